@@ -26,19 +26,28 @@
 #include <system/interrupts.h>
 #include <system/utils.h>
 #include <interrupts.h>
+#include <arch.h>
+#include <heap.h>
 #include <log.h>
 #include <cpu.h>
+#include <fpu.h>
+
+/* Includes
+ * - Library */
+#include <string.h>
 
  /* Globals 
   * Keep a copy of cpu information in the system */
 static CpuInformation_t __CpuInformation = { 0 };
 static int __CpuInitialized = 0;
+static CpuCore_t __BootCore = { 0 };
+static CpuCore_t *__CpuCores[MAX_SUPPORTED_CPUS] = { 0 };
+static int __CpuBootCoreInstalled = 0;
 
 /* Extern functions
  * We need access to these in order to implement
  * the interface */
 __EXTERN volatile size_t GlbTimerTicks[64];
-__EXTERN UUId_t ApicGetCpu(void);
 
 /* Extern assembly functions
  * These utilities are located in boot.asm */
@@ -88,6 +97,9 @@ CpuInitialize(void)
 	if (__CpuInformation.EdxFeatures & CPUID_FEAT_EDX_SSE) {
 		CpuEnableSse();
 	}
+
+	// Enable xsave and the extended states
+	FpuInitialize();
 }
 
 /* CpuHasFeatures
@@ -113,13 +125,74 @@ CpuHasFeatures(Flags_t Ecx, Flags_t Edx)
 	return OsSuccess;
 }
 
+/* CpuCreateCore
+ * Creates the control block for the given cpu, the boot cpu
+ * uses static storage as there is no memory allocator yet,
+ * returns NULL if the block could not be allocated */
+CpuCore_t*
+CpuCreateCore(
+    _In_ UUId_t Cpu,
+    _In_ int Static)
+{
+	// Variables
+	CpuCore_t *Core = NULL;
+
+	if (Static) {
+		Core = &__BootCore;
+	}
+	else {
+		Core = (CpuCore_t*)kmalloc(sizeof(CpuCore_t));
+		if (Core == NULL) {
+			return NULL;
+		}
+	}
+
+	// Initialize members, threading fills in the rest
+	memset(Core, 0, sizeof(CpuCore_t));
+	Core->Self = Core;
+	Core->Id = Cpu;
+	__CpuCores[Cpu] = Core;
+	return Core;
+}
+
+/* CpuGetCore
+ * Retrieves the control block of the given cpu, returns
+ * NULL if the cpu has not been brought up yet */
+CpuCore_t*
+CpuGetCore(
+    _In_ UUId_t Cpu)
+{
+	if (Cpu >= MAX_SUPPORTED_CPUS) {
+		return NULL;
+	}
+	return __CpuCores[Cpu];
+}
+
+/* CpuInstallCore
+ * Marks the control block of the given cpu as loaded into fs,
+ * must be called by the cpu itself once the segment is installed */
+void
+CpuInstallCore(
+    _In_ UUId_t Cpu)
+{
+	if (Cpu == 0) {
+		__CpuBootCoreInstalled = 1;
+	}
+}
+
 /* CpuGetCurrentId 
  * Retrieves the current cpu id for caller */
 UUId_t
 CpuGetCurrentId(void)
 {
-	// Get apic id
-	return ApicGetCpu();
+	// The boot cpu logs and takes locks before its control block
+	// is installed, fs is still the flat selector of the bootloader
+	// then, and no other cpu is running yet. The application cpus
+	// install their block before they run anything else
+	if (!__CpuBootCoreInstalled) {
+		return 0;
+	}
+	return CpuGetCurrentCore()->Id;
 }
 
 /* CpuIdle
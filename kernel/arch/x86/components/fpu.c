@@ -0,0 +1,220 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS X86 Fpu State Interface
+ * - Saves and restores the fpu, sse and avx state of threads with xsave
+ *   when available. Save areas are sized by cpuid and handed out from a
+ *   dedicated cache of page-sized slabs
+ */
+#define __MODULE "XFPU"
+
+/* Includes
+ * - System */
+#include <system/utils.h>
+#include <os/spinlock.h>
+#include <memory.h>
+#include <debug.h>
+#include <heap.h>
+#include <log.h>
+#include <cpu.h>
+#include <fpu.h>
+
+/* Includes
+ * - Library */
+#include <stddef.h>
+#include <assert.h>
+#include <string.h>
+
+/* FpuAreaCache
+ * Save areas are carved from slabs of whole pages and never returned to
+ * the heap, freed areas are linked through their first word */
+typedef struct _FpuAreaCache {
+    Spinlock_t           Lock;
+    size_t               AreaSize;
+    size_t               SlabSize;
+    uintptr_t           *FreeAreas;
+    size_t               SlabCount;
+    size_t               AreasInUse;
+} FpuAreaCache_t;
+
+/* Globals
+ * The save mode and components are the same for all cpus */
+static int __GlbFpuMode             = FPU_MODE_FXSAVE;
+static uint32_t __GlbFpuMaskLow     = 0;
+static uint32_t __GlbFpuMaskHigh    = 0;
+static int __GlbFpuInitialized      = 0;
+static FpuAreaCache_t __GlbFpuCache = { SPINLOCK_INIT, FPU_LEGACY_SIZE, PAGE_SIZE, NULL, 0, 0 };
+
+/* Extern assembly functions
+ * These utilities are located in boot.asm and thread.asm */
+__EXTERN void CpuIdSubleaf(uint32_t CpuId, uint32_t SubLeaf, 
+    uint32_t *Eax, uint32_t *Ebx, uint32_t *Ecx, uint32_t *Edx);
+__EXTERN void CpuEnableXSave(uint32_t MaskLow, uint32_t MaskHigh);
+__EXTERN void save_fpu(uintptr_t *buffer);
+__EXTERN void load_fpu(uintptr_t *buffer);
+__EXTERN void save_fpu_extended(uintptr_t *buffer, uint32_t masklow, uint32_t maskhigh);
+__EXTERN void save_fpu_optimized(uintptr_t *buffer, uint32_t masklow, uint32_t maskhigh);
+__EXTERN void load_fpu_extended(uintptr_t *buffer, uint32_t masklow, uint32_t maskhigh);
+
+/* FpuInitialize
+ * Enables xsave and the supported state components for the calling cpu.
+ * The first call also determines the save mode and save area size. */
+void
+FpuInitialize(void)
+{
+    // Variables
+    uint32_t _eax, _ebx, _ecx, _edx;
+    size_t AreaSize = FPU_LEGACY_SIZE;
+
+    // Without xsave the state is saved with fxsave
+    if (CpuHasFeatures(CPUID_FEAT_ECX_XSAVE, 0) != OsSuccess) {
+        return;
+    }
+
+    // Only enable the components we know how to handle, the first
+    // sub-leaf reports the components the cpu supports
+    if (__GlbFpuInitialized == 0) {
+        CpuIdSubleaf(0xD, 0, &_eax, &_ebx, &_ecx, &_edx);
+        __GlbFpuMaskLow = _eax & (FPU_XSTATE_X87 | FPU_XSTATE_SSE);
+        if (CpuHasFeatures(CPUID_FEAT_ECX_AVX, 0) == OsSuccess) {
+            __GlbFpuMaskLow |= _eax & FPU_XSTATE_AVX;
+        }
+        __GlbFpuMaskHigh = 0;
+    }
+    CpuEnableXSave(__GlbFpuMaskLow, __GlbFpuMaskHigh);
+    if (__GlbFpuInitialized != 0) {
+        return;
+    }
+
+    // Now XCR0 is set, ebx reports the size needed by the enabled components
+    CpuIdSubleaf(0xD, 0, &_eax, &_ebx, &_ecx, &_edx);
+    AreaSize = MAX(_ebx, FPU_LEGACY_SIZE + FPU_XSAVE_HEADER_SIZE);
+    __GlbFpuMode = FPU_MODE_XSAVE;
+
+    // Xsaveopt skips components that are unmodified since the last
+    // xrstor from the same area, that is always true for us as a thread
+    // is only saved if it restored its area on the same cpu
+    CpuIdSubleaf(0xD, 1, &_eax, &_ebx, &_ecx, &_edx);
+    if (_eax & 0x1) {
+        __GlbFpuMode = FPU_MODE_XSAVEOPT;
+    }
+
+    // Size the cache, areas must be 64 byte aligned for xsave
+    __GlbFpuCache.AreaSize = (AreaSize + (FPU_AREA_ALIGNMENT - 1)) & ~(FPU_AREA_ALIGNMENT - 1);
+    __GlbFpuCache.SlabSize = (__GlbFpuCache.AreaSize + (PAGE_SIZE - 1)) & ~(PAGE_SIZE - 1);
+    __GlbFpuInitialized = 1;
+    TRACE("Fpu mode %i, components 0x%x, area size %u", 
+        __GlbFpuMode, __GlbFpuMaskLow, __GlbFpuCache.AreaSize);
+}
+
+/* FpuGetAreaSize
+ * Retrieves the size of the save area of a single thread */
+size_t
+FpuGetAreaSize(void)
+{
+    return __GlbFpuCache.AreaSize;
+}
+
+/* FpuCreateArea
+ * Allocates a save area from the fpu area cache and initializes it to
+ * the default fpu state, restoring it gives the thread a clean fpu */
+uintptr_t*
+FpuCreateArea(void)
+{
+    // Variables
+    uintptr_t *Area = NULL;
+    uint8_t *Slab = NULL;
+    size_t i;
+
+    SpinlockAcquire(&__GlbFpuCache.Lock);
+    while (__GlbFpuCache.FreeAreas == NULL) {
+        // Grow the cache by a slab, the heap is not touched with the lock
+        // held, another cpu might have grown it meanwhile which is fine
+        SpinlockRelease(&__GlbFpuCache.Lock);
+        Slab = (uint8_t*)kmalloc_a(__GlbFpuCache.SlabSize);
+        assert(Slab != NULL);
+        SpinlockAcquire(&__GlbFpuCache.Lock);
+        for (i = 0; i + __GlbFpuCache.AreaSize <= __GlbFpuCache.SlabSize; 
+            i += __GlbFpuCache.AreaSize) {
+            Area = (uintptr_t*)(Slab + i);
+            *Area = (uintptr_t)__GlbFpuCache.FreeAreas;
+            __GlbFpuCache.FreeAreas = Area;
+        }
+        __GlbFpuCache.SlabCount++;
+    }
+    Area = __GlbFpuCache.FreeAreas;
+    __GlbFpuCache.FreeAreas = (uintptr_t*)*Area;
+    __GlbFpuCache.AreasInUse++;
+    SpinlockRelease(&__GlbFpuCache.Lock);
+
+    // A zeroed xsave header puts every component in its initial state
+    // on restore, but the control words are always loaded from the area
+    memset(Area, 0, __GlbFpuCache.AreaSize);
+    *((uint16_t*)((uint8_t*)Area + 0)) = FPU_DEFAULT_FCW;
+    *((uint32_t*)((uint8_t*)Area + 24)) = FPU_DEFAULT_MXCSR;
+    return Area;
+}
+
+/* FpuDestroyArea
+ * Returns the save area to the fpu area cache */
+void
+FpuDestroyArea(
+    _In_ uintptr_t *Area)
+{
+    if (Area == NULL) {
+        return;
+    }
+    SpinlockAcquire(&__GlbFpuCache.Lock);
+    *Area = (uintptr_t)__GlbFpuCache.FreeAreas;
+    __GlbFpuCache.FreeAreas = Area;
+    __GlbFpuCache.AreasInUse--;
+    SpinlockRelease(&__GlbFpuCache.Lock);
+}
+
+/* FpuSave
+ * Saves the fpu state of the calling cpu to the given area */
+void
+FpuSave(
+    _In_ uintptr_t *Area)
+{
+    switch (__GlbFpuMode) {
+        case FPU_MODE_XSAVEOPT:
+            save_fpu_optimized(Area, __GlbFpuMaskLow, __GlbFpuMaskHigh);
+            break;
+        case FPU_MODE_XSAVE:
+            save_fpu_extended(Area, __GlbFpuMaskLow, __GlbFpuMaskHigh);
+            break;
+        default:
+            save_fpu(Area);
+            break;
+    }
+}
+
+/* FpuRestore
+ * Restores the fpu state of the calling cpu from the given area */
+void
+FpuRestore(
+    _In_ uintptr_t *Area)
+{
+    if (__GlbFpuMode == FPU_MODE_FXSAVE) {
+        load_fpu(Area);
+    }
+    else {
+        load_fpu_extended(Area, __GlbFpuMaskLow, __GlbFpuMaskHigh);
+    }
+}
@@ -30,16 +30,22 @@
 
 /* Includes 
  * - C-Library */
+#include <ds/bitmap.h>
 #include <assert.h>
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
 
+/* Frames below 16mb are handed out for allocations with a
+ * dma mask, the first 128kb are never handed out */
+#define MEMORY_LOW_FIRST_FRAME		(0x20000 / PAGE_SIZE)
+#define MEMORY_LOW_END_FRAME		(0x1000000 / PAGE_SIZE)
+
 /* Globals 
  * This is primarily stats and 
  * information about the memory
  * bitmap */
-uintptr_t *MemoryBitmap = NULL;
+Bitmap_t MemoryBitmap;
 size_t MemoryBitmapSize = 0;
 size_t MemoryBlocks = 0;
 size_t MemoryBlocksUsed = 0;
@@ -90,7 +96,7 @@ MmPhysicalQuery(
  * make sure this is tested before and give
  * an error if its already allocated */
 void MmMemoryMapSetBit(int Bit) {
-	MemoryBitmap[Bit / __BITS] |= (1 << (Bit % __BITS));
+	BitmapSetBits(&MemoryBitmap, Bit, 1);
 }
 
 /* This is an inline helper for 
@@ -98,14 +104,14 @@ void MmMemoryMapSetBit(int Bit) {
  * make sure this is tested before and give
  * an error if it's not allocated */
 void MmMemoryMapUnsetBit(int Bit) {
-	MemoryBitmap[Bit / __BITS] &= ~(1 << (Bit % __BITS));
+	BitmapClearBits(&MemoryBitmap, Bit, 1);
 }
 
 /* This is an inline helper for 
  * testing whether or not a bit is set, it returns
  * 1 if allocated, or 0 if free */
 int MmMemoryMapTestBit(int Bit) {
-	return (MemoryBitmap[Bit / __BITS] & (1 << (Bit % __BITS))) > 0 ? 1 : 0;
+	return BitmapAreBitsSet(&MemoryBitmap, Bit, 1);
 }
 
 /* This function can be used to retrieve
@@ -113,42 +119,8 @@ int MmMemoryMapTestBit(int Bit) {
  * this is useful for devices that use DMA */
 int MmGetFreeMapBitLow(int Count)
 {
-	/* Variables needed for iteration */
-	int i, j, Result = -1;
-
-	/* Start out by iterating the 
-	 * different memory blocks, but always skip
-	 * the first mem-block */
-	for (i = 1; i < (8 * 16); i++)
-	{
-		/* Quick-check, if it's maxxed we can skip it 
-		 * due to all being allocated */
-		if (MemoryBitmap[i] != __MASK) {
-			for (j = 0; j < __BITS; j++) {
-				if (!(MemoryBitmap[i] & 1 << j)) {
-					int Found = 1;
-					for (int k = 0, c = j; k < Count && c < __BITS; k++, c++) {
-						if (MemoryBitmap[i] & 1 << c) {
-							Found = 0;
-							break;
-						}
-					}
-					if (Found == 1) {
-						Result = (int)((i * __BITS) + j);
-						break;
-					}
-				}
-			}
-		}
-
-		/* Check for break 
-		 * If result is found then we are done! */
-		if (Result != -1)
-			break;
-	}
-
-	/* Return frame */
-	return Result;
+	return BitmapFindBitsInRange(&MemoryBitmap, 
+		MEMORY_LOW_FIRST_FRAME, MEMORY_LOW_END_FRAME, Count);
 }
 
 /* This function can be used to retrieve
@@ -156,77 +128,46 @@ int MmGetFreeMapBitLow(int Count)
  * this should probably be the standard alloc used */
 int MmGetFreeMapBitHigh(int Count)
 {
-	/* Variables needed for iteration */
-	int i, j, Result = -1;
-
-	/* Start out by iterating the
-	 * different memory blocks, but always skip
-	 * the first mem-block */
-	for (i = (8 * 16); i < (int)MemoryBlocks; i++)
-	{
-		/* Quick-check, if it's maxxed we can skip it
-		 * due to all being allocated */
-		if (MemoryBitmap[i] != __MASK) {
-			for (j = 0; j < __BITS; j++) {
-				if (!(MemoryBitmap[i] & 1 << j)) {
-					int Found = 1;
-					for (int k = 0, c = j; k < Count && c < __BITS; k++, c++) {
-						if (MemoryBitmap[i] & 1 << c) {
-							Found = 0;
-							break;
-						}
-					}
-					if (Found == 1) {
-						Result = (int)((i * __BITS) + j);
-						break;
-					}
-				}
-			}
-		}
-
-		/* Check for break
-		 * If result is found then we are done! */
-		if (Result != -1)
-			break;
-	}
-
-	/* Return frame */
-	return Result;
+	return BitmapFindBitsInRange(&MemoryBitmap, 
+		MEMORY_LOW_END_FRAME, (int)MemoryBlocks, Count);
 }
 
 /* One of the two region functions
  * they are helpers in order to either free
- * or allocate a region of memory */
+ * or allocate a region of memory, frames past
+ * the end of memory are not tracked */
 void MmFreeRegion(uintptr_t Base, size_t Size)
 {
 	/* Calculate the frame */
-	int Frame = (int)(Base / PAGE_SIZE);
+	size_t Frame = (size_t)(Base / PAGE_SIZE);
 	size_t Count = (size_t)(Size / PAGE_SIZE);
 
-	/* Iterate and free the frames in the 
-	 * bitmap using our helper function */
-	for (size_t i = Base; Count > 0; Count--, i += PAGE_SIZE) {
-		MmMemoryMapUnsetBit(Frame++);
-
-		/* Decrease allocated blocks */
-		if (MemoryBlocksUsed != 0)
-			MemoryBlocksUsed--;
+	if (Frame >= MemoryBlocks) {
+		return;
 	}
+	Count = MIN(Count, MemoryBlocks - Frame);
+	BitmapClearBits(&MemoryBitmap, (int)Frame, (int)Count);
+
+	/* Decrease allocated blocks */
+	MemoryBlocksUsed -= MIN(MemoryBlocksUsed, Count);
 }
 
 /* One of the two region functions
  * they are helpers in order to either free
- * or allocate a region of memory */
+ * or allocate a region of memory, the frame
+ * the region ends in is allocated as well */
 void MmAllocateRegion(uintptr_t Base, size_t Size)
 {
 	/* Calculate the frame */
-	int Frame = (int)(Base / PAGE_SIZE);
-	size_t Count = (size_t)(Size / PAGE_SIZE);
+	size_t Frame = (size_t)(Base / PAGE_SIZE);
+	size_t Count = (size_t)(Size / PAGE_SIZE) + 1;
 
-	for (size_t i = Base; (Count + 1) > 0; Count--, i += PAGE_SIZE){
-		MmMemoryMapSetBit(Frame++);
-		MemoryBlocksUsed++;
+	if (Frame >= MemoryBlocks) {
+		return;
 	}
+	Count = MIN(Count, MemoryBlocks - Frame);
+	BitmapSetBits(&MemoryBitmap, (int)Frame, (int)Count);
+	MemoryBlocksUsed += Count;
 }
 
 /* This validates if a system mapping already
@@ -280,14 +221,17 @@ MmPhyiscalInit(
 	assert((MemorySize / 1024 / 1024) >= 32);
 
 	/* Set storage variables 
-	 * We have the bitmap normally at 2mb mark */
-	MemoryBitmap = (uintptr_t*)MEMORY_LOCATION_BITMAP;
+	 * We have the bitmap normally at 2mb mark, the
+	 * summary of full words follows right after it */
 	MemoryBlocks = MemorySize / PAGE_SIZE;
 	MemoryBlocksUsed = MemoryBlocks;
 	MemoryBitmapSize = DIVUP(MemoryBlocks, 8); /* 8 blocks per byte, 32/64 per int */
+	BitmapConstruct(&MemoryBitmap, (uintptr_t*)MEMORY_LOCATION_BITMAP, MemoryBitmapSize);
+	BitmapConstructSummary(&MemoryBitmap, 
+		&MemoryBitmap.Data[BITMAP_WORDS(MemoryBitmapSize)]);
 
 	/* Set all memory in use */
-	memset((void*)MemoryBitmap, 0xFFFFFFFF, MemoryBitmapSize);
+	BitmapSetBits(&MemoryBitmap, 0, (int)MemoryBitmap.Capacity);
 	memset((void*)SysMappings, 0, sizeof(SysMappings));
 
 	// Create critical section
@@ -350,7 +294,8 @@ MmPhyiscalInit(
 
 	/* 0x300000 - ?? || Bitmap Space 
 	 * We allocate an extra guard-page */
-	MmAllocateRegion(MEMORY_LOCATION_BITMAP, (MemoryBitmapSize + PAGE_SIZE));
+	MmAllocateRegion(MEMORY_LOCATION_BITMAP, (BITMAP_WORDS(MemoryBitmapSize) 
+		+ BITMAP_SUMMARY_WORDS(MemoryBitmapSize)) * sizeof(uintptr_t) + PAGE_SIZE);
 
 	/* Debug */
 	MmMemoryDebugPrint();
@@ -425,9 +370,7 @@ MmPhysicalAllocateBlock(
 	 * release the lock, but ONLY if 
 	 * the frame is valid */
 	if (Frame != -1) {
-		for (int i = 0; i < Count; i++) {
-			MmMemoryMapSetBit(Frame + i);
-		}
+		BitmapSetBits(&MemoryBitmap, Frame, Count);
 	}
 
     // Leave critical and sanitize frame
@@ -435,7 +378,7 @@ MmPhysicalAllocateBlock(
 	assert(Frame != -1);
 
 	/* Statistics */
-	MemoryBlocksUsed++;
+	MemoryBlocksUsed += Count;
 
 	/* Calculate the return 
 	 * address by multiplying by block size */
@@ -92,7 +92,7 @@ PitInitialize(void)
 
 	// Register our irq as a system timer
 	if (PitUnit.Irq != UUID_INVALID) {
-		TimersRegisterSystemTimer(PitUnit.Irq, PitUnit.NsTick, PitGetTicks);
+		TimersRegisterSystemTimer(PitUnit.Irq, PitUnit.NsTick, PitGetTicks, NULL);
 	}
     else {
         ERROR("Failed to register interrupt");
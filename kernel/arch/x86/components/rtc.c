@@ -108,7 +108,7 @@ RtcInitialize(
 
 	// Register our irq as a system timer
 	if (Chip->Irq != UUID_INVALID) {
-		TimersRegisterSystemTimer(Chip->Irq, Chip->NsTick, CmosGetTicks);
+		TimersRegisterSystemTimer(Chip->Irq, Chip->NsTick, CmosGetTicks, NULL);
 	}
     else {
         ERROR("Failed to register interrupt for rtc");
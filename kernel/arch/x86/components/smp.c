@@ -108,13 +108,14 @@ void SmpApEntry(void)
 	/* Memory */
 	MmVirtualInstallPaging(Cpu);
 
+	/* Install the TSS descriptor and the per-cpu
+	 * block, they were allocated by the booting cpu as
+	 * fs does not point to our block until this is done */
+	GdtInstallTss(Cpu, 0);
+
 	/* Setup apic */
 	ApicInitAp();
 
-	/* Install the TSS descriptor, 
-	 * we need memory management for that */
-	GdtInstallTss(Cpu, 0);
-
 	/* Setup Threading */
 	SchedulerCreate(Cpu);
 	ThreadingInitialize(Cpu);
@@ -158,6 +159,10 @@ void SmpBootCore(void *Data, int n, void *UserData)
 
 	/* Move cpu apic id to upper 8 bits */
 	printf("    * Booting Core %u", ApicId);
+	if (GdtCreateTss(Core->Id) != OsSuccess) {
+		printf(" failed to allocate cpu block!\n");
+		return;
+	}
 	ApicId <<= 24;
 
 	/* Set destination to that cpu */
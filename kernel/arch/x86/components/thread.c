@@ -23,6 +23,7 @@
 
 /* Includes 
  * - System */
+#include <system/utils.h>
 #include <threading.h>
 #include <process/phoenix.h>
 #include <interrupts.h>
@@ -31,6 +32,7 @@
 #include <debug.h>
 #include <heap.h>
 #include <apic.h>
+#include <fpu.h>
 #include <gdt.h>
 #include <log.h>
 
@@ -44,12 +46,12 @@
  * to the timer-quantum and a bunch of 
  * assembly functions */
 __EXTERN size_t GlbTimerQuantum;
-__EXTERN void save_fpu(uintptr_t *buffer);
 __EXTERN void set_ts(void);
 __EXTERN void _yield(void);
 __EXTERN void enter_thread(Context_t *Regs);
 __EXTERN void enter_signal(Context_t *Regs, uintptr_t Handler, int Signal, uintptr_t Return);
 __EXTERN void RegisterDump(Context_t *Regs);
+__EXTERN uint32_t CoreGetSegment(void);
 
 /* Globals,
  * Keep track of whether or not init code has run */
@@ -64,7 +66,7 @@ InterruptStatus_t ThreadingYieldHandler(void *Args)
 	/* Variables we will need for loading
 	 * a new task */
 	Context_t *Regs = NULL;
-	UUId_t CurrCpu = ApicGetCpu();
+	UUId_t CurrCpu = CpuGetCurrentId();
 
 	/* These will be assigned from the 
 	 * _switch function, but set them in
@@ -116,10 +118,9 @@ ThreadingCreateArch(
 	Thread = (x86Thread_t*)kmalloc(sizeof(x86Thread_t));
 	memset(Thread, 0, sizeof(x86Thread_t));
 
-	// Allocate a new buffer for FPU operations  
-	// and zero out the buffer space
-	Thread->FpuBuffer = kmalloc_a(0x1000);
-	memset(Thread->FpuBuffer, 0, 0x1000);
+	// Allocate a new save area for FPU operations, it
+	// starts out in the default fpu state
+	Thread->FpuBuffer = FpuCreateArea();
 
 	// Don't create contexts for idle threads 
 	// Otherwise setup a kernel stack 
@@ -181,7 +182,7 @@ void IThreadDestroy(MCoreThread_t *Thread)
 
 	/* Free fpu buffer and the
 	 * base structure */
-	kfree(tData->FpuBuffer);
+	FpuDestroyArea(tData->FpuBuffer);
 	kfree(tData);
 }
 
@@ -250,7 +251,7 @@ ThreadingImpersonate(
 
 	// Instantiate values
 	SubContext = (x86Thread_t*)Thread->ThreadData;
-    Cpu = ApicGetCpu();
+    Cpu = CpuGetCurrentId();
     Current = ThreadingGetCurrentThread(Cpu);
     
     // If we impersonate ourself, leave
@@ -292,7 +293,7 @@ _ThreadingSwitch(
     }
 
 	// Instantiate variables
-	Cpu = ApicGetCpu();
+	Cpu = CpuGetCurrentId();
 	Thread = ThreadingGetCurrentThread(Cpu);
     assert(Thread != NULL && Regs != NULL);
 	Tx = (x86Thread_t*)Thread->ThreadData;
@@ -307,7 +308,7 @@ _ThreadingSwitch(
 	/* Save FPU/MMX/SSE information if it's
 	 * been used, otherwise skip this and save time */
 	if (Tx->Flags & X86_THREAD_USEDFPU) {
-		save_fpu(Tx->FpuBuffer);
+		FpuSave(Tx->FpuBuffer);
 	}
 
 	/* Save stack, we have a few cases here. 
@@ -353,9 +354,11 @@ _ThreadingSwitch(
 	/* Set TS bit in CR0 */
 	set_ts();
 
-	/* Return new stack */
+	/* Return new stack, kernel contexts must resume with the
+	 * per-cpu segment of this cpu as the thread might have moved */
 	if ((THREADING_RUNMODE(Thread->Flags) == THREADING_KERNELMODE)
 		|| (Thread->Flags & THREADING_SWITCHMODE)) {
+		Tx->Context->Fs = CoreGetSegment();
 		return Tx->Context;
 	}	
 	else {
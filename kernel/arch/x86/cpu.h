@@ -28,6 +28,10 @@
  * - Library */
 #include <os/osdefs.h>
 
+/* Includes
+ * - System */
+#include <system/utils.h>
+
 /* Definitions 
  * Where in lower memory we want to keep trampoline code */
 #define TRAMPOLINE_CODE_MEM		0x5000
@@ -129,4 +133,24 @@ OsStatus_t
 KERNELABI
 CpuHasFeatures(Flags_t Ecx, Flags_t Edx);
 
+/* CpuCreateCore
+ * Creates the control block for the given cpu, the boot cpu
+ * uses static storage as there is no memory allocator yet,
+ * returns NULL if the block could not be allocated */
+KERNELAPI
+CpuCore_t*
+KERNELABI
+CpuCreateCore(
+    _In_ UUId_t Cpu,
+    _In_ int Static);
+
+/* CpuInstallCore
+ * Marks the control block of the given cpu as loaded into fs,
+ * must be called by the cpu itself once the segment is installed */
+KERNELAPI
+void
+KERNELABI
+CpuInstallCore(
+    _In_ UUId_t Cpu);
+
 #endif // !_x86_CPU_H_
@@ -0,0 +1,104 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS X86 Fpu State Header
+ * - Contains the interface for saving and restoring the fpu, sse and
+ *   avx state of threads. Uses xsave when available and fxsave otherwise
+ */
+
+#ifndef _x86_FPU_H_
+#define _x86_FPU_H_
+
+/* Includes
+ * - Library */
+#include <os/osdefs.h>
+
+/* Includes
+ * - System */
+#include <system/utils.h>
+
+/* Fpu Save Modes
+ * The instructions used for saving and restoring the state */
+#define FPU_MODE_FXSAVE             0
+#define FPU_MODE_XSAVE              1
+#define FPU_MODE_XSAVEOPT           2
+
+/* Fpu State Components
+ * The bits of XCR0 the kernel enables when the cpu supports them, avx
+ * covers the upper halves of the ymm registers used by avx and avx2 */
+#define FPU_XSTATE_X87              0x1
+#define FPU_XSTATE_SSE              0x2
+#define FPU_XSTATE_AVX              0x4
+
+/* Fpu Save Area Layout
+ * The legacy region is shared between fxsave and xsave, the xsave header
+ * follows it and must be zero for a fresh area */
+#define FPU_LEGACY_SIZE             512
+#define FPU_XSAVE_HEADER_SIZE       64
+#define FPU_AREA_ALIGNMENT          64
+#define FPU_DEFAULT_FCW             0x037F
+#define FPU_DEFAULT_MXCSR           0x1F80
+
+/* FpuInitialize
+ * Enables xsave and the supported state components for the calling cpu.
+ * The first call also determines the save mode and save area size. */
+KERNELAPI
+void
+KERNELABI
+FpuInitialize(void);
+
+/* FpuGetAreaSize
+ * Retrieves the size of the save area of a single thread */
+KERNELAPI
+size_t
+KERNELABI
+FpuGetAreaSize(void);
+
+/* FpuCreateArea
+ * Allocates a save area from the fpu area cache and initializes it to
+ * the default fpu state, restoring it gives the thread a clean fpu */
+KERNELAPI
+uintptr_t*
+KERNELABI
+FpuCreateArea(void);
+
+/* FpuDestroyArea
+ * Returns the save area to the fpu area cache */
+KERNELAPI
+void
+KERNELABI
+FpuDestroyArea(
+    _In_ uintptr_t *Area);
+
+/* FpuSave
+ * Saves the fpu state of the calling cpu to the given area */
+KERNELAPI
+void
+KERNELABI
+FpuSave(
+    _In_ uintptr_t *Area);
+
+/* FpuRestore
+ * Restores the fpu state of the calling cpu from the given area */
+KERNELAPI
+void
+KERNELABI
+FpuRestore(
+    _In_ uintptr_t *Area);
+
+#endif // !_x86_FPU_H_
@@ -22,6 +22,7 @@
 
 /* Includes 
  * - System */
+#include <system/utils.h>
 #include <acpi.h>
 #include <apic.h>
 #include <thread.h>
@@ -49,7 +50,7 @@ InterruptStatus_t ApicTimerHandler(void *Args)
 	/* Variables we will need for loading
 	 * a new task */
 	Context_t *Regs = NULL;
-	UUId_t CurrCpu = ApicGetCpu();
+	UUId_t CurrCpu = CpuGetCurrentId();
 
 	/* These will be assigned from the 
 	 * _switch function, but set them in
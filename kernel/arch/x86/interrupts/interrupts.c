@@ -39,6 +39,7 @@
 #include <debug.h>
 #include <heap.h>
 #include <apic.h>
+#include <fpu.h>
 #include <idt.h>
 #include <pic.h>
 
@@ -58,8 +59,6 @@ __EXTERN void __cli(void);
 __EXTERN void __sti(void);
 __EXTERN reg_t __getflags(void);
 __EXTERN reg_t __getcr2(void);
-__EXTERN void init_fpu(void);
-__EXTERN void load_fpu(uintptr_t *buffer);
 __EXTERN void clear_ts(void);
 __EXTERN void enter_thread(Context_t *Regs);
 
@@ -407,17 +406,12 @@ void ExceptionEntry(Context_t *Registers)
         // Clear the task-switch bit
         clear_ts();
 
-        // Either of two cases;
-        // 1 - We need to initialize the FPU
-        // 2 - We need to load the FPU
-        if (!(cT86->Flags & X86_THREAD_FPU_INITIALISED)) {
-            init_fpu();
-            cT86->Flags |= X86_THREAD_FPU_INITIALISED;
-            IssueFixed = 1;
-        }
-        else if (!(cT86->Flags & X86_THREAD_USEDFPU)) {
-            load_fpu(cT86->FpuBuffer);
-            cT86->Flags |= X86_THREAD_USEDFPU;
+        // Load the FPU state of the thread, the save area of a new
+        // thread holds the default state so the first use also restores
+        // from it, that clears out the state of the previous thread
+        if (!(cT86->Flags & X86_THREAD_USEDFPU)) {
+            FpuRestore(cT86->FpuBuffer);
+            cT86->Flags |= X86_THREAD_USEDFPU | X86_THREAD_FPU_INITIALISED;
             IssueFixed = 1;
         }
     }
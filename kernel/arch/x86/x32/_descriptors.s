@@ -24,6 +24,9 @@ segment .text
 ;Functions in this asm
 global _GdtInstall
 global _TssInstall
+global _CoreInstall
+global _CoreGetSegment
+global _CpuGetCurrentCore
 global _IdtInstall
 
 extern ___GdtTableObject
@@ -83,6 +86,33 @@ _TssInstall:
 	pop ebp
 	ret
 
+; void CoreInstall(int gdt_index)
+; Load the per-cpu segment of the
+; given index into fs
+_CoreInstall:
+	; Calculate selector
+	mov eax, [esp + 4]
+	shl eax, 3
+
+	; Load segment
+	mov fs, ax
+	ret
+
+; uint32_t CoreGetSegment()
+; Returns the per-cpu segment of the
+; calling cpu
+_CoreGetSegment:
+	xor eax, eax
+	mov ax, fs
+	ret
+
+; CpuCore_t *CpuGetCurrentCore()
+; Returns the control block of the calling
+; cpu, it's first member points to itself
+_CpuGetCurrentCore:
+	mov eax, [fs:0]
+	ret
+
 ; void IdtInstall()
 ; Load the given TSS descriptor
 ; index
@@ -94,12 +94,16 @@ _exception_common:
 	; Save Registers
 	pushad
 
-	; Switch to kernel segment
+	; Switch to kernel segment, fs holds the per-cpu
+	; segment which is placed right after our tss
 	mov ax, 0x10
 	mov ds, ax
 	mov es, ax
-	mov fs, ax
 	mov gs, ax
+	str ax
+	and ax, 0xFFF8
+	add ax, 0x8
+	mov fs, ax
 
 	; Push registers as pointer to struct
 	push esp
@@ -137,12 +141,16 @@ _irq_common:
 	; Save Registers
 	pushad
 
-	; Switch to kernel segment
+	; Switch to kernel segment, fs holds the per-cpu
+	; segment which is placed right after our tss
 	mov ax, 0x10
 	mov ds, ax
 	mov es, ax
-	mov fs, ax
 	mov gs, ax
+	str ax
+	and ax, 0xFFF8
+	add ax, 0x8
+	mov fs, ax
 
 	; Push registers as pointer to struct
 	push esp
@@ -177,13 +185,17 @@ _syscall_entry:
 	push fs
 	push gs
 
-	; Switch to kernel segment
+	; Switch to kernel segment, fs holds the per-cpu
+	; segment which is placed right after our tss
 	push eax
 	mov ax, 0x10
 	mov ds, ax
 	mov es, ax
-	mov fs, ax
 	mov gs, ax
+	str ax
+	and ax, 0xFFF8
+	add ax, 0x8
+	mov fs, ax
 	pop eax
 
 	; Push args to stack
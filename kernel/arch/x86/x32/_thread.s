@@ -25,6 +25,9 @@ segment .text
 global _init_fpu
 global _save_fpu
 global _load_fpu
+global _save_fpu_extended
+global _save_fpu_optimized
+global _load_fpu_extended
 global _clear_ts
 global _set_ts
 global _rdtsc
@@ -83,6 +86,88 @@ _load_fpu:
 	pop ebp
 	ret 
 
+; void save_fpu_extended(uintptr_t *buffer, uint32_t masklow, uint32_t maskhigh)
+; Save the extended states selected by the mask
+_save_fpu_extended:
+	; Stack Frame
+	push ebp
+	mov ebp, esp
+
+	; Save registers
+	push eax
+	push ecx
+	push edx
+
+	; Save states to argument 1
+	mov ecx, [ebp + 8]
+	mov eax, [ebp + 12]
+	mov edx, [ebp + 16]
+	xsave [ecx]
+
+	; Restore registers
+	pop edx
+	pop ecx
+	pop eax
+
+	; Release stack frame
+	pop ebp
+	ret 
+
+; void save_fpu_optimized(uintptr_t *buffer, uint32_t masklow, uint32_t maskhigh)
+; Save the extended states selected by the mask, skips
+; states that are unmodified since they were loaded
+_save_fpu_optimized:
+	; Stack Frame
+	push ebp
+	mov ebp, esp
+
+	; Save registers
+	push eax
+	push ecx
+	push edx
+
+	; Save states to argument 1
+	mov ecx, [ebp + 8]
+	mov eax, [ebp + 12]
+	mov edx, [ebp + 16]
+	xsaveopt [ecx]
+
+	; Restore registers
+	pop edx
+	pop ecx
+	pop eax
+
+	; Release stack frame
+	pop ebp
+	ret 
+
+; void load_fpu_extended(uintptr_t *buffer, uint32_t masklow, uint32_t maskhigh)
+; Load the extended states selected by the mask
+_load_fpu_extended:
+	; Stack Frame
+	push ebp
+	mov ebp, esp
+
+	; Save registers
+	push eax
+	push ecx
+	push edx
+
+	; Load states from argument 1
+	mov ecx, [ebp + 8]
+	mov eax, [ebp + 12]
+	mov edx, [ebp + 16]
+	xrstor [ecx]
+
+	; Restore registers
+	pop edx
+	pop ecx
+	pop eax
+
+	; Release stack frame
+	pop ebp
+	ret 
+
 ; void set_ts()
 ; Sets the Task-Switch register
 _set_ts:
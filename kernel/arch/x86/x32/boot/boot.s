@@ -29,6 +29,8 @@ global _kentry
 global _CpuEnableSse
 global _CpuEnableFpu
 global _CpuId
+global _CpuIdSubleaf
+global _CpuEnableXSave
 
 ; No matter what, this is booted by multiboot, and thus
 ; We can assume the state when this point is reached.
@@ -126,4 +128,56 @@ _CpuId:
 	; Release stack frame
 	popad
 	pop ebp
-	ret 
\ No newline at end of file
+	ret 
+
+; Assembly routine to get
+; cpuid information for leaves that take a sub-leaf
+; void cpuidsubleaf(uint32_t cpuid, uint32_t subleaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx)
+_CpuIdSubleaf:
+	; Stack Frame
+	push ebp
+	mov ebp, esp
+	pushad
+
+	; Get CPUID
+	mov eax, [ebp + 8]
+	mov ecx, [ebp + 12]
+	cpuid
+	mov edi, [ebp + 16]
+	mov [edi], eax
+	mov edi, [ebp + 20]
+	mov [edi], ebx
+	mov edi, [ebp + 24]
+	mov [edi], ecx
+	mov edi, [ebp + 28]
+	mov [edi], edx
+
+	; Release stack frame
+	popad
+	pop ebp
+	ret 
+
+; Assembly routine to enable
+; xsave support and the given state components
+; void CpuEnableXSave(uint32_t MaskLow, uint32_t MaskHigh)
+_CpuEnableXSave:
+	; Stack Frame
+	push ebp
+	mov ebp, esp
+	pushad
+
+	; Enable
+	mov eax, cr4
+	bts eax, 18		;Set Operating System Support for XSAVE and Processor Extended States (Bit 18)
+	mov cr4, eax
+
+	; Write XCR0
+	xor ecx, ecx
+	mov eax, [ebp + 8]
+	mov edx, [ebp + 12]
+	xsetbv
+
+	; Release stack frame
+	popad
+	pop ebp
+	ret 
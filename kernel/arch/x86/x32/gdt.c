@@ -26,6 +26,7 @@
 #include <arch.h>
 #include <heap.h>
 #include <gdt.h>
+#include <cpu.h>
 
 /* Includes
  * - Library */
@@ -38,6 +39,10 @@ __EXTERN
 void
 TssInstall(
     _In_ int GdtIndex);
+__EXTERN
+void
+CoreInstall(
+    _In_ int GdtIndex);
 
 /* Globals
  * Static storage as we have no memory allocator here */
@@ -129,26 +134,52 @@ GdtInitialize(void)
 	GdtInstallTss(0, 1);
 }
 
+/* GdtCreateTss
+ * Allocates the task state segment and the per-cpu block for the
+ * given application cpu, must be called by a running cpu before
+ * the target cpu is started */
+OsStatus_t
+GdtCreateTss(
+    _In_ UUId_t Cpu)
+{
+	__TssDescriptors[Cpu] = (TssDescriptor_t*)kmalloc(sizeof(TssDescriptor_t));
+	if (__TssDescriptors[Cpu] == NULL) {
+		return OsError;
+	}
+	if (CpuCreateCore(Cpu, 0) == NULL) {
+		kfree(__TssDescriptors[Cpu]);
+		__TssDescriptors[Cpu] = NULL;
+		return OsError;
+	}
+	return OsSuccess;
+}
+
 /* GdtInstallTss
  * Helper for setting up a new task state segment for
  * the given cpu core, this should be done once per
- * core, and it will set default params for the TSS */
+ * core, and it will set default params for the TSS. The
+ * per-cpu segment is installed in the descriptor after the tss
+ * so the interrupt entry can derive it from the task register */
 void
 GdtInstallTss(
     _In_ UUId_t Cpu,
     _In_ int Static)
 {
 	// Variables
+	CpuCore_t *Core = NULL;
 	uint32_t tBase = 0;
 	uint32_t tLimit = 0;
 	int TssIndex = __GblGdtIndex;
 
-	// If we use the static allocator, it must be the boot cpu
+	// If we use the static allocator, it must be the boot cpu, the
+	// application cpus had their storage allocated by GdtCreateTss as
+	// nothing may allocate before their per-cpu block is installed
 	if (Static) {
 		__TssDescriptors[Cpu] = &__BootTss;
+		Core = CpuCreateCore(Cpu, Static);
 	}
 	else {
-		__TssDescriptors[Cpu] = (TssDescriptor_t*)kmalloc(sizeof(TssDescriptor_t));
+		Core = CpuGetCore(Cpu);
 	}
 
 	// Initialize descriptor by zeroing and set default members
@@ -174,6 +205,12 @@ GdtInstallTss(
 	// Install TSS into table and hardware
 	GdtInstallDescriptor(tBase, tLimit, GDT_TSS_ENTRY, 0x00);
 	TssInstall(TssIndex);
+
+	// Install the per-cpu segment and load it into fs
+	GdtInstallDescriptor((uint32_t)Core, sizeof(CpuCore_t) - 1,
+		GDT_RING0_DATA, GDT_FLAG_32BIT);
+	CoreInstall(TssIndex + 1);
+	CpuInstallCore(Cpu);
 }
 
 /* TssUpdateStack
@@ -31,9 +31,10 @@
 /* Customization of TSS and GDT entry limits
  * we allow for 16 gdt descriptors and tss descriptors 
  * they are allocated using static storage since we have
- * no dynamic memory at the time we need them */
+ * no dynamic memory at the time we need them. Each tss is followed
+ * by the per-cpu segment of the same cpu */
 #define GDT_MAX_TSS                 128
-#define GDT_MAX_DESCRIPTORS         (GDT_MAX_TSS + 8)
+#define GDT_MAX_DESCRIPTORS         ((GDT_MAX_TSS * 2) + 8)
 #define GDT_IOMAP_SIZE              2048
 
 /* 8 Hardcoded system descriptors, we must have a 
@@ -166,10 +167,21 @@ __EXTERN
 void
 GdtInstall(void);
 
+/* GdtCreateTss
+ * Allocates the task state segment and the per-cpu block for the
+ * given application cpu, must be called by a running cpu before
+ * the target cpu is started */
+__EXTERN
+OsStatus_t
+GdtCreateTss(
+    _In_ UUId_t Cpu);
+
 /* GdtInstallTss
  * Helper for setting up a new task state segment for
  * the given cpu core, this should be done once per
- * core, and it will set default params for the TSS */
+ * core, and it will set default params for the TSS.
+ * Nothing is allocated here, application cpus must have
+ * been prepared with GdtCreateTss */
 __EXTERN
 void
 GdtInstallTss(
@@ -30,8 +30,15 @@
 // Standard CRC-32 polynomial
 #define POLYNOMIAL              0x04c11db7L
 
+/* Crc32 Implementation Levels
+ * The lookup tables are always available, the carry-less multiply
+ * is only used outside the kernel on cpus that support it */
+#define CRC32_SLICE8            0
+#define CRC32_PCLMUL            1
+
 /* Crc32GenerateTable
- * Generates a dynamic crc-32 table. */
+ * Generates the dynamic crc-32 tables and selects the fastest
+ * implementation the cpu supports. */
 KERNELAPI
 void
 KERNELABI
@@ -48,4 +55,13 @@ Crc32Generate(
     _In_ uint8_t *DataPointer, 
     _In_ size_t DataSize);
 
+/* Crc32Select
+ * Overrides the implementation with the given level, used for benchmarking.
+ * Returns OsError if the cpu does not support the level. */
+KERNELAPI
+OsStatus_t
+KERNELABI
+Crc32Select(
+    _In_ int Level);
+
 #endif //!__MCORE_CRC32_H__
@@ -30,8 +30,17 @@
 
 /* Garbage Collector Definitions
  * Describes the prototype that can be registered */
+#define GC_MAX_HANDLERS             16
 typedef OsStatus_t (*GcHandler_t)(void*);
 
+/* GcEvent
+ * Garbage is queued through an event embedded in the object
+ * that needs cleanup, this way signalling never allocates. */
+typedef struct _GcEvent {
+    struct _GcEvent         *Link;
+    void                    *Data;
+} GcEvent_t;
+
 /* GcInitialize
  * Initializes the garbage-collector system */
 KERNELAPI
@@ -58,12 +67,15 @@ GcUnregister(
 	_In_ UUId_t Handler);
 
 /* GcSignal
- * Signals new garbage for the specified handler */
+ * Signals new garbage for the specified handler, the event must
+ * stay valid and unused until the handler has been called. This is
+ * lock-free and can be called from interrupt context */
 KERNELAPI
 OsStatus_t
 KERNELABI
 GcSignal(
 	_In_ UUId_t Handler,
+	_In_ GcEvent_t *Event,
 	_In_ void *Data);
 
 #endif //!_MCORE_GARBAGECOLLECTOR_H_
\ No newline at end of file
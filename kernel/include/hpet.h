@@ -128,7 +128,12 @@ typedef struct _HpController {
 	size_t					 TickMinimum;
 	size_t					 Period;
 	LargeInteger_t			 Frequency;
-	clock_t					 Clock;
+	int						 SystemTimer;
+
+	// Extension of 32 bit main counters
+	Spinlock_t				 CounterLock;
+	reg32_t					 CounterHigh;
+	reg32_t					 CounterLast;
 } HpController_t;
 
 /* HpInitialize
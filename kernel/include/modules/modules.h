@@ -40,11 +40,13 @@
 
 /* The module definition, it currently just
  * consists of the a ramdisk entry header and
- * a name/path */
+ * a name/path. The data is referenced in place in the
+ * ramdisk and is validated the first time it's loaded */
 typedef struct _MCoreModule {
 	MString_t                   *Name;
     MCoreRamDiskModuleHeader_t   Header;
     __CONST void                *Data;
+    int                          Validated;
 } MCoreModule_t;
 
 /* ModulesInitialize
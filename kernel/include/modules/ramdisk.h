@@ -45,6 +45,7 @@
 #define RAMDISK_FILE                0x1
 #define RAMDISK_DIRECTORY           0x2
 #define RAMDISK_MODULE              0x4
+#define RAMDISK_INDEX               0x8
 
 /* These are the different identifiers for a module
  * since modules can be different types of modules */
@@ -86,4 +87,22 @@ PACKED_TYPESTRUCT(MCoreRamDiskModuleHeader, {
     uint32_t    DeviceSubType;
 });
 
+/* MCoreRamDiskIndexHeader
+ * The data of the index entry, it's built when the image is
+ * created and is followed by the specific (vendor/device) records
+ * and then the generic (class/subclass) records. */
+PACKED_TYPESTRUCT(MCoreRamDiskIndexHeader, {
+    uint32_t    SpecificCount;
+    uint32_t    GenericCount;
+});
+
+/* MCoreRamDiskIndexRecord
+ * Records are sorted by the key pair and then by entry, the entry
+ * is the position of the module in the entry table. */
+PACKED_TYPESTRUCT(MCoreRamDiskIndexRecord, {
+    uint32_t    Primary; // VendorId or DeviceType
+    uint32_t    Secondary; // DeviceId or DeviceSubType
+    uint32_t    Entry;
+});
+
 #endif //!_RAMDISK_H_
@@ -27,6 +27,7 @@
 /* Includes
  * - Library */
 #include <os/osdefs.h>
+#include <stdatomic.h>
 
 /* Includes 
  * - System */
@@ -59,6 +60,7 @@ typedef struct _MCorePipe {
     Semaphore_t                 WriteQueue;
     size_t                      ReadQueueCount;
     size_t                      WriteQueueCount;
+    _Atomic(int)                References;
 } MCorePipe_t;
 
 /* PipeCreate
@@ -89,6 +91,22 @@ void
 PipeDestroy(
     _In_ MCorePipe_t *Pipe);
 
+/* PipeAcquire
+ * Takes a reference on the pipe, a pipe starts out with one
+ * reference that belongs to its creator */
+__EXTERN
+void
+PipeAcquire(
+    _In_ MCorePipe_t *Pipe);
+
+/* PipeRelease
+ * Drops a reference on the pipe, the pipe is destroyed
+ * when the last reference is dropped */
+__EXTERN
+void
+PipeRelease(
+    _In_ MCorePipe_t *Pipe);
+
 /* PipeWrite
  * Writes the given data to the pipe-buffer, unless PIPE_NOBLOCK_WRITE
  * has been specified, it will block untill there is room in the pipe */
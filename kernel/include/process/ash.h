@@ -29,11 +29,13 @@
 #include <ds/blbitmap.h>
 #include <ds/mstring.h>
 #include <ds/collection.h>
+#include <stdatomic.h>
 #include <signal.h>
 
 /* Includes
  * - System */
 #include <system/addresspace.h>
+#include <garbagecollector.h>
 #include <process/pe.h>
 #include <mutex.h>
 #include <pipe.h>
@@ -44,6 +46,7 @@
 #define ASH_STACK_INIT          0x1000
 #define ASH_STACK_MAX           (4 << 20)
 #define ASH_PIPE_SIZE           0x2000
+#define ASH_PIPE_PORTS          16
 
 /* Ash Queries
  * List of the different options
@@ -96,6 +99,13 @@ typedef struct _MCoreAsh {
     // derived from the file that spawned it
     MString_t           *Name;
     MString_t           *Path;
+
+    // Pipes on the low ports are kept in an array that
+    // is read without locking, the rest is in the collection.
+    // Lock-free lookups are counted so a closed pipe keeps its
+    // memory until no lookup can still be taking a reference
+    _Atomic(MCorePipe_t*) PortPipes[ASH_PIPE_PORTS];
+    _Atomic(int)         PipeLookups;
     Collection_t        *Pipes;
 
     // Memory management and information,
@@ -122,6 +132,7 @@ typedef struct _MCoreAsh {
     // This is the return/code
     // that gets set upon ash-exit
     int                  Code;
+    GcEvent_t            GcEvent;
 } MCoreAsh_t;
 
 /* PhoenixInitializeAsh
@@ -193,7 +204,8 @@ PhoenixCloseAshPipe(
 
 /* PhoenixGetAshPipe
  * Retrieves an existing pipe instance for the given ash
- * and port-id. If it doesn't exist, returns NULL. */
+ * and port-id. If it doesn't exist, returns NULL. The caller
+ * owns a reference and must drop it with PipeRelease */
 KERNELAPI
 MCorePipe_t*
 KERNELABI
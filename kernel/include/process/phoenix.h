@@ -104,6 +104,17 @@ PhoenixRegisterAlias(
 	_In_ MCoreAsh_t *Ash, 
     _In_ UUId_t Alias);
     
+/* PhoenixWaitAlias
+ * Waits for a server to register the given alias, this is how services
+ * order themselves after the services they depend on. Returns OsError
+ * if the alias was not registered within the timeout */
+KERNELAPI
+OsStatus_t
+KERNELABI
+PhoenixWaitAlias(
+    _In_ UUId_t Alias,
+    _In_ size_t Timeout);
+
 /* PhoenixUpdateAlias
  * Checks if the given process-id has an registered alias.
  * If it has, the given process-id will be overwritten. */
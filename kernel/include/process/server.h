@@ -44,6 +44,10 @@ typedef struct _MCoreServer {
     DevInfo_t            DeviceId;
     DevInfo_t            DeviceClass;
     DevInfo_t            DeviceSubClass;
+
+    // Boot timeline, the stages of the startup
+    // are logged relative to the creation
+    uint64_t             CreatedAt;
 } MCoreServer_t;
 
 /* PhoenixCreateServer
@@ -56,6 +60,16 @@ KERNELABI
 PhoenixCreateServer(
 	_In_ MString_t *Path);
 
+/* PhoenixServerTimeline
+ * Logs a startup stage of the server to the boot timeline with the
+ * time since boot and the time since the server was created */
+KERNELAPI
+void
+KERNELABI
+PhoenixServerTimeline(
+    _In_ MCoreServer_t  *Server,
+    _In_ __CONST char   *Stage);
+
 /* PhoenixCleanupServer
  * Cleans up all the server-specific resources allocated
  * this this AshServer, and afterwards call the base-cleanup */
@@ -84,6 +84,15 @@ KERNELABI
 SchedulerCreate(
     _In_ UUId_t Cpu);
 
+/* SchedulerGetCpu
+ * Retrieves the scheduler of the given cpu, returns NULL
+ * if the cpu has not been brought up yet */
+KERNELAPI
+Scheduler_t*
+KERNELABI
+SchedulerGetCpu(
+    _In_ UUId_t Cpu);
+
 /* SchedulerThreadInitialize
  * Can be called by the creation of a new thread to initalize
  * all the scheduler data for that thread. */
@@ -120,6 +129,18 @@ SchedulerThreadSleep(
     _In_ uintptr_t *Handle,
     _In_ size_t Timeout);
 
+/* SchedulerAtomicThreadSleep
+ * Enters the current thread into sleep-queue and releases the given lock
+ * once the thread is queued, so a waker holding the lock can't miss it.
+ * The lock must be acquired by the caller with interrupts disabled. */
+KERNELAPI
+int
+KERNELABI
+SchedulerAtomicThreadSleep(
+    _In_ uintptr_t *Handle,
+    _In_ size_t Timeout,
+    _In_Opt_ Spinlock_t *Lock);
+
 /* SchedulerThreadWake
  * Finds a sleeping thread with the given sleep-handle and wakes it. */
 KERNELAPI
@@ -136,15 +157,6 @@ KERNELABI
 SchedulerThreadWakeAll(
     _In_ uintptr_t *Handle);
 
-/* SchedulerTick
- * Iterates the io-queue and handle any threads that will timeout
- * on the tick. */
-KERNELAPI
-void
-KERNELABI
-SchedulerTick(
-    _In_ size_t Milliseconds);
-
 /* SchedulerThreadSchedule 
  * This should be called by the underlying archteicture code
  * to get the next thread that is to be run. */
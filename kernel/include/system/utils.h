@@ -51,6 +51,18 @@ typedef struct _SystemInformation {
 
 } SystemInformation_t;
 
+/* CpuCore
+ * The per-cpu control block, each cpu has it's own instance that
+ * it can reach in constant time through a segment register. The first
+ * two members are accessed from assembly and must keep their offsets */
+typedef struct _CpuCore {
+	struct _CpuCore			*Self;
+	UUId_t					 Id;
+	struct _MCoreThread		*CurrentThread;
+	struct _MCoreThread		*IdleThread;
+	struct _MCoreScheduler	*Scheduler;
+} CpuCore_t;
+
 /* SystemInformationQuery 
  * Queries information about the running system
  * and the underlying architecture */
@@ -67,6 +79,22 @@ UUId_t
 KERNELABI
 CpuGetCurrentId(void);
 
+/* CpuGetCore
+ * Retrieves the control block of the given cpu, returns
+ * NULL if the cpu has not been brought up yet */
+KERNELAPI
+CpuCore_t*
+KERNELABI
+CpuGetCore(
+    _In_ UUId_t Cpu);
+
+/* CpuGetCurrentCore
+ * Retrieves the control block of the calling cpu */
+KERNELAPI
+CpuCore_t*
+KERNELABI
+CpuGetCurrentCore(void);
+
 /* CpuIdle
  * Enters idle mode for the current cpu */
 KERNELAPI
@@ -29,7 +29,9 @@
 #include <os/osdefs.h>
 #include <system/addresspace.h>
 #include <mutex.h>
+#include <garbagecollector.h>
 #include <pipe.h>
+#include <timers.h>
 
 /* Define the thread entry point signature */
 #ifndef __THREADING_ENTRY
@@ -109,9 +111,11 @@ typedef struct _MCoreThread {
     struct {
         uintptr_t                   *Handle;
         int                          Timeout;
-        size_t                       TimeLeft;
+        size_t                       Generation;
+        MCoreTimer_t                 Timer;
     }                                Sleep;
     struct _MCoreThread             *Link;
+    GcEvent_t                        GcEvent;
 
     ThreadEntry_t                    Function;
     void                            *Arguments;
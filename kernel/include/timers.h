@@ -40,25 +40,37 @@ typedef struct _MCoreTimePerformanceOps {
 
 /* MCoreTimer
  * The timer structure, contains information about
- * the owner, the timeout and the type of timer. */
+ * the owner, the timeout and the type of timer. Timers are kept
+ * in a single queue sorted by their absolute deadline, Expire is
+ * invoked for kernel timers, otherwise the owner is notified.
+ * Expire receives the Generation the timer had when it expired, so
+ * the owner can tell a stale expiry from the one it queued last */
 typedef struct _MCoreTimer {
     UUId_t               Id;
     UUId_t               AshId;
     __CONST void        *Data;
 
     size_t               Interval;
-    volatile size_t      Current;
+    uint64_t             Deadline;
+    size_t               Generation;
     int                  Periodic;
+    int                  Queued;
+    int                  Cancelled;
+    void                (*Expire)(_In_ struct _MCoreTimer *Timer, _In_ size_t Generation);
+    struct _MCoreTimer  *Link;
 } MCoreTimer_t;
 
 /* MCoreSystemTimer
  * The system timer structure
- * Contains information related to the registered system timers */
+ * Contains information related to the registered system timers. Timers
+ * that can be armed one-shot provide Arm, and are then only interrupting
+ * when the next deadline is reached */
 typedef struct _MCoreSystemTimer {
 	UUId_t					Source;
 	size_t					Tick;
 	size_t					Ticks;
     clock_t                 (*SystemTick)(void);
+    void                    (*Arm)(_In_ size_t Ns);
 } MCoreSystemTimer_t;
 
 /* TimersInitialize
@@ -79,7 +91,8 @@ KERNELABI
 TimersRegisterSystemTimer(
 	_In_ UUId_t Source,
     _In_ size_t TickNs,
-    _In_ clock_t (*SystemTickHandler)(void));
+    _In_ clock_t (*SystemTickHandler)(void),
+    _In_Opt_ void (*ArmHandler)(_In_ size_t Ns));
 
 /* TimersRegisterPerformanceTimer
  * Registers a high performance timer that can be seperate
@@ -118,6 +131,34 @@ KERNELABI
 TimersStop(
     _In_ UUId_t TimerId);
 
+/* TimersQueue
+ * Queues a kernel timer to expire in the given interval, a timer that
+ * is queued already is moved to the new deadline. Expire must be set. */
+KERNELAPI
+void
+KERNELABI
+TimersQueue(
+    _In_ MCoreTimer_t *Timer,
+    _In_ size_t IntervalNs);
+
+/* TimersCancel
+ * Removes a queued timer from the timer queue, returns OsError if
+ * the timer was not queued (it expired or was never started) */
+KERNELAPI
+OsStatus_t
+KERNELABI
+TimersCancel(
+    _In_ MCoreTimer_t *Timer);
+
+/* TimersGetTimestamp
+ * Retrieves the absolute time that timer deadlines are measured in,
+ * the performance timer is used when present, otherwise system ticks */
+KERNELAPI
+OsStatus_t
+KERNELABI
+TimersGetTimestamp(
+    _Out_ uint64_t *Timestamp);
+
 /* TimersInterrupt
  * Called by the interrupt-code to tell the timer-management system
  * a new interrupt has occured from the given source. This allows
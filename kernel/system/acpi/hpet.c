@@ -24,6 +24,7 @@
 
 /* Includes
  * - System */
+#include <system/interrupts.h>
 #include <interrupts.h>
 #include <timers.h>
 #include <debug.h>
@@ -89,14 +90,6 @@ HpStart(void)
 	return HpWrite(HPET_REGISTER_CONFIG, Config);
 }
 
-/* HpGetTicks
- * Retrieves the number of ticks done by the PIT. */
-clock_t
-HpGetTicks(void)
-{
-    return HpetController.Clock;
-}
-
 /* HpReadFrequency
  * Reads the main frequency value into the given structure */
 void
@@ -107,18 +100,97 @@ HpReadFrequency(
 }
 
 /* HpReadPerformance
- * Reads the main counter register into the given structure */
+ * Reads the main counter register into the given structure, 32 bit
+ * counters are extended in software. The system timer is never armed
+ * for longer than a second, so no wrap can be missed. */
 void
 HpReadPerformance(
 	_Out_ LargeInteger_t *Value)
 {
+	// Variables
+	IntStatus_t InterruptStatus;
+	reg32_t High;
+
 	// Reset value
 	Value->QuadPart = 0;
 
-	// Read lower 32 bit
-	HpRead(HPET_REGISTER_MAINCOUNTER, &Value->u.LowPart);
+	// The halves of a 64 bit counter are read separately, so read
+	// until the upper half did not change while reading the lower
 	if (HpetController.Is64Bit) {
-		HpRead(HPET_REGISTER_MAINCOUNTER + 4, &Value->u.HighPart);
+		do {
+			HpRead(HPET_REGISTER_MAINCOUNTER + 4, &High);
+			HpRead(HPET_REGISTER_MAINCOUNTER, &Value->u.LowPart);
+			HpRead(HPET_REGISTER_MAINCOUNTER + 4, &Value->u.HighPart);
+		} while (High != Value->u.HighPart);
+	}
+	else {
+		// The counter must be read under the lock as well, otherwise
+		// an older value could be taken for a wrap
+		InterruptStatus = InterruptDisable();
+		SpinlockAcquire(&HpetController.CounterLock);
+		HpRead(HPET_REGISTER_MAINCOUNTER, &Value->u.LowPart);
+		if (Value->u.LowPart < HpetController.CounterLast) {
+			HpetController.CounterHigh++;
+		}
+		HpetController.CounterLast = Value->u.LowPart;
+		Value->u.HighPart = HpetController.CounterHigh;
+		SpinlockRelease(&HpetController.CounterLock);
+		InterruptRestoreState(InterruptStatus);
+	}
+}
+
+/* HpGetTicks
+ * Retrieves the number of milliseconds the main counter has run, the
+ * system timer is one-shot so the ticks are derived from the counter. */
+clock_t
+HpGetTicks(void)
+{
+	// Variables
+	LargeInteger_t Value;
+
+	HpReadPerformance(&Value);
+	return (clock_t)(((uint64_t)Value.QuadPart * MSEC_PER_SEC) 
+		/ (uint64_t)HpetController.Frequency.QuadPart);
+}
+
+/* HpArm
+ * Arms the system timer comparator one-shot to fire in the given 
+ * interval. If the counter passed the comparator while writing it the
+ * interrupt would be missed, so the interval is grown until it sticks. */
+void
+HpArm(
+	_In_ size_t Ns)
+{
+	// Variables
+	int Index       = HpetController.SystemTimer;
+	uint64_t Delta  = ((uint64_t)HpetController.Frequency.QuadPart * Ns)
+		/ (NSEC_PER_MSEC * MSEC_PER_SEC);
+	LargeInteger_t Comparator;
+	reg32_t Configuration, Counter;
+
+	// Never arm below what the hardware can deliver
+	if (Delta < HpetController.TickMinimum) {
+		Delta = HpetController.TickMinimum;
+	}
+	if (Delta == 0) {
+		Delta = 1;
+	}
+
+	// The interval is at most a second, so the low part decides
+	// whether the counter already passed the comparator
+	HpRead(HPET_TIMER_CONFIG(Index), &Configuration);
+	while (1) {
+		HpReadPerformance(&Comparator);
+		Comparator.QuadPart += Delta;
+		HpWrite(HPET_TIMER_COMPARATOR(Index), Comparator.u.LowPart);
+		if (!(Configuration & HPET_TIMER_CONFIG_32BITMODE)) {
+			HpWrite(HPET_TIMER_COMPARATOR(Index) + 4, Comparator.u.HighPart);
+		}
+		HpRead(HPET_REGISTER_MAINCOUNTER, &Counter);
+		if ((int32_t)(Comparator.u.LowPart - Counter) > 0) {
+			break;
+		}
+		Delta *= 2;
 	}
 }
 
@@ -149,10 +221,9 @@ HpInterrupt(
 		if (InterruptStatus & (1 << i)
 			&& HpetController.Timers[i].Enabled) {
 			if (HpetController.Timers[i].SystemTimer) {
-				HpetController.Clock++;
                 TimersInterrupt(HpetController.Timers[i].Interrupt);
 			}
-			if (!HpetController.Timers[i].PeriodicSupport) {
+			else if (!HpetController.Timers[i].PeriodicSupport) {
 				// Non periodic timer fired, what now?
 				WARNING("HPET::NON-PERIODIC TIMER FIRED");
 			}
@@ -329,7 +400,7 @@ HpInitialize(
     MCoreTimePerformanceOps_t PerformanceOps = { 
         HpReadFrequency, HpReadPerformance, NULL
     };
-	int Legacy = 0, FoundPeriodic = 0;
+	int Legacy = 0, FoundTimer = 0;
 	reg32_t TempValue;
 	int i, NumTimers;
 
@@ -340,6 +411,7 @@ HpInitialize(
 
 	// Initialize the structure
 	memset(&HpetController, 0, sizeof(HpController_t));
+	SpinlockReset(&HpetController.CounterLock);
 
 	// Initialize io-space
 	HpetController.BaseAddress = 
@@ -413,22 +485,22 @@ HpInitialize(
 		}
 	}
 
-	// Iterate and find periodic timer
-	// and install that one as system timer
+	// Iterate and find a timer to install as system timer, it
+	// runs one-shot and is armed for the next timer deadline
 	for (i = 0; i < NumTimers; i++) {
-		if (HpetController.Timers[i].Present
-			&& HpetController.Timers[i].PeriodicSupport) {
-			if (HpComparatorStart(i, 1000, 1) != OsSuccess) {
-				ERROR("Failed to initialize periodic timer %i", i);
+		if (HpetController.Timers[i].Present) {
+			HpetController.SystemTimer = i;
+			if (HpComparatorStart(i, 1000, 0) != OsSuccess) {
+				ERROR("Failed to initialize timer %i", i);
 			}
 			else {
 				if (TimersRegisterSystemTimer(HpetController.Timers[i].Interrupt, 
-                        1000, HpGetTicks) != OsSuccess) {
+                        1000, HpGetTicks, HpArm) != OsSuccess) {
 					ERROR("Failed register timer %i as the system timer", i);
 				}
 				else {
 					HpetController.Timers[i].SystemTimer = 1;
-					FoundPeriodic = 1;
+					FoundTimer = 1;
 					break;
 				}
 			}
@@ -440,10 +512,10 @@ HpInitialize(
         ERROR("Failed to register the performance handlers");
     }    
 
-	// If we didn't find periodic, use the first present
-	// timer as one-shot and reinit it every interrupt
-	if (!FoundPeriodic) {
-		WARNING("No periodic timer present!");
+	// If we didn't find a timer, the system timer
+	// falls back to the legacy timers
+	if (!FoundTimer) {
+		WARNING("No usable comparator present!");
 	}
 
 	// Success!
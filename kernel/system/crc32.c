@@ -17,19 +17,60 @@
  *
  *
  * MollenOS MCore - CRC Implementation
- *  - Implemented using lookup tables for speed
+ *  - Implemented using slice-by-8 lookup tables for speed, the host tools
+ *    that compile this file fold the bulk with carry-less multiplies
  */
 
 /* Includes
  * - Library */
 #include <crc32.h>
 
+/* The kernel doesn't save vector registers when it's interrupted,
+ * so it only ever uses the lookup tables */
+#ifndef LIBC_KERNEL
+#include <cpuid.h>
+#include <immintrin.h>
+
+/* Definitions CPUID */
+#define CPUID_FEAT_ECX_PCLMUL       (1 << 1)
+#define CPUID_FEAT_ECX_SSSE3        (1 << 9)
+#define CRC32_PCLMUL_TARGET         __attribute__((target("pclmul,ssse3")))
+
+/* The fold constants are x^n mod P for folding 512 and 128 bits ahead */
+static uint32_t CrcFoldConstants[4] = { 0 };
+
+/* Crc32PowerOfX (Private)
+ * Calculates x^Power mod P, the remainder of shifting a one bit
+ * through Power zero bits */
+static uint32_t
+Crc32PowerOfX(
+    _In_ int Power)
+{
+    // Variables
+    uint32_t Remainder = 1;
+
+    while (Power--) {
+        if (Remainder & 0x80000000L) {
+            Remainder = (Remainder << 1) ^ POLYNOMIAL;
+        }
+        else {
+            Remainder = (Remainder << 1);
+        }
+    }
+    return Remainder;
+}
+#endif
+
 /* Static Storage
- * Used for keeping the crc-32 table */
-static uint32_t CrcTable[256] = { 0 };
+ * Used for keeping the crc-32 tables, table 0 is the regular byte-wise
+ * table and table n advances a byte through n more zero bytes */
+static uint32_t CrcTable[8][256] = { { 0 } };
+static int CrcLevelSupported = CRC32_SLICE8;
+static int CrcLevel = CRC32_SLICE8;
 
 /* Crc32GenerateTable
- * Generates a dynamic crc-32 table. */
+ * Generates the dynamic crc-32 tables and selects the fastest
+ * implementation the cpu supports. */
 void
 Crc32GenerateTable(void)
 {
@@ -48,10 +89,156 @@ Crc32GenerateTable(void)
                 CrcAccumulator = (CrcAccumulator << 1);
             }
         }
-        CrcTable[i] = CrcAccumulator;
+        CrcTable[0][i] = CrcAccumulator;
+    }
+
+    // Derive the slicing tables from the byte-wise table
+    for (i = 0; i < 256; i++) {
+        for (j = 1; j < 8; j++) {
+            CrcTable[j][i] = (CrcTable[j - 1][i] << 8) 
+                ^ CrcTable[0][CrcTable[j - 1][i] >> 24];
+        }
     }
+
+#ifndef LIBC_KERNEL
+    // Folding a 128 bit block n bits ahead multiplies the high
+    // half by x^(n+64) and the low half by x^n
+    CrcFoldConstants[0] = Crc32PowerOfX(512 + 64);
+    CrcFoldConstants[1] = Crc32PowerOfX(512);
+    CrcFoldConstants[2] = Crc32PowerOfX(128 + 64);
+    CrcFoldConstants[3] = Crc32PowerOfX(128);
+    {
+        unsigned int Eax = 0, Ebx = 0, Ecx = 0, Edx = 0;
+        if (__get_cpuid(1, &Eax, &Ebx, &Ecx, &Edx)
+            && (Ecx & CPUID_FEAT_ECX_PCLMUL) && (Ecx & CPUID_FEAT_ECX_SSSE3)) {
+            CrcLevelSupported = CRC32_PCLMUL;
+        }
+    }
+#endif
+    CrcLevel = CrcLevelSupported;
+}
+
+/* Crc32Select
+ * Overrides the implementation with the given level, used for benchmarking.
+ * Returns OsError if the cpu does not support the level. */
+OsStatus_t
+Crc32Select(
+    _In_ int Level)
+{
+    if (Level < CRC32_SLICE8 || Level > CrcLevelSupported) {
+        return OsError;
+    }
+    CrcLevel = Level;
+    return OsSuccess;
 }
 
+/* Crc32Update (Private)
+ * Accumulates the data into the crc without the final inversion, the
+ * bulk is processed 8 bytes at the time. */
+static uint32_t
+Crc32Update(
+    _In_ uint32_t CrcAccumulator, 
+    _In_ const uint8_t *DataPointer, 
+    _In_ size_t DataSize)
+{
+    // Variables
+    register size_t i;
+
+    // Slice 8 bytes per iteration, the crc is msb-first so
+    // the first four bytes are folded in as big-endian
+    while (DataSize >= 8) {
+        CrcAccumulator ^= ((uint32_t)DataPointer[0] << 24) | ((uint32_t)DataPointer[1] << 16)
+            | ((uint32_t)DataPointer[2] << 8) | (uint32_t)DataPointer[3];
+        CrcAccumulator = CrcTable[7][CrcAccumulator >> 24]
+            ^ CrcTable[6][(CrcAccumulator >> 16) & 0xFF]
+            ^ CrcTable[5][(CrcAccumulator >> 8) & 0xFF]
+            ^ CrcTable[4][CrcAccumulator & 0xFF]
+            ^ CrcTable[3][DataPointer[4]]
+            ^ CrcTable[2][DataPointer[5]]
+            ^ CrcTable[1][DataPointer[6]]
+            ^ CrcTable[0][DataPointer[7]];
+        DataPointer += 8;
+        DataSize -= 8;
+    }
+
+    // Iterate each remaining byte and accumulate crc
+    while (DataSize--) {
+        i = ((int) (CrcAccumulator >> 24) ^ *DataPointer++) & 0xFF;
+        CrcAccumulator = (CrcAccumulator << 8) ^ CrcTable[0][i];
+    }
+    return CrcAccumulator;
+}
+
+#ifndef LIBC_KERNEL
+/* Crc32Fold (Private)
+ * Folds a 128 bit block ahead by the distance of the given constants, the
+ * result is congruent to the block shifted by that distance modulo P */
+CRC32_PCLMUL_TARGET
+static inline __m128i
+Crc32Fold(
+    _In_ __m128i Block,
+    _In_ __m128i Constants)
+{
+    return _mm_xor_si128(_mm_clmulepi64_si128(Block, Constants, 0x11),
+        _mm_clmulepi64_si128(Block, Constants, 0x00));
+}
+
+/* Crc32UpdatePclmul (Private)
+ * Accumulates at least 64 bytes into the crc. The data is loaded as
+ * big-endian 128 bit blocks, four blocks are folded in parallel, then into
+ * one and the remaining block is reduced by the lookup tables. */
+CRC32_PCLMUL_TARGET
+static uint32_t
+Crc32UpdatePclmul(
+    _In_ uint32_t CrcAccumulator, 
+    _In_ const uint8_t *DataPointer, 
+    _In_ size_t DataSize)
+{
+    // Variables
+    const __m128i Reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+        8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i Fold512 = _mm_set_epi32(0, (int)CrcFoldConstants[0], 0, (int)CrcFoldConstants[1]);
+    const __m128i Fold128 = _mm_set_epi32(0, (int)CrcFoldConstants[2], 0, (int)CrcFoldConstants[3]);
+    __m128i Block0, Block1, Block2, Block3;
+    uint8_t Remainder[16];
+
+#define CRC32_LOAD(Offset) _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(DataPointer + (Offset))), Reverse)
+
+    // The accumulator is xor'ed into the first four bytes
+    Block0 = _mm_xor_si128(CRC32_LOAD(0), _mm_set_epi32((int)CrcAccumulator, 0, 0, 0));
+    Block1 = CRC32_LOAD(16);
+    Block2 = CRC32_LOAD(32);
+    Block3 = CRC32_LOAD(48);
+    DataPointer += 64;
+    DataSize -= 64;
+
+    while (DataSize >= 64) {
+        Block0 = _mm_xor_si128(Crc32Fold(Block0, Fold512), CRC32_LOAD(0));
+        Block1 = _mm_xor_si128(Crc32Fold(Block1, Fold512), CRC32_LOAD(16));
+        Block2 = _mm_xor_si128(Crc32Fold(Block2, Fold512), CRC32_LOAD(32));
+        Block3 = _mm_xor_si128(Crc32Fold(Block3, Fold512), CRC32_LOAD(48));
+        DataPointer += 64;
+        DataSize -= 64;
+    }
+
+    Block1 = _mm_xor_si128(Crc32Fold(Block0, Fold128), Block1);
+    Block2 = _mm_xor_si128(Crc32Fold(Block1, Fold128), Block2);
+    Block3 = _mm_xor_si128(Crc32Fold(Block2, Fold128), Block3);
+    while (DataSize >= 16) {
+        Block3 = _mm_xor_si128(Crc32Fold(Block3, Fold128), CRC32_LOAD(0));
+        DataPointer += 16;
+        DataSize -= 16;
+    }
+#undef CRC32_LOAD
+
+    // The block is congruent to the data folded so far, running it through
+    // the tables from zero gives the crc of it
+    _mm_storeu_si128((__m128i*)&Remainder[0], _mm_shuffle_epi8(Block3, Reverse));
+    CrcAccumulator = Crc32Update(0, &Remainder[0], sizeof(Remainder));
+    return Crc32Update(CrcAccumulator, DataPointer, DataSize);
+}
+#endif
+
 /* Crc32Generate
  * Generates an crc-32 checksum from the given accumulator and
  * the given data. */
@@ -61,14 +248,10 @@ Crc32Generate(
     _In_ uint8_t *DataPointer, 
     _In_ size_t DataSize)
 {
-    // Variables
-    register size_t i, j;
-
-    // Iterate each byte and accumulate crc
-    for (j = 0; j < DataSize; j++) {
-        i = ((int) (CrcAccumulator >> 24) ^ *DataPointer++) & 0xFF;
-        CrcAccumulator = (CrcAccumulator << 8) ^ CrcTable[i];
+#ifndef LIBC_KERNEL
+    if (CrcLevel == CRC32_PCLMUL && DataSize >= 64) {
+        return ~Crc32UpdatePclmul(CrcAccumulator, DataPointer, DataSize);
     }
-    CrcAccumulator = ~CrcAccumulator;
-    return CrcAccumulator;
+#endif
+    return ~Crc32Update(CrcAccumulator, DataPointer, DataSize);
 }
@@ -30,21 +30,27 @@
 
 /* Includes
  * - Library */
-#include <ds/collection.h>
+#include <stdatomic.h>
 #include <stddef.h>
 
+/* GcHandlerEntry
+ * Each handler has it's own list of pending events, producers push
+ * onto the list lock-free and the worker takes the entire list at once */
+typedef struct _GcHandlerEntry {
+	GcHandler_t				 Handler;
+	_Atomic(GcEvent_t*)		 Pending;
+} GcHandlerEntry_t;
+
 /* Prototypes 
  * Defines the GC worker thread */
 void GcWorker(void *Args);
 
 /* Globals 
  * Needed for state-keeping */
+static GcHandlerEntry_t GlbGcHandlers[GC_MAX_HANDLERS];
 static Semaphore_t *GlbGcEventLock  = NULL;
-static Collection_t *GlbGcHandlers  = NULL;
-static Collection_t *GlbGcEvents    = NULL;
-static CriticalSection_t GcSignalLock;
+static CriticalSection_t GcRegisterLock;
 static int GlbGcInitialized         = 0;
-static UUId_t GlbGcId               = 0;
 
 /* GcConstruct
  * Constructs the gc data-systems, but does
@@ -52,12 +58,16 @@ static UUId_t GlbGcId               = 0;
 void
 GcConstruct(void)
 {
+	// Variables
+	int i;
+
 	// Create data-structures
 	GlbGcEventLock = SemaphoreCreate(0);
-	GlbGcHandlers = CollectionCreate(KeyInteger);
-	GlbGcEvents = CollectionCreate(KeyInteger);
-    CriticalSectionConstruct(&GcSignalLock, CRITICALSECTION_PLAIN);
-	GlbGcId = 0;
+	CriticalSectionConstruct(&GcRegisterLock, CRITICALSECTION_PLAIN);
+	for (i = 0; i < GC_MAX_HANDLERS; i++) {
+		GlbGcHandlers[i].Handler = NULL;
+		atomic_init(&GlbGcHandlers[i].Pending, NULL);
+	}
 
 	// Set initialized
 	GlbGcInitialized = 1;
@@ -80,6 +90,25 @@ GcInitialize(void)
 	ThreadingCreateThread("gc-worker", GcWorker, NULL, 0);
 }
 
+/* GcDiscard (Private)
+ * Takes all pending events of a handler without running them, the
+ * events are unlinked so their owners may signal them again */
+void
+GcDiscard(
+	_In_ GcHandlerEntry_t *Entry)
+{
+	// Variables
+	GcEvent_t *Events   = NULL;
+	GcEvent_t *Next     = NULL;
+
+	Events = atomic_exchange(&Entry->Pending, NULL);
+	while (Events != NULL) {
+		Next = Events->Link;
+		Events->Link = NULL;
+		Events = Next;
+	}
+}
+
 /* GcRegister
  * Registers a new gc-handler that will be run
  * when new work is available, returns the unique id
@@ -89,115 +118,142 @@ GcRegister(
 	_In_ GcHandler_t Handler)
 {
 	// Variables
-	DataKey_t Key;
+	UUId_t Id = UUID_INVALID;
+	int i;
 
 	// Sanitize initialization status
 	if (GlbGcInitialized != 1) {
 		GcConstruct();
 	}
 
-	// Generate a uuid for it
-	Key.Value = (int)GlbGcId++;
-
-	// Cool thing - add the handler
-	CollectionAppend(GlbGcHandlers, CollectionCreateNode(Key, (void*)Handler));
-
-	// Done - no errors
-	return (UUId_t)Key.Value;
+	// The id is the slot, so signals don't need a lookup. Events that
+	// raced with the unregistration of the previous handler are dropped
+	CriticalSectionEnter(&GcRegisterLock);
+	for (i = 0; i < GC_MAX_HANDLERS; i++) {
+		if (GlbGcHandlers[i].Handler == NULL) {
+			GcDiscard(&GlbGcHandlers[i]);
+			GlbGcHandlers[i].Handler = Handler;
+			Id = (UUId_t)i;
+			break;
+		}
+	}
+	CriticalSectionLeave(&GcRegisterLock);
+	return Id;
 }
 
 /* GcUnregister
- * Removes a previously registed handler by its id */
+ * Removes a previously registed handler by its id, events
+ * that are still pending for the handler are dropped */
 OsStatus_t
 GcUnregister(
 	_In_ UUId_t Handler)
 {
-	// Variables
-	DataKey_t Key;
-
-	// Setup the key
-	Key.Value = (int)Handler;
-
 	// Sanitize the status of the gc
-	if (GlbGcInitialized != 1
-		|| CollectionGetDataByKey(GlbGcHandlers, Key, 0) == NULL) {
+	if (GlbGcInitialized != 1 || Handler >= GC_MAX_HANDLERS
+		|| GlbGcHandlers[Handler].Handler == NULL) {
 		return OsError;
 	}
 
-	// Remove the entry
-	CollectionRemoveByKey(GlbGcHandlers, Key);
-
-	// Done - no further cleanup needed
+	// Remove the entry, then drop the pending events so they don't
+	// reach the next handler registered in the slot
+	CriticalSectionEnter(&GcRegisterLock);
+	GlbGcHandlers[Handler].Handler = NULL;
+	GcDiscard(&GlbGcHandlers[Handler]);
+	CriticalSectionLeave(&GcRegisterLock);
 	return OsSuccess;
 }
 
 /* GcSignal
- * Signals new garbage for the specified handler */
+ * Signals new garbage for the specified handler, the event must
+ * stay valid and unused until the handler has been called. This is
+ * lock-free and can be called from interrupt context */
 OsStatus_t
 GcSignal(
 	_In_ UUId_t Handler,
+	_In_ GcEvent_t *Event,
 	_In_ void *Data)
 {
 	// Variables
-	DataKey_t Key;
-
-	// Setup the key
-	Key.Value = (int)Handler;
+	GcHandlerEntry_t *Entry = NULL;
+	GcEvent_t *Head         = NULL;
 
 	// Sanitize the status of the gc
-	if (GlbGcInitialized != 1
-		|| CollectionGetDataByKey(GlbGcHandlers, Key, 0) == NULL) {
+	if (GlbGcInitialized != 1 || Handler >= GC_MAX_HANDLERS
+		|| GlbGcHandlers[Handler].Handler == NULL || Event == NULL) {
 		return OsError;
 	}
 
-	// Create a new event
-    CriticalSectionEnter(&GcSignalLock);
-	CollectionAppend(GlbGcEvents, CollectionCreateNode(Key, Data));
-    CriticalSectionLeave(&GcSignalLock);
-	SemaphoreV(GlbGcEventLock, 1);
-
-	// Done - no errors
+	// Push the event onto the pending list
+	Entry = &GlbGcHandlers[Handler];
+	Event->Data = Data;
+	Head = atomic_load(&Entry->Pending);
+	do {
+		Event->Link = Head;
+	} while (!atomic_compare_exchange_weak(&Entry->Pending, &Head, Event));
+
+	// Only wake the worker when the list goes from empty, it
+	// drains everything that is pending when it runs
+	if (Head == NULL) {
+		SemaphoreV(GlbGcEventLock, 1);
+	}
 	return OsSuccess;
 }
 
+/* GcDrain
+ * Takes all pending events of a handler and runs them in the
+ * order they were signalled. Returns the number of events handled */
+int
+GcDrain(
+	_In_ GcHandlerEntry_t *Entry)
+{
+	// Variables
+	GcEvent_t *Events   = NULL;
+	GcEvent_t *Ordered  = NULL;
+	GcEvent_t *Next     = NULL;
+	GcHandler_t Handler = NULL;
+	int Count           = 0;
+
+	// Take the list, it's pushed in reverse order
+	Events = atomic_exchange(&Entry->Pending, NULL);
+	while (Events != NULL) {
+		Next = Events->Link;
+		Events->Link = Ordered;
+		Ordered = Events;
+		Events = Next;
+	}
+
+	// Run the handler for each, the event belongs to the
+	// object and can't be touched once the handler is called
+	Handler = Entry->Handler;
+	while (Ordered != NULL) {
+		Next = Ordered->Link;
+		if (Handler != NULL) {
+			Handler(Ordered->Data);
+		}
+		Ordered = Next;
+		Count++;
+	}
+	return Count;
+}
+
 /* GcWorker
- * The event-handler thread */
+ * The event-handler thread, each wakeup processes everything pending */
 void GcWorker(void *Args)
 {
 	// Variables
-	CollectionItem_t *eNode = NULL;
-	GcHandler_t Handler;
 	int Run = 1;
+	int i;
 
 	// Unused arg
 	_CRT_UNUSED(Args);
 
 	// Run as long as the OS runs
-	while (Run)
-	{
-		// Wait for next event
+	while (Run) {
 		SemaphoreP(GlbGcEventLock, 0);
-
-		// Pop event
-        CriticalSectionEnter(&GcSignalLock);
-		eNode = CollectionPopFront(GlbGcEvents);
-        CriticalSectionLeave(&GcSignalLock);
-
-		// Sanitize the node
-		if (eNode == NULL) {
-			continue;
+		for (i = 0; i < GC_MAX_HANDLERS; i++) {
+			if (atomic_load(&GlbGcHandlers[i].Pending) != NULL) {
+				GcDrain(&GlbGcHandlers[i]);
+			}
 		}
-
-		// Sanitize the handler
-		if ((Handler = (GcHandler_t)CollectionGetDataByKey(GlbGcHandlers, eNode->Key, 0)) == NULL) {
-			CollectionDestroyNode(GlbGcEvents, eNode);
-			continue;
-		}
-
-		// Call the handler
-		Handler(eNode->Data);
-
-		// Free the node
-		CollectionDestroyNode(GlbGcEvents, eNode);
 	}
 }
@@ -34,21 +34,29 @@
 
 /* Includes
  * - Library */
-#include <ds/collection.h>
 #include <stddef.h>
 
-/* Private definitions that are local to this file */
-#define LIST_MODULE             1
-#define LIST_SERVER             2
-
-/* Globals */
-Collection_t *GlbModules = NULL;
-int GlbModulesInitialized = 0;
+/* Module Validation States
+ * The crc of a module is checked the first time it's loaded */
+#define MODULE_UNVALIDATED      0
+#define MODULE_VALID            1
+#define MODULE_INVALID          -1
+
+/* Globals
+ * Modules are stored at their position in the entry table, so the
+ * records of the ramdisk index can refer to them directly */
+static MCoreModule_t *GlbModules                    = NULL;
+static int GlbModuleCount                           = 0;
+static MCoreRamDiskIndexRecord_t *GlbSpecificIndex  = NULL;
+static MCoreRamDiskIndexRecord_t *GlbGenericIndex   = NULL;
+static int GlbSpecificCount                         = 0;
+static int GlbGenericCount                          = 0;
+static int GlbModulesInitialized                    = 0;
 
 /* ModulesInitialize
  * Loads the ramdisk, iterates all headers and 
  * builds a list of both available servers and 
- * available drivers */
+ * available drivers. Module data is not copied or validated here */
 OsStatus_t
 ModulesInitialize(
     _In_ Multiboot_t *BootInformation)
@@ -56,7 +64,8 @@ ModulesInitialize(
     // Variables
     MCoreRamDiskHeader_t *Ramdisk = NULL;
     MCoreRamDiskEntry_t *Entry = NULL;
-    int Counter = 0;
+    int Found = 0;
+    int i;
     
     // Debug
     TRACE("ModulesInitialize(Address 0x%x, Size 0x%x)",
@@ -83,65 +92,112 @@ ModulesInitialize(
         return OsError;
     }
 
-    // Initialize the list of modules 
-    // and servers so we can add later :-)
-    GlbModules = CollectionCreate(KeyInteger);
-
-    // Store filecount so we can iterate
+    // Allocate a module for every entry in one go
+    GlbModuleCount = Ramdisk->FileCount;
+    GlbModules = (MCoreModule_t*)kmalloc(sizeof(MCoreModule_t) * GlbModuleCount);
+    if (GlbModules == NULL) {
+        ERROR("Failed to allocate %i modules", GlbModuleCount);
+        GlbModuleCount = 0;
+        return OsError;
+    }
+    memset(GlbModules, 0, sizeof(MCoreModule_t) * GlbModuleCount);
     Entry = (MCoreRamDiskEntry_t*)
         (BootInformation->RamdiskAddress + sizeof(MCoreRamDiskHeader_t));
-    Counter = Ramdisk->FileCount;
 
-    // Keep iterating untill we reach the end of counter
-    TRACE("Parsing %i number of files in the ramdisk", Counter);
-    while (Counter != 0) {
+    // Keep iterating untill we reach the end of entries
+    TRACE("Parsing %i number of files in the ramdisk", GlbModuleCount);
+    for (i = 0; i < GlbModuleCount; i++, Entry++) {
         if (Entry->Type == RAMDISK_MODULE || Entry->Type == RAMDISK_FILE) {
             MCoreRamDiskModuleHeader_t *Header =
                 (MCoreRamDiskModuleHeader_t*)(BootInformation->RamdiskAddress + Entry->DataHeaderOffset);
-            MCoreModule_t *Module = NULL;
-            uint8_t *ModuleData = NULL;
-            uint32_t CrcOfData = 0;
-            DataKey_t Key;
-
-            // Perform CRC validation
-            ModuleData = (uint8_t*)(BootInformation->RamdiskAddress 
-                + Entry->DataHeaderOffset + sizeof(MCoreRamDiskModuleHeader_t));
-            CrcOfData = Crc32Generate(-1, ModuleData, Header->LengthOfData);
-            if (CrcOfData != Header->Crc32OfData) {
-                ERROR("CRC-Validation(%s): Failed (Calculated 0x%x != Stored 0x%x)",
-                    &Entry->Name[0], CrcOfData, Header->Crc32OfData);
-            }
+            MCoreModule_t *Module = &GlbModules[i];
 
-            // Allocate a new module header and copy some values 
-            Module = (MCoreModule_t*)kmalloc(sizeof(MCoreModule_t));
+            // Reference the data where it is, the ramdisk
+            // is never released
             Module->Name = MStringCreate(Entry->Name, StrUTF8);
             memcpy(&Module->Header, Header, sizeof(MCoreRamDiskModuleHeader_t));
-            Module->Data = (__CONST void*)kmalloc(Header->LengthOfData);
-            memcpy((void*)Module->Data, ModuleData, Header->LengthOfData);
-
-            // Update key based on the type of module
-            // either its a server or a driver
-            if (Header->Flags & RAMDISK_MODULE_SERVER) {
-                Key.Value = LIST_SERVER;
-            }
-            else {
-                Key.Value = LIST_MODULE;
-            }
-            CollectionAppend(GlbModules, CollectionCreateNode(Key, Module));
+            Module->Data = (__CONST void*)((uintptr_t)Header + sizeof(MCoreRamDiskModuleHeader_t));
+            Module->Validated = MODULE_UNVALIDATED;
+            Found++;
+        }
+        else if (Entry->Type == RAMDISK_INDEX) {
+            MCoreRamDiskIndexHeader_t *Index =
+                (MCoreRamDiskIndexHeader_t*)(BootInformation->RamdiskAddress + Entry->DataHeaderOffset);
+            GlbSpecificIndex = (MCoreRamDiskIndexRecord_t*)((uintptr_t)Index + sizeof(MCoreRamDiskIndexHeader_t));
+            GlbSpecificCount = (int)Index->SpecificCount;
+            GlbGenericIndex = GlbSpecificIndex + GlbSpecificCount;
+            GlbGenericCount = (int)Index->GenericCount;
         }
         else {
             WARNING("Unknown entry type: %u", Entry->Type);
         }
-        Entry++;
-        Counter--;
     }
 
     // Debug
-    TRACE("Found %i Modules and Servers", CollectionLength(GlbModules));
+    TRACE("Found %i Modules and Servers", Found);
 
     // All is fine
     GlbModulesInitialized = 1;
-    return CollectionLength(GlbModules) == 0 ? OsError : OsSuccess;
+    return Found == 0 ? OsError : OsSuccess;
+}
+
+/* ModulesValidate
+ * Validates the module data against the crc stored in the ramdisk,
+ * this is only done the first time a module is loaded */
+OsStatus_t
+ModulesValidate(
+    _In_ MCoreModule_t *Module)
+{
+    // Variables
+    uint32_t CrcOfData = 0;
+
+    if (Module->Validated == MODULE_UNVALIDATED) {
+        CrcOfData = Crc32Generate(-1, (uint8_t*)Module->Data, Module->Header.LengthOfData);
+        if (CrcOfData != Module->Header.Crc32OfData) {
+            ERROR("CRC-Validation(%s): Failed (Calculated 0x%x != Stored 0x%x)",
+                MStringRaw(Module->Name), CrcOfData, Module->Header.Crc32OfData);
+            Module->Validated = MODULE_INVALID;
+        }
+        else {
+            Module->Validated = MODULE_VALID;
+        }
+    }
+    return (Module->Validated == MODULE_VALID) ? OsSuccess : OsError;
+}
+
+/* ModulesIndexLookup
+ * Binary searches the given index for the first record matching the
+ * key pair, returns the module of the record or NULL */
+MCoreModule_t*
+ModulesIndexLookup(
+    _In_ MCoreRamDiskIndexRecord_t *Index,
+    _In_ int Count,
+    _In_ DevInfo_t Primary,
+    _In_ DevInfo_t Secondary)
+{
+    // Variables
+    int Low = 0, High = Count;
+
+    // Find the lower bound of the key
+    while (Low < High) {
+        int Middle = Low + ((High - Low) / 2);
+        if (Index[Middle].Primary < Primary
+            || (Index[Middle].Primary == Primary && Index[Middle].Secondary < Secondary)) {
+            Low = Middle + 1;
+        }
+        else {
+            High = Middle;
+        }
+    }
+
+    // Match and sanitize the entry
+    if (Low < Count && Index[Low].Primary == Primary
+        && Index[Low].Secondary == Secondary
+        && Index[Low].Entry < (uint32_t)GlbModuleCount
+        && GlbModules[Index[Low].Entry].Name != NULL) {
+        return &GlbModules[Index[Low].Entry];
+    }
+    return NULL;
 }
 
 /* ModulesRunServers
@@ -152,6 +208,7 @@ ModulesRunServers(void)
 {
     // Variables
     IntStatus_t IrqState = 0;
+    int i;
 
     // Sanitize init status
     if (GlbModulesInitialized != 1) {
@@ -165,11 +222,12 @@ ModulesRunServers(void)
 
     // Iterate module list and spawn all servers
     // then they will "run" the system for us
-    foreach(sNode, GlbModules) {
-        if (sNode->Key.Value == LIST_SERVER) {
+    for (i = 0; i < GlbModuleCount; i++) {
+        if (GlbModules[i].Name != NULL
+            && (GlbModules[i].Header.Flags & RAMDISK_MODULE_SERVER)) {
             MCorePhoenixRequest_t *Request = NULL;
             MString_t *Path = MStringCreate("rd:/", StrUTF8);
-            MStringAppendString(Path, ((MCoreModule_t*)sNode->Data)->Name);
+            MStringAppendString(Path, GlbModules[i].Name);
 
             // Allocate a new request, let it cleanup itself
             Request = (MCorePhoenixRequest_t*)kmalloc(sizeof(MCorePhoenixRequest_t));
@@ -190,7 +248,8 @@ ModulesRunServers(void)
 
 /* ModulesQueryPath
  * Retrieve a pointer to the file-buffer and its length 
- * based on the given <rd:/> path */
+ * based on the given <rd:/> path. The buffer is the ramdisk
+ * itself and must not be modified or freed */
 OsStatus_t
 ModulesQueryPath(
     _In_ MString_t *Path, 
@@ -201,6 +260,7 @@ ModulesQueryPath(
     MString_t *Token    = Path;
     OsStatus_t Result   = OsError;
     int Index           = -1;
+    int i;
 
     // Debug
     TRACE("ModulesQueryPath(%s)", MStringRaw(Path));
@@ -218,13 +278,18 @@ ModulesQueryPath(
     TRACE("TokenToSearchFor(%s)", MStringRaw(Token));
 
     // Locate the module
-    foreach(sNode, GlbModules) {
-        MCoreModule_t *Mod = (MCoreModule_t*)sNode->Data;
+    for (i = 0; i < GlbModuleCount; i++) {
+        MCoreModule_t *Mod = &GlbModules[i];
+        if (Mod->Name == NULL) {
+            continue;
+        }
         TRACE("Comparing(%s)To(%s)", MStringRaw(Token), MStringRaw(Mod->Name));
         if (MStringCompare(Token, Mod->Name, 1) != MSTRING_NO_MATCH) {
-            *Buffer = (void*)Mod->Data;
-            *Length = Mod->Header.LengthOfData;
-            Result = OsSuccess;
+            if (ModulesValidate(Mod) == OsSuccess) {
+                *Buffer = (void*)Mod->Data;
+                *Length = Mod->Header.LengthOfData;
+                Result = OsSuccess;
+            }
             break;
         }
     }
@@ -248,15 +313,25 @@ ModulesFindGeneric(
     _In_ DevInfo_t DeviceType, 
     _In_ DevInfo_t DeviceSubType)
 {
+    // Variables
+    int i;
+
     // Sanitize status
     if (GlbModulesInitialized != 1) {
         return NULL;
     }
 
+    // Use the index if the ramdisk has one
+    if (GlbGenericIndex != NULL) {
+        return ModulesIndexLookup(GlbGenericIndex, GlbGenericCount,
+            DeviceType, DeviceSubType);
+    }
+
     // Locate the module
-    foreach(sNode, GlbModules) {
-        MCoreModule_t *Mod = (MCoreModule_t*)sNode->Data;
-        if (Mod->Header.DeviceType == DeviceType
+    for (i = 0; i < GlbModuleCount; i++) {
+        MCoreModule_t *Mod = &GlbModules[i];
+        if (Mod->Name != NULL
+            && Mod->Header.DeviceType == DeviceType
             && Mod->Header.DeviceSubType == DeviceSubType) {
             return Mod;
         }
@@ -273,6 +348,9 @@ ModulesFindSpecific(
     _In_ DevInfo_t VendorId, 
     _In_ DevInfo_t DeviceId)
 {
+    // Variables
+    int i;
+
     // Sanitize status
     if (GlbModulesInitialized != 1) {
         return NULL;
@@ -283,10 +361,17 @@ ModulesFindSpecific(
         return NULL;
     }
 
+    // Use the index if the ramdisk has one
+    if (GlbSpecificIndex != NULL) {
+        return ModulesIndexLookup(GlbSpecificIndex, GlbSpecificCount,
+            VendorId, DeviceId);
+    }
+
     // Locate the module
-    foreach(sNode, GlbModules) {
-        MCoreModule_t *Mod = (MCoreModule_t*)sNode->Data;
-        if (Mod->Header.VendorId == VendorId
+    for (i = 0; i < GlbModuleCount; i++) {
+        MCoreModule_t *Mod = &GlbModules[i];
+        if (Mod->Name != NULL
+            && Mod->Header.VendorId == VendorId
             && Mod->Header.DeviceId == DeviceId) {
             return Mod;
         }
@@ -301,15 +386,19 @@ MCoreModule_t*
 ModulesFindString(
     _In_ MString_t *Module)
 {
+    // Variables
+    int i;
+
     // Sanitize status
     if (GlbModulesInitialized != 1) {
         return NULL;
     }
 
     // Locate the module
-    foreach(sNode, GlbModules) {
-        MCoreModule_t *Mod = (MCoreModule_t*)sNode->Data;
-        if (MStringCompare(Module, Mod->Name, 1) == MSTRING_FULL_MATCH) {
+    for (i = 0; i < GlbModuleCount; i++) {
+        MCoreModule_t *Mod = &GlbModules[i];
+        if (Mod->Name != NULL
+            && MStringCompare(Module, Mod->Name, 1) == MSTRING_FULL_MATCH) {
             return Mod;
         }
     }
@@ -98,6 +98,7 @@ PipeConstruct(
     CriticalSectionConstruct(&Pipe->Lock, CRITICALSECTION_PLAIN);
     SemaphoreConstruct(&Pipe->ReadQueue, 0);
     SemaphoreConstruct(&Pipe->WriteQueue, 0);
+    atomic_init(&Pipe->References, 1);
 }
 
 /* PipeDestroy
@@ -114,9 +115,33 @@ PipeDestroy(
     kfree(Pipe);
 }
 
+/* PipeAcquire
+ * Takes a reference on the pipe, a pipe starts out with one
+ * reference that belongs to its creator */
+void
+PipeAcquire(
+    _In_ MCorePipe_t *Pipe)
+{
+    atomic_fetch_add(&Pipe->References, 1);
+}
+
+/* PipeRelease
+ * Drops a reference on the pipe, the pipe is destroyed
+ * when the last reference is dropped */
+void
+PipeRelease(
+    _In_ MCorePipe_t *Pipe)
+{
+    if (atomic_fetch_sub(&Pipe->References, 1) == 1) {
+        PipeDestroy(Pipe);
+    }
+}
+
 /* PipeWrite
  * Writes the given data to the pipe-buffer, unless PIPE_NOBLOCK_WRITE
- * has been specified, it will block untill there is room in the pipe */
+ * has been specified, it will block untill there is room in the pipe.
+ * Writes that fit in the pipe are never split, so they don't interleave
+ * with writes from other threads */
 int
 PipeWrite(
     _In_ MCorePipe_t *Pipe,
@@ -125,20 +150,24 @@ PipeWrite(
 {
     // Variables
     size_t BytesWritten = 0;
+    int Atomic = 0;
 
     // Sanitize parameters
     if (Pipe == NULL || Length == 0 || Data == NULL) {
         return -1;
     }
+    Atomic = (Length < Pipe->Length) ? 1 : 0;
 
     // Write in loop
     while (BytesWritten < Length) {
         // Write while there are bytes left, and space in pipe
         // Locked operation
         CriticalSectionEnter(&Pipe->Lock);
-        while (PipeBytesLeft(Pipe) > 0 && BytesWritten < Length) {
-            Pipe->Buffer[Pipe->IndexWrite] = Data[BytesWritten++];
-            PipeIncreaseWrite(Pipe);
+        if (!Atomic || PipeBytesLeft(Pipe) >= (int)Length) {
+            while (PipeBytesLeft(Pipe) > 0 && BytesWritten < Length) {
+                Pipe->Buffer[Pipe->IndexWrite] = Data[BytesWritten++];
+                PipeIncreaseWrite(Pipe);
+            }
         }
         CriticalSectionLeave(&Pipe->Lock);
 
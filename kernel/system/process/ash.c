@@ -37,6 +37,7 @@
 
 /* Includes
  * - Library */
+#include <stdatomic.h>
 #include <stddef.h>
 
 /* This is the finalizor function for starting
@@ -234,6 +235,38 @@ PhoenixStartupAsh(
     return Ash->Id;
 }
 
+/* PhoenixLookupAshPipe
+ * Looks up the pipe on the given port and takes a reference on it,
+ * ports in the port array are read without the lock, the rest must
+ * hold the ash lock. The reference is dropped with PipeRelease */
+static MCorePipe_t*
+PhoenixLookupAshPipe(
+    _In_ MCoreAsh_t     *Ash,
+    _In_ int             Port)
+{
+    // Variables
+    MCorePipe_t *Pipe = NULL;
+    DataKey_t Key;
+
+    // The lookup is counted until the reference is taken, closing
+    // waits for the count to drain before it drops its reference
+    if (Port < ASH_PIPE_PORTS) {
+        atomic_fetch_add(&Ash->PipeLookups, 1);
+        Pipe = atomic_load(&Ash->PortPipes[Port]);
+        if (Pipe != NULL) {
+            PipeAcquire(Pipe);
+        }
+        atomic_fetch_sub(&Ash->PipeLookups, 1);
+        return Pipe;
+    }
+    Key.Value = Port;
+    Pipe = (MCorePipe_t*)CollectionGetDataByKey(Ash->Pipes, Key, 0);
+    if (Pipe != NULL) {
+        PipeAcquire(Pipe);
+    }
+    return Pipe;
+}
+
 /* PhoenixOpenAshPipe
  * Creates a new communication pipe available for use. */
 OsStatus_t
@@ -255,22 +288,27 @@ PhoenixOpenAshPipe(
         return OsError;
     }
 
-    // Make sure that a pipe on the given Port 
-    // doesn't already exist!
-    Key.Value = Port;
+    // Opening an existing pipe is not an error, servers
+    // find their rpc pipe opened by the kernel
     CriticalSectionEnter(&Ash->Lock);
-    if (CollectionGetDataByKey(Ash->Pipes, Key, 0) != NULL) {
+    Pipe = PhoenixLookupAshPipe(Ash, Port);
+    if (Pipe != NULL) {
         CriticalSectionLeave(&Ash->Lock);
-        WARNING("The requested pipe already exists");
+        PipeRelease(Pipe);
+        TRACE("The requested pipe already exists");
         return OsSuccess;
     }
-    CriticalSectionLeave(&Ash->Lock);
 
-    // Create a new pipe and add it to list
+    // Create a new pipe and publish it, the pipe is
+    // fully constructed before readers can see it
     Pipe = PipeCreate(ASH_PIPE_SIZE, Flags);
-    
-    CriticalSectionEnter(&Ash->Lock);
-    CollectionAppend(Ash->Pipes, CollectionCreateNode(Key, Pipe));
+    if (Port < ASH_PIPE_PORTS) {
+        atomic_store_explicit(&Ash->PortPipes[Port], Pipe, memory_order_release);
+    }
+    else {
+        Key.Value = Port;
+        CollectionAppend(Ash->Pipes, CollectionCreateNode(Key, Pipe));
+    }
     CriticalSectionLeave(&Ash->Lock);
 
     // Wake sleepers waiting for pipe creations
@@ -287,23 +325,21 @@ PhoenixWaitAshPipe(
     _In_ int         Port)
 {
     // Variables
-    DataKey_t Key;
+    MCorePipe_t *Pipe = NULL;
     int Run = 1;
 
     // Sanitize input
-    if (Ash == NULL) {
+    if (Ash == NULL || Port < 0) {
         return OsError;
     }
 
     // Wait for wake-event on pipe
-    Key.Value = Port;
     while (Run) {
-        CriticalSectionEnter(&Ash->Lock);
-        if (CollectionGetDataByKey(Ash->Pipes, Key, 0) != NULL) {
-            CriticalSectionLeave(&Ash->Lock);
+        Pipe = PhoenixGetAshPipe(Ash, Port);
+        if (Pipe != NULL) {
+            PipeRelease(Pipe);
             break;
         }
-        CriticalSectionLeave(&Ash->Lock);
         if (SchedulerThreadSleep((uintptr_t*)Ash->Pipes, 5000) == SCHEDULER_SLEEP_TIMEOUT) {
             ERROR("Failed to wait for open pipe, timeout after 5 seconds.");
             return OsError;
@@ -330,25 +366,36 @@ PhoenixCloseAshPipe(
         return OsSuccess;
     }
 
-    // Lookup pipe
-    Key.Value = Port;
+    // Unpublish the pipe before it's destroyed so
+    // no new lookups can find it
     CriticalSectionEnter(&Ash->Lock);
-    Pipe = (MCorePipe_t*)CollectionGetDataByKey(Ash->Pipes, Key, 0);
+    if (Port < ASH_PIPE_PORTS) {
+        Pipe = atomic_exchange(&Ash->PortPipes[Port], NULL);
+    }
+    else {
+        Key.Value = Port;
+        Pipe = (MCorePipe_t*)CollectionGetDataByKey(Ash->Pipes, Key, 0);
+        CollectionRemoveByKey(Ash->Pipes, Key);
+    }
     CriticalSectionLeave(&Ash->Lock);
     if (Pipe == NULL) {
         return OsError;
     }
 
-    // Cleanup pipe and remove node
-    PipeDestroy(Pipe);
-    CriticalSectionEnter(&Ash->Lock);
-    CollectionRemoveByKey(Ash->Pipes, Key);
-    return CriticalSectionLeave(&Ash->Lock);
+    // Lock-free lookups may have loaded the pipe before it was
+    // unpublished, once they drained every user holds a reference
+    // and the pipe is destroyed when the last one is dropped
+    while (atomic_load(&Ash->PipeLookups) != 0) {
+        ThreadingYield();
+    }
+    PipeRelease(Pipe);
+    return OsSuccess;
 }
 
 /* PhoenixGetAshPipe
  * Retrieves an existing pipe instance for the given ash
- * and port-id. If it doesn't exist, returns NULL. */
+ * and port-id. If it doesn't exist, returns NULL. The caller
+ * owns a reference and must drop it with PipeRelease */
 MCorePipe_t*
 PhoenixGetAshPipe(
     _In_ MCoreAsh_t     *Ash, 
@@ -356,17 +403,19 @@ PhoenixGetAshPipe(
 {
     // Variables
     MCorePipe_t *Pipe = NULL;
-    DataKey_t Key;
 
     // Sanitize input
     if (Ash == NULL || Port < 0) {
         return NULL;
     }
 
-    // Perform the lookup
-    Key.Value = Port;
+    // Perform the lookup, the common ports
+    // never touch the lock
+    if (Port < ASH_PIPE_PORTS) {
+        return PhoenixLookupAshPipe(Ash, Port);
+    }
     CriticalSectionEnter(&Ash->Lock);
-    Pipe = (MCorePipe_t*)CollectionGetDataByKey(Ash->Pipes, Key, 0);
+    Pipe = PhoenixLookupAshPipe(Ash, Port);
     CriticalSectionLeave(&Ash->Lock);
     return Pipe;
 }
@@ -461,6 +510,7 @@ PhoenixCleanupAsh(
 {
     // Variables
     CollectionItem_t *fNode = NULL;
+    int i;
 
     // Strings first
     MStringDestroy(Ash->Name);
@@ -473,8 +523,13 @@ PhoenixCleanupAsh(
     CollectionDestroy(Ash->SignalQueue);
 
     // Cleanup pipes
+    for (i = 0; i < ASH_PIPE_PORTS; i++) {
+        if (Ash->PortPipes[i] != NULL) {
+            PipeRelease(Ash->PortPipes[i]);
+        }
+    }
     _foreach(fNode, Ash->Pipes) {
-        PipeDestroy((MCorePipe_t*)fNode->Data);
+        PipeRelease((MCorePipe_t*)fNode->Data);
     }
     CollectionDestroy(Ash->Pipes);
 
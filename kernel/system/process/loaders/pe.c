@@ -46,7 +46,9 @@ __EXTERN CriticalSection_t LoaderLock;
 /* PeCalculateChecksum
  * Perform a checksum calculation of the 
  * given PE file. Use this to validate contents
- * of a PE executable */
+ * of a PE executable. The words are summed into 64 bits
+ * and the carries are folded back in at the end, which
+ * equals folding them in after every word */
 uint32_t
 PeCalculateChecksum(
     _In_ uint8_t *Data, 
@@ -55,20 +57,27 @@ PeCalculateChecksum(
 {
     // Variables
     uint32_t *DataPtr = (uint32_t*)Data;
-    uint64_t Limit = 4294967296;
-    uint64_t CheckSum = 0;
+    size_t WordCount = DataLength / 4;
+    size_t SkipIndex = PeChkSumOffset / 4;
+    uint64_t CheckSum = 0, CheckSumOdd = 0;
+    size_t i = 0;
 
-    for (size_t i = 0; i < (DataLength / 4); i++, DataPtr++) {
-        uint32_t Val = *DataPtr;
+    // Two accumulators so the additions don't depend on each other
+    for (; i + 1 < WordCount; i += 2) {
+        CheckSum += DataPtr[i];
+        CheckSumOdd += DataPtr[i + 1];
+    }
+    if (i < WordCount) {
+        CheckSum += DataPtr[i];
+    }
+    CheckSum += CheckSumOdd;
 
-        // Skip the checksum index
-        if (i == (PeChkSumOffset / 4)) {
-            continue;
-        }
-        CheckSum = (CheckSum & UINT32_MAX) + Val + (CheckSum >> 32);
-        if (CheckSum > Limit) {
-            CheckSum = (CheckSum & UINT32_MAX) + (CheckSum >> 32);
-        }
+    // Skip the checksum index
+    if (SkipIndex < WordCount) {
+        CheckSum -= DataPtr[SkipIndex];
+    }
+    while (CheckSum >> 32) {
+        CheckSum = (CheckSum & UINT32_MAX) + (CheckSum >> 32);
     }
 
     CheckSum = (CheckSum & UINT16_MAX) + (CheckSum >> 16);
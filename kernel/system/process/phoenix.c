@@ -24,6 +24,7 @@
 
 /* Includes 
  * - System */
+#include <system/interrupts.h>
 #include <system/utils.h>
 #include <process/phoenix.h>
 #include <process/process.h>
@@ -38,6 +39,7 @@
  * C-Library */
 #include <ds/collection.h>
 #include <ds/mstring.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <string.h>
 
@@ -51,12 +53,28 @@ OsStatus_t
 PhoenixReapAsh(
     _In_Opt_ void *UserData);
 
+/* Ash Table
+ * Ashes are indexed by id in a radix tree with 8 bits per level, ids
+ * are handed out sequentially so the tree stays dense. Nodes are never
+ * freed and are published with release stores, so lookups walk the
+ * tree without taking the process lock */
+#define PHOENIX_TABLE_BITS          8
+#define PHOENIX_TABLE_SIZE          (1 << PHOENIX_TABLE_BITS)
+#define PHOENIX_TABLE_MASK          (PHOENIX_TABLE_SIZE - 1)
+#define PHOENIX_TABLE_LEVELS        ((sizeof(UUId_t) * 8) / PHOENIX_TABLE_BITS)
+
+typedef struct _PhoenixTableNode {
+    _Atomic(void*)           Slots[PHOENIX_TABLE_SIZE];
+} PhoenixTableNode_t;
+
 /* Globals 
  * State-keeping and data-storage */
 static MCoreEventHandler_t *EventHandler    = NULL;
 static Collection_t *Processes              = NULL;
+static PhoenixTableNode_t AshTable;
 static CriticalSection_t ProcessLock;
 static UUId_t *AliasMap                     = NULL;
+static Spinlock_t AliasLock;
 static UUId_t GcHandlerId                   = 0;
 static UUId_t ProcessIdGenerator            = 0;
 CriticalSection_t LoaderLock;
@@ -82,6 +100,7 @@ PhoenixInitialize(void)
     CriticalSectionConstruct(&LoaderLock, CRITICALSECTION_REENTRANCY);
 
 	// Initialize the global alias map
+	SpinlockReset(&AliasLock);
 	AliasMap = (UUId_t*)kmalloc(sizeof(UUId_t) * PHOENIX_MAX_ASHES);
 	for (i = 0; i < PHOENIX_MAX_ASHES; i++) {
 		AliasMap[i] = UUID_INVALID;
@@ -119,6 +138,9 @@ PhoenixRegisterAlias(
 	_In_ MCoreAsh_t *Ash, 
 	_In_ UUId_t Alias)
 {
+	// Variables
+	IntStatus_t InterruptStatus;
+
 	// Sanitize both the server and alias 
 	if (Ash == NULL
 		|| (Alias < PHOENIX_ALIAS_BASE)
@@ -129,11 +151,58 @@ PhoenixRegisterAlias(
 		return OsError;
 	}
 
-	// Register
+	// Register and wake services that depend on it, waiters check
+	// the map under the same lock before they go to sleep
+	InterruptStatus = InterruptDisable();
+	SpinlockAcquire(&AliasLock);
 	AliasMap[Alias - PHOENIX_ALIAS_BASE] = Ash->Id;
+	SchedulerThreadWakeAll((uintptr_t*)&AliasMap[Alias - PHOENIX_ALIAS_BASE]);
+	SpinlockRelease(&AliasLock);
+	InterruptRestoreState(InterruptStatus);
+	if (Ash->Type == AshServer) {
+		PhoenixServerTimeline((MCoreServer_t*)Ash, "registered");
+	}
 	return OsSuccess;
 }
 
+/* PhoenixWaitAlias
+ * Waits for a server to register the given alias, this is how services
+ * order themselves after the services they depend on. Returns OsError
+ * if the alias was not registered within the timeout */
+OsStatus_t
+PhoenixWaitAlias(
+    _In_ UUId_t Alias,
+    _In_ size_t Timeout)
+{
+    // Variables
+    IntStatus_t InterruptStatus;
+    OsStatus_t Result = OsSuccess;
+
+    // Sanitize the alias
+    if (Alias < PHOENIX_ALIAS_BASE
+        || Alias >= (PHOENIX_ALIAS_BASE + PHOENIX_MAX_ASHES)) {
+        return OsError;
+    }
+
+    // Wait for wake-event on the alias, the map is checked under the
+    // alias lock which is released only once we are queued for sleep
+    InterruptStatus = InterruptDisable();
+    SpinlockAcquire(&AliasLock);
+    while (AliasMap[Alias - PHOENIX_ALIAS_BASE] == UUID_INVALID) {
+        if (SchedulerAtomicThreadSleep((uintptr_t*)&AliasMap[Alias - PHOENIX_ALIAS_BASE], 
+                Timeout, &AliasLock) == SCHEDULER_SLEEP_TIMEOUT) {
+            Result = OsError;
+            break;
+        }
+        SpinlockAcquire(&AliasLock);
+    }
+    if (Result == OsSuccess) {
+        SpinlockRelease(&AliasLock);
+    }
+    InterruptRestoreState(InterruptStatus);
+    return Result;
+}
+
 /* PhoenixUpdateAlias
  * Checks if the given process-id has an registered alias.
  * If it has, the given process-id will be overwritten. */
@@ -157,6 +226,65 @@ PhoenixGetNextId(void)
     return ProcessIdGenerator++;
 }
 
+/* PhoenixTableLookup (@interrupt_context)
+ * Walks the ash table for the given id without locking, returns
+ * NULL if the id is not registered */
+static MCoreAsh_t*
+PhoenixTableLookup(
+    _In_ UUId_t AshId)
+{
+    // Variables
+    PhoenixTableNode_t *Node = &AshTable;
+    int Level;
+
+    for (Level = PHOENIX_TABLE_LEVELS - 1; Level > 0 && Node != NULL; Level--) {
+        Node = (PhoenixTableNode_t*)atomic_load_explicit(
+            &Node->Slots[(AshId >> (Level * PHOENIX_TABLE_BITS)) & PHOENIX_TABLE_MASK], 
+            memory_order_acquire);
+    }
+    if (Node == NULL) {
+        return NULL;
+    }
+    return (MCoreAsh_t*)atomic_load_explicit(
+        &Node->Slots[AshId & PHOENIX_TABLE_MASK], memory_order_acquire);
+}
+
+/* PhoenixTableUpdate
+ * Stores the ash for the given id in the ash table, creating
+ * missing nodes on the way. Must be called with the process lock held.
+ * Returns OsError if a node could not be allocated */
+static OsStatus_t
+PhoenixTableUpdate(
+    _In_ UUId_t      AshId,
+    _In_ MCoreAsh_t *Ash)
+{
+    // Variables
+    PhoenixTableNode_t *Node = &AshTable;
+    PhoenixTableNode_t *Next = NULL;
+    int Level, i;
+
+    for (Level = PHOENIX_TABLE_LEVELS - 1; Level > 0; Level--) {
+        _Atomic(void*) *Slot = &Node->Slots[(AshId >> (Level * PHOENIX_TABLE_BITS)) & PHOENIX_TABLE_MASK];
+        Next = (PhoenixTableNode_t*)atomic_load_explicit(Slot, memory_order_relaxed);
+        if (Next == NULL) {
+            if (Ash == NULL) {
+                return OsSuccess;
+            }
+            Next = (PhoenixTableNode_t*)kmalloc(sizeof(PhoenixTableNode_t));
+            if (Next == NULL) {
+                return OsError;
+            }
+            for (i = 0; i < PHOENIX_TABLE_SIZE; i++) {
+                atomic_init(&Next->Slots[i], NULL);
+            }
+            atomic_store_explicit(Slot, Next, memory_order_release);
+        }
+        Node = Next;
+    }
+    atomic_store_explicit(&Node->Slots[AshId & PHOENIX_TABLE_MASK], Ash, memory_order_release);
+    return OsSuccess;
+}
+
 /* PhoenixGetAsh (@interrupt_context)
  * This function looks up a ash structure by the given id */
 MCoreAsh_t*
@@ -164,8 +292,6 @@ PhoenixGetAsh(
     _In_ UUId_t AshId)
 {
     // Variables
-    CollectionItem_t *Node  = NULL;
-    MCoreAsh_t *Result      = NULL;
     UUId_t CurrentCpu       = UUID_INVALID;
 
     // If we pass invalid get the current
@@ -187,19 +313,8 @@ PhoenixGetAsh(
     // Now we can sanitize the extra stuff, like alias
     PhoenixUpdateAlias(&AshId);
 
-    // Iterate the list for ash-id
-    CriticalSectionEnter(&ProcessLock);
-    _foreach(Node, Processes) {
-        MCoreAsh_t *Ash = (MCoreAsh_t*)Node->Data;
-        if (Ash->Id == AshId) {
-            Result = Ash;
-            break;
-        }
-    }
-    CriticalSectionLeave(&ProcessLock);
-
-    // We didn't find it
-    return Result;
+    // Lookup the table, this takes no locks
+    return PhoenixTableLookup(AshId);
 }
 
 /* GetServerByDriver
@@ -248,14 +363,18 @@ PhoenixRegisterAsh(
     _In_ MCoreAsh_t *Ash)
 {
     // Variables
+    OsStatus_t Result;
     DataKey_t Key;
     
 	// Modifications to process-list are locked
 	Key.Value = (int)Ash->Id;
     CriticalSectionEnter(&ProcessLock);
-	CollectionAppend(Processes, CollectionCreateNode(Key, Ash));
+    Result = PhoenixTableUpdate(Ash->Id, Ash);
+    if (Result == OsSuccess) {
+	    CollectionAppend(Processes, CollectionCreateNode(Key, Ash));
+    }
     CriticalSectionLeave(&ProcessLock);
-    return OsSuccess;
+    return Result;
 }
 
 /* PhoenixTerminateAsh
@@ -272,11 +391,12 @@ PhoenixTerminateAsh(
     Key.Value = (int)Ash->Id;
     CriticalSectionEnter(&ProcessLock);
 	CollectionRemoveByKey(Processes, Key);
+    PhoenixTableUpdate(Ash->Id, NULL);
     CriticalSectionLeave(&ProcessLock);
 
 	// Alert GC
 	SchedulerThreadWakeAll((uintptr_t*)Ash);
-	GcSignal(GcHandlerId, Ash);
+	GcSignal(GcHandlerId, &Ash->GcEvent, Ash);
 }
 
 /* PhoenixReapAsh
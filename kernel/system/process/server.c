@@ -28,15 +28,55 @@
 #include <threading.h>
 #include <semaphore.h>
 #include <scheduler.h>
+#include <timers.h>
 #include <heap.h>
 #include <log.h>
 
 /* Includes
 * - Library */
+#include <os/ipc/ipc.h>
 #include <ds/mstring.h>
 #include <stddef.h>
 #include <string.h>
 
+/* PhoenixServerTimeline
+ * Logs a startup stage of the server to the boot timeline with the
+ * time since boot and the time since the server was created */
+void
+PhoenixServerTimeline(
+    _In_ MCoreServer_t  *Server,
+    _In_ __CONST char   *Stage)
+{
+    // Variables
+    uint64_t Timestamp = 0;
+
+    // Timestamps are in timer units, there are
+    // NSEC_PER_MSEC units to a millisecond
+    if (TimersGetTimestamp(&Timestamp) != OsSuccess) {
+        return;
+    }
+    LogInformation("BOOT", "%s %s at %u ms, %u ms after creation",
+        MStringRaw(Server->Base.Name), Stage,
+        (size_t)(Timestamp / NSEC_PER_MSEC),
+        (size_t)((Timestamp - Server->CreatedAt) / NSEC_PER_MSEC));
+}
+
+/* PhoenixServerStartupEntry (Private)
+ * The loader of a server, loads the image on the new thread so
+ * servers load concurrently on whichever cpu picked them up */
+void
+PhoenixServerStartupEntry(
+    _In_ void *BasePointer)
+{
+    // Variables
+    MCoreServer_t *Server = (MCoreServer_t*)BasePointer;
+
+    // Finish boot-process and go to usermode
+    PhoenixFinishAsh(&Server->Base);
+    PhoenixServerTimeline(Server, "loaded");
+    ThreadingEnterUserMode(&Server->Base);
+}
+
 /* PhoenixCreateServer
  * This function loads the executable and
  * prepares the ash-server-environment, at this point
@@ -47,8 +87,10 @@ PhoenixCreateServer(
 {
 	// Variables
 	MCoreServer_t *Server = NULL;
+	uint64_t CreatedAt = 0;
 
 	// Allocate and initiate new instance
+	TimersGetTimestamp(&CreatedAt);
 	Server = (MCoreServer_t*)kmalloc(sizeof(MCoreServer_t));
 	if (PhoenixInitializeAsh(&Server->Base, Path) != OsSuccess) {
 		LogFatal("SERV", "Failed to spawn server %s", MStringRaw(Path));
@@ -59,6 +101,16 @@ PhoenixCreateServer(
 	// Initialize the server io-space memory
 	Server->DriverMemory = BlockBitmapCreate(MEMORY_LOCATION_RING3_IOSPACE,
 		MEMORY_LOCATION_RING3_IOSPACE_END, PAGE_SIZE);
+	Server->VendorId = 0;
+	Server->DeviceId = 0;
+	Server->DeviceClass = 0;
+	Server->DeviceSubClass = 0;
+	Server->CreatedAt = CreatedAt;
+
+	// Open the rpc pipe up front, requests can then be queued
+	// for the server while it's still loading, the server's own
+	// open of the pipe finds it and succeeds
+	PhoenixOpenAshPipe(&Server->Base, PIPE_RPCOUT, 0);
 
 	// Register ash
 	Server->Base.Type = AshServer;
@@ -66,7 +118,7 @@ PhoenixCreateServer(
 
     // Create the loader
 	ThreadingCreateThread(MStringRaw(Server->Base.Name),
-		PhoenixStartupEntry, Server, THREADING_DRIVERMODE);
+		PhoenixServerStartupEntry, Server, THREADING_DRIVERMODE);
 	return Server->Base.Id;
 }
 
@@ -978,9 +978,11 @@ ScPipeRead(
     MCorePipe_t *Pipe = NULL;
     int BytesRead = 0;
 
-    // Lookup the pipe for the given port
+    // Lookup the pipe for the given port, a reference
+    // is held on the pipe while it's in use
     if (Port == -1) {
         Pipe = ThreadingGetCurrentThread(CpuGetCurrentId())->Pipe;
+        PipeAcquire(Pipe);
     }
     else {
         Pipe = PhoenixGetAshPipe(PhoenixGetCurrentAsh(), Port);
@@ -994,11 +996,13 @@ ScPipeRead(
 
     // Sanitize parameters
     if (Length == 0) {
+        PipeRelease(Pipe);
         return OsSuccess;
     }
 
     // Debug
     BytesRead = PipeRead(Pipe, Container, Length, Peek);
+    PipeRelease(Pipe);
     return (BytesRead > 0) ? OsSuccess : OsError;
 }
 
@@ -1016,6 +1020,7 @@ ScPipeWrite(
 {
     // Variables
     MCorePipe_t *Pipe = NULL;
+    MRemoteCallReply_t *Reply = NULL;
     int BytesWritten = 0;
 
     // Sanitize parameters
@@ -1023,9 +1028,14 @@ ScPipeWrite(
         return OsError;
     }
 
-    // Lookup the pipe for the given port
+    // Lookup the pipe for the given port, a reference
+    // is held on the pipe while it's in use
     if (Port == -1 && ThreadingGetThread(AshId) != NULL) {
         Pipe = ThreadingGetThread(AshId)->Pipe;
+        PipeAcquire(Pipe);
+    }
+    else if (Port != -1 && (Port & PIPE_ASYNC_FLAG)) {
+        Pipe = PhoenixGetAshPipe(PhoenixGetAsh(AshId), PIPE_ASYNC_GETPORT(Port));
     }
     else {
         Pipe = PhoenixGetAshPipe(PhoenixGetAsh(AshId), Port);
@@ -1035,9 +1045,26 @@ ScPipeWrite(
     if (Pipe == NULL) {
         return OsError;
     }
-    
-    // Debug
-    BytesWritten = PipeWrite(Pipe, Message, Length);
+
+    // Replies to asynchronous requests are framed with the request id,
+    // the frame is written in one go so replies from concurrent
+    // writers never interleave
+    if (Port != -1 && (Port & PIPE_ASYNC_FLAG)) {
+        Reply = (MRemoteCallReply_t*)kmalloc(sizeof(MRemoteCallReply_t) + Length);
+        if (Reply == NULL) {
+            PipeRelease(Pipe);
+            return OsOutOfMemory;
+        }
+        Reply->RequestId = PIPE_ASYNC_GETID(Port);
+        Reply->Length = Length;
+        memcpy((void*)(Reply + 1), Message, Length);
+        BytesWritten = PipeWrite(Pipe, (uint8_t*)Reply, sizeof(MRemoteCallReply_t) + Length);
+        kfree(Reply);
+    }
+    else {
+        BytesWritten = PipeWrite(Pipe, Message, Length);
+    }
+    PipeRelease(Pipe);
     return (BytesWritten > 0) ? OsSuccess : OsError;
 }
 
@@ -1101,6 +1128,7 @@ ScRpcResponse(
     // Use the builtin thread pipe
     if (Rpc->Sender == UUID_INVALID) {
         Pipe = ThreadingGetCurrentThread(CpuGetCurrentId())->Pipe;
+        PipeAcquire(Pipe);
     }
     else {
         // Resolve the current running process
@@ -1112,10 +1140,14 @@ ScRpcResponse(
         if (Ash == NULL || Pipe == NULL) {
             ERROR("Process lookup failed for process 0x%x:%i", 
                 ThreadingGetCurrentThread(CpuGetCurrentId())->AshId, Rpc->ResponsePort);
+            if (Pipe != NULL) {
+                PipeRelease(Pipe);
+            }
             return OsError;
         }
         else if (Rpc->Result.Type == ARGUMENT_NOTUSED) {
             ERROR("No result expected but used result-executer.");
+            PipeRelease(Pipe);
             return OsError;
         }
     }
@@ -1128,6 +1160,7 @@ ScRpcResponse(
 
     // Read the data into the response-buffer
     PipeRead(Pipe, (uint8_t*)Rpc->Result.Data.Buffer, ToRead, 0);
+    PipeRelease(Pipe);
     return OsSuccess;
 }
 
@@ -1172,6 +1205,7 @@ ScRpcExecute(
                 Rpc->Arguments[i].Length);
         }
     }
+    PipeRelease(Pipe);
 
     // Async request? Because if yes, don't
     // wait for response
@@ -1431,11 +1465,23 @@ ScLoadDriver(
     RPCInitialize(&RemoteCall, 1, PIPE_RPCOUT, __DRIVER_REGISTERINSTANCE);
     RPCSetArgument(&RemoteCall, 0, Device, Length);
 
-    // Make sure the server has opened it's comm-pipe
-    PhoenixWaitAshPipe(&Server->Base, PIPE_RPCOUT);
+    // The comm-pipe is opened when the server is created, so the
+    // instance is queued without waiting for the driver to load. The
+    // next driver is spawned while this one is still loading
     return ScRpcExecute(&RemoteCall, Server->Base.Id, 1);
 }
 
+/* ScWaitForService
+ * Waits for the service with the given alias to register, services
+ * use it to declare the services they depend on */
+OsStatus_t
+ScWaitForService(
+    _In_ UUId_t Alias,
+    _In_ size_t Timeout)
+{
+    return PhoenixWaitAlias(Alias, Timeout);
+}
+
 /* ScRegisterInterrupt 
  * Allocates the given interrupt source for use by
  * the requesting driver, an id for the interrupt source
@@ -1671,7 +1717,7 @@ uintptr_t GlbSyscallTable[91] = {
      * - Support */
     DefineSyscall(ScRegisterAliasId),
     DefineSyscall(ScLoadDriver),
-    DefineSyscall(NoOperation),
+    DefineSyscall(ScWaitForService),
     DefineSyscall(NoOperation),
     DefineSyscall(NoOperation),
     DefineSyscall(NoOperation),
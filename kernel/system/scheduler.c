@@ -35,14 +35,16 @@
 #include <system/interrupts.h>
 #include <system/utils.h>
 #include <scheduler.h>
+#include <timers.h>
 #include <debug.h>
 #include <heap.h>
 #include <assert.h>
 
 /* Globals
- * - State keeping variables */
-static Scheduler_t *Schedulers[MAX_SUPPORTED_CPUS];
+ * - State keeping variables, the per-cpu
+ *   schedulers are kept in the cpu blocks */
 static SchedulerQueue_t IoQueue = { 0 };
+static Spinlock_t IoQueueLock;
 static int SchedulerInitialized = 0;
 
 /* SchedulerInitialize
@@ -51,9 +53,9 @@ void
 SchedulerInitialize(void)
 {
     // Initialize Globals
-    memset(&Schedulers[0], 0, sizeof(Schedulers));
     IoQueue.Head = NULL;
     IoQueue.Tail = NULL;
+    SpinlockReset(&IoQueueLock);
     SchedulerInitialized = 1;
 }
 
@@ -72,7 +74,22 @@ SchedulerCreate(
     
     // Initialize members
 	CriticalSectionConstruct(&Scheduler->QueueLock, CRITICALSECTION_PLAIN);
-	Schedulers[Cpu] = Scheduler;
+	CpuGetCore(Cpu)->Scheduler = Scheduler;
+}
+
+/* SchedulerGetCpu
+ * Retrieves the scheduler of the given cpu, returns NULL
+ * if the cpu has not been brought up yet */
+Scheduler_t*
+SchedulerGetCpu(
+    _In_ UUId_t Cpu)
+{
+	// Variables
+	CpuCore_t *Core = CpuGetCore(Cpu);
+	if (Core == NULL) {
+		return NULL;
+	}
+	return Core->Scheduler;
 }
 
 /* SchedulerQueueAppend 
@@ -221,8 +238,8 @@ SchedulerThreadQueue(
     
 	// Sanitize the cpu that thread needs to be bound to
 	if (Thread->CpuId == SCHEDULER_CPU_SELECT) {
-		while (Schedulers[i] != NULL) {
-			if (Schedulers[i]->ThreadCount < Schedulers[CpuIndex]->ThreadCount) {
+		while (SchedulerGetCpu(i) != NULL) {
+			if (SchedulerGetCpu(i)->ThreadCount < SchedulerGetCpu(CpuIndex)->ThreadCount) {
 				CpuIndex = i;
 			}
 			i++;
@@ -234,7 +251,7 @@ SchedulerThreadQueue(
     }
 
     // Shorthand access
-    Scheduler = Schedulers[CpuIndex];
+    Scheduler = SchedulerGetCpu(CpuIndex);
 
     // Debug
     TRACE("Appending thread %u to queue %i", Thread->Id, Thread->Queue);
@@ -275,7 +292,7 @@ SchedulerThreadDequeue(
         Thread->CpuId, Thread->Id, Thread->Queue);
 
     // Instantiate variables
-    Scheduler = Schedulers[Thread->CpuId];
+    Scheduler = SchedulerGetCpu(Thread->CpuId);
 
 	// Locked operation
     CriticalSectionEnter(&Scheduler->QueueLock);
@@ -288,6 +305,45 @@ SchedulerThreadDequeue(
     return OsSuccess;
 }
 
+/* SchedulerThreadTimeout
+ * Expire handler for sleep timers, wakes the thread if it's still
+ * in the sleep the timer was queued for and marks it as timed out. */
+void
+SchedulerThreadTimeout(
+    _In_ MCoreTimer_t *Timer,
+    _In_ size_t Generation)
+{
+	// Variables
+	MCoreThread_t *Thread   = (MCoreThread_t*)Timer->Data;
+	MCoreThread_t *Current  = NULL;
+    IntStatus_t InterruptStatus;
+
+    // The thread might have been woken while the timer expired, and
+    // might even have gone to sleep again, so match the generation
+    InterruptStatus = InterruptDisable();
+    SpinlockAcquire(&IoQueueLock);
+    if (Thread->Sleep.Generation == Generation) {
+        Current = IoQueue.Head;
+        while (Current != NULL && Current != Thread) {
+            Current = Current->Link;
+        }
+    }
+    if (Current == NULL) {
+        SpinlockRelease(&IoQueueLock);
+        InterruptRestoreState(InterruptStatus);
+        return;
+    }
+
+    TRACE("SchedulerThreadTimeout(%u)", Thread->Id);
+    if (Thread->Sleep.Handle != NULL) {
+        Thread->Sleep.Timeout = 1;
+    }
+    SchedulerQueueRemove(&IoQueue, Thread);
+    SpinlockRelease(&IoQueueLock);
+    SchedulerThreadQueue(Thread);
+    InterruptRestoreState(InterruptStatus);
+}
+
 /* SchedulerThreadSleep
  * Enters the current thread into sleep-queue. Can return different
  * sleep-state results. SCHEDULER_SLEEP_OK or SCHEDULER_SLEEP_TIMEOUT. */
@@ -295,6 +351,19 @@ int
 SchedulerThreadSleep(
     _In_ uintptr_t *Handle,
     _In_ size_t Timeout)
+{
+    return SchedulerAtomicThreadSleep(Handle, Timeout, NULL);
+}
+
+/* SchedulerAtomicThreadSleep
+ * Enters the current thread into sleep-queue and releases the given lock
+ * once the thread is queued, so a waker holding the lock can't miss it.
+ * The lock must be acquired by the caller with interrupts disabled. */
+int
+SchedulerAtomicThreadSleep(
+    _In_ uintptr_t *Handle,
+    _In_ size_t Timeout,
+    _In_Opt_ Spinlock_t *Lock)
 {
     // Variables
 	MCoreThread_t *CurrentThread    = NULL;
@@ -314,13 +383,26 @@ SchedulerThreadSleep(
     SchedulerThreadDequeue(CurrentThread);
     CurrentThread->Flags |= THREADING_TRANSITION_SLEEP;
 
-    // Update sleep-information
-    CurrentThread->Sleep.TimeLeft = Timeout;
+    // Update sleep-information, each sleep gets a new generation
+    // so a timeout left over from an earlier sleep is ignored
+    SpinlockAcquire(&IoQueueLock);
     CurrentThread->Sleep.Timeout = 0;
     CurrentThread->Sleep.Handle = Handle;
+    CurrentThread->Sleep.Generation++;
 
-    // Add to io-queue
+    // Add to io-queue, the timeout is queued with the
+    // other timers and wakes us at the deadline
     SchedulerQueueAppend(&IoQueue, CurrentThread, CurrentThread);
+    if (Timeout != SCHEDULER_TIMEOUT_INFINITE) {
+        CurrentThread->Sleep.Timer.Data = CurrentThread;
+        CurrentThread->Sleep.Timer.Expire = SchedulerThreadTimeout;
+        CurrentThread->Sleep.Timer.Generation = CurrentThread->Sleep.Generation;
+        TimersQueue(&CurrentThread->Sleep.Timer, Timeout * NSEC_PER_MSEC);
+    }
+    SpinlockRelease(&IoQueueLock);
+    if (Lock != NULL) {
+        SpinlockRelease(Lock);
+    }
     InterruptRestoreState(InterruptStatus);
     ThreadingYield();
 
@@ -341,6 +423,8 @@ SchedulerThreadWake(
 {
 	// Variables
 	MCoreThread_t *Current = NULL;
+    IntStatus_t InterruptStatus;
+    OsStatus_t Result = OsError;
 
 	// Sanitize the io-queue
 	if (IoQueue.Head == NULL || Handle == NULL) {
@@ -348,6 +432,8 @@ SchedulerThreadWake(
     }
 
     // Iterate the queue
+    InterruptStatus = InterruptDisable();
+    SpinlockAcquire(&IoQueueLock);
     Current = IoQueue.Head;
     while (Current) {
         if (Current->Sleep.Handle == Handle) {
@@ -358,17 +444,21 @@ SchedulerThreadWake(
         }
     }
 
-	// If found, remove from queue and queue
+	// If found, remove from queue and queue, a timeout that is
+    // expiring right now is ignored as the thread left the queue
 	if (Current != NULL) {
+        TimersCancel(&Current->Sleep.Timer);
         Current->Sleep.Timeout = 0;
         Current->Sleep.Handle = NULL;
-        Current->Sleep.TimeLeft = 0;
         SchedulerQueueRemove(&IoQueue, Current);
-		return SchedulerThreadQueue(Current);
+        SpinlockRelease(&IoQueueLock);
+		Result = SchedulerThreadQueue(Current);
 	}
 	else {
-        return OsError;
+        SpinlockRelease(&IoQueueLock);
     }
+    InterruptRestoreState(InterruptStatus);
+    return Result;
 }
 
 /* SchedulerThreadWakeAll
@@ -384,48 +474,6 @@ SchedulerThreadWakeAll(
 	}
 }
 
-/* SchedulerTick
- * Iterates the io-queue and handle any threads that will timeout
- * on the tick. */
-void
-SchedulerTick(
-    _In_ size_t Milliseconds)
-{
-	// Variables
-	MCoreThread_t *Current = NULL;
-
-	// Sanitize the io-queue
-	if (IoQueue.Head == NULL) {
-        return;
-    }
-
-    // Debug
-    TRACE("SchedulerTick()");
-
-    // Iterate the queue
-    Current = IoQueue.Head;
-    while (Current) {
-        if (Current->Sleep.TimeLeft != 0) {
-            Current->Sleep.TimeLeft -= MIN(Milliseconds, Current->Sleep.TimeLeft);
-            if (Current->Sleep.TimeLeft == 0) {
-                MCoreThread_t *Next = Current->Link;
-                if (Current->Sleep.Handle != NULL) {
-                    Current->Sleep.Timeout = 1;
-                }
-                SchedulerQueueRemove(&IoQueue, Current);
-                SchedulerThreadQueue(Current);
-                Current = Next;
-            }
-            else {
-                Current = Current->Link;
-            }
-        }
-        else {
-            Current = Current->Link;
-        }
-    }
-}
-
 /* SchedulerThreadSchedule 
  * This should be called by the underlying archteicture code
  * to get the next thread that is to be run. */
@@ -442,8 +490,8 @@ SchedulerThreadSchedule(
 	int i                       = 0;
 
 	// Sanitize the scheduler status
-    if (SchedulerInitialized != 1 
-        || Schedulers[Cpu] == NULL) {
+    Scheduler = SchedulerGetCpu(Cpu);
+    if (SchedulerInitialized != 1 || Scheduler == NULL) {
         return Thread;
     }
 
@@ -451,9 +499,6 @@ SchedulerThreadSchedule(
     TRACE("SchedulerThreadSchedule(Cpu %u, Thread 0x%x, Preemptive %i)", 
         Cpu, Thread, Preemptive);
 
-    // Instantiate pointers
-    Scheduler = Schedulers[Cpu];
-
 	// Handle the scheduled thread first
 	if (Thread != NULL) {
 		TimeSlice = Thread->TimeSlice;
@@ -49,31 +49,15 @@
 OsStatus_t ThreadingReap(void *UserData);
 
 /* Globals, we need a few variables to
- * keep track of running threads, idle threads
- * and a thread resources lock */
+ * keep track of all threads and a thread resources lock,
+ * the running and idle threads are kept in the cpu blocks */
 static CriticalSection_t ThreadGlobalLock;
-static CollectionItem_t *GlbCurrentThreads[MAX_SUPPORTED_CPUS];
-static CollectionItem_t *GlbIdleThreads[MAX_SUPPORTED_CPUS];
 
 static UUId_t GlbThreadGcId         = 0;
 static UUId_t GlbThreadId           = 1;
 static Collection_t *GlbThreads     = NULL;
 static int GlbThreadingEnabled      = 0;
 
-/* ThreadingGetCurrentNode
- * Helper function, retrieves the current 
- * list-node in our list of threads */
-CollectionItem_t *ThreadingGetCurrentNode(UUId_t Cpu) {
-	return GlbCurrentThreads[Cpu];
-}
-
-/* ThreadingUpdateCurrent
- * Helper function, updates the current
- * list-node in our list of current threads */
-void ThreadingUpdateCurrent(UUId_t Cpu, CollectionItem_t *Node) {
-	GlbCurrentThreads[Cpu] = Node;
-}
-
 /* ThreadingEntryPoint
  * Initializes and handles finish of the thread
  * all threads should use this entry point. No Return */
@@ -148,10 +132,12 @@ ThreadingInitialize(
 {
 	// Variables
 	MCoreThread_t *Init         = NULL;
-	CollectionItem_t *Node      = NULL;
-	int Itr                     = 0;
+	CpuCore_t *Core             = CpuGetCore(Cpu);
 	DataKey_t Key;
 
+	// The cpu block must have been installed by the sub-layer
+	assert(Core != NULL);
+
 	// Sanitize the global, do we need to
 	// initialize the entire threading?
 	if (GlbThreadingEnabled != 1) {
@@ -159,12 +145,6 @@ ThreadingInitialize(
 		GlbThreadGcId = GcRegister(ThreadingReap);
 		GlbThreadId = 1;
         CriticalSectionConstruct(&ThreadGlobalLock, CRITICALSECTION_PLAIN);
-
-		// Zero all current threads out, together with idle
-		for (Itr = 0; Itr < MAX_SUPPORTED_CPUS; Itr++) {
-			GlbCurrentThreads[Itr] = NULL;
-			GlbIdleThreads[Itr] = NULL;
-		}
 		GlbThreadingEnabled = 1;
     }
     
@@ -194,13 +174,13 @@ ThreadingInitialize(
 
 	// Acquire lock to modify the list
 	Key.Value = (int)Init->Id;
-	Node = CollectionCreateNode(Key, Init);
-
 	CriticalSectionEnter(&ThreadGlobalLock);
-	GlbCurrentThreads[Cpu] = Node;
-	GlbIdleThreads[Cpu] = Node;
-	CollectionAppend(GlbThreads, Node);
+	CollectionAppend(GlbThreads, CollectionCreateNode(Key, Init));
 	CriticalSectionLeave(&ThreadGlobalLock);
+
+	// The idle thread is the running thread of the cpu
+	Core->IdleThread = Init;
+	Core->CurrentThread = Init;
 }
 
 /* ThreadingCreateThread
@@ -332,13 +312,14 @@ ThreadingCleanupThread(
     // Make sure we are completely removed as reference
     // from the entire system
     SchedulerThreadDequeue(Thread);
+    TimersCancel(&Thread->Sleep.Timer);
 
 	// Cleanup resources allocated by sub-systems
 	AddressSpaceDestroy(Thread->AddressSpace);
 	IThreadDestroy(Thread);
 
 	// Cleanup our allocated resources
-	PipeDestroy(Thread->Pipe);
+	PipeRelease(Thread->Pipe);
 	kfree((void*)Thread->Name);
 	kfree(Thread);
 }
@@ -466,12 +447,14 @@ MCoreThread_t*
 ThreadingGetCurrentThread(
     _In_ UUId_t Cpu)
 {
+	// Variables
+	CpuCore_t *Core = CpuGetCore(Cpu);
+
 	// Sanitize data first
-	if (GlbThreadingEnabled != 1
-		|| GlbCurrentThreads[Cpu] == NULL) {
+	if (GlbThreadingEnabled != 1 || Core == NULL) {
 		return NULL;
 	}
-	return (MCoreThread_t*)GlbCurrentThreads[Cpu]->Data;
+	return Core->CurrentThread;
 }
 
 /* ThreadingGetCurrentThreadId
@@ -481,20 +464,14 @@ UUId_t ThreadingGetCurrentThreadId(void)
 {
 	/* Get current cpu */
 	UUId_t Cpu = CpuGetCurrentId();
+	MCoreThread_t *Current = ThreadingGetCurrentThread(Cpu);
 
 	/* If it's during startup phase for cpu's
 	 * we have to take precautions */
-	if (GlbCurrentThreads[Cpu] == NULL) {
+	if (Current == NULL) {
 		return (UUId_t)Cpu;
 	}
-
-	/* Sanitize the threading status */
-	if (GlbThreadingEnabled != 1) {
-		return 0;
-	}
-	else {
-		return ThreadingGetCurrentThread(Cpu)->Id;
-	}
+	return Current->Id;
 }
 
 /* ThreadingGetThread
@@ -610,11 +587,10 @@ ThreadingSwitch(
 {
 	// Variables
 	MCoreThread_t *NextThread   = NULL;
-	CollectionItem_t *Node      = NULL;
-    DataKey_t Key;
+	CpuCore_t *Core             = CpuGetCore(Cpu);
 
     // Sanitize current thread
-    assert(Current != NULL);
+    assert(Current != NULL && Core != NULL);
     
 	// Unless this one is done..
 GetNextThread:
@@ -629,7 +605,7 @@ GetNextThread:
 		// If the thread is finished then add it to 
 		// garbagecollector
 		if (Current->Flags & THREADING_FINISHED) {
-			GcSignal(GlbThreadGcId, Current);
+			GcSignal(GlbThreadGcId, &Current->GcEvent, Current);
 		}
         
         // Don't schedule the current
@@ -641,7 +617,7 @@ GetNextThread:
 
 	// Sanitize if we need to active our idle thread
 	if (NextThread == NULL) {
-        NextThread = (MCoreThread_t*)GlbIdleThreads[Cpu]->Data;
+        NextThread = Core->IdleThread;
     }
 
 	// More sanity 
@@ -652,12 +628,7 @@ GetNextThread:
 		goto GetNextThread;
 	}
 
-	// Get node by thread
-	Key.Value = (int)NextThread->Id;
-    Node = CollectionGetNodeByKey(GlbThreads, Key, 0);
-    assert(Node != NULL);
-
 	// Update current thread and return it
-	ThreadingUpdateCurrent(Cpu, Node);
+	Core->CurrentThread = NextThread;
 	return NextThread;
 }
@@ -38,12 +38,21 @@
 #include <stdlib.h>
 #include <stddef.h>
 
+/* Timer Definitions
+ * The system timer is armed for at most the idle interval when the
+ * queue is empty, this keeps the timestamp extension of 32 bit
+ * performance counters from missing a wrap. */
+#define TIMERS_UNITS_PER_SEC            (NSEC_PER_MSEC * MSEC_PER_SEC)
+#define TIMERS_IDLE_INTERVAL            (NSEC_PER_MSEC * MSEC_PER_SEC)
+
 /* Globals */
 static MCoreTimePerformanceOps_t PerformanceTimer;
 static MCoreSystemTimer_t *GlbActiveSystemTimer = NULL;
 static Collection_t *GlbSystemTimers            = NULL;
-static Collection_t *GlbTimers                  = NULL;
-static CriticalSection_t TimerLock;
+static MCoreTimer_t *GlbTimerQueue              = NULL;
+static MCoreTimer_t *GlbTimerExpiring           = NULL;
+static Spinlock_t TimerLock;
+static uint64_t GlbPerformanceFrequency         = 0;
 static UUId_t GlbTimerIds                       = 0;
 static int GlbTimersInitialized                 = 0;
 
@@ -58,12 +67,133 @@ TimersInitialize(void)
     memset(&PerformanceTimer, 0, sizeof(MCoreTimePerformanceOps_t));
 	GlbActiveSystemTimer = NULL;
 	GlbSystemTimers = CollectionCreate(KeyInteger);
-	GlbTimers = CollectionCreate(KeyInteger);
-    CriticalSectionConstruct(&TimerLock, CRITICALSECTION_PLAIN);
+	GlbTimerQueue = NULL;
+    SpinlockReset(&TimerLock);
 	GlbTimersInitialized = 1;
 	GlbTimerIds = 0;
 }
 
+/* TimersArmSystemTimer
+ * Arms the active system timer for the deadline at the head of the queue.
+ * Fixed-rate timers are left alone. The timer lock must be held. */
+void
+TimersArmSystemTimer(void)
+{
+    // Variables
+    size_t Interval = TIMERS_IDLE_INTERVAL;
+    uint64_t Now = 0;
+
+    // Only one-shot sources need to be armed
+    if (GlbActiveSystemTimer == NULL || GlbActiveSystemTimer->Arm == NULL) {
+        return;
+    }
+
+    // Read the clock again, the caller may have spent a while since it
+    // last did and the interval must be measured from when we program
+    TimersGetTimestamp(&Now);
+    if (GlbTimerQueue != NULL) {
+        if (GlbTimerQueue->Deadline <= Now) {
+            Interval = GlbActiveSystemTimer->Tick;
+        }
+        else if ((GlbTimerQueue->Deadline - Now) < TIMERS_IDLE_INTERVAL) {
+            Interval = (size_t)(GlbTimerQueue->Deadline - Now);
+        }
+    }
+    GlbActiveSystemTimer->Arm(Interval);
+}
+
+/* TimersInsert
+ * Inserts the timer into the deadline-sorted queue, timers with equal
+ * deadlines expire in the order they were queued. The timer lock must be held.
+ * Returns 1 if the timer became the next to expire. */
+int
+TimersInsert(
+    _In_ MCoreTimer_t *Timer)
+{
+    // Variables
+    MCoreTimer_t **Link = &GlbTimerQueue;
+
+    // Find the first timer that expires later
+    while (*Link != NULL && (*Link)->Deadline <= Timer->Deadline) {
+        Link = &(*Link)->Link;
+    }
+    Timer->Link = *Link;
+    Timer->Queued = 1;
+    *Link = Timer;
+    return (GlbTimerQueue == Timer) ? 1 : 0;
+}
+
+/* TimersUnlink
+ * Removes the timer from the queue. The timer lock must be held. */
+OsStatus_t
+TimersUnlink(
+    _In_ MCoreTimer_t *Timer)
+{
+    // Variables
+    MCoreTimer_t **Link = &GlbTimerQueue;
+
+    // Find the link pointing to the timer
+    while (*Link != NULL && *Link != Timer) {
+        Link = &(*Link)->Link;
+    }
+    if (*Link == NULL) {
+        return OsError;
+    }
+    *Link = Timer->Link;
+    Timer->Link = NULL;
+    Timer->Queued = 0;
+    return OsSuccess;
+}
+
+/* TimersQueue
+ * Queues a kernel timer to expire in the given interval, a timer that
+ * is queued already is moved to the new deadline. Expire must be set. */
+void
+TimersQueue(
+    _In_ MCoreTimer_t *Timer,
+    _In_ size_t IntervalNs)
+{
+    // Variables
+    IntStatus_t InterruptStatus;
+    uint64_t Now = 0;
+
+    // Calculate the deadline before taking the lock
+    TimersGetTimestamp(&Now);
+    Timer->Deadline = Now + IntervalNs;
+
+    InterruptStatus = InterruptDisable();
+    SpinlockAcquire(&TimerLock);
+    if (Timer->Queued) {
+        TimersUnlink(Timer);
+    }
+    if (TimersInsert(Timer)) {
+        TimersArmSystemTimer();
+    }
+    SpinlockRelease(&TimerLock);
+    InterruptRestoreState(InterruptStatus);
+}
+
+/* TimersCancel
+ * Removes a queued timer from the timer queue, returns OsError if
+ * the timer was not queued (it expired or was never started) */
+OsStatus_t
+TimersCancel(
+    _In_ MCoreTimer_t *Timer)
+{
+    // Variables
+    IntStatus_t InterruptStatus;
+    OsStatus_t Result = OsError;
+
+    InterruptStatus = InterruptDisable();
+    SpinlockAcquire(&TimerLock);
+    if (Timer->Queued) {
+        Result = TimersUnlink(Timer);
+    }
+    SpinlockRelease(&TimerLock);
+    InterruptRestoreState(InterruptStatus);
+    return Result;
+}
+
 /* TimersStart 
  * Creates a new standard timer for the requesting process. */
 KERNELAPI
@@ -76,7 +206,6 @@ TimersStart(
 {
     // Variables
     MCoreTimer_t *Timer = NULL;
-    DataKey_t Key;
 
     // Sanity
     if (PhoenixGetCurrentAsh() == NULL) {
@@ -85,18 +214,15 @@ TimersStart(
 
     // Allocate a new instance and initialize
     Timer = (MCoreTimer_t*)kmalloc(sizeof(MCoreTimer_t));
+    memset(Timer, 0, sizeof(MCoreTimer_t));
     Timer->Id = GlbTimerIds++;
     Timer->AshId = PhoenixGetCurrentAsh()->Id;
     Timer->Data = Data;
     Timer->Interval = IntervalNs;
-    Timer->Current = 0;
     Timer->Periodic = Periodic;
-    Key.Value = (int)Timer->Id;
 
-    // Add to list of timers
-    CriticalSectionEnter(&TimerLock);
-    CollectionAppend(GlbTimers, CollectionCreateNode(Key, Timer));
-    CriticalSectionLeave(&TimerLock);
+    // Add to the queue of timers
+    TimersQueue(Timer, IntervalNs);
     return Timer->Id;
 }
 
@@ -110,64 +236,106 @@ TimersStop(
     _In_ UUId_t TimerId)
 {
     // Variables
-    OsStatus_t Result = OsError;
+    MCoreTimer_t *Timer = NULL;
+    IntStatus_t InterruptStatus;
 
-    // Now loop through timers registered
-    CriticalSectionEnter(&TimerLock);
-	foreach(tNode, GlbTimers) {
-        // Initiate pointer
-        MCoreTimer_t *Timer = (MCoreTimer_t*)tNode->Data;
-        
-        // Does it match the id? + Owner must match
-        if (Timer->Id == TimerId
+    // Sanity
+    if (PhoenixGetCurrentAsh() == NULL) {
+        return OsError;
+    }
+
+    // Now loop through timers queued, kernel timers
+    // have no owner and can't be matched
+    InterruptStatus = InterruptDisable();
+    SpinlockAcquire(&TimerLock);
+    for (Timer = GlbTimerQueue; Timer != NULL; Timer = Timer->Link) {
+        if (Timer->Expire == NULL && Timer->Id == TimerId
             && Timer->AshId == PhoenixGetCurrentAsh()->Id) {
-			CollectionRemoveByNode(GlbTimers, tNode);
-            kfree(Timer);
-            kfree(tNode);
-            Result = OsSuccess;
+            TimersUnlink(Timer);
             break;
-		}
+        }
     }
-    CriticalSectionLeave(&TimerLock);
-    return Result;
+
+    // A timer whose owner is being notified is on no list, mark it
+    // cancelled and leave the cleanup to the tick that holds it
+    if (Timer == NULL && GlbTimerExpiring != NULL
+        && GlbTimerExpiring->Id == TimerId
+        && GlbTimerExpiring->AshId == PhoenixGetCurrentAsh()->Id) {
+        GlbTimerExpiring->Cancelled = 1;
+        SpinlockRelease(&TimerLock);
+        InterruptRestoreState(InterruptStatus);
+        return OsSuccess;
+    }
+    SpinlockRelease(&TimerLock);
+    InterruptRestoreState(InterruptStatus);
+
+    if (Timer == NULL) {
+        return OsError;
+    }
+    kfree(Timer);
+    return OsSuccess;
 }
 
 /* TimersTick
- * This method actually applies the new tick-delta to all
- * active timers registered, and decreases the total */
+ * Expires the timers at the head of the queue whose deadline has
+ * been reached, the queue is sorted so we stop at the first timer
+ * that is still pending. Handlers are invoked without the lock held. */
 void
-TimersTick(
-	_In_ size_t Tick)
+TimersTick(void)
 {
 	// Variables
-	CollectionItem_t *i = NULL;
-	size_t MilliTicks = 0;
-
-	// Calculate how many milliseconds
-	MilliTicks = DIVUP(Tick, NSEC_PER_MSEC);
-
-	// Update scheduler with the milliticks
-	SchedulerTick(MilliTicks);
-
-	// Now loop through timers registered
-	_foreach(i, GlbTimers) {
-        // Initiate pointer
-        MCoreTimer_t *Timer = (MCoreTimer_t*)i->Data;
-        
-        // Reduce
-		Timer->Current -= MIN(Timer->Current, Tick);
-		if (Timer->Current == 0) {
-			__KernelTimeoutDriver(Timer->AshId, Timer->Id, (void*)Timer->Data);
-			if (Timer->Periodic) {
-				Timer->Current = Timer->Interval;
-			}
-			else {
-				CollectionRemoveByNode(GlbTimers, i);
-				kfree(Timer);
-				kfree(i);
-			}
-		}
-	}
+    MCoreTimer_t *Timer = NULL;
+    IntStatus_t InterruptStatus;
+    size_t Generation;
+    uint64_t Now = 0;
+
+    // Expire the timers that are due one at a time, the lock is not held
+    // while the owners are notified and a notified timer is on no list,
+    // so the owners may queue or cancel any timer. Kernel timers can be
+    // queued again meanwhile, so their generation is captured here
+    TimersGetTimestamp(&Now);
+    InterruptStatus = InterruptDisable();
+    SpinlockAcquire(&TimerLock);
+    while (GlbTimerQueue != NULL && GlbTimerQueue->Deadline <= Now) {
+        Timer = GlbTimerQueue;
+        GlbTimerQueue = Timer->Link;
+        Timer->Link = NULL;
+        Timer->Queued = 0;
+        Generation = Timer->Generation;
+        if (Timer->Expire == NULL) {
+            GlbTimerExpiring = Timer;
+        }
+        SpinlockRelease(&TimerLock);
+
+        if (Timer->Expire != NULL) {
+            Timer->Expire(Timer, Generation);
+            SpinlockAcquire(&TimerLock);
+            continue;
+        }
+        __KernelTimeoutDriver(Timer->AshId, Timer->Id, (void*)Timer->Data);
+
+        // Periodic timers keep the period, but don't try to catch up on
+        // missed periods, unless they were stopped while notified
+        SpinlockAcquire(&TimerLock);
+        GlbTimerExpiring = NULL;
+        if (Timer->Periodic && !Timer->Cancelled) {
+            Timer->Deadline += Timer->Interval;
+            if (Timer->Deadline <= Now) {
+                Timer->Deadline = Now + Timer->Interval;
+            }
+            TimersInsert(Timer);
+        }
+        else {
+            SpinlockRelease(&TimerLock);
+            kfree(Timer);
+            SpinlockAcquire(&TimerLock);
+        }
+    }
+
+    // Arm the system timer for the next deadline
+    TimersArmSystemTimer();
+    SpinlockRelease(&TimerLock);
+    InterruptRestoreState(InterruptStatus);
 }
 
 /* TimersRegistrate
@@ -178,7 +346,8 @@ OsStatus_t
 TimersRegisterSystemTimer(
 	_In_ UUId_t Source, 
 	_In_ size_t TickNs,
-    _In_ clock_t (*SystemTickHandler)(void))
+    _In_ clock_t (*SystemTickHandler)(void),
+    _In_Opt_ void (*ArmHandler)(_In_ size_t Ns))
 {
 	// Variables
 	MCoreInterruptDescriptor_t *Interrupt = NULL;
@@ -203,17 +372,22 @@ TimersRegisterSystemTimer(
 	SystemTimer->Tick = TickNs;
 	SystemTimer->Ticks = 0;
     SystemTimer->SystemTick = SystemTickHandler;
+    SystemTimer->Arm = ArmHandler;
 
 	// Add the new timer to the list
 	tKey.Value = 0;
 	CollectionAppend(GlbSystemTimers, 
         CollectionCreateNode(tKey, SystemTimer));
 
-	// Ok, for a system timer we want something optimum
-	// of 1 ms per interrupt
+	// Ok, for a system timer we want one that can be armed one-shot,
+	// otherwise something optimum of 1 ms per interrupt
 	if (GlbActiveSystemTimer != NULL) {
 		int ActiveDelta = abs(1000 - GlbActiveSystemTimer->Tick);
-		if (ActiveDelta > Delta) {
+		if (GlbActiveSystemTimer->Arm == NULL && ArmHandler != NULL) {
+			GlbActiveSystemTimer = SystemTimer;
+		}
+		else if ((GlbActiveSystemTimer->Arm == NULL || ArmHandler != NULL)
+			&& ActiveDelta > Delta) {
 			GlbActiveSystemTimer = SystemTimer;
 		}
 	}
@@ -235,6 +409,15 @@ OsStatus_t
 TimersRegisterPerformanceTimer(
 	_In_ MCoreTimePerformanceOps_t *Operations)
 {
+    // Variables
+    LargeInteger_t Frequency;
+
+    // The frequency is cached as every timestamp needs it
+    Operations->ReadFrequency(&Frequency);
+    if (Frequency.QuadPart == 0) {
+        return OsError;
+    }
+    GlbPerformanceFrequency = (uint64_t)Frequency.QuadPart;
     PerformanceTimer.ReadFrequency = Operations->ReadFrequency;
     PerformanceTimer.ReadTimer = Operations->ReadTimer;
     return OsSuccess;
@@ -263,7 +446,8 @@ TimersInterrupt(
 	// Sanitize if the source is ok
 	if (GlbActiveSystemTimer != NULL) {
 		if (GlbActiveSystemTimer->Source == Source) {
-			TimersTick(GlbActiveSystemTimer->Tick);
+			GlbActiveSystemTimer->Ticks++;
+			TimersTick();
 			return OsSuccess;
 		}
 	}
@@ -286,6 +470,33 @@ TimersGetSystemTime(
     return OsSuccess;
 }
 
+/* TimersGetTimestamp
+ * Retrieves the absolute time that timer deadlines are measured in,
+ * the performance timer is used when present, otherwise system ticks */
+OsStatus_t
+TimersGetTimestamp(
+    _Out_ uint64_t *Timestamp)
+{
+    // Variables
+    LargeInteger_t Counter;
+
+    // Prefer the performance counter, it keeps running while
+    // the system timer is armed one-shot
+    if (PerformanceTimer.ReadTimer != NULL) {
+        PerformanceTimer.ReadTimer(&Counter);
+        *Timestamp = (((uint64_t)Counter.QuadPart / GlbPerformanceFrequency) * TIMERS_UNITS_PER_SEC)
+            + ((((uint64_t)Counter.QuadPart % GlbPerformanceFrequency) * TIMERS_UNITS_PER_SEC) 
+                / GlbPerformanceFrequency);
+        return OsSuccess;
+    }
+    if (GlbActiveSystemTimer != NULL) {
+        *Timestamp = (uint64_t)GlbActiveSystemTimer->Ticks * GlbActiveSystemTimer->Tick;
+        return OsSuccess;
+    }
+    *Timestamp = 0;
+    return OsError;
+}
+
 /* TimersGetSystemTick 
  * Retrieves the system tick counter. This is only ticking
  * if a system timer has been initialized. */
@@ -28,18 +28,27 @@
 #include <ds/ds.h>
 
 /* Bitmap
- * Contains information about the bitmap and resources. */
+ * Contains information about the bitmap and resources. The optional
+ * summary has a bit for each word of data that is set when the word
+ * is full, searches use it to skip full words without reading them. */
 typedef struct _Bitmap {
     int                  Cleanup;
     size_t               SizeInBytes;
     size_t               Capacity;
 	uintptr_t           *Data;
+	uintptr_t           *Summary;
 } Bitmap_t;
 
+/* BITMAP_WORDS
+ * The number of words needed for the given number of bytes, the data
+ * of a bitmap is always accessed in whole words */
+#define BITMAP_WORDS(Size)          DIVUP((Size), sizeof(uintptr_t))
+#define BITMAP_SUMMARY_WORDS(Size)  DIVUP(BITMAP_WORDS(Size), __BITS)
+
 /* BitmapCreate
  * Creates a bitmap of the given size in bytes, the actual available
  * member count will then be Size * sizeof(byte). This automatically
- * allocates neccessary resources */
+ * allocates neccessary resources, including the summary */
 MOSAPI
 Bitmap_t*
 MOSABI
@@ -49,7 +58,8 @@ BitmapCreate(
 /* BitmapConstruct
  * Creates a bitmap of the given size in bytes, the actual available
  * member count will then be Size * sizeof(byte). This uses user-provided
- * resources, and won't be cleaned up. */
+ * resources, and won't be cleaned up. Data must have room for
+ * BITMAP_WORDS(Size) words. */
 MOSAPI
 OsStatus_t
 MOSABI
@@ -58,6 +68,16 @@ BitmapConstruct(
     _In_ uintptr_t *Data,
     _In_ size_t Size);
 
+/* BitmapConstructSummary
+ * Attaches the user-provided summary to the bitmap, it must have room for
+ * BITMAP_SUMMARY_WORDS(SizeInBytes) words and is built from the data. */
+MOSAPI
+OsStatus_t
+MOSABI
+BitmapConstructSummary(
+    _In_ Bitmap_t *Bitmap,
+    _In_ uintptr_t *Summary);
+
 /* BitmapDestroy
  * Cleans up any resources allocated by the Create/Construct. */
 MOSAPI
@@ -118,4 +138,16 @@ BitmapFindBits(
     _In_ Bitmap_t *Bitmap,
     _In_ int Count);
 
+/* BitmapFindBitsInRange
+ * Locates the requested number of consequtive free bits between Start and
+ * End (exclusive). Returns the index of the first free bit. Returns -1 on no free. */
+MOSAPI
+int
+MOSABI
+BitmapFindBitsInRange(
+    _In_ Bitmap_t *Bitmap,
+    _In_ int Start,
+    _In_ int End,
+    _In_ int Count);
+
 #endif //!_GENERIC_BITMAP_H_
@@ -0,0 +1,88 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS C Library - String Operations
+ * - The memory and string primitives are implemented for each instruction
+ *   set, the c-library selects the best set for the cpu at startup. The
+ *   kernel library always uses the scalar versions
+ */
+
+#ifndef __INTERNAL_STRINGOPS_INC__
+#define __INTERNAL_STRINGOPS_INC__
+
+/* Includes
+ * - Library */
+#include <crtdefs.h>
+
+/* String Operation Levels
+ * The instruction sets the primitives are available for */
+#define STRINGOPS_SCALAR			0
+#define STRINGOPS_SSE2				1
+#define STRINGOPS_AVX2				2
+
+/* StringOperations
+ * A set of primitives for one instruction set, the table that is
+ * selected serves memcpy, memmove etc in the c-library */
+typedef struct _StringOperations {
+	int				Level;
+	const char		*Name;
+	void*			(*Memcpy)(void *Destination, const void *Source, size_t Count);
+	void*			(*Memmove)(void *Destination, const void *Source, size_t Count);
+	void*			(*Memset)(void *Destination, int Value, size_t Count);
+	int				(*Memcmp)(const void *First, const void *Second, size_t Count);
+	void*			(*Memchr)(const void *Source, int Value, size_t Count);
+	size_t			(*Strlen)(const char *String);
+	char*			(*Strchr)(const char *String, int Value);
+	int				(*Strcmp)(const char *First, const char *Second);
+} StringOperations_t;
+
+_CODE_BEGIN
+/* Scalar Primitives
+ * The portable implementations, they are the only ones used by the kernel */
+__EXTERN void*	memcpy_base(void *Destination, const void *Source, size_t Count);
+__EXTERN void*	memmove_base(void *Destination, const void *Source, size_t Count);
+__EXTERN void*	memset_base(void *Destination, int Value, size_t Count);
+__EXTERN int	memcmp_base(const void *First, const void *Second, size_t Count);
+__EXTERN void*	memchr_base(const void *Source, int Value, size_t Count);
+__EXTERN size_t	strlen_base(const char *String);
+__EXTERN char*	strchr_base(const char *String, int Value);
+__EXTERN int	strcmp_base(const char *First, const char *Second);
+
+#ifndef LIBC_KERNEL
+/* The currently selected primitives, it points to the
+ * scalar primitives until StringOperationsInitialize is called */
+__EXTERN const StringOperations_t *__GlbStringOperations;
+
+/* StringOperationsInitialize
+ * Selects the best primitives for the cpu by cpuid, called by the
+ * runtime before anything else */
+_CRTIMP
+void
+StringOperationsInitialize(void);
+
+/* StringOperationsSelect
+ * Overrides the primitives with the given level, used for benchmarking. Returns
+ * NULL if the cpu does not support the level. */
+_CRTIMP
+const StringOperations_t*
+StringOperationsSelect(
+	_In_ int Level);
+#endif
+_CODE_END
+
+#endif //!__INTERNAL_STRINGOPS_INC__
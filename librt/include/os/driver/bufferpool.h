@@ -30,9 +30,30 @@
 #include <os/osdefs.h>
 
 /* BufferPool 
- * */
+ * Sub-allocator for buffer-objects. Allocations are served from power-of-two
+ * size classes, and are aligned to their class size (up to the alignment of
+ * the buffer-object). This means an allocation of 4kb or less never crosses
+ * a 4kb boundary, which is what most host controllers require. */
 typedef struct _BufferPool BufferPool_t;
 
+/* BufferPool Definitions
+ * Size class limits, the smallest class is 16 bytes */
+#define BUFFERPOOL_MIN_ORDER            4
+#define BUFFERPOOL_MAX_ORDER            24
+#define BUFFERPOOL_CLASSES              (BUFFERPOOL_MAX_ORDER - BUFFERPOOL_MIN_ORDER + 1)
+
+/* BufferPoolStatistics
+ * Usage statistics for a buffer-pool, retrieved by BufferPoolGetStatistics. */
+typedef struct _BufferPoolStatistics {
+    size_t                      Capacity;
+    size_t                      BytesAllocated;
+    size_t                      BytesPeak;
+    size_t                      Allocations;
+    size_t                      Frees;
+    size_t                      Failures;
+    size_t                      ClassAllocations[BUFFERPOOL_CLASSES];
+} BufferPoolStatistics_t;
+
 // Cpp guard begin
 _CODE_BEGIN
 
@@ -58,7 +79,8 @@ BufferPoolDestroy(
 /* BufferPoolAllocate
  * Allocates the requested size and outputs two addresses. The
  * virtual pointer to the accessible data, and the address of its 
- * corresponding physical address for hardware. */
+ * corresponding physical address for hardware. The allocation is
+ * rounded up to the nearest power of two and aligned to it. */
 MOSAPI
 OsStatus_t
 MOSABI
@@ -78,6 +100,15 @@ BufferPoolFree(
     _In_ BufferPool_t *Pool,
     _In_ uintptr_t *VirtualPointer);
 
+/* BufferPoolGetStatistics
+ * Retrieves a snapshot of the usage statistics of the buffer-pool. */
+MOSAPI
+OsStatus_t
+MOSABI
+BufferPoolGetStatistics(
+    _In_ BufferPool_t *Pool,
+    _Out_ BufferPoolStatistics_t *Statistics);
+
 // Cpp guard end
 _CODE_END
 
@@ -39,6 +39,17 @@
 #define __WINDOWMANAGER_TARGET              __SERVICE_TARGET(2)
 #define __USBMANAGER_TARGET                 __SERVICE_TARGET(3)
 
+/* Service dispatch definitions, a service handles its events on a single
+ * thread unless it asks for workers. With workers each event is routed by
+ * an affinity key taken from the message, events that have the same key
+ * always go to the same worker and are handled in the order they arrived */
+#define SERVICE_AFFINITY_SERIAL             0   /* Default, all on the first worker */
+#define SERVICE_AFFINITY_NONE               -1  /* Any worker, no ordering */
+#define SERVICE_AFFINITY_SENDER             -2  /* Ordered per sending process */
+#define SERVICE_AFFINITY_ARGUMENT(Index)    ((Index) + 1)
+#define SERVICE_MAX_FUNCTIONS               0x200
+#define SERVICE_MAX_WORKERS                 16
+
 /* RegisterService 
  * Registers a service on the current alias, allowing
  * other applications and frameworks to send commands
@@ -49,6 +60,18 @@ MOSABI
 RegisterService(
     _In_ UUId_t Alias);
 
+/* WaitForService
+ * Waits for the service on the given alias to register, this is how
+ * a service declares the services it depends on. Services start in
+ * parallel, so anything used during OnLoad must be waited for. A timeout
+ * of 0 waits forever, OsError is returned if the timeout expires */
+MOSAPI 
+OsStatus_t
+MOSABI
+WaitForService(
+    _In_ UUId_t Alias,
+    _In_ size_t Timeout);
+
 /* OnLoad
  * The entry-point of a service, this is called
  * as soon as the server is loaded in the system */
@@ -58,6 +81,28 @@ OsStatus_t
 OnLoad(void);
 #endif
 
+/* ServiceSetWorkers
+ * Sets the number of workers that handle events for the service, must
+ * be called from OnLoad. A single worker keeps events on the main thread */
+#ifdef __SERVICE_IMPL
+__EXTERN
+OsStatus_t
+ServiceSetWorkers(
+    _In_ int Workers);
+#endif
+
+/* ServiceSetAffinity
+ * Declares which part of a message with the given function that decides
+ * the worker it is handled by, e.g. the argument that holds a file handle.
+ * Must be called from OnLoad */
+#ifdef __SERVICE_IMPL
+__EXTERN
+OsStatus_t
+ServiceSetAffinity(
+    _In_ int Function,
+    _In_ int Affinity);
+#endif
+
 /* OnUnload
  * This is called when the service is being unloaded
  * and should free all resources allocated by the system */
@@ -27,6 +27,7 @@
 #include <os/mollenos.h>
 #include <os/osdefs.h>
 #include <os/ipc/ipc.h>
+#include <stddef.h>
 
 /* Includes
  * - System */
@@ -46,10 +47,17 @@
 #define __WINDOWMANAGER_DESTROY				IPC_DECL_FUNCTION(1)
 #define __WINDOWMANAGER_INVALIDATE			IPC_DECL_FUNCTION(2)
 #define __WINDOWMANAGER_CONFIGURE			IPC_DECL_FUNCTION(3)
-#define __WINDOWMANAGER_SWAPBUFFER			IPC_DECL_FUNCTION(4)
+#define __WINDOWMANAGER_PRESENT			IPC_DECL_FUNCTION(4)
 #define __WINDOWMANAGER_QUERY				IPC_DECL_FUNCTION(5)
 #define __WINDOWMANAGER_NEWINPUT			IPC_DECL_FUNCTION(6)
 
+/* Window surfaces are shared between the client and the windowmanager,
+ * the surface buffer holds a number of frames of (Pitch * Height) bytes 
+ * each. The client draws into one frame while the windowmanager reads
+ * from the last presented frame. */
+#define WINDOW_SURFACE_FRAMES				2
+#define WINDOW_MAX_DAMAGE					16
+
 /* SurfaceFormat 
  * Describes the types of pixel formats that are available
  * for surfaces */
@@ -82,11 +90,28 @@ typedef struct _MWindowDescriptor {
 	SurfaceDescriptor_t		Surface;
 } WindowDescriptor_t;
 
+/* WindowPresent_t
+ * Structure used by the present function call, it describes which frame
+ * of the surface should be shown and which parts of it changed. The damage
+ * is relative to the surface, a count of 0 damages the entire surface */
+typedef struct _MWindowPresent {
+	Handle_t				Handle;
+	int						Frame;
+	int						DamageCount;
+	Rect_t					Damage[WINDOW_MAX_DAMAGE];
+} WindowPresent_t;
+
+/* GetWindowSurfaceSize
+ * Calculates the number of bytes the surface buffer must be able to
+ * hold for the given surface */
+#define GetWindowSurfaceSize(Surface) \
+	((Surface)->Pitch * (size_t)(Surface)->Dimensions.h * WINDOW_SURFACE_FRAMES)
+
 /* CreateWindow 
  * Creates a window of the given
- * dimensions and flags. The returned
- * value is the id of the newly created
- * window. Returns NULL on failure */
+ * dimensions and flags. The surface buffer must be at least 
+ * GetWindowSurfaceSize bytes and is shared with the windowmanager,
+ * nothing is drawn before the first PresentWindow. Returns NULL on failure */
 #ifdef __WINDOWMANAGER_EXPORT
 __WNDAPI Handle_t CreateWindow(WindowParameters_t *Params);
 #else
@@ -212,4 +237,62 @@ InvalidateWindow(
 }
 #endif
 
+/* PresentWindow
+ * Shows the given frame of the window surface and marks the damaged 
+ * rectangles (relative to the surface) for redrawing, NULL damages all.
+ * When this returns the windowmanager no longer reads from the previously
+ * presented frame, so the client can start drawing into it. That frame
+ * still contains the contents from before the last present. */
+#ifdef __WINDOWMANAGER_EXPORT
+__WNDAPI OsStatus_t PresentWindow(WindowPresent_t *Present);
+#else
+SERVICEAPI
+OsStatus_t
+SERVICEABI
+PresentWindow(
+	_In_ Handle_t Handle,
+	_In_ int Frame,
+	_In_Opt_ Rect_t *Damage,
+	_In_ int DamageCount)
+{
+	// Variables
+	MRemoteCall_t Request;
+	WindowPresent_t Present;
+	OsStatus_t Result = OsError;
+
+	// Sanitize, the damage must fit into a single message
+	if (DamageCount < 0 || DamageCount > WINDOW_MAX_DAMAGE
+		|| (Damage == NULL && DamageCount != 0)) {
+		return OsError;
+	}
+
+	// Build the present description, only the used 
+	// damage entries are sent
+	Present.Handle = Handle;
+	Present.Frame = Frame;
+	Present.DamageCount = DamageCount;
+	if (DamageCount != 0) {
+		memcpy(&Present.Damage[0], Damage, DamageCount * sizeof(Rect_t));
+	}
+
+	// Initialize rpc request
+	RPCInitialize(&Request, __WINDOWMANAGER_INTERFACE_VERSION,
+		PIPE_RPCOUT, __WINDOWMANAGER_PRESENT);
+
+	// Setup rpc arguments
+	RPCSetArgument(&Request, 0, (__CONST void*)&Present, 
+		offsetof(WindowPresent_t, Damage) + (DamageCount * sizeof(Rect_t)));
+
+	// Install result buffer
+	RPCSetResult(&Request, (__CONST void*)&Result, sizeof(OsStatus_t));
+
+	// Execute the request, we wait for the windowmanager to have
+	// switched frames before returning
+	if (RPCExecute(&Request, __WINDOWMANAGER_TARGET) != OsSuccess) {
+		return OsError;
+	}
+	return Result;
+}
+#endif
+
 #endif //!_MOLLENOS_WINDOW_H_
@@ -43,6 +43,15 @@
 #define PIPE_RPCOUT						0
 #define PIPE_RPCIN						1
 
+/* Asynchronous response ports encode the pipe-port of an rpc queue and
+ * the request id, writes to them are framed with the request id by the
+ * kernel so replies can be matched no matter the order they arrive in */
+#define PIPE_ASYNC_FLAG					0x40000000
+#define PIPE_ASYNC_MAXPORT				0x3FFF
+#define PIPE_ASYNC_PORT(Port, Id)		(PIPE_ASYNC_FLAG | (((Port) & PIPE_ASYNC_MAXPORT) << 16) | ((Id) & 0xFFFF))
+#define PIPE_ASYNC_GETPORT(Port)		(((Port) >> 16) & PIPE_ASYNC_MAXPORT)
+#define PIPE_ASYNC_GETID(Port)			((Port) & 0xFFFF)
+
 /* Predefined system events that is common for
  * all userspace applications, these primarily consists
  * of input and/or window events */
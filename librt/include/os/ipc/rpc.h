@@ -62,6 +62,36 @@ PACKED_TYPESTRUCT(MRemoteCall, {
 	RPCArgument_t			Result;
 });
 
+/* The frame that preceeds every reply to an asynchronous
+ * request, the kernel writes it when a reply is sent to an
+ * asynchronous response port */
+PACKED_TYPESTRUCT(MRemoteCallReply, {
+	int						RequestId;
+	size_t					Length;		/* Excluding this header */
+});
+
+/* RPC Completion
+ * Describes a finished asynchronous request, Length is the number
+ * of bytes that was copied into the result buffer of the request */
+typedef struct _MRemoteCallCompletion {
+	int						RequestId;
+	void					*Context;
+	size_t					Length;
+} MRemoteCallCompletion_t;
+
+/* RPC Queue
+ * Asynchronous requests are submitted through a queue, a queue owns a
+ * pipe-port that all replies are received on and can have up to Depth
+ * requests in flight. A queue must only be used by a single thread */
+#define RPC_QUEUE_MAX_DEPTH			0x10000
+typedef struct _MRemoteCallQueue MRemoteCallQueue_t;
+
+/* RPC Message Arena
+ * Servers receive messages into slots of an arena, each slot has room for
+ * the header and all arguments and is recycled once the message is handled */
+#define RPC_ARENA_SLAB_SLOTS		16
+typedef struct _MRemoteCallArena MRemoteCallArena_t;
+
 /* Start one of these before function prototypes */
 _CODE_BEGIN
 
@@ -172,6 +202,40 @@ OsStatus_t
 RPCCleanup(
 	_In_ MRemoteCall_t *Message);
 
+/* RPCArenaInitialize
+ * Creates a new message arena for a server loop, the first slab is
+ * allocated up front */
+MOSAPI
+OsStatus_t
+RPCArenaInitialize(
+	_Out_ MRemoteCallArena_t **Arena);
+
+/* RPCArenaDestroy
+ * Frees all slabs of the arena, all messages taken
+ * from the arena must have been released */
+MOSAPI
+OsStatus_t
+RPCArenaDestroy(
+	_In_ MRemoteCallArena_t *Arena);
+
+/* RPCListenArena
+ * Waits for a new RPC message and reads the header and all arguments
+ * into a slot from the arena. The message must be given back with
+ * RPCRelease once handled, it may be handed to other threads until then */
+MOSAPI
+OsStatus_t
+RPCListenArena(
+	_In_ MRemoteCallArena_t *Arena,
+	_Out_ MRemoteCall_t **Message);
+
+/* RPCRelease
+ * Returns a message received by RPCListenArena to its arena, the
+ * argument buffers of the message are invalid afterwards */
+MOSAPI
+OsStatus_t
+RPCRelease(
+	_In_ MRemoteCall_t *Message);
+
 /* RPCExecute/RPCEvent
  * To get a reply from the RPC request, the user
  * must use RPCExecute, this will automatically wait
@@ -200,6 +264,59 @@ RPCRespond(
 	_In_ __CONST void *Buffer, 
 	_In_ size_t Length);
 
+/* RPCQueueInitialize
+ * Creates a new queue for asynchronous requests, the queue opens a pipe
+ * on the given port that replies are received on */
+MOSAPI
+OsStatus_t
+RPCQueueInitialize(
+	_In_ int Port,
+	_In_ size_t Depth,
+	_Out_ MRemoteCallQueue_t **Queue);
+
+/* RPCQueueDestroy
+ * Closes the pipe of the queue and frees it, replies to
+ * requests that are still in flight are lost */
+MOSAPI
+OsStatus_t
+RPCQueueDestroy(
+	_In_ MRemoteCallQueue_t *Queue);
+
+/* RPCSubmit
+ * Sends the request without waiting for the reply, the reply is read into
+ * the result buffer of the request by RPCPoll or RPCWait. The result buffer
+ * must stay valid until the request has completed */
+MOSAPI
+OsStatus_t
+RPCSubmit(
+	_In_ MRemoteCallQueue_t *Queue,
+	_In_ MRemoteCall_t *Rpc,
+	_In_ UUId_t Target,
+	_In_Opt_ void *Context,
+	_Out_Opt_ int *RequestId);
+
+/* RPCPoll
+ * Collects up to Count completed requests without blocking,
+ * returns the number of completions filled in */
+MOSAPI
+int
+RPCPoll(
+	_In_ MRemoteCallQueue_t *Queue,
+	_Out_ MRemoteCallCompletion_t *Completions,
+	_In_ int Count);
+
+/* RPCWait
+ * Blocks until at least MinCount requests have completed and collects up to
+ * Count completions, returns the number of completions filled in or -1 if
+ * fewer than MinCount requests are in flight */
+MOSAPI
+int
+RPCWait(
+	_In_ MRemoteCallQueue_t *Queue,
+	_Out_ MRemoteCallCompletion_t *Completions,
+	_In_ int Count,
+	_In_ int MinCount);
+
 _CODE_END
 
 #endif //!_RPC_INTERFACE_H_
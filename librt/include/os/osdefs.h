@@ -78,7 +78,8 @@ typedef void *                      Handle_t;
  * from certain os-operations */
 typedef enum {
     OsSuccess,
-    OsError
+    OsError,
+    OsOutOfMemory
 } OsStatus_t;
 
 typedef enum {
@@ -109,6 +109,7 @@
  * - Server Support */
 #define SYSCALL_SERVICEREGISTER		0x4B
 #define SYSCALL_RESOLVEDRIVER		0x4C
+#define SYSCALL_SERVICEWAIT			0x4D
 
 /* Driver System Calls 
  * - Interrupt Support */
@@ -37,6 +37,7 @@ QUICKREF
 */
 
 #include <string.h>
+#include <internal/_stringops.h>
 #include <limits.h>
 #include <stddef.h>
 
@@ -68,7 +69,7 @@ QUICKREF
    to fill (long)MASK. */
 #define DETECTCHAR(X,MASK) (DETECTNULL(X ^ MASK))
 
-void* memchr(const void* src_void, int c, size_t length)
+void* memchr_base(const void* src_void, int c, size_t length)
 {
 	const unsigned char *src = (const unsigned char *)src_void;
 	unsigned char d = (unsigned char)c;
@@ -127,3 +128,12 @@ void* memchr(const void* src_void, int c, size_t length)
 
 	return NULL;
 }
+
+void* memchr(const void* src_void, int c, size_t length)
+{
+#ifdef LIBC_KERNEL
+	return memchr_base(src_void, c, length);
+#else
+	return __GlbStringOperations->Memchr(src_void, c, length);
+#endif
+}
@@ -23,6 +23,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <internal/_string.h>
+#include <internal/_stringops.h>
 #include <stddef.h>
 
 /* This is the default non-accelerated byte copier, it's optimized
@@ -73,150 +74,23 @@ memcpy_base(
 	return Destination;
 }
 
-// Don't use SSE/MMX instructions in kernel environment
-// it's way to fragile on task-switches as we can heavily use memcpy
-#ifdef LIBC_KERNEL
-
 #if defined(_MSC_VER) && !defined(__clang__)
 #pragma function(memcpy)
 #endif
 
 /* memcpy
- * The memory copy function, simply calls the selector */
+ * The memory copy function, the kernel always uses the byte copier as
+ * vector registers are not saved when it's interrupted. The c-library
+ * uses the primitives selected at startup */
 void*
 memcpy(
     _InOut_ void *destination,
     _In_ const void *source,
     _In_ size_t count)
 {
+#ifdef LIBC_KERNEL
 	return memcpy_base(destination, source, count);
-}
-
-#else
-
-#if defined(_MSC_VER) && !defined(__clang__)
-#include <intrin.h>
 #else
-#include <cpuid.h>
+	return __GlbStringOperations->Memcpy(destination, source, count);
 #endif
-
-/* Typedef the memset fingerprint */
-typedef void *(*MemCpyTemplate)(void *Destination, const void *Source, size_t Count);
-
-/* Definitions CPUID */
-#define CPUID_FEAT_EDX_MMX      1 << 23
-#define CPUID_FEAT_EDX_SSE		1 << 25
-#define MEMCPY_ACCEL_THRESHOLD	10
-
-/* ASM Externs + Prototypes */
-extern void asm_memcpy_mmx(void *Dest, const void *Source, int Loops, int RemainingBytes);
-extern void asm_memcpy_sse(void *Dest, const void *Source, int Loops, int RemainingBytes);
-
-/* Global */
-MemCpyTemplate __GlbMemCpyInstance = NULL;
-
-/* This is the SSE optimized version of memcpy, but there is a fallback
- * to the normal one, in case there isn't enough loops for overhead to be
- * worth it. */
-void *MemCpySSE(void *Destination, const void *Source, size_t Count)
-{
-	/* Loop Count */
-	uint32_t SseLoops = Count / 16;
-	uint32_t mBytes = Count % 16;
-
-	/* Sanity, we don't want to go through the
-	 * overhead if it's less than a certain threshold */
-	if (SseLoops < MEMCPY_ACCEL_THRESHOLD) {
-		return memcpy_base(Destination, Source, Count);
-	}
-
-	/* Call asm */
-	asm_memcpy_sse(Destination, Source, SseLoops, mBytes);
-	
-	/* Done */
-	return Destination;
-}
-
-/* This is the MMX optimized version of memcpy, but there is a fallback
- * to the normal one, in case there isn't enough loops for overhead to be
- * worth it. */
-void *MemCpyMMX(void *Destination, const void *Source, size_t Count)
-{
-	/* Loop Count */
-	uint32_t MmxLoops = Count / 8;
-	uint32_t mBytes = Count % 8;
-
-	/* Sanity, we don't want to go through the
-	* overhead if it's less than a certain threshold */
-	if (MmxLoops < MEMCPY_ACCEL_THRESHOLD) {
-		return memcpy_base(Destination, Source, Count);
-	}
-
-	/* Call asm */
-	asm_memcpy_mmx(Destination, Source, MmxLoops, mBytes);
-
-	/* Done */
-	return Destination;
 }
-
-/* MemCpySelect
- * This is the default, initial routine, it selects the best
- * optimized memcpy for this system. It can be either SSE or MMX
- * or just the byte copier */
-void*
-MemCpySelect(
-    _InOut_ void *Destination,
-    _In_ const void *Source,
-    _In_ size_t Count)
-{
-	// Variables
-	int CpuRegisters[4] = { 0 };
-	int CpuFeatEcx = 0;
-	int CpuFeatEdx = 0;
-
-	// Now extract the cpu information 
-	// so we can select a memcpy
-#if defined(_MSC_VER) && !defined(__clang__)
-	__cpuid(CpuRegisters, 1);
-#else
-    __cpuid(1, CpuRegisters[0], CpuRegisters[1], 
-        CpuRegisters[2], CpuRegisters[3]);
-#endif
-    // Features are in ecx/edx
-    CpuFeatEcx = CpuRegisters[2];
-    CpuFeatEdx = CpuRegisters[3];
-
-    // Choose between SSE, MMX and base
-	if (CpuFeatEdx & CPUID_FEAT_EDX_SSE) {
-		__GlbMemCpyInstance = MemCpySSE;
-		return MemCpySSE(Destination, Source, Count);
-	}
-	else if (CpuFeatEdx & CPUID_FEAT_EDX_MMX) {
-		__GlbMemCpyInstance = MemCpyMMX;
-		return MemCpyMMX(Destination, Source, Count);
-	}
-	else {
-		__GlbMemCpyInstance = memcpy_base;
-		return memcpy_base(Destination, Source, Count);
-	}
-}
-
-#if defined(_MSC_VER) && !defined(__clang__)
-#pragma function(memcpy)
-#endif
-
-/* memcpy
- * The memory copy function, simply calls the selector */
-void*
-memcpy(
-    _InOut_ void *destination,
-    _In_ const void *source,
-    _In_ size_t count)
-{
-	if (__GlbMemCpyInstance == NULL) {
-		__GlbMemCpyInstance = MemCpySelect;
-	}
-	return __GlbMemCpyInstance(destination, source, count);
-}
-
-#endif
@@ -36,10 +36,11 @@ QUICKREF
 */
 
 #include <string.h>
+#include <internal/_stringops.h>
 #include <internal/_string.h>
 #include <stdint.h>
 
-void* memmove(void *destination, const void* source, size_t count)
+void* memmove_base(void *destination, const void* source, size_t count)
 {
 	char *dst = (char *)destination;
 	const char *src = (char *)source;
@@ -95,4 +96,13 @@ void* memmove(void *destination, const void* source, size_t count)
 	}
 
 	return destination;
-}
\ No newline at end of file
+}
+
+void* memmove(void *destination, const void* source, size_t count)
+{
+#ifdef LIBC_KERNEL
+	return memmove_base(destination, source, count);
+#else
+	return __GlbStringOperations->Memmove(destination, source, count);
+#endif
+}
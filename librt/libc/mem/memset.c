@@ -4,16 +4,13 @@
  */
 
 #include <string.h>
+#include <internal/_stringops.h>
 
 #define LBLOCKSIZE (sizeof(long))
 #define UNALIGNED(X)   ((long)X & (LBLOCKSIZE - 1))
 #define TOO_SMALL(LEN) ((LEN) < LBLOCKSIZE)
 
-#if defined(_MSC_VER) && !defined(__clang__)
-#pragma function(memset)
-#endif
-
-void *memset(void *dest, int c, size_t count)
+void *memset_base(void *dest, int c, size_t count)
 {
 	char *s = (char *)dest;
 	int i;
@@ -65,4 +62,17 @@ void *memset(void *dest, int c, size_t count)
 		*s++ = (char) c;
 
 	return dest;
-}
\ No newline at end of file
+}
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma function(memset)
+#endif
+
+void *memset(void *dest, int c, size_t count)
+{
+#ifdef LIBC_KERNEL
+	return memset_base(dest, c, count);
+#else
+	return __GlbStringOperations->Memset(dest, c, count);
+#endif
+}
@@ -0,0 +1,659 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS C Library - String Operations
+ * - Contains the SSE2 and AVX2 versions of the memory and string primitives
+ *   and the cpuid selection between them. The string functions only read
+ *   past the terminator within the same page, so they never fault
+ */
+
+/* Includes
+ * - Library */
+#include <internal/_stringops.h>
+#include <stdint.h>
+
+/* The kernel doesn't save vector registers when it's interrupted,
+ * so it only ever uses the scalar primitives */
+#ifndef LIBC_KERNEL
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+/* Definitions CPUID */
+#define CPUID_FEAT_ECX_OSXSAVE      (1 << 27)
+#define CPUID_FEAT_ECX_AVX          (1 << 28)
+#define CPUID_FEAT_EDX_SSE2         (1 << 26)
+#define CPUID_EXTFEAT_EBX_AVX2      (1 << 5)
+#define XCR0_SSE_AVX                0x6
+
+/* Primitive target attributes, the primitives are compiled for their own
+ * instruction set no matter what the rest of the library targets */
+#define STRINGOPS_SSE2_TARGET       __attribute__((target("sse2")))
+#define STRINGOPS_AVX2_TARGET       __attribute__((target("avx2")))
+
+/* Definitions
+ * Vector loads of strings must not cross into the next page */
+#define STRINGOPS_PAGE_SIZE         4096
+#define STRINGOPS_CROSSES_PAGE(Pointer, Size) \
+	((((uintptr_t)(Pointer)) & (STRINGOPS_PAGE_SIZE - 1)) > (STRINGOPS_PAGE_SIZE - (Size)))
+
+/* Unaligned scalar access for the short copies */
+typedef uint32_t __attribute__((__may_alias__, __aligned__(1))) Unaligned32_t;
+
+/* CopySmall
+ * Copies up to 32 bytes, everything is read before anything is written
+ * so the areas are allowed to overlap */
+STRINGOPS_SSE2_TARGET
+static inline void CopySmall(uint8_t *Destination, const uint8_t *Source, size_t Count)
+{
+	if (Count >= 16) {
+		__m128i Head = _mm_loadu_si128((const __m128i*)Source);
+		__m128i Tail = _mm_loadu_si128((const __m128i*)(Source + Count - 16));
+		_mm_storeu_si128((__m128i*)Destination, Head);
+		_mm_storeu_si128((__m128i*)(Destination + Count - 16), Tail);
+	}
+	else if (Count >= 8) {
+		__m128i Head = _mm_loadl_epi64((const __m128i*)Source);
+		__m128i Tail = _mm_loadl_epi64((const __m128i*)(Source + Count - 8));
+		_mm_storel_epi64((__m128i*)Destination, Head);
+		_mm_storel_epi64((__m128i*)(Destination + Count - 8), Tail);
+	}
+	else if (Count >= 4) {
+		uint32_t Head = *(const Unaligned32_t*)Source;
+		uint32_t Tail = *(const Unaligned32_t*)(Source + Count - 4);
+		*(Unaligned32_t*)Destination = Head;
+		*(Unaligned32_t*)(Destination + Count - 4) = Tail;
+	}
+	else if (Count != 0) {
+		uint8_t First = Source[0], Middle = Source[Count >> 1], Last = Source[Count - 1];
+		Destination[0] = First;
+		Destination[Count >> 1] = Middle;
+		Destination[Count - 1] = Last;
+	}
+}
+
+/* SetSmall
+ * Sets up to 32 bytes */
+STRINGOPS_SSE2_TARGET
+static inline void SetSmall(uint8_t *Destination, __m128i Value, size_t Count)
+{
+	if (Count >= 16) {
+		_mm_storeu_si128((__m128i*)Destination, Value);
+		_mm_storeu_si128((__m128i*)(Destination + Count - 16), Value);
+	}
+	else if (Count >= 8) {
+		_mm_storel_epi64((__m128i*)Destination, Value);
+		_mm_storel_epi64((__m128i*)(Destination + Count - 8), Value);
+	}
+	else if (Count >= 4) {
+		uint32_t Word = (uint32_t)_mm_cvtsi128_si32(Value);
+		*(Unaligned32_t*)Destination = Word;
+		*(Unaligned32_t*)(Destination + Count - 4) = Word;
+	}
+	else if (Count != 0) {
+		uint8_t Byte = (uint8_t)_mm_cvtsi128_si32(Value);
+		Destination[0] = Byte;
+		Destination[Count >> 1] = Byte;
+		Destination[Count - 1] = Byte;
+	}
+}
+
+/* SSE2 Primitives
+ * 16 bytes per vector, copies and sets align the destination */
+STRINGOPS_SSE2_TARGET
+static void *MemcpySse2(void *Destination, const void *Source, size_t Count)
+{
+	uint8_t *Dst = (uint8_t*)Destination;
+	const uint8_t *Src = (const uint8_t*)Source;
+	if (Count <= 32) {
+		CopySmall(Dst, Src, Count);
+		return Destination;
+	}
+
+	// The unaligned head and tail are stored last, that makes this
+	// safe for overlapping areas as long as the destination is lower
+	__m128i Head = _mm_loadu_si128((const __m128i*)Src);
+	__m128i Tail = _mm_loadu_si128((const __m128i*)(Src + Count - 16));
+	size_t Skip = 16 - ((uintptr_t)Dst & 15);
+	uint8_t *End = Dst + Count;
+	Dst += Skip;
+	Src += Skip;
+	Count -= Skip;
+	while (Count >= 64) {
+		__m128i A = _mm_loadu_si128((const __m128i*)Src);
+		__m128i B = _mm_loadu_si128((const __m128i*)(Src + 16));
+		__m128i C = _mm_loadu_si128((const __m128i*)(Src + 32));
+		__m128i D = _mm_loadu_si128((const __m128i*)(Src + 48));
+		_mm_store_si128((__m128i*)Dst, A);
+		_mm_store_si128((__m128i*)(Dst + 16), B);
+		_mm_store_si128((__m128i*)(Dst + 32), C);
+		_mm_store_si128((__m128i*)(Dst + 48), D);
+		Dst += 64;
+		Src += 64;
+		Count -= 64;
+	}
+	while (Count >= 16) {
+		_mm_store_si128((__m128i*)Dst, _mm_loadu_si128((const __m128i*)Src));
+		Dst += 16;
+		Src += 16;
+		Count -= 16;
+	}
+	_mm_storeu_si128((__m128i*)(End - 16), Tail);
+	_mm_storeu_si128((__m128i*)Destination, Head);
+	return Destination;
+}
+
+STRINGOPS_SSE2_TARGET
+static void *MemmoveSse2(void *Destination, const void *Source, size_t Count)
+{
+	uint8_t *Dst = (uint8_t*)Destination;
+	const uint8_t *Src = (const uint8_t*)Source;
+	if ((uintptr_t)Dst - (uintptr_t)Src >= Count) {
+		return MemcpySse2(Destination, Source, Count);
+	}
+	if (Count <= 32) {
+		CopySmall(Dst, Src, Count);
+		return Destination;
+	}
+
+	// Destination is above the source, copy backwards from
+	// an aligned end of the destination
+	__m128i Head = _mm_loadu_si128((const __m128i*)Src);
+	__m128i Tail = _mm_loadu_si128((const __m128i*)(Src + Count - 16));
+	size_t Cut = (uintptr_t)(Dst + Count) & 15;
+	uint8_t *DstEnd, *TailAt = Dst + Count - 16;
+	const uint8_t *SrcEnd;
+	if (Cut == 0) {
+		Cut = 16;
+	}
+	DstEnd = Dst + Count - Cut;
+	SrcEnd = Src + Count - Cut;
+	Count -= Cut;
+	while (Count >= 64) {
+		__m128i A = _mm_loadu_si128((const __m128i*)(SrcEnd - 16));
+		__m128i B = _mm_loadu_si128((const __m128i*)(SrcEnd - 32));
+		__m128i C = _mm_loadu_si128((const __m128i*)(SrcEnd - 48));
+		__m128i D = _mm_loadu_si128((const __m128i*)(SrcEnd - 64));
+		_mm_store_si128((__m128i*)(DstEnd - 16), A);
+		_mm_store_si128((__m128i*)(DstEnd - 32), B);
+		_mm_store_si128((__m128i*)(DstEnd - 48), C);
+		_mm_store_si128((__m128i*)(DstEnd - 64), D);
+		DstEnd -= 64;
+		SrcEnd -= 64;
+		Count -= 64;
+	}
+	while (Count >= 16) {
+		_mm_store_si128((__m128i*)(DstEnd - 16), _mm_loadu_si128((const __m128i*)(SrcEnd - 16)));
+		DstEnd -= 16;
+		SrcEnd -= 16;
+		Count -= 16;
+	}
+	_mm_storeu_si128((__m128i*)Dst, Head);
+	_mm_storeu_si128((__m128i*)TailAt, Tail);
+	return Destination;
+}
+
+STRINGOPS_SSE2_TARGET
+static void *MemsetSse2(void *Destination, int Value, size_t Count)
+{
+	uint8_t *Dst = (uint8_t*)Destination;
+	__m128i Fill = _mm_set1_epi8((char)Value);
+	if (Count <= 32) {
+		SetSmall(Dst, Fill, Count);
+		return Destination;
+	}
+
+	uint8_t *End = Dst + Count;
+	_mm_storeu_si128((__m128i*)Dst, Fill);
+	_mm_storeu_si128((__m128i*)(End - 16), Fill);
+	Dst = (uint8_t*)(((uintptr_t)Dst + 16) & ~(uintptr_t)15);
+	while ((size_t)(End - Dst) >= 64) {
+		_mm_store_si128((__m128i*)Dst, Fill);
+		_mm_store_si128((__m128i*)(Dst + 16), Fill);
+		_mm_store_si128((__m128i*)(Dst + 32), Fill);
+		_mm_store_si128((__m128i*)(Dst + 48), Fill);
+		Dst += 64;
+	}
+	while ((size_t)(End - Dst) >= 16) {
+		_mm_store_si128((__m128i*)Dst, Fill);
+		Dst += 16;
+	}
+	return Destination;
+}
+
+STRINGOPS_SSE2_TARGET
+static int MemcmpSse2(const void *First, const void *Second, size_t Count)
+{
+	const uint8_t *A = (const uint8_t*)First;
+	const uint8_t *B = (const uint8_t*)Second;
+	while (Count >= 16) {
+		unsigned Mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(
+			_mm_loadu_si128((const __m128i*)A), _mm_loadu_si128((const __m128i*)B)));
+		if (Mask != 0xFFFF) {
+			unsigned Index = (unsigned)__builtin_ctz(~Mask);
+			return A[Index] - B[Index];
+		}
+		A += 16;
+		B += 16;
+		Count -= 16;
+	}
+	while (Count--) {
+		if (*A != *B) {
+			return *A - *B;
+		}
+		A++;
+		B++;
+	}
+	return 0;
+}
+
+STRINGOPS_SSE2_TARGET
+static void *MemchrSse2(const void *Source, int Value, size_t Count)
+{
+	const uint8_t *Src = (const uint8_t*)Source;
+	__m128i Needle = _mm_set1_epi8((char)Value);
+	while (Count >= 16) {
+		unsigned Mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(
+			_mm_loadu_si128((const __m128i*)Src), Needle));
+		if (Mask != 0) {
+			return (void*)(Src + __builtin_ctz(Mask));
+		}
+		Src += 16;
+		Count -= 16;
+	}
+	while (Count--) {
+		if (*Src == (uint8_t)Value) {
+			return (void*)Src;
+		}
+		Src++;
+	}
+	return NULL;
+}
+
+STRINGOPS_SSE2_TARGET
+static size_t StrlenSse2(const char *String)
+{
+	// Aligned loads never cross a page, the bytes before the
+	// string are shifted out of the first mask
+	const char *Block = (const char*)((uintptr_t)String & ~(uintptr_t)15);
+	__m128i Zero = _mm_setzero_si128();
+	unsigned Mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(
+		_mm_load_si128((const __m128i*)Block), Zero)) >> ((uintptr_t)String & 15);
+	if (Mask != 0) {
+		return (size_t)__builtin_ctz(Mask);
+	}
+	for (;;) {
+		Block += 16;
+		Mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*)Block), Zero));
+		if (Mask != 0) {
+			return (size_t)(Block - String) + __builtin_ctz(Mask);
+		}
+	}
+}
+
+STRINGOPS_SSE2_TARGET
+static char *StrchrSse2(const char *String, int Value)
+{
+	const char *Block = (const char*)((uintptr_t)String & ~(uintptr_t)15);
+	__m128i Zero = _mm_setzero_si128();
+	__m128i Needle = _mm_set1_epi8((char)Value);
+	__m128i Data = _mm_load_si128((const __m128i*)Block);
+	unsigned Mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(
+		_mm_cmpeq_epi8(Data, Zero), _mm_cmpeq_epi8(Data, Needle))) >> ((uintptr_t)String & 15);
+	const char *Found = String;
+	if (Mask == 0) {
+		for (;;) {
+			Block += 16;
+			Data = _mm_load_si128((const __m128i*)Block);
+			Mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(
+				_mm_cmpeq_epi8(Data, Zero), _mm_cmpeq_epi8(Data, Needle)));
+			if (Mask != 0) {
+				Found = Block;
+				break;
+			}
+		}
+	}
+	Found += __builtin_ctz(Mask);
+	return (*Found == (char)Value) ? (char*)Found : NULL;
+}
+
+STRINGOPS_SSE2_TARGET
+static int StrcmpSse2(const char *First, const char *Second)
+{
+	const uint8_t *A = (const uint8_t*)First;
+	const uint8_t *B = (const uint8_t*)Second;
+	__m128i Zero = _mm_setzero_si128();
+	for (;;) {
+		// Near the end of a page the next page might not be
+		// mapped, those bytes are compared one at a time
+		if (STRINGOPS_CROSSES_PAGE(A, 16) || STRINGOPS_CROSSES_PAGE(B, 16)) {
+			for (int i = 0; i < 16; i++) {
+				if (A[i] != B[i] || A[i] == 0) {
+					return A[i] - B[i];
+				}
+			}
+		}
+		else {
+			__m128i DataA = _mm_loadu_si128((const __m128i*)A);
+			__m128i DataB = _mm_loadu_si128((const __m128i*)B);
+			unsigned Mask = ((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(DataA, DataB)) ^ 0xFFFF)
+				| (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(DataA, Zero));
+			if (Mask != 0) {
+				unsigned Index = (unsigned)__builtin_ctz(Mask);
+				return A[Index] - B[Index];
+			}
+		}
+		A += 16;
+		B += 16;
+	}
+}
+
+/* AVX2 Primitives
+ * 32 bytes per vector, short inputs are handled by the SSE2 primitives */
+STRINGOPS_AVX2_TARGET
+static void *MemcpyAvx2(void *Destination, const void *Source, size_t Count)
+{
+	uint8_t *Dst = (uint8_t*)Destination;
+	const uint8_t *Src = (const uint8_t*)Source;
+	if (Count <= 64) {
+		if (Count <= 32) {
+			CopySmall(Dst, Src, Count);
+		}
+		else {
+			__m256i Head = _mm256_loadu_si256((const __m256i*)Src);
+			__m256i Tail = _mm256_loadu_si256((const __m256i*)(Src + Count - 32));
+			_mm256_storeu_si256((__m256i*)Dst, Head);
+			_mm256_storeu_si256((__m256i*)(Dst + Count - 32), Tail);
+		}
+		return Destination;
+	}
+
+	__m256i Head = _mm256_loadu_si256((const __m256i*)Src);
+	__m256i Tail = _mm256_loadu_si256((const __m256i*)(Src + Count - 32));
+	size_t Skip = 32 - ((uintptr_t)Dst & 31);
+	uint8_t *End = Dst + Count;
+	Dst += Skip;
+	Src += Skip;
+	Count -= Skip;
+	while (Count >= 128) {
+		__m256i A = _mm256_loadu_si256((const __m256i*)Src);
+		__m256i B = _mm256_loadu_si256((const __m256i*)(Src + 32));
+		__m256i C = _mm256_loadu_si256((const __m256i*)(Src + 64));
+		__m256i D = _mm256_loadu_si256((const __m256i*)(Src + 96));
+		_mm256_store_si256((__m256i*)Dst, A);
+		_mm256_store_si256((__m256i*)(Dst + 32), B);
+		_mm256_store_si256((__m256i*)(Dst + 64), C);
+		_mm256_store_si256((__m256i*)(Dst + 96), D);
+		Dst += 128;
+		Src += 128;
+		Count -= 128;
+	}
+	while (Count >= 32) {
+		_mm256_store_si256((__m256i*)Dst, _mm256_loadu_si256((const __m256i*)Src));
+		Dst += 32;
+		Src += 32;
+		Count -= 32;
+	}
+	_mm256_storeu_si256((__m256i*)(End - 32), Tail);
+	_mm256_storeu_si256((__m256i*)Destination, Head);
+	return Destination;
+}
+
+STRINGOPS_AVX2_TARGET
+static void *MemmoveAvx2(void *Destination, const void *Source, size_t Count)
+{
+	uint8_t *Dst = (uint8_t*)Destination;
+	const uint8_t *Src = (const uint8_t*)Source;
+	if ((uintptr_t)Dst - (uintptr_t)Src >= Count || Count <= 64) {
+		return MemcpyAvx2(Destination, Source, Count);
+	}
+
+	__m256i Head = _mm256_loadu_si256((const __m256i*)Src);
+	__m256i Tail = _mm256_loadu_si256((const __m256i*)(Src + Count - 32));
+	size_t Cut = (uintptr_t)(Dst + Count) & 31;
+	uint8_t *DstEnd, *TailAt = Dst + Count - 32;
+	const uint8_t *SrcEnd;
+	if (Cut == 0) {
+		Cut = 32;
+	}
+	DstEnd = Dst + Count - Cut;
+	SrcEnd = Src + Count - Cut;
+	Count -= Cut;
+	while (Count >= 128) {
+		__m256i A = _mm256_loadu_si256((const __m256i*)(SrcEnd - 32));
+		__m256i B = _mm256_loadu_si256((const __m256i*)(SrcEnd - 64));
+		__m256i C = _mm256_loadu_si256((const __m256i*)(SrcEnd - 96));
+		__m256i D = _mm256_loadu_si256((const __m256i*)(SrcEnd - 128));
+		_mm256_store_si256((__m256i*)(DstEnd - 32), A);
+		_mm256_store_si256((__m256i*)(DstEnd - 64), B);
+		_mm256_store_si256((__m256i*)(DstEnd - 96), C);
+		_mm256_store_si256((__m256i*)(DstEnd - 128), D);
+		DstEnd -= 128;
+		SrcEnd -= 128;
+		Count -= 128;
+	}
+	while (Count >= 32) {
+		_mm256_store_si256((__m256i*)(DstEnd - 32), _mm256_loadu_si256((const __m256i*)(SrcEnd - 32)));
+		DstEnd -= 32;
+		SrcEnd -= 32;
+		Count -= 32;
+	}
+	_mm256_storeu_si256((__m256i*)Dst, Head);
+	_mm256_storeu_si256((__m256i*)TailAt, Tail);
+	return Destination;
+}
+
+STRINGOPS_AVX2_TARGET
+static void *MemsetAvx2(void *Destination, int Value, size_t Count)
+{
+	uint8_t *Dst = (uint8_t*)Destination;
+	if (Count <= 64) {
+		return MemsetSse2(Destination, Value, Count);
+	}
+
+	__m256i Fill = _mm256_set1_epi8((char)Value);
+	uint8_t *End = Dst + Count;
+	_mm256_storeu_si256((__m256i*)Dst, Fill);
+	_mm256_storeu_si256((__m256i*)(End - 32), Fill);
+	Dst = (uint8_t*)(((uintptr_t)Dst + 32) & ~(uintptr_t)31);
+	while ((size_t)(End - Dst) >= 128) {
+		_mm256_store_si256((__m256i*)Dst, Fill);
+		_mm256_store_si256((__m256i*)(Dst + 32), Fill);
+		_mm256_store_si256((__m256i*)(Dst + 64), Fill);
+		_mm256_store_si256((__m256i*)(Dst + 96), Fill);
+		Dst += 128;
+	}
+	while ((size_t)(End - Dst) >= 32) {
+		_mm256_store_si256((__m256i*)Dst, Fill);
+		Dst += 32;
+	}
+	return Destination;
+}
+
+STRINGOPS_AVX2_TARGET
+static int MemcmpAvx2(const void *First, const void *Second, size_t Count)
+{
+	const uint8_t *A = (const uint8_t*)First;
+	const uint8_t *B = (const uint8_t*)Second;
+	while (Count >= 32) {
+		unsigned Mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+			_mm256_loadu_si256((const __m256i*)A), _mm256_loadu_si256((const __m256i*)B)));
+		if (Mask != 0xFFFFFFFF) {
+			unsigned Index = (unsigned)__builtin_ctz(~Mask);
+			return A[Index] - B[Index];
+		}
+		A += 32;
+		B += 32;
+		Count -= 32;
+	}
+	return MemcmpSse2(A, B, Count);
+}
+
+STRINGOPS_AVX2_TARGET
+static void *MemchrAvx2(const void *Source, int Value, size_t Count)
+{
+	const uint8_t *Src = (const uint8_t*)Source;
+	__m256i Needle = _mm256_set1_epi8((char)Value);
+	while (Count >= 32) {
+		unsigned Mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+			_mm256_loadu_si256((const __m256i*)Src), Needle));
+		if (Mask != 0) {
+			return (void*)(Src + __builtin_ctz(Mask));
+		}
+		Src += 32;
+		Count -= 32;
+	}
+	return MemchrSse2(Src, Value, Count);
+}
+
+STRINGOPS_AVX2_TARGET
+static size_t StrlenAvx2(const char *String)
+{
+	const char *Block = (const char*)((uintptr_t)String & ~(uintptr_t)31);
+	__m256i Zero = _mm256_setzero_si256();
+	unsigned Mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+		_mm256_load_si256((const __m256i*)Block), Zero)) >> ((uintptr_t)String & 31);
+	if (Mask != 0) {
+		return (size_t)__builtin_ctz(Mask);
+	}
+	for (;;) {
+		Block += 32;
+		Mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i*)Block), Zero));
+		if (Mask != 0) {
+			return (size_t)(Block - String) + __builtin_ctz(Mask);
+		}
+	}
+}
+
+STRINGOPS_AVX2_TARGET
+static char *StrchrAvx2(const char *String, int Value)
+{
+	const char *Block = (const char*)((uintptr_t)String & ~(uintptr_t)31);
+	__m256i Zero = _mm256_setzero_si256();
+	__m256i Needle = _mm256_set1_epi8((char)Value);
+	__m256i Data = _mm256_load_si256((const __m256i*)Block);
+	unsigned Mask = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(
+		_mm256_cmpeq_epi8(Data, Zero), _mm256_cmpeq_epi8(Data, Needle))) >> ((uintptr_t)String & 31);
+	const char *Found = String;
+	if (Mask == 0) {
+		for (;;) {
+			Block += 32;
+			Data = _mm256_load_si256((const __m256i*)Block);
+			Mask = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(
+				_mm256_cmpeq_epi8(Data, Zero), _mm256_cmpeq_epi8(Data, Needle)));
+			if (Mask != 0) {
+				Found = Block;
+				break;
+			}
+		}
+	}
+	Found += __builtin_ctz(Mask);
+	return (*Found == (char)Value) ? (char*)Found : NULL;
+}
+
+STRINGOPS_AVX2_TARGET
+static int StrcmpAvx2(const char *First, const char *Second)
+{
+	const uint8_t *A = (const uint8_t*)First;
+	const uint8_t *B = (const uint8_t*)Second;
+	__m256i Zero = _mm256_setzero_si256();
+	for (;;) {
+		if (STRINGOPS_CROSSES_PAGE(A, 32) || STRINGOPS_CROSSES_PAGE(B, 32)) {
+			for (int i = 0; i < 32; i++) {
+				if (A[i] != B[i] || A[i] == 0) {
+					return A[i] - B[i];
+				}
+			}
+		}
+		else {
+			__m256i DataA = _mm256_loadu_si256((const __m256i*)A);
+			__m256i DataB = _mm256_loadu_si256((const __m256i*)B);
+			unsigned Mask = ~(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(DataA, DataB))
+				| (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(DataA, Zero));
+			if (Mask != 0) {
+				unsigned Index = (unsigned)__builtin_ctz(Mask);
+				return A[Index] - B[Index];
+			}
+		}
+		A += 32;
+		B += 32;
+	}
+}
+
+/* Globals
+ * The primitive tables and the current selection */
+static const StringOperations_t GlbStringOperationsTable[] = {
+	{ STRINGOPS_SCALAR, "scalar", memcpy_base, memmove_base, memset_base, memcmp_base,
+		memchr_base, strlen_base, strchr_base, strcmp_base },
+	{ STRINGOPS_SSE2, "sse2", MemcpySse2, MemmoveSse2, MemsetSse2, MemcmpSse2,
+		MemchrSse2, StrlenSse2, StrchrSse2, StrcmpSse2 },
+	{ STRINGOPS_AVX2, "avx2", MemcpyAvx2, MemmoveAvx2, MemsetAvx2, MemcmpAvx2,
+		MemchrAvx2, StrlenAvx2, StrchrAvx2, StrcmpAvx2 }
+};
+const StringOperations_t *__GlbStringOperations = &GlbStringOperationsTable[STRINGOPS_SCALAR];
+
+/* StringOperationsQueryLevel
+ * Queries the highest level supported by the cpu, AVX2 also requires the
+ * operating system to have enabled the ymm state in XCR0 */
+static int StringOperationsQueryLevel(void)
+{
+	unsigned int Eax = 0, Ebx = 0, Ecx = 0, Edx = 0;
+	unsigned int XcrLow = 0, XcrHigh = 0;
+	int Level = STRINGOPS_SCALAR;
+
+	if (!__get_cpuid(1, &Eax, &Ebx, &Ecx, &Edx)) {
+		return Level;
+	}
+	if (Edx & CPUID_FEAT_EDX_SSE2) {
+		Level = STRINGOPS_SSE2;
+	}
+	if ((Ecx & CPUID_FEAT_ECX_OSXSAVE) && (Ecx & CPUID_FEAT_ECX_AVX)
+		&& __get_cpuid_max(0, NULL) >= 7) {
+		__asm__ __volatile__("xgetbv" : "=a"(XcrLow), "=d"(XcrHigh) : "c"(0));
+		__cpuid_count(7, 0, Eax, Ebx, Ecx, Edx);
+		if ((XcrLow & XCR0_SSE_AVX) == XCR0_SSE_AVX && (Ebx & CPUID_EXTFEAT_EBX_AVX2)) {
+			Level = STRINGOPS_AVX2;
+		}
+	}
+	return Level;
+}
+
+/* StringOperationsInitialize
+ * Selects the best primitives for the cpu by cpuid, called by the
+ * runtime before anything else */
+void
+StringOperationsInitialize(void)
+{
+	__GlbStringOperations = &GlbStringOperationsTable[StringOperationsQueryLevel()];
+}
+
+/* StringOperationsSelect
+ * Overrides the primitives with the given level, used for benchmarking. Returns
+ * NULL if the cpu does not support the level. */
+const StringOperations_t*
+StringOperationsSelect(
+	_In_ int Level)
+{
+	if (Level < STRINGOPS_SCALAR || Level > StringOperationsQueryLevel()) {
+		return NULL;
+	}
+	__GlbStringOperations = &GlbStringOperationsTable[Level];
+	return __GlbStringOperations;
+}
+
+#endif //!LIBC_KERNEL
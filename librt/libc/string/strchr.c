@@ -35,6 +35,7 @@ QUICKREF
 
 #include <stddef.h>
 #include <string.h>
+#include <internal/_stringops.h>
 #include <limits.h>
 
 /* Nonzero if X is not aligned on a "long" boundary.  */
@@ -58,7 +59,7 @@ QUICKREF
    to fill (long)MASK. */
 #define DETECTCHAR(X,MASK) (DETECTNULL(X ^ MASK))
 
-char *strchr(const char *s1, int i)
+char *strchr_base(const char *s1, int i)
 {
 	const unsigned char *s = (const unsigned char *)s1;
 	unsigned char c = (unsigned char)i;
@@ -114,3 +115,12 @@ char *strchr(const char *s1, int i)
 		return (char *)s;
 	return NULL;
 }
+
+char *strchr(const char *s1, int i)
+{
+#ifdef LIBC_KERNEL
+	return strchr_base(s1, i);
+#else
+	return __GlbStringOperations->Strchr(s1, i);
+#endif
+}
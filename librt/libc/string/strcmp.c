@@ -4,6 +4,7 @@
  */
 
 #include <string.h>
+#include <internal/_stringops.h>
 #include <internal/_string.h>
 #include <limits.h>
 
@@ -18,11 +19,7 @@
 #endif
 #endif
 
-#if defined(_MSC_VER) && !defined(__clang__)
-#pragma function(strcmp)
-#endif
-
-int strcmp(const char* str1, const char* str2)
+int strcmp_base(const char* str1, const char* str2)
 {
 	unsigned long *a1;
 	unsigned long *a2;
@@ -57,6 +54,19 @@ int strcmp(const char* str1, const char* str2)
 	return (*(unsigned char *) str1) - (*(unsigned char *) str2);
 }
 
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma function(strcmp)
+#endif
+
+int strcmp(const char* str1, const char* str2)
+{
+#ifdef LIBC_KERNEL
+	return strcmp_base(str1, str2);
+#else
+	return __GlbStringOperations->Strcmp(str1, str2);
+#endif
+}
+
 //Old
 //for(; *str1 == *str2; ++str1, ++str2)
 //	if(*str1 == 0)
@@ -4,6 +4,7 @@
  */
 
 #include <string.h>
+#include <internal/_stringops.h>
 #include <stdint.h>
 #include <limits.h>
 
@@ -25,11 +26,7 @@
 #error long int is not a 32bit or 64bit byte
 #endif
 
-#if defined(_MSC_VER) && !defined(__clang__)
-#pragma function(strlen)
-#endif
-
-size_t strlen(const char *str)
+size_t strlen_base(const char *str)
 {
 	const char *start = str;
 	unsigned long *aligned_addr;
@@ -56,4 +53,17 @@ size_t strlen(const char *str)
 		str++;
 
 	return str - start;
-}
\ No newline at end of file
+}
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma function(strlen)
+#endif
+
+size_t strlen(const char *str)
+{
+#ifdef LIBC_KERNEL
+	return strlen_base(str);
+#else
+	return __GlbStringOperations->Strlen(str);
+#endif
+}
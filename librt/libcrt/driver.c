@@ -27,6 +27,7 @@
 
 /* Includes
  * - Library */
+#include <internal/_stringops.h>
 #include <stdlib.h>
 
 /* Extern
@@ -48,6 +49,9 @@ StdioInitialize(void);
  * for a shared C/C++ environment call this in all entry points */
  void _mCrtInit(ThreadLocalStorage_t *Tls)
  {
+	 // Select the memory and string primitives for this cpu
+	 StringOperationsInitialize();
+
 	 // Initialize C/CPP
 	 __CppInit();
  
@@ -29,6 +29,7 @@
 /* Includes 
  * - Library */
 #include <stddef.h>
+#include <internal/_stringops.h>
 #include <stdlib.h>
 #include <ctype.h>
 
@@ -162,6 +163,9 @@ __CrtInitialize(
     ProcessStartupInformation_t StartupInformation;
 	char **Arguments            = NULL;
 
+	// Select the memory and string primitives for this cpu
+	StringOperationsInitialize();
+
 	// Initialize C/CPP
 	__CppInit();
  
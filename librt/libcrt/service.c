@@ -21,8 +21,10 @@
 
 /* Includes 
  * - System */
-#include <os/threadpool.h>
+#include <os/condition.h>
 #include <os/mollenos.h>
+#include <os/mutex.h>
+#include <os/thread.h>
 
 /* Includes
  * - Driver */
@@ -30,6 +32,7 @@
 
 /* Includes
  * - Library */
+#include <internal/_stringops.h>
 #include <stdlib.h>
 
 /* Extern
@@ -51,6 +54,9 @@ StdioInitialize(void);
  * for a shared C/C++ environment call this in all entry points */
 void _mCrtInit(ThreadLocalStorage_t *Tls)
 {
+	// Select the memory and string primitives for this cpu
+	StringOperationsInitialize();
+
 	// Initialize C/CPP
 	__CppInit();
 
@@ -67,19 +73,217 @@ void _mCrtInit(ThreadLocalStorage_t *Tls)
 #endif
 }
 
-/* Server event entry point
- * Used in multi-threading environment as means to cleanup
- * all allocated resources properly */
-int _mDrvEvent(void *Argument)
+/* ServiceWorker (Private)
+ * A worker handles the events routed to it in the order they were
+ * received, the queue is a fixed ring and the listener waits when it's full */
+#define SERVICE_WORKER_QUEUE        64
+typedef struct _ServiceWorker {
+	UUId_t					Thread;
+	int						Running;
+	Mutex_t					Lock;
+	Condition_t				HasWork;
+	Condition_t				HasRoom;
+	size_t					Head;
+	size_t					Count;
+	MRemoteCall_t			*Queue[SERVICE_WORKER_QUEUE];
+} ServiceWorker_t;
+
+/* Globals
+ * Dispatch configuration set by the service in OnLoad */
+static int GlbServiceWorkerCount = 1;
+static signed char GlbServiceAffinity[SERVICE_MAX_FUNCTIONS] = { 0 };
+static ServiceWorker_t *GlbServiceWorkers = NULL;
+static size_t GlbServiceNextWorker = 0;
+
+/* ServiceSetWorkers
+ * Sets the number of workers that handle events for the service, must
+ * be called from OnLoad. A single worker keeps events on the main thread */
+OsStatus_t
+ServiceSetWorkers(
+	_In_ int Workers)
+{
+	if (Workers < 1 || Workers > SERVICE_MAX_WORKERS) {
+		return OsError;
+	}
+	GlbServiceWorkerCount = Workers;
+	return OsSuccess;
+}
+
+/* ServiceSetAffinity
+ * Declares which part of a message with the given function that decides
+ * the worker it is handled by, e.g. the argument that holds a file handle.
+ * Must be called from OnLoad */
+OsStatus_t
+ServiceSetAffinity(
+	_In_ int Function,
+	_In_ int Affinity)
+{
+	if (Function < 0 || Function >= SERVICE_MAX_FUNCTIONS
+		|| Affinity < SERVICE_AFFINITY_SENDER
+		|| Affinity > SERVICE_AFFINITY_ARGUMENT(IPC_MAX_ARGUMENTS - 1)) {
+		return OsError;
+	}
+	GlbServiceAffinity[Function] = (signed char)Affinity;
+	return OsSuccess;
+}
+
+/* ServiceGetWorker (Private)
+ * Hashes the affinity key of the message to a worker, buffer arguments
+ * are hashed by their content so equal paths go to the same worker */
+static ServiceWorker_t*
+ServiceGetWorker(
+	_In_ MRemoteCall_t *Message)
+{
+	// Variables
+	RPCArgument_t *Argument = NULL;
+	int Affinity = SERVICE_AFFINITY_SERIAL;
+	size_t Key = 0;
+	size_t i;
+
+	if (Message->Function >= 0 && Message->Function < SERVICE_MAX_FUNCTIONS) {
+		Affinity = GlbServiceAffinity[Message->Function];
+	}
+
+	switch (Affinity) {
+		case SERVICE_AFFINITY_SERIAL: {
+			return &GlbServiceWorkers[0];
+		}
+		case SERVICE_AFFINITY_NONE: {
+			return &GlbServiceWorkers[GlbServiceNextWorker++ % GlbServiceWorkerCount];
+		}
+		case SERVICE_AFFINITY_SENDER: {
+			Key = (size_t)Message->Sender;
+		} break;
+		default: {
+			Argument = &Message->Arguments[Affinity - SERVICE_AFFINITY_ARGUMENT(0)];
+			if (Argument->Type == ARGUMENT_REGISTER) {
+				Key = Argument->Data.Value;
+			}
+			else if (Argument->Type == ARGUMENT_BUFFER) {
+				Key = 5381;
+				for (i = 0; i < Argument->Length; i++) {
+					Key = (Key * 33) + ((__CONST uint8_t*)Argument->Data.Buffer)[i];
+				}
+			}
+		} break;
+	}
+
+	// Mix the key so handles that are multiples of the
+	// worker count still spread
+	Key = (Key ^ (Key >> 16)) * 0x45D9F3B;
+	Key = Key ^ (Key >> 16);
+	return &GlbServiceWorkers[Key % (size_t)GlbServiceWorkerCount];
+}
+
+/* ServiceWorkerEntry (Private)
+ * Handles events from the queue of the worker until the
+ * worker is stopped and the queue is empty */
+static int
+ServiceWorkerEntry(
+	_In_ void *Argument)
+{
+	// Variables
+	ServiceWorker_t *Worker = (ServiceWorker_t*)Argument;
+	MRemoteCall_t *Message = NULL;
+
+	while (1) {
+		MutexLock(&Worker->Lock);
+		while (Worker->Count == 0 && Worker->Running) {
+			ConditionWait(&Worker->HasWork, &Worker->Lock);
+		}
+		if (Worker->Count == 0) {
+			MutexUnlock(&Worker->Lock);
+			break;
+		}
+		Message = Worker->Queue[Worker->Head];
+		Worker->Head = (Worker->Head + 1) % SERVICE_WORKER_QUEUE;
+		Worker->Count--;
+		ConditionSignal(&Worker->HasRoom);
+		MutexUnlock(&Worker->Lock);
+
+		OnEvent(Message);
+		RPCRelease(Message);
+	}
+	return 0;
+}
+
+/* ServiceDispatch (Private)
+ * Queues the message on the worker given by its affinity */
+static void
+ServiceDispatch(
+	_In_ MRemoteCall_t *Message)
+{
+	// Variables
+	ServiceWorker_t *Worker = ServiceGetWorker(Message);
+
+	MutexLock(&Worker->Lock);
+	while (Worker->Count == SERVICE_WORKER_QUEUE) {
+		ConditionWait(&Worker->HasRoom, &Worker->Lock);
+	}
+	Worker->Queue[(Worker->Head + Worker->Count) % SERVICE_WORKER_QUEUE] = Message;
+	Worker->Count++;
+	ConditionSignal(&Worker->HasWork);
+	MutexUnlock(&Worker->Lock);
+}
+
+/* ServiceStopWorkers (Private)
+ * Lets the workers finish their queues and waits for them to exit */
+static void
+ServiceStopWorkers(void)
+{
+	// Variables
+	int i;
+
+	for (i = 0; i < GlbServiceWorkerCount; i++) {
+		ServiceWorker_t *Worker = &GlbServiceWorkers[i];
+		MutexLock(&Worker->Lock);
+		Worker->Running = 0;
+		ConditionSignal(&Worker->HasWork);
+		MutexUnlock(&Worker->Lock);
+		ThreadJoin(Worker->Thread);
+		ConditionDestroy(&Worker->HasWork);
+		ConditionDestroy(&Worker->HasRoom);
+		MutexDestruct(&Worker->Lock);
+	}
+	free(GlbServiceWorkers);
+	GlbServiceWorkers = NULL;
+}
+
+/* ServiceStartWorkers (Private)
+ * Creates the worker threads when the service asked for more than one,
+ * if a thread can't be created the workers already started are stopped */
+static OsStatus_t
+ServiceStartWorkers(void)
 {
-	// Initiate the message pointer
-	MRemoteCall_t *Message = (MRemoteCall_t*)Argument;
-	OsStatus_t Result = OnEvent(Message);
-	
-	// Cleanup and return result
-	RPCCleanup(Message);
-	free(Message);
-	return Result == OsSuccess ? 0 : -1;
+	// Variables
+	int Count = GlbServiceWorkerCount;
+	int i;
+
+	GlbServiceWorkers = (ServiceWorker_t*)malloc(
+		GlbServiceWorkerCount * sizeof(ServiceWorker_t));
+	if (GlbServiceWorkers == NULL) {
+		return OsError;
+	}
+	memset((void*)GlbServiceWorkers, 0, GlbServiceWorkerCount * sizeof(ServiceWorker_t));
+
+	for (i = 0; i < Count; i++) {
+		ServiceWorker_t *Worker = &GlbServiceWorkers[i];
+		Worker->Running = 1;
+		MutexConstruct(&Worker->Lock, MUTEX_PLAIN);
+		ConditionConstruct(&Worker->HasWork);
+		ConditionConstruct(&Worker->HasRoom);
+		Worker->Thread = ThreadCreate(ServiceWorkerEntry, Worker);
+		if (Worker->Thread == UUID_INVALID) {
+			ConditionDestroy(&Worker->HasWork);
+			ConditionDestroy(&Worker->HasRoom);
+			MutexDestruct(&Worker->Lock);
+			GlbServiceWorkerCount = i;
+			ServiceStopWorkers();
+			GlbServiceWorkerCount = Count;
+			return OsError;
+		}
+	}
+	return OsSuccess;
 }
 
 /* Server Entry Point
@@ -88,10 +292,8 @@ void _mDrvCrt(void)
 {
 	// Variables
 	ThreadLocalStorage_t Tls;
-	MRemoteCall_t Message;
-#ifdef __SERVER_MULTITHREADED
-	ThreadPool_t *ThreadPool;
-#endif
+	MRemoteCallArena_t *Arena;
+	MRemoteCall_t *Message;
 	int IsRunning = 1;
 
 	// Initialize environment
@@ -108,45 +310,45 @@ void _mDrvCrt(void)
 		goto Cleanup;
 	}
 
-	// Initialize threadpool
-#ifdef __SERVER_MULTITHREADED
-	if (ThreadPoolInitialize(THREADPOOL_DEFAULT_WORKERS, 
-		&ThreadPool) != OsSuccess) {
+	// Initialize the message arena
+	if (RPCArenaInitialize(&Arena) != OsSuccess) {
 		OnUnload();
 		goto Cleanup;
 	}
 
-	// Initialize the server event loop
-	while (IsRunning) {
-		if (RPCListen(&Message) == OsSuccess) {
-			MRemoteCall_t *RpcCopy = (MRemoteCall_t*)malloc(sizeof(MRemoteCall_t));
-			memcpy(RpcCopy, &Message, sizeof(MRemoteCall_t));
-			ThreadPoolAddWork(ThreadPool, _mDrvEvent, RpcCopy);
+	// Initialize the workers
+	if (GlbServiceWorkerCount > 1) {
+		if (ServiceStartWorkers() != OsSuccess) {
+			OnUnload();
+			RPCArenaDestroy(Arena);
+			goto Cleanup;
 		}
-		else {}
-	}
-
-	// Wait for threads to finish
-	if (ThreadPoolGetWorkingCount(ThreadPool) != 0) {
-		ThreadPoolWait(ThreadPool);
-	}
 
-	// Destroy thread-pool
-	ThreadPoolDestroy(ThreadPool);
+		// Initialize the server event loop
+		while (IsRunning) {
+			if (RPCListenArena(Arena, &Message) == OsSuccess) {
+				ServiceDispatch(Message);
+			}
+			else {}
+		}
 
-#else
-	// Initialize the server event loop
-	while (IsRunning) {
-		if (RPCListen(&Message) == OsSuccess) {
-			OnEvent(&Message);
-			RPCCleanup(&Message);
+		// Wait for workers to finish
+		ServiceStopWorkers();
+	}
+	else {
+		// Initialize the server event loop
+		while (IsRunning) {
+			if (RPCListenArena(Arena, &Message) == OsSuccess) {
+				OnEvent(Message);
+				RPCRelease(Message);
+			}
+			else {}
 		}
-		else {}
 	}
-#endif
 
 	// Call unload, so driver can cleanup
 	OnUnload();
+	RPCArenaDestroy(Arena);
 
 Cleanup:
 	// Cleanup allocated resources
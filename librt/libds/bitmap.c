@@ -17,6 +17,8 @@
  *
  *
  * MollenOS MCore - Generic Bitmap Implementation
+ * - Bits are set, cleared and searched a word at the time, searches skip
+ *   full words by the summary when the bitmap has one
  */
 
 /* Includes 
@@ -26,10 +28,98 @@
 #include <string.h>
 #include <stddef.h>
 
+/* Bit-scan of a word, the word must not be zero */
+#if __BITS == 64
+#define BITMAP_CTZ(Word)        __builtin_ctzll(Word)
+#else
+#define BITMAP_CTZ(Word)        __builtin_ctz(Word)
+#endif
+
+/* BitmapMask (Private)
+ * Returns a word with <Count> bits set from <Offset>, Count must
+ * be between 1 and the number of bits in a word */
+static uintptr_t
+BitmapMask(
+    _In_ int Offset,
+    _In_ int Count)
+{
+    if (Count >= __BITS) {
+        return __MASK;
+    }
+    return ((((uintptr_t)1) << Count) - 1) << Offset;
+}
+
+/* BitmapValidate (Private)
+ * Validates that the range is inside the bitmap */
+static OsStatus_t
+BitmapValidate(
+    _In_ Bitmap_t *Bitmap,
+    _In_ int Index,
+    _In_ int Count)
+{
+    if (Bitmap == NULL || Index < 0 || Count < 0
+        || (size_t)Index + (size_t)Count > Bitmap->Capacity) {
+        return OsError;
+    }
+    return OsSuccess;
+}
+
+/* BitmapUpdateSummary (Private)
+ * Updates the summary bits of the given words of data */
+static void
+BitmapUpdateSummary(
+    _In_ Bitmap_t *Bitmap,
+    _In_ size_t FirstWord,
+    _In_ size_t LastWord)
+{
+    // Variables
+    uintptr_t Bit;
+    size_t i;
+
+    if (Bitmap->Summary == NULL) {
+        return;
+    }
+    for (i = FirstWord; i <= LastWord; i++) {
+        Bit = ((uintptr_t)1) << (i % __BITS);
+        if (Bitmap->Data[i] == __MASK) {
+            Bitmap->Summary[i / __BITS] |= Bit;
+        }
+        else {
+            Bitmap->Summary[i / __BITS] &= ~Bit;
+        }
+    }
+}
+
+/* BitmapNextWord (Private)
+ * Uses the summary to locate the first word from the given word that is
+ * not full. Returns a word past the data if there is none. */
+static size_t
+BitmapNextWord(
+    _In_ Bitmap_t *Bitmap,
+    _In_ size_t Word)
+{
+    // Variables
+    size_t SummaryWords = BITMAP_SUMMARY_WORDS(Bitmap->SizeInBytes);
+    size_t i = Word / __BITS;
+    uintptr_t NotFull;
+
+    if (i >= SummaryWords) {
+        return Word;
+    }
+    NotFull = ~Bitmap->Summary[i] & (__MASK << (Word % __BITS));
+    while (NotFull == 0) {
+        if (++i == SummaryWords) {
+            return i * __BITS;
+        }
+        NotFull = ~Bitmap->Summary[i];
+    }
+    return (i * __BITS) + BITMAP_CTZ(NotFull);
+}
+
 /* BitmapCreate
  * Creates a bitmap of the given size in bytes, the actual available
  * member count will then be Size * sizeof(byte). This automatically
- * allocates neccessary resources */
+ * allocates neccessary resources, including the summary */
 Bitmap_t*
 BitmapCreate(
     _In_ size_t Size)
@@ -37,18 +127,22 @@ BitmapCreate(
     // Variables
     Bitmap_t *Bitmap = NULL;
     uintptr_t *Data = NULL;
+    uintptr_t *Summary = NULL;
 
     // Sanitize parameters
     if (Size == 0) {
         return NULL;
     }
 
-    // Allocate a new bitmap and associated buffer
+    // Allocate a new bitmap and associated buffers
     Bitmap = (Bitmap_t*)dsalloc(sizeof(Bitmap_t));
-    Data = (uintptr_t*)dsalloc(Size);
+    Data = (uintptr_t*)dsalloc(BITMAP_WORDS(Size) * sizeof(uintptr_t));
+    Summary = (uintptr_t*)dsalloc(BITMAP_SUMMARY_WORDS(Size) * sizeof(uintptr_t));
 
     // Construct the bitmap
-    if (BitmapConstruct(Bitmap, Data, Size) != OsSuccess) {
+    if (BitmapConstruct(Bitmap, Data, Size) != OsSuccess
+        || BitmapConstructSummary(Bitmap, Summary) != OsSuccess) {
+        dsfree((void*)Summary);
         dsfree((void*)Data);
         dsfree((void*)Bitmap);
         return NULL;
@@ -64,7 +158,8 @@ BitmapCreate(
 /* BitmapConstruct
  * Creates a bitmap of the given size in bytes, the actual available
  * member count will then be Size * sizeof(byte). This uses user-provided
- * resources, and won't be cleaned up. */
+ * resources, and won't be cleaned up. Data must have room for
+ * BITMAP_WORDS(Size) words. */
 OsStatus_t
 BitmapConstruct(
     _In_ Bitmap_t *Bitmap,
@@ -77,8 +172,9 @@ BitmapConstruct(
     }
 
     // Fill in data
-    memset(Data, 0, Size);
+    memset(Data, 0, BITMAP_WORDS(Size) * sizeof(uintptr_t));
     Bitmap->Data = Data;
+    Bitmap->Summary = NULL;
     Bitmap->SizeInBytes = Size;
     Bitmap->Cleanup = 0;
     Bitmap->Capacity = (Size * 8);
@@ -87,6 +183,25 @@ BitmapConstruct(
     return OsSuccess;
 }
 
+/* BitmapConstructSummary
+ * Attaches the user-provided summary to the bitmap, it must have room for
+ * BITMAP_SUMMARY_WORDS(SizeInBytes) words and is built from the data. */
+OsStatus_t
+BitmapConstructSummary(
+    _In_ Bitmap_t *Bitmap,
+    _In_ uintptr_t *Summary)
+{
+    // Sanitize parameters
+    if (Bitmap == NULL || Summary == NULL || Bitmap->SizeInBytes == 0) {
+        return OsError;
+    }
+
+    memset(Summary, 0, BITMAP_SUMMARY_WORDS(Bitmap->SizeInBytes) * sizeof(uintptr_t));
+    Bitmap->Summary = Summary;
+    BitmapUpdateSummary(Bitmap, 0, BITMAP_WORDS(Bitmap->SizeInBytes) - 1);
+    return OsSuccess;
+}
+
 /* BitmapDestroy
  * Cleans up any resources allocated by the Create/Construct. */
 OsStatus_t
@@ -100,6 +215,9 @@ BitmapDestroy(
 
     // Should we cleanup bitmap?
     if (Bitmap->Cleanup != 0) {
+        if (Bitmap->Summary != NULL) {
+            dsfree((void*)Bitmap->Summary);
+        }
         dsfree((void*)Bitmap->Data);
         dsfree((void*)Bitmap);
     }
@@ -116,32 +234,27 @@ BitmapSetBits(
     _In_ int Index,
     _In_ int Count)
 {
-    // Calculate the block index first
-    int BlockIndex = Index / (sizeof(uintptr_t) * 8);
-    int BlockOffset = Index % (sizeof(uintptr_t) * 8);
+    // Variables
+    int BlockIndex = Index / __BITS;
+    int BlockOffset = Index % __BITS;
     int BitsLeft = Count;
-    int i, j;
+    int i = BlockIndex, Bits;
 
     // Sanitize parameters
-    if (Bitmap == NULL) {
+    if (BitmapValidate(Bitmap, Index, Count) != OsSuccess) {
         return OsError;
     }
+    if (Count == 0) {
+        return OsSuccess;
+    }
 
-    // Iterate the block and flip bits
-    for (i = BlockIndex; 
-         i < (Bitmap->SizeInBytes / (sizeof(uintptr_t) * 8)) && BitsLeft > 0; 
-         i++) {
-        for (j = BlockOffset; 
-             j < (sizeof(uintptr_t) * 8) && BitsLeft > 0; 
-             j++, BitsLeft--) {
-            Bitmap->Data[i] |= (1 << j);
-        }
-
-        // Reset block offset
-        if (BitsLeft != 0) {
-            BlockOffset = 0;
-        }
+    // Flip the bits a word at the time
+    for (; BitsLeft > 0; i++, BlockOffset = 0) {
+        Bits = MIN(BitsLeft, __BITS - BlockOffset);
+        Bitmap->Data[i] |= BitmapMask(BlockOffset, Bits);
+        BitsLeft -= Bits;
     }
+    BitmapUpdateSummary(Bitmap, BlockIndex, i - 1);
 
     // If we reach here, success
     return OsSuccess;
@@ -155,32 +268,27 @@ BitmapClearBits(
     _In_ int Index,
     _In_ int Count)
 {
-    // Calculate the block index first
-    int BlockIndex = Index / (sizeof(uintptr_t) * 8);
-    int BlockOffset = Index % (sizeof(uintptr_t) * 8);
+    // Variables
+    int BlockIndex = Index / __BITS;
+    int BlockOffset = Index % __BITS;
     int BitsLeft = Count;
-    int i, j;
+    int i = BlockIndex, Bits;
 
     // Sanitize parameters
-    if (Bitmap == NULL) {
+    if (BitmapValidate(Bitmap, Index, Count) != OsSuccess) {
         return OsError;
     }
+    if (Count == 0) {
+        return OsSuccess;
+    }
 
-    // Iterate the block and flip bits
-    for (i = BlockIndex; 
-         i < (Bitmap->SizeInBytes / (sizeof(uintptr_t) * 8)) && BitsLeft > 0; 
-         i++) {
-        for (j = BlockOffset; 
-             j < (sizeof(uintptr_t) * 8) && BitsLeft > 0; 
-             j++, BitsLeft--) {
-            Bitmap->Data[i] &= ~(1 << j);
-        }
-
-        // Reset block offset
-        if (BitsLeft != 0) {
-            BlockOffset = 0;
-        }
+    // Clear the bits a word at the time
+    for (; BitsLeft > 0; i++, BlockOffset = 0) {
+        Bits = MIN(BitsLeft, __BITS - BlockOffset);
+        Bitmap->Data[i] &= ~BitmapMask(BlockOffset, Bits);
+        BitsLeft -= Bits;
     }
+    BitmapUpdateSummary(Bitmap, BlockIndex, i - 1);
 
     // If we reach here, success
     return OsSuccess;
@@ -195,35 +303,27 @@ BitmapAreBitsSet(
     _In_ int Index,
     _In_ int Count)
 {
-    // Calculate the block index first
-    int BlockIndex = Index / (sizeof(uintptr_t) * 8);
-    int BlockOffset = Index % (sizeof(uintptr_t) * 8);
+    // Variables
+    int BlockOffset = Index % __BITS;
     int BitsLeft = Count;
-    int i, j;
+    int i = Index / __BITS, Bits;
+    uintptr_t Mask;
 
     // Sanitize parameters
-    if (Bitmap == NULL) {
-        return OsError;
+    if (BitmapValidate(Bitmap, Index, Count) != OsSuccess) {
+        return 0;
     }
 
-    // Iterate the block and flip bits
-    for (i = BlockIndex; 
-         i < (Bitmap->SizeInBytes / (sizeof(uintptr_t) * 8)) && BitsLeft > 0; 
-         i++) {
-        for (j = BlockOffset; 
-             j < (sizeof(uintptr_t) * 8) && BitsLeft > 0; 
-             j++, BitsLeft--) {
-            if (!(Bitmap->Data[i] & (1 << j))) {
-                return 0;
-            }
-        }
-
-        // Reset block offset
-        if (BitsLeft != 0) {
-            BlockOffset = 0;
+    // Test the bits a word at the time
+    for (; BitsLeft > 0; i++, BlockOffset = 0) {
+        Bits = MIN(BitsLeft, __BITS - BlockOffset);
+        Mask = BitmapMask(BlockOffset, Bits);
+        if ((Bitmap->Data[i] & Mask) != Mask) {
+            return 0;
         }
+        BitsLeft -= Bits;
     }
-    
+
     // If we reach here, success
     return 1;
 }
@@ -237,37 +337,112 @@ BitmapAreBitsClear(
     _In_ int Index,
     _In_ int Count)
 {
-    // Calculate the block index first
-    int BlockIndex = Index / (sizeof(uintptr_t) * 8);
-    int BlockOffset = Index % (sizeof(uintptr_t) * 8);
+    // Variables
+    int BlockOffset = Index % __BITS;
     int BitsLeft = Count;
-    int i, j;
+    int i = Index / __BITS, Bits;
 
     // Sanitize parameters
-    if (Bitmap == NULL) {
-        return OsError;
+    if (BitmapValidate(Bitmap, Index, Count) != OsSuccess) {
+        return 0;
+    }
+
+    // Test the bits a word at the time
+    for (; BitsLeft > 0; i++, BlockOffset = 0) {
+        Bits = MIN(BitsLeft, __BITS - BlockOffset);
+        if (Bitmap->Data[i] & BitmapMask(BlockOffset, Bits)) {
+            return 0;
+        }
+        BitsLeft -= Bits;
+    }
+
+    // If we reach here, success
+    return 1;
+}
+
+/* BitmapFindBitsInRange
+ * Locates the requested number of consequtive free bits between Start and
+ * End (exclusive). Returns the index of the first free bit. Returns -1 on no free. */
+int
+BitmapFindBitsInRange(
+    _In_ Bitmap_t *Bitmap,
+    _In_ int Start,
+    _In_ int End,
+    _In_ int Count)
+{
+    // Variables
+    size_t Word, LastWord;
+    uintptr_t Free, Rest;
+    int Run = 0, RunStart = -1;
+    int Bit, Length;
+
+    // Sanitize parameters
+    if (Bitmap == NULL || Count <= 0 || Start < 0 || End <= Start
+        || (size_t)End > Bitmap->Capacity || End - Start < Count) {
+        return -1;
     }
 
-    // Iterate the block and flip bits
-    for (i = BlockIndex; 
-         i < (Bitmap->SizeInBytes / (sizeof(uintptr_t) * 8)) && BitsLeft > 0; 
-         i++) {
-        for (j = BlockOffset; 
-             j < (sizeof(uintptr_t) * 8) && BitsLeft > 0; 
-             j++, BitsLeft--) {
-            if (Bitmap->Data[i] & (1 << j)) {
-                return 0;
+    // Iterate the words, the free bits of each word are the
+    // cleared bits inside the range
+    Word = (size_t)Start / __BITS;
+    LastWord = (size_t)(End - 1) / __BITS;
+    while (Word <= LastWord) {
+        // Skip the full words when not inside a run
+        if (Run == 0 && Bitmap->Summary != NULL) {
+            Word = BitmapNextWord(Bitmap, Word);
+            if (Word > LastWord) {
+                break;
             }
         }
 
-        // Reset block offset
-        if (BitsLeft != 0) {
-            BlockOffset = 0;
+        Free = ~Bitmap->Data[Word];
+        if (Word == (size_t)Start / __BITS) {
+            Free &= __MASK << (Start % __BITS);
         }
+        if (Word == LastWord && (End % __BITS) != 0) {
+            Free &= BitmapMask(0, End % __BITS);
+        }
+
+        // Whole free words extend the run without looking at the bits
+        if (Free == __MASK) {
+            if (Run == 0) {
+                RunStart = (int)(Word * __BITS);
+            }
+            Run += __BITS;
+            if (Run >= Count) {
+                return RunStart;
+            }
+            Word++;
+            continue;
+        }
+
+        // Walk the runs of free bits in the word, a run that reaches
+        // the end of the word is continued by the next word
+        Bit = 0;
+        while (Bit < __BITS) {
+            Rest = Free >> Bit;
+            if (Rest == 0) {
+                Run = 0;
+                break;
+            }
+            if (!(Rest & 1)) {
+                Run = 0;
+                Bit += BITMAP_CTZ(Rest);
+                Rest = Free >> Bit;
+            }
+            Length = BITMAP_CTZ(~Rest);
+            if (Run == 0) {
+                RunStart = (int)(Word * __BITS) + Bit;
+            }
+            Run += Length;
+            if (Run >= Count) {
+                return RunStart;
+            }
+            Bit += Length;
+        }
+        Word++;
     }
-    
-    // If we reach here, success
-    return 1;
+    return -1;
 }
 
 /* BitmapFindBits
@@ -278,57 +453,9 @@ BitmapFindBits(
     _In_ Bitmap_t *Bitmap,
     _In_ int Count)
 {
-    // Variables
-    int StartBit = -1;
-	int i = 0, j = 0, k = 0;
-
-    // Iterate bits
-    for (i = 0; i < (Bitmap->SizeInBytes / (sizeof(uintptr_t) * 8)); i++) {
-		// Quick test, if all is allocated, damn
-		if (Bitmap->Data[i] == __MASK) {
-			continue;
-		}
-
-		// Test each bit in the value
-		for (j = 0; j < __BITS; j++) {
-			uintptr_t CurrentBit = 1 << j;
-			if (Bitmap->Data[i] & CurrentBit) {
-				continue;
-			}
-
-		    // Ok, now we have to incremently make sure
-			// enough consecutive bits are free
-			for (k = 0; k < Count; k++) {
-				// Make sure we are still in same block
-				if ((j + k) >= __BITS) {
-					int TempI = i + ((j + k) / __BITS);
-					int OffsetI = (j + k) % __BITS;
-					uintptr_t BlockBit = 1 << OffsetI;
-					if (Bitmap->Data[TempI] & BlockBit) {
-						break;
-					}
-				}
-				else {
-					uintptr_t BlockBit = 1 << (j + k);
-					if (Bitmap->Data[i] & BlockBit) {
-						break;
-					}
-				}
-			}
-
-			// If k == numblocks we've found free bits!
-			if (k == Count) {
-				StartBit = (int)(i * sizeof(uintptr_t) * 8 + j);
-				break;
-			}
-		}
-
-		// Break out if we found start-bit
-		if (StartBit != -1) {
-			break;
-        }
+    // Sanitize parameters
+    if (Bitmap == NULL) {
+        return -1;
     }
-    
-    // Done
-    return StartBit;
+    return BitmapFindBitsInRange(Bitmap, 0, (int)Bitmap->Capacity, Count);
 }
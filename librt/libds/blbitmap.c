@@ -46,13 +46,15 @@ BlockBitmapCreate(
     Blockmap->BlockStart = BlockStart;
     Blockmap->BlockEnd = BlockEnd;
     Blockmap->BlockSize = BlockSize;
-	Blockmap->BlockCount = (BlockEnd - BlockSize) / BlockSize;
+	Blockmap->BlockCount = (BlockEnd - BlockStart) / BlockSize;
 	SpinlockReset(&Blockmap->Lock);
 
 	// Now calculate blocks 
 	// and divide by how many bytes are required
-	Bytes = DIVUP((Blockmap->BlockCount + 1), 8);
-    BitmapConstruct(&Blockmap->Base, (uintptr_t*)dsalloc(Bytes), Bytes);
+	Bytes = DIVUP(Blockmap->BlockCount, 8);
+    BitmapConstruct(&Blockmap->Base, (uintptr_t*)dsalloc(BITMAP_WORDS(Bytes) * sizeof(uintptr_t)), Bytes);
+    BitmapConstructSummary(&Blockmap->Base, 
+        (uintptr_t*)dsalloc(BITMAP_SUMMARY_WORDS(Bytes) * sizeof(uintptr_t)));
     Blockmap->Base.Cleanup = 1;
 	return Blockmap;
 }
@@ -89,7 +91,7 @@ BlockBitmapAllocate(
 
 	// Locked operation
     SpinlockAcquire(&Blockmap->Lock);
-    Index = BitmapFindBits(&Blockmap->Base, BitCount);
+    Index = BitmapFindBitsInRange(&Blockmap->Base, 0, (int)Blockmap->BlockCount, BitCount);
     if (Index != -1) {
         BitmapSetBits(&Blockmap->Base, Index, BitCount);
         Block = Blockmap->BlockStart + (uintptr_t)(Index * Blockmap->BlockSize);
@@ -24,16 +24,72 @@
 /* Includes
  * - Library */
 #include <os/driver/bufferpool.h>
+#include <os/spinlock.h>
 #include <os/osdefs.h>
-#include "../common/bytepool.h"
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
+
+/* BufferPool Definitions
+ * The class table keeps the order of each block head, and marks free heads */
+#define BUFFERPOOL_BLOCK_FREE           0x80
+#define BUFFERPOOL_BLOCK_ORDER(Entry)   ((Entry) & 0x7F)
+
+/* BufferPoolBlock
+ * Free blocks are kept in per-class lists, the list node is stored
+ * inside the free block itself. */
+typedef struct _BufferPoolBlock {
+    struct _BufferPoolBlock     *Link;
+    struct _BufferPoolBlock     *Previous;
+} BufferPoolBlock_t;
 
 typedef struct _BufferPool {
     BufferObject_t*             Buffer;
-    BytePool_t*                 Pool;
+    uintptr_t                   BaseAddress;
+    size_t                      Capacity;
+    Spinlock_t                  Lock;
+    uint8_t                    *Classes;
+    BufferPoolBlock_t          *FreeLists[BUFFERPOOL_CLASSES];
+    BufferPoolStatistics_t      Statistics;
 } BufferPool_t;
 
+/* BufferPoolPush
+ * Marks the block free and inserts it in the free list of its class. */
+void
+BufferPoolPush(
+    _In_ BufferPool_t *Pool,
+    _In_ BufferPoolBlock_t *Block,
+    _In_ int Order)
+{
+    size_t Index = ((uintptr_t)Block - Pool->BaseAddress) >> BUFFERPOOL_MIN_ORDER;
+    Block->Previous = NULL;
+    Block->Link = Pool->FreeLists[Order - BUFFERPOOL_MIN_ORDER];
+    if (Block->Link != NULL) {
+        Block->Link->Previous = Block;
+    }
+    Pool->FreeLists[Order - BUFFERPOOL_MIN_ORDER] = Block;
+    Pool->Classes[Index] = (uint8_t)Order | BUFFERPOOL_BLOCK_FREE;
+}
+
+/* BufferPoolUnlink
+ * Removes the block from the free list of its class. */
+void
+BufferPoolUnlink(
+    _In_ BufferPool_t *Pool,
+    _In_ BufferPoolBlock_t *Block,
+    _In_ int Order)
+{
+    if (Block->Previous != NULL) {
+        Block->Previous->Link = Block->Link;
+    }
+    else {
+        Pool->FreeLists[Order - BUFFERPOOL_MIN_ORDER] = Block->Link;
+    }
+    if (Block->Link != NULL) {
+        Block->Link->Previous = Block->Previous;
+    }
+}
+
 /* BufferPoolCreate
  * Creates a new buffer-pool from the given buffer object. 
  * This allows sub-allocations from a buffer-object. */
@@ -42,12 +98,45 @@ BufferPoolCreate(
     _In_ BufferObject_t *Buffer,
     _Out_ BufferPool_t **Pool)
 {
+    // Variables
+    BufferPool_t *Instance = NULL;
+    size_t Offset = 0;
+    int Order;
+
     // Allocate the pool
-    *Pool = (BufferPool_t*)malloc(sizeof(BufferPool_t));
-    (*Pool)->Buffer = Buffer;
+    Instance = (BufferPool_t*)malloc(sizeof(BufferPool_t));
+    if (Instance == NULL) {
+        return OsError;
+    }
+    memset(Instance, 0, sizeof(BufferPool_t));
+    Instance->Buffer = Buffer;
+    Instance->BaseAddress = (uintptr_t)GetBufferData(Buffer);
+    Instance->Capacity = GetBufferCapacity(Buffer) & ~((1 << BUFFERPOOL_MIN_ORDER) - 1);
+    Instance->Statistics.Capacity = Instance->Capacity;
+    SpinlockReset(&Instance->Lock);
 
-    // Initiate the pool
-    return bpool((void*)GetBufferData(Buffer), GetBufferCapacity(Buffer), &(*Pool)->Pool);
+    // Allocate the class table, one entry per minimum block
+    Instance->Classes = (uint8_t*)malloc(Instance->Capacity >> BUFFERPOOL_MIN_ORDER);
+    if (Instance->Classes == NULL) {
+        free(Instance);
+        return OsError;
+    }
+    memset(Instance->Classes, 0, Instance->Capacity >> BUFFERPOOL_MIN_ORDER);
+
+    // Carve the buffer into the largest naturally aligned blocks possible,
+    // capacities that are not a power of two end up as multiple top blocks
+    while (Offset < Instance->Capacity) {
+        for (Order = BUFFERPOOL_MAX_ORDER; Order > BUFFERPOOL_MIN_ORDER; Order--) {
+            if ((Offset & ((1 << Order) - 1)) == 0
+                && (Offset + (1 << Order)) <= Instance->Capacity) {
+                break;
+            }
+        }
+        BufferPoolPush(Instance, (BufferPoolBlock_t*)(Instance->BaseAddress + Offset), Order);
+        Offset += (1 << Order);
+    }
+    *Pool = Instance;
+    return OsSuccess;
 }
 
 /* BufferPoolDestroy
@@ -58,7 +147,7 @@ BufferPoolDestroy(
     _In_ BufferPool_t *Pool)
 {
     // Cleanup structure
-    free(Pool->Pool);
+    free(Pool->Classes);
     free(Pool);
     return OsSuccess;
 }
@@ -66,7 +155,8 @@ BufferPoolDestroy(
 /* BufferPoolAllocate
  * Allocates the requested size and outputs two addresses. The
  * virtual pointer to the accessible data, and the address of its 
- * corresponding physical address for hardware. */
+ * corresponding physical address for hardware. The allocation is
+ * rounded up to the nearest power of two and aligned to it. */
 OsStatus_t
 BufferPoolAllocate(
     _In_ BufferPool_t *Pool,
@@ -75,20 +165,51 @@ BufferPoolAllocate(
     _Out_ uintptr_t *PhysicalAddress)
 {
     // Variables
-    void *Allocation = NULL;
+    BufferPoolBlock_t *Block = NULL;
+    int Order = BUFFERPOOL_MIN_ORDER;
+    int Current;
+
+    // Find the size class
+    while (Order <= BUFFERPOOL_MAX_ORDER && ((size_t)1 << Order) < Size) {
+        Order++;
+    }
 
-    // Perform an allocation
-    Allocation = bget(Pool->Pool, Size);
-    if (Allocation == NULL) {
+    // Find the smallest class with a free block
+    SpinlockAcquire(&Pool->Lock);
+    for (Current = Order; Current <= BUFFERPOOL_MAX_ORDER; Current++) {
+        if (Pool->FreeLists[Current - BUFFERPOOL_MIN_ORDER] != NULL) {
+            break;
+        }
+    }
+    if (Current > BUFFERPOOL_MAX_ORDER) {
+        Pool->Statistics.Failures++;
+        SpinlockRelease(&Pool->Lock);
         return OsError;
     }
 
+    // Take the block and split it down to the requested class,
+    // the upper halves are returned to the free lists
+    Block = Pool->FreeLists[Current - BUFFERPOOL_MIN_ORDER];
+    BufferPoolUnlink(Pool, Block, Current);
+    while (Current > Order) {
+        Current--;
+        BufferPoolPush(Pool, (BufferPoolBlock_t*)((uintptr_t)Block + (1 << Current)), Current);
+    }
+    Pool->Classes[((uintptr_t)Block - Pool->BaseAddress) >> BUFFERPOOL_MIN_ORDER] = (uint8_t)Order;
+
+    // Update statistics
+    Pool->Statistics.Allocations++;
+    Pool->Statistics.ClassAllocations[Order - BUFFERPOOL_MIN_ORDER]++;
+    Pool->Statistics.BytesAllocated += (1 << Order);
+    if (Pool->Statistics.BytesAllocated > Pool->Statistics.BytesPeak) {
+        Pool->Statistics.BytesPeak = Pool->Statistics.BytesAllocated;
+    }
+    SpinlockRelease(&Pool->Lock);
+
     // Calculate the addresses and update out's
-    *VirtualPointer = (uintptr_t*)Allocation;
+    *VirtualPointer = (uintptr_t*)Block;
     *PhysicalAddress = GetBufferAddress(Pool->Buffer) 
-        + ((uintptr_t)Allocation - (uintptr_t)GetBufferData(Pool->Buffer));
-
-    // Done
+        + ((uintptr_t)Block - Pool->BaseAddress);
     return OsSuccess;
 }
 
@@ -100,7 +221,58 @@ BufferPoolFree(
     _In_ BufferPool_t *Pool,
     _In_ uintptr_t *VirtualPointer)
 {
-    // Free it in brel
-    brel(Pool->Pool, (void*)VirtualPointer);
+    // Variables
+    size_t Offset = (uintptr_t)VirtualPointer - Pool->BaseAddress;
+    size_t BuddyOffset;
+    int Order;
+
+    // Sanitize the pointer
+    if ((uintptr_t)VirtualPointer < Pool->BaseAddress || Offset >= Pool->Capacity
+        || (Offset & ((1 << BUFFERPOOL_MIN_ORDER) - 1)) != 0) {
+        return OsError;
+    }
+
+    // Sanitize the block, it must be an allocated block head
+    SpinlockAcquire(&Pool->Lock);
+    Order = Pool->Classes[Offset >> BUFFERPOOL_MIN_ORDER];
+    if (Order < BUFFERPOOL_MIN_ORDER || (Order & BUFFERPOOL_BLOCK_FREE)) {
+        SpinlockRelease(&Pool->Lock);
+        return OsError;
+    }
+    Pool->Statistics.Frees++;
+    Pool->Statistics.BytesAllocated -= (1 << Order);
+
+    // Merge with the buddy as long as it's free and of the same class
+    while (Order < BUFFERPOOL_MAX_ORDER) {
+        BuddyOffset = Offset ^ ((size_t)1 << Order);
+        if (BuddyOffset >= Pool->Capacity || Pool->Classes[BuddyOffset >> BUFFERPOOL_MIN_ORDER] 
+            != ((uint8_t)Order | BUFFERPOOL_BLOCK_FREE)) {
+            break;
+        }
+        BufferPoolUnlink(Pool, (BufferPoolBlock_t*)(Pool->BaseAddress + BuddyOffset), Order);
+        Pool->Classes[Offset >> BUFFERPOOL_MIN_ORDER] = 0;
+        Pool->Classes[BuddyOffset >> BUFFERPOOL_MIN_ORDER] = 0;
+        Offset &= ~((size_t)1 << Order);
+        Order++;
+    }
+    BufferPoolPush(Pool, (BufferPoolBlock_t*)(Pool->BaseAddress + Offset), Order);
+    SpinlockRelease(&Pool->Lock);
+    return OsSuccess;
+}
+
+/* BufferPoolGetStatistics
+ * Retrieves a snapshot of the usage statistics of the buffer-pool. */
+OsStatus_t
+BufferPoolGetStatistics(
+    _In_ BufferPool_t *Pool,
+    _Out_ BufferPoolStatistics_t *Statistics)
+{
+    // Sanitize
+    if (Pool == NULL || Statistics == NULL) {
+        return OsError;
+    }
+    SpinlockAcquire(&Pool->Lock);
+    memcpy(Statistics, &Pool->Statistics, sizeof(BufferPoolStatistics_t));
+    SpinlockRelease(&Pool->Lock);
     return OsSuccess;
 }
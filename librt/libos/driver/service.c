@@ -38,6 +38,20 @@ RegisterService(
         SYSCALL_SERVICEREGISTER, SYSCALL_PARAM(Alias));
 }
 
+/* WaitForService
+ * Waits for the service on the given alias to register, this is how
+ * a service declares the services it depends on. Services start in
+ * parallel, so anything used during OnLoad must be waited for. A timeout
+ * of 0 waits forever, OsError is returned if the timeout expires */
+OsStatus_t
+WaitForService(
+    _In_ UUId_t Alias,
+    _In_ size_t Timeout)
+{
+	return (OsStatus_t)Syscall2(SYSCALL_SERVICEWAIT, 
+        SYSCALL_PARAM(Alias), SYSCALL_PARAM(Timeout));
+}
+
 /* InstallDriver 
  * Tries to find a suitable driver for the given device
  * by searching storage-medias for the vendorid/deviceid 
@@ -47,6 +47,19 @@ void MStringAppendString(MString_t *Destination, MString_t *String)
 	/* Set a null terminator */
 	BufPtr[NewLength] = '\0';
 
+	/* Appending ascii to ascii keeps the cache, the hash
+	 * continues over the new bytes */
+	if ((Destination->CacheFlags & MSTRING_CACHE_ASCII)
+		&& (String->CacheFlags & MSTRING_CACHE_ASCII)) {
+		for (size_t i = Destination->Length; i < NewLength; i++) {
+			Destination->Hash = ((Destination->Hash << 5) + Destination->Hash) + MSTRING_FOLD(BufPtr[i]);
+		}
+		Destination->CharacterCount += String->CharacterCount;
+	}
+	else {
+		MStringInvalidate(Destination);
+	}
+
 	/* Update Length */
 	Destination->Length = NewLength;
 }
@@ -77,6 +90,15 @@ void MStringAppendCharacter(MString_t *String, mchar_t Character)
 	/* Null-terminate */
 	BufPtr[Itr + cLen] = '\0';
 
+	/* Appending ascii to ascii keeps the cache */
+	if ((String->CacheFlags & MSTRING_CACHE_ASCII) && cLen == 1 && Character < 0x80) {
+		String->Hash = ((String->Hash << 5) + String->Hash) + MSTRING_FOLD(Character);
+		String->CharacterCount++;
+	}
+	else {
+		MStringInvalidate(String);
+	}
+
 	/* Done? */
 	String->Length += cLen;
 }
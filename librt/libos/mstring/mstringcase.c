@@ -0,0 +1,80 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2016, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS MCore - String Format
+ */
+
+/* Includes 
+ * - System */
+#include "mstringprivate.h"
+
+/* Helper
+ * Converts the ascii letters of a string, bytes of multi-byte
+ * characters are never in the ascii range so they are left alone. The
+ * cached properties are not affected as the hash ignores case. */
+void MStringConvertCase(MString_t *String, int Upper)
+{
+	/* Variables */
+	uint8_t *DataPtr = (uint8_t*)String->Data;
+	uint8_t Lower = Upper ? 'a' : 'A';
+	size_t i;
+
+	/* Sanitize */
+	if (String->Data == NULL) {
+		return;
+	}
+
+	/* Toggle the case bit of letters in the source case */
+	for (i = 0; i < String->Length; i++) {
+		if ((uint8_t)(DataPtr[i] - Lower) < 26) {
+			DataPtr[i] ^= 0x20;
+		}
+	}
+}
+
+/* Casing 
+ * Converts the ascii letters of the string to upper-case */
+void MStringUpperCase(MString_t *String)
+{
+	MStringConvertCase(String, 1);
+}
+
+/* Casing 
+ * Creates a copy of the string with the ascii letters in upper-case */
+MString_t *MStringUpperCaseCopy(MString_t *String)
+{
+	MString_t *Copy = MStringCreate((void*)MStringRaw(String), StrUTF8);
+	MStringConvertCase(Copy, 1);
+	return Copy;
+}
+
+/* Casing 
+ * Converts the ascii letters of the string to lower-case */
+void MStringLowerCase(MString_t *String)
+{
+	MStringConvertCase(String, 0);
+}
+
+/* Casing 
+ * Creates a copy of the string with the ascii letters in lower-case */
+MString_t *MStringLowerCaseCopy(MString_t *String)
+{
+	MString_t *Copy = MStringCreate((void*)MStringRaw(String), StrUTF8);
+	MStringConvertCase(Copy, 0);
+	return Copy;
+}
@@ -23,6 +23,31 @@
  * - System */
 #include "mstringprivate.h"
 
+/* Compares two ascii strings of equal length, this is
+ * the common case for paths and names and needs no decoding */
+int MStringCompareASCII(MString_t *String1, MString_t *String2, int IgnoreCase)
+{
+	/* Loop vars */
+	uint8_t *DataPtr1 = (uint8_t*)String1->Data;
+	uint8_t *DataPtr2 = (uint8_t*)String2->Data;
+	size_t i;
+
+	/* Case-sensitive is a plain byte compare */
+	if (!IgnoreCase) {
+		return memcmp(DataPtr1, DataPtr2, String1->Length) == 0 ?
+			MSTRING_FULL_MATCH : MSTRING_NO_MATCH;
+	}
+
+	/* Otherwise fold each byte */
+	for (i = 0; i < String1->Length; i++) {
+		if (DataPtr1[i] != DataPtr2[i]
+			&& MSTRING_FOLD(DataPtr1[i]) != MSTRING_FOLD(DataPtr2[i])) {
+			return MSTRING_NO_MATCH;
+		}
+	}
+	return MSTRING_FULL_MATCH;
+}
+
 /* Compare two strings with either case-ignore or not. 
  * Returns MSTRING_FULL_MATCH if they are equal, or
  * MSTRING_PARTIAL_MATCH if they contain same text 
@@ -37,6 +62,19 @@ int MStringCompare(MString_t *String1, MString_t *String2, int IgnoreCase)
 	char *DataPtr2 = (char*)String2->Data;
 	int i1 = 0, i2 = 0;
 
+	/* Ascii strings can only match with the same byte-length
+	 * and the same case-insensitive hash, both are cached */
+	MStringUpdateCache(String1);
+	MStringUpdateCache(String2);
+	if ((String1->CacheFlags & MSTRING_CACHE_ASCII)
+		&& (String2->CacheFlags & MSTRING_CACHE_ASCII)) {
+		if (String1->Length != String2->Length
+			|| String1->Hash != String2->Hash) {
+			return MSTRING_NO_MATCH;
+		}
+		return MStringCompareASCII(String1, String2, IgnoreCase);
+	}
+
 	/* Iterate */
 	while (DataPtr1[i1] && DataPtr2[i2])
 	{
@@ -57,10 +95,8 @@ int MStringCompare(MString_t *String1, MString_t *String2, int IgnoreCase)
 		 * because they are the only ones we can convert
 		 * easily without any help lookup tables */
 		if (IgnoreCase) {
-			if (First < 0x80 && isalpha(First))
-				First = tolower((uint8_t)First);
-			if (Second < 0x80 && isalpha(Second))
-				Second = tolower((uint8_t)Second);
+			First = MSTRING_FOLD(First);
+			Second = MSTRING_FOLD(Second);
 		}
 
 		/* Lets see */
@@ -73,7 +109,7 @@ int MStringCompare(MString_t *String1, MString_t *String2, int IgnoreCase)
 		return MSTRING_NO_MATCH;
 
 	/* Sanity - Length */
-	if (strlen(String1->Data) != strlen(String2->Data))
+	if (String1->Length != String2->Length)
 		return MSTRING_PARTIAL_MATCH;
 
 	/* Done - Equal */
@@ -40,14 +40,19 @@ void MStringCopy(MString_t *Destination, MString_t *Source, int Length)
 	{
 		/* Is destination large enough? */
 		if (Source->Length >= Destination->MaxLength) {
-			MStringResize(Destination, Source->MaxLength);
+			MStringResize(Destination, Source->Length);
 		}
 
 		/* Copy */
 		memcpy(Destination->Data, Source->Data, Source->Length);
+		((uint8_t*)Destination->Data)[Source->Length] = '\0';
 
-		/* Update length */
+		/* Update length, the cache
+		 * is the same as the source */
 		Destination->Length = Source->Length;
+		Destination->CacheFlags = Source->CacheFlags;
+		Destination->CharacterCount = Source->CharacterCount;
+		Destination->Hash = Source->Hash;
 	}
 	else
 	{
@@ -75,5 +80,7 @@ void MStringCopy(MString_t *Destination, MString_t *Source, int Length)
 		/* Null Terminate */
 		uint8_t *NullPtr = (uint8_t*)Destination->Data;
 		NullPtr[Index] = '\0';
+		Destination->Length = (size_t)Index;
+		MStringInvalidate(Destination);
 	}
 }
@@ -31,7 +31,6 @@ int MStringConvertASCIIToUtf8(MString_t *Storage, const char *Source)
 	/* Variables and make sure to reset length */
 	char *dPtr = NULL;
 	char *cPtr = (char*)Source;
-	size_t DataLength = 0;
 	Storage->Length = 0;
 
 	/* We have to count manually, 
@@ -41,16 +40,9 @@ int MStringConvertASCIIToUtf8(MString_t *Storage, const char *Source)
 		cPtr++;
 	}
 
-	/* Calculate Length 
-	 * include extra byte for terminator */
-	DataLength = DIVUP((Storage->Length + 1), MSTRING_BLOCK_SIZE) * MSTRING_BLOCK_SIZE;
-
-	/* Allocate a buffer */
-	Storage->Data = (void*)dsalloc(DataLength);
-	Storage->MaxLength = DataLength;
-
-	/* Memset it */
-	memset(Storage->Data, 0, DataLength);
+	/* Allocate a zeroed buffer, it
+	 * has an extra byte for terminator */
+	MStringAllocate(Storage, Storage->Length);
 
 	/* Conversion time! */
 	dPtr = Storage->Data;
@@ -67,6 +59,9 @@ int MStringConvertASCIIToUtf8(MString_t *Storage, const char *Source)
 		cPtr++;
 	}
 
+	/* Characters that failed to encode were skipped */
+	Storage->Length = (size_t)(dPtr - (char*)Storage->Data);
+
 	/* Done! */
 	return 0;
 }
@@ -78,19 +73,12 @@ int MStringConvertLatin1ToUtf8(MString_t *Storage, const char *Source)
 {
 	/* Calculate the string length 
 	 * given by the forumale len*2+1 */
-	size_t TempLength = strlen(Source) * 2 + 1;
+	size_t TempLength = strlen(Source) * 2;
 	char *SourcePtr = (char*)Source;
 	char *DestPtr = NULL;
 
-	/* Calculate Length */
-	size_t DataLength = DIVUP(TempLength, MSTRING_BLOCK_SIZE) * MSTRING_BLOCK_SIZE;
-
-	/* Allocate a buffer */
-	Storage->Data = (void*)dsalloc(DataLength);
-	Storage->MaxLength = DataLength;
-
-	/* Memset it */
-	memset(Storage->Data, 0, DataLength);
+	/* Allocate a zeroed buffer */
+	MStringAllocate(Storage, TempLength);
 
 	/* Iterate the data given and convert */
 	DestPtr = (char*)Storage->Data;
@@ -109,7 +97,7 @@ int MStringConvertLatin1ToUtf8(MString_t *Storage, const char *Source)
 	*DestPtr = '\0';
 
 	/* Update the actual length of the string */
-	Storage->Length = strlen((const char*)Storage->Data);
+	Storage->Length = (size_t)(DestPtr - (char*)Storage->Data);
 
 	/* Done! */
 	return 0;
@@ -123,7 +111,6 @@ int MStringConvertUtf16ToUtf8(MString_t *Storage, const char *Source)
 	/* Variables and make sure to reset length */
 	uint16_t *sPtr = (uint16_t*)Source;
 	char *dPtr = NULL;
-	size_t DataLength = 0;
 	Storage->Length = 0;
 	
 	/* Iterate and count how many bytes
@@ -133,16 +120,9 @@ int MStringConvertUtf16ToUtf8(MString_t *Storage, const char *Source)
 		sPtr++;
 	}
 
-	/* Calculate Length 
-	 * but here include terminator bytes */
-	DataLength = DIVUP((Storage->Length + 2), MSTRING_BLOCK_SIZE) * MSTRING_BLOCK_SIZE;
-
-	/* Allocate a buffer */
-	Storage->Data = (void*)dsalloc(DataLength);
-	Storage->MaxLength = DataLength;
-
-	/* Memset it */
-	memset(Storage->Data, 0, DataLength);
+	/* Allocate a zeroed buffer, it
+	 * has an extra byte for terminator */
+	MStringAllocate(Storage, Storage->Length);
 
 	/* Conversion time! */
 	sPtr = (uint16_t*)Source;
@@ -159,6 +139,9 @@ int MStringConvertUtf16ToUtf8(MString_t *Storage, const char *Source)
 		sPtr++;
 	}
 
+	/* Characters that failed to encode were skipped */
+	Storage->Length = (size_t)(dPtr - (char*)Storage->Data);
+
 	/* Done! */
 	return 0;
 }
@@ -171,7 +154,6 @@ int MStringConvertUtf32ToUtf8(MString_t *Storage, const char *Source)
 	/* Variables and make sure to reset length */
 	uint32_t *sPtr = (uint32_t*)Source;
 	char *dPtr = NULL;
-	size_t DataLength = 0;
 	Storage->Length = 0;
 	
 	/* Iterate and count how many bytes
@@ -181,16 +163,9 @@ int MStringConvertUtf32ToUtf8(MString_t *Storage, const char *Source)
 		sPtr++;
 	}
 
-	/* Calculate Length 
-	 * but here include terminator bytes */
-	DataLength = DIVUP((Storage->Length + 4), MSTRING_BLOCK_SIZE) * MSTRING_BLOCK_SIZE;
-
-	/* Allocate a buffer */
-	Storage->Data = (void*)dsalloc(DataLength);
-	Storage->MaxLength = DataLength;
-
-	/* Memset it */
-	memset(Storage->Data, 0, DataLength);
+	/* Allocate a zeroed buffer, it
+	 * has an extra byte for terminator */
+	MStringAllocate(Storage, Storage->Length);
 
 	/* Conversion time! */
 	sPtr = (uint32_t*)Source;
@@ -207,6 +182,9 @@ int MStringConvertUtf32ToUtf8(MString_t *Storage, const char *Source)
 		sPtr++;
 	}
 
+	/* Characters that failed to encode were skipped */
+	Storage->Length = (size_t)(dPtr - (char*)Storage->Data);
+
 	/* Done! */
 	return 0;
 }
@@ -216,22 +194,12 @@ int MStringConvertUtf32ToUtf8(MString_t *Storage, const char *Source)
  * returns 0 on success, otherwise error */
 int MStringCopyUtf8ToUtf8(MString_t *Storage, const char *Source)
 {
-	/* Variables */
-	size_t DataLength = 0;
-
 	/* Get length */
 	Storage->Length = strlen(Source);
 
-	/* Calculate Length 
-	 * include extra byte for null-terminator */
-	DataLength = DIVUP((Storage->Length + 1), MSTRING_BLOCK_SIZE) * MSTRING_BLOCK_SIZE;
-
-	/* Allocate a buffer */
-	Storage->Data = (void*)dsalloc(DataLength);
-	Storage->MaxLength = DataLength;
-
-	/* Memset it */
-	memset(Storage->Data, 0, DataLength);
+	/* Allocate a zeroed buffer, it
+	 * has an extra byte for null-terminator */
+	MStringAllocate(Storage, Storage->Length);
 
 	/* Copy string */
 	memcpy(Storage->Data, (const void*)Source, Storage->Length);
@@ -246,15 +214,15 @@ void MStringNull(MString_t *Storage)
 {
 	/* Allocate an empty string */
 	if (Storage->Data == NULL) {
-		Storage->Data = dsalloc(MSTRING_BLOCK_SIZE);
-		Storage->MaxLength = MSTRING_BLOCK_SIZE;
+		MStringAllocate(Storage, 0);
+	}
+	else {
+		memset(Storage->Data, 0, Storage->MaxLength);
 	}
-	
-	/* Reset memory */
-	memset(Storage->Data, 0, Storage->MaxLength);
 
 	/* Reset length */
 	Storage->Length = 0;
+	MStringInvalidate(Storage);
 }
 
 /* Creates a MString instace from string data
@@ -271,6 +239,7 @@ MString_t *MStringCreate(void *Data, MStringType_t DataType)
 	 * So there is always returned a new string */
 	String = (MString_t*)dsalloc(sizeof(MString_t));
 	String->Data = NULL;
+	MStringInvalidate(String);
 
 	/* SPECIAL Case: Empty string */
 	if (Data == NULL) {
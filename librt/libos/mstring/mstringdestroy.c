@@ -33,10 +33,8 @@ void MStringDestroy(MString_t *String)
 	}
 
 	/* Free buffer 
-	 * make sure it's not null */
-	if (String->Data != NULL) {
-		dsfree(String->Data);
-	}
+	 * unless it's stored inline */
+	MStringFree(String);
 
 	/* Free structure */
 	dsfree(String);
@@ -23,28 +23,54 @@
  * - System */
 #include "mstringprivate.h"
 
-/* Generate hash of a mstring
- * the hash will be either 32/64 depending
- * on the size of architecture */
-size_t MStringHash(MString_t *String)
+/* Helper for internal functions
+ * to compute the cached properties of a string if they
+ * have been invalidated since last time */
+void MStringUpdateCache(MString_t *String)
 {
 	/* Hash Seed */
+	Flags_t Flags = MSTRING_CACHE_VALID | MSTRING_CACHE_ASCII;
 	size_t Hash = 5381;
 	uint8_t *StrPtr;
-	int Char;
+	size_t i;
 
 	/* Sanity */
-	if (String->Data == NULL
-		|| String->Length == 0)
-		return 0;
+	if (String->CacheFlags & MSTRING_CACHE_VALID) {
+		return;
+	}
 
-	/* Get a pointer */
+	/* Hash and check for non-ascii in the same pass, the
+	 * hash ignores case so case-folding keeps the cache valid */
 	StrPtr = (uint8_t*)String->Data;
+	for (i = 0; StrPtr != NULL && i < String->Length; i++) {
+		if (StrPtr[i] & 0x80) {
+			Flags &= ~MSTRING_CACHE_ASCII;
+		}
+		Hash = ((Hash << 5) + Hash) + MSTRING_FOLD(StrPtr[i]); /* hash * 33 + c */
+	}
+
+	/* Only non-ascii strings have to be decoded for the count */
+	String->Hash = Hash;
+	if (Flags & MSTRING_CACHE_ASCII) {
+		String->CharacterCount = String->Length;
+	}
+	else {
+		String->CharacterCount = Utf8CharacterCountInString((const char*)String->Data);
+	}
+	String->CacheFlags = Flags;
+}
 
-	/* Hash */
-	while ((Char = tolower(*StrPtr++)) != 0)
-		Hash = ((Hash << 5) + Hash) + Char; /* hash * 33 + c */
+/* Generate hash of a mstring
+ * the hash will be either 32/64 depending
+ * on the size of architecture */
+size_t MStringHash(MString_t *String)
+{
+	/* Sanity */
+	if (String->Data == NULL
+		|| String->Length == 0)
+		return 0;
 
-	/* Done */
-	return Hash;
+	/* Hash is cached until the string is modified */
+	MStringUpdateCache(String);
+	return String->Hash;
 }
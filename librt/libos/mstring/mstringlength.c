@@ -32,8 +32,9 @@ size_t MStringLength(MString_t *String)
 		|| String->Length == 0)
 		return 0;
 
-	/* Use our Utf8 helper */
-	return Utf8CharacterCountInString((const char*)String->Data);
+	/* Count is cached until the string is modified */
+	MStringUpdateCache(String);
+	return String->CharacterCount;
 }
 
 /* Retrieves the number of bytes used 
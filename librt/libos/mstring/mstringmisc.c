@@ -62,7 +62,7 @@ int MStringFindChars(MString_t *String, const char *Chars)
 			{ 
 				/* Get next */
 				SourceCharacter = Utf8GetNextCharacterInString(DataPtr, &iTemp);
-				DestCharacter = Utf8GetNextCharacterInString(DataPtr, &iDest);
+				DestCharacter = Utf8GetNextCharacterInString(Chars, &iDest);
 			}
 
 			/* Are they still equal? */
@@ -131,7 +131,7 @@ void MStringReplace(MString_t *String, const char *Old, const char *New)
 			{
 				/* Get next */
 				SourceCharacter = Utf8GetNextCharacterInString(DataPtr, &iTemp);
-				DestCharacter = Utf8GetNextCharacterInString(DataPtr, &iDest);
+				DestCharacter = Utf8GetNextCharacterInString(Old, &iDest);
 			}
 
 			/* Are they still equal? */
@@ -159,13 +159,15 @@ void MStringReplace(MString_t *String, const char *Old, const char *New)
 	NewLen = strlen((const char*)TempPtr);
 
 	/* Sanity */
-	if (NewLen > String->MaxLength) {
+	if (NewLen >= String->MaxLength) {
 		MStringResize(String, NewLen);
 	}
 
 	/* Copy over */
 	memcpy(String->Data, TempPtr, NewLen);
+	((uint8_t*)String->Data)[NewLen] = '\0';
 	String->Length = NewLen;
+	MStringInvalidate(String);
 
 	/* Free */
 	dsfree(TempPtr);
@@ -124,6 +124,20 @@
  * this can be tweaked by the user */
 #define MSTRING_BLOCK_SIZE		64
 
+/* This is the number of bytes that can be stored inside the
+ * mstring structure itself, names and short paths fit in here
+ * and don't need a seperate allocation */
+#define MSTRING_INLINE_SIZE		48
+
+/* Cache flags, the cached properties are computed on demand
+ * and must be invalidated whenever the data is modified */
+#define MSTRING_CACHE_VALID		0x1
+#define MSTRING_CACHE_ASCII		0x2
+
+/* Folds an ASCII character to lower-case, only A-Z are
+ * touched so it's safe to use on the bytes of UTF8 data */
+#define MSTRING_FOLD(Character)	(((Character) >= 'A' && (Character) <= 'Z') ? ((Character) | 0x20) : (Character))
+
 /* Structures 
  * The MString structure, it keeps 
  * track of data, length and max length 
@@ -131,15 +145,28 @@
 typedef struct _MString
 {
 	/* String Data
-	 * As UTF8 */
+	 * As UTF8, points to Inline for short strings */
 	void *Data;
 	
 	/* Length(s) */
 	size_t Length;
 	size_t MaxLength;
 
+	/* Cached properties of the data
+	 * they are only valid with MSTRING_CACHE_VALID */
+	Flags_t CacheFlags;
+	size_t CharacterCount;
+	size_t Hash;
+
+	/* Inline storage for short strings */
+	char Inline[MSTRING_INLINE_SIZE];
+
 } MString_t;
 
+/* Invalidates the cached properties of a string, must
+ * be used by all functions that modify string data */
+#define MStringInvalidate(String)	((String)->CacheFlags = 0)
+
 /* Converts a single char (ASCII, UTF16, UTF32) to UTF8 
  * and returns the number of bytes the new utf8 
  * 'string' takes up. Returns 0 if conversion was good */
@@ -169,4 +196,18 @@ MOSAPI size_t Utf8ByteCountInString(const char *Str);
  * of a string to be able to fit a certain size */
 MOSAPI void MStringResize(MString_t *String, size_t Length);
 
+/* Helper for internal functions
+ * to set up a zeroed buffer that fits the given number of bytes
+ * and a null-terminator. The previous buffer is not released */
+MOSAPI void MStringAllocate(MString_t *String, size_t Length);
+
+/* Helper for internal functions
+ * to release the buffer of a string if it was allocated */
+MOSAPI void MStringFree(MString_t *String);
+
+/* Helper for internal functions
+ * to compute the cached properties of a string if they
+ * have been invalidated since last time */
+MOSAPI void MStringUpdateCache(MString_t *String);
+
 #endif //!_MSTRING_PRIV_H_
@@ -23,26 +23,49 @@
  * - System */
 #include "mstringprivate.h"
 
+/* Helper for internal functions
+ * to set up a zeroed buffer that fits the given number of bytes
+ * and a null-terminator. The previous buffer is not released */
+void MStringAllocate(MString_t *String, size_t Length)
+{
+	/* Short strings are kept inline */
+	if (Length < MSTRING_INLINE_SIZE) {
+		String->Data = (void*)&String->Inline[0];
+		String->MaxLength = MSTRING_INLINE_SIZE;
+	}
+	else {
+		String->MaxLength = DIVUP((Length + 1), MSTRING_BLOCK_SIZE) * MSTRING_BLOCK_SIZE;
+		String->Data = dsalloc(String->MaxLength);
+	}
+	memset(String->Data, 0, String->MaxLength);
+}
+
+/* Helper for internal functions
+ * to release the buffer of a string if it was allocated */
+void MStringFree(MString_t *String)
+{
+	if (String->Data != NULL 
+		&& String->Data != (void*)&String->Inline[0]) {
+		dsfree(String->Data);
+	}
+	String->Data = NULL;
+}
+
 /* Helper for internal functions
  * to automatically resize the buffer 
  * of a string to be able to fit a certain size */
 void MStringResize(MString_t *String, size_t Length)
 {
-	/* Calculate the new byte-count we 
-	 * need to encompass with blocks */
-	size_t DataLength = DIVUP(Length, MSTRING_BLOCK_SIZE) * MSTRING_BLOCK_SIZE;
+	/* Keep a copy of the old buffer */
+	MString_t Old = *String;
+	if (Old.Data == (void*)&String->Inline[0]) {
+		Old.Data = (void*)&Old.Inline[0];
+	}
 
 	/* Expand and reset buffer */
-	void *Data = dsalloc(DataLength);
-	memset(Data, 0, DataLength);
-
-	/* Copy old data over */
-	memcpy(Data, String->Data, String->Length);
-
-	/* Free the old buffer */
-	dsfree(String->Data);
+	MStringAllocate(String, Length);
 
-	/* Update string to new buffer */
-	String->MaxLength = DataLength;
-	String->Data = Data;
+	/* Copy old data over and free the old buffer */
+	memcpy(String->Data, Old.Data, MIN(Old.Length, Length));
+	MStringFree(&Old);
 }
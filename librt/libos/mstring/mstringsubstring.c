@@ -31,7 +31,7 @@ MString_t *MStringSubString(MString_t *String, int Index, int Length)
 	/* Variables needed for the
 	* string operation */
 	MString_t *SubString = NULL;
-	size_t DataLength = 0, DataAllocLength = 0;
+	size_t DataLength = 0;
 	char *sPtr = NULL;
 
 	/* Indices for enumeration of 
@@ -84,18 +84,12 @@ MString_t *MStringSubString(MString_t *String, int Index, int Length)
 
 	/* Allocate a new instance of mstring */
 	SubString = (MString_t*)dsalloc(sizeof(MString_t));
+	MStringInvalidate(SubString);
 
-	/* Calculate Length 
-	 * add an extra byte for null terminator */
-	DataAllocLength = DIVUP((DataLength + 1), MSTRING_BLOCK_SIZE) * MSTRING_BLOCK_SIZE;
-
-	/* Set */
-	SubString->Data = dsalloc(DataAllocLength);
+	/* Allocate a zeroed buffer, it
+	 * has an extra byte for null terminator */
+	MStringAllocate(SubString, DataLength);
 	SubString->Length = DataLength;
-	SubString->MaxLength = DataAllocLength;
-
-	/* Zero it */
-	memset(SubString->Data, 0, DataAllocLength);
 
 	/* Now copy data over, we know start index
 	 * and also the length of the data to copy */
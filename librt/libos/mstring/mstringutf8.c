@@ -156,14 +156,16 @@ mchar_t Utf8GetNextCharacterInString(const char *Str, int *Index)
 
 	/* Sanitize that index is within bounds 
 	 * otherwise the index is invalid 
-	 * and string is done */
-	if (Str == NULL || strlen(Str) <= (size_t)lIndex) {
+	 * and string is done. The index is never
+	 * advanced past the terminator */
+	if (Str == NULL || Str[lIndex] == '\0') {
 		goto Done;
 	}
 
 	/* Iterate while string is not EOS and 
-	 * while the given character is UTF8 flagged */
-	while (Str[lIndex] && IsUTF8(Str[lIndex])) {
+	 * while the given character is UTF8 flagged, a
+	 * character is never longer than the offset table */
+	while (Str[lIndex] && IsUTF8(Str[lIndex]) && Size < 6) {
 		/* Add byte to character and advance */
 		Character <<= 6;
 		Character += (unsigned char)Str[lIndex++];
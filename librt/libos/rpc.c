@@ -22,6 +22,7 @@
 /* Includes
  * - System */
 #include <os/syscall.h>
+#include <os/spinlock.h>
 #include <os/ipc/ipc.h>
 
 /* Includes
@@ -133,6 +134,189 @@ RPCCleanup(
 	return OsSuccess;
 }
 
+/* RPC Message Slot
+ * A slot holds a message header followed by room for all of its argument
+ * buffers, the header must come first so the message pointer handed out
+ * is also the slot pointer. Slots are carved out of slabs */
+typedef struct _MRemoteCallSlot {
+	MRemoteCall_t				 Message;
+	MRemoteCallArena_t			*Arena;
+	struct _MRemoteCallSlot		*Link;
+	uint8_t						 Payload[IPC_MAX_MESSAGELENGTH];
+} MRemoteCallSlot_t;
+
+typedef struct _MRemoteCallSlab {
+	struct _MRemoteCallSlab		*Link;
+	MRemoteCallSlot_t			 Slots[RPC_ARENA_SLAB_SLOTS];
+} MRemoteCallSlab_t;
+
+/* RPC Message Arena
+ * The free slots are kept in a list protected by a spinlock, the listener
+ * takes slots and workers return them. The arena only ever grows */
+struct _MRemoteCallArena {
+	Spinlock_t					 Lock;
+	MRemoteCallSlot_t			*FreeSlots;
+	MRemoteCallSlab_t			*Slabs;
+};
+
+/* RPCArenaInitialize
+ * Creates a new message arena for a server loop, the first slab is
+ * allocated up front */
+OsStatus_t
+RPCArenaInitialize(
+	_Out_ MRemoteCallArena_t **Arena)
+{
+	// Variables
+	MRemoteCallArena_t *Instance = NULL;
+
+	// Allocate a new instance
+	Instance = (MRemoteCallArena_t*)malloc(sizeof(MRemoteCallArena_t));
+	if (Instance == NULL) {
+		return OsError;
+	}
+	memset((void*)Instance, 0, sizeof(MRemoteCallArena_t));
+	SpinlockReset(&Instance->Lock);
+	*Arena = Instance;
+	return OsSuccess;
+}
+
+/* RPCArenaDestroy
+ * Frees all slabs of the arena, all messages taken
+ * from the arena must have been released */
+OsStatus_t
+RPCArenaDestroy(
+	_In_ MRemoteCallArena_t *Arena)
+{
+	// Variables
+	MRemoteCallSlab_t *Slab = Arena->Slabs;
+
+	while (Slab != NULL) {
+		MRemoteCallSlab_t *Next = Slab->Link;
+		free(Slab);
+		Slab = Next;
+	}
+	free(Arena);
+	return OsSuccess;
+}
+
+/* RPCArenaAcquire (Private)
+ * Takes a free slot from the arena, a new slab is
+ * allocated when the free list is empty */
+static MRemoteCallSlot_t*
+RPCArenaAcquire(
+	_In_ MRemoteCallArena_t *Arena)
+{
+	// Variables
+	MRemoteCallSlot_t *Slot = NULL;
+	MRemoteCallSlab_t *Slab = NULL;
+	int i;
+
+	SpinlockAcquire(&Arena->Lock);
+	Slot = Arena->FreeSlots;
+	if (Slot != NULL) {
+		Arena->FreeSlots = Slot->Link;
+	}
+	SpinlockRelease(&Arena->Lock);
+	if (Slot != NULL) {
+		return Slot;
+	}
+
+	// Grow the arena, the first slot is handed out directly
+	Slab = (MRemoteCallSlab_t*)malloc(sizeof(MRemoteCallSlab_t));
+	if (Slab == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < RPC_ARENA_SLAB_SLOTS; i++) {
+		Slab->Slots[i].Arena = Arena;
+		Slab->Slots[i].Link = (i + 1 < RPC_ARENA_SLAB_SLOTS) ? &Slab->Slots[i + 1] : NULL;
+	}
+
+	SpinlockAcquire(&Arena->Lock);
+	Slab->Link = Arena->Slabs;
+	Arena->Slabs = Slab;
+	Slab->Slots[RPC_ARENA_SLAB_SLOTS - 1].Link = Arena->FreeSlots;
+	Arena->FreeSlots = &Slab->Slots[1];
+	SpinlockRelease(&Arena->Lock);
+	return &Slab->Slots[0];
+}
+
+/* RPCListenArena
+ * Waits for a new RPC message and reads the header and all arguments
+ * into a slot from the arena. The message must be given back with
+ * RPCRelease once handled, it may be handed to other threads until then */
+OsStatus_t
+RPCListenArena(
+	_In_ MRemoteCallArena_t *Arena,
+	_Out_ MRemoteCall_t **Message)
+{
+	// Variables
+	MRemoteCallSlot_t *Slot = NULL;
+	size_t Offset = 0;
+	int Overflow = 0;
+	int i;
+
+	// Get a slot before waiting so the header can be read directly into it
+	Slot = RPCArenaAcquire(Arena);
+	if (Slot == NULL) {
+		return OsError;
+	}
+
+	if (PipeRead(PIPE_RPCOUT, &Slot->Message, sizeof(MRemoteCall_t)) != OsSuccess) {
+		RPCRelease(&Slot->Message);
+		return OsError;
+	}
+
+	// The arguments are packed back to back in the payload, arguments
+	// that don't fit are drained from the pipe and the message is dropped
+	for (i = 0; i < IPC_MAX_ARGUMENTS; i++) {
+		RPCArgument_t *Argument = &Slot->Message.Arguments[i];
+		if (Argument->Type == ARGUMENT_BUFFER) {
+			if (Overflow || Argument->Length > (IPC_MAX_MESSAGELENGTH - Offset)) {
+				size_t Remaining = Argument->Length;
+				while (Remaining != 0) {
+					size_t Chunk = MIN(Remaining, IPC_MAX_MESSAGELENGTH);
+					PipeRead(PIPE_RPCOUT, &Slot->Payload[0], Chunk);
+					Remaining -= Chunk;
+				}
+				Overflow = 1;
+				continue;
+			}
+			Argument->Data.Buffer = (__CONST void*)&Slot->Payload[Offset];
+			PipeRead(PIPE_RPCOUT, &Slot->Payload[Offset], Argument->Length);
+			Offset += Argument->Length;
+		}
+		else if (Argument->Type == ARGUMENT_NOTUSED) {
+			Argument->Data.Buffer = NULL;
+			Argument->Length = 0;
+		}
+	}
+
+	if (Overflow) {
+		RPCRelease(&Slot->Message);
+		return OsError;
+	}
+	*Message = &Slot->Message;
+	return OsSuccess;
+}
+
+/* RPCRelease
+ * Returns a message received by RPCListenArena to its arena, the
+ * argument buffers of the message are invalid afterwards */
+OsStatus_t
+RPCRelease(
+	_In_ MRemoteCall_t *Message)
+{
+	// Variables
+	MRemoteCallSlot_t *Slot = (MRemoteCallSlot_t*)Message;
+	MRemoteCallArena_t *Arena = Slot->Arena;
+
+	SpinlockAcquire(&Arena->Lock);
+	Slot->Link = Arena->FreeSlots;
+	Arena->FreeSlots = Slot;
+	SpinlockRelease(&Arena->Lock);
+	return OsSuccess;
+}
+
 /* RPCRespond
  * This is a wrapper to return a respond message/buffer to the
  * sender of the message, it's good practice to always wait for
@@ -147,6 +331,250 @@ RPCRespond(
 	return PipeSend(Rpc->Sender, Rpc->ResponsePort, (void*)Buffer, Length);
 }
 
+/* RPC Queue Request
+ * The result buffer and context of a request in flight, the
+ * index of the request in the queue is the request id */
+typedef struct _MRemoteCallRequest {
+	int							 InUse;
+	void						*Buffer;
+	size_t						 Length;
+	void						*Context;
+} MRemoteCallRequest_t;
+
+struct _MRemoteCallQueue {
+	int							 Port;
+	size_t						 Depth;
+	size_t						 InFlight;
+	int							*FreeIds;
+	size_t						 FreeCount;
+	MRemoteCallRequest_t		*Requests;
+};
+
+/* RPCQueueInitialize
+ * Creates a new queue for asynchronous requests, the queue opens a pipe
+ * on the given port that replies are received on */
+OsStatus_t
+RPCQueueInitialize(
+	_In_ int Port,
+	_In_ size_t Depth,
+	_Out_ MRemoteCallQueue_t **Queue)
+{
+	// Variables
+	MRemoteCallQueue_t *Instance = NULL;
+	size_t i;
+
+	// Sanitize the parameters, the port must fit in an async port
+	if (Port <= PIPE_RPCIN || Port > PIPE_ASYNC_MAXPORT
+		|| Depth == 0 || Depth > RPC_QUEUE_MAX_DEPTH) {
+		return OsError;
+	}
+
+	// Allocate the queue and the request table
+	Instance = (MRemoteCallQueue_t*)malloc(sizeof(MRemoteCallQueue_t));
+	if (Instance == NULL) {
+		return OsError;
+	}
+	memset((void*)Instance, 0, sizeof(MRemoteCallQueue_t));
+	Instance->Port = Port;
+	Instance->Depth = Depth;
+	Instance->FreeIds = (int*)malloc(Depth * sizeof(int));
+	Instance->Requests = (MRemoteCallRequest_t*)malloc(Depth * sizeof(MRemoteCallRequest_t));
+	if (Instance->FreeIds == NULL || Instance->Requests == NULL) {
+		free(Instance->FreeIds);
+		free(Instance->Requests);
+		free(Instance);
+		return OsError;
+	}
+	memset((void*)Instance->Requests, 0, Depth * sizeof(MRemoteCallRequest_t));
+
+	// Ids are handed out from the top of the stack, so the lowest first
+	for (i = 0; i < Depth; i++) {
+		Instance->FreeIds[i] = (int)(Depth - i - 1);
+	}
+	Instance->FreeCount = Depth;
+
+	if (Syscall1(SYSCALL_OPENPIPE, SYSCALL_PARAM(Port)) != OsSuccess) {
+		free(Instance->FreeIds);
+		free(Instance->Requests);
+		free(Instance);
+		return OsError;
+	}
+	*Queue = Instance;
+	return OsSuccess;
+}
+
+/* RPCQueueDestroy
+ * Closes the pipe of the queue and frees it, replies to
+ * requests that are still in flight are lost */
+OsStatus_t
+RPCQueueDestroy(
+	_In_ MRemoteCallQueue_t *Queue)
+{
+	Syscall1(SYSCALL_CLOSEPIPE, SYSCALL_PARAM(Queue->Port));
+	free(Queue->FreeIds);
+	free(Queue->Requests);
+	free(Queue);
+	return OsSuccess;
+}
+
+/* RPCSubmit
+ * Sends the request without waiting for the reply, the reply is read into
+ * the result buffer of the request by RPCPoll or RPCWait. The result buffer
+ * must stay valid until the request has completed */
+OsStatus_t
+RPCSubmit(
+	_In_ MRemoteCallQueue_t *Queue,
+	_In_ MRemoteCall_t *Rpc,
+	_In_ UUId_t Target,
+	_In_Opt_ void *Context,
+	_Out_Opt_ int *RequestId)
+{
+	// Variables
+	MRemoteCallRequest_t *Request = NULL;
+	int Id;
+
+	// Sanitize that there is room for another request
+	if (Queue->FreeCount == 0) {
+		return OsError;
+	}
+	Id = Queue->FreeIds[--Queue->FreeCount];
+	Request = &Queue->Requests[Id];
+
+	// Store the result buffer before the request can complete
+	Request->InUse = 1;
+	Request->Context = Context;
+	if (Rpc->Result.Type == ARGUMENT_BUFFER) {
+		Request->Buffer = (void*)Rpc->Result.Data.Buffer;
+		Request->Length = Rpc->Result.Length;
+	}
+	else {
+		Request->Buffer = NULL;
+		Request->Length = 0;
+	}
+
+	// The reply is sent to the async port that identifies the request
+	Rpc->ResponsePort = PIPE_ASYNC_PORT(Queue->Port, Id);
+	if (RPCEvent(Rpc, Target) != OsSuccess) {
+		Request->InUse = 0;
+		Queue->FreeIds[Queue->FreeCount++] = Id;
+		return OsError;
+	}
+	Queue->InFlight++;
+	if (RequestId != NULL) {
+		*RequestId = Id;
+	}
+	return OsSuccess;
+}
+
+/* RPCQueueReceive (Private)
+ * Reads the next reply from the queue pipe into the result buffer of
+ * its request, bytes that don't fit the result buffer are discarded.
+ * Returns 1 if a request completed, 0 if the reply was stale and -1 on errors */
+static int
+RPCQueueReceive(
+	_In_ MRemoteCallQueue_t *Queue,
+	_Out_ MRemoteCallCompletion_t *Completion)
+{
+	// Variables
+	MRemoteCallRequest_t *Request = NULL;
+	MRemoteCallReply_t Reply;
+	size_t BytesToCopy = 0;
+
+	if (PipeRead(Queue->Port, &Reply, sizeof(MRemoteCallReply_t)) != OsSuccess) {
+		return -1;
+	}
+
+	// Replies for ids that are not in flight are consumed and ignored
+	if (Reply.RequestId < 0 || (size_t)Reply.RequestId >= Queue->Depth
+		|| !Queue->Requests[Reply.RequestId].InUse) {
+		if (Reply.Length != 0) {
+			PipeRead(Queue->Port, NULL, Reply.Length);
+		}
+		return 0;
+	}
+	Request = &Queue->Requests[Reply.RequestId];
+
+	BytesToCopy = MIN(Reply.Length, Request->Length);
+	if (BytesToCopy != 0) {
+		PipeRead(Queue->Port, Request->Buffer, BytesToCopy);
+	}
+	if (Reply.Length > BytesToCopy) {
+		PipeRead(Queue->Port, NULL, Reply.Length - BytesToCopy);
+	}
+
+	// Complete the request and recycle the id
+	Completion->RequestId = Reply.RequestId;
+	Completion->Context = Request->Context;
+	Completion->Length = BytesToCopy;
+	Request->InUse = 0;
+	Queue->FreeIds[Queue->FreeCount++] = Reply.RequestId;
+	Queue->InFlight--;
+	return 1;
+}
+
+/* RPCQueueReady (Private)
+ * Peeks the queue pipe for a reply, replies are written in one go
+ * so a visible reply header means the entire reply is there */
+static int
+RPCQueueReady(
+	_In_ MRemoteCallQueue_t *Queue)
+{
+	// Variables
+	MRemoteCallReply_t Reply;
+	return Syscall4(SYSCALL_READPIPE, SYSCALL_PARAM(Queue->Port),
+		SYSCALL_PARAM(&Reply), SYSCALL_PARAM(sizeof(MRemoteCallReply_t)), 1) == OsSuccess;
+}
+
+/* RPCPoll
+ * Collects up to Count completed requests without blocking,
+ * returns the number of completions filled in */
+int
+RPCPoll(
+	_In_ MRemoteCallQueue_t *Queue,
+	_Out_ MRemoteCallCompletion_t *Completions,
+	_In_ int Count)
+{
+	return RPCWait(Queue, Completions, Count, 0);
+}
+
+/* RPCWait
+ * Blocks until at least MinCount requests have completed and collects up to
+ * Count completions, returns the number of completions filled in or -1 if
+ * fewer than MinCount requests are in flight */
+int
+RPCWait(
+	_In_ MRemoteCallQueue_t *Queue,
+	_Out_ MRemoteCallCompletion_t *Completions,
+	_In_ int Count,
+	_In_ int MinCount)
+{
+	// Variables
+	int Completed = 0;
+	int Status = 0;
+
+	// Sanitize the parameters
+	if (MinCount > Count) {
+		MinCount = Count;
+	}
+	if ((size_t)MinCount > Queue->InFlight) {
+		return -1;
+	}
+
+	// Block for replies until we have the minimum, then take
+	// whatever else has already arrived
+	while (Completed < Count && Queue->InFlight != 0) {
+		if (Completed >= MinCount && !RPCQueueReady(Queue)) {
+			break;
+		}
+		Status = RPCQueueReceive(Queue, &Completions[Completed]);
+		if (Status < 0) {
+			break;
+		}
+		Completed += Status;
+	}
+	return Completed;
+}
+
 /* IPC - Sleep
  * This suspends the current process-thread
  * and puts it in a sleep state untill either
@@ -20,32 +20,39 @@
  * - This header describes the base sha1-structures, prototypes
  *   and functionality, refer to the individual things for descriptions
  */
-#define SHA1HANDSOFF
-
 /* Includes 
  * - System */
 #include <os/sha1.h>
 
 /* Includes
  * - Library */
+#include <cpuid.h>
+#include <immintrin.h>
 #include <stdio.h>
 #include <string.h>
 
-void Sha1Transform(int handsoff, uint32_t state[5], const uint8_t buffer[64]);
+/* Definitions CPUID */
+#define CPUID_FEAT_ECX_SSSE3        (1 << 9)
+#define CPUID_FEAT_ECX_SSE41        (1 << 19)
+#define CPUID_EXTFEAT_EBX_SHA       (1 << 29)
+
+/* Transform target attributes, the transforms are compiled for their own
+ * instruction set no matter what the rest of the library targets */
+#define SHA1_SSSE3_TARGET           __attribute__((target("ssse3")))
+#define SHA1_SHANI_TARGET           __attribute__((target("sha,sse4.1")))
+
+/* Sha1Transform
+ * Hashes a number of consecutive 512-bit blocks into the state */
+typedef void (*Sha1Transform_t)(uint32_t State[5], const uint8_t *Data, size_t Blocks);
 
 #define rol(value, bits) (((value) << (bits)) | ((value) >> (32 - (bits))))
 
 /* blk0() and blk() perform the initial expand. */
 /* I got the idea of expanding during the round function from SSLeay */
-/* FIXME: can we do this in an endian-proof way? */
-#ifdef WORDS_BIGENDIAN
-#define blk0(i) block->l[i]
-#else
-#define blk0(i) (block->l[i] = (rol(block->l[i],24)&0xFF00FF00) \
-    |(rol(block->l[i],8)&0x00FF00FF))
-#endif
-#define blk(i) (block->l[i&15] = rol(block->l[(i+13)&15]^block->l[(i+8)&15] \
-    ^block->l[(i+2)&15]^block->l[i&15],1))
+#define blk0(i) (W[i] = ((uint32_t)Data[i * 4] << 24) | ((uint32_t)Data[i * 4 + 1] << 16) \
+    | ((uint32_t)Data[i * 4 + 2] << 8) | (uint32_t)Data[i * 4 + 3])
+#define blk(i) (W[i&15] = rol(W[(i+13)&15]^W[(i+8)&15] \
+    ^W[(i+2)&15]^W[i&15],1))
 
 /* (R0+R1), R2, R3, R4 are the different operations used in SHA1 */
 #define R0(v,w,x,y,z,i) z+=((w&(x^y))^y)+blk0(i)+0x5A827999+rol(v,5);w=rol(w,30);
@@ -54,70 +61,272 @@ void Sha1Transform(int handsoff, uint32_t state[5], const uint8_t buffer[64]);
 #define R3(v,w,x,y,z,i) z+=(((w|x)&y)|(w&x))+blk(i)+0x8F1BBCDC+rol(v,5);w=rol(w,30);
 #define R4(v,w,x,y,z,i) z+=(w^x^y)+blk(i)+0xCA62C1D6+rol(v,5);w=rol(w,30);
 
-/* Hash a single 512-bit block. This is the core of the algorithm. */
-void Sha1Transform(int handsoff, uint32_t state[5], const uint8_t buffer[64])
+/* The rounds of the vector transform take the message word and
+ * the round constant added together from the schedule */
+#define F0(w,x,y) ((w&(x^y))^y)
+#define F1(w,x,y) (w^x^y)
+#define F2(w,x,y) (((w|x)&y)|(w&x))
+#define RK(F,v,w,x,y,z,i) z+=F(w,x,y)+WK[i]+rol(v,5);w=rol(w,30);
+
+/* Sha1TransformScalar (Private)
+ * Hashes the blocks, the message schedule is expanded in a 16 word
+ * window on the stack so the data itself is never modified. */
+static void
+Sha1TransformScalar(
+	_In_ uint32_t State[5],
+	_In_ const uint8_t *Data,
+	_In_ size_t Blocks)
 {
-	static uint8_t workspace[64];
 	uint32_t a, b, c, d, e;
-	typedef union {
-		uint8_t c[64];
-		uint32_t l[16];
-	} CHAR64LONG16;
-	CHAR64LONG16 *block;
-
-	if (handsoff) {
-		block = (CHAR64LONG16 *)workspace;
-		memcpy(block, buffer, 64);
+	uint32_t W[16];
+
+	for (; Blocks != 0; Blocks--, Data += 64) {
+		/* Copy context->state[] to working vars */
+		a = State[0];
+		b = State[1];
+		c = State[2];
+		d = State[3];
+		e = State[4];
+
+		/* 4 rounds of 20 operations each. Loop unrolled. */
+		R0(a, b, c, d, e, 0); R0(e, a, b, c, d, 1); R0(d, e, a, b, c, 2); R0(c, d, e, a, b, 3);
+		R0(b, c, d, e, a, 4); R0(a, b, c, d, e, 5); R0(e, a, b, c, d, 6); R0(d, e, a, b, c, 7);
+		R0(c, d, e, a, b, 8); R0(b, c, d, e, a, 9); R0(a, b, c, d, e, 10); R0(e, a, b, c, d, 11);
+		R0(d, e, a, b, c, 12); R0(c, d, e, a, b, 13); R0(b, c, d, e, a, 14); R0(a, b, c, d, e, 15);
+		R1(e, a, b, c, d, 16); R1(d, e, a, b, c, 17); R1(c, d, e, a, b, 18); R1(b, c, d, e, a, 19);
+		R2(a, b, c, d, e, 20); R2(e, a, b, c, d, 21); R2(d, e, a, b, c, 22); R2(c, d, e, a, b, 23);
+		R2(b, c, d, e, a, 24); R2(a, b, c, d, e, 25); R2(e, a, b, c, d, 26); R2(d, e, a, b, c, 27);
+		R2(c, d, e, a, b, 28); R2(b, c, d, e, a, 29); R2(a, b, c, d, e, 30); R2(e, a, b, c, d, 31);
+		R2(d, e, a, b, c, 32); R2(c, d, e, a, b, 33); R2(b, c, d, e, a, 34); R2(a, b, c, d, e, 35);
+		R2(e, a, b, c, d, 36); R2(d, e, a, b, c, 37); R2(c, d, e, a, b, 38); R2(b, c, d, e, a, 39);
+		R3(a, b, c, d, e, 40); R3(e, a, b, c, d, 41); R3(d, e, a, b, c, 42); R3(c, d, e, a, b, 43);
+		R3(b, c, d, e, a, 44); R3(a, b, c, d, e, 45); R3(e, a, b, c, d, 46); R3(d, e, a, b, c, 47);
+		R3(c, d, e, a, b, 48); R3(b, c, d, e, a, 49); R3(a, b, c, d, e, 50); R3(e, a, b, c, d, 51);
+		R3(d, e, a, b, c, 52); R3(c, d, e, a, b, 53); R3(b, c, d, e, a, 54); R3(a, b, c, d, e, 55);
+		R3(e, a, b, c, d, 56); R3(d, e, a, b, c, 57); R3(c, d, e, a, b, 58); R3(b, c, d, e, a, 59);
+		R4(a, b, c, d, e, 60); R4(e, a, b, c, d, 61); R4(d, e, a, b, c, 62); R4(c, d, e, a, b, 63);
+		R4(b, c, d, e, a, 64); R4(a, b, c, d, e, 65); R4(e, a, b, c, d, 66); R4(d, e, a, b, c, 67);
+		R4(c, d, e, a, b, 68); R4(b, c, d, e, a, 69); R4(a, b, c, d, e, 70); R4(e, a, b, c, d, 71);
+		R4(d, e, a, b, c, 72); R4(c, d, e, a, b, 73); R4(b, c, d, e, a, 74); R4(a, b, c, d, e, 75);
+		R4(e, a, b, c, d, 76); R4(d, e, a, b, c, 77); R4(c, d, e, a, b, 78); R4(b, c, d, e, a, 79);
+
+		/* Add the working vars back into context.state[] */
+		State[0] += a;
+		State[1] += b;
+		State[2] += c;
+		State[3] += d;
+		State[4] += e;
 	}
-	else {
-		block = (CHAR64LONG16 *)buffer;
+}
+
+/* Sha1Rotate (Private)
+ * Rotates the four words of the vector left */
+SHA1_SSSE3_TARGET
+static inline __m128i
+Sha1Rotate(
+	_In_ __m128i Value,
+	_In_ int Bits)
+{
+	return _mm_or_si128(_mm_slli_epi32(Value, Bits), _mm_srli_epi32(Value, 32 - Bits));
+}
+
+/* Sha1TransformSsse3 (Private)
+ * Hashes the blocks, the message schedule is expanded four words at the
+ * time with the round constants added and the rounds consume it. Words
+ * 16-31 need the last word of the vector fixed up as it depends on the
+ * first, from word 32 W[i] = (W[i-6]^W[i-16]^W[i-28]^W[i-32]) rol 2. */
+SHA1_SSSE3_TARGET
+static void
+Sha1TransformSsse3(
+	_In_ uint32_t State[5],
+	_In_ const uint8_t *Data,
+	_In_ size_t Blocks)
+{
+	const __m128i Swap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11,
+		4, 5, 6, 7, 0, 1, 2, 3);
+	const __m128i K[4] = {
+		_mm_set1_epi32(0x5A827999), _mm_set1_epi32(0x6ED9EBA1),
+		_mm_set1_epi32(0x8F1BBCDC), _mm_set1_epi32(0xCA62C1D6)
+	};
+	uint32_t WK[80] __attribute__((aligned(16)));
+	uint32_t a, b, c, d, e;
+	__m128i W[20], Value;
+	int i;
+
+	for (; Blocks != 0; Blocks--, Data += 64) {
+		for (i = 0; i < 4; i++) {
+			W[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(Data + i * 16)), Swap);
+		}
+		for (i = 4; i < 8; i++) {
+			Value = _mm_xor_si128(_mm_srli_si128(W[i - 1], 4), W[i - 2]);
+			Value = _mm_xor_si128(Value, _mm_alignr_epi8(W[i - 3], W[i - 4], 8));
+			Value = Sha1Rotate(_mm_xor_si128(Value, W[i - 4]), 1);
+			W[i] = _mm_xor_si128(Value, Sha1Rotate(_mm_slli_si128(Value, 12), 1));
+		}
+		for (i = 8; i < 20; i++) {
+			Value = _mm_xor_si128(_mm_alignr_epi8(W[i - 1], W[i - 2], 8), W[i - 4]);
+			Value = _mm_xor_si128(Value, _mm_xor_si128(W[i - 7], W[i - 8]));
+			W[i] = Sha1Rotate(Value, 2);
+		}
+		for (i = 0; i < 20; i++) {
+			_mm_store_si128((__m128i*)&WK[i * 4], _mm_add_epi32(W[i], K[i / 5]));
+		}
+
+		a = State[0];
+		b = State[1];
+		c = State[2];
+		d = State[3];
+		e = State[4];
+
+		for (i = 0; i < 20; i += 5) {
+			RK(F0, a, b, c, d, e, i + 0); RK(F0, e, a, b, c, d, i + 1); RK(F0, d, e, a, b, c, i + 2);
+			RK(F0, c, d, e, a, b, i + 3); RK(F0, b, c, d, e, a, i + 4);
+		}
+		for (i = 20; i < 40; i += 5) {
+			RK(F1, a, b, c, d, e, i + 0); RK(F1, e, a, b, c, d, i + 1); RK(F1, d, e, a, b, c, i + 2);
+			RK(F1, c, d, e, a, b, i + 3); RK(F1, b, c, d, e, a, i + 4);
+		}
+		for (i = 40; i < 60; i += 5) {
+			RK(F2, a, b, c, d, e, i + 0); RK(F2, e, a, b, c, d, i + 1); RK(F2, d, e, a, b, c, i + 2);
+			RK(F2, c, d, e, a, b, i + 3); RK(F2, b, c, d, e, a, i + 4);
+		}
+		for (i = 60; i < 80; i += 5) {
+			RK(F1, a, b, c, d, e, i + 0); RK(F1, e, a, b, c, d, i + 1); RK(F1, d, e, a, b, c, i + 2);
+			RK(F1, c, d, e, a, b, i + 3); RK(F1, b, c, d, e, a, i + 4);
+		}
+
+		State[0] += a;
+		State[1] += b;
+		State[2] += c;
+		State[3] += d;
+		State[4] += e;
 	}
+}
 
-	/* Copy context->state[] to working vars */
-	a = state[0];
-	b = state[1];
-	c = state[2];
-	d = state[3];
-	e = state[4];
-
-	/* 4 rounds of 20 operations each. Loop unrolled. */
-	R0(a, b, c, d, e, 0); R0(e, a, b, c, d, 1); R0(d, e, a, b, c, 2); R0(c, d, e, a, b, 3);
-	R0(b, c, d, e, a, 4); R0(a, b, c, d, e, 5); R0(e, a, b, c, d, 6); R0(d, e, a, b, c, 7);
-	R0(c, d, e, a, b, 8); R0(b, c, d, e, a, 9); R0(a, b, c, d, e, 10); R0(e, a, b, c, d, 11);
-	R0(d, e, a, b, c, 12); R0(c, d, e, a, b, 13); R0(b, c, d, e, a, 14); R0(a, b, c, d, e, 15);
-	R1(e, a, b, c, d, 16); R1(d, e, a, b, c, 17); R1(c, d, e, a, b, 18); R1(b, c, d, e, a, 19);
-	R2(a, b, c, d, e, 20); R2(e, a, b, c, d, 21); R2(d, e, a, b, c, 22); R2(c, d, e, a, b, 23);
-	R2(b, c, d, e, a, 24); R2(a, b, c, d, e, 25); R2(e, a, b, c, d, 26); R2(d, e, a, b, c, 27);
-	R2(c, d, e, a, b, 28); R2(b, c, d, e, a, 29); R2(a, b, c, d, e, 30); R2(e, a, b, c, d, 31);
-	R2(d, e, a, b, c, 32); R2(c, d, e, a, b, 33); R2(b, c, d, e, a, 34); R2(a, b, c, d, e, 35);
-	R2(e, a, b, c, d, 36); R2(d, e, a, b, c, 37); R2(c, d, e, a, b, 38); R2(b, c, d, e, a, 39);
-	R3(a, b, c, d, e, 40); R3(e, a, b, c, d, 41); R3(d, e, a, b, c, 42); R3(c, d, e, a, b, 43);
-	R3(b, c, d, e, a, 44); R3(a, b, c, d, e, 45); R3(e, a, b, c, d, 46); R3(d, e, a, b, c, 47);
-	R3(c, d, e, a, b, 48); R3(b, c, d, e, a, 49); R3(a, b, c, d, e, 50); R3(e, a, b, c, d, 51);
-	R3(d, e, a, b, c, 52); R3(c, d, e, a, b, 53); R3(b, c, d, e, a, 54); R3(a, b, c, d, e, 55);
-	R3(e, a, b, c, d, 56); R3(d, e, a, b, c, 57); R3(c, d, e, a, b, 58); R3(b, c, d, e, a, 59);
-	R4(a, b, c, d, e, 60); R4(e, a, b, c, d, 61); R4(d, e, a, b, c, 62); R4(c, d, e, a, b, 63);
-	R4(b, c, d, e, a, 64); R4(a, b, c, d, e, 65); R4(e, a, b, c, d, 66); R4(d, e, a, b, c, 67);
-	R4(c, d, e, a, b, 68); R4(b, c, d, e, a, 69); R4(a, b, c, d, e, 70); R4(e, a, b, c, d, 71);
-	R4(d, e, a, b, c, 72); R4(c, d, e, a, b, 73); R4(b, c, d, e, a, 74); R4(a, b, c, d, e, 75);
-	R4(e, a, b, c, d, 76); R4(d, e, a, b, c, 77); R4(c, d, e, a, b, 78); R4(b, c, d, e, a, 79);
-
-	/* Add the working vars back into context.state[] */
-	state[0] += a;
-	state[1] += b;
-	state[2] += c;
-	state[3] += d;
-	state[4] += e;
+/* SHA1_SHANI_ROUNDS
+ * Runs the four rounds of group G with the message Mc, the next E is
+ * computed into Ein and the state before the rounds is saved in Esave.
+ * The schedule of the following groups is advanced in the same go */
+#define SHA1_SHANI_ROUNDS(G, F, Ein, Esave, Mc, Mn1, Mn2, Mp) \
+	Ein = _mm_sha1nexte_epu32(Ein, Mc); \
+	Esave = Abcd; \
+	if (G >= 3 && G <= 18) Mn1 = _mm_sha1msg2_epu32(Mn1, Mc); \
+	Abcd = _mm_sha1rnds4_epu32(Abcd, Ein, F); \
+	if (G >= 1 && G <= 16) Mp = _mm_sha1msg1_epu32(Mp, Mc); \
+	if (G >= 2 && G <= 17) Mn2 = _mm_xor_si128(Mn2, Mc);
 
-	/* Wipe variables */
-	a = b = c = d = e = 0;
+/* Sha1TransformShaNi (Private)
+ * Hashes the blocks with the sha extensions, each instruction
+ * runs four rounds or four words of the schedule */
+SHA1_SHANI_TARGET
+static void
+Sha1TransformShaNi(
+	_In_ uint32_t State[5],
+	_In_ const uint8_t *Data,
+	_In_ size_t Blocks)
+{
+	const __m128i Swap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+		8, 9, 10, 11, 12, 13, 14, 15);
+	__m128i Abcd, AbcdSave, E0, E0Save, E1;
+	__m128i M0, M1, M2, M3;
+
+	// The state is kept as DCBA and E in the top word
+	Abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)State), 0x1B);
+	E0 = _mm_set_epi32((int)State[4], 0, 0, 0);
+
+	for (; Blocks != 0; Blocks--, Data += 64) {
+		AbcdSave = Abcd;
+		E0Save = E0;
+
+		M0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(Data + 0)), Swap);
+		M1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(Data + 16)), Swap);
+		M2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(Data + 32)), Swap);
+		M3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(Data + 48)), Swap);
+
+		// Rounds 0-3 add the message to E directly
+		E0 = _mm_add_epi32(E0, M0);
+		E1 = Abcd;
+		Abcd = _mm_sha1rnds4_epu32(Abcd, E0, 0);
+
+		SHA1_SHANI_ROUNDS(1, 0, E1, E0, M1, M2, M3, M0);
+		SHA1_SHANI_ROUNDS(2, 0, E0, E1, M2, M3, M0, M1);
+		SHA1_SHANI_ROUNDS(3, 0, E1, E0, M3, M0, M1, M2);
+		SHA1_SHANI_ROUNDS(4, 0, E0, E1, M0, M1, M2, M3);
+		SHA1_SHANI_ROUNDS(5, 1, E1, E0, M1, M2, M3, M0);
+		SHA1_SHANI_ROUNDS(6, 1, E0, E1, M2, M3, M0, M1);
+		SHA1_SHANI_ROUNDS(7, 1, E1, E0, M3, M0, M1, M2);
+		SHA1_SHANI_ROUNDS(8, 1, E0, E1, M0, M1, M2, M3);
+		SHA1_SHANI_ROUNDS(9, 1, E1, E0, M1, M2, M3, M0);
+		SHA1_SHANI_ROUNDS(10, 2, E0, E1, M2, M3, M0, M1);
+		SHA1_SHANI_ROUNDS(11, 2, E1, E0, M3, M0, M1, M2);
+		SHA1_SHANI_ROUNDS(12, 2, E0, E1, M0, M1, M2, M3);
+		SHA1_SHANI_ROUNDS(13, 2, E1, E0, M1, M2, M3, M0);
+		SHA1_SHANI_ROUNDS(14, 2, E0, E1, M2, M3, M0, M1);
+		SHA1_SHANI_ROUNDS(15, 3, E1, E0, M3, M0, M1, M2);
+		SHA1_SHANI_ROUNDS(16, 3, E0, E1, M0, M1, M2, M3);
+		SHA1_SHANI_ROUNDS(17, 3, E1, E0, M1, M2, M3, M0);
+		SHA1_SHANI_ROUNDS(18, 3, E0, E1, M2, M3, M0, M1);
+		SHA1_SHANI_ROUNDS(19, 3, E1, E0, M3, M0, M1, M2);
+
+		E0 = _mm_sha1nexte_epu32(E0, E0Save);
+		Abcd = _mm_add_epi32(Abcd, AbcdSave);
+	}
+
+	_mm_storeu_si128((__m128i*)State, _mm_shuffle_epi32(Abcd, 0x1B));
+	State[4] = (uint32_t)_mm_extract_epi32(E0, 3);
+}
+
+/* Globals
+ * The transform table is indexed by level, the transform is
+ * selected by cpuid the first time a context is initialized.
+ * Only the sha extensions are used without Sha1Select */
+static const Sha1Transform_t GlbSha1Transforms[3] = {
+	Sha1TransformScalar,
+	Sha1TransformSsse3,
+	Sha1TransformShaNi
+};
+static Sha1Transform_t GlbSha1Transform = NULL;
+
+/* Sha1QueryLevel (Private)
+ * Queries the highest level supported by the cpu */
+static int Sha1QueryLevel(void)
+{
+	unsigned int Eax = 0, Ebx = 0, Ecx = 0, Edx = 0;
+	int Level = SHA1_SCALAR;
+
+	if (!__get_cpuid(1, &Eax, &Ebx, &Ecx, &Edx)) {
+		return Level;
+	}
+	if (Ecx & CPUID_FEAT_ECX_SSSE3) {
+		Level = SHA1_SSSE3;
+		if ((Ecx & CPUID_FEAT_ECX_SSE41) && __get_cpuid_max(0, NULL) >= 7) {
+			__cpuid_count(7, 0, Eax, Ebx, Ecx, Edx);
+			if (Ebx & CPUID_EXTFEAT_EBX_SHA) {
+				Level = SHA1_SHANI;
+			}
+		}
+	}
+	return Level;
+}
+
+/* Sha1Select
+ * Overrides the transform with the given level, used for benchmarking.
+ * Returns OsError if the cpu does not support the level. */
+OsStatus_t
+Sha1Select(
+	_In_ int Level)
+{
+	if (Level < SHA1_SCALAR || Level > Sha1QueryLevel()) {
+		return OsError;
+	}
+	GlbSha1Transform = GlbSha1Transforms[Level];
+	return OsSuccess;
 }
 
 /* Sha1Init
- * Initializes a new SHA1 context 
- * using either an internal buffer for 
- * hashing by setting handsoff to 1, otherwise
- * it will destroy the given data buffers */
+ * Initializes a new SHA1 context, the given data
+ * buffers are never modified so handsoff is only
+ * kept for compatibility */
 OsStatus_t
 Sha1Init(
 	_In_ Sha1Context_t *Context, 
@@ -134,6 +343,12 @@ Sha1Init(
 	Context->state[4] = 0xC3D2E1F0;
 	Context->count[0] = Context->count[1] = 0;
 
+	/* Select the transform on first use, the ssse3 transform is
+	 * not faster than the scalar one and must be selected explicitly */
+	if (GlbSha1Transform == NULL) {
+		GlbSha1Transform = GlbSha1Transforms[
+			Sha1QueryLevel() == SHA1_SHANI ? SHA1_SHANI : SHA1_SCALAR];
+	}
 	return OsSuccess;
 }
 
@@ -155,9 +370,10 @@ Sha1Add(
 	Context->count[1] += (Length >> 29);
 	if ((j + Length) > 63) {
 		memcpy(&Context->buffer[j], Data, (i = 64 - j));
-		Sha1Transform(Context->handsoff, Context->state, Context->buffer);
-		for (; i + 63 < Length; i += 64) {
-			Sha1Transform(Context->handsoff, Context->state, Data + i);
+		GlbSha1Transform(Context->state, Context->buffer, 1);
+		if (Length - i >= 64) {
+			GlbSha1Transform(Context->state, Data + i, (Length - i) / 64);
+			i += (Length - i) & ~((size_t)63);
 		}
 		j = 0;
 	}
@@ -176,6 +392,7 @@ Sha1Finalize(
 	_Out_ uint8_t Digest[SHA1_DIGEST_SIZE])
 {
 	/* Variables */
+	static const uint8_t padding[64] = { 0x80 };
 	uint32_t i;
 	uint8_t finalcount[8];
 
@@ -183,10 +400,10 @@ Sha1Finalize(
 		finalcount[i] = (unsigned char)((Context->count[(i >= 4 ? 0 : 1)]
 			>> ((3 - (i & 3)) * 8)) & 255);        /* Endian independent */
 	}
-	Sha1Add(Context, (uint8_t *) "\200", 1);
-	while ((Context->count[0] & 504) != 448) {
-		Sha1Add(Context, (uint8_t *) "\0", 1);
-	}
+
+	/* Pad to 56 bytes into the last block in one go */
+	i = (Context->count[0] >> 3) & 63;
+	Sha1Add(Context, padding, (i < 56) ? (56 - i) : (120 - i));
 	Sha1Add(Context, finalcount, 8);        /* Should cause a SHA1_Transform() */
 	for (i = 0; i < SHA1_DIGEST_SIZE; i++) {
 		Digest[i] = (uint8_t)
@@ -199,12 +416,6 @@ Sha1Finalize(
 	memset(Context->state, 0, 20);
 	memset(Context->count, 0, 8);
 	memset(finalcount, 0, 8);   /* SWR */
-
-	if (Context->handsoff) {
-		/* make SHA1Transform overwrite its own static vars */
-		Sha1Transform(Context->handsoff, Context->state, Context->buffer);
-	}
-
 	return OsSuccess;
 }
 
@@ -52,8 +52,8 @@ FsOpenFile(
 	Mfs = (MfsInstance_t*)Descriptor->ExtensionData;
 
 	// Try to locate the given file-record
-	Result = MfsLocateRecord(Descriptor, Mfs->MasterRecord.RootIndex, 
-		Path, &fInformation);
+	Result = MfsLocateRecord(Descriptor, Mfs->MasterRecord.RootIndex,
+		MFS_ROOTFLAGS(Mfs), Path, &fInformation);
 
 	// Sanitize the result
 	if (Result != FsOk) {
@@ -93,7 +93,7 @@ FsCreateFile(
 
 	// Create the record
 	Result = MfsCreateRecord(Descriptor, Mfs->MasterRecord.RootIndex,
-		Path, Options, &fInformation);
+		MFS_ROOTFLAGS(Mfs), Path, Options, &fInformation);
 
 	// Sanitize the result
 	if (Result != FsOk) {
@@ -134,6 +134,12 @@ FsCloseFile(
 		return FsOk;
 	}
 
+	// No handles are open, so the data can be moved
+	// into a single run if it's spread out
+	if (MfsDefragmentRecord(Descriptor, fInformation) != OsSuccess) {
+		WARNING("Failed to defragment %s", MStringRaw(fInformation->Name));
+	}
+
 	// Cleanup data
 	MStringDestroy(fInformation->Name);
 	free(fInformation);
@@ -255,6 +261,14 @@ FsReadFile(
 		BytesToRead = (size_t)(Handle->File->Size - Position);
 	}
 
+	// The run might have been grown in place since the handle got there
+	if (fInstance->DataBucketPosition != MFS_ENDOFCHAIN) {
+		MapRecord_t Link;
+		if (MfsGetBucketLink(Descriptor, fInstance->DataBucketPosition, &Link) == OsSuccess) {
+			fInstance->DataBucketLength = Link.Length;
+		}
+	}
+
 	// Read the current sector, update index to where data starts
 	// Keep reading consecutive after that untill all bytes requested have
 	// been read
@@ -268,7 +282,7 @@ FsReadFile(
 			% Descriptor->Disk.Descriptor.SectorSize;
 		size_t SectorIndex = (size_t)((Position - fInstance->BucketByteBoundary)
 			/ Descriptor->Disk.Descriptor.SectorSize);
-		size_t SectorsLeft = fInstance->DataBucketLength - SectorIndex;
+		size_t SectorsLeft = (fInstance->DataBucketLength * Mfs->SectorsPerBucket) - SectorIndex;
 		size_t SectorCount = 0, ByteCount = 0;
 		
 		// Update the data-offset
@@ -342,6 +356,9 @@ FsReadFile(
 				break;
 			}
 
+			// Update bucket boundary, it moves past the current run
+			fInstance->BucketByteBoundary += (fInstance->DataBucketLength * BucketSizeBytes);
+
 			// Store link
 			fInstance->DataBucketPosition = Link.Link;
 
@@ -355,9 +372,6 @@ FsReadFile(
 
 			// Store length
 			fInstance->DataBucketLength = Link.Length;
-
-			// Update bucket boundary
-			fInstance->BucketByteBoundary += (Link.Length * BucketSizeBytes);
 		}
 	}
 
@@ -406,45 +420,20 @@ FsWriteFile(
 		size_t NumSectors = (size_t)(DIVUP(((Position + BytesToWrite) - fInformation->AllocatedSize),
 			Descriptor->Disk.Descriptor.SectorSize));
 		size_t NumBuckets = DIVUP(NumSectors, Mfs->SectorsPerBucket);
-		uint32_t BucketPointer, PreviousBucketPointer;
-		MapRecord_t Iterator, Link;
 
-		// Perform the allocation of buckets
-		if (MfsAllocateBuckets(Descriptor, NumBuckets, &Link) != OsSuccess) {
+		// Perform the allocation of buckets, the last run
+		// of the file is grown if possible
+		if (MfsExpandRecord(Descriptor, fInformation, NumBuckets) != OsSuccess) {
 			ERROR("Failed to allocate %u buckets for file", NumBuckets);
 			return FsDiskError;
 		}
 
-		// Now iterate to end
-		BucketPointer = fInformation->StartBucket;
-		PreviousBucketPointer = MFS_ENDOFCHAIN;
-		while (BucketPointer != MFS_ENDOFCHAIN) {
-			PreviousBucketPointer = BucketPointer;
-			if (MfsGetBucketLink(Descriptor, BucketPointer, &Iterator) != OsSuccess) {
-				ERROR("Failed to get link for bucket %u", BucketPointer);
-				return FsDiskError;
-			}
-			BucketPointer = Iterator.Link;
-		}
-
-		// We have a special case if previous == MFS_ENDOFCHAIN
-		if (PreviousBucketPointer == MFS_ENDOFCHAIN) {
-			// This means file had nothing allocated
-			fInformation->StartBucket = Link.Link;
-			fInformation->StartLength = Link.Length;
-			fInstance->DataBucketPosition = Link.Link;
-			fInstance->DataBucketLength = Link.Length;
+		// This means file had nothing allocated
+		if (fInstance->DataBucketPosition == MFS_ENDOFCHAIN) {
+			fInstance->DataBucketPosition = fInformation->StartBucket;
+			fInstance->DataBucketLength = fInformation->StartLength;
 			fInstance->BucketByteBoundary = 0;
 		}
-		else {
-			if (MfsSetBucketLink(Descriptor, PreviousBucketPointer, &Link, 1) != OsSuccess) {
-				ERROR("Failed to set link for bucket %u", PreviousBucketPointer);
-				return FsDiskError;
-			}
-		}
-
-		// Adjust the allocated-size of record
-		fInformation->AllocatedSize += (NumBuckets * BucketSizeBytes);
 
 		// Now, update entry on disk 
 		// thats important if next steps fail
@@ -457,6 +446,27 @@ FsWriteFile(
 		}
 	}
 	
+	// The run might have been grown in place, and if the position is at 
+	// the end of the run it was the last one when the position got there
+	if (fInstance->DataBucketPosition != MFS_ENDOFCHAIN) {
+		MapRecord_t Link;
+		if (MfsGetBucketLink(Descriptor, fInstance->DataBucketPosition, &Link) != OsSuccess) {
+			ERROR("Failed to get link for bucket %u", fInstance->DataBucketPosition);
+			return FsDiskError;
+		}
+		fInstance->DataBucketLength = Link.Length;
+		if (Link.Link != MFS_ENDOFCHAIN && Position == (fInstance->BucketByteBoundary
+			+ (fInstance->DataBucketLength * BucketSizeBytes))) {
+			fInstance->BucketByteBoundary += (fInstance->DataBucketLength * BucketSizeBytes);
+			fInstance->DataBucketPosition = Link.Link;
+			if (MfsGetBucketLink(Descriptor, Link.Link, &Link) != OsSuccess) {
+				ERROR("Failed to get length for bucket %u", fInstance->DataBucketPosition);
+				return FsDiskError;
+			}
+			fInstance->DataBucketLength = Link.Length;
+		}
+	}
+
 	// Figure out the sector that we need to modify
 	// Then figure out if we need to modify a full sector or a partial
 	// sector.
@@ -474,7 +484,7 @@ FsWriteFile(
 			% Descriptor->Disk.Descriptor.SectorSize;
 		size_t SectorIndex = (size_t)((Position - fInstance->BucketByteBoundary)
 			/ Descriptor->Disk.Descriptor.SectorSize);
-		size_t SectorsLeft = fInstance->DataBucketLength - SectorIndex;
+		size_t SectorsLeft = (fInstance->DataBucketLength * Mfs->SectorsPerBucket) - SectorIndex;
 		size_t SectorCount = 0, ByteCount = 0;
 
 		// Ok - so sectorindex contains the index in the bucket
@@ -555,6 +565,9 @@ FsWriteFile(
 				break;
 			}
 
+			// Update bucket boundary, it moves past the current run
+			fInstance->BucketByteBoundary += (fInstance->DataBucketLength * BucketSizeBytes);
+
 			// Store link
 			fInstance->DataBucketPosition = Link.Link;
 
@@ -568,9 +581,6 @@ FsWriteFile(
 
 			// Store length
 			fInstance->DataBucketLength = Link.Length;
-
-			// Update bucket boundary
-			fInstance->BucketByteBoundary += (Link.Length * BucketSizeBytes);
 		}
 	}
 
@@ -617,6 +627,13 @@ FsDeleteFile(
 	fHandle = (MfsFileInstance_t*)Handle->ExtensionData;
 	fInformation = (MfsFile_t*)Handle->File->ExtensionData;
 
+	// Hashed directories own a chain per used slot
+	if (MfsFreeDirectory(Descriptor, fInformation) != OsSuccess) {
+		ERROR("Failed to free the chains of directory at 0x%x",
+			fInformation->StartBucket);
+		return FsDiskError;
+	}
+
 	// Free all buckets allocated
 	if (MfsFreeBuckets(Descriptor, fInformation->StartBucket, 
 		fInformation->StartLength) != OsSuccess) {
@@ -677,6 +694,14 @@ FsSeekFile(
 		// within the current bucket
 		uint64_t OldBucketLow, OldBucketHigh;
 
+		// The run might have been grown in place
+		if (fInstance->DataBucketPosition != MFS_ENDOFCHAIN) {
+			MapRecord_t Link;
+			if (MfsGetBucketLink(Descriptor, fInstance->DataBucketPosition, &Link) == OsSuccess) {
+				fInstance->DataBucketLength = Link.Length;
+			}
+		}
+
 		// Calculate bucket boundaries
 		OldBucketLow = fInstance->BucketByteBoundary;
 		OldBucketHigh = OldBucketLow + (fInstance->DataBucketLength 
@@ -711,8 +736,13 @@ FsSeekFile(
 					return FsDiskError;
 				}
 
-				// If we do reach end of chain, something went terribly wrong
+				// The end of the last run is a valid position, it's where
+				// the next write grows the file from. Beyond is an error
 				if (Link.Link == MFS_ENDOFCHAIN) {
+					if (AbsolutePosition == (PositionBoundLow + PositionBoundHigh)) {
+						fInstance->BucketByteBoundary = PositionBoundLow;
+						break;
+					}
 					ERROR("Reached end of chain during seek");
 					return FsInvalidParameters;
 				}
@@ -738,6 +768,7 @@ FsSeekFile(
 			// Update bucket pointer
 			if (BucketPtr != MFS_ENDOFCHAIN) {
 				fInstance->DataBucketPosition = BucketPtr;
+				fInstance->DataBucketLength = BucketLength;
 			}
 		}
 	}
@@ -785,9 +816,20 @@ FsChangeFileSize(
 		fInformation->StartBucket = MFS_ENDOFCHAIN;
 		fInformation->StartLength = 0;
 	}
+	else if (Size > fInformation->AllocatedSize) {
+		// Allocate everything at once, this is used by the
+		// filemanager for data it buffered before allocating
+		size_t BucketSizeBytes = Mfs->SectorsPerBucket * Descriptor->Disk.Descriptor.SectorSize;
+		size_t NumBuckets = (size_t)DIVUP((Size - fInformation->AllocatedSize), BucketSizeBytes);
+		if (MfsExpandRecord(Descriptor, fInformation, NumBuckets) != OsSuccess) {
+			ERROR("Failed to allocate %u buckets for file", NumBuckets);
+			return FsDiskError;
+		}
+	}
 
 	// Set new size
 	fInformation->Size = Size;
+	Handle->Size = Size;
 
 	// Update time
 
@@ -857,10 +899,20 @@ FsDestroy(
 		DestroyBuffer(Mfs->TransferBuffer);
 	}
 
-	// Free the bucket-map
+	if (Mfs->MapBuffer != NULL) {
+		DestroyBuffer(Mfs->MapBuffer);
+	}
+
+	// Free the bucket-map and the free-space index
 	if (Mfs->BucketMap != NULL) {
 		free(Mfs->BucketMap);
 	}
+	if (Mfs->Extents != NULL) {
+		free(Mfs->Extents);
+	}
+	if (Mfs->ExtentsBySize != NULL) {
+		free(Mfs->ExtentsBySize);
+	}
 
 	// Free structure and return
 	free(Mfs);
@@ -897,6 +949,7 @@ FsInitialize(
 
 	// Allocate a new instance of mfs
 	Mfs = (MfsInstance_t*)malloc(sizeof(MfsInstance_t));
+	memset(Mfs, 0, sizeof(MfsInstance_t));
 	Descriptor->ExtensionData = (uintptr_t*)Mfs;
 
 	// Instantiate the boot-record pointer
@@ -947,8 +1000,8 @@ FsInitialize(
 	// Copy the master-record data
 	memcpy(&Mfs->MasterRecord, MasterRecord, sizeof(MasterRecord_t));
 
-	// Cleanup the transfer buffer
-	DestroyBuffer(Buffer);
+	// Keep the buffer for map and master-record updates
+	Mfs->MapBuffer = Buffer;
 
 	// Allocate a new in the size of a bucket
 	Buffer = CreateBuffer(Mfs->SectorsPerBucket 
@@ -987,12 +1040,30 @@ FsInitialize(
 		i++;
 	}
 
+	// Index the free space
+	if (MfsBuildExtentIndex(Descriptor) != OsSuccess) {
+		ERROR("Failed to build the free-space index");
+		goto Error;
+	}
+
 	// Update the structure
 	return OsSuccess;
 
 Error:
 	// Cleanup mfs
 	if (Mfs != NULL) {
+		if (Mfs->MapBuffer != NULL && Mfs->MapBuffer != Buffer) {
+			DestroyBuffer(Mfs->MapBuffer);
+		}
+		if (Mfs->BucketMap != NULL) {
+			free(Mfs->BucketMap);
+		}
+		if (Mfs->Extents != NULL) {
+			free(Mfs->Extents);
+		}
+		if (Mfs->ExtentsBySize != NULL) {
+			free(Mfs->ExtentsBySize);
+		}
 		free(Mfs);
 	}
 
@@ -43,6 +43,11 @@
 #define MFS_ENDOFCHAIN							0xFFFFFFFF
 #define MFS_GETSECTOR(mInstance, Bucket)		((Mfs->SectorsPerBucket * Bucket))
 #define MFS_ROOTSIZE							8
+#define MFS_EXTENTS_INITIAL						64
+#define MFS_DEFRAG_MINRUNS						2
+#define MFS_DEFRAG_MAXBUCKETS					2048
+#define MFS_HASHSLOT_EMPTY						0
+#define MFS_ROOTFLAGS(Mfs)						(((Mfs)->MasterRecord.Flags & MFS_MASTERRECORD_HASHEDROOT) ? MFS_FILERECORD_HASHED : 0)
 
 /* MFS Update Entry Action Codes */
 #define MFS_ACTION_UPDATE	0x0
@@ -84,6 +89,12 @@ PACKED_TYPESTRUCT(BootRecord, {
 #define MFS_BOOTRECORD_DIRTY			0x2
 #define MFS_BOOTRECORD_ENCRYPTED		0x4
 
+/* MFS Master-Record flags
+ * The possible values that can be present in MasterRecord::Flags, volumes
+ * without them only contain flat directories */
+#define MFS_MASTERRECORD_HASHEDDIRS		0x1			// New directories are hashed
+#define MFS_MASTERRECORD_HASHEDROOT		0x2			// Root directory is hashed
+
 /* The master-record structure
  * Exists two places on disk to have a backup
  * and it contains extended information related
@@ -181,6 +192,7 @@ PACKED_TYPESTRUCT(FileRecord, {
 #define MFS_FILERECORD_HIDDEN			0x10		// Don't show
 #define MFS_FILERECORD_CHAINED			0x20		// Means all buckets are adjacent
 #define MFS_FILERECORD_LOCKED			0x40		// File is deep-locked
+#define MFS_FILERECORD_HASHED			0x80		// Directory is a table of hashed chains
 
 #define MFS_FILERECORD_VERSIONED		0x10000000	// Record is versioned
 #define MFS_FILERECORD_INLINE			0x20000000	// Inline data is present
@@ -216,6 +228,14 @@ typedef struct _MfsFileInstance {
 	uint64_t BucketByteBoundary;
 } MfsFileInstance_t;
 
+/* Mfs Free Extent
+ * A run of free buckets. The free runs are indexed twice, ordered by
+ * address to coalesce neighbours and ordered by size to do best-fit */
+typedef struct _MfsExtent {
+	uint32_t				 Bucket;
+	uint32_t				 Length;
+} MfsExtent_t;
+
 /* Mfs Instance data
  * Keeps track of the current state of an instance of
  * the mollenos-filesystem and keeps cached data as well */
@@ -224,6 +244,7 @@ typedef struct _MfsInstance {
 	int						 Version;
 	size_t					 SectorsPerBucket;
 	BufferObject_t			*TransferBuffer;
+	BufferObject_t			*MapBuffer;
 	
 	uint64_t				 MasterRecordSector;
 	uint64_t				 MasterRecordMirrorSector;
@@ -234,6 +255,14 @@ typedef struct _MfsInstance {
 	// Cached map
 	uint32_t				*BucketMap;
 
+	// Free-space index, the on-disk free chain
+	// is kept in address order and coalesced
+	MfsExtent_t				*Extents;
+	MfsExtent_t				*ExtentsBySize;
+	size_t					 ExtentCount;
+	size_t					 ExtentCapacity;
+	size_t					 FreeBuckets;
+
 	// Keep a cached copy of master-record
 	MasterRecord_t			 MasterRecord;
 } MfsInstance_t;
@@ -291,8 +320,17 @@ MfsZeroBucket(
 	_In_ uint32_t Bucket,
 	_In_ size_t Count);
 
+/* MfsBuildExtentIndex
+ * Builds the free-space index from the free chain of the bucket-map, the
+ * chain is rewritten in address order if it was not */
+__EXTERN
+OsStatus_t
+MfsBuildExtentIndex(
+	_In_ FileSystemDescriptor_t *Descriptor);
+
 /* MfsAllocateBuckets
- * Allocates the number of requested buckets in the bucket-map
+ * Allocates the number of requested buckets in the bucket-map, the smallest
+ * free run that fits is used. If none fits the largest runs are chained
  * if the allocation could not be done, it'll return OsError */
 __EXTERN
 OsStatus_t
@@ -311,6 +349,26 @@ MfsFreeBuckets(
 	_In_ uint32_t StartBucket,
 	_In_ uint32_t StartLength);
 
+/* MfsExpandRecord
+ * Allocates the given number of buckets at the end of the record, the
+ * last run is grown in place if the buckets after it are free. The
+ * record is not updated on disk */
+__EXTERN
+OsStatus_t
+MfsExpandRecord(
+	_In_ FileSystemDescriptor_t *Descriptor,
+	_In_ MfsFile_t *File,
+	_In_ size_t BucketCount);
+
+/* MfsDefragmentRecord
+ * Moves the data of a fragmented record into a single run if a free
+ * run is large enough, no handles may be open to the record */
+__EXTERN
+OsStatus_t
+MfsDefragmentRecord(
+	_In_ FileSystemDescriptor_t *Descriptor,
+	_In_ MfsFile_t *File);
+
 /* MfsUpdateRecord
  * Conveniance function for updating a given file on
  * the disk, not data related to file, but the metadata */
@@ -321,6 +379,23 @@ MfsUpdateRecord(
 	_In_ MfsFile_t *Handle,
 	_In_ int Action);
 
+/* MfsHashName
+ * Hashes the name case-insensitively up to the first path separator,
+ * the hash selects the chain of a hashed directory the record lives in */
+__EXTERN
+uint32_t
+MfsHashName(
+	_In_ const char *Name);
+
+/* MfsFreeDirectory
+ * Frees the record chains of a hashed directory, the bucket holding
+ * the table of chains is freed with the rest of the record */
+__EXTERN
+OsStatus_t
+MfsFreeDirectory(
+	_In_ FileSystemDescriptor_t *Descriptor,
+	_In_ MfsFile_t *File);
+
 /* MfsLocateRecord
  * Locates a given file-record by the path given, all sub
  * entries must be directories. File is only allocated and set
@@ -330,6 +405,7 @@ FileSystemCode_t
 MfsLocateRecord(
 	_In_ FileSystemDescriptor_t *Descriptor,
 	_In_ uint32_t BucketOfDirectory,
+	_In_ Flags_t DirectoryFlags,
 	_In_ MString_t *Path,
 	_Out_ MfsFile_t **File);
 
@@ -343,6 +419,7 @@ FileSystemCode_t
 MfsLocateFreeRecord(
 	_In_ FileSystemDescriptor_t *Descriptor,
 	_In_ uint32_t BucketOfDirectory,
+	_In_ Flags_t DirectoryFlags,
 	_In_ MString_t *Path,
 	_Out_ MfsFile_t **File);
 
@@ -355,6 +432,7 @@ FileSystemCode_t
 MfsCreateRecord(
 	_In_ FileSystemDescriptor_t *Descriptor,
 	_In_ uint32_t BucketOfDirectory,
+	_In_ Flags_t DirectoryFlags,
 	_In_ MString_t *Path,
 	_In_ Flags_t Flags,
 	_Out_ MfsFile_t **File);
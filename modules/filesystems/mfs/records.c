@@ -69,14 +69,155 @@ MfsExtractToken(
 	return OsSuccess;
 }
 
+/* MfsHashName
+ * Hashes the name case-insensitively up to the first path separator,
+ * the hash selects the chain of a hashed directory the record lives in */
+uint32_t
+MfsHashName(
+	_In_ const char *Name)
+{
+	// Variables
+	const uint8_t *Data = (const uint8_t*)Name;
+	uint32_t Hash = 5381;
+
+	// Only ascii is folded, the hash is stored on disk
+	// implicitly so it must never depend on the locale
+	while (*Data != '\0' && *Data != '/') {
+		uint8_t Character = *Data++;
+		if (Character >= 'A' && Character <= 'Z') {
+			Character += 'a' - 'A';
+		}
+		Hash = (Hash * 33) + Character;
+	}
+	return Hash;
+}
+
+/* MfsGetDirectoryChain (Private)
+ * Flat directories are a single chain of record buckets. The first bucket
+ * of a hashed directory is a table of chain heads instead, and the name hash
+ * selects the chain the record lives in. An empty slot is given a chain if
+ * Create is set, otherwise FsPathNotFound is returned */
+FileSystemCode_t
+MfsGetDirectoryChain(
+	_In_ FileSystemDescriptor_t *Descriptor,
+	_In_ uint32_t BucketOfDirectory,
+	_In_ Flags_t DirectoryFlags,
+	_In_ MString_t *Name,
+	_In_ int Create,
+	_Out_ uint32_t *Chain)
+{
+	// Variables
+	MfsInstance_t *Mfs = NULL;
+	MapRecord_t Expansion;
+	uint32_t *Slots = NULL;
+	size_t SlotsPerSector, Slot;
+	uint64_t Sector;
+
+	// Flat directories are their own chain
+	if (!(DirectoryFlags & MFS_FILERECORD_HASHED)) {
+		*Chain = BucketOfDirectory;
+		return FsOk;
+	}
+
+	// Instantiate the mfs pointer
+	Mfs = (MfsInstance_t*)Descriptor->ExtensionData;
+
+	// Only the sector holding the slot is read
+	SlotsPerSector = Descriptor->Disk.Descriptor.SectorSize / sizeof(uint32_t);
+	Slot = MfsHashName(MStringRaw(Name)) % (Mfs->SectorsPerBucket * SlotsPerSector);
+	Sector = MFS_GETSECTOR(Mfs, BucketOfDirectory) + (Slot / SlotsPerSector);
+	if (MfsReadSectors(Descriptor, Mfs->MapBuffer, Sector, 1) != OsSuccess) {
+		ERROR("Failed to read hash-table of directory-bucket %u", BucketOfDirectory);
+		return FsDiskError;
+	}
+	Slots = (uint32_t*)GetBufferData(Mfs->MapBuffer);
+	*Chain = Slots[Slot % SlotsPerSector];
+	if (*Chain != MFS_HASHSLOT_EMPTY) {
+		return FsOk;
+	}
+	else if (!Create) {
+		return FsPathNotFound;
+	}
+
+	// Allocate the chain, the map buffer is used for
+	// the map updates so the sector is read again after
+	if (MfsAllocateBuckets(Descriptor, 1, &Expansion) != OsSuccess) {
+		ERROR("Failed to allocate bucket for hash-chain");
+		return FsDiskError;
+	}
+	if (MfsZeroBucket(Descriptor, Expansion.Link, Expansion.Length) != OsSuccess) {
+		ERROR("Failed to zero bucket %u", Expansion.Link);
+		return FsDiskError;
+	}
+	if (MfsReadSectors(Descriptor, Mfs->MapBuffer, Sector, 1) != OsSuccess) {
+		ERROR("Failed to read hash-table of directory-bucket %u", BucketOfDirectory);
+		return FsDiskError;
+	}
+	Slots = (uint32_t*)GetBufferData(Mfs->MapBuffer);
+	Slots[Slot % SlotsPerSector] = Expansion.Link;
+	if (MfsWriteSectors(Descriptor, Mfs->MapBuffer, Sector, 1) != OsSuccess) {
+		ERROR("Failed to update hash-table of directory-bucket %u", BucketOfDirectory);
+		return FsDiskError;
+	}
+	*Chain = Expansion.Link;
+	return FsOk;
+}
+
+/* MfsFreeDirectory
+ * Frees the record chains of a hashed directory, the bucket holding
+ * the table of chains is freed with the rest of the record */
+OsStatus_t
+MfsFreeDirectory(
+	_In_ FileSystemDescriptor_t *Descriptor,
+	_In_ MfsFile_t *File)
+{
+	// Variables
+	MfsInstance_t *Mfs = NULL;
+	uint32_t *Slots = NULL;
+	MapRecord_t Link;
+	size_t i;
+
+	// Nothing but hashed directories own more than one chain
+	if (!(File->Flags & MFS_FILERECORD_HASHED)
+		|| File->StartBucket == MFS_ENDOFCHAIN) {
+		return OsSuccess;
+	}
+
+	// Instantiate the mfs pointer
+	Mfs = (MfsInstance_t*)Descriptor->ExtensionData;
+
+	// Freeing only touches the map buffer, so the table
+	// stays intact in the transfer buffer
+	if (MfsReadSectors(Descriptor, Mfs->TransferBuffer,
+		MFS_GETSECTOR(Mfs, File->StartBucket), Mfs->SectorsPerBucket) != OsSuccess) {
+		ERROR("Failed to read hash-table of directory-bucket %u", File->StartBucket);
+		return OsError;
+	}
+
+	Slots = (uint32_t*)GetBufferData(Mfs->TransferBuffer);
+	for (i = 0; i < (Mfs->SectorsPerBucket * Descriptor->Disk.Descriptor.SectorSize)
+		/ sizeof(uint32_t); i++) {
+		if (Slots[i] == MFS_HASHSLOT_EMPTY) {
+			continue;
+		}
+		if (MfsGetBucketLink(Descriptor, Slots[i], &Link) != OsSuccess
+			|| MfsFreeBuckets(Descriptor, Slots[i], Link.Length) != OsSuccess) {
+			ERROR("Failed to free hash-chain at bucket %u", Slots[i]);
+			return OsError;
+		}
+	}
+	return OsSuccess;
+}
+
 /* MfsLocateRecord
  * Locates a given file-record by the path given, all sub
  * entries must be directories. File is only allocated and set
  * if the function returns FsOk */
 FileSystemCode_t
 MfsLocateRecord(
-	_In_ FileSystemDescriptor_t *Descriptor, 
-	_In_ uint32_t BucketOfDirectory, 
+	_In_ FileSystemDescriptor_t *Descriptor,
+	_In_ uint32_t BucketOfDirectory,
+	_In_ Flags_t DirectoryFlags,
 	_In_ MString_t *Path,
 	_Out_ MfsFile_t **File)
 {
@@ -87,7 +228,7 @@ MfsLocateRecord(
 
 	int IsEndOfFolder = 0, IsEndOfPath = 0;
 	uint32_t CurrentBucket = BucketOfDirectory;
-	size_t i;
+	size_t i, RecordCount;
 
 	// Trace
 	TRACE("MfsLocateRecord(Directory-Bucket %u, Path %s)",
@@ -104,6 +245,13 @@ MfsLocateRecord(
 		IsEndOfPath = 1;
 	}
 
+	// Hashed directories keep the token in one of their chains
+	Result = MfsGetDirectoryChain(Descriptor, BucketOfDirectory,
+		DirectoryFlags, Token, 0, &CurrentBucket);
+	if (Result != FsOk) {
+		goto Cleanup;
+	}
+
 	// Iterate untill we reach end of folder
 	while (!IsEndOfFolder) {
 		FileRecord_t *Record = NULL;
@@ -128,10 +276,11 @@ MfsLocateRecord(
 			goto Cleanup;
 		}
 
-		// Iterate the number of records in a bucket
+		// Iterate the number of records in the run of buckets
 		// A record spans two sectors
 		Record = (FileRecord_t*)GetBufferData(Mfs->TransferBuffer);
-		for (i = 0; i < (Mfs->SectorsPerBucket / 2); i++) {
+		RecordCount = (Mfs->SectorsPerBucket * Link.Length) / 2;
+		for (i = 0; i < RecordCount; i++) {
 			// Variables
 			MString_t *Filename = NULL;
 
@@ -163,7 +312,6 @@ MfsLocateRecord(
 						goto Cleanup;
 					}
 					if (Record->StartBucket == MFS_ENDOFCHAIN) {
-						MStringDestroy(Filename);
 						Result = FsPathNotFound;
 						goto Cleanup;
 					}
@@ -174,7 +322,7 @@ MfsLocateRecord(
 
 					// Now search for the next token inside this directory
 					Result = MfsLocateRecord(Descriptor, Record->StartBucket,
-						Remaining, File);
+						Record->Flags, Remaining, File);
 					goto Cleanup;
 				}
 				else {
@@ -232,8 +380,9 @@ Cleanup:
  * the path, and validates the path as it goes */
 FileSystemCode_t
 MfsLocateFreeRecord(
-	_In_ FileSystemDescriptor_t *Descriptor, 
-	_In_ uint32_t BucketOfDirectory, 
+	_In_ FileSystemDescriptor_t *Descriptor,
+	_In_ uint32_t BucketOfDirectory,
+	_In_ Flags_t DirectoryFlags,
 	_In_ MString_t *Path,
 	_Out_ MfsFile_t **File)
 {
@@ -244,7 +393,7 @@ MfsLocateFreeRecord(
 
 	int IsEndOfFolder = 0, IsEndOfPath = 0;
 	uint32_t CurrentBucket = BucketOfDirectory;
-	size_t i;
+	size_t i, RecordCount;
 
 	// Trace
 	TRACE("MfsLocateFreeRecord(Directory-Bucket %u, Path %s)",
@@ -261,6 +410,13 @@ MfsLocateFreeRecord(
 		IsEndOfPath = 1;
 	}
 
+	// Hashed directories keep the token in one of their chains
+	Result = MfsGetDirectoryChain(Descriptor, BucketOfDirectory,
+		DirectoryFlags, Token, IsEndOfPath, &CurrentBucket);
+	if (Result != FsOk) {
+		goto Cleanup;
+	}
+
 	// Iterate untill we reach end of folder
 	while (!IsEndOfFolder) {
 		FileRecord_t *Record = NULL;
@@ -282,10 +438,11 @@ MfsLocateFreeRecord(
 			goto Cleanup;
 		}
 
-		// Iterate the number of records in a bucket
+		// Iterate the number of records in the run of buckets
 		// A record spans two sectors
 		Record = (FileRecord_t*)GetBufferData(Mfs->TransferBuffer);
-		for (i = 0; i < (Mfs->SectorsPerBucket / 2); i++) {
+		RecordCount = (Mfs->SectorsPerBucket * Link.Length) / 2;
+		for (i = 0; i < RecordCount; i++) {
 			// Variables
 			MString_t *Filename = NULL;
 
@@ -343,31 +500,43 @@ MfsLocateFreeRecord(
 							goto Cleanup;
 						}
 
-						// Update record information
+						// Update record information, empty directories take
+						// the format new directories have on this volume
 						Record->StartBucket = Expansion.Link;
 						Record->StartLength = Expansion.Length;
 						Record->AllocatedSize = Mfs->SectorsPerBucket 
 							* Descriptor->Disk.Descriptor.SectorSize;
+						if (Mfs->MasterRecord.Flags & MFS_MASTERRECORD_HASHEDDIRS) {
+							Record->Flags |= MFS_FILERECORD_HASHED;
+						}
 
-						// Write back record bucket
+						// Write back record run
 						if (MfsWriteSectors(Descriptor, Mfs->TransferBuffer,
-							MFS_GETSECTOR(Mfs, CurrentBucket), Mfs->SectorsPerBucket) != OsSuccess) {
+							MFS_GETSECTOR(Mfs, CurrentBucket), 
+							Mfs->SectorsPerBucket * Link.Length) != OsSuccess) {
 							ERROR("Failed to update bucket %u", CurrentBucket);
 							Result = FsDiskError;
 							goto Cleanup;
 						}
 
-						// Zero the bucket
-						if (MfsZeroBucket(Descriptor, Record->StartBucket, Record->StartLength) != OsSuccess) {
-							ERROR("Failed to zero bucket %u", Record->StartBucket);
+						// Zero the bucket, this also clears the table
+						// of chains of a hashed directory
+						if (MfsZeroBucket(Descriptor, Expansion.Link, Expansion.Length) != OsSuccess) {
+							ERROR("Failed to zero bucket %u", Expansion.Link);
 							Result = FsDiskError;
 							goto Cleanup;
 						}
+
+						// The record was in the transfer buffer
+						Result = MfsLocateFreeRecord(Descriptor, Expansion.Link,
+							(Mfs->MasterRecord.Flags & MFS_MASTERRECORD_HASHEDDIRS) 
+								? MFS_FILERECORD_HASHED : 0, Remaining, File);
+						goto Cleanup;
 					}
 					
 					// Go recursive with the remaining path
 					Result = MfsLocateFreeRecord(Descriptor, Record->StartBucket, 
-						Remaining, File);
+						Record->Flags, Remaining, File);
 					goto Cleanup;
 				}
 				else {
@@ -408,8 +577,8 @@ MfsLocateFreeRecord(
 					goto Cleanup;
 				}
 
-				// Update link
-				if (MfsSetBucketLink(Descriptor, CurrentBucket, &Link, 1) != OsSuccess) {
+				// Update link, the length of the current run stays
+				if (MfsSetBucketLink(Descriptor, CurrentBucket, &Link, 0) != OsSuccess) {
 					ERROR("Failed to update bucket-link for expansion");
 					Result = FsDiskError;
 					goto Cleanup;
@@ -445,13 +614,14 @@ FileSystemCode_t
 MfsCreateRecord(
 	_In_ FileSystemDescriptor_t *Descriptor,
 	_In_ uint32_t BucketOfDirectory,
+	_In_ Flags_t DirectoryFlags,
 	_In_ MString_t *Path,
 	_In_ Flags_t Flags, 
 	_Out_ MfsFile_t **File)
 {
 	// Locate a free entry, and make sure file does not exist 
 	FileSystemCode_t Result = MfsLocateFreeRecord(Descriptor, 
-		BucketOfDirectory, Path, File);
+		BucketOfDirectory, DirectoryFlags, Path, File);
 
 	// If it failed either of two things happened 
 	// 1) Path was invalid 
@@ -465,7 +635,7 @@ MfsCreateRecord(
 	(*File)->StartLength = 0;
 	(*File)->Size = 0;
 	(*File)->AllocatedSize = 0;
-	(*File)->Flags = Flags | MFS_FILERECORD_INUSE;
+	(*File)->Flags = (Flags & ~MFS_FILERECORD_HASHED) | MFS_FILERECORD_INUSE;
 
 	// Update the on-disk record with the new data
 	return MfsUpdateRecord(Descriptor, *File, MFS_ACTION_CREATE);
@@ -90,16 +90,17 @@ MfsUpdateMasterRecord(
 	// Instantiate the pointers
 	Mfs = (MfsInstance_t*)Descriptor->ExtensionData;
 
-	// Clear buffer
-	ZeroBuffer(Mfs->TransferBuffer);
+	// Clear buffer, the map buffer is used so the transfer
+	// buffer can hold a directory while buckets are allocated
+	ZeroBuffer(Mfs->MapBuffer);
 
 	// Copy data
-	WriteBuffer(Mfs->TransferBuffer, &Mfs->MasterRecord, 
+	WriteBuffer(Mfs->MapBuffer, &Mfs->MasterRecord, 
 		sizeof(MasterRecord_t), NULL);
 
 	// Write the master-record to harddisk
-	if (MfsWriteSectors(Descriptor, Mfs->TransferBuffer, Mfs->MasterRecordSector, 1) != OsSuccess
-		|| MfsWriteSectors(Descriptor, Mfs->TransferBuffer, Mfs->MasterRecordMirrorSector, 1) != OsSuccess) {
+	if (MfsWriteSectors(Descriptor, Mfs->MapBuffer, Mfs->MasterRecordSector, 1) != OsSuccess
+		|| MfsWriteSectors(Descriptor, Mfs->MapBuffer, Mfs->MasterRecordMirrorSector, 1) != OsSuccess) {
 		ERROR("Failed to write master-record to disk");
 		return OsError;
 	}
@@ -170,12 +171,12 @@ MfsSetBucketLink(
 	BufferOffset += (SectorOffset * Descriptor->Disk.Descriptor.SectorSize);
 
 	// Copy a sector's worth of data into the buffer
-	ZeroBuffer(Mfs->TransferBuffer);
-	WriteBuffer(Mfs->TransferBuffer, BufferOffset, 
+	ZeroBuffer(Mfs->MapBuffer);
+	WriteBuffer(Mfs->MapBuffer, BufferOffset, 
 		Descriptor->Disk.Descriptor.SectorSize, NULL);
 
 	// Flush buffer to disk
-	if (MfsWriteSectors(Descriptor, Mfs->TransferBuffer, 
+	if (MfsWriteSectors(Descriptor, Mfs->MapBuffer, 
 		Mfs->MasterRecord.MapSector + SectorOffset, 1) != OsSuccess) {
 		ERROR("Failed to update the given map-sector %u on disk",
 			LODWORD(Mfs->MasterRecord.MapSector + SectorOffset));
@@ -186,8 +187,321 @@ MfsSetBucketLink(
 	return OsSuccess;
 }
 
+/* MfsExtentLocate (Private)
+ * Returns the index of the first free run at or after the given
+ * bucket in the address ordered index */
+size_t
+MfsExtentLocate(
+	_In_ MfsInstance_t *Mfs,
+	_In_ uint32_t Bucket)
+{
+	// Variables
+	size_t Low = 0, High = Mfs->ExtentCount;
+
+	while (Low < High) {
+		size_t Middle = Low + ((High - Low) / 2);
+		if (Mfs->Extents[Middle].Bucket < Bucket) {
+			Low = Middle + 1;
+		}
+		else {
+			High = Middle;
+		}
+	}
+	return Low;
+}
+
+/* MfsExtentLocateSize (Private)
+ * Returns the index of the first free run that is at least the given
+ * length in the size ordered index, equal sizes are ordered by address */
+size_t
+MfsExtentLocateSize(
+	_In_ MfsInstance_t *Mfs,
+	_In_ uint32_t Length,
+	_In_ uint32_t Bucket)
+{
+	// Variables
+	size_t Low = 0, High = Mfs->ExtentCount;
+
+	while (Low < High) {
+		size_t Middle = Low + ((High - Low) / 2);
+		MfsExtent_t *Extent = &Mfs->ExtentsBySize[Middle];
+		if (Extent->Length < Length
+			|| (Extent->Length == Length && Extent->Bucket < Bucket)) {
+			Low = Middle + 1;
+		}
+		else {
+			High = Middle;
+		}
+	}
+	return Low;
+}
+
+/* MfsExtentSizeInsert (Private)
+ * Inserts the run into the size ordered index, the index must
+ * have room for it */
+void
+MfsExtentSizeInsert(
+	_In_ MfsInstance_t *Mfs,
+	_In_ MfsExtent_t *Extent,
+	_In_ size_t Count)
+{
+	// Variables
+	size_t Index = 0, High = Count;
+
+	while (Index < High) {
+		size_t Middle = Index + ((High - Index) / 2);
+		MfsExtent_t *Entry = &Mfs->ExtentsBySize[Middle];
+		if (Entry->Length < Extent->Length
+			|| (Entry->Length == Extent->Length && Entry->Bucket < Extent->Bucket)) {
+			Index = Middle + 1;
+		}
+		else {
+			High = Middle;
+		}
+	}
+	memmove(&Mfs->ExtentsBySize[Index + 1], &Mfs->ExtentsBySize[Index],
+		(Count - Index) * sizeof(MfsExtent_t));
+	Mfs->ExtentsBySize[Index] = *Extent;
+}
+
+/* MfsExtentSizeRemove (Private)
+ * Removes the run from the size ordered index */
+void
+MfsExtentSizeRemove(
+	_In_ MfsInstance_t *Mfs,
+	_In_ MfsExtent_t *Extent)
+{
+	// Variables
+	size_t Index = MfsExtentLocateSize(Mfs, Extent->Length, Extent->Bucket);
+
+	memmove(&Mfs->ExtentsBySize[Index], &Mfs->ExtentsBySize[Index + 1],
+		(Mfs->ExtentCount - Index - 1) * sizeof(MfsExtent_t));
+}
+
+/* MfsExtentInsert (Private)
+ * Adds a free run to the index and merges it with the runs next to it,
+ * only the in-memory index is changed. Returns the address index of the
+ * run the buckets ended up in */
+OsStatus_t
+MfsExtentInsert(
+	_In_ MfsInstance_t *Mfs,
+	_In_ uint32_t Bucket,
+	_In_ uint32_t Length,
+	_Out_ size_t *Position)
+{
+	// Variables
+	size_t Index = MfsExtentLocate(Mfs, Bucket);
+	int MergePrevious = 0, MergeNext = 0;
+
+	// Make sure there is room for another run
+	if (Mfs->ExtentCount == Mfs->ExtentCapacity) {
+		size_t Capacity = (Mfs->ExtentCapacity == 0) ? 
+			MFS_EXTENTS_INITIAL : (Mfs->ExtentCapacity * 2);
+		MfsExtent_t *Extents = (MfsExtent_t*)realloc(Mfs->Extents, 
+			Capacity * sizeof(MfsExtent_t));
+		MfsExtent_t *BySize = NULL;
+		if (Extents == NULL) {
+			return OsError;
+		}
+		Mfs->Extents = Extents;
+		BySize = (MfsExtent_t*)realloc(Mfs->ExtentsBySize,
+			Capacity * sizeof(MfsExtent_t));
+		if (BySize == NULL) {
+			return OsError;
+		}
+		Mfs->ExtentsBySize = BySize;
+		Mfs->ExtentCapacity = Capacity;
+	}
+
+	// Figure out which neighbours the run touches
+	if (Index > 0 && (Mfs->Extents[Index - 1].Bucket 
+		+ Mfs->Extents[Index - 1].Length) == Bucket) {
+		MergePrevious = 1;
+	}
+	if (Index < Mfs->ExtentCount && (Bucket + Length) == Mfs->Extents[Index].Bucket) {
+		MergeNext = 1;
+	}
+
+	// Update the indices, the size index is updated by
+	// removing and reinserting the runs that change
+	if (MergePrevious && MergeNext) {
+		MfsExtentSizeRemove(Mfs, &Mfs->Extents[Index - 1]);
+		Mfs->ExtentCount--;
+		MfsExtentSizeRemove(Mfs, &Mfs->Extents[Index]);
+		Mfs->Extents[Index - 1].Length += Length + Mfs->Extents[Index].Length;
+		memmove(&Mfs->Extents[Index], &Mfs->Extents[Index + 1],
+			(Mfs->ExtentCount - Index) * sizeof(MfsExtent_t));
+		MfsExtentSizeInsert(Mfs, &Mfs->Extents[Index - 1], Mfs->ExtentCount - 1);
+		Index--;
+	}
+	else if (MergePrevious) {
+		MfsExtentSizeRemove(Mfs, &Mfs->Extents[Index - 1]);
+		Mfs->Extents[Index - 1].Length += Length;
+		MfsExtentSizeInsert(Mfs, &Mfs->Extents[Index - 1], Mfs->ExtentCount - 1);
+		Index--;
+	}
+	else if (MergeNext) {
+		MfsExtentSizeRemove(Mfs, &Mfs->Extents[Index]);
+		Mfs->Extents[Index].Bucket = Bucket;
+		Mfs->Extents[Index].Length += Length;
+		MfsExtentSizeInsert(Mfs, &Mfs->Extents[Index], Mfs->ExtentCount - 1);
+	}
+	else {
+		memmove(&Mfs->Extents[Index + 1], &Mfs->Extents[Index],
+			(Mfs->ExtentCount - Index) * sizeof(MfsExtent_t));
+		Mfs->Extents[Index].Bucket = Bucket;
+		Mfs->Extents[Index].Length = Length;
+		MfsExtentSizeInsert(Mfs, &Mfs->Extents[Index], Mfs->ExtentCount);
+		Mfs->ExtentCount++;
+	}
+
+	Mfs->FreeBuckets += Length;
+	*Position = Index;
+	return OsSuccess;
+}
+
+/* MfsExtentSync (Private)
+ * Writes the free chain around the run at the given address index to
+ * disk, the link to the run and the run itself are updated. The run may
+ * have been removed, then the link skips to the next run */
+OsStatus_t
+MfsExtentSync(
+	_In_ FileSystemDescriptor_t *Descriptor,
+	_In_ size_t Index)
+{
+	// Variables
+	MfsInstance_t *Mfs = (MfsInstance_t*)Descriptor->ExtensionData;
+	MapRecord_t Record;
+
+	// The link to the run is either in the master-record
+	// or in the previous free run
+	if (Index == 0) {
+		uint32_t FreeBucket = (Mfs->ExtentCount != 0) ? 
+			Mfs->Extents[0].Bucket : MFS_ENDOFCHAIN;
+		if (Mfs->MasterRecord.FreeBucket != FreeBucket) {
+			Mfs->MasterRecord.FreeBucket = FreeBucket;
+			if (MfsUpdateMasterRecord(Descriptor) != OsSuccess) {
+				return OsError;
+			}
+		}
+	}
+	else {
+		Record.Link = (Index < Mfs->ExtentCount) ? 
+			Mfs->Extents[Index].Bucket : MFS_ENDOFCHAIN;
+		Record.Length = Mfs->Extents[Index - 1].Length;
+		if (MfsSetBucketLink(Descriptor, Mfs->Extents[Index - 1].Bucket, &Record, 1) != OsSuccess) {
+			return OsError;
+		}
+	}
+
+	// Update the run itself
+	if (Index < Mfs->ExtentCount) {
+		Record.Link = ((Index + 1) < Mfs->ExtentCount) ?
+			Mfs->Extents[Index + 1].Bucket : MFS_ENDOFCHAIN;
+		Record.Length = Mfs->Extents[Index].Length;
+		if (MfsSetBucketLink(Descriptor, Mfs->Extents[Index].Bucket, &Record, 1) != OsSuccess) {
+			return OsError;
+		}
+	}
+	return OsSuccess;
+}
+
+/* MfsExtentTake (Private)
+ * Takes the given number of buckets from the start of the free run
+ * at the given address index and updates the free chain */
+OsStatus_t
+MfsExtentTake(
+	_In_ FileSystemDescriptor_t *Descriptor,
+	_In_ size_t Index,
+	_In_ uint32_t Count)
+{
+	// Variables
+	MfsInstance_t *Mfs = (MfsInstance_t*)Descriptor->ExtensionData;
+	MfsExtent_t *Extent = &Mfs->Extents[Index];
+
+	MfsExtentSizeRemove(Mfs, Extent);
+	if (Extent->Length == Count) {
+		Mfs->ExtentCount--;
+		memmove(&Mfs->Extents[Index], &Mfs->Extents[Index + 1],
+			(Mfs->ExtentCount - Index) * sizeof(MfsExtent_t));
+	}
+	else {
+		Extent->Bucket += Count;
+		Extent->Length -= Count;
+		MfsExtentSizeInsert(Mfs, Extent, Mfs->ExtentCount - 1);
+	}
+	Mfs->FreeBuckets -= Count;
+	return MfsExtentSync(Descriptor, Index);
+}
+
+/* MfsBuildExtentIndex
+ * Builds the free-space index from the free chain of the bucket-map, the
+ * chain is rewritten in address order if it was not */
+OsStatus_t
+MfsBuildExtentIndex(
+	_In_ FileSystemDescriptor_t *Descriptor)
+{
+	// Variables
+	MfsInstance_t *Mfs = NULL;
+	uint32_t Bucket, Previous = 0;
+	uint64_t Steps = 0;
+	int Ordered = 1;
+	MapRecord_t Record;
+	size_t Index;
+
+	// Trace
+	TRACE("MfsBuildExtentIndex()");
+
+	// Instantiate the pointers
+	Mfs = (MfsInstance_t*)Descriptor->ExtensionData;
+	Mfs->Extents = NULL;
+	Mfs->ExtentsBySize = NULL;
+	Mfs->ExtentCount = 0;
+	Mfs->ExtentCapacity = 0;
+	Mfs->FreeBuckets = 0;
+
+	// Walk the free chain, a chain that is not in address order or
+	// has runs next to each other was written by the old allocator
+	Bucket = Mfs->MasterRecord.FreeBucket;
+	while (Bucket != MFS_ENDOFCHAIN) {
+		if (Bucket >= Mfs->BucketCount || Steps++ > Mfs->BucketCount) {
+			ERROR("The free chain of the bucket-map is broken at %u", Bucket);
+			return OsError;
+		}
+		if (MfsGetBucketLink(Descriptor, Bucket, &Record) != OsSuccess) {
+			return OsError;
+		}
+		if (Bucket <= Previous && Steps > 1) {
+			Ordered = 0;
+		}
+		if (MfsExtentInsert(Mfs, Bucket, Record.Length, &Index) != OsSuccess) {
+			ERROR("Failed to allocate the free-space index");
+			return OsError;
+		}
+		if (Mfs->Extents[Index].Bucket != Bucket || Mfs->Extents[Index].Length != Record.Length) {
+			Ordered = 0;
+		}
+		Previous = Bucket;
+		Bucket = Record.Link;
+	}
+
+	// Trace
+	TRACE("Free-space: %u buckets in %u runs", Mfs->FreeBuckets, Mfs->ExtentCount);
+
+	// Rewrite the chain once so it matches the index
+	if (!Ordered) {
+		for (Index = 0; Index < Mfs->ExtentCount; Index++) {
+			if (MfsExtentSync(Descriptor, Index) != OsSuccess) {
+				return OsError;
+			}
+		}
+	}
+	return OsSuccess;
+}
+
 /* MfsAllocateBuckets
- * Allocates the number of requested buckets in the bucket-map
+ * Allocates the number of requested buckets in the bucket-map, the smallest
+ * free run that fits is used. If none fits the largest runs are chained
  * if the allocation could not be done, it'll return OsError */
 OsStatus_t
 MfsAllocateBuckets(
@@ -198,116 +512,85 @@ MfsAllocateBuckets(
 	// Variables
 	MfsInstance_t *Mfs = NULL;
 	MapRecord_t Record;
-	uint32_t Bucket, PreviousBucket;
-	size_t Counter;
+	uint32_t Previous = MFS_ENDOFCHAIN;
+	uint32_t PreviousLength = 0;
+	size_t Index;
 
 	// Trace
-	TRACE("MfsAllocateBuckets(Bucket %u, Link %u)",
-		Bucket, Link->Link);
+	TRACE("MfsAllocateBuckets(Count %u)", BucketCount);
 
 	// Instantiate the pointers
 	Mfs = (MfsInstance_t*)Descriptor->ExtensionData;
 
 	// Instantiate out
-	RecordResult->Link = Mfs->MasterRecord.FreeBucket;
+	RecordResult->Link = MFS_ENDOFCHAIN;
 	RecordResult->Length = 0;
-	PreviousBucket = 0;
 
-	// Instantiate our varibles
-	Bucket = Mfs->MasterRecord.FreeBucket;
-	Counter = BucketCount;
+	// Sanitize the free space
+	if (BucketCount == 0 || BucketCount > Mfs->FreeBuckets) {
+		ERROR("Failed to allocate %u buckets, %u are free", 
+			BucketCount, Mfs->FreeBuckets);
+		return OsError;
+	}
 
-	// Do allocation in a for-loop as bucket-sizes
-	// are variable and thus we might need multiple
-	// allocations to satisfy the demand
-	while (Counter > 0) {
-		// Get next free bucket
-		if (MfsGetBucketLink(Descriptor, Bucket, &Record) != OsSuccess) {
-			ERROR("Failed to retrieve link for bucket %u", Bucket);
-			return OsError;
-		}
+	// Take the best fit for what is left, the largest 
+	// run is used when nothing fits so the chain is kept short
+	while (BucketCount != 0) {
+		MfsExtent_t Extent;
 
-		// Bucket points to the free bucket index
-		// Record.Link holds the link of <Bucket>
-		// Record.Length holds the length of <Bucket>
-
-		// We now have two cases, either the next block is
-		// larger than the number of buckets we are asking for
-		// or it's smaller
-		if (Record.Length > Counter) {
-			// Ok, this block is larger than what we need
-			// We now need to first, update the free index to these values
-			// Map[Bucket] = (Counter) | (MFS_ENDOFCHAIN)
-			// Map[Bucket + Counter] = (Length - Counter) | Link
-			MapRecord_t Update, Next;
-
-			// Set update
-			Update.Link = MFS_ENDOFCHAIN;
-			Update.Length = Counter;
-
-			// Set next
-			Next.Link = Record.Link;
-			Next.Length = Record.Length - Counter;
-
-			// Make sure only to update out once, we just need
-			// the initial size, not for each new allocation
-			if (RecordResult->Length == 0) {
-				RecordResult->Length = Update.Length;
-			}
+		Index = MfsExtentLocateSize(Mfs, (uint32_t)BucketCount, 0);
+		if (Index == Mfs->ExtentCount) {
+			Index = Mfs->ExtentCount - 1;
+		}
+		Extent = Mfs->ExtentsBySize[Index];
+		Extent.Length = MIN(Extent.Length, (uint32_t)BucketCount);
+
+		// Remove the buckets from the free chain
+		if (MfsExtentTake(Descriptor, MfsExtentLocate(Mfs, Extent.Bucket), 
+				Extent.Length) != OsSuccess) {
+			ERROR("Failed to update the free chain");
+			goto Error;
+		}
 
-			// We have to adjust now, since we are taking 
-			// only a chunk of the available length
-			// Map[Bucket] = (Counter) | (MFS_ENDOFCHAIN)
-			// Map[Bucket + Counter] = (Length - Counter) | PreviousLink
-			if (MfsSetBucketLink(Descriptor, Bucket, &Update, 1) != OsSuccess
-				&& MfsSetBucketLink(Descriptor, Bucket + Counter, &Next, 1) != OsSuccess) {
-				ERROR("Failed to update link for bucket %u and %u", 
-					Bucket, Bucket + Counter);
-				return OsError;
+		// Terminate the new run and link it, the run is not part of the 
+		// chain yet so it's given back directly if that fails
+		Record.Link = MFS_ENDOFCHAIN;
+		Record.Length = Extent.Length;
+		if (MfsSetBucketLink(Descriptor, Extent.Bucket, &Record, 1) != OsSuccess) {
+			ERROR("Failed to update link for bucket %u", Extent.Bucket);
+			if (MfsExtentInsert(Mfs, Extent.Bucket, Extent.Length, &Index) == OsSuccess) {
+				MfsExtentSync(Descriptor, Index);
 			}
-
-			// Update the master-record and we are done
-			Mfs->MasterRecord.FreeBucket = Bucket + Counter;
-			return MfsUpdateMasterRecord(Descriptor);
+			goto Error;
+		}
+		if (Previous == MFS_ENDOFCHAIN) {
+			RecordResult->Link = Extent.Bucket;
+			RecordResult->Length = Extent.Length;
 		}
 		else {
-			// Ok, block is either exactly the size we need or less
-			// than what we need
-
-			// Make sure only to update out once, we just need
-			// the initial size, not for each new allocation
-			if (RecordResult->Length == 0) {
-				RecordResult->Length = Record.Length;
+			Record.Link = Extent.Bucket;
+			Record.Length = PreviousLength;
+			if (MfsSetBucketLink(Descriptor, Previous, &Record, 0) != OsSuccess) {
+				ERROR("Failed to update link for bucket %u", Previous);
+				MfsFreeBuckets(Descriptor, Extent.Bucket, Extent.Length);
+				goto Error;
 			}
-
-			// Decrease allocation amount
-			Counter -= Record.Length;
-
-			// Set bucket to next
-			PreviousBucket = Bucket;
-			Bucket = Record.Link;
 		}
-	}
-
-	// If we reach here it was because we encountered a block
-	// that was exactly the fit we needed
-	// So we set FreeIndex to Bucket
-	// We set Record.Link to ENDOFCHAIN
-	// We leave size unchanged
 
-	// We want to update the last bucket of the chain
-	// but not update the length
-	Record.Link = MFS_ENDOFCHAIN;
+		Previous = Extent.Bucket;
+		PreviousLength = Extent.Length;
+		BucketCount -= Extent.Length;
+	}
+	return OsSuccess;
 
-	// Update the previous bucket to MFS_ENDOFCHAIN
-	if (MfsSetBucketLink(Descriptor, PreviousBucket, &Record, 0) != OsSuccess) {
-		ERROR("Failed to update link for bucket %u", PreviousBucket);
-		return OsError;
+Error:
+	// Give back the runs that were chained so far
+	if (RecordResult->Link != MFS_ENDOFCHAIN) {
+		MfsFreeBuckets(Descriptor, RecordResult->Link, RecordResult->Length);
+		RecordResult->Link = MFS_ENDOFCHAIN;
+		RecordResult->Length = 0;
 	}
-	
-	// Update the master-record and we are done
-	Mfs->MasterRecord.FreeBucket = Bucket;
-	return MfsUpdateMasterRecord(Descriptor);
+	return OsError;
 }
 
 /* MfsFreeBuckets
@@ -321,8 +604,9 @@ MfsFreeBuckets(
 {
 	// Variables
 	MfsInstance_t *Mfs = NULL;
-	uint32_t PreviousBucket;
+	uint32_t Bucket;
 	MapRecord_t Record;
+	size_t Index;
 
 	// Trace
 	TRACE("MfsFreeBuckets(Bucket %u, Length %u)",
@@ -330,53 +614,210 @@ MfsFreeBuckets(
 
 	// Instantiate the variables
 	Mfs = (MfsInstance_t*)Descriptor->ExtensionData;
-	Record.Link = StartBucket;
 
 	// Sanitize params
 	if (StartBucket == MFS_ENDOFCHAIN || StartLength == 0) {
 		return OsError;
 	}
 
-	// Essentially there is two algorithms we can deploy here
-	// The quick one - Which is just to add the allocated bucket list
-	// to the free and set the last allocated to point to the first free
-	// OR there is the slow one that makes sure that buckets are <in order> as
-	// they get freed, and gets inserted or extended correctly. This will reduce
-	// fragmentation by A LOT
+	// Each run of the chain is merged into the free runs
+	// around it, so the free chain stays ordered and freeing
+	// undoes fragmentation instead of adding to it
+	Bucket = StartBucket;
+	while (Bucket != MFS_ENDOFCHAIN) {
+		if (MfsGetBucketLink(Descriptor, Bucket, &Record) != OsSuccess) {
+			ERROR("Failed to retrieve the next bucket-link");
+			return OsError;
+		}
+		if (MfsExtentInsert(Mfs, Bucket, Record.Length, &Index) != OsSuccess
+			|| MfsExtentSync(Descriptor, Index) != OsSuccess) {
+			ERROR("Failed to free the run at bucket %u", Bucket);
+			return OsError;
+		}
+		Bucket = Record.Link;
+	}
+	return OsSuccess;
+}
 
-	// So I'm already limited by time due to life, so i'll with the quick
+/* MfsExpandRecord
+ * Allocates the given number of buckets at the end of the record, the
+ * last run is grown in place if the buckets after it are free. The
+ * record is not updated on disk */
+OsStatus_t
+MfsExpandRecord(
+	_In_ FileSystemDescriptor_t *Descriptor,
+	_In_ MfsFile_t *File,
+	_In_ size_t BucketCount)
+{
+	// Variables
+	MfsInstance_t *Mfs = NULL;
+	uint32_t Bucket, Last = MFS_ENDOFCHAIN;
+	size_t BucketSizeBytes;
+	MapRecord_t Record, Link;
 
-	// Start by iterating to the last bucket
-	PreviousBucket = MFS_ENDOFCHAIN;
-	while (Record.Link != MFS_ENDOFCHAIN) {
-		PreviousBucket = Record.Link;
-		if (MfsGetBucketLink(Descriptor, Record.Link, &Record) != OsSuccess) {
-			ERROR("Failed to retrieve the next bucket-link");
+	// Trace
+	TRACE("MfsExpandRecord(File %s, Count %u)", 
+		MStringRaw(File->Name), BucketCount);
+
+	// Instantiate the pointers
+	Mfs = (MfsInstance_t*)Descriptor->ExtensionData;
+	BucketSizeBytes = Mfs->SectorsPerBucket * Descriptor->Disk.Descriptor.SectorSize;
+
+	// Find the last run of the record
+	Bucket = File->StartBucket;
+	while (Bucket != MFS_ENDOFCHAIN) {
+		Last = Bucket;
+		if (MfsGetBucketLink(Descriptor, Bucket, &Record) != OsSuccess) {
+			ERROR("Failed to get link for bucket %u", Bucket);
 			return OsError;
 		}
+		Bucket = Record.Link;
 	}
 
-	// If there was no allocated buckets to start with
-	// then do nothing
-	if (PreviousBucket == MFS_ENDOFCHAIN) {
-		// Update record
-		Record.Link = Mfs->MasterRecord.FreeBucket;
+	// Grow the last run if a free run starts right after it
+	if (Last != MFS_ENDOFCHAIN) {
+		size_t Index = MfsExtentLocate(Mfs, Last + Record.Length);
+		if (Index < Mfs->ExtentCount 
+			&& Mfs->Extents[Index].Bucket == (Last + Record.Length)) {
+			uint32_t Count = MIN(Mfs->Extents[Index].Length, (uint32_t)BucketCount);
+			if (MfsExtentTake(Descriptor, Index, Count) != OsSuccess) {
+				ERROR("Failed to update the free chain");
+				return OsError;
+			}
+
+			Record.Length += Count;
+			if (MfsSetBucketLink(Descriptor, Last, &Record, 1) != OsSuccess) {
+				ERROR("Failed to update link for bucket %u", Last);
+				return OsError;
+			}
+			if (Last == File->StartBucket) {
+				File->StartLength = Record.Length;
+			}
+			File->AllocatedSize += (uint64_t)Count * BucketSizeBytes;
+			BucketCount -= Count;
+		}
+	}
 
-		// Ok, so now update the pointer to free list
-		if (MfsSetBucketLink(Descriptor, PreviousBucket, &Record, 0)) {
-			ERROR("Failed to update the next bucket-link");
+	// Allocate a new run for the rest
+	if (BucketCount != 0) {
+		if (MfsAllocateBuckets(Descriptor, BucketCount, &Link) != OsSuccess) {
+			ERROR("Failed to allocate %u buckets for file", BucketCount);
 			return OsError;
 		}
+		if (Last == MFS_ENDOFCHAIN) {
+			File->StartBucket = Link.Link;
+			File->StartLength = Link.Length;
+		}
+		else {
+			Record.Link = Link.Link;
+			if (MfsSetBucketLink(Descriptor, Last, &Record, 0) != OsSuccess) {
+				ERROR("Failed to set link for bucket %u", Last);
+				return OsError;
+			}
+		}
+		File->AllocatedSize += (uint64_t)BucketCount * BucketSizeBytes;
+	}
+	return OsSuccess;
+}
 
-		// Update initial free bucket
-		Mfs->MasterRecord.FreeBucket = StartBucket;
+/* MfsDefragmentRecord
+ * Moves the data of a fragmented record into a single run if a free
+ * run is large enough, no handles may be open to the record */
+OsStatus_t
+MfsDefragmentRecord(
+	_In_ FileSystemDescriptor_t *Descriptor,
+	_In_ MfsFile_t *File)
+{
+	// Variables
+	MfsInstance_t *Mfs = NULL;
+	uint32_t Bucket, Target, Written = 0;
+	uint32_t OldStart, OldLength;
+	size_t Runs = 0, Total = 0, Index, Chunk;
+	MapRecord_t Record;
 
-		// As a last step update the master-record
-		return MfsUpdateMasterRecord(Descriptor);
+	// Instantiate the pointers
+	Mfs = (MfsInstance_t*)Descriptor->ExtensionData;
+	Chunk = GetBufferCapacity(Mfs->TransferBuffer) 
+		/ (Mfs->SectorsPerBucket * Descriptor->Disk.Descriptor.SectorSize);
+
+	// Directories are left alone, open records keep
+	// the location of their directory entry
+	if (MFS_FILERECORD_TYPE(File->Flags) != MFS_FILERECORD_FILE) {
+		return OsSuccess;
 	}
-	else {
+
+	// Count the runs of the record
+	Bucket = File->StartBucket;
+	while (Bucket != MFS_ENDOFCHAIN) {
+		if (MfsGetBucketLink(Descriptor, Bucket, &Record) != OsSuccess) {
+			return OsError;
+		}
+		Total += Record.Length;
+		Runs++;
+		Bucket = Record.Link;
+	}
+
+	// Only move records that are fragmented and small enough
+	// to be moved without stalling other requests
+	if (Runs < MFS_DEFRAG_MINRUNS || Total > MFS_DEFRAG_MAXBUCKETS) {
+		return OsSuccess;
+	}
+	Index = MfsExtentLocateSize(Mfs, (uint32_t)Total, 0);
+	if (Index == Mfs->ExtentCount) {
 		return OsSuccess;
 	}
+
+	// Trace
+	TRACE("MfsDefragmentRecord(File %s, Runs %u, Buckets %u)",
+		MStringRaw(File->Name), Runs, Total);
+
+	// Allocate the new run
+	Target = Mfs->ExtentsBySize[Index].Bucket;
+	if (MfsExtentTake(Descriptor, MfsExtentLocate(Mfs, Target), (uint32_t)Total) != OsSuccess) {
+		return OsError;
+	}
+	Record.Link = MFS_ENDOFCHAIN;
+	Record.Length = (uint32_t)Total;
+	if (MfsSetBucketLink(Descriptor, Target, &Record, 1) != OsSuccess) {
+		return OsError;
+	}
+
+	// Copy the runs in order
+	Bucket = File->StartBucket;
+	while (Bucket != MFS_ENDOFCHAIN) {
+		uint32_t Offset = 0;
+		if (MfsGetBucketLink(Descriptor, Bucket, &Record) != OsSuccess) {
+			return OsError;
+		}
+		while (Offset < Record.Length) {
+			size_t Count = MIN(Chunk, (size_t)(Record.Length - Offset));
+			if (MfsReadSectors(Descriptor, Mfs->TransferBuffer, 
+					MFS_GETSECTOR(Mfs, Bucket + Offset), Count * Mfs->SectorsPerBucket) != OsSuccess
+				|| MfsWriteSectors(Descriptor, Mfs->TransferBuffer,
+					MFS_GETSECTOR(Mfs, Target + Written), Count * Mfs->SectorsPerBucket) != OsSuccess) {
+				ERROR("Failed to move bucket %u to %u", Bucket + Offset, Target + Written);
+				MfsFreeBuckets(Descriptor, Target, (uint32_t)Total);
+				return OsError;
+			}
+			Offset += (uint32_t)Count;
+			Written += (uint32_t)Count;
+		}
+		Bucket = Record.Link;
+	}
+
+	// Point the record to the copy before the old 
+	// runs are released
+	OldStart = File->StartBucket;
+	OldLength = File->StartLength;
+	File->StartBucket = Target;
+	File->StartLength = (uint32_t)Total;
+	if (MfsUpdateRecord(Descriptor, File, MFS_ACTION_UPDATE) != FsOk) {
+		File->StartBucket = OldStart;
+		File->StartLength = OldLength;
+		MfsFreeBuckets(Descriptor, Target, (uint32_t)Total);
+		return OsError;
+	}
+	return MfsFreeBuckets(Descriptor, OldStart, OldLength);
 }
 
 /* MfsZeroBucket
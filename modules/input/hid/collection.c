@@ -31,32 +31,6 @@
 #include <stddef.h>
 #include <stdlib.h>
 
-/* HidExtractValue
- * Retrieves a value from a buffer by the given bit-offset and the for a certain
- * number of bits, the extracted value will be treated unsigned */
-uint64_t
-HidExtractValue(
-    _In_ uint8_t *Buffer, 
-    _In_ uint32_t BitOffset, 
-    _In_ uint32_t NumBits)
-{
-    // Variables
-    uint64_t value = 0;
-    uint32_t i = 0;
-    uint32_t offset = BitOffset;
-
-    // Do it by loop
-    while (i < NumBits) {
-        uint8_t bits = ((offset % 8) + NumBits - i) < 8 ? NumBits % 8 : 8 - (offset % 8);
-        value |= ((Buffer[offset / 8] >> (offset % 8)) & ((1 << bits) - 1)) << i;
-        i += bits;
-        offset += bits;
-    }
-
-    // Return calculated value
-    return value;
-}
-
 /* HidCollectionCreate
  * Allocates a new collection and fills it from the current states. */
 UsbHidReportCollection_t*
@@ -520,9 +494,18 @@ HidParseReportDescriptor(
         }
     }
 
-    // Store the collection in the device
-    // and return the calculated number of maximum bytes reports can use
+    // Store the collection in the device, and compile it into extraction
+    // tables. The compiled plans know the real size of each report
     Device->Collection = (RootCollection == NULL) ? CurrentCollection : RootCollection;
+    Device->ReportIdsUsed = ReportIdsUsed;
+    if (Device->Collection != NULL) {
+        LongestReport = HidCompileReportPlans(Device);
+        if (LongestReport != 0) {
+            return LongestReport;
+        }
+    }
+
+    // Fallback to the calculated number of maximum bytes reports can use
     if (ReportIdsUsed) {
         return DIVUP(LongestReport, 8) + 1;
     }
@@ -575,253 +558,26 @@ OsStatus_t
 HidCollectionCleanup(
     _In_ HidDevice_t *Device)
 {
+    // Variables
+    size_t i;
+
     // Sanitize input
     if (Device == NULL) {
         return OsError;
     }
 
-    // Recursively cleanup
-    return HidCollectionDestroy(Device->Collection);
-}
-
-/* HidParseReportInput
- * Handles report data from a collection-item of the type input.
- * This means we have actual input data from the device */
-void
-HidParseReportInput(
-    _In_ HidDevice_t *Device,
-    _In_ UsbHidReportCollectionItem_t *CollectionItem,
-    _In_ size_t DataIndex)
-{
-    // Variables
-    uint8_t *DataPointer = NULL, *PreviousDataPointer = NULL;
-    UsbHidReportInputItem_t *InputItem = NULL;
-    uint64_t Value = 0, OldValue = 0;
-    size_t i, Offset, Length, Usage;
-
-    // Static buffers
-    MInput_t InputData = { 0 };
-
-    // Cast the input-item from the ItemPointer
-    InputItem = (UsbHidReportInputItem_t*)CollectionItem->ItemPointer;
-
-    // Initiate pointers to new and previous data
-    DataPointer = &((uint8_t*)Device->Buffer)[DataIndex];
-    PreviousDataPointer = &((uint8_t*)Device->Buffer)[Device->PreviousDataIndex];
-
-    // Sanitize the type of input, if we are constant, it's padding
-    if (InputItem->Flags == REPORT_INPUT_TYPE_CONSTANT) {
-        return;
-    }
-
-    // If report-ids are active, we must make sure this data-packet
-    // is actually for this report
-    // The first byte of the data-report is the id
-    if (CollectionItem->Stats.ReportId != UUID_INVALID) {
-        uint8_t ReportId = DataPointer[0];
-        if (ReportId != (uint8_t)CollectionItem->Stats.ReportId) {
-            return;
-        }
-    }
-
-    // Initiate the mInputEvent data
-    InputData.Type = CollectionItem->InputType;
-
-    // Extract some of the state variables for parsing
-    Offset = InputItem->LocalState.BitOffset;
-    Length = CollectionItem->Stats.ReportSize;
-
-    // Iterate the data
-    for (i = 0; i < CollectionItem->Stats.ReportCount; i++, Offset += Length) {
-        Value = HidExtractValue(DataPointer, Offset, Length);
-        OldValue = HidExtractValue(PreviousDataPointer, Offset, Length);
-        
-        // We cant expect this to be correct though, it might be 0
-        Usage = InputItem->LocalState.Usages[i];
-
-        // Take action based on the type of input
-        // currently we only handle generic pc input devices
-        switch (CollectionItem->Stats.UsagePage) {
-            case HID_USAGE_PAGE_GENERIC_PC: {
-                switch (Usage) {
-                    // Calculating Device Bounds 
-                    // Resolution = (Logical Maximum � Logical Minimum) / 
-                    // ((Physical Maximum � Physical Minimum) * (10 Unit Exponent))
-
-                    // If physical min/max is not defined or are 0, 
-                    // we set them to be logical min/max
-
-                    // Grid updates like x, y or z coordinates have
-                    // changed. 
-                    case HID_REPORT_USAGE_X_AXIS:
-                    case HID_REPORT_USAGE_Y_AXIS:
-                    case HID_REPORT_USAGE_Z_AXIS: {
-                        // Variables
-                        int64_t Relative = (int64_t)Value;
-
-                        // Sanitize against no changes
-                        if (Value == 0) {
-                            break;
-                        }
-
-                        // If the value is absolute, we want to
-                        // make sure we calculate the relative
-                        if (InputItem->Flags == REPORT_INPUT_TYPE_ABSOLUTE) {
-                            Relative = (int64_t)(Value - OldValue);
-                        }
-
-                        // Handle sign-cases where we have to turn them negative
-                        if (Relative > CollectionItem->Stats.LogicalMax
-                            && CollectionItem->Stats.LogicalMin < 0) {
-                            if (Relative & (int64_t)(1 << (Length - 1))) {
-                                Relative -= (int64_t)(1 << Length);
-                            }
-                        }
-
-                        // Guard against relative = 0
-                        if (Relative != 0) {
-                            char *DebugAxis = NULL;
-                            if (Usage == HID_REPORT_USAGE_X_AXIS) {
-                                DebugAxis = "X";
-                                InputData.xRelative = (int32_t)Relative;
-                            }
-                            else if (Usage == HID_REPORT_USAGE_Y_AXIS) {
-                                DebugAxis = "Y";
-                                InputData.xRelative = (int32_t)Relative;
-                            }
-                            else { // HID_REPORT_USAGE_Z_AXIS
-                                DebugAxis = "Z";
-                                InputData.xRelative = (int32_t)Relative;
-                            }
-                            
-                            // Debug
-                            TRACE("%s-Change: %i (Original 0x%x, Old 0x%x, LogMax %i)",
-                                DebugAxis, (int32_t)Relative, (uint32_t)Value, (uint32_t)OldValue, 
-                                CollectionItem->Stats.LogicalMax);
-                        }
-
-                    } break;
-                }
-            } break;
-
-            // Describes keyboard or keypad events
-            case HID_REPORT_USAGE_PAGE_KEYBOARD: {
-
-            } break;
-
-            // Generic Button events
-            case HID_REPORT_USAGE_PAGE_BUTTON: {
-                uint8_t KeystateChanged = 0;
-
-                // Check against old values if any changes are neccessary
-                if (Value != OldValue) {
-                    KeystateChanged = 1;
-                }
-                else {
-                    break;
-                }
-
-                // Ok, so if we have multiple buttons (an array) 
-                // we will use the logical min & max to find out which
-                // button id this is
-                TRACE("Button %u: %u", i, (uint32_t)Value);
-
-                // Possible types are: Keyboard, keypad, mouse, gamepad or joystick
-                switch (CollectionItem->InputType) {
-                    // Mouse button event
-                    case InputMouse: {
-
-                    } break;
-
-                    // Gamepad button event
-                    case InputGamePad: {
-
-                    } break;
-
-                    // Joystick button event
-                    case InputJoystick: {
-
-                    } break;
-
-                    // Ignore the rest of the input-types
-                    default:
-                        break;
-                }
-            } break;
-
-            // Consumer, this is device-specific
-            case HID_REPORT_USAGE_PAGE_CONSUMER: {
-                // Virtual box sends me 0x238 which means AC Pan 
-                // which actually is a kind of scrolling 
-                // From the HID Usage Table Specs:
-                // Sel - Set the horizontal offset of the display in the document. 
-            } break;
-
-            // We don't handle rest of usage-pages, but should be ok
-            default: {
-                TRACE("Usage Page 0x%x (Input Type 0x%x), Usage 0x%x, Value 0x%x",
-                    CollectionItem->Stats.UsagePage, CollectionItem->InputType, Usage, (uint32_t)Value);
-            } break;
-        }
-    }
-    
-    // Create a new input report
-    if (InputData.xRelative != 0 ||
-        InputData.yRelative != 0 ||
-        InputData.zRelative != 0) {
-        //InputManagerCreatePointerEvent(&PointerData);
-    }
-}
-
-/* HidParseReport
- * Recursive report-parser that applies the given report-data
- * to the parsed report collection. */
-OsStatus_t
-HidParseReport(
-    _In_ HidDevice_t *Device,
-    _In_ UsbHidReportCollection_t *Collection,
-    _In_ size_t DataIndex)
-{
-    // Variables
-    UsbHidReportCollectionItem_t *Itr = NULL;
-    int Calls = 0;
-
-    // Get the collection pointer
-    Itr = Collection->Childs;
-    
-    // Iterate over all the children elements of root
-    while (Itr != NULL) {
-        switch (Itr->CollectionType) {
-
-            // Collections inside collections must be parsed
-            // recursively, so handle them
-            case HID_TYPE_COLLECTION: {
-                // Sanitize data attached
-                if (Itr->ItemPointer == NULL) {
-                    break;
-                }
-                
-                // Recursive parser for sub-collections
-                Calls += HidParseReport(Device, 
-                    (UsbHidReportCollection_t*)Itr->ItemPointer, DataIndex);
-            } break;
-            
-            // Input reports are interesting, that means we have an input event
-            case HID_TYPE_INPUT: {
-                HidParseReportInput(Device, Itr, DataIndex);
-                Calls++;
-            } break;
-
-            // For now we don't handle feature-reports
-            // output reports are not handled here, but never should
-            default:
-                break;
+    // Cleanup the compiled plans
+    if (Device->Plans != NULL) {
+        for (i = 0; i < Device->PlanCount; i++) {
+            if (Device->Plans[i].Fields != NULL) {
+                free(Device->Plans[i].Fields);
+            }
         }
-        
-        // Go to next collection item in the collection
-        Itr = Itr->Link;
+        free(Device->Plans);
+        Device->Plans = NULL;
+        Device->PlanCount = 0;
     }
 
-    // Return the number of actual parses we made
-    return Calls;
+    // Recursively cleanup
+    return HidCollectionDestroy(Device->Collection);
 }
@@ -155,12 +155,7 @@ HidInterrupt(
         return InterruptHandled;
     }
 
-    // Perform the report parse
-    if (!HidParseReport(Device, Device->Collection, DataIndex)) {
-        return InterruptHandled;
-    }
-
-    // Store previous index
-    Device->PreviousDataIndex = DataIndex;
+    // Execute the compiled report plan
+    HidParseReport(Device, DataIndex);
     return InterruptHandled;
 }
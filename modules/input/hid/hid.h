@@ -231,6 +231,44 @@ typedef struct _UsbHidReportCollection {
     UsbHidReportCollectionItem_t    *Childs;
 } UsbHidReportCollection_t;
 
+/* UsbHidReportField
+ * A precompiled extraction entry for a single value of a report. The fields
+ * are built once from the collection tree, so parsing a report is a flat loop
+ * over this table instead of a walk of the tree. */
+typedef struct _UsbHidReportField {
+    uint32_t                        BitOffset;
+    uint8_t                         BitLength;
+    uint8_t                         Target;
+    uint8_t                         Flags;
+    uint8_t                         Index;
+    int32_t                         Previous;
+} UsbHidReportField_t;
+
+/* UsbHidReportField::Target
+ * Contains definitions and bitfield definitions for UsbHidReportField::Target */
+#define HID_FIELD_TARGET_X                  0x0
+#define HID_FIELD_TARGET_Y                  0x1
+#define HID_FIELD_TARGET_Z                  0x2
+#define HID_FIELD_TARGET_BUTTON             0x3
+
+/* UsbHidReportField::Flags
+ * Contains definitions and bitfield definitions for UsbHidReportField::Flags */
+#define HID_FIELD_SIGNED                    0x1
+#define HID_FIELD_ABSOLUTE                  0x2
+#define HID_FIELD_PRIMED                    0x4
+
+/* UsbHidReportPlan
+ * The extraction table for a single report-id, the fields are stored in
+ * the order they appear in the report. */
+typedef struct _UsbHidReportPlan {
+    UUId_t                          ReportId;
+    MInputType_t                    InputType;
+    size_t                          ReportBits;
+    uint32_t                        Buttons;
+    size_t                          FieldCount;
+    UsbHidReportField_t            *Fields;
+} UsbHidReportPlan_t;
+
 /* HidDevice
  * Represents a human input device. */
 typedef struct _HidDevice {
@@ -243,8 +281,13 @@ typedef struct _HidDevice {
     UsbHidReportCollection_t    *Collection;
     uintptr_t                   *Buffer;
     uintptr_t                    BufferAddress;
-    size_t                       PreviousDataIndex;
     size_t                       ReportLength;
+
+    // Compiled report plans, indexed by report-id
+    UsbHidReportPlan_t          *Plans;
+    size_t                       PlanCount;
+    uint8_t                      PlanLookup[256];
+    int                          ReportIdsUsed;
     
     // Endpoint Information
     UsbHcEndpointDescriptor_t   *Control;
@@ -304,14 +347,21 @@ HidParseReportDescriptor(
     _In_ uint8_t *Descriptor,
     _In_ size_t DescriptorLength);
 
+/* HidCompileReportPlans
+ * Compiles the parsed collection tree into flat per-report extraction tables.
+ * The size in bytes of the largest individual report is returned. */
+__EXTERN
+size_t
+HidCompileReportPlans(
+    _In_ HidDevice_t *Device);
+
 /* HidParseReport
- * Recursive report-parser that applies the given report-data
- * to the parsed report collection. */
+ * Executes the compiled extraction table for the given report-data and
+ * emits a single input event for the report if anything changed. */
 __EXTERN
 OsStatus_t
 HidParseReport(
     _In_ HidDevice_t *Device,
-    _In_ UsbHidReportCollection_t *Collection,
     _In_ size_t DataIndex);
 
 /* HidCollectionCleanup
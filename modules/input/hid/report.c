@@ -0,0 +1,356 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS MCore - Human Input Device Driver (Generic)
+ * - Report plan compiler and executor, the collection tree is compiled
+ *   once into flat extraction tables that are executed for each report
+ */
+//#define __TRACE
+
+/* Includes
+ * - System */
+#include <os/utils.h>
+#include <os/driver/usb.h>
+#include "hid.h"
+
+/* Includes
+ * - Library */
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* HidExtractValue
+ * Retrieves a value from a buffer by the given bit-offset and the for a certain
+ * number of bits (max 32), the extracted value will be treated unsigned. A single
+ * word-sized load is used when the report is long enough to allow it. */
+uint32_t
+HidExtractValue(
+    _In_ uint8_t *Buffer,
+    _In_ size_t BufferLength,
+    _In_ uint32_t BitOffset,
+    _In_ uint32_t NumBits)
+{
+    // Variables
+    size_t ByteOffset = BitOffset >> 3;
+    uint64_t Value = 0;
+    size_t i;
+
+    // Load the word that contains the value, only the tail
+    // of the report needs to be assembled byte by byte
+    if ((ByteOffset + sizeof(uint64_t)) <= BufferLength) {
+        memcpy(&Value, &Buffer[ByteOffset], sizeof(uint64_t));
+    }
+    else {
+        for (i = 0; (ByteOffset + i) < BufferLength && i < sizeof(uint64_t); i++) {
+            Value |= ((uint64_t)Buffer[ByteOffset + i]) << (i * 8);
+        }
+    }
+    return (uint32_t)((Value >> (BitOffset & 0x7)) & ((1ULL << NumBits) - 1));
+}
+
+/* HidGetReportPlan
+ * Retrieves the plan for the given report-id, if it does not exist
+ * a new plan is created and registered in the lookup table. */
+UsbHidReportPlan_t*
+HidGetReportPlan(
+    _In_ HidDevice_t *Device,
+    _In_ UUId_t ReportId)
+{
+    // Variables
+    UsbHidReportPlan_t *Plans = NULL;
+    uint8_t Index = (ReportId == UUID_INVALID) ? 0 : (uint8_t)ReportId;
+
+    // Lookup is stored as index + 1, 0 means no plan
+    if (Device->PlanLookup[Index] != 0) {
+        return &Device->Plans[Device->PlanLookup[Index] - 1];
+    }
+
+    // Grow the plan array, this only happens while compiling
+    Plans = (UsbHidReportPlan_t*)realloc(Device->Plans,
+        (Device->PlanCount + 1) * sizeof(UsbHidReportPlan_t));
+    if (Plans == NULL) {
+        return NULL;
+    }
+    Device->Plans = Plans;
+    memset(&Plans[Device->PlanCount], 0, sizeof(UsbHidReportPlan_t));
+    Plans[Device->PlanCount].ReportId = ReportId;
+
+    // Reports prefixed with an id start with the id byte
+    if (ReportId != UUID_INVALID) {
+        Plans[Device->PlanCount].ReportBits = 8;
+    }
+    Device->PlanCount++;
+    Device->PlanLookup[Index] = (uint8_t)Device->PlanCount;
+    return &Plans[Device->PlanCount - 1];
+}
+
+/* HidAppendReportField
+ * Appends a new extraction entry to the given plan. */
+OsStatus_t
+HidAppendReportField(
+    _In_ UsbHidReportPlan_t *Plan,
+    _In_ UsbHidReportField_t *Field)
+{
+    // Variables
+    UsbHidReportField_t *Fields = (UsbHidReportField_t*)realloc(Plan->Fields,
+        (Plan->FieldCount + 1) * sizeof(UsbHidReportField_t));
+    if (Fields == NULL) {
+        return OsError;
+    }
+    memcpy(&Fields[Plan->FieldCount], Field, sizeof(UsbHidReportField_t));
+    Plan->Fields = Fields;
+    Plan->FieldCount++;
+    return OsSuccess;
+}
+
+/* HidCompileInputItem
+ * Compiles a single input item into fields of the plan it belongs to. Only
+ * values we actually handle are compiled, padding and unknown usages just
+ * advance the report offset. */
+OsStatus_t
+HidCompileInputItem(
+    _In_ HidDevice_t *Device,
+    _In_ UsbHidReportCollectionItem_t *CollectionItem)
+{
+    // Variables
+    UsbHidReportInputItem_t *InputItem = (UsbHidReportInputItem_t*)CollectionItem->ItemPointer;
+    UsbHidReportGlobalStats_t *Stats = &CollectionItem->Stats;
+    UsbHidReportPlan_t *Plan = HidGetReportPlan(Device, Stats->ReportId);
+    UsbHidReportField_t Field;
+    size_t BitOffset, i;
+    uint32_t Usage;
+
+    // Sanitize the plan
+    if (Plan == NULL) {
+        return OsError;
+    }
+    BitOffset = Plan->ReportBits;
+    Plan->ReportBits += Stats->ReportCount * Stats->ReportSize;
+
+    // Constants are padding, arrays are not used by the generic driver
+    // and values wider than 32 bits are not supported
+    if (InputItem->Flags == REPORT_INPUT_TYPE_CONSTANT
+        || InputItem->Flags == REPORT_INPUT_TYPE_ARRAY
+        || Stats->ReportSize == 0 || Stats->ReportSize > 32) {
+        return OsSuccess;
+    }
+
+    // Store the input type of the first handled item
+    if (Plan->InputType == InputUnknown) {
+        Plan->InputType = CollectionItem->InputType;
+    }
+
+    // Compile each of the values in the item
+    for (i = 0; i < Stats->ReportCount; i++, BitOffset += Stats->ReportSize) {
+        memset(&Field, 0, sizeof(UsbHidReportField_t));
+        Field.BitOffset = BitOffset;
+        Field.BitLength = (uint8_t)Stats->ReportSize;
+
+        // Usages are either listed or given as a range
+        Usage = (i < 16) ? (uint32_t)InputItem->LocalState.Usages[i] : 0;
+        if (Usage == 0 && InputItem->LocalState.UsageMin != 0) {
+            Usage = InputItem->LocalState.UsageMin + i;
+            if (Usage > InputItem->LocalState.UsageMax) {
+                continue;
+            }
+        }
+
+        // Resolve the target for the value
+        if (Stats->UsagePage == HID_USAGE_PAGE_GENERIC_PC) {
+            if (Usage == HID_REPORT_USAGE_X_AXIS) {
+                Field.Target = HID_FIELD_TARGET_X;
+            }
+            else if (Usage == HID_REPORT_USAGE_Y_AXIS) {
+                Field.Target = HID_FIELD_TARGET_Y;
+            }
+            else if (Usage == HID_REPORT_USAGE_Z_AXIS
+                || Usage == HID_REPORT_USAGE_WHEEL) {
+                Field.Target = HID_FIELD_TARGET_Z;
+            }
+            else {
+                TRACE("Usage 0x%x is not handled", Usage);
+                continue;
+            }
+        }
+        else if (Stats->UsagePage == HID_REPORT_USAGE_PAGE_BUTTON) {
+            if (Usage == 0 || Usage > 32) {
+                continue;
+            }
+            Field.Target = HID_FIELD_TARGET_BUTTON;
+            Field.Index = (uint8_t)(Usage - 1);
+        }
+        else {
+            TRACE("Usage Page 0x%x is not handled", Stats->UsagePage);
+            continue;
+        }
+
+        // Precompute the sign and relative/absolute handling
+        if (Stats->LogicalMin < 0) {
+            Field.Flags |= HID_FIELD_SIGNED;
+        }
+        if (InputItem->Flags == REPORT_INPUT_TYPE_ABSOLUTE) {
+            Field.Flags |= HID_FIELD_ABSOLUTE;
+        }
+        if (HidAppendReportField(Plan, &Field) != OsSuccess) {
+            return OsError;
+        }
+    }
+    return OsSuccess;
+}
+
+/* HidCompileCollection
+ * Recursively compiles the collection in the order the items
+ * appear in the report. */
+OsStatus_t
+HidCompileCollection(
+    _In_ HidDevice_t *Device,
+    _In_ UsbHidReportCollection_t *Collection)
+{
+    // Variables
+    UsbHidReportCollectionItem_t *Itr = Collection->Childs;
+
+    while (Itr != NULL) {
+        if (Itr->CollectionType == HID_TYPE_COLLECTION && Itr->ItemPointer != NULL) {
+            if (HidCompileCollection(Device,
+                (UsbHidReportCollection_t*)Itr->ItemPointer) != OsSuccess) {
+                return OsError;
+            }
+        }
+        else if (Itr->CollectionType == HID_TYPE_INPUT) {
+            if (HidCompileInputItem(Device, Itr) != OsSuccess) {
+                return OsError;
+            }
+        }
+        Itr = Itr->Link;
+    }
+    return OsSuccess;
+}
+
+/* HidCompileReportPlans
+ * Compiles the parsed collection tree into flat per-report extraction tables.
+ * The size in bytes of the largest individual report is returned. */
+size_t
+HidCompileReportPlans(
+    _In_ HidDevice_t *Device)
+{
+    // Variables
+    size_t LongestReport = 0;
+    size_t i;
+
+    // Compile the tree
+    memset(&Device->PlanLookup[0], 0, sizeof(Device->PlanLookup));
+    if (HidCompileCollection(Device, Device->Collection) != OsSuccess) {
+        ERROR("Failed to compile the hid report plans");
+        return 0;
+    }
+
+    // Find the longest report
+    for (i = 0; i < Device->PlanCount; i++) {
+        TRACE("Report %u: %u fields, %u bits", Device->Plans[i].ReportId,
+            Device->Plans[i].FieldCount, Device->Plans[i].ReportBits);
+        if (DIVUP(Device->Plans[i].ReportBits, 8) > LongestReport) {
+            LongestReport = DIVUP(Device->Plans[i].ReportBits, 8);
+        }
+    }
+    return LongestReport;
+}
+
+/* HidParseReport
+ * Executes the compiled extraction table for the given report-data and
+ * emits a single input event for the report if anything changed. */
+OsStatus_t
+HidParseReport(
+    _In_ HidDevice_t *Device,
+    _In_ size_t DataIndex)
+{
+    // Variables
+    uint8_t *DataPointer = &((uint8_t*)Device->Buffer)[DataIndex];
+    UsbHidReportField_t *Field = NULL;
+    UsbHidReportPlan_t *Plan = NULL;
+    MInput_t InputData = { 0 };
+    uint32_t Buttons, Value;
+    int32_t Relative;
+    size_t i;
+
+    // Locate the plan, if report-ids are active the first byte is the id
+    i = Device->PlanLookup[Device->ReportIdsUsed ? DataPointer[0] : 0];
+    if (i == 0) {
+        return OsError;
+    }
+    Plan = &Device->Plans[i - 1];
+    Buttons = Plan->Buttons;
+
+    // Execute the extraction table
+    for (i = 0, Field = Plan->Fields; i < Plan->FieldCount; i++, Field++) {
+        Value = HidExtractValue(DataPointer, Device->ReportLength,
+            Field->BitOffset, Field->BitLength);
+
+        // Sign extend the value from its bit-length
+        if ((Field->Flags & HID_FIELD_SIGNED) && Field->BitLength < 32
+            && (Value & (1U << (Field->BitLength - 1)))) {
+            Value |= ~((1U << Field->BitLength) - 1);
+        }
+
+        // Buttons are collected into a single state mask
+        if (Field->Target == HID_FIELD_TARGET_BUTTON) {
+            if (Value != 0) {
+                Buttons |= (1U << Field->Index);
+            }
+            else {
+                Buttons &= ~(1U << Field->Index);
+            }
+            continue;
+        }
+
+        // Absolute values must be converted to relative ones, the first
+        // sample only primes the field
+        Relative = (int32_t)Value;
+        if (Field->Flags & HID_FIELD_ABSOLUTE) {
+            Relative = (Field->Flags & HID_FIELD_PRIMED) ? (int32_t)Value - Field->Previous : 0;
+            Field->Previous = (int32_t)Value;
+            Field->Flags |= HID_FIELD_PRIMED;
+        }
+
+        // Accumulate the axis change
+        if (Field->Target == HID_FIELD_TARGET_X) {
+            InputData.xRelative += Relative;
+        }
+        else if (Field->Target == HID_FIELD_TARGET_Y) {
+            InputData.yRelative += Relative;
+        }
+        else {
+            InputData.zRelative += Relative;
+        }
+    }
+
+    // Only emit an event if the report changed anything
+    if (InputData.xRelative == 0 && InputData.yRelative == 0
+        && InputData.zRelative == 0 && Buttons == Plan->Buttons) {
+        return OsSuccess;
+    }
+
+    // Fill in the remaining event data, any newly pressed
+    // button marks the event as a click
+    InputData.Type = Plan->InputType;
+    InputData.Scancode = Buttons;
+    InputData.Flags = (Buttons & ~Plan->Buttons) ? INPUT_BUTTON_CLICKED : INPUT_BUTTON_RELEASED;
+    Plan->Buttons = Buttons;
+    TRACE("Report %u: (%i, %i, %i), buttons 0x%x", Plan->ReportId, InputData.xRelative,
+        InputData.yRelative, InputData.zRelative, Buttons);
+    return CreateInput(&InputData);
+}
@@ -117,15 +117,28 @@ PACKED_TYPESTRUCT(PciNativeHeader, {
     uint8_t                 MaxLatency;   /* 0x3F */
 });
 
+/* PCI-Express memory mapped configuration space, each
+ * bus takes 1mb and each function on it 4kb */
+#define PCIE_BUS_SHIFT                  20
+#define PCIE_BUS_SIZE                   (1 << PCIE_BUS_SHIFT)
+
+/* The number of functions on a bus, the functions of a bus
+ * are indexed by (Slot << 3) | Function */
+#define PCI_BUS_FUNCTIONS               256
+#define PCI_BUS_COUNT                   256
+#define PCI_MAX_SEGMENTS                8
+
 /* The PCI bus header, this is used
  * by the bus code, and is not related to any hardware structure. 
- * This keeps track of the bus's in the system and their io space */
+ * This keeps track of the bus's in the system and their io space,
+ * and the devices found on each of its busses */
 typedef struct _PciBus {
     DeviceIoSpace_t         IoSpace;
     int                     IsExtended;
     int                     Segment;
     int                     BusStart;
     int                     BusEnd;
+    struct _PciDevice     **Functions[PCI_BUS_COUNT];
 } PciBus_t;
 
 /* PCI Device header
@@ -48,8 +48,10 @@ typedef struct _McfgEntry {
 #pragma pack(pop)
 
 /* Globals, we want to
- * keep track of all pci-devices by having this root device */
-static Collection_t *__GlbPciDevices    = NULL;
+ * keep track of all pci-devices by having this root device, the
+ * devices are also indexed by location in the bus of their segment */
+static PciBus_t *__GlbSegments[PCI_MAX_SEGMENTS] = { NULL };
+static int __GlbSegmentCount            = 0;
 static PciDevice_t *__GlbRoot           = NULL;
 static int __GlbAcpiAvailable           = 0;
 
@@ -219,6 +221,73 @@ void PciReadBars(PciBus_t *Bus, MCoreDevice_t *Device, uint32_t HeaderType)
 	}
 }
 
+/* PciLookupChild (Private)
+ * Looks up the pci-device at the given location by walking the
+ * devices behind the given device, this is used for the busses
+ * whose function table could not be allocated */
+PciDevice_t*
+PciLookupChild(
+	_In_ PciDevice_t *Parent,
+	_In_ DevInfo_t Segment,
+	_In_ DevInfo_t Bus,
+	_In_ DevInfo_t Slot,
+	_In_ DevInfo_t Function)
+{
+	// Variables
+	CollectionItem_t *Node = NULL;
+	PciDevice_t *Result = NULL;
+
+	if (Parent->Children == NULL) {
+		return NULL;
+	}
+	_foreach(Node, Parent->Children) {
+		PciDevice_t *Child = (PciDevice_t*)Node->Data;
+		if (Child->BusIo->Segment == (int)Segment && Child->Bus == Bus
+			&& Child->Slot == Slot && Child->Function == Function) {
+			return Child;
+		}
+		if (Child->IsBridge) {
+			Result = PciLookupChild(Child, Segment, Bus, Slot, Function);
+			if (Result != NULL) {
+				return Result;
+			}
+		}
+	}
+	return NULL;
+}
+
+/* PciLookupDevice
+ * Looks up the pci-device at the given location through
+ * the function table of the segment, and falls back to
+ * walking the devices if the function isn't indexed */
+PciDevice_t*
+PciLookupDevice(
+	_In_ DevInfo_t Segment,
+	_In_ DevInfo_t Bus,
+	_In_ DevInfo_t Slot,
+	_In_ DevInfo_t Function)
+{
+	// Variables
+	int i;
+
+	// Sanitize the location
+	if (Bus >= PCI_BUS_COUNT || Slot >= 32 || Function >= 8) {
+		return NULL;
+	}
+
+	for (i = 0; i < __GlbSegmentCount; i++) {
+		PciBus_t *Io = __GlbSegments[i];
+		if (Io->Segment == (int)Segment) {
+			if (Io->Functions[Bus] != NULL
+				&& Io->Functions[Bus][(Slot << 3) | Function] != NULL) {
+				return Io->Functions[Bus][(Slot << 3) | Function];
+			}
+			break;
+		}
+	}
+	return PciLookupChild(__GlbRoot, Segment, Bus, Slot, Function);
+}
+
 /* PciDerivePin
  * Pin conversion from behind a bridge */
 int PciDerivePin(int Device, int Pin) {
@@ -275,9 +344,15 @@ PciCheckFunction(
 			PciSettings | PCI_COMMAND_INTDISABLE);
 	}
 
-	// Add to the flat list
-	lKey.Value = 0;
-	CollectionAppend(__GlbPciDevices, CollectionCreateNode(lKey, Device));
+	// Add to the function table of the bus, if the table can't be 
+	// allocated the function is only found by walking the devices
+	if (Device->BusIo->Functions[Bus] == NULL) {
+		Device->BusIo->Functions[Bus] = (PciDevice_t**)
+			calloc(PCI_BUS_FUNCTIONS, sizeof(PciDevice_t*));
+	}
+	if (Device->BusIo->Functions[Bus] != NULL) {
+		Device->BusIo->Functions[Bus][(Slot << 3) | Function] = Device;
+	}
 
 	// Add to list
 	if (Pcs->Class == PCI_CLASS_BRIDGE
@@ -287,9 +362,13 @@ PciCheckFunction(
 		CollectionAppend(Parent->Children, CollectionCreateNode(lKey, Device));
 		Device->Children = CollectionCreate(KeyInteger);
 
-		// Extract secondary bus
+		// Extract secondary bus, only busses behind bridges are
+		// enumerated and a bridge that isn't configured is skipped
 		SecondBus = PciReadSecondaryBusNumber(Device->BusIo, Bus, Slot, Function);
-		PciCheckBus(Device, SecondBus);
+		if (SecondBus > Bus && SecondBus >= Device->BusIo->BusStart
+			&& SecondBus <= Device->BusIo->BusEnd) {
+			PciCheckBus(Device, SecondBus);
+		}
 	}
 	else {
 		// Trace
@@ -415,6 +494,38 @@ PciCheckBus(
 	}
 }
 
+/* PciCheckRoot
+ * Enumerates the busses of a segment starting from the host bridge, if
+ * it's a multi-function device each function is a host controller that
+ * is responsible for its own bus */
+void
+PciCheckRoot(
+	_In_ PciBus_t *Io)
+{
+	// Variables
+	int Function;
+
+	// Store the segment for lookups
+	if (__GlbSegmentCount < PCI_MAX_SEGMENTS) {
+		__GlbSegments[__GlbSegmentCount++] = Io;
+	}
+	__GlbRoot->BusIo = Io;
+
+	if (!(PciReadHeaderType(Io, (DevInfo_t)Io->BusStart, 0, 0) & 0x80)) {
+		PciCheckBus(__GlbRoot, Io->BusStart);
+	}
+	else {
+		for (Function = 0; Function < 8; Function++) {
+			if (PciReadVendorId(Io, (DevInfo_t)Io->BusStart, 0, (DevInfo_t)Function) == 0xFFFF) {
+				continue;
+			}
+			if (Io->BusStart + Function <= Io->BusEnd) {
+				PciCheckBus(__GlbRoot, Io->BusStart + Function);
+			}
+		}
+	}
+}
+
 /* PciCreateDeviceFromPci
  * Creates a new MCoreDevice_t from a pci-device 
  * and registers it with the device-manager */
@@ -542,15 +653,11 @@ BusEnumerate(void)
 	ACPI_TABLE_HEADER *Header = NULL;
 	ACPI_TABLE_MCFG *McfgTable = NULL;
 	AcpiDescriptor_t Acpi;
-	int Function;
 
 	// Initialize the root bridge element
 	__GlbRoot = (PciDevice_t*)malloc(sizeof(PciDevice_t));
 	memset(__GlbRoot, 0, sizeof(PciDevice_t));
 
-	// Initialize a flat list of devices
-	__GlbPciDevices = CollectionCreate(KeyInteger);
-
 	// Initiate root-bridge
 	__GlbRoot->Children = CollectionCreate(KeyInteger);
 	__GlbRoot->IsBridge = 1;
@@ -564,9 +671,7 @@ BusEnumerate(void)
 		/* PCI-Express */
 		if (AcpiQueryTable(ACPI_SIG_MCFG, &Header) == OsSuccess) {
 			TRACE("PCI-Express Controller (mcfg length 0x%x)", Header->Length);
-			//McfgTable = (ACPI_TABLE_MCFG*)Header;
-			//remember to free(McfgTable)
-			free(Header);
+			McfgTable = (ACPI_TABLE_MCFG*)Header;
 		}
 
 		/* Does the PS2 exist in our system? */
@@ -585,53 +690,57 @@ BusEnumerate(void)
 	{
 		/* Woah, there exists Pci Express Controllers */
 		McfgEntry_t *Entry = (McfgEntry_t*)((uint8_t*)McfgTable + sizeof(ACPI_TABLE_MCFG));
-		size_t EntryCount = (McfgTable->Header.Length - sizeof(ACPI_TABLE_MCFG) / sizeof(McfgEntry_t));
+		size_t EntryCount = (McfgTable->Header.Length - sizeof(ACPI_TABLE_MCFG)) / sizeof(McfgEntry_t);
 		size_t Itr = 0;
 
 		/* Iterate */
-		for (Itr = 0; Itr < EntryCount; Itr++)
+		for (Itr = 0; Itr < EntryCount; Itr++, Entry++)
 		{
 			/* Allocate entry */
 			PciBus_t *Bus = (PciBus_t*)malloc(sizeof(PciBus_t));
 			memset(Bus, 0, sizeof(PciBus_t));
 
-			/* Setup io-space */
-			Bus->IoSpace.Type = IO_SPACE_MMIO;
-			Bus->IoSpace.PhysicalBase = (uintptr_t)Entry->BaseAddress;
-			Bus->IoSpace.Size = (1024 * 1024 * 256);
-
-			/* Memory Map 256 MB!!!!! Oh fucking god */
+			/* Only the busses the segment decodes are mapped, 
+			 * that is 1mb per bus instead of the full 256mb */
 			Bus->IsExtended = 1;
 			Bus->BusStart = Entry->StartBus;
 			Bus->BusEnd = Entry->EndBus;
 			Bus->Segment = Entry->SegmentGroup;
-
-			/* Store bus */
-			__GlbRoot->BusIo = Bus;
-
-			/* Enumerate devices */
-			for (Function = Bus->BusStart; Function <= Bus->BusEnd; Function++) {
-				PciCheckBus(__GlbRoot, Function);
+			Bus->IoSpace.Type = IO_SPACE_MMIO;
+			Bus->IoSpace.PhysicalBase = (uintptr_t)(Entry->BaseAddress 
+				+ ((uint64_t)Entry->StartBus << PCIE_BUS_SHIFT));
+			Bus->IoSpace.Size = (size_t)(Bus->BusEnd - Bus->BusStart + 1) * PCIE_BUS_SIZE;
+
+			/* Sanitize the address, and map the configuration space */
+			if ((sizeof(uintptr_t) < 8 && Entry->BaseAddress > SIZE_MAX)
+				|| CreateIoSpace(&Bus->IoSpace) != OsSuccess) {
+				ERROR("Failed to initialize pci-express segment %u", Entry->SegmentGroup);
+				free(Bus);
+				continue;
+			}
+			if (AcquireIoSpace(&Bus->IoSpace) != OsSuccess) {
+				ERROR("Failed to acquire pci-express io with id %u", Bus->IoSpace.Id);
+				free(Bus);
+				continue;
 			}
 
-			/* Next */
-			Entry++;
+			/* Enumerate devices */
+			PciCheckRoot(Bus);
 		}
 
 		/* Cleanup the mcfg table */
 		free(McfgTable);
 	}
-	else
+	
+	/* Use the legacy io-ports if there were no usable segments */
+	if (__GlbSegmentCount == 0)
 	{
 		/* Allocate a new pci-bus controller */
 		PciBus_t *Bus = (PciBus_t*)malloc(sizeof(PciBus_t));
 		memset(Bus, 0, sizeof(PciBus_t));
 
-		/* Store the newly allocated bus in root bridge */
-		__GlbRoot->BusIo = Bus;
-
 		/* Setup some initial stuff */
-		Bus->BusEnd = 7;
+		Bus->BusEnd = PCI_BUS_COUNT - 1;
 		
 		/* Initialize a fixed io-space */
 		Bus->IoSpace.Type = IO_SPACE_IO;
@@ -650,18 +759,8 @@ BusEnumerate(void)
 			for (;;);
 		}
 		
-		/* We can check whether or not it's a multi-function
-		 * root-bridge, in that case there are multiple buses */
-		if (!(PciReadHeaderType(Bus, 0, 0, 0) & 0x80)) {
-			PciCheckBus(__GlbRoot, 0);
-		}
-		else {
-			for (Function = 0; Function < 8; Function++) {
-				if (PciReadVendorId(Bus, 0, 0, Function) != 0xFFFF)
-					break;
-				PciCheckBus(__GlbRoot, Function);
-			}
-		}
+		/* Enumerate devices */
+		PciCheckRoot(Bus);
 	}
 
 	/* Now, that the bus is enumerated, we can
@@ -685,15 +784,8 @@ IoctlDevice(
 	uint16_t Settings;
 
 	// Lookup pci-device
-	foreach(dNode, __GlbPciDevices) {
-		PciDevice_t *Entry = (PciDevice_t*)dNode->Data;
-		if (Entry->Bus == Device->Bus
-			&& Entry->Slot == Device->Slot
-			&& Entry->Function == Device->Function) {
-			PciDevice = Entry;
-			break;
-		}
-	}
+	PciDevice = PciLookupDevice(Device->Segment, Device->Bus, 
+		Device->Slot, Device->Function);
 
 	// Sanitize
 	if (PciDevice == NULL) {
@@ -753,15 +845,8 @@ IoctlDeviceEx(
 	PciDevice_t *PciDevice = NULL;
 
 	// Lookup pci-device
-	foreach(dNode, __GlbPciDevices) {
-		PciDevice_t *Entry = (PciDevice_t*)dNode->Data;
-		if (Entry->Bus == Device->Bus
-			&& Entry->Slot == Device->Slot
-			&& Entry->Function == Device->Function) {
-			PciDevice = Entry;
-			break;
-		}
-	}
+	PciDevice = PciLookupDevice(Device->Segment, Device->Bus, 
+		Device->Slot, Device->Function);
 
 	// Sanitize
 	if (PciDevice == NULL) {
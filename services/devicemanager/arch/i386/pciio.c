@@ -35,9 +35,10 @@
 size_t PciCalculateOffset(PciBus_t *Io,
 	DevInfo_t Bus, DevInfo_t Device, DevInfo_t Function, size_t Register)
 {
-	/* PCI Express? */
+	/* PCI Express? The io-space starts at the first bus of the segment */
 	if (Io->IsExtended) {
-		return (size_t)((Bus << 20) | (Device << 15) | (Function << 12) | Register);
+		return (size_t)(((Bus - Io->BusStart) << PCIE_BUS_SHIFT) 
+			| (Device << 15) | (Function << 12) | Register);
 	}
 	else {
 		return (size_t)(0x80000000 | (Bus << 16) | (Device << 11) 
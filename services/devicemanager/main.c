@@ -36,24 +36,76 @@
 #include <string.h>
 #include <ctype.h>
 
+/* Lookup tables
+ * Device and contract ids are handed out in sequence, so both are kept
+ * in tables indexed by id that grow as needed. Queries are by type and
+ * resolve to the first contract registered for the type */
+#define __DEVICEMANAGER_TABLE_GROWTH    32
+#define __DEVICEMANAGER_CONTRACT_TYPES  ((int)ContractStorage + 1)
+
+/* Dependencies
+ * Time in milliseconds enumeration waits for each service
+ * that the spawned drivers register with */
+#define __DEVICEMANAGER_DEPENDENCY_TIMEOUT  5000
+
 /* Globals 
  * Keep track of all devices and contracts */
-static Collection_t *__GlbContracts = NULL;
-static Collection_t *__GlbDevices   = NULL;
+static MCoreDevice_t **GlbDevices   = NULL;
+static MContract_t **GlbContracts   = NULL;
+static MContract_t *GlbContractsByType[__DEVICEMANAGER_CONTRACT_TYPES] = { NULL };
+static size_t GlbDevicesCapacity    = 0, GlbContractsCapacity = 0;
 static UUId_t GlbDeviceIdGen        = 0, GlbDriverIdGen = 0;
 static int GlbInitialized           = 0;
 static int GlbRun                   = 0;
 
+/* TableInsert
+ * Stores the entry at the index of the table, the table
+ * is grown in steps when the index is beyond its end */
+OsStatus_t
+TableInsert(
+    _InOut_ void ***Table,
+    _InOut_ size_t *Capacity,
+    _In_ UUId_t Index,
+    _In_ void *Entry)
+{
+    // Variables
+    void **Resized = NULL;
+    size_t NewCapacity = 0;
+
+    // Grow the table if needed
+    if ((size_t)Index >= *Capacity) {
+        NewCapacity = ((size_t)Index + __DEVICEMANAGER_TABLE_GROWTH)
+            & ~(size_t)(__DEVICEMANAGER_TABLE_GROWTH - 1);
+        Resized = (void**)realloc(*Table, NewCapacity * sizeof(void*));
+        if (Resized == NULL) {
+            return OsError;
+        }
+        memset(&Resized[*Capacity], 0, (NewCapacity - *Capacity) * sizeof(void*));
+        *Table = Resized;
+        *Capacity = NewCapacity;
+    }
+    (*Table)[Index] = Entry;
+    return OsSuccess;
+}
+
+/* DeviceLookup
+ * Returns the registered device with the given id, or NULL */
+MCoreDevice_t*
+DeviceLookup(
+    _In_ UUId_t DeviceId)
+{
+    if ((size_t)DeviceId >= GlbDevicesCapacity) {
+        return NULL;
+    }
+    return GlbDevices[DeviceId];
+}
+
 /* OnLoad
  * The entry-point of a server, this is called
  * as soon as the server is loaded in the system */
 OsStatus_t
 OnLoad(void)
 {
-    // Setup list
-    __GlbDevices = CollectionCreate(KeyInteger);
-    __GlbContracts = CollectionCreate(KeyInteger);
-
     // Init variables
     GlbDeviceIdGen = 0;
     GlbDriverIdGen = 0;
@@ -63,6 +115,15 @@ OnLoad(void)
     // Register us with server manager
     RegisterService(__DEVICEMANAGER_TARGET);
 
+    // Services start in parallel, the drivers we spawn register with
+    // these so enumeration waits for them. A missing service is not fatal
+    if (WaitForService(__FILEMANAGER_TARGET, __DEVICEMANAGER_DEPENDENCY_TIMEOUT) != OsSuccess) {
+        WARNING("Enumerating without the file manager");
+    }
+    if (WaitForService(__USBMANAGER_TARGET, __DEVICEMANAGER_DEPENDENCY_TIMEOUT) != OsSuccess) {
+        WARNING("Enumerating without the usb manager");
+    }
+
     // Enumerate bus controllers/devices */
     return BusEnumerate();
 }
@@ -135,11 +196,9 @@ OnEvent(
             // Extract argumenters
             MCoreDevice_t *Device = NULL;
             OsStatus_t Result = OsError;
-            DataKey_t Key;
 
             // Lookup device
-            Key.Value = (int)Message->Arguments[0].Data.Value;
-            Device = CollectionGetDataByKey(__GlbDevices, Key, 0);
+            Device = DeviceLookup((UUId_t)Message->Arguments[0].Data.Value);
 
             // Sanitizie
             if (Device != NULL) {
@@ -240,7 +299,6 @@ RegisterDevice(
 {
     // Variables
     MCoreDevice_t *CopyDevice = NULL;
-    DataKey_t Key;
 
     // Not sure what to do with this rn
     _CRT_UNUSED(Parent);
@@ -256,14 +314,17 @@ RegisterDevice(
 
     // Generate id and update out
     *Id = Device->Id = GlbDeviceIdGen++;
-    Key.Value = (int)Device->Id;
 
     // Allocate our own copy of the device
     CopyDevice = (MCoreDevice_t*)malloc(Device->Length);
     memcpy(CopyDevice, Device, Device->Length);
 
-    // Add to list
-    CollectionAppend(__GlbDevices, CollectionCreateNode(Key, CopyDevice));
+    // Add to table
+    if (TableInsert((void***)&GlbDevices, &GlbDevicesCapacity,
+            Device->Id, CopyDevice) != OsSuccess) {
+        free(CopyDevice);
+        return OsError;
+    }
 
     // Now, we want to try to find a driver
     // for the new device
@@ -288,17 +349,13 @@ RegisterContract(
 {
     // Variables
     MContract_t *CopyContract = NULL;
-    DataKey_t Key;
 
     // Trace
     TRACE("Registered driver for device %u: %s", 
         Contract->DeviceId, &Contract->Name[0]);
 
-    // Lookup device
-    Key.Value = (int)Contract->DeviceId;
-
     // Sanitize device
-    if (CollectionGetDataByKey(__GlbDevices, Key, 0) == NULL) {
+    if (DeviceLookup(Contract->DeviceId) == NULL) {
         ERROR("Device id %u was not registered with the device manager",
             Contract->DeviceId);
         return OsError;
@@ -309,14 +366,22 @@ RegisterContract(
 
     // Update contract id
     Contract->ContractId = *Id;
-    Key.Value = (int)*Id;
 
     // Allocate our own copy of the contract
     CopyContract = (MContract_t*)malloc(sizeof(MContract_t));
     memcpy(CopyContract, Contract, sizeof(MContract_t));
 
-    // Add to list
-    CollectionAppend(__GlbContracts, CollectionCreateNode(Key, CopyContract));
+    // Add to tables, queries by type go to the first contract of the type
+    if (TableInsert((void***)&GlbContracts, &GlbContractsCapacity,
+            *Id, CopyContract) != OsSuccess) {
+        free(CopyContract);
+        return OsError;
+    }
+    if ((int)CopyContract->Type >= 0 
+        && (int)CopyContract->Type < __DEVICEMANAGER_CONTRACT_TYPES
+        && GlbContractsByType[CopyContract->Type] == NULL) {
+        GlbContractsByType[CopyContract->Type] = CopyContract;
+    }
 
     // Done
     return OsSuccess;
@@ -338,15 +403,17 @@ QueryContract(
     _Out_Opt_ __CONST void *ResultBuffer,
     _In_Opt_ size_t ResultLength)
 {
-    // Iterate driver list and find a contract that
-    // matches the request
-    foreach(cNode, __GlbContracts) {
-        MContract_t *Contract = (MContract_t*)cNode->Data;
-        if (Contract->Type == Type) {
-            return QueryDriver(Contract, Function, 
-                Arg0, Length0, Arg1, Length1, Arg2, Length2,
-                ResultBuffer, ResultLength);
-        }
+    // Variables
+    MContract_t *Contract = NULL;
+
+    // Lookup the contract that handles the type
+    if ((int)Type >= 0 && (int)Type < __DEVICEMANAGER_CONTRACT_TYPES) {
+        Contract = GlbContractsByType[Type];
+    }
+    if (Contract == NULL) {
+        return OsError;
     }
-    return OsError;
+    return QueryDriver(Contract, Function, 
+        Arg0, Length0, Arg1, Length1, Arg2, Length2,
+        ResultBuffer, ResultLength);
 }
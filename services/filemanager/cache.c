@@ -0,0 +1,660 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS - File Manager Service
+ * - Page cache, file data is cached in pages keyed by filesystem, file
+ *   and page index so every handle and every filesystem module shares
+ *   one cache. Pages outlive the open file, so reopening a file reads
+ *   from memory.
+ * - Writes that grow a file are buffered without allocating disk space,
+ *   the filesystem allocates all of it in one go when the first page past
+ *   the end on disk is written back
+ */
+//#define __TRACE
+
+/* Includes
+ * - System */
+#include <os/driver/file.h>
+#include <os/thread.h>
+#include <os/utils.h>
+#include "include/vfs.h"
+
+/* Includes
+ * - C-Library */
+#include <stdlib.h>
+#include <string.h>
+
+/* VfsCachePage (Private)
+ * A page of file data, the file is identified by the filesystem
+ * id and the path hash, the same key the open-file list uses */
+typedef struct _VfsCachePage {
+	UUId_t					 FileSystem;
+	size_t					 File;
+	uint64_t				 Index;
+	size_t					 Length;
+	int						 Valid;
+	int						 Referenced;
+	int						 Dirty;
+	UUId_t					 Writer;
+	BufferObject_t			*Buffer;
+	struct _VfsCachePage	*Link;
+} VfsCachePage_t;
+
+/* VfsCacheExtension (Private)
+ * A file that has buffered data past its end on disk, the disk size
+ * is where the data stops being on disk */
+typedef struct _VfsCacheExtension {
+	UUId_t					 FileSystem;
+	size_t					 File;
+	uint64_t				 DiskSize;
+	int						 Valid;
+} VfsCacheExtension_t;
+
+/* Globals
+ * The pages are a fixed pool, the buffers of the pages are
+ * allocated the first time a page is used. The dirty count is
+ * read by the write-back thread without locking, it only decides
+ * if an event is sent */
+static VfsCachePage_t GlbCachePages[__FILEMANAGER_CACHEPAGES];
+static VfsCachePage_t *GlbCacheTable[__FILEMANAGER_CACHEBUCKETS];
+static VfsCacheExtension_t GlbCacheExtensions[__FILEMANAGER_CACHEEXTENSIONS];
+static BufferObject_t *GlbCacheTransfer = NULL;
+static size_t GlbCacheHand = 0;
+static volatile int GlbCacheDirty = 0;
+static volatile int GlbCacheFlushPending = 0;
+
+/* VfsCacheHash (Private)
+ * Hashes the page key into a table bucket */
+size_t
+VfsCacheHash(
+	_In_ UUId_t FileSystem,
+	_In_ size_t File,
+	_In_ uint64_t Index)
+{
+	size_t Hash = (File * 31) + (size_t)FileSystem;
+	Hash ^= (size_t)Index * 0x9E3779B1;
+	Hash ^= Hash >> 16;
+	return Hash & (__FILEMANAGER_CACHEBUCKETS - 1);
+}
+
+/* VfsCacheLookup (Private)
+ * Looks up a cached page, marks it referenced when found */
+VfsCachePage_t*
+VfsCacheLookup(
+	_In_ UUId_t FileSystem,
+	_In_ size_t File,
+	_In_ uint64_t Index)
+{
+	// Variables
+	VfsCachePage_t *Page = GlbCacheTable[VfsCacheHash(FileSystem, File, Index)];
+
+	while (Page != NULL) {
+		if (Page->FileSystem == FileSystem
+			&& Page->File == File
+			&& Page->Index == Index) {
+			Page->Referenced = 1;
+			return Page;
+		}
+		Page = Page->Link;
+	}
+	return NULL;
+}
+
+/* VfsCacheUnlink (Private)
+ * Removes the page from the table and marks it unused */
+void
+VfsCacheUnlink(
+	_In_ VfsCachePage_t *Page)
+{
+	// Variables
+	VfsCachePage_t **Link =
+		&GlbCacheTable[VfsCacheHash(Page->FileSystem, Page->File, Page->Index)];
+
+	while (*Link != NULL) {
+		if (*Link == Page) {
+			*Link = Page->Link;
+			break;
+		}
+		Link = &(*Link)->Link;
+	}
+	if (Page->Dirty) {
+		GlbCacheDirty--;
+	}
+	Page->Link = NULL;
+	Page->Valid = 0;
+	Page->Dirty = 0;
+}
+
+/* VfsCacheGetExtension (Private)
+ * Looks up the buffered extension of the file, returns NULL if
+ * all data of the file is on disk */
+VfsCacheExtension_t*
+VfsCacheGetExtension(
+	_In_ UUId_t FileSystem,
+	_In_ size_t File)
+{
+	// Variables
+	int i;
+
+	for (i = 0; i < __FILEMANAGER_CACHEEXTENSIONS; i++) {
+		if (GlbCacheExtensions[i].Valid
+			&& GlbCacheExtensions[i].FileSystem == FileSystem
+			&& GlbCacheExtensions[i].File == File) {
+			return &GlbCacheExtensions[i];
+		}
+	}
+	return NULL;
+}
+
+/* VfsCacheSeek (Private)
+ * Moves the filesystem position of the handle, empty files
+ * can't be seeked by the filesystems but are always at 0 */
+FileSystemCode_t
+VfsCacheSeek(
+	_In_ FileSystemFileHandle_t *Handle,
+	_In_ uint64_t Position)
+{
+	// Variables
+	FileSystem_t *Fs = (FileSystem_t*)Handle->File->System;
+
+	if (Handle->File->Size == 0) {
+		Handle->Position = Position;
+		return FsOk;
+	}
+	return Fs->Module->SeekFile(&Fs->Descriptor, Handle, Position);
+}
+
+/* VfsCacheFlushPage (Private)
+ * Writes the page to the filesystem through the handle, the filesystem
+ * maps the buffer it is given, so it's given a copy of the buffer object
+ * and the mapping of the page is left alone */
+FileSystemCode_t
+VfsCacheFlushPage(
+	_In_ VfsCachePage_t *Page,
+	_In_ FileSystemFileHandle_t *Handle)
+{
+	// Variables
+	FileSystem_t *Fs = (FileSystem_t*)Handle->File->System;
+	uint64_t Position = Handle->Position;
+	FileSystemCode_t Code = FsOk;
+	size_t BytesWritten = 0;
+
+	TRACE("VfsCacheFlushPage(File 0x%x, Index %u)", Page->File, LODWORD(Page->Index));
+
+	// The space for buffered data is allocated before any of it is written
+	Code = VfsCacheCommit(Handle);
+	if (Code != FsOk) {
+		return Code;
+	}
+
+	// Allocate the transfer object on first use
+	if (GlbCacheTransfer == NULL) {
+		GlbCacheTransfer = (BufferObject_t*)malloc(GetBufferObjectSize(Page->Buffer));
+		if (GlbCacheTransfer == NULL) {
+			return FsDiskError;
+		}
+	}
+	memcpy(GlbCacheTransfer, Page->Buffer, GetBufferObjectSize(Page->Buffer));
+	ChangeBufferSize(GlbCacheTransfer, Page->Length);
+
+	// Write the page and restore the position
+	Code = VfsCacheSeek(Handle, Page->Index * __FILEMANAGER_CACHEPAGESIZE);
+	if (Code == FsOk) {
+		Code = Fs->Module->WriteFile(&Fs->Descriptor, Handle,
+			GlbCacheTransfer, &BytesWritten);
+	}
+	VfsCacheSeek(Handle, Position);
+	Handle->Position = Position;
+
+	if (Code == FsOk) {
+		Page->Dirty = 0;
+		GlbCacheDirty--;
+	}
+	return Code;
+}
+
+/* VfsCacheEvict (Private)
+ * Finds a page to reuse by a clock sweep, referenced pages get a
+ * second chance and dirty pages are written back before reuse */
+VfsCachePage_t*
+VfsCacheEvict(void)
+{
+	// Variables
+	VfsCachePage_t *Page = NULL;
+	int i;
+
+	for (i = 0; i < (__FILEMANAGER_CACHEPAGES * 2); i++) {
+		Page = &GlbCachePages[GlbCacheHand];
+		GlbCacheHand = (GlbCacheHand + 1) % __FILEMANAGER_CACHEPAGES;
+		if (!Page->Valid) {
+			return Page;
+		}
+		if (Page->Referenced) {
+			Page->Referenced = 0;
+			continue;
+		}
+		if (Page->Dirty) {
+			FileSystemFileHandle_t *Writer = NULL;
+			DataKey_t Key;
+			Key.Value = (int)Page->Writer;
+			Writer = (FileSystemFileHandle_t*)
+				CollectionGetDataByKey(VfsGetOpenHandles(), Key, 0);
+			if (Writer == NULL || VfsCacheFlushPage(Page, Writer) != FsOk) {
+				continue;
+			}
+		}
+		VfsCacheUnlink(Page);
+		return Page;
+	}
+	return NULL;
+}
+
+/* VfsCacheGetPage (Private)
+ * Retrieves the page of the file the handle refers to, the page
+ * is read from the filesystem if it's not cached */
+VfsCachePage_t*
+VfsCacheGetPage(
+	_In_ FileSystemFileHandle_t *Handle,
+	_In_ uint64_t Index,
+	_Out_ FileSystemCode_t *Code)
+{
+	// Variables
+	FileSystem_t *Fs = (FileSystem_t*)Handle->File->System;
+	VfsCacheExtension_t *Extension = NULL;
+	VfsCachePage_t *Page = NULL;
+	uint64_t Position = Handle->Position;
+	uint64_t Start = Index * __FILEMANAGER_CACHEPAGESIZE;
+	size_t BytesIndex = 0, BytesRead = 0;
+	size_t Bucket;
+
+	// Lookup the cache first
+	*Code = FsOk;
+	Page = VfsCacheLookup(Fs->Id, Handle->File->Hash, Index);
+	if (Page != NULL) {
+		return Page;
+	}
+
+	// Find a page and make sure it has a buffer
+	Page = VfsCacheEvict();
+	if (Page == NULL) {
+		*Code = FsDiskError;
+		return NULL;
+	}
+	if (Page->Buffer == NULL) {
+		Page->Buffer = CreateBuffer(__FILEMANAGER_CACHEPAGESIZE);
+		if (Page->Buffer == NULL) {
+			*Code = FsDiskError;
+			return NULL;
+		}
+	}
+	ChangeBufferSize(Page->Buffer, __FILEMANAGER_CACHEPAGESIZE);
+	ZeroBuffer(Page->Buffer);
+
+	// Only what is on disk is read, a page past the end on
+	// disk starts out empty
+	Extension = VfsCacheGetExtension(Fs->Id, Handle->File->Hash);
+	if (Extension != NULL && Start < Extension->DiskSize
+		&& (Extension->DiskSize - Start) < __FILEMANAGER_CACHEPAGESIZE) {
+		ChangeBufferSize(Page->Buffer, (size_t)(Extension->DiskSize - Start));
+	}
+
+	// Read the page, it's aligned so the data starts at 0
+	if ((Extension == NULL || Start < Extension->DiskSize)
+		&& Start < Handle->File->Size) {
+		TRACE("VfsCacheGetPage(File 0x%x, Index %u) miss", Handle->File->Hash, LODWORD(Index));
+		*Code = VfsCacheSeek(Handle, Start);
+		if (*Code == FsOk) {
+			*Code = Fs->Module->ReadFile(&Fs->Descriptor, Handle,
+				Page->Buffer, &BytesIndex, &BytesRead);
+		}
+		VfsCacheSeek(Handle, Position);
+		Handle->Position = Position;
+		ChangeBufferSize(Page->Buffer, __FILEMANAGER_CACHEPAGESIZE);
+		if (*Code != FsOk || BytesIndex != 0) {
+			if (*Code == FsOk) {
+				*Code = FsDiskError;
+			}
+			return NULL;
+		}
+	}
+
+	// Publish the page
+	Page->FileSystem = Fs->Id;
+	Page->File = Handle->File->Hash;
+	Page->Index = Index;
+	Page->Length = BytesRead;
+	Page->Valid = 1;
+	Page->Referenced = 1;
+	Page->Dirty = 0;
+	Page->Writer = UUID_INVALID;
+	Bucket = VfsCacheHash(Page->FileSystem, Page->File, Index);
+	Page->Link = GlbCacheTable[Bucket];
+	GlbCacheTable[Bucket] = Page;
+	return Page;
+}
+
+/* VfsCacheWriteback (Private)
+ * The write-back thread, sends the flush event to the service when
+ * there are dirty pages. The pages are written by the event so the
+ * filesystems are only ever called from the service thread */
+int
+VfsCacheWriteback(
+	_In_Opt_ void *Argument)
+{
+	// Variables
+	MRemoteCall_t Rpc;
+
+	_CRT_UNUSED(Argument);
+	while (1) {
+		ThreadSleep(__FILEMANAGER_FLUSHINTERVAL);
+		if (GlbCacheDirty != 0 && GlbCacheFlushPending == 0) {
+			GlbCacheFlushPending = 1;
+			RPCInitialize(&Rpc, __FILEMANAGER_INTERFACE_VERSION,
+				PIPE_RPCOUT, __FILEMANAGER_FLUSHCACHE);
+			RPCEvent(&Rpc, __FILEMANAGER_TARGET);
+		}
+	}
+	return 0;
+}
+
+/* VfsCacheInitialize
+ * Initializes the page cache and starts the write-back thread */
+OsStatus_t
+VfsCacheInitialize(void)
+{
+	memset(&GlbCachePages[0], 0, sizeof(GlbCachePages));
+	memset(&GlbCacheTable[0], 0, sizeof(GlbCacheTable));
+	memset(&GlbCacheExtensions[0], 0, sizeof(GlbCacheExtensions));
+	GlbCacheHand = 0;
+	GlbCacheDirty = 0;
+	GlbCacheFlushPending = 0;
+	if (ThreadCreate(VfsCacheWriteback, NULL) == UUID_INVALID) {
+		return OsError;
+	}
+	return OsSuccess;
+}
+
+/* VfsCacheRead
+ * Reads from the current position of the handle into the buffer
+ * through the page cache, the position of the handle is not updated */
+FileSystemCode_t
+VfsCacheRead(
+	_In_ FileSystemFileHandle_t *Handle,
+	_Out_ BufferObject_t *BufferObject,
+	_Out_ size_t *BytesIndex,
+	_Out_ size_t *BytesRead)
+{
+	// Variables
+	FileSystem_t *Fs = (FileSystem_t*)Handle->File->System;
+	FileSystemCode_t Code = FsOk;
+	uint64_t Position = Handle->Position;
+	size_t BytesToRead = GetBufferSize(BufferObject);
+
+	// Unbuffered handles read from the filesystem, but
+	// must see what was written through the cache
+	if (Handle->Options & __FILE_VOLATILE) {
+		Code = VfsCacheFlush(Handle);
+		if (Code != FsOk) {
+			return Code;
+		}
+		return Fs->Module->ReadFile(&Fs->Descriptor, Handle,
+			BufferObject, BytesIndex, BytesRead);
+	}
+
+	// Cap the read at the end of file
+	*BytesIndex = 0;
+	*BytesRead = 0;
+	if ((Position + BytesToRead) > Handle->File->Size) {
+		BytesToRead = (size_t)(Handle->File->Size - Position);
+	}
+
+	// The buffer of the requester is mapped in while we copy
+	if (AcquireBuffer(BufferObject) != OsSuccess) {
+		return FsInvalidParameters;
+	}
+	SeekBuffer(BufferObject, 0);
+
+	while (BytesToRead != 0) {
+		uint64_t Index = Position / __FILEMANAGER_CACHEPAGESIZE;
+		size_t Offset = (size_t)(Position % __FILEMANAGER_CACHEPAGESIZE);
+		VfsCachePage_t *Page = VfsCacheGetPage(Handle, Index, &Code);
+		size_t ByteCount;
+
+		if (Page == NULL || Page->Length <= Offset) {
+			break;
+		}
+		ByteCount = MIN(BytesToRead, Page->Length - Offset);
+		WriteBuffer(BufferObject,
+			(__CONST void*)((uint8_t*)GetBufferData(Page->Buffer) + Offset), ByteCount, NULL);
+		*BytesRead += ByteCount;
+		Position += ByteCount;
+		BytesToRead -= ByteCount;
+	}
+
+	ReleaseBuffer(BufferObject);
+	return Code;
+}
+
+/* VfsCacheWrite
+ * Writes the buffer at the current position of the handle through the
+ * page cache, unbuffered handles write to the filesystem. The position
+ * of the handle is not updated */
+FileSystemCode_t
+VfsCacheWrite(
+	_In_ FileSystemFileHandle_t *Handle,
+	_In_ BufferObject_t *BufferObject,
+	_Out_ size_t *BytesWritten)
+{
+	// Variables
+	FileSystem_t *Fs = (FileSystem_t*)Handle->File->System;
+	VfsCacheExtension_t *Extension = NULL;
+	FileSystemCode_t Code = FsOk;
+	uint64_t Position = Handle->Position;
+	size_t BytesToWrite = GetBufferSize(BufferObject);
+	int i;
+
+	*BytesWritten = 0;
+
+	// Writes that grow the file are buffered without allocating, the
+	// disk size is remembered so the pages past it are not read
+	if (!(Handle->Options & __FILE_VOLATILE)
+		&& (Position + BytesToWrite) > Handle->File->Size) {
+		Extension = VfsCacheGetExtension(Fs->Id, Handle->File->Hash);
+		for (i = 0; Extension == NULL && i < __FILEMANAGER_CACHEEXTENSIONS; i++) {
+			if (!GlbCacheExtensions[i].Valid) {
+				Extension = &GlbCacheExtensions[i];
+				Extension->FileSystem = Fs->Id;
+				Extension->File = Handle->File->Hash;
+				Extension->DiskSize = Handle->File->Size;
+				Extension->Valid = 1;
+			}
+		}
+	}
+
+	// Unbuffered writes go to the filesystem, so do writes that
+	// grow the file when too many files have buffered growth
+	if ((Handle->Options & __FILE_VOLATILE)
+		|| ((Position + BytesToWrite) > Handle->File->Size && Extension == NULL)) {
+		Code = VfsCacheFlush(Handle);
+		if (Code != FsOk) {
+			return Code;
+		}
+		VfsCacheInvalidate(Handle->File, Position, BytesToWrite);
+		Code = VfsCacheSeek(Handle, Position);
+		if (Code == FsOk) {
+			Code = Fs->Module->WriteFile(&Fs->Descriptor, Handle,
+				BufferObject, BytesWritten);
+		}
+		Handle->Position = Position;
+		return Code;
+	}
+
+	// The buffer of the requester is mapped in while we copy
+	if (AcquireBuffer(BufferObject) != OsSuccess) {
+		return FsInvalidParameters;
+	}
+	SeekBuffer(BufferObject, 0);
+
+	while (BytesToWrite != 0) {
+		uint64_t Index = Position / __FILEMANAGER_CACHEPAGESIZE;
+		size_t Offset = (size_t)(Position % __FILEMANAGER_CACHEPAGESIZE);
+		VfsCachePage_t *Page = VfsCacheGetPage(Handle, Index, &Code);
+		size_t ByteCount;
+
+		if (Page == NULL || Page->Length < Offset) {
+			break;
+		}
+		ByteCount = MIN(BytesToWrite, __FILEMANAGER_CACHEPAGESIZE - Offset);
+		ReadBuffer(BufferObject,
+			(__CONST void*)((uint8_t*)GetBufferData(Page->Buffer) + Offset), ByteCount, NULL);
+		if (!Page->Dirty) {
+			Page->Dirty = 1;
+			GlbCacheDirty++;
+		}
+		Page->Writer = Handle->Id;
+		Page->Length = MAX(Page->Length, Offset + ByteCount);
+		*BytesWritten += ByteCount;
+		Position += ByteCount;
+		BytesToWrite -= ByteCount;
+
+		// Grow the file for each page, looking up the next page may evict
+		// this one which commits the size, the filesystem is told when
+		// it's written back
+		if (Position > Handle->File->Size) {
+			Handle->File->Size = Position;
+		}
+	}
+	ReleaseBuffer(BufferObject);
+	return Code;
+}
+
+/* VfsCacheFlush
+ * Writes back all dirty pages of the file the handle refers to */
+FileSystemCode_t
+VfsCacheFlush(
+	_In_ FileSystemFileHandle_t *Handle)
+{
+	// Variables
+	FileSystem_t *Fs = (FileSystem_t*)Handle->File->System;
+	FileSystemCode_t Code = FsOk;
+	int i;
+
+	Code = VfsCacheCommit(Handle);
+	if (Code != FsOk) {
+		return Code;
+	}
+	for (i = 0; i < __FILEMANAGER_CACHEPAGES && GlbCacheDirty != 0; i++) {
+		VfsCachePage_t *Page = &GlbCachePages[i];
+		if (Page->Valid && Page->Dirty
+			&& Page->FileSystem == Fs->Id
+			&& Page->File == Handle->File->Hash) {
+			FileSystemCode_t PageCode = VfsCacheFlushPage(Page, Handle);
+			if (PageCode != FsOk) {
+				Code = PageCode;
+			}
+		}
+	}
+	return Code;
+}
+
+/* VfsCacheCommit
+ * Makes the filesystem allocate the space of buffered writes that
+ * grew the file the handle refers to, the data stays buffered */
+FileSystemCode_t
+VfsCacheCommit(
+	_In_ FileSystemFileHandle_t *Handle)
+{
+	// Variables
+	FileSystem_t *Fs = (FileSystem_t*)Handle->File->System;
+	VfsCacheExtension_t *Extension = NULL;
+	FileSystemCode_t Code = FsOk;
+
+	Extension = VfsCacheGetExtension(Fs->Id, Handle->File->Hash);
+	if (Extension == NULL) {
+		return FsOk;
+	}
+
+	TRACE("VfsCacheCommit(File 0x%x, Size %u => %u)", Handle->File->Hash,
+		LODWORD(Extension->DiskSize), LODWORD(Handle->File->Size));
+	Code = Fs->Module->ChangeFileSize(&Fs->Descriptor, 
+		Handle->File, Handle->File->Size);
+	if (Code == FsOk) {
+		Extension->Valid = 0;
+	}
+	return Code;
+}
+
+/* VfsCacheFlushAll
+ * Writes back all dirty pages, invoked by the write-back event */
+OsStatus_t
+VfsCacheFlushAll(void)
+{
+	// Variables
+	OsStatus_t Result = OsSuccess;
+	int i;
+
+	GlbCacheFlushPending = 0;
+	for (i = 0; i < __FILEMANAGER_CACHEPAGES && GlbCacheDirty != 0; i++) {
+		VfsCachePage_t *Page = &GlbCachePages[i];
+		if (Page->Valid && Page->Dirty) {
+			FileSystemFileHandle_t *Writer = NULL;
+			DataKey_t Key;
+			Key.Value = (int)Page->Writer;
+			Writer = (FileSystemFileHandle_t*)
+				CollectionGetDataByKey(VfsGetOpenHandles(), Key, 0);
+			if (Writer == NULL || VfsCacheFlushPage(Page, Writer) != FsOk) {
+				Result = OsError;
+			}
+		}
+	}
+	return Result;
+}
+
+/* VfsCacheInvalidate
+ * Drops the cached pages of the file that overlap the given range, a
+ * length of 0 drops everything from the offset. Dirty pages are discarded */
+void
+VfsCacheInvalidate(
+	_In_ FileSystemFile_t *File,
+	_In_ uint64_t Offset,
+	_In_ uint64_t Length)
+{
+	// Variables
+	FileSystem_t *Fs = (FileSystem_t*)File->System;
+	VfsCacheExtension_t *Extension = NULL;
+	uint64_t First = Offset / __FILEMANAGER_CACHEPAGESIZE;
+	uint64_t Last = (Offset + Length - 1) / __FILEMANAGER_CACHEPAGESIZE;
+	int i;
+
+	// Buffered growth is dropped with the pages
+	Extension = VfsCacheGetExtension(Fs->Id, File->Hash);
+	if (Extension != NULL && Length == 0) {
+		Extension->Valid = 0;
+	}
+
+	for (i = 0; i < __FILEMANAGER_CACHEPAGES; i++) {
+		VfsCachePage_t *Page = &GlbCachePages[i];
+		if (Page->Valid
+			&& Page->FileSystem == Fs->Id
+			&& Page->File == File->Hash
+			&& Page->Index >= First
+			&& (Length == 0 || Page->Index <= Last)) {
+			VfsCacheUnlink(Page);
+		}
+	}
+}
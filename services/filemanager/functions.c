@@ -18,7 +18,7 @@
  *
  * MollenOS - File Manager Service
  * - Handles all file related services and disk services
- * - ToDo Buffering is not ported to BufferObjects yet
+ * - File data is buffered by the page cache in cache.c
  */
 
 /* Includes 
@@ -183,6 +183,7 @@ VfsOpenInternal(
 
 					// Take care of truncation flag
 					if (Handle->Options & __FILE_TRUNCATE) {
+						VfsCacheInvalidate(File, 0, 0);
 						Code = Fs->Module->ChangeFileSize(&Fs->Descriptor, File, 0);
 					}
 
@@ -365,10 +366,15 @@ CloseFile(
 		return FsAccessDenied;
 	}
 
-	/* If there has been allocated any buffers they should
-	 * be flushed and cleaned up */
+	/* Written pages are flushed and any buffers cleaned up, the 
+	 * dirty pages of a file never outlive the handles of the file.
+	 * If they can't be written the handle stays open, the pages
+	 * keep their writer and the close can be retried */
+	Code = VfsCacheFlush(fHandle);
+	if (Code != FsOk) {
+		return Code;
+	}
 	if (!(fHandle->Options & __FILE_VOLATILE)) {
-		FlushFile(Requester, Handle);
 		free(fHandle->OutBuffer);
 	}
 
@@ -450,8 +456,9 @@ DeleteFile(
 		goto Cleanup;
 	}
 
-	/* Deep Delete */
+	/* Deep Delete, cached pages of the file are dropped */
 	Fs = (FileSystem_t*)Handle->File->System;
+	VfsCacheInvalidate(Handle->File, 0, 0);
 	Code = Fs->Module->DeleteFile(&Fs->Descriptor, Handle);
 
 Cleanup:
@@ -476,7 +483,6 @@ ReadFile(
 	FileSystemFileHandle_t *fHandle = NULL;
 	FileSystemCode_t Code = FsOk;
 	CollectionItem_t *hNode = NULL;
-	FileSystem_t *Fs = NULL;
 	DataKey_t Key;
 
 	/* Sanitize request parameters first
@@ -508,15 +514,9 @@ ReadFile(
 		return FsOk;
 	}
 
-	/* Sanity -> Flush if we wrote and now read */
-	if (fHandle->LastOperation != __FILE_OPERATION_READ) {
-		Code = FlushFile(Requester, Handle);
-	}
-
-	/* Instantiate the pointer and read */
-	Fs = (FileSystem_t*)fHandle->File->System;
-	Code = Fs->Module->ReadFile(&Fs->Descriptor, fHandle, 
-		BufferObject, BytesIndex, BytesRead);
+	/* Read through the page cache, it's shared by all handles
+	 * so there is nothing to flush when switching from writing */
+	Code = VfsCacheRead(fHandle, BufferObject, BytesIndex, BytesRead);
 
 	/* Update stats for the handle */
 	fHandle->LastOperation = __FILE_OPERATION_READ;
@@ -538,8 +538,6 @@ WriteFile(
 	FileSystemFileHandle_t *fHandle = NULL;
 	FileSystemCode_t Code = FsOk;
 	CollectionItem_t *hNode = NULL;
-	FileSystem_t *Fs = NULL;
-	int WriteToDisk = 0;
 	DataKey_t Key;
 
 	/* Sanitize request parameters first
@@ -565,71 +563,9 @@ WriteFile(
 		return FsAccessDenied;
 	}
 
-	/* Sanity -> Clear read buffer if we are writing */
-	if (fHandle->LastOperation != __FILE_OPERATION_WRITE) {
-		Code = FlushFile(Requester, Handle);
-	}
-
-	/* Instantiate the pointer */
-	Fs = (FileSystem_t*)fHandle->File->System;
-
-	/* Write to buffer if we can 
-	 * - This needs severely improved support for
-	 * bufferobjects before this works */
-#if 0
-	if (!(fHandle->Options & __FILE_VOLATILE)) {
-		size_t BytesAvailable = Fs->Descriptor.Disk.Descriptor.SectorSize
-			- fHandle->OutBufferPosition;
-
-		/* Do we have enough room for the entire transaction? */
-		if (BufferObject->Length < BytesAvailable) {
-			uint8_t *bPtr = (uint8_t*)fHandle->OutBuffer;
-			memcpy((bPtr + fHandle->OutBufferPosition), 
-				BufferObject->Virtual, BufferObject->Length);
-			fHandle->OutBufferPosition += BufferObject->Length;
-			*BytesWritten = BufferObject->Length;
-		}
-		else { /* This is only really neccesary if we actually used the buffer */
-			if (fHandle->OutBufferPosition != 0)
-			{
-				/* Allocate a temporary buffer big enough */
-				uint8_t *TemporaryBuffer =
-					(uint8_t*)malloc(fHandle->OutBufferPosition + BufferObject->Length);
-
-				/* Copy data over */
-				memcpy(TemporaryBuffer, Handle->oBuffer, Handle->oBufferPosition);
-				memcpy(TemporaryBuffer + Handle->oBufferPosition, Buffer, Length);
-
-				/* Write to Disk */
-				BytesWritten = Fs->WriteFile(Fs, Handle, TempBuffer, 
-					Handle->oBufferPosition + Length);
-
-				/* Sanity */
-				if (BytesWritten > Length)
-					BytesWritten = Length;
-
-				/* Free temporary buffer */
-				free(TempBuffer);
-
-				/* Reset index */
-				memset(Handle->oBuffer, 0, Fs->SectorSize);
-				Handle->oBufferPosition = 0;
-			}
-			else
-				WriteToDisk = 1;
-		}
-	}
-	else
-		WriteToDisk = 1;
-#else
-	WriteToDisk = 1;
-#endif
-
-	/* Deep Write */
-	if (WriteToDisk) {
-		Code = Fs->Module->WriteFile(&Fs->Descriptor, 
-			fHandle, BufferObject, BytesWritten);
-	}
+	/* Write through the page cache, it decides if the data
+	 * is buffered or goes to the filesystem */
+	Code = VfsCacheWrite(fHandle, BufferObject, BytesWritten);
 
 	/* Update stats for the handle */
 	fHandle->LastOperation = __FILE_OPERATION_WRITE;
@@ -687,13 +623,14 @@ SeekFile(
 		return FsAccessDenied;
 	}
 
-	/* Flush buffers before seeking */
-	if (!(fHandle->Options & __FILE_VOLATILE)) {
-		Code = FlushFile(Requester, Handle);
-	}
-
-	/* Instantiate the filesystem pointer */
+	/* Instantiate the filesystem pointer, the page cache
+	 * is shared so there is nothing to flush before seeking, but
+	 * the filesystem must know the size of buffered growth */
 	Fs = (FileSystem_t*)fHandle->File->System;
+	Code = VfsCacheCommit(fHandle);
+	if (Code != FsOk) {
+		return Code;
+	}
 
 	/* Seek into file */
 	Code = Fs->Module->SeekFile(&Fs->Descriptor, fHandle, SeekAbs.Full);
@@ -715,9 +652,7 @@ FlushFile(
 {
 	/* Variables */
 	FileSystemFileHandle_t *fHandle = NULL;
-	FileSystemCode_t Code = FsOk;
 	CollectionItem_t *hNode = NULL;
-	FileSystem_t *Fs = NULL;
 	DataKey_t Key;
 
 	/* Sanitize request parameters first
@@ -743,23 +678,8 @@ FlushFile(
 		return FsOk;
 	}
 
-	/* Instantiate the filesystem pointer */
-	Fs = (FileSystem_t*)fHandle->File->System;
-
-	/* Empty output buffer 
-	 * - But sanitize the buffers first */
-	if (fHandle->OutBuffer != NULL
-		&& fHandle->OutBufferPosition != 0) {
-		size_t BytesWritten = 0;
-#if 0
-		Code = Fs->Module->WriteFile(&Fs->Descriptor, fHandle, NULL, &BytesWritten);
-#endif
-		if (BytesWritten != fHandle->OutBufferPosition) {
-			return FsDiskError;
-		}
-	}
-
-	return Code;
+	/* Write back the dirty pages of the file */
+	return VfsCacheFlush(fHandle);
 }
 
 /* MoveFile
@@ -40,8 +40,21 @@
  * - General identifiers can be used in paths */
 #define __FILEMANAGER_INITPROCESS		"system/sapphire.mxi"
 #define __FILEMANAGER_RESOLVEQUEUE		IPC_DECL_FUNCTION(10000)
+#define __FILEMANAGER_FLUSHCACHE		IPC_DECL_FUNCTION(10001)
 #define __FILEMANAGER_MAXDISKS			64
 
+/* VFS Cache Definitions
+ * File data is cached in pages shared by all handles, pages are
+ * evicted by a clock sweep and dirty pages are written back on the
+ * flush interval (milliseconds), on flush and on close. Writes that
+ * grow a file are buffered too, the filesystem allocates the space for
+ * them when they are written back */
+#define __FILEMANAGER_CACHEPAGESIZE		0x1000
+#define __FILEMANAGER_CACHEPAGES		1024
+#define __FILEMANAGER_CACHEBUCKETS		256
+#define __FILEMANAGER_FLUSHINTERVAL		1000
+#define __FILEMANAGER_CACHEEXTENSIONS	32
+
 #define __FILE_OPERATION_NONE			0x00000000
 #define __FILE_OPERATION_READ			0x00000001
 #define __FILE_OPERATION_WRITE			0x00000002
@@ -161,6 +174,42 @@ __EXTERN UUId_t VfsIdentifierFileGet(void);
 __EXTERN Collection_t *VfsGetOpenFiles(void);
 __EXTERN Collection_t *VfsGetOpenHandles(void);
 
+/* VfsCacheInitialize
+ * Initializes the page cache and starts the write-back thread */
+__EXTERN OsStatus_t VfsCacheInitialize(void);
+
+/* VfsCacheRead
+ * Reads from the current position of the handle into the buffer
+ * through the page cache, the position of the handle is not updated */
+__EXTERN FileSystemCode_t VfsCacheRead(FileSystemFileHandle_t *Handle,
+	BufferObject_t *BufferObject, size_t *BytesIndex, size_t *BytesRead);
+
+/* VfsCacheWrite
+ * Writes the buffer at the current position of the handle through the
+ * page cache, unbuffered handles write to the filesystem. The position
+ * of the handle is not updated */
+__EXTERN FileSystemCode_t VfsCacheWrite(FileSystemFileHandle_t *Handle,
+	BufferObject_t *BufferObject, size_t *BytesWritten);
+
+/* VfsCacheFlush
+ * Writes back all dirty pages of the file the handle refers to */
+__EXTERN FileSystemCode_t VfsCacheFlush(FileSystemFileHandle_t *Handle);
+
+/* VfsCacheCommit
+ * Makes the filesystem allocate the space of buffered writes that
+ * grew the file the handle refers to, the data stays buffered */
+__EXTERN FileSystemCode_t VfsCacheCommit(FileSystemFileHandle_t *Handle);
+
+/* VfsCacheFlushAll
+ * Writes back all dirty pages, invoked by the write-back event */
+__EXTERN OsStatus_t VfsCacheFlushAll(void);
+
+/* VfsCacheInvalidate
+ * Drops the cached pages of the file that overlap the given range, a
+ * length of 0 drops everything from the offset. Dirty pages are discarded */
+__EXTERN void VfsCacheInvalidate(FileSystemFile_t *File,
+	uint64_t Offset, uint64_t Length);
+
 /* VfsIdentifierAllocate 
  * Allocates a free identifier index for the
  * given disk, it varies based upon disk type */
@@ -165,6 +165,11 @@ OsStatus_t OnLoad(void)
 	GlbFileId = 0;
 	GlbInitialized = 1;
 
+	// Initialize the page cache
+	if (VfsCacheInitialize() != OsSuccess) {
+		return OsError;
+	}
+
 	// Register us with server manager
 	RegisterService(__FILEMANAGER_TARGET);
 
@@ -222,6 +227,13 @@ OsStatus_t OnEvent(MRemoteCall_t *Message)
 			Result = VfsResolveQueueExecute();
 		} break;
 
+		/* Writes back dirty pages of the page cache, this
+		 * is sent by the write-back thread */
+		case __FILEMANAGER_FLUSHCACHE: {
+			TRACE("Filemanager.OnEvent FlushCache");
+			Result = VfsCacheFlushAll();
+		} break;
+
 		/* Opens or creates the given file path based on
 		 * the given <Access> and <Options> flags. */
 		case __FILEMANAGER_OPENFILE: {
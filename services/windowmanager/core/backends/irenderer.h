@@ -28,18 +28,43 @@
  * - Library */
 #include <os/osdefs.h>
 
+/* Prototypes
+ * Regions are passed by pointer only */
+class CRegion;
+
 /* IRenderer
- * Defines the methods that all renderer backends must implement */
+ * Defines the methods that all renderer backends must implement. All pixel
+ * data is 32 bit premultiplied ARGB8888, and pitches are given in bytes */
 class IRenderer
 {
 public:
+	virtual ~IRenderer() { }
+
 	// Create
 	// Creates and initializes the renderer for usage
-	virtual bool Create(Rect_t *Dimensions);
+	virtual bool Create(Rect_t *Dimensions) = 0;
 
 	// Destroy
 	// Destroys and cleansup the renderer resources
-	virtual bool Destroy();
+	virtual bool Destroy() = 0;
+
+	// Fill
+	// Fills the area of the backbuffer with the given color
+	virtual bool Fill(const Rect_t *Area, uint32_t Color) = 0;
+
+	// Blit
+	// Copies pixels into the area of the backbuffer, the source
+	// points to the pixel that maps to the top-left of the area
+	virtual bool Blit(const Rect_t *Area, const uint32_t *Source, size_t Pitch) = 0;
+
+	// Blend
+	// Blends pixels into the area of the backbuffer (source over destination),
+	// the source points to the pixel that maps to the top-left of the area
+	virtual bool Blend(const Rect_t *Area, const uint32_t *Source, size_t Pitch) = 0;
+
+	// Present
+	// Flushes the given region of the backbuffer to the display
+	virtual bool Present(const CRegion *Region) = 0;
 };
 
 #endif //!_SAPPHIRE_RENDERER_INTERFACE_H_
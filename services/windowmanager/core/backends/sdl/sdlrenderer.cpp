@@ -23,6 +23,7 @@
 /* Includes
  * - System */
 #include "sdlrenderer.h"
+#include "../../region.h"
 #include <os/utils.h>
 
 // Constructor 
@@ -31,7 +32,8 @@ CSdlRenderer::CSdlRenderer()
 {
 	// Null out members
 	m_pRenderer = NULL;
-	m_pTarget = NULL;
+	m_pWindow = NULL;
+	m_pTexture = NULL;
 
 	// TRACE
 	TRACE("CSdlRenderer::CSdlRenderer()");
@@ -47,27 +49,33 @@ CSdlRenderer::CSdlRenderer()
 // Creates and initializes the renderer for usage
 bool CSdlRenderer::Create(Rect_t *Dimensions)
 {
+	// Create the software backbuffer
+	if (!CSoftRenderer::Create(Dimensions)) {
+		ERROR("Failed to create the backbuffer");
+		return false;
+	}
+
 	// Create the primary window
-	m_pTarget = SDL_CreateWindow("Sapphire", 
+	m_pWindow = SDL_CreateWindow("Sapphire", 
 		Dimensions->x, Dimensions->y,
 		Dimensions->w, Dimensions->h,
 		SDL_WINDOW_SHOWN | SDL_WINDOW_FULLSCREEN);
 
 	// Sanitize result
-	if (m_pTarget == NULL) {
+	if (m_pWindow == NULL) {
 		ERROR("Failed to create SDL window: %s", SDL_GetError());
 		return false;
 	}
 
 	// Create the primary renderer
-	m_pRenderer = SDL_CreateRenderer(m_pTarget, -1,
+	m_pRenderer = SDL_CreateRenderer(m_pWindow, -1,
 		SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE);
 
 	// Sanitize result
 	if (m_pRenderer == NULL) {
 		ERROR("Failed to create SDL renderer: %s", SDL_GetError());
-		SDL_DestroyWindow(m_pTarget);
-		m_pTarget = NULL;
+		SDL_DestroyWindow(m_pWindow);
+		m_pWindow = NULL;
 		return false;
 	}
 
@@ -75,12 +83,73 @@ bool CSdlRenderer::Create(Rect_t *Dimensions)
 	if (!IMG_Init(IMG_INIT_PNG)) {
 		ERROR("Failed to initialize image-libraries");
 		SDL_DestroyRenderer(m_pRenderer);
-		SDL_DestroyWindow(m_pTarget);
+		SDL_DestroyWindow(m_pWindow);
 		m_pRenderer = NULL;
-		m_pTarget = NULL;
+		m_pWindow = NULL;
+		return false;
+	}
+
+	// Create the texture the backbuffer is presented through
+	m_pTexture = SDL_CreateTexture(m_pRenderer, SDL_PIXELFORMAT_ARGB8888,
+		SDL_TEXTUREACCESS_STREAMING, Dimensions->w, Dimensions->h);
+	if (m_pTexture == NULL) {
+		ERROR("Failed to create SDL texture: %s", SDL_GetError());
+		Destroy();
 		return false;
 	}
 
 	// No errors
 	return true;
 }
+
+// Destructor
+// Cleans up the sdl resources
+CSdlRenderer::~CSdlRenderer()
+{
+	Destroy();
+}
+
+// Destroy
+// Destroys and cleansup the renderer resources
+bool CSdlRenderer::Destroy()
+{
+	if (m_pTexture != NULL) {
+		SDL_DestroyTexture(m_pTexture);
+		m_pTexture = NULL;
+	}
+	if (m_pRenderer != NULL) {
+		SDL_DestroyRenderer(m_pRenderer);
+		m_pRenderer = NULL;
+	}
+	if (m_pWindow != NULL) {
+		SDL_DestroyWindow(m_pWindow);
+		m_pWindow = NULL;
+	}
+	return CSoftRenderer::Destroy();
+}
+
+// Present
+// Uploads the given region of the backbuffer and presents it
+bool CSdlRenderer::Present(const CRegion *Region)
+{
+	SDL_Rect Area;
+
+	// Sanitize
+	if (m_pTexture == NULL || Region == NULL || Region->IsEmpty()) {
+		return false;
+	}
+
+	// Only upload the damaged rectangles
+	for (int i = 0; i < Region->GetCount(); i++) {
+		const Rect_t *Rectangle = Region->GetRectangle(i);
+		Area.x = Rectangle->x;
+		Area.y = Rectangle->y;
+		Area.w = Rectangle->w;
+		Area.h = Rectangle->h;
+		SDL_UpdateTexture(m_pTexture, &Area, (uint8_t*)m_pBuffer 
+			+ (Area.y * m_Pitch) + (Area.x * 4), (int)m_Pitch);
+	}
+	SDL_RenderCopy(m_pRenderer, m_pTexture, NULL, NULL);
+	SDL_RenderPresent(m_pRenderer);
+	return true;
+}
@@ -27,11 +27,12 @@
  * - System */
 #include <SDL/SDL.h>
 #include <SDL/SDL_image.h>
-#include "../irenderer.h"
+#include "../soft/softrenderer.h"
 
 /* CSdlRenderer
- * Implementation of IRenderer with SDL as backend */
-class CSdlRenderer : public IRenderer
+ * Implementation of IRenderer with SDL as display backend, all drawing
+ * is done by the software renderer and presented through a texture */
+class CSdlRenderer : public CSoftRenderer
 {
 public:
 	CSdlRenderer();
@@ -45,9 +46,14 @@ public:
 	// Destroys and cleansup the renderer resources
 	bool Destroy();
 
+	// Present
+	// Uploads the given region of the backbuffer and presents it
+	bool Present(const CRegion *Region);
+
 private:
 	SDL_Renderer*		m_pRenderer;
-	SDL_Window*			m_pTarget;
+	SDL_Window*			m_pWindow;
+	SDL_Texture*		m_pTexture;
 };
 
 #endif //!_SAPPHIRE_RENDERER_SDL_H_
@@ -0,0 +1,290 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS Sapphire - Pixel Operations
+ * - Contains the fill, copy and blend kernels used by the software
+ *   renderer. All pixels are 32 bit premultiplied ARGB8888
+ */
+
+/* Includes
+ * - Library */
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#include "pixelops.h"
+
+/* Definitions CPUID */
+#define CPUID_FEAT_ECX_OSXSAVE      (1 << 27)
+#define CPUID_FEAT_ECX_AVX          (1 << 28)
+#define CPUID_FEAT_EDX_SSE2         (1 << 26)
+#define CPUID_EXTFEAT_EBX_AVX2      (1 << 5)
+#define XCR0_SSE_AVX                0x6
+
+/* Kernel target attributes, the kernels are compiled for their own
+ * instruction set no matter what the rest of the service targets. MSVC
+ * emits any intrinsic without them */
+#if defined(_MSC_VER) && !defined(__clang__)
+#define PIXELOPS_SSE2_TARGET
+#define PIXELOPS_AVX2_TARGET
+#else
+#define PIXELOPS_SSE2_TARGET        __attribute__((target("sse2")))
+#define PIXELOPS_AVX2_TARGET        __attribute__((target("avx2")))
+#endif
+
+/* BlendChannel
+ * Blends a single channel with the inverse source alpha, x / 255 is approximated
+ * by (x + 128 + ((x + 128) >> 8)) >> 8 which is exact for 8 bit inputs. The
+ * sum saturates like the vector kernels do. */
+static inline uint32_t BlendChannel(uint32_t Source, uint32_t Destination, uint32_t InvAlpha)
+{
+	uint32_t Value = Destination * InvAlpha + 128;
+	Value = Source + ((Value + (Value >> 8)) >> 8);
+	return (Value > 255) ? 255 : Value;
+}
+
+/* Scalar Kernels
+ * Always available, also used for the unaligned tails of the vector kernels */
+static void FillScalar(uint32_t *Destination, uint32_t Color, size_t Count)
+{
+	for (size_t i = 0; i < Count; i++) {
+		Destination[i] = Color;
+	}
+}
+
+static void CopyScalar(uint32_t *Destination, const uint32_t *Source, size_t Count)
+{
+	for (size_t i = 0; i < Count; i++) {
+		Destination[i] = Source[i];
+	}
+}
+
+static void BlendScalar(uint32_t *Destination, const uint32_t *Source, size_t Count)
+{
+	for (size_t i = 0; i < Count; i++) {
+		uint32_t Src = Source[i], Dst = Destination[i];
+		uint32_t InvAlpha = 255 - (Src >> 24);
+		if (InvAlpha == 0) {
+			Destination[i] = Src;
+		}
+		else if (Src != 0) {
+			Destination[i] = BlendChannel(Src & 0xFF, Dst & 0xFF, InvAlpha)
+				| (BlendChannel((Src >> 8) & 0xFF, (Dst >> 8) & 0xFF, InvAlpha) << 8)
+				| (BlendChannel((Src >> 16) & 0xFF, (Dst >> 16) & 0xFF, InvAlpha) << 16)
+				| (BlendChannel(Src >> 24, Dst >> 24, InvAlpha) << 24);
+		}
+	}
+}
+
+/* SSE2 Kernels
+ * 4 pixels per iteration */
+PIXELOPS_SSE2_TARGET
+static void FillSse2(uint32_t *Destination, uint32_t Color, size_t Count)
+{
+	__m128i Value = _mm_set1_epi32((int)Color);
+	size_t i = 0;
+	for (; i + 4 <= Count; i += 4) {
+		_mm_storeu_si128((__m128i*)&Destination[i], Value);
+	}
+	FillScalar(&Destination[i], Color, Count - i);
+}
+
+PIXELOPS_SSE2_TARGET
+static void CopySse2(uint32_t *Destination, const uint32_t *Source, size_t Count)
+{
+	size_t i = 0;
+	for (; i + 8 <= Count; i += 8) {
+		__m128i A = _mm_loadu_si128((const __m128i*)&Source[i]);
+		__m128i B = _mm_loadu_si128((const __m128i*)&Source[i + 4]);
+		_mm_storeu_si128((__m128i*)&Destination[i], A);
+		_mm_storeu_si128((__m128i*)&Destination[i + 4], B);
+	}
+	CopyScalar(&Destination[i], &Source[i], Count - i);
+}
+
+PIXELOPS_SSE2_TARGET
+static inline __m128i BlendHalfSse2(__m128i Source, __m128i Destination)
+{
+	__m128i Max = _mm_set1_epi16(255), Round = _mm_set1_epi16(128);
+	__m128i Alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(Source, 0xFF), 0xFF);
+	__m128i Value = _mm_add_epi16(_mm_mullo_epi16(Destination, _mm_sub_epi16(Max, Alpha)), Round);
+	return _mm_srli_epi16(_mm_add_epi16(Value, _mm_srli_epi16(Value, 8)), 8);
+}
+
+PIXELOPS_SSE2_TARGET
+static void BlendSse2(uint32_t *Destination, const uint32_t *Source, size_t Count)
+{
+	__m128i Zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 4 <= Count; i += 4) {
+		__m128i Src = _mm_loadu_si128((const __m128i*)&Source[i]);
+		__m128i Dst = _mm_loadu_si128((const __m128i*)&Destination[i]);
+		__m128i Low = BlendHalfSse2(_mm_unpacklo_epi8(Src, Zero), _mm_unpacklo_epi8(Dst, Zero));
+		__m128i High = BlendHalfSse2(_mm_unpackhi_epi8(Src, Zero), _mm_unpackhi_epi8(Dst, Zero));
+		_mm_storeu_si128((__m128i*)&Destination[i], _mm_adds_epu8(_mm_packus_epi16(Low, High), Src));
+	}
+	BlendScalar(&Destination[i], &Source[i], Count - i);
+}
+
+/* AVX2 Kernels
+ * 8 pixels per iteration */
+PIXELOPS_AVX2_TARGET
+static void FillAvx2(uint32_t *Destination, uint32_t Color, size_t Count)
+{
+	__m256i Value = _mm256_set1_epi32((int)Color);
+	size_t i = 0;
+	for (; i + 8 <= Count; i += 8) {
+		_mm256_storeu_si256((__m256i*)&Destination[i], Value);
+	}
+	FillScalar(&Destination[i], Color, Count - i);
+}
+
+PIXELOPS_AVX2_TARGET
+static void CopyAvx2(uint32_t *Destination, const uint32_t *Source, size_t Count)
+{
+	size_t i = 0;
+	for (; i + 16 <= Count; i += 16) {
+		__m256i A = _mm256_loadu_si256((const __m256i*)&Source[i]);
+		__m256i B = _mm256_loadu_si256((const __m256i*)&Source[i + 8]);
+		_mm256_storeu_si256((__m256i*)&Destination[i], A);
+		_mm256_storeu_si256((__m256i*)&Destination[i + 8], B);
+	}
+	CopyScalar(&Destination[i], &Source[i], Count - i);
+}
+
+PIXELOPS_AVX2_TARGET
+static inline __m256i BlendHalfAvx2(__m256i Source, __m256i Destination)
+{
+	__m256i Max = _mm256_set1_epi16(255), Round = _mm256_set1_epi16(128);
+	__m256i Alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(Source, 0xFF), 0xFF);
+	__m256i Value = _mm256_add_epi16(_mm256_mullo_epi16(Destination, _mm256_sub_epi16(Max, Alpha)), Round);
+	return _mm256_srli_epi16(_mm256_add_epi16(Value, _mm256_srli_epi16(Value, 8)), 8);
+}
+
+PIXELOPS_AVX2_TARGET
+static void BlendAvx2(uint32_t *Destination, const uint32_t *Source, size_t Count)
+{
+	__m256i Zero = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 8 <= Count; i += 8) {
+		__m256i Src = _mm256_loadu_si256((const __m256i*)&Source[i]);
+		__m256i Dst = _mm256_loadu_si256((const __m256i*)&Destination[i]);
+		__m256i Low = BlendHalfAvx2(_mm256_unpacklo_epi8(Src, Zero), _mm256_unpacklo_epi8(Dst, Zero));
+		__m256i High = BlendHalfAvx2(_mm256_unpackhi_epi8(Src, Zero), _mm256_unpackhi_epi8(Dst, Zero));
+		_mm256_storeu_si256((__m256i*)&Destination[i], _mm256_adds_epu8(_mm256_packus_epi16(Low, High), Src));
+	}
+	BlendScalar(&Destination[i], &Source[i], Count - i);
+}
+
+/* Globals
+ * The kernel tables and the current selection */
+static const PixelOperations_t GlbPixelOperations[] = {
+	{ PIXELOPS_SCALAR, "scalar", FillScalar, CopyScalar, BlendScalar },
+	{ PIXELOPS_SSE2, "sse2", FillSse2, CopySse2, BlendSse2 },
+	{ PIXELOPS_AVX2, "avx2", FillAvx2, CopyAvx2, BlendAvx2 }
+};
+static const PixelOperations_t *GlbPixelOperationsCurrent = NULL;
+
+/* PixelOperationsCpuid
+ * Reads subleaf 0 of the given cpuid leaf into Eax, Ebx, Ecx and Edx,
+ * returns 0 if the cpu does not have the leaf */
+static int PixelOperationsCpuid(unsigned int Leaf, unsigned int Registers[4])
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int Info[4];
+	__cpuid(Info, 0);
+	if ((unsigned int)Info[0] < Leaf) {
+		return 0;
+	}
+	__cpuidex(Info, (int)Leaf, 0);
+	for (int i = 0; i < 4; i++) {
+		Registers[i] = (unsigned int)Info[i];
+	}
+#else
+	if (__get_cpuid_max(0, NULL) < Leaf) {
+		return 0;
+	}
+	__cpuid_count(Leaf, 0, Registers[0], Registers[1], Registers[2], Registers[3]);
+#endif
+	return 1;
+}
+
+/* PixelOperationsXcr0
+ * Reads the low half of XCR0, the caller must have checked OSXSAVE */
+static unsigned int PixelOperationsXcr0(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	return (unsigned int)_xgetbv(0);
+#else
+	unsigned int XcrLow = 0, XcrHigh = 0;
+	__asm__ __volatile__("xgetbv" : "=a"(XcrLow), "=d"(XcrHigh) : "c"(0));
+	return XcrLow;
+#endif
+}
+
+/* PixelOperationsQueryLevel
+ * Queries the highest level supported by the cpu, AVX2 also requires the
+ * operating system to have enabled the ymm state in XCR0 */
+static int PixelOperationsQueryLevel(void)
+{
+	unsigned int Features[4] = { 0 }, Extended[4] = { 0 };
+	int Level = PIXELOPS_SCALAR;
+
+	if (!PixelOperationsCpuid(1, Features)) {
+		return Level;
+	}
+	if (Features[3] & CPUID_FEAT_EDX_SSE2) {
+		Level = PIXELOPS_SSE2;
+	}
+	if ((Features[2] & CPUID_FEAT_ECX_OSXSAVE) && (Features[2] & CPUID_FEAT_ECX_AVX)
+		&& PixelOperationsCpuid(7, Extended)) {
+		if ((PixelOperationsXcr0() & XCR0_SSE_AVX) == XCR0_SSE_AVX
+			&& (Extended[1] & CPUID_EXTFEAT_EBX_AVX2)) {
+			Level = PIXELOPS_AVX2;
+		}
+	}
+	return Level;
+}
+
+/* PixelOperationsGet
+ * Retrieves the best kernels for this cpu, the selection is done
+ * on the first call by cpuid. */
+const PixelOperations_t*
+PixelOperationsGet(void)
+{
+	if (GlbPixelOperationsCurrent == NULL) {
+		GlbPixelOperationsCurrent = &GlbPixelOperations[PixelOperationsQueryLevel()];
+	}
+	return GlbPixelOperationsCurrent;
+}
+
+/* PixelOperationsSelect
+ * Overrides the kernels with the given level, used for benchmarking. Returns
+ * NULL if the cpu does not support the level. */
+const PixelOperations_t*
+PixelOperationsSelect(
+	_In_ int Level)
+{
+	if (Level < PIXELOPS_SCALAR || Level > PixelOperationsQueryLevel()) {
+		return NULL;
+	}
+	GlbPixelOperationsCurrent = &GlbPixelOperations[Level];
+	return GlbPixelOperationsCurrent;
+}
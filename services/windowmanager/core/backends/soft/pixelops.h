@@ -0,0 +1,62 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS Sapphire - Pixel Operations
+ * - Contains the fill, copy and blend kernels used by the software
+ *   renderer. All pixels are 32 bit premultiplied ARGB8888
+ */
+
+#ifndef _SAPPHIRE_PIXELOPS_H_
+#define _SAPPHIRE_PIXELOPS_H_
+
+/* Includes
+ * - Library */
+#include <os/osdefs.h>
+
+/* Pixel Operation Levels
+ * The instruction set used by the selected kernels */
+#define PIXELOPS_SCALAR             0
+#define PIXELOPS_SSE2               1
+#define PIXELOPS_AVX2               2
+
+/* PixelOperations
+ * A set of row kernels, Count is always in pixels. */
+typedef struct _PixelOperations {
+	int			Level;
+	const char *Name;
+	void		(*Fill)(uint32_t *Destination, uint32_t Color, size_t Count);
+	void		(*Copy)(uint32_t *Destination, const uint32_t *Source, size_t Count);
+	void		(*Blend)(uint32_t *Destination, const uint32_t *Source, size_t Count);
+} PixelOperations_t;
+
+/* PixelOperationsGet
+ * Retrieves the best kernels for this cpu, the selection is done
+ * on the first call by cpuid. */
+__EXTERN
+const PixelOperations_t*
+PixelOperationsGet(void);
+
+/* PixelOperationsSelect
+ * Overrides the kernels with the given level, used for benchmarking. Returns
+ * NULL if the cpu does not support the level. */
+__EXTERN
+const PixelOperations_t*
+PixelOperationsSelect(
+	_In_ int Level);
+
+#endif //!_SAPPHIRE_PIXELOPS_H_
@@ -0,0 +1,192 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS Sapphire - Software Renderer Backend
+ * - Contains the implementation of the software framebuffer renderer, it
+ *   renders into system memory and can run without any display
+ */
+
+/* Includes
+ * - System */
+#include "softrenderer.h"
+#include "../../region.h"
+
+/* Includes
+ * - Library */
+#include <stdlib.h>
+#include <string.h>
+
+// Constructor
+// Initializes members, the backbuffer is allocated by Create
+CSoftRenderer::CSoftRenderer()
+{
+	memset(&m_Dimensions, 0, sizeof(Rect_t));
+	m_pAllocation = NULL;
+	m_pBuffer = NULL;
+	m_Pitch = 0;
+	m_pTarget = NULL;
+	m_TargetPitch = 0;
+	m_pOperations = NULL;
+}
+
+// Destructor
+// Cleans up the backbuffer
+CSoftRenderer::~CSoftRenderer()
+{
+	Destroy();
+}
+
+// Create
+// Creates and initializes the renderer for usage
+bool CSoftRenderer::Create(Rect_t *Dimensions)
+{
+	// Sanitize
+	if (Dimensions == NULL || Dimensions->w <= 0 || Dimensions->h <= 0) {
+		return false;
+	}
+
+	// Allocate the backbuffer, the buffer is aligned and rows are padded 
+	// to 64 bytes so each row starts on a cache-line
+	memcpy(&m_Dimensions, Dimensions, sizeof(Rect_t));
+	m_pOperations = PixelOperationsGet();
+	m_Pitch = (((size_t)Dimensions->w * 4) + 63) & ~(size_t)63;
+	m_pAllocation = malloc((m_Pitch * Dimensions->h) + 63);
+	if (m_pAllocation == NULL) {
+		return false;
+	}
+	m_pBuffer = (uint32_t*)(((uintptr_t)m_pAllocation + 63) & ~(uintptr_t)63);
+	memset(m_pBuffer, 0, m_Pitch * Dimensions->h);
+	return true;
+}
+
+// Destroy
+// Destroys and cleansup the renderer resources
+bool CSoftRenderer::Destroy()
+{
+	if (m_pAllocation != NULL) {
+		free(m_pAllocation);
+		m_pAllocation = NULL;
+		m_pBuffer = NULL;
+	}
+	return true;
+}
+
+// SetTarget
+// Sets the scanout target that Present copies into, NULL makes it headless
+void CSoftRenderer::SetTarget(void *Target, size_t Pitch)
+{
+	m_pTarget = (uint8_t*)Target;
+	m_TargetPitch = Pitch;
+}
+
+// Clip
+// Clips the area to the backbuffer, returns false if nothing is left.
+// The source is adjusted to match the clipped area
+bool CSoftRenderer::Clip(const Rect_t *Area, Rect_t *Clipped, const uint32_t **Source, size_t Pitch)
+{
+	Rect_t Screen = { 0, 0, m_Dimensions.w, m_Dimensions.h };
+	if (m_pBuffer == NULL) {
+		return false;
+	}
+
+	CRegion::Intersection(Area, &Screen, Clipped);
+	if (CRegion::IsEmpty(Clipped)) {
+		return false;
+	}
+	if (Source != NULL) {
+		*Source = (const uint32_t*)((const uint8_t*)*Source 
+			+ ((Clipped->y - Area->y) * Pitch)) + (Clipped->x - Area->x);
+	}
+	return true;
+}
+
+// Fill
+// Fills the area of the backbuffer with the given color
+bool CSoftRenderer::Fill(const Rect_t *Area, uint32_t Color)
+{
+	Rect_t Clipped;
+	if (!Clip(Area, &Clipped, NULL, 0)) {
+		return false;
+	}
+
+	uint8_t *Row = (uint8_t*)m_pBuffer + (Clipped.y * m_Pitch) + (Clipped.x * 4);
+	for (int y = 0; y < Clipped.h; y++, Row += m_Pitch) {
+		m_pOperations->Fill((uint32_t*)Row, Color, Clipped.w);
+	}
+	return true;
+}
+
+// Blit
+// Copies pixels into the area of the backbuffer, the source
+// points to the pixel that maps to the top-left of the area
+bool CSoftRenderer::Blit(const Rect_t *Area, const uint32_t *Source, size_t Pitch)
+{
+	Rect_t Clipped;
+	if (!Clip(Area, &Clipped, &Source, Pitch)) {
+		return false;
+	}
+
+	uint8_t *Row = (uint8_t*)m_pBuffer + (Clipped.y * m_Pitch) + (Clipped.x * 4);
+	const uint8_t *SourceRow = (const uint8_t*)Source;
+	for (int y = 0; y < Clipped.h; y++, Row += m_Pitch, SourceRow += Pitch) {
+		m_pOperations->Copy((uint32_t*)Row, (const uint32_t*)SourceRow, Clipped.w);
+	}
+	return true;
+}
+
+// Blend
+// Blends pixels into the area of the backbuffer (source over destination),
+// the source points to the pixel that maps to the top-left of the area
+bool CSoftRenderer::Blend(const Rect_t *Area, const uint32_t *Source, size_t Pitch)
+{
+	Rect_t Clipped;
+	if (!Clip(Area, &Clipped, &Source, Pitch)) {
+		return false;
+	}
+
+	uint8_t *Row = (uint8_t*)m_pBuffer + (Clipped.y * m_Pitch) + (Clipped.x * 4);
+	const uint8_t *SourceRow = (const uint8_t*)Source;
+	for (int y = 0; y < Clipped.h; y++, Row += m_Pitch, SourceRow += Pitch) {
+		m_pOperations->Blend((uint32_t*)Row, (const uint32_t*)SourceRow, Clipped.w);
+	}
+	return true;
+}
+
+// Present
+// Flushes the given region of the backbuffer to the scanout target
+bool CSoftRenderer::Present(const CRegion *Region)
+{
+	if (m_pTarget == NULL || Region == NULL) {
+		return true;
+	}
+
+	for (int i = 0; i < Region->GetCount(); i++) {
+		const Rect_t *Area = Region->GetRectangle(i);
+		Rect_t Clipped;
+		if (!Clip(Area, &Clipped, NULL, 0)) {
+			continue;
+		}
+
+		uint8_t *Row = (uint8_t*)m_pBuffer + (Clipped.y * m_Pitch) + (Clipped.x * 4);
+		uint8_t *TargetRow = m_pTarget + (Clipped.y * m_TargetPitch) + (Clipped.x * 4);
+		for (int y = 0; y < Clipped.h; y++, Row += m_Pitch, TargetRow += m_TargetPitch) {
+			m_pOperations->Copy((uint32_t*)TargetRow, (const uint32_t*)Row, Clipped.w);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,80 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS Sapphire - Software Renderer Backend
+ * - Contains the implementation of the software framebuffer renderer, it
+ *   renders into system memory and can run without any display
+ */
+
+#ifndef _SAPPHIRE_RENDERER_SOFT_H_
+#define _SAPPHIRE_RENDERER_SOFT_H_
+
+/* Includes
+ * - System */
+#include "../irenderer.h"
+#include "pixelops.h"
+
+/* CSoftRenderer
+ * Implementation of IRenderer that renders into a framebuffer in system
+ * memory. Present copies the region to the scanout target if one is set,
+ * otherwise the renderer is headless. */
+class CSoftRenderer : public IRenderer
+{
+public:
+	CSoftRenderer();
+	virtual ~CSoftRenderer();
+
+	// Create
+	// Creates and initializes the renderer for usage
+	virtual bool Create(Rect_t *Dimensions);
+
+	// Destroy
+	// Destroys and cleansup the renderer resources
+	virtual bool Destroy();
+
+	// IRenderer drawing implementation
+	bool Fill(const Rect_t *Area, uint32_t Color);
+	bool Blit(const Rect_t *Area, const uint32_t *Source, size_t Pitch);
+	bool Blend(const Rect_t *Area, const uint32_t *Source, size_t Pitch);
+	virtual bool Present(const CRegion *Region);
+
+	// SetTarget
+	// Sets the scanout target that Present copies into, NULL makes it headless
+	void SetTarget(void *Target, size_t Pitch);
+
+	// Accessors for the backbuffer
+	uint32_t *GetBuffer() const { return m_pBuffer; }
+	size_t GetPitch() const { return m_Pitch; }
+	const PixelOperations_t *GetOperations() const { return m_pOperations; }
+
+protected:
+	// Clip
+	// Clips the area to the backbuffer, returns false if nothing is left.
+	// The source is adjusted to match the clipped area
+	bool Clip(const Rect_t *Area, Rect_t *Clipped, const uint32_t **Source, size_t Pitch);
+
+	Rect_t						m_Dimensions;
+	void*						m_pAllocation;
+	uint32_t*					m_pBuffer;
+	size_t						m_Pitch;
+	uint8_t*					m_pTarget;
+	size_t						m_TargetPitch;
+	const PixelOperations_t*	m_pOperations;
+};
+
+#endif //!_SAPPHIRE_RENDERER_SOFT_H_
@@ -0,0 +1,142 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS Sapphire - Compositor
+ * - Contains the damage-tracked compositor that renders layers through
+ *   an IRenderer, fully covered layers are culled
+ */
+
+/* Includes
+ * - Ui */
+#include "compositor.h"
+
+/* Includes
+ * - Library */
+#include <string.h>
+
+// Constructor
+// Initializes the compositor, the entire screen starts out damaged
+CCompositor::CCompositor(IRenderer *Renderer, Rect_t *Dimensions)
+{
+	m_pRenderer = Renderer;
+	memcpy(&m_Dimensions, Dimensions, sizeof(Rect_t));
+	m_Background = 0xFF000000;
+	m_pVisible = NULL;
+	m_iVisibleCapacity = 0;
+	m_iCulled = 0;
+	m_PixelCount = 0;
+	Damage(NULL);
+}
+
+// Destructor
+// Cleans up the visibility regions
+CCompositor::~CCompositor()
+{
+	delete[] m_pVisible;
+}
+
+// Damage
+// Marks the area as changed, NULL damages the entire screen
+void CCompositor::Damage(const Rect_t *Area)
+{
+	Rect_t Screen = { 0, 0, m_Dimensions.w, m_Dimensions.h };
+	Rect_t Clipped;
+
+	if (Area == NULL) {
+		m_Damage.Clear();
+		m_Damage.Add(&Screen);
+		return;
+	}
+	CRegion::Intersection(Area, &Screen, &Clipped);
+	m_Damage.Add(&Clipped);
+}
+
+// Compose
+// Renders and presents the damaged region, returns the number of
+// layers drawn. The damage is reset afterwards
+int CCompositor::Compose(CompositorLayer_t **Layers, int LayerCount)
+{
+	CRegion Remaining;
+	int Drawn = 0;
+
+	m_iCulled = 0;
+	m_PixelCount = 0;
+	if (m_Damage.IsEmpty()) {
+		return 0;
+	}
+
+	// Make sure we have a visibility region for each layer
+	if (LayerCount > m_iVisibleCapacity) {
+		delete[] m_pVisible;
+		m_pVisible = new CRegion[LayerCount];
+		m_iVisibleCapacity = LayerCount;
+	}
+
+	// Calculate the visible part of each layer top-down, opaque
+	// layers hide everything below them
+	Remaining.Add(&m_Damage);
+	for (int i = LayerCount - 1; i >= 0; i--) {
+		CompositorLayer_t *Layer = Layers[i];
+		m_pVisible[i].Clear();
+		if (Layer->Flags & LAYER_HIDDEN) {
+			continue;
+		}
+
+		m_pVisible[i].Add(&Remaining);
+		m_pVisible[i].Intersect(&Layer->Dimensions);
+		if (m_pVisible[i].IsEmpty()) {
+			m_iCulled++;
+			continue;
+		}
+		if (Layer->Flags & LAYER_OPAQUE) {
+			Remaining.Subtract(&Layer->Dimensions);
+		}
+	}
+
+	// Render bottom-up, starting with whatever no opaque layer covers
+	for (int i = 0; i < Remaining.GetCount(); i++) {
+		m_pRenderer->Fill(Remaining.GetRectangle(i), m_Background);
+	}
+	m_PixelCount += Remaining.GetArea();
+
+	for (int i = 0; i < LayerCount; i++) {
+		CompositorLayer_t *Layer = Layers[i];
+		if (m_pVisible[i].IsEmpty()) {
+			continue;
+		}
+
+		for (int j = 0; j < m_pVisible[i].GetCount(); j++) {
+			const Rect_t *Area = m_pVisible[i].GetRectangle(j);
+			const uint32_t *Source = (const uint32_t*)((const uint8_t*)Layer->Pixels
+				+ ((Area->y - Layer->Dimensions.y) * Layer->Pitch)) + (Area->x - Layer->Dimensions.x);
+			if (Layer->Flags & LAYER_OPAQUE) {
+				m_pRenderer->Blit(Area, Source, Layer->Pitch);
+			}
+			else {
+				m_pRenderer->Blend(Area, Source, Layer->Pitch);
+			}
+		}
+		m_PixelCount += m_pVisible[i].GetArea();
+		Drawn++;
+	}
+
+	// Flush the damage to the display
+	m_pRenderer->Present(&m_Damage);
+	m_Damage.Clear();
+	return Drawn;
+}
@@ -0,0 +1,89 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS Sapphire - Compositor
+ * - Contains the damage-tracked compositor that renders layers through
+ *   an IRenderer, fully covered layers are culled
+ */
+
+#ifndef _SAPPHIRE_COMPOSITOR_H_
+#define _SAPPHIRE_COMPOSITOR_H_
+
+/* Includes
+ * - Library */
+#include <os/osdefs.h>
+
+/* Includes
+ * - Ui */
+#include "backends/irenderer.h"
+#include "region.h"
+
+/* CompositorLayer
+ * A surface that is composited, pixels are premultiplied ARGB8888 and the
+ * pitch is in bytes. Layers are passed ordered from bottom to top. */
+typedef struct _CompositorLayer {
+	Rect_t			Dimensions;
+	uint32_t*		Pixels;
+	size_t			Pitch;
+	int				Flags;
+} CompositorLayer_t;
+
+/* CompositorLayer::Flags
+ * Contains definitions and bitfield definitions for CompositorLayer::Flags */
+#define LAYER_OPAQUE			0x1
+#define LAYER_HIDDEN			0x2
+
+/* CCompositor
+ * Keeps the damaged region of the screen, and renders only that region. The
+ * visible part of each layer is calculated top-down so layers covered by
+ * opaque layers are never drawn. */
+class CCompositor
+{
+public:
+	CCompositor(IRenderer *Renderer, Rect_t *Dimensions);
+	~CCompositor();
+
+	// SetBackground
+	// Sets the color used for areas not covered by any layer
+	void SetBackground(uint32_t Color) { m_Background = Color; }
+
+	// Damage
+	// Marks the area as changed, NULL damages the entire screen
+	void Damage(const Rect_t *Area);
+
+	// Compose
+	// Renders and presents the damaged region, returns the number of
+	// layers drawn. The damage is reset afterwards
+	int Compose(CompositorLayer_t **Layers, int LayerCount);
+
+	// Statistics for the last compose
+	int GetCulledCount() const { return m_iCulled; }
+	size_t GetPixelCount() const { return m_PixelCount; }
+
+private:
+	IRenderer*		m_pRenderer;
+	Rect_t			m_Dimensions;
+	uint32_t		m_Background;
+	CRegion			m_Damage;
+	CRegion*		m_pVisible;
+	int				m_iVisibleCapacity;
+	int				m_iCulled;
+	size_t			m_PixelCount;
+};
+
+#endif //!_SAPPHIRE_COMPOSITOR_H_
@@ -0,0 +1,316 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS Sapphire - Region
+ * - Contains the rectangle-list region used for damage tracking and
+ *   occlusion culling
+ */
+
+/* Includes
+ * - Ui */
+#include "region.h"
+
+// Intersects
+// Returns true if the two rectangles share any pixels
+bool CRegion::Intersects(const Rect_t *A, const Rect_t *B)
+{
+	return A->x < (B->x + B->w) && B->x < (A->x + A->w)
+		&& A->y < (B->y + B->h) && B->y < (A->y + A->h);
+}
+
+// Contains
+// Returns true if the inner rectangle is fully inside the outer
+bool CRegion::Contains(const Rect_t *Outer, const Rect_t *Inner)
+{
+	return Inner->x >= Outer->x && Inner->y >= Outer->y
+		&& (Inner->x + Inner->w) <= (Outer->x + Outer->w)
+		&& (Inner->y + Inner->h) <= (Outer->y + Outer->h);
+}
+
+// Intersection
+// Calculates the shared area of two rectangles, w/h is 0 if none
+void CRegion::Intersection(const Rect_t *A, const Rect_t *B, Rect_t *Result)
+{
+	int Left = (A->x > B->x) ? A->x : B->x;
+	int Top = (A->y > B->y) ? A->y : B->y;
+	int Right = ((A->x + A->w) < (B->x + B->w)) ? (A->x + A->w) : (B->x + B->w);
+	int Bottom = ((A->y + A->h) < (B->y + B->h)) ? (A->y + A->h) : (B->y + B->h);
+
+	Result->x = Left;
+	Result->y = Top;
+	Result->w = (Right > Left) ? (Right - Left) : 0;
+	Result->h = (Bottom > Top) ? (Bottom - Top) : 0;
+}
+
+// Union
+// Calculates the bounding box of two rectangles
+void CRegion::Union(const Rect_t *A, const Rect_t *B, Rect_t *Result)
+{
+	int Left = (A->x < B->x) ? A->x : B->x;
+	int Top = (A->y < B->y) ? A->y : B->y;
+	int Right = ((A->x + A->w) > (B->x + B->w)) ? (A->x + A->w) : (B->x + B->w);
+	int Bottom = ((A->y + A->h) > (B->y + B->h)) ? (A->y + A->h) : (B->y + B->h);
+
+	Result->x = Left;
+	Result->y = Top;
+	Result->w = Right - Left;
+	Result->h = Bottom - Top;
+}
+
+// Append
+// Stores a rectangle without any merging
+void CRegion::Append(const Rect_t *Area)
+{
+	m_Rectangles[m_iCount++] = *Area;
+}
+
+// Remove
+// Removes the rectangle at the given index, order is not kept
+void CRegion::Remove(int Index)
+{
+	m_Rectangles[Index] = m_Rectangles[--m_iCount];
+}
+
+// Coalesce
+// Collapses the region and the area into their bounding box, used when
+// the region runs full
+void CRegion::Coalesce(const Rect_t *Area)
+{
+	Rect_t Bounds;
+	GetBounds(&Bounds);
+	if (m_iCount != 0) {
+		Union(&Bounds, Area, &Bounds);
+	}
+	else {
+		Bounds = *Area;
+	}
+	m_Rectangles[0] = Bounds;
+	m_iCount = 1;
+}
+
+// Add
+// Adds the area to the region, overlapping parts are only stored once
+void CRegion::Add(const Rect_t *Area)
+{
+	Rect_t Pieces[REGION_MAX_RECTANGLES];
+	Rect_t Current = *Area, Merged;
+	int PieceCount, i, j;
+
+	if (IsEmpty(Area)) {
+		return;
+	}
+
+	// Merge with rectangles that share a full edge, or that are contained,
+	// and restart as the merged rectangle might merge with others
+	for (i = 0; i < m_iCount; i++) {
+		const Rect_t *Existing = &m_Rectangles[i];
+		if (Contains(Existing, &Current)) {
+			return;
+		}
+
+		Union(Existing, &Current, &Merged);
+		if (Contains(&Current, Existing)
+			|| (Existing->x == Current.x && Existing->w == Current.w
+				&& Existing->y <= (Current.y + Current.h) && Current.y <= (Existing->y + Existing->h))
+			|| (Existing->y == Current.y && Existing->h == Current.h
+				&& Existing->x <= (Current.x + Current.w) && Current.x <= (Existing->x + Existing->w))) {
+			Current = Merged;
+			Remove(i);
+			i = -1;
+		}
+	}
+
+	// Split the rectangle by the ones that overlap it, so the region
+	// never contains overlapping rectangles
+	Pieces[0] = Current;
+	PieceCount = 1;
+	for (i = 0; i < m_iCount && PieceCount > 0; i++) {
+		for (j = 0; j < PieceCount; j++) {
+			const Rect_t *Existing = &m_Rectangles[i];
+			Rect_t Piece = Pieces[j];
+			Rect_t Split[4];
+			int SplitCount = 0, k;
+
+			if (!Intersects(Existing, &Piece)) {
+				continue;
+			}
+
+			// Top and bottom bands span the full width, left and right
+			// bands span the height of the overlap
+			if (Piece.y < Existing->y) {
+				Split[SplitCount].x = Piece.x; Split[SplitCount].y = Piece.y;
+				Split[SplitCount].w = Piece.w; Split[SplitCount].h = Existing->y - Piece.y;
+				SplitCount++;
+			}
+			if ((Piece.y + Piece.h) > (Existing->y + Existing->h)) {
+				Split[SplitCount].x = Piece.x; Split[SplitCount].y = Existing->y + Existing->h;
+				Split[SplitCount].w = Piece.w; Split[SplitCount].h = (Piece.y + Piece.h) - (Existing->y + Existing->h);
+				SplitCount++;
+			}
+			Intersection(Existing, &Piece, &Merged);
+			if (Piece.x < Existing->x) {
+				Split[SplitCount].x = Piece.x; Split[SplitCount].y = Merged.y;
+				Split[SplitCount].w = Existing->x - Piece.x; Split[SplitCount].h = Merged.h;
+				SplitCount++;
+			}
+			if ((Piece.x + Piece.w) > (Existing->x + Existing->w)) {
+				Split[SplitCount].x = Existing->x + Existing->w; Split[SplitCount].y = Merged.y;
+				Split[SplitCount].w = (Piece.x + Piece.w) - (Existing->x + Existing->w); Split[SplitCount].h = Merged.h;
+				SplitCount++;
+			}
+
+			// Running out of room means we stop being exact
+			if ((PieceCount - 1 + SplitCount) > REGION_MAX_RECTANGLES) {
+				Coalesce(&Current);
+				return;
+			}
+
+			// Replace the piece with its remains
+			Pieces[j] = Pieces[--PieceCount];
+			for (k = 0; k < SplitCount; k++) {
+				Pieces[PieceCount++] = Split[k];
+			}
+			j--;
+		}
+	}
+
+	// Store the remaining pieces
+	if ((m_iCount + PieceCount) > REGION_MAX_RECTANGLES) {
+		Coalesce(&Current);
+		return;
+	}
+	for (i = 0; i < PieceCount; i++) {
+		Append(&Pieces[i]);
+	}
+}
+
+// Add
+// Adds all rectangles of the given region to this region
+void CRegion::Add(const CRegion *Region)
+{
+	for (int i = 0; i < Region->m_iCount; i++) {
+		Add(&Region->m_Rectangles[i]);
+	}
+}
+
+// Subtract
+// Removes the area from the region, rectangles are split as needed. If the
+// region is full the rectangle is kept whole, so the result may be larger
+void CRegion::Subtract(const Rect_t *Area)
+{
+	int Count = m_iCount;
+	Rect_t Overlap;
+
+	if (IsEmpty(Area)) {
+		return;
+	}
+
+	// Only iterate the rectangles present before we started, the
+	// pieces appended at the end never intersect the area
+	for (int i = 0; i < Count; ) {
+		Rect_t Existing = m_Rectangles[i];
+		Rect_t Split[4];
+		int SplitCount = 0;
+
+		if (!Intersects(&Existing, Area)) {
+			i++;
+			continue;
+		}
+
+		Intersection(&Existing, Area, &Overlap);
+		if (Existing.y < Overlap.y) {
+			Split[SplitCount].x = Existing.x; Split[SplitCount].y = Existing.y;
+			Split[SplitCount].w = Existing.w; Split[SplitCount].h = Overlap.y - Existing.y;
+			SplitCount++;
+		}
+		if ((Existing.y + Existing.h) > (Overlap.y + Overlap.h)) {
+			Split[SplitCount].x = Existing.x; Split[SplitCount].y = Overlap.y + Overlap.h;
+			Split[SplitCount].w = Existing.w; Split[SplitCount].h = (Existing.y + Existing.h) - (Overlap.y + Overlap.h);
+			SplitCount++;
+		}
+		if (Existing.x < Overlap.x) {
+			Split[SplitCount].x = Existing.x; Split[SplitCount].y = Overlap.y;
+			Split[SplitCount].w = Overlap.x - Existing.x; Split[SplitCount].h = Overlap.h;
+			SplitCount++;
+		}
+		if ((Existing.x + Existing.w) > (Overlap.x + Overlap.w)) {
+			Split[SplitCount].x = Overlap.x + Overlap.w; Split[SplitCount].y = Overlap.y;
+			Split[SplitCount].w = (Existing.x + Existing.w) - (Overlap.x + Overlap.w); Split[SplitCount].h = Overlap.h;
+			SplitCount++;
+		}
+
+		// Keep the rectangle whole if the pieces do not fit
+		if ((m_iCount - 1 + SplitCount) > REGION_MAX_RECTANGLES) {
+			i++;
+			continue;
+		}
+
+		// Move the last rectangle in place, and if it was one of the
+		// original rectangles it must be visited at this index
+		m_Rectangles[i] = m_Rectangles[--m_iCount];
+		if (m_iCount < Count) {
+			Count--;
+		}
+		else {
+			i++;
+		}
+		for (int k = 0; k < SplitCount; k++) {
+			Append(&Split[k]);
+		}
+	}
+}
+
+// Intersect
+// Clips the region to the given area
+void CRegion::Intersect(const Rect_t *Area)
+{
+	for (int i = 0; i < m_iCount; ) {
+		Intersection(&m_Rectangles[i], Area, &m_Rectangles[i]);
+		if (IsEmpty(&m_Rectangles[i])) {
+			Remove(i);
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+// GetBounds
+// Retrieves the bounding box of the region
+void CRegion::GetBounds(Rect_t *Bounds) const
+{
+	Bounds->x = Bounds->y = Bounds->w = Bounds->h = 0;
+	if (m_iCount == 0) {
+		return;
+	}
+	*Bounds = m_Rectangles[0];
+	for (int i = 1; i < m_iCount; i++) {
+		Union(Bounds, &m_Rectangles[i], Bounds);
+	}
+}
+
+// GetArea
+// Returns the number of pixels covered by the region
+size_t CRegion::GetArea() const
+{
+	size_t Area = 0;
+	for (int i = 0; i < m_iCount; i++) {
+		Area += (size_t)m_Rectangles[i].w * (size_t)m_Rectangles[i].h;
+	}
+	return Area;
+}
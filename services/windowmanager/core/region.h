@@ -0,0 +1,100 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS Sapphire - Region
+ * - Contains the rectangle-list region used for damage tracking and
+ *   occlusion culling
+ */
+
+#ifndef _SAPPHIRE_REGION_H_
+#define _SAPPHIRE_REGION_H_
+
+/* Includes
+ * - Library */
+#include <os/osdefs.h>
+
+/* Region Definitions
+ * The maximum number of rectangles a region can hold before
+ * rectangles are coalesced into their bounding boxes */
+#define REGION_MAX_RECTANGLES       64
+
+/* CRegion
+ * A set of non-overlapping rectangles. Rectangles that are added are merged
+ * with existing ones when that does not waste much area, and the region never
+ * grows beyond REGION_MAX_RECTANGLES. The class holds no heap memory, so it can
+ * live inside zeroed C structures. */
+class CRegion
+{
+public:
+	CRegion() { Clear(); }
+
+	// Clear
+	// Removes all rectangles from the region
+	void Clear() { m_iCount = 0; }
+
+	// IsEmpty
+	// Returns true if the region contains no rectangles
+	bool IsEmpty() const { return m_iCount == 0; }
+
+	// GetCount / GetRectangle
+	// Accessors for iterating the rectangles in the region
+	int GetCount() const { return m_iCount; }
+	const Rect_t *GetRectangle(int Index) const { return &m_Rectangles[Index]; }
+
+	// Add
+	// Adds the area to the region, overlapping parts are only stored once
+	void Add(const Rect_t *Area);
+
+	// Add
+	// Adds all rectangles of the given region to this region
+	void Add(const CRegion *Region);
+
+	// Subtract
+	// Removes the area from the region, rectangles are split as needed. If the
+	// region is full the rectangle is kept whole, so the result may be larger
+	void Subtract(const Rect_t *Area);
+
+	// Intersect
+	// Clips the region to the given area
+	void Intersect(const Rect_t *Area);
+
+	// GetBounds
+	// Retrieves the bounding box of the region
+	void GetBounds(Rect_t *Bounds) const;
+
+	// GetArea
+	// Returns the number of pixels covered by the region
+	size_t GetArea() const;
+
+	// Rectangle helpers, shared with the compositor
+	static bool IsEmpty(const Rect_t *Area) { return Area->w <= 0 || Area->h <= 0; }
+	static bool Intersects(const Rect_t *A, const Rect_t *B);
+	static bool Contains(const Rect_t *Outer, const Rect_t *Inner);
+	static void Intersection(const Rect_t *A, const Rect_t *B, Rect_t *Result);
+	static void Union(const Rect_t *A, const Rect_t *B, Rect_t *Result);
+
+private:
+	void Append(const Rect_t *Area);
+	void Remove(int Index);
+	void Coalesce(const Rect_t *Area);
+
+	Rect_t	m_Rectangles[REGION_MAX_RECTANGLES];
+	int		m_iCount;
+};
+
+#endif //!_SAPPHIRE_REGION_H_
@@ -29,12 +29,15 @@
 #include <string.h>
 #include <stdlib.h>
 
+/* Scene definitions */
+#define SCENE_BACKGROUND_COLOR	0xFF2D2D30
+
 /* Initializor
  * Creates a new scene */
-Scene_t *SceneCreate(int Id, Rect_t *Dimensions, SDL_Renderer *Renderer)
+Scene_t *SceneCreate(int Id, Rect_t *Dimensions, IRenderer *Renderer)
 {
 	/* Variables */
-	SDL_Texture *Background = NULL;
+	SDL_Surface *Background = NULL;
 	Scene_t *Scene = NULL;
 
 	/* Allocate a scene instance and reset it */
@@ -45,33 +48,27 @@ Scene_t *SceneCreate(int Id, Rect_t *Dimensions, SDL_Renderer *Renderer)
 	Scene->Id = Id;
 	Scene->Windows = ListCreate(KeyInteger);
 	memcpy(&Scene->Dimensions, Dimensions, sizeof(Rect_t));
+	Scene->Compositor = new CCompositor(Renderer, Dimensions);
+	Scene->Compositor->SetBackground(SCENE_BACKGROUND_COLOR);
 
-	/* Load default background for this scene */
-	Background = IMG_LoadTexture(Renderer, "Themes/Default/GfxBg.png");
+	/* Load default background for this scene, we fall
+	 * back to the background color if it's not there */
+	Background = IMG_Load("Themes/Default/GfxBg.png");
 	if (Background == NULL) {
 		MollenOSSystemLog("BACKGROUND::SDL Error: (%s)", SDL_GetError());
-		for (;;);
+		return Scene;
 	}
 
-	/* Allocate two textures, one as a backbuffer
-	 * and the second one for a scaled background image */
-	Scene->Background = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_ARGB8888,
-		SDL_TEXTUREACCESS_TARGET, Dimensions->w, Dimensions->h);
-	Scene->Texture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_ARGB8888,
-		SDL_TEXTUREACCESS_TARGET, Dimensions->w, Dimensions->h);
-
-	/* Scale background image to our 
-	 * newly allocated background texture */
-	SDL_SetRenderTarget(Renderer, Scene->Background);
-	SDL_RenderCopy(Renderer, Background, NULL, NULL);
-	SDL_SetRenderTarget(Renderer, NULL);
-
-	/* Set blend mode for the backbuffer 
-	 * texture, we only do this for it */
-	SDL_SetTextureBlendMode(Scene->Texture, SDL_BLENDMODE_BLEND);
+	/* Scale background image to our own surface
+	 * in the format the compositor uses */
+	Scene->Background = SDL_CreateRGBSurfaceWithFormat(0, Dimensions->w, 
+		Dimensions->h, 32, SDL_PIXELFORMAT_ARGB8888);
+	if (Scene->Background != NULL) {
+		SDL_BlitScaled(Background, NULL, Scene->Background, NULL);
+	}
 
-	/* Cleanup the allocated image */
-	SDL_DestroyTexture(Background);
+	/* Cleanup the loaded image */
+	SDL_FreeSurface(Background);
 
 	/* Done! */
 	return Scene;
@@ -98,10 +95,14 @@ void SceneDestroy(Scene_t *Scene)
 	}
 
 	/* Cleanup SDL */
-	SDL_DestroyTexture(Scene->Background);
-	SDL_DestroyTexture(Scene->Texture);
+	if (Scene->Background != NULL) {
+		SDL_FreeSurface(Scene->Background);
+	}
 
 	/* Cleanup */
+	delete Scene->Compositor;
+	free(Scene->Layers);
+	free(Scene->LayerOrder);
 	ListDestroy(Scene->Windows);
 	free(Scene);
 }
@@ -167,101 +168,90 @@ void SceneUpdate(Scene_t *Scene, Rect_t *DirtyArea)
 	if (Scene == NULL)
 		return;
 
-	/* Append dirty rectangles */
-	if (DirtyArea == NULL || Scene->ValidRectangles == -1) {
-		Scene->ValidRectangles = -1;
+	/* Damage the area, or the entire scene */
+	if (DirtyArea == NULL) {
+		Scene->Damage.Clear();
+		Scene->Damage.Add(&Scene->Dimensions);
 	}
 	else {
-		memcpy(&Scene->Dirty[Scene->ValidRectangles], DirtyArea, sizeof(Rect_t));
-		Scene->ValidRectangles++;
+		Scene->Damage.Add(DirtyArea);
 	}
 }
 
+/* Present Window
+ * Shows a new frame of the window, only the damaged
+ * rectangles of the window are redrawn */
+OsStatus_t ScenePresentWindow(Scene_t *Scene, Window_t *Window, 
+	int Frame, Rect_t *Damage, int DamageCount)
+{
+	/* Sanity */
+	if (Scene == NULL)
+		return OsError;
+
+	/* Let the window switch frames and damage us */
+	return WindowPresent(Window, Frame, Damage, DamageCount, &Scene->Damage);
+}
+
 /* Render
- * This renders all windows for this scene */
-void SceneRender(Scene_t *Scene, SDL_Renderer *Renderer)
+ * This renders all windows for this scene, the content of the windows
+ * is read directly from their presented frames */
+void SceneRender(Scene_t *Scene)
 {
 	/* Variables */
-	SDL_Rect InvalidationRect;
+	int LayerCount = 0, MaxLayers = 1;
 
 	/* Sanity */
 	if (Scene == NULL
-		|| Renderer == NULL)
+		|| Scene->Damage.IsEmpty())
 		return;
 
-	/* Change render target to backbuffer */
-	SDL_SetRenderTarget(Renderer, Scene->Texture);
-
-	/* Are we rerendering entire scene? */
-	if (Scene->ValidRectangles == -1) {
-
-		/* Start by rendering background */
-		SDL_RenderCopy(Renderer, Scene->Background, NULL, NULL);
-
-		/* Render windows */
-		foreach(wNode, Scene->Windows)
-		{
-			/* Cast */
-			Window_t *Window = (Window_t*)wNode->Data;
-
-			/* Update window */
-			WindowUpdate(Window, NULL);
-
-			/* Render window */
-			WindowRender(Window, Renderer, NULL);
-		}
+	/* Make sure there is room for the background and two layers per window */
+	foreach(wNode, Scene->Windows) {
+		MaxLayers += 2;
+	}
+	if (Scene->LayerCapacity < MaxLayers) {
+		CompositorLayer_t *Layers = NULL;
+		CompositorLayer_t **LayerOrder = NULL;
+
+		/* On failure the old buffers are kept and the damage is left
+		 * for the next render, the capacity only grows once both fit */
+		Layers = (CompositorLayer_t*)realloc(Scene->Layers,
+			MaxLayers * sizeof(CompositorLayer_t));
+		if (Layers == NULL)
+			return;
+		Scene->Layers = Layers;
+		LayerOrder = (CompositorLayer_t**)realloc(Scene->LayerOrder,
+			MaxLayers * sizeof(CompositorLayer_t*));
+		if (LayerOrder == NULL)
+			return;
+		Scene->LayerOrder = LayerOrder;
+		Scene->LayerCapacity = MaxLayers;
+	}
 
-		/* Change target back to screen */
-		SDL_SetRenderTarget(Renderer, NULL);
+	/* Start with the background */
+	if (Scene->Background != NULL) {
+		Scene->Layers[0].Dimensions = Scene->Dimensions;
+		Scene->Layers[0].Pixels = (uint32_t*)Scene->Background->pixels;
+		Scene->Layers[0].Pitch = Scene->Background->pitch;
+		Scene->Layers[0].Flags = LAYER_OPAQUE;
+		LayerCount++;
+	}
 
-		/* Render */
-		SDL_RenderCopy(Renderer, Scene->Texture, NULL, NULL);
+	/* Windows are ordered bottom to top */
+	foreach(wNode, Scene->Windows) {
+		LayerCount += WindowGetLayers((Window_t*)wNode->Data, &Scene->Layers[LayerCount]);
 	}
-	else if (Scene->ValidRectangles > 0)
-	{
-		/* Go through dirty rectangles and update/render */
-		for (int i = 0; i < Scene->ValidRectangles; i++) 
-		{
-			/* Copy data over */
-			InvalidationRect.x = Scene->Dirty[i].x;
-			InvalidationRect.y = Scene->Dirty[i].y;
-			InvalidationRect.w = Scene->Dirty[i].w;
-			InvalidationRect.h = Scene->Dirty[i].h;
-
-			/* Start by rendering background */
-			SDL_RenderCopy(Renderer, Scene->Background, &InvalidationRect, &InvalidationRect);
-
-			/* Render windows */
-			foreach(wNode, Scene->Windows)
-			{
-				/* Cast */
-				Window_t *Window = (Window_t*)wNode->Data;
-
-				/* Update window */
-				WindowUpdate(Window, &Scene->Dirty[i]);
-
-				/* Render window */
-				WindowRender(Window, Renderer, &Scene->Dirty[i]);
-			}
-		}
-
-		/* Change target back to screen */
-		SDL_SetRenderTarget(Renderer, NULL);
-
-		/* Render */
-		for (int i = 0; i < Scene->ValidRectangles; i++) 
-		{
-			/* Copy data over */
-			InvalidationRect.x = Scene->Dirty[i].x;
-			InvalidationRect.y = Scene->Dirty[i].y;
-			InvalidationRect.w = Scene->Dirty[i].w;
-			InvalidationRect.h = Scene->Dirty[i].h;
-
-			/* Write to screen */
-			SDL_RenderCopy(Renderer, Scene->Texture, &InvalidationRect, &InvalidationRect);
-		}
+	for (int i = 0; i < LayerCount; i++) {
+		Scene->LayerOrder[i] = &Scene->Layers[i];
+	}
+
+	/* Render the damaged rectangles, the compositor 
+	 * skips everything that is covered */
+	for (int i = 0; i < Scene->Damage.GetCount(); i++) {
+		Scene->Compositor->Damage(Scene->Damage.GetRectangle(i));
 	}
+	Scene->Compositor->Compose(Scene->LayerOrder, LayerCount);
 
-	/* Reset dirties */
-	Scene->ValidRectangles = 0;
+	/* Reset damage */
+	Scene->Damage.Clear();
 }
@@ -30,7 +30,10 @@
 
 /* Includes
  * - Ui */
+#include <SDL/SDL.h>
 #include "backends/irenderer.h"
+#include "compositor.h"
+#include "region.h"
 #include "window.h"
 
 /* CScene
@@ -55,22 +58,22 @@ typedef struct _sScene {
 	/* Scene dimensions */
 	Rect_t Dimensions;
 
-	/* Background */
-	SDL_Texture *Background;
+	/* Background, scaled to the scene */
+	SDL_Surface *Background;
 
-	/* Backbuffer */
-	SDL_Texture *Texture;
+	/* The compositor that renders the scene 
+	 * and the layer storage used for it */
+	CCompositor *Compositor;
+	CompositorLayer_t *Layers;
+	CompositorLayer_t **LayerOrder;
+	int LayerCapacity;
 
 	/* List of windows */
 	List_t *Windows;
 
-	/* Array of dirty rectangles
-	 * up to a max 16 per iteration */
-	Rect_t Dirty[16];
-
-	/* The index for how many of the 
-	 * above rectangles are valid */
-	int ValidRectangles;
+	/* The damaged area of the scene, it is
+	 * rendered and reset by SceneRender */
+	CRegion Damage;
 
 } Scene_t;
 
@@ -79,7 +82,7 @@ typedef struct _sScene {
 
 /* Initializor
  * Creates a new scene */
-__CRT_EXTERN Scene_t *SceneCreate(int Id, Rect_t *Dimensions, SDL_Renderer *Renderer);
+__CRT_EXTERN Scene_t *SceneCreate(int Id, Rect_t *Dimensions, IRenderer *Renderer);
 
 /* Destructor
  * Cleans up all windows
@@ -107,8 +110,14 @@ __CRT_EXTERN Window_t *SceneGetActiveWindow(Scene_t *Scene);
  * for this scene, but only for the given rectangle */
 __CRT_EXTERN void SceneUpdate(Scene_t *Scene, Rect_t *DirtyArea);
 
+/* Present Window
+ * Shows a new frame of the window, only the damaged
+ * rectangles of the window are redrawn */
+__CRT_EXTERN OsStatus_t ScenePresentWindow(Scene_t *Scene, Window_t *Window, 
+	int Frame, Rect_t *Damage, int DamageCount);
+
 /* Render
  * This renders all windows for this scene */
-__CRT_EXTERN void SceneRender(Scene_t *Scene, SDL_Renderer *Renderer);
+__CRT_EXTERN void SceneRender(Scene_t *Scene);
 
 #endif //!_SAPPHIRE_SCENE_H_
\ No newline at end of file
@@ -32,18 +32,95 @@
 bool CSceneManager::Initialize(
 	IRenderer *Renderer, Rect_t *Size)
 {
-	// Reset some variables
+	// Variables
+	Scene_t *Scene = NULL;
+	DataKey_t Key;
+
+	// Reset some variables, window ids start at 1
+	// as they are used as handles
 	m_iSceneId = 0;
-	m_iWindowId = 0;
+	m_iWindowId = 1;
 	m_pScenes = ListCreate(KeyInteger);
 
 	// Create initial scene
+	Scene = SceneCreate(m_iSceneId, Size, Renderer);
+	if (Scene == NULL) {
+		return false;
+	}
+	Key.Value = m_iSceneId++;
+	ListAppend(m_pScenes, ListCreateNode(Key, Key, Scene));
+	return true;
+}
+
+// GetActiveScene
+// Retrieves the scene currently shown
+Scene_t *CSceneManager::GetActiveScene()
+{
+	// Variables
+	DataKey_t Key;
+
+	// Get active scene (todo)
+	Key.Value = 0;
+	return (Scene_t*)ListGetDataByKey(m_pScenes, Key, 0);
+}
+
+// Invalidate
+// This updates the current scene and makes all neccessary 
+// changes to windows a call with NULL invalidates entire scene
+bool CSceneManager::Invalidate(Rect_t *Area)
+{
+	SceneUpdate(GetActiveScene(), Area);
+	return true;
+}
 
+// Update
+// Flushes all the changes since last call to the renderer
+bool CSceneManager::Update()
+{
+	SceneRender(GetActiveScene());
+	return true;
+}
+
+// AddWindow
+// Adds a newly created window to the active scene and assigns it an id
+bool CSceneManager::AddWindow(Window_t *Window)
+{
+	if (Window == NULL) {
+		return false;
+	}
+	Window->Id = m_iWindowId++;
+	SceneAddWindow(GetActiveScene(), Window);
+	return true;
+}
+
+// GetWindow
+// Looks up a window by id in the active scene, NULL if not found
+Window_t *CSceneManager::GetWindow(int WindowId)
+{
+	return SceneGetWindow(GetActiveScene(), WindowId);
+}
+
+// PresentWindow
+// Shows a new frame of the window and redraws the damaged parts
+OsStatus_t CSceneManager::PresentWindow(WindowPresent_t *Present)
+{
+	// Variables
+	Window_t *Window = GetWindow((int)(uintptr_t)Present->Handle);
+	Scene_t *Scene = GetActiveScene();
+
+	// Switch frames and render right away, this paces 
+	// the client to the compositor
+	if (Window == NULL || ScenePresentWindow(Scene, Window, Present->Frame, 
+			&Present->Damage[0], Present->DamageCount) != OsSuccess) {
+		return OsError;
+	}
+	SceneRender(Scene);
+	return OsSuccess;
 }
 
 void
 SceneManagerInitialize(
-	_In_ SDL_Renderer *Renderer, 
+	_In_ IRenderer *Renderer, 
 	_In_ Rect_t *ScreenSize)
 {
 	/* Vars */
@@ -182,8 +259,7 @@ SceneManagerUpdate(
 /* SceneManagerRender
  * This renders the current scene to the screen */
 void
-SceneManagerRender(
-	_In_ SDL_Renderer *Renderer)
+SceneManagerRender(void)
 {
 	/* Vars */
 	DataKey_t Key;
@@ -196,9 +272,6 @@ SceneManagerRender(
 	Key.Value = 0;
 	Scene_t *ActiveScene = (Scene_t*)ListGetDataByKey(GlbSceneManager->Scenes, Key, 0);
 
-	/* Update Scene */
-	SceneRender(ActiveScene, Renderer);
-
-	/* Present Scene */
-	SDL_RenderPresent(Renderer);
+	/* Update Scene, the compositor presents it */
+	SceneRender(ActiveScene);
 }
\ No newline at end of file
@@ -74,6 +74,21 @@ public:
 	// Flushes all the changes since last call to the renderer
 	bool Update();
 
+	// AddWindow
+	// Adds a newly created window to the active scene and assigns it an id
+	bool AddWindow(Window_t *Window);
+
+	// GetWindow
+	// Looks up a window by id in the active scene, NULL if not found
+	Window_t *GetWindow(int WindowId);
+
+	// PresentWindow
+	// Shows a new frame of the window and redraws the damaged parts
+	OsStatus_t PresentWindow(WindowPresent_t *Present);
+
+private:
+	Scene_t *GetActiveScene();
+
 private:
 	int				m_iSceneId;
 	int				m_iWindowId;
@@ -88,7 +103,7 @@ private:
 __EXTERN
 void
 SceneManagerInitialize(
-	_In_ SDL_Renderer *Renderer, 
+	_In_ IRenderer *Renderer, 
 	_In_ Rect_t *ScreenSize);
 
 /* SceneManagerDestroy
@@ -132,7 +147,6 @@ SceneManagerUpdate(
  * This renders the current scene to the screen */
 __EXTERN
 void
-SceneManagerRender(
-	_In_ SDL_Renderer *Renderer);
+SceneManagerRender(void);
 
 #endif //!_SAPPHIRE_SCENEMGR_H_
\ No newline at end of file
@@ -20,9 +20,6 @@
 */
 
 /* Includes */
-#include <SDL.h>
-#include <SDL_image.h>
-#include "Scene.h"
 #include "Window.h"
 
 /* CLib */
@@ -39,14 +36,14 @@
 
 #define DECO_SHADOW				5
 
+/* Decoration colors, premultiplied ARGB */
+#define DECO_COLOR_HEADER		0xFFCCCCCC
+#define DECO_COLOR_CONTENT		0xFFFFFFFF
+
 /* BitBlt Flags */
 #define BITBLT_SRCSET			0x1
 #define BITBLT_SRCCOPY			0x2
 
-/* Prototypes */
-void SDL_DrawRound(SDL_Texture *Target,
-	Sint16 x0, Sint16 y0, Uint16 w, Uint16 h, Uint16 corner, Uint32 color);
-
 /* This is a dword size memset 
  * utilized to clear a surface to a given color */
 void memsetd(void *Buffer, uint32_t Color, size_t Count)
@@ -75,7 +72,7 @@ void BitBlt(uint8_t *Dest, size_t DestPitch, int DestX, int DestY,
 	/* Start a loop */
 	for (int Row = 0; Row < Height; Row++) {
 		if (Flags & BITBLT_SRCSET) {
-			memsetd(DestPointer, (uint32_t)((uint32_t*)Src), Width);
+			memsetd(DestPointer, (uint32_t)(uintptr_t)Src, Width);
 			DestPointer += DestPitch;
 		}
 		else {
@@ -86,67 +83,59 @@ void BitBlt(uint8_t *Dest, size_t DestPitch, int DestX, int DestY,
 	}
 }
 
-/* Utility to intersect two rectangles, we utilize 
- * the inbuilt SDL function for this, but we use our own struct */
-void RectIntersect(Rect_t *RectA, Rect_t *RectB, Rect_t *Result)
+/* Utility to draw the shadow in the edges of the decoration, 
+ * each ring is darker than the one outside of it */
+void WindowDrawShadows(Window_t *Window)
 {
-	/* We have to proxy some values ... */
-	SDL_Rect A, B, R;
-
-	/* Copy over first rectangle data */
-	A.x = RectA->x;
-	A.y = RectA->y;
-	A.w = RectA->w;
-	A.h = RectA->h;
-
-	/* Copy over second rectangle data */
-	B.x = RectB->x;
-	B.y = RectB->y;
-	B.w = RectB->w;
-	B.h = RectB->h;
-
-	/* Do the call */
-	if (SDL_IntersectRect(&A, &B, &R)) {
-		Result->x = R.x;
-		Result->y = R.y;
-		Result->w = R.w;
-		Result->h = R.h;
-	}
-	else {
-		Result->w = 0;
-		Result->h = 0;
-	}
-}
+	uint8_t *Pixels = (uint8_t*)Window->Decoration;
+	int Width = Window->FullDimensions.w;
+	int Height = Window->FullDimensions.h;
 
-/* Utility to draw rounded shadows in edges
- * of texture, uses SDL_draw code */
-void SDL_Shadows(SDL_Texture *Texture, int Width, int Height)
-{
 	for (int i = 0; i < DECO_SHADOW; i++) {
-		SDL_DrawRound(Texture, i, i, Width - (i * 2), Height - (i * 2), 
-			2, 0x00000000 + (i * 0x3F000000));
+		uint32_t Color = (uint32_t)i * 0x3F000000;
+		int RingWidth = Width - (i * 2), RingHeight = Height - (i * 2);
+		BitBlt(Pixels, Window->DecorationPitch, i, i, (uint8_t*)(uintptr_t)Color, 0, 0, 0,
+			RingWidth, 1, BITBLT_SRCSET);
+		BitBlt(Pixels, Window->DecorationPitch, i, Height - i - 1, (uint8_t*)(uintptr_t)Color, 0, 0, 0,
+			RingWidth, 1, BITBLT_SRCSET);
+		BitBlt(Pixels, Window->DecorationPitch, i, i, (uint8_t*)(uintptr_t)Color, 0, 0, 0,
+			1, RingHeight, BITBLT_SRCSET);
+		BitBlt(Pixels, Window->DecorationPitch, Width - i - 1, i, (uint8_t*)(uintptr_t)Color, 0, 0, 0,
+			1, RingHeight, BITBLT_SRCSET);
 	}
 }
 
 /* Constructor
- * Allocates a new window of the given
- * dimensions and initializes it */
-Window_t *WindowCreate(IpcComm_t Owner, Rect_t *Dimensions, int Flags, SDL_Renderer *Renderer)
+ * Allocates a new window of the given dimensions and maps the
+ * client surface, returns NULL if the surface can't be used */
+Window_t *WindowCreate(UUId_t Owner, Rect_t *Dimensions, int Flags, 
+	BufferObject_t *Surface, size_t Pitch)
 {
+	/* Variables */
+	Window_t *Window = NULL;
+	size_t FrameSize;
+
+	/* Sanity, the surface must be able to hold all frames */
+	FrameSize = Pitch * (size_t)Dimensions->h;
+	if (Surface == NULL || Dimensions->w <= 0 || Dimensions->h <= 0
+		|| Pitch < ((size_t)Dimensions->w * 4)
+		|| GetBufferCapacity(Surface) < (FrameSize * WINDOW_SURFACE_FRAMES)) {
+		return NULL;
+	}
+
 	/* Allocate a new window instance */
-	Window_t *Window = (Window_t*)malloc(sizeof(Window_t));
-	void *mPixels = NULL;
-	int mPitch = 0;
+	Window = (Window_t*)malloc(sizeof(Window_t));
+	if (Window == NULL) {
+		return NULL;
+	}
+	memset(Window, 0, sizeof(Window_t));
 	
 	/* Set initial stuff */
 	Window->Id = 0;
 	Window->Owner = Owner;
 	Window->Flags = Flags;
-	Window->Flip = SDL_FLIP_NONE;
-	Window->Rotation = 0.0;
 	Window->zIndex = 1000;
-	Window->Texture = NULL;
-	Window->Renderer = Renderer;
+	Window->FrontFrame = -1;
 
 	/* Convert dims 
 	 * The full-dimension is screen absolute */
@@ -168,43 +157,47 @@ Window_t *WindowCreate(IpcComm_t Owner, Rect_t *Dimensions, int Flags, SDL_Rende
 	Window->ContentDimensions.h = Dimensions->h;
 	Window->ContentDimensions.w = Dimensions->w;
 
-	/* Allocate a texture for the full dimensions of 
-	 * the window */
-	Window->Texture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_ARGB8888,
-		SDL_TEXTUREACCESS_STREAMING, Window->FullDimensions.w, Window->FullDimensions.h);
-
-	/* Set blend mode for the backbuffer
-	 * texture, we only do this for it */
-	SDL_SetTextureBlendMode(Window->Texture, SDL_BLENDMODE_BLEND);
-
-	/* Get texture information */
-	SDL_LockTexture(Window->Texture, NULL, &mPixels, &mPitch);
-	memset(mPixels, 0, Window->FullDimensions.h * mPitch);
-	SDL_UnlockTexture(Window->Texture);
+	/* Keep our own copy of the buffer object, the one we are
+	 * given belongs to the message. Then map it in */
+	Window->Surface = (BufferObject_t*)malloc(GetBufferObjectSize(Surface));
+	if (Window->Surface == NULL) {
+		free(Window);
+		return NULL;
+	}
+	memcpy(Window->Surface, Surface, GetBufferObjectSize(Surface));
+	if (AcquireBuffer(Window->Surface) != OsSuccess) {
+		free(Window->Surface);
+		free(Window);
+		return NULL;
+	}
+	Window->SurfacePixels = (uint8_t*)GetBufferData(Window->Surface);
+	Window->SurfacePitch = Pitch;
+	Window->SurfaceFrameSize = FrameSize;
+
+	/* Allocate the decoration for the full dimensions of 
+	 * the window, the content area is shown until the first present */
+	Window->DecorationPitch = Window->FullDimensions.w * 4;
+	Window->Decoration = (uint32_t*)malloc(Window->DecorationPitch * Window->FullDimensions.h);
+	if (Window->Decoration == NULL) {
+		ReleaseBuffer(Window->Surface);
+		free(Window->Surface);
+		free(Window);
+		return NULL;
+	}
+	memset(Window->Decoration, 0, Window->DecorationPitch * Window->FullDimensions.h);
 
 	/* Draw Shadows */
-	SDL_Shadows(Window->Texture, Window->FullDimensions.w, Window->FullDimensions.h);
-
-	/* Allocate a user-backbuffer for only the content
-	 * therefore we can't exactly use mPitch if Content.w != Full.w */
-	Window->Backbuffer = malloc(Window->ContentDimensions.h * mPitch);
-	Window->BackbufferSize = Window->ContentDimensions.h * mPitch;
-	memsetd(Window->Backbuffer, 0xFFFFFFFF, (Window->ContentDimensions.h * mPitch) / 4);
-
-	/* Now lock the texture again */
-	SDL_LockTexture(Window->Texture, NULL, &mPixels, &mPitch);
+	WindowDrawShadows(Window);
 
 	/* Fill the header */
-	BitBlt(mPixels, mPitch, DECO_SHADOW, DECO_SHADOW, (uint8_t*)0xFFCCCCCC, 0, 0, 0,
+	BitBlt((uint8_t*)Window->Decoration, Window->DecorationPitch, DECO_SHADOW, DECO_SHADOW, 
+		(uint8_t*)DECO_COLOR_HEADER, 0, 0, 0,
 		Window->ContentDimensions.w, DECO_BAR_TOP_HEIGHT, BITBLT_SRCSET);
 
-	/* Fill the content => Copy pixels */
-	BitBlt(mPixels, mPitch, DECO_SHADOW, DECO_BAR_TOP_HEIGHT + DECO_SHADOW,
-		Window->Backbuffer, mPitch, 0, 0,
-		Window->ContentDimensions.w, Window->ContentDimensions.h, BITBLT_SRCCOPY);
-
-	/* Unlock texture */
-	SDL_UnlockTexture(Window->Texture);
+	/* Fill the content */
+	BitBlt((uint8_t*)Window->Decoration, Window->DecorationPitch, DECO_SHADOW, 
+		DECO_BAR_TOP_HEIGHT + DECO_SHADOW, (uint8_t*)DECO_COLOR_CONTENT, 0, 0, 0,
+		Window->ContentDimensions.w, Window->ContentDimensions.h, BITBLT_SRCSET);
 
 	/* Draw the image */
 
@@ -223,105 +216,77 @@ void WindowDestroy(Window_t *Window)
 	if (Window == NULL)
 		return;
 
-	/* Free sdl-stuff */
-	SDL_DestroyTexture(Window->Texture);
+	/* Unmap the surface, the memory belongs to the client */
+	ReleaseBuffer(Window->Surface);
 
 	/* Free resources */
-	free(Window->Backbuffer);
+	free(Window->Surface);
+	free(Window->Decoration);
 	free(Window);
 }
 
-/* Update
- * Updates all neccessary state and
- * buffers before rendering */
-void WindowUpdate(Window_t *Window, Rect_t *DirtyArea)
+/* Present
+ * Switches the front frame of the window and adds the damaged
+ * parts of the window (in screen coordinates) to the given region */
+OsStatus_t WindowPresent(Window_t *Window, int Frame, 
+	Rect_t *Damage, int DamageCount, CRegion *ScreenDamage)
 {
-	/* Variables needed for update */
-	Rect_t Intersection;
-	void *mPixels = NULL;
-	int mPitch = 0;
+	/* Variables */
+	Rect_t Area;
 
 	/* Sanity */
-	if (Window == NULL)
-		return;
+	if (Window == NULL || Frame < 0 || Frame >= WINDOW_SURFACE_FRAMES
+		|| DamageCount < 0 || DamageCount > WINDOW_MAX_DAMAGE) {
+		return OsError;
+	}
 
-	/* Check intersection */
-	if (DirtyArea != NULL) {
-		RectIntersect(&Window->ContentDimensions, DirtyArea, &Intersection);
+	/* The first present and full presents damage the entire content, 
+	 * otherwise translate the damage to screen coordinates */
+	if (Window->FrontFrame == -1 || DamageCount == 0 || Damage == NULL) {
+		ScreenDamage->Add(&Window->ContentDimensions);
 	}
 	else {
-		Intersection.x = Window->ContentDimensions.x;
-		Intersection.y = Window->ContentDimensions.y;
-		Intersection.w = Window->ContentDimensions.w;
-		Intersection.h = Window->ContentDimensions.h;
-	}
-
-	/* Sanity 
-	 * In case there was no intersection */
-	if (Intersection.w == 0 && Intersection.h == 0) {
-		return;
+		for (int i = 0; i < DamageCount; i++) {
+			Area.x = Window->ContentDimensions.x + Damage[i].x;
+			Area.y = Window->ContentDimensions.y + Damage[i].y;
+			Area.w = Damage[i].w;
+			Area.h = Damage[i].h;
+			CRegion::Intersection(&Area, &Window->ContentDimensions, &Area);
+			ScreenDamage->Add(&Area);
+		}
 	}
 
-	/* Lock texture */
-	SDL_LockTexture(Window->Texture, NULL, &mPixels, &mPitch);
-
-	/* Copy pixels */
-	BitBlt(mPixels, mPitch, (Intersection.x - Window->FullDimensions.x), (Intersection.y - Window->FullDimensions.x),
-		Window->Backbuffer, mPitch, (Intersection.x - Window->ContentDimensions.x), (Intersection.y - Window->ContentDimensions.y),
-		Intersection.w, Intersection.h, BITBLT_SRCCOPY);
-
-	/* Unlock texture */
-	SDL_UnlockTexture(Window->Texture);
+	/* Switch frames, from here on we never touch the old frame */
+	Window->FrontFrame = Frame;
+	return OsSuccess;
 }
 
-/* Render
- * Renders the window to the given renderer 
- * Right now it does not use rect-invalidation
- * so any invalidate out of scope faults */
-void WindowRender(Window_t *Window, SDL_Renderer *Renderer, Rect_t *DirtyArea)
+/* Get Layers
+ * Describes the window as compositor layers, the decoration
+ * and the content of the front frame. Returns the number of layers */
+int WindowGetLayers(Window_t *Window, CompositorLayer_t *Layers)
 {
-	/* The rects to be updated */
-	SDL_Rect Source, Destination;
-
 	/* Sanity */
 	if (Window == NULL)
-		return;
-
-	/* Copy window texture to render */
-	if (DirtyArea == NULL
-		|| (DirtyArea->x == Window->FullDimensions.x
-			&& DirtyArea->y == Window->FullDimensions.y
-			&& DirtyArea->w == Window->FullDimensions.w
-			&& DirtyArea->h == Window->FullDimensions.h)) 
-	{
-		/* Set destination (just copy) */
-		Destination.x = Window->FullDimensions.x;
-		Destination.y = Window->FullDimensions.y;
-		Destination.w = Window->FullDimensions.w;
-		Destination.h = Window->FullDimensions.h;
-
-		/* Full redraw */
-		SDL_RenderCopyEx(Renderer, Window->Texture, NULL, &Destination,
-			Window->Rotation, NULL, Window->Flip); 
+		return 0;
+
+	/* The decoration has shadows so it is blended */
+	Layers[0].Dimensions = Window->FullDimensions;
+	Layers[0].Pixels = Window->Decoration;
+	Layers[0].Pitch = Window->DecorationPitch;
+	Layers[0].Flags = 0;
+
+	/* The content is read directly from the client frame */
+	Layers[1].Dimensions = Window->ContentDimensions;
+	Layers[1].Pitch = Window->SurfacePitch;
+	if (Window->FrontFrame == -1) {
+		Layers[1].Pixels = NULL;
+		Layers[1].Flags = LAYER_HIDDEN;
 	}
 	else {
-
-		/* Set source variables 
-		 * We do this by adjusting the rectangle
-		 * by the window position */
-		Source.x = DirtyArea->x - Window->FullDimensions.x;
-		Source.y = DirtyArea->y - Window->FullDimensions.y;
-		Source.w = DirtyArea->w;
-		Source.h = DirtyArea->h;
-
-		/* Set destination (just copy) */
-		Destination.x = DirtyArea->x;
-		Destination.y = DirtyArea->y;
-		Destination.w = DirtyArea->w;
-		Destination.h = DirtyArea->h;
-
-		/* Copy buffer */
-		SDL_RenderCopyEx(Renderer, Window->Texture, &Source, &Destination,
-			Window->Rotation, NULL, Window->Flip);
+		Layers[1].Pixels = (uint32_t*)(Window->SurfacePixels 
+			+ ((size_t)Window->FrontFrame * Window->SurfaceFrameSize));
+		Layers[1].Flags = LAYER_OPAQUE;
 	}
+	return 2;
 }
@@ -24,11 +24,14 @@
 
 /* Includes
  * - Library */
+#include <os/driver/window.h>
+#include <os/driver/buffer.h>
 #include <os/osdefs.h>
 
 /* Includes
  * - Ui */
-#include <SDL/SDL.h>
+#include "compositor.h"
+#include "region.h"
 
 /* Definitions */
 #define WINDOW_CONSOLE	0x1
@@ -50,18 +53,19 @@ typedef struct _sWindow {
 	Rect_t FullDimensions;
 	Rect_t ContentDimensions;
 
-	/* Specials */
-	double Rotation;
-	SDL_RendererFlip Flip;
-
-	/* User-Backbuffer */
-	void *Backbuffer;
-	void *BackbufferHandle;
-	size_t BackbufferSize;
-	
-	/* The render surface */
-	SDL_Renderer *Renderer;
-	SDL_Texture *Texture;
+	/* Shared surface, the frames are owned by the client and
+	 * mapped into our address space. We only read from the
+	 * frame that was last presented */
+	BufferObject_t *Surface;
+	uint8_t *SurfacePixels;
+	size_t SurfacePitch;
+	size_t SurfaceFrameSize;
+	int FrontFrame;
+
+	/* Decorations, owned by us and drawn
+	 * beneath the surface */
+	uint32_t *Decoration;
+	size_t DecorationPitch;
 	void *Terminal;
 
 } Window_t;
@@ -70,23 +74,25 @@ typedef struct _sWindow {
 /* Prototypes */
 
 /* Constructor 
- * Allocates a new window of the given
- * dimensions and initializes it */
-__EXTERN Window_t *WindowCreate(UUId_t Owner, Rect_t *Dimensions, int Flags, SDL_Renderer *Renderer);
+ * Allocates a new window of the given dimensions and maps the
+ * client surface, returns NULL if the surface can't be used */
+__EXTERN Window_t *WindowCreate(UUId_t Owner, Rect_t *Dimensions, int Flags, 
+	BufferObject_t *Surface, size_t Pitch);
 
 /* Destructor
  * Cleans up and releases 
  * resources allocated */
 __EXTERN void WindowDestroy(Window_t *Window);
 
-/* Update
- * Updates all neccessary state and 
- * buffers before rendering */
-__EXTERN void WindowUpdate(Window_t *Window, Rect_t *DirtyArea);
+/* Present
+ * Switches the front frame of the window and adds the damaged
+ * parts of the window (in screen coordinates) to the given region */
+__EXTERN OsStatus_t WindowPresent(Window_t *Window, int Frame, 
+	Rect_t *Damage, int DamageCount, CRegion *ScreenDamage);
 
-/* Render
- * Renders the window to the 
- * given renderer */
-__EXTERN void WindowRender(Window_t *Window, SDL_Renderer *Renderer, Rect_t *DirtyArea);
+/* Get Layers
+ * Describes the window as compositor layers, the decoration
+ * and the content of the front frame. Returns the number of layers */
+__EXTERN int WindowGetLayers(Window_t *Window, CompositorLayer_t *Layers);
 
 #endif //!_SAPPHIRE_WINDOW_H_
\ No newline at end of file
@@ -30,101 +30,13 @@
 #include "core/backends/sdl/sdlrenderer.h"
 
 /* Handle Message */
-void HandleMessage(SDL_Renderer *Target, MEventMessage_t *Message)
+void HandleMessage(MEventMessage_t *Message)
 {
 	/* First of all, 
 	 * which kind of message is it? 
-	 * User-messages are generic */
+	 * Window requests arrive through OnEvent */
 	switch (Message->Base.Type)
 	{
-		/* Generic Message 
-		 * Comes from processes */
-		case EventGeneric:
-		{
-			/* Let's see.. */
-			switch (Message->Generic.Type)
-			{
-				/* Create new window */
-				case GenericWindowCreate:
-				{
-					/* Get window information structure */
-					IPCWindowCreate_t *WndInformation = 
-						(IPCWindowCreate_t*)Message->Generic.LoParam;
-					Window_t *Wnd = NULL;
-					void *BackbufferHandle = NULL;
-
-					/* Create window */
-					Wnd = WindowCreate(Message->Base.Sender, &WndInformation->Dimensions, 
-						WndInformation->Flags, Target);
-
-					/* Share backbuffer */
-					BackbufferHandle = MollenOSMemoryShare(Message->Base.Sender, 
-						Wnd->Backbuffer, Wnd->BackbufferSize);
-
-					/* Update structure */
-					Wnd->BackbufferHandle = BackbufferHandle;
-					WndInformation->Backbuffer = BackbufferHandle;
-					WndInformation->BackbufferSize = Wnd->BackbufferSize;
-
-					/* Update dimensions */
-					WndInformation->WndDimensions.x = Wnd->FullDimensions.x;
-					WndInformation->WndDimensions.y = Wnd->FullDimensions.y;
-					WndInformation->WndDimensions.w = Wnd->FullDimensions.w;
-					WndInformation->WndDimensions.h = Wnd->FullDimensions.h;
-					
-					WndInformation->BbDimensions.x = Wnd->ContentDimensions.x;
-					WndInformation->BbDimensions.y = Wnd->ContentDimensions.y;
-					WndInformation->BbDimensions.w = Wnd->ContentDimensions.w;
-					WndInformation->BbDimensions.h = Wnd->ContentDimensions.h;
-
-					/* Add to scene manager */
-					SceneManagerAddWindow(Wnd);
-
-					/* Invalidate Rectangle */
-					SceneManagerUpdate(&Wnd->FullDimensions);
-
-					/* Update id */
-					WndInformation->WindowId = Wnd->Id;
-
-					/* Signal the process */
-					MollenOSSignalWake(Message->Base.Sender);
-
-				} break;
-
-				/* Destroy a window */
-				case GenericWindowDestroy:
-				{
-
-				} break;
-
-				/* Invalidate a window */
-				case GenericWindowInvalidate:
-				{
-					/* Since the coordinates for the dirty rect
-					 * actually are relative to the window 
-					 * we need to offset them */
-					Window_t *Window = SceneManagerGetWindow((int)Message->Generic.LoParam);
-					Rect_t AbsRect;
-
-					/* Append global coords */
-					AbsRect.x = Window->FullDimensions.x + Message->Generic.RcParam.x;
-					AbsRect.y = Window->FullDimensions.y + Message->Generic.RcParam.y;
-					AbsRect.w = Message->Generic.RcParam.w;
-					AbsRect.h = Message->Generic.RcParam.h;
-
-					/* Ok, so mark the rectangle dirty 
-					 * and update screen */
-					SceneManagerUpdate(&AbsRect);
-
-				} break;
-
-				/* Ignore other events */
-				default:
-					break;
-			}
-
-		} break;
-
 		/* Input Message
 		 * Comes from input drivers */
 		case EventInput:
@@ -213,14 +125,67 @@ OsStatus_t OnEvent(MRemoteCall_t *Message)
 	// Which function is called?
 	switch (Message->Function)
 	{
+		// Creates a window on top of the surface the client
+		// allocated, the surface is mapped and never copied
 		case __WINDOWMANAGER_CREATE: {
-
+			// Variables
+			WindowParameters_t *Parameters = 
+				(WindowParameters_t*)Message->Arguments[0].Data.Buffer;
+			BufferObject_t *Surface = 
+				(BufferObject_t*)Message->Arguments[1].Data.Buffer;
+			Handle_t Handle = HANDLE_INVALID;
+			Window_t *Window = NULL;
+
+			// Create the window and show its decoration
+			Window = WindowCreate(Message->Sender, &Parameters->Surface.Dimensions,
+				Parameters->Flags, Surface, Parameters->Surface.Pitch);
+			if (Window != NULL && sSceneManager.AddWindow(Window)) {
+				Handle = (Handle_t)(uintptr_t)Window->Id;
+				sSceneManager.Invalidate(&Window->FullDimensions);
+				sSceneManager.Update();
+			}
+			Result = RPCRespond(Message, (__CONST void*)&Handle, sizeof(Handle_t));
 		} break;
 		case __WINDOWMANAGER_DESTROY: {
 
 		} break;
+
+		// Invalidate redraws the given area of the presented frame 
+		// without switching frames
 		case __WINDOWMANAGER_INVALIDATE: {
+			// Variables
+			Window_t *Window = sSceneManager.GetWindow(
+				(int)(uintptr_t)Message->Arguments[0].Data.Value);
+			WindowPresent_t Present;
+
+			if (Window != NULL && Window->FrontFrame != -1) {
+				Present.Handle = (Handle_t)(uintptr_t)Window->Id;
+				Present.Frame = Window->FrontFrame;
+				Present.DamageCount = 0;
+				if (Message->Arguments[1].Data.Buffer != NULL) {
+					memcpy(&Present.Damage[0], Message->Arguments[1].Data.Buffer, sizeof(Rect_t));
+					Present.DamageCount = 1;
+				}
+				sSceneManager.PresentWindow(&Present);
+			}
+		} break;
 
+		// Present switches the shown frame of a window, we respond
+		// once the previous frame is no longer in use
+		case __WINDOWMANAGER_PRESENT: {
+			// Variables
+			WindowPresent_t *Present = 
+				(WindowPresent_t*)Message->Arguments[0].Data.Buffer;
+			OsStatus_t Status = OsError;
+
+			// The damage list is variable in length
+			if (Message->Arguments[0].Length >= offsetof(WindowPresent_t, Damage)
+				&& Present->DamageCount >= 0 && Present->DamageCount <= WINDOW_MAX_DAMAGE
+				&& Message->Arguments[0].Length >= offsetof(WindowPresent_t, Damage)
+					+ (Present->DamageCount * sizeof(Rect_t))) {
+				Status = sSceneManager.PresentWindow(Present);
+			}
+			Result = RPCRespond(Message, (__CONST void*)&Status, sizeof(OsStatus_t));
 		} break;
 		case __WINDOWMANAGER_QUERY: {
 
@@ -149,6 +149,7 @@ static int Main(string[] args)
             String Target = "live";
             String SchemeType = "mbr";
             bool Automatic = false;
+            bool HashedDirectories = false;
 
             // Debug print header
             Console.WriteLine("MFS Utility Software");
@@ -172,6 +173,10 @@ static int Main(string[] args)
                                 SchemeType = args[i + 1];
                                 i++;
                             } break;
+
+                        case "-hashed": {
+                                HashedDirectories = true;
+                            } break;
                     }
                 }
             }
@@ -236,7 +241,7 @@ static int Main(string[] args)
                 }
 
                 // Partition setup?
-                FileSystem = new CMollenOSFileSystem("MollenOS");
+                FileSystem = new CMollenOSFileSystem("MollenOS", HashedDirectories);
 
                 // Setup disk partition layout
                 Scheme.Create(Disk);
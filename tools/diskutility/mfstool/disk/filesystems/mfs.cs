@@ -34,6 +34,7 @@ public enum RecordFlags : uint
             Hidden          = 0x10,
             Chained         = 0x20,
             Locked          = 0x40,
+            Hashed          = 0x80,
 
             Versioned       = 0x10000000,
             Inline          = 0x20000000,
@@ -43,6 +44,9 @@ public enum RecordFlags : uint
 
         // Constants
         private readonly UInt32 MFS_ENDOFCHAIN = 0xFFFFFFFF;
+        private readonly UInt32 MFS_HASHSLOT_EMPTY = 0;
+        private readonly UInt32 MFS_MASTERRECORD_HASHEDDIRS = 0x1;
+        private readonly UInt32 MFS_MASTERRECORD_HASHEDROOT = 0x2;
 
         // Variabes
         private String m_szName;
@@ -50,6 +54,7 @@ public enum RecordFlags : uint
         private UInt64 m_iSector;
         private UInt64 m_iSectorCount;
         private UInt16 m_iBucketSize;
+        private Boolean m_bHashedDirectories;
 
         /* CalculateChecksum
          * Allocates the number of requested buckets, and spits out the initial allocation size */
@@ -269,6 +274,102 @@ void FillBucketChain(UInt32 Bucket, UInt32 BucketLength, Byte[] Data)
             }
         }
 
+        /* HashName
+         * Hashes the name case-insensitively (ascii only) up to the first path separator, this must
+         * match the driver as the hash selects the chain of a hashed directory the record lives in */
+        UInt32 HashName(String Name)
+        {
+            // Variables
+            UInt32 Hash = 5381;
+
+            // Build hash
+            foreach (Byte Character in Encoding.UTF8.GetBytes(Name)) {
+                Byte Folded = Character;
+                if (Folded == '/')
+                    break;
+                if (Folded >= 'A' && Folded <= 'Z')
+                    Folded = (Byte)(Folded + ('a' - 'A'));
+                Hash = unchecked((Hash * 33) + Folded);
+            }
+
+            // Done
+            return Hash;
+        }
+
+        /* GetDirectoryChain
+         * Flat directories are a single chain of record buckets. The first bucket of a hashed directory
+         * is a table of chain heads instead, and the name hash selects the chain. An empty slot gets a chain
+         * allocated if Create is set, otherwise MFS_ENDOFCHAIN is returned */
+        UInt32 GetDirectoryChain(UInt32 DirectoryBucket, Boolean Hashed, String Name, Boolean Create)
+        {
+            // Flat directories are their own chain
+            if (!Hashed)
+                return DirectoryBucket;
+
+            // Read the table of chains
+            UInt64 Sector = DirectoryBucket * m_iBucketSize;
+            Byte[] Table = m_pDisk.Read(m_iSector + Sector, m_iBucketSize);
+            int SlotOffset = (int)((HashName(Name) % (UInt32)(Table.Length / 4)) * 4);
+            UInt32 Chain = BitConverter.ToUInt32(Table, SlotOffset);
+            if (Chain != MFS_HASHSLOT_EMPTY)
+                return Chain;
+            if (!Create)
+                return MFS_ENDOFCHAIN;
+
+            // Load master-record and get free entry
+            Byte[] Bootsector = m_pDisk.Read(m_iSector, 1);
+            UInt64 MasterRecordSector = BitConverter.ToUInt64(Bootsector, 28);
+            UInt64 MasterRecordMirrorSector = BitConverter.ToUInt64(Bootsector, 36);
+            Byte[] MasterRecord = m_pDisk.Read(m_iSector + MasterRecordSector, 1);
+            UInt32 Allocation = BitConverter.ToUInt32(MasterRecord, 76);
+            UInt32 AllocationLength = 0;
+
+            // Allocate a single bucket for the chain
+            UInt32 UpdatedFreePointer = AllocateBuckets(Allocation, 1, out AllocationLength);
+            MasterRecord[76] = (Byte)(UpdatedFreePointer & 0xFF);
+            MasterRecord[77] = (Byte)((UpdatedFreePointer >> 8) & 0xFF);
+            MasterRecord[78] = (Byte)((UpdatedFreePointer >> 16) & 0xFF);
+            MasterRecord[79] = (Byte)((UpdatedFreePointer >> 24) & 0xFF);
+            m_pDisk.Write(MasterRecord, m_iSector + MasterRecordSector, true);
+            m_pDisk.Write(MasterRecord, m_iSector + MasterRecordMirrorSector, true);
+
+            // Wipe the chain and link it into the table
+            Byte[] Wipe = new Byte[m_iBucketSize * m_pDisk.BytesPerSector * AllocationLength];
+            m_pDisk.Write(Wipe, m_iSector + (Allocation * m_iBucketSize), true);
+            Table[SlotOffset + 0] = (Byte)(Allocation & 0xFF);
+            Table[SlotOffset + 1] = (Byte)((Allocation >> 8) & 0xFF);
+            Table[SlotOffset + 2] = (Byte)((Allocation >> 16) & 0xFF);
+            Table[SlotOffset + 3] = (Byte)((Allocation >> 24) & 0xFF);
+            m_pDisk.Write(Table, m_iSector + Sector, true);
+            return Allocation;
+        }
+
+        /* GetDirectoryChains
+         * Returns the chains of the directory the name can be in, or every chain of the
+         * directory if no name is given */
+        Queue<UInt32> GetDirectoryChains(UInt32 DirectoryBucket, Boolean Hashed, String Name)
+        {
+            // Variables
+            Queue<UInt32> Chains = new Queue<UInt32>();
+
+            // Only listings of hashed directories visit more than one chain
+            if (!Hashed || !String.IsNullOrEmpty(Name)) {
+                UInt32 Chain = GetDirectoryChain(DirectoryBucket, Hashed, Name, false);
+                if (Chain != MFS_ENDOFCHAIN)
+                    Chains.Enqueue(Chain);
+                return Chains;
+            }
+
+            // Read the table of chains
+            Byte[] Table = m_pDisk.Read(m_iSector + (DirectoryBucket * m_iBucketSize), m_iBucketSize);
+            for (int i = 0; i < Table.Length; i += 4) {
+                UInt32 Chain = BitConverter.ToUInt32(Table, i);
+                if (Chain != MFS_HASHSLOT_EMPTY)
+                    Chains.Enqueue(Chain);
+            }
+            return Chains;
+        }
+
         /* CreateFileRecord
          * Creates a new file-record with the given flags and data, and name at in the given directory start bucket. 
          * Name must not be a path. */
@@ -421,7 +522,7 @@ void CreateFileRecord(String Name, RecordFlags Flags, UInt32 Bucket, UInt32 Buck
         /* ListRecursive 
          * Has two purposes - either it recursively lists the entries of end directory or it
          * can locate a file if the path contains '.' and return it's placement */
-        MfsRecord ListRecursive(UInt32 DirectoryBucket, String LocalPath, Boolean Verbose = true)
+        MfsRecord ListRecursive(UInt32 DirectoryBucket, Boolean Hashed, String LocalPath, Boolean Verbose = true)
         {
             // Sanitize path, if it starts with / skip it
             String mPath = LocalPath;
@@ -434,10 +535,11 @@ MfsRecord ListRecursive(UInt32 DirectoryBucket, String LocalPath, Boolean Verbos
 
             // Detect end of path
             if (String.IsNullOrEmpty(LookFor) || LookFor.Contains(".")) {
-                // Variables
-                UInt32 IteratorBucket = DirectoryBucket;
+                // Variables, hashed directories keep the token in one of their chains
+                Queue<UInt32> Chains = GetDirectoryChains(DirectoryBucket, Hashed, LookFor);
+                UInt32 IteratorBucket = (Chains.Count > 0) ? Chains.Dequeue() : MFS_ENDOFCHAIN;
                 UInt32 DirectoryLength = 0;
-                int End = 0;
+                int End = (IteratorBucket == MFS_ENDOFCHAIN) ? 1 : 0;
 
                 while (End == 0) {
                     // Get length of bucket
@@ -501,8 +603,11 @@ MfsRecord ListRecursive(UInt32 DirectoryBucket, String LocalPath, Boolean Verbos
                         IteratorBucket = GetBucketLengthAndLink(IteratorBucket, out DirectoryLength);
                     }
                     
-                    // Have we reached end?
-                    if (IteratorBucket == MFS_ENDOFCHAIN) {
+                    // Have we reached end? Then move on to the next chain
+                    if (IteratorBucket == MFS_ENDOFCHAIN && Chains.Count > 0) {
+                        IteratorBucket = Chains.Dequeue();
+                    }
+                    else if (IteratorBucket == MFS_ENDOFCHAIN) {
                         End = 1;
                         break;
                     }
@@ -512,10 +617,11 @@ MfsRecord ListRecursive(UInt32 DirectoryBucket, String LocalPath, Boolean Verbos
                 return null;
             }
             else {
-                // Variables
-                UInt32 IteratorBucket = DirectoryBucket;
+                // Variables, hashed directories keep the token in one of their chains
+                Queue<UInt32> Chains = GetDirectoryChains(DirectoryBucket, Hashed, LookFor);
+                UInt32 IteratorBucket = (Chains.Count > 0) ? Chains.Dequeue() : MFS_ENDOFCHAIN;
                 UInt32 DirectoryLength = 0;
-                int End = 0;
+                int End = (IteratorBucket == MFS_ENDOFCHAIN) ? 1 : 0;
 
                 while (End == 0) {
                     // Get length of bucket
@@ -565,7 +671,8 @@ MfsRecord ListRecursive(UInt32 DirectoryBucket, String LocalPath, Boolean Verbos
                             }
                             
                             // Go further down the rabbit-hole
-                            return ListRecursive(nEntry.Bucket, mPath.Substring(LookFor.Length), Verbose);
+                            return ListRecursive(nEntry.Bucket, Flags.HasFlag(RecordFlags.Hashed), 
+                                mPath.Substring(LookFor.Length), Verbose);
                         }
 
                         // Advance to next entry
@@ -577,8 +684,11 @@ MfsRecord ListRecursive(UInt32 DirectoryBucket, String LocalPath, Boolean Verbos
                         IteratorBucket = GetBucketLengthAndLink(IteratorBucket, out DirectoryLength);
                     }
                     
-                    // Have we reached end?
-                    if (IteratorBucket == MFS_ENDOFCHAIN) {
+                    // Have we reached end? Then move on to the next chain
+                    if (IteratorBucket == MFS_ENDOFCHAIN && Chains.Count > 0) {
+                        IteratorBucket = Chains.Dequeue();
+                    }
+                    else if (IteratorBucket == MFS_ENDOFCHAIN) {
                         End = 1;
                         break;
                     }
@@ -592,7 +702,7 @@ MfsRecord ListRecursive(UInt32 DirectoryBucket, String LocalPath, Boolean Verbos
         /* CreateRecursive 
          * Recursively iterates through the path and creates the path. 
          * If path exists nothing happens */
-        MfsRecord CreateRecursive(UInt32 DirectoryBucket, String LocalPath)
+        MfsRecord CreateRecursive(UInt32 DirectoryBucket, Boolean Hashed, String LocalPath)
         {
             /* Sanity, if start with "/" skip */
             String mPath = LocalPath;
@@ -607,8 +717,9 @@ MfsRecord CreateRecursive(UInt32 DirectoryBucket, String LocalPath)
 
             // Handle end of path
             if (String.IsNullOrEmpty(LookFor) || iDex == -1) {
-                // Variables
-                UInt32 IteratorBucket = DirectoryBucket, PreviousBucket = MFS_ENDOFCHAIN;
+                // Variables, hashed directories keep the token in one of their chains
+                UInt32 IteratorBucket = GetDirectoryChain(DirectoryBucket, Hashed, LookFor, true);
+                UInt32 PreviousBucket = MFS_ENDOFCHAIN;
                 UInt32 DirectoryLength = 0;
                 int End = 0;
                 int i = 0;
@@ -670,10 +781,10 @@ MfsRecord CreateRecursive(UInt32 DirectoryBucket, String LocalPath)
                 return nEntry;
             }
             else {
-                // Variables
-                UInt32 IteratorBucket = DirectoryBucket;
+                // Variables, hashed directories keep the token in one of their chains
+                UInt32 IteratorBucket = GetDirectoryChain(DirectoryBucket, Hashed, LookFor, false);
                 UInt32 DirectoryLength = 0;
-                int End = 0;
+                int End = (IteratorBucket == MFS_ENDOFCHAIN) ? 1 : 0;
 
                 while (End == 0) {
                     // Get length of bucket
@@ -731,10 +842,21 @@ MfsRecord CreateRecursive(UInt32 DirectoryBucket, String LocalPath)
                                 Byte[] MasterRecord = m_pDisk.Read(m_iSector + MasterRecordSector, 1);
                                 UInt32 FreeBucket = BitConverter.ToUInt32(MasterRecord, 76);
 
+                                // Empty directories take the format new directories have on this
+                                // volume, the table of a hashed directory is a single bucket
+                                if ((BitConverter.ToUInt32(MasterRecord, 4) & MFS_MASTERRECORD_HASHEDDIRS) != 0) {
+                                    Flags |= RecordFlags.Hashed;
+                                    fBuffer[i + 0] = (Byte)((uint)Flags & 0xFF);
+                                    fBuffer[i + 1] = (Byte)(((uint)Flags >> 8) & 0xFF);
+                                    fBuffer[i + 2] = (Byte)(((uint)Flags >> 16) & 0xFF);
+                                    fBuffer[i + 3] = (Byte)(((uint)Flags >> 24) & 0xFF);
+                                }
+
                                 // Allocate new buckets
                                 nEntry.Bucket = FreeBucket;
                                 UInt32 InitialBucketSize = 0;
-                                UInt32 NextFree = AllocateBuckets(FreeBucket, 4, out InitialBucketSize);
+                                UInt32 NextFree = AllocateBuckets(FreeBucket, 
+                                    Flags.HasFlag(RecordFlags.Hashed) ? 1UL : 4UL, out InitialBucketSize);
 
                                 // Update the master-record
                                 MasterRecord[76] = (Byte)(NextFree & 0xFF);
@@ -763,7 +885,8 @@ MfsRecord CreateRecursive(UInt32 DirectoryBucket, String LocalPath)
                             }
 
                             // Go further down the rabbit hole
-                            return CreateRecursive(nEntry.Bucket, mPath.Substring(LookFor.Length));
+                            return CreateRecursive(nEntry.Bucket, Flags.HasFlag(RecordFlags.Hashed), 
+                                mPath.Substring(LookFor.Length));
                         }
 
                         // Advance to next entry
@@ -789,12 +912,13 @@ MfsRecord CreateRecursive(UInt32 DirectoryBucket, String LocalPath)
         
         /* Constructor
          * Zeroes out and initializes local members */
-        public CMollenOSFileSystem(String PartitionName = "System")
+        public CMollenOSFileSystem(String PartitionName = "System", Boolean HashedDirectories = false)
         {
             // Initialize
             m_pDisk = null;
             m_iBucketSize = 0;
             m_szName = PartitionName;
+            m_bHashedDirectories = HashedDirectories;
         }
 
         /* Initialize
@@ -986,7 +1110,15 @@ public bool Format()
             MasterRecord[2] = 0x53;
             MasterRecord[3] = 0x31;
 
-            // Flags are 0
+            // Flags, hashed volumes start out with a hashed root, the wiped
+            // root bucket is an empty table of chains
+            if (m_bHashedDirectories) {
+                UInt32 MasterFlags = MFS_MASTERRECORD_HASHEDDIRS | MFS_MASTERRECORD_HASHEDROOT;
+                MasterRecord[4] = (Byte)(MasterFlags & 0xFF);
+                MasterRecord[5] = (Byte)((MasterFlags >> 8) & 0xFF);
+                MasterRecord[6] = (Byte)((MasterFlags >> 16) & 0xFF);
+                MasterRecord[7] = (Byte)((MasterFlags >> 24) & 0xFF);
+            }
 
             // Initialize partition name
             Byte[] NameBytes = Encoding.UTF8.GetBytes(m_szName);
@@ -1202,10 +1334,11 @@ public bool ListDirectory(String Path)
             // Read master-record
             Byte[] MasterRecord = m_pDisk.Read(m_iSector + MasterRecordSector, 1);
             UInt32 RootBucket = BitConverter.ToUInt32(MasterRecord, 80);
+            Boolean RootHashed = (BitConverter.ToUInt32(MasterRecord, 4) & MFS_MASTERRECORD_HASHEDROOT) != 0;
 
             // Call our recursive function to list everything
             Console.WriteLine("Files in " + Path + ":");
-            ListRecursive(RootBucket, Path);
+            ListRecursive(RootBucket, RootHashed, Path);
             Console.WriteLine("");
 
             // Done
@@ -1232,6 +1365,7 @@ public bool WriteFile(String LocalPath, FileFlags Flags, Byte[] Data)
             Byte[] MasterRecord = m_pDisk.Read(m_iSector + MasterRecordSector, 1);
             UInt32 FreeBucket = BitConverter.ToUInt32(MasterRecord, 76);
             UInt32 RootBucket = BitConverter.ToUInt32(MasterRecord, 80);
+            Boolean RootHashed = (BitConverter.ToUInt32(MasterRecord, 4) & MFS_MASTERRECORD_HASHEDROOT) != 0;
             UInt64 SectorsRequired = 0;
             UInt64 BucketsRequired = 0;
 
@@ -1251,7 +1385,7 @@ public bool WriteFile(String LocalPath, FileFlags Flags, Byte[] Data)
             // Try to locate if the record exists already
             // Because if it exists - then we update it
             // If it does not exist - we then create it
-            MfsRecord nEntry = ListRecursive(RootBucket, LocalPath, false);
+            MfsRecord nEntry = ListRecursive(RootBucket, RootHashed, LocalPath, false);
             if (nEntry != null) {
                 Console.WriteLine("File exists in table, updating");
 
@@ -1342,7 +1476,7 @@ public bool WriteFile(String LocalPath, FileFlags Flags, Byte[] Data)
             else {
                 Console.WriteLine("/" + LocalPath + " is a new " 
                     + (Flags.HasFlag(FileFlags.Directory) ? "directory" : "file"));
-                MfsRecord cInfo = CreateRecursive(RootBucket, LocalPath);
+                MfsRecord cInfo = CreateRecursive(RootBucket, RootHashed, LocalPath);
                 if (cInfo == null) {
                     Console.WriteLine("The creation info returned null, somethings wrong");
                     return false;
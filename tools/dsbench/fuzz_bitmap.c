@@ -0,0 +1,120 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS - Bitmap Fuzzer
+ * - Runs random set, clear and search sequences against the bitmap
+ *   and the block bitmap and validates every search result against
+ *   a bit by bit search
+ */
+
+#include <stdlib.h>
+
+#include <ds/bitmap.h>
+#include <ds/blbitmap.h>
+
+#define BLOCK_SIZE			0x1000
+#define BLOCK_START			0x100000
+
+// Validates that a search result is in range and actually free
+void ValidateFind(Bitmap_t *Bitmap, int Index, int Count)
+{
+	if (Index == -1) {
+		return;
+	}
+	if (Index < 0 || (size_t)(Index + Count) > Bitmap->Capacity
+		|| BitmapAreBitsClear(Bitmap, Index, Count) != 1) {
+		abort();
+	}
+}
+
+// Locates the first free run bit by bit, the reference for the searches
+int ReferenceFind(Bitmap_t *Bitmap, int Start, int End, int Count)
+{
+	for (int i = Start; i + Count <= End; i++) {
+		int k = 0;
+		while (k < Count && !((Bitmap->Data[(i + k) / __BITS] >> ((i + k) % __BITS)) & 1)) {
+			k++;
+		}
+		if (k == Count) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// The first two bytes select the bitmap size, the rest are
+// operations of four bytes: operation, index (16 bit) and count
+int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size)
+{
+	BlockBitmap_t *Blockmap;
+	Bitmap_t *Bitmap;
+	size_t Bytes;
+	int Index, Count;
+
+	if (Size < 2) {
+		return 0;
+	}
+	Bytes = ((((size_t)Data[0] << 8) | Data[1]) % 512 + 1) * 64;
+	Bitmap = BitmapCreate(Bytes);
+	Blockmap = BlockBitmapCreate(BLOCK_START, BLOCK_START + (Bytes * 8 * BLOCK_SIZE), BLOCK_SIZE);
+	if (Bitmap == NULL || Blockmap == NULL) {
+		abort();
+	}
+
+	for (size_t i = 2; i + 3 < Size; i += 4) {
+		Count = (Data[i + 3] % 64) + 1;
+		Index = (int)((((size_t)Data[i + 1] << 8) | Data[i + 2]) % (Bitmap->Capacity - Count + 1));
+		switch (Data[i] % 4) {
+			case 0: {
+				BitmapSetBits(Bitmap, Index, Count);
+				if (BitmapAreBitsSet(Bitmap, Index, Count) != 1) {
+					abort();
+				}
+			} break;
+			case 1: {
+				BitmapClearBits(Bitmap, Index, Count);
+				if (BitmapAreBitsClear(Bitmap, Index, Count) != 1) {
+					abort();
+				}
+			} break;
+			case 2: {
+				int Found = BitmapFindBits(Bitmap, Count);
+				ValidateFind(Bitmap, Found, Count);
+				if (Found != ReferenceFind(Bitmap, 0, (int)Bitmap->Capacity, Count)
+					|| BitmapFindBitsInRange(Bitmap, Index, (int)Bitmap->Capacity, Count)
+						!= ReferenceFind(Bitmap, Index, (int)Bitmap->Capacity, Count)) {
+					abort();
+				}
+			} break;
+			default: {
+				uintptr_t Block = BlockBitmapAllocate(Blockmap, (size_t)Count * BLOCK_SIZE);
+				if (Block != 0) {
+					if (Block < BLOCK_START || BlockBitmapValidateState(Blockmap, Block, 1) != OsSuccess) {
+						abort();
+					}
+					if (Data[i + 1] & 1) {
+						BlockBitmapFree(Blockmap, Block, (size_t)Count * BLOCK_SIZE);
+					}
+				}
+			} break;
+		}
+	}
+	BlockBitmapDestroy(Blockmap);
+	BitmapDestroy(Bitmap);
+	return 0;
+}
@@ -0,0 +1,116 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS - Bytepool Fuzzer
+ * - Runs random allocation sequences against the byte pool, every
+ *   allocation is filled and verified before it is released
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bytepool.h"
+
+#define POOL_SIZE			(256 * 1024)
+#define MAX_LIVE			64
+
+/* Allocation
+ * Keeps track of a live allocation and the pattern it was filled with */
+typedef struct _Allocation {
+	uint8_t			*Buffer;
+	size_t			 Size;
+	uint8_t			 Pattern;
+} Allocation_t;
+
+// Verifies that the allocation still holds its pattern
+void Verify(Allocation_t *Allocation)
+{
+	for (size_t i = 0; i < Allocation->Size; i++) {
+		if (Allocation->Buffer[i] != Allocation->Pattern) {
+			abort();
+		}
+	}
+}
+
+// Each operation is three bytes: operation, slot and size
+int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size)
+{
+	Allocation_t Live[MAX_LIVE];
+	BytePool_t *Pool = NULL;
+	void *Memory = malloc(POOL_SIZE);
+
+	memset(&Live[0], 0, sizeof(Live));
+	bpool(Memory, POOL_SIZE, &Pool);
+	for (size_t i = 0; i + 2 < Size; i += 3) {
+		Allocation_t *Allocation = &Live[Data[i + 1] % MAX_LIVE];
+		size_t Length = ((size_t)Data[i + 2] * 37) + 1;
+
+		if (Allocation->Buffer != NULL) {
+			Verify(Allocation);
+			if (bpoolv(Pool, Memory) != OsSuccess) {
+				abort();
+			}
+		}
+		switch (Data[i] % 3) {
+			case 0: {
+				if (Allocation->Buffer != NULL) {
+					brel(Pool, Allocation->Buffer);
+				}
+				Allocation->Buffer = (uint8_t*)bget(Pool, (ssize_t)Length);
+			} break;
+			case 1: {
+				if (Allocation->Buffer != NULL) {
+					brel(Pool, Allocation->Buffer);
+				}
+				Allocation->Buffer = (uint8_t*)bgetz(Pool, (ssize_t)Length);
+				for (size_t j = 0; Allocation->Buffer != NULL && j < Length; j++) {
+					if (Allocation->Buffer[j] != 0) {
+						abort();
+					}
+				}
+			} break;
+			default: {
+				uint8_t *Buffer = (uint8_t*)bgetr(Pool, Allocation->Buffer, (ssize_t)Length);
+				if (Buffer == NULL) {
+					continue;
+				}
+				for (size_t j = 0; Allocation->Buffer != NULL && j < Length && j < Allocation->Size; j++) {
+					if (Buffer[j] != Allocation->Pattern) {
+						abort();
+					}
+				}
+				Allocation->Buffer = Buffer;
+			} break;
+		}
+		if (Allocation->Buffer != NULL) {
+			Allocation->Size = Length;
+			Allocation->Pattern = Data[i];
+			memset(Allocation->Buffer, Allocation->Pattern, Length);
+		}
+	}
+
+	for (int i = 0; i < MAX_LIVE; i++) {
+		if (Live[i].Buffer != NULL) {
+			Verify(&Live[i]);
+			brel(Pool, Live[i].Buffer);
+		}
+	}
+	free(Pool);
+	free(Memory);
+	return 0;
+}
@@ -0,0 +1,140 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS - Collection Fuzzer
+ * - Runs random operation sequences against the collection and compares
+ *   every result with a plain array model
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <ds/collection.h>
+
+#define MODEL_CAPACITY		512
+
+/* Globals
+ * The model of the collection contents, front to back */
+static int Model[MODEL_CAPACITY];
+static int ModelLength;
+
+// Returns the index of the n'th occurrence of the key in the model
+int ModelFind(int Key, int n)
+{
+	for (int i = 0; i < ModelLength; i++) {
+		if (Model[i] == Key && n-- == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Removes the entry at the given index from the model
+void ModelRemove(int Index)
+{
+	memmove(&Model[Index], &Model[Index + 1], (ModelLength - Index - 1) * sizeof(int));
+	ModelLength--;
+}
+
+// Validates length, order and links of the collection
+void Validate(Collection_t *Collection)
+{
+	CollectionItem_t *Previous = NULL;
+	int Index = 0;
+	if (CollectionLength(Collection) != (size_t)ModelLength) {
+		abort();
+	}
+	foreach(Node, Collection) {
+		if (Index >= ModelLength || Node->Key.Value != Model[Index++] || Node->Prev != Previous) {
+			abort();
+		}
+		Previous = Node;
+	}
+	if (Index != ModelLength) {
+		abort();
+	}
+}
+
+// Each operation is two bytes, the operation and the key
+int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size)
+{
+	Collection_t *Collection = CollectionCreate(KeyInteger);
+	CollectionItem_t *Node;
+	DataKey_t Key;
+	int Index;
+
+	ModelLength = 0;
+	for (size_t i = 0; i + 1 < Size; i += 2) {
+		Key.Value = Data[i + 1] & 0xF;
+		switch (Data[i] % 6) {
+			case 0: {
+				if (ModelLength == MODEL_CAPACITY) {
+					break;
+				}
+				CollectionAppend(Collection, CollectionCreateNode(Key, NULL));
+				Model[ModelLength++] = Key.Value;
+			} break;
+			case 1: {
+				if (ModelLength == MODEL_CAPACITY) {
+					break;
+				}
+				CollectionInsert(Collection, CollectionCreateNode(Key, NULL));
+				memmove(&Model[1], &Model[0], ModelLength * sizeof(int));
+				Model[0] = Key.Value;
+				ModelLength++;
+			} break;
+			case 2: {
+				Node = CollectionPopFront(Collection);
+				if ((Node == NULL) != (ModelLength == 0)) {
+					abort();
+				}
+				if (Node != NULL) {
+					if (Node->Key.Value != Model[0]) {
+						abort();
+					}
+					ModelRemove(0);
+					CollectionDestroyNode(Collection, Node);
+				}
+			} break;
+			case 3: {
+				Index = ModelFind(Key.Value, 0);
+				if ((CollectionRemoveByKey(Collection, Key) == OsSuccess) != (Index != -1)) {
+					abort();
+				}
+				if (Index != -1) {
+					ModelRemove(Index);
+				}
+			} break;
+			case 4: {
+				int n = Data[i + 1] >> 4;
+				Index = ModelFind(Key.Value, n);
+				Node = CollectionGetNodeByKey(Collection, Key, n);
+				if ((Node == NULL) != (Index == -1)
+					|| (Node != NULL && Node->Key.Value != Key.Value)) {
+					abort();
+				}
+			} break;
+			default: {
+				Validate(Collection);
+			} break;
+		}
+	}
+	Validate(Collection);
+	CollectionDestroy(Collection);
+	return 0;
+}
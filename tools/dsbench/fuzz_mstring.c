@@ -0,0 +1,86 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS - MString Fuzzer
+ * - Creates strings from arbitrary data in every input encoding and
+ *   runs the read-only operations on them
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <ds/mstring.h>
+
+static const MStringType_t Types[] = { StrASCII, StrUTF8, StrUTF16, StrUTF32, Latin1 };
+
+// The first byte selects the encoding, the rest is the string data
+int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size)
+{
+	MString_t *String, *Copy, *SubString;
+	uint8_t *Buffer;
+	size_t Length;
+
+	if (Size < 1) {
+		return 0;
+	}
+
+	// Terminate the data for the widest encoding, wide strings
+	// are read a whole character at a time
+	Buffer = (uint8_t*)calloc(1, ((Size + 3) & ~(size_t)3) + 4);
+	memcpy(Buffer, Data + 1, Size - 1);
+	String = MStringCreate(Buffer, Types[Data[0] % 5]);
+	Copy = MStringCreate((void*)MStringRaw(String), StrUTF8);
+	Length = MStringLength(String);
+
+	// The string must be equal to itself and to a copy of itself
+	if (Length != 0 
+		&& (MStringCompare(String, Copy, 0) != MSTRING_FULL_MATCH
+		|| MStringCompare(String, Copy, 1) != MSTRING_FULL_MATCH
+		|| MStringHash(String) != MStringHash(Copy)
+		|| MStringLength(Copy) != Length)) {
+		abort();
+	}
+
+	// Every character must be found at or before its position
+	for (size_t i = 0; i < Length && i < 64; i++) {
+		mchar_t Character = MStringGetCharAt(String, (int)i);
+		int Index = MStringFind(String, Character);
+		if (Index < 0 || Index > (int)i) {
+			abort();
+		}
+		Index = MStringFindReverse(String, Character);
+		if (Index < (int)i) {
+			abort();
+		}
+	}
+
+	if (Length != 0) {
+		SubString = MStringSubString(String, (int)(Length / 2), -1);
+		if (SubString != NULL) {
+			if (MStringLength(SubString) != Length - (Length / 2)) {
+				abort();
+			}
+			MStringDestroy(SubString);
+		}
+	}
+
+	MStringDestroy(Copy);
+	MStringDestroy(String);
+	free(Buffer);
+	return 0;
+}
@@ -0,0 +1,340 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS - Data Structure Benchmark
+ * - Runs the libds and libos containers on the host and prints one
+ *   result line per benchmark
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ds/collection.h>
+#include <ds/bitmap.h>
+#include <ds/blbitmap.h>
+#include <ds/ringbuffer.h>
+#include <ds/mstring.h>
+#include "bytepool.h"
+
+/* Benchmark
+ * Each benchmark receives the scale and returns the number of operations
+ * it performed, the time is measured by the caller */
+typedef struct _Benchmark {
+	const char		*Name;
+	size_t			(*Run)(size_t Scale);
+} Benchmark_t;
+
+/* Globals
+ * Results are accumulated into the sink so nothing is optimized away */
+static volatile size_t Sink = 0;
+static unsigned int RandomState = 0x2545F491;
+
+// Prints usage format of this program
+void PrintUsage(void)
+{
+	printf("Usage:\n"
+		"dsbench [-n scale] [-b name]\n"
+		"  -n  Number of operations per benchmark, default is 100000\n"
+		"  -b  Only runs benchmarks whose name starts with the given name\n");
+}
+
+// Returns a monotonic timestamp in nanoseconds
+double GetTimestamp(void)
+{
+	struct timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return ((double)Time.tv_sec * 1e9) + (double)Time.tv_nsec;
+}
+
+// Xorshift generator, the sequence is the same for every run
+unsigned int Random(void)
+{
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+	return RandomState;
+}
+
+// Creates a collection with integer keys 0 to Count - 1
+Collection_t *CreateCollection(size_t Count)
+{
+	Collection_t *Collection = CollectionCreate(KeyInteger);
+	DataKey_t Key;
+	for (size_t i = 0; i < Count; i++) {
+		Key.Value = (int)i;
+		CollectionAppend(Collection, CollectionCreateNode(Key, NULL));
+	}
+	return Collection;
+}
+
+size_t BenchCollectionAppend(size_t Scale)
+{
+	Collection_t *Collection = CreateCollection(Scale);
+	Sink += CollectionLength(Collection);
+	CollectionDestroy(Collection);
+	return Scale;
+}
+
+size_t BenchCollectionInsert(size_t Scale)
+{
+	Collection_t *Collection = CollectionCreate(KeyInteger);
+	DataKey_t Key;
+	for (size_t i = 0; i < Scale; i++) {
+		Key.Value = (int)i;
+		CollectionInsert(Collection, CollectionCreateNode(Key, NULL));
+	}
+	Sink += CollectionLength(Collection);
+	CollectionDestroy(Collection);
+	return Scale;
+}
+
+// Lookups are linear, so the collection is kept at the size of
+// a busy handle list
+size_t BenchCollectionLookup(size_t Scale)
+{
+	Collection_t *Collection = CreateCollection(4096);
+	DataKey_t Key;
+	for (size_t i = 0; i < Scale; i++) {
+		Key.Value = (int)(Random() % 4096);
+		Sink += (size_t)CollectionGetNodeByKey(Collection, Key, 0);
+	}
+	CollectionDestroy(Collection);
+	return Scale;
+}
+
+size_t BenchCollectionIterate(size_t Scale)
+{
+	Collection_t *Collection = CreateCollection(Scale);
+	foreach(Node, Collection) {
+		Sink += (size_t)Node->Key.Value;
+	}
+	CollectionDestroy(Collection);
+	return Scale;
+}
+
+size_t BenchCollectionPopFront(size_t Scale)
+{
+	Collection_t *Collection = CreateCollection(Scale);
+	CollectionItem_t *Node;
+	while ((Node = CollectionPopFront(Collection)) != NULL) {
+		Sink += (size_t)Node->Key.Value;
+		CollectionDestroyNode(Collection, Node);
+	}
+	CollectionDestroy(Collection);
+	return Scale;
+}
+
+// Fragments the map by setting random runs, then searches for
+// runs of 1, 8 and 64 bits
+size_t BenchBitmapFindBits(size_t Scale)
+{
+	Bitmap_t *Bitmap = BitmapCreate(1024 * 1024);
+	size_t Operations = 0;
+	for (size_t i = 0; i < Bitmap->Capacity / 64; i++) {
+		BitmapSetBits(Bitmap, (int)(Random() % (Bitmap->Capacity - 16)), (int)(Random() % 16) + 1);
+	}
+	for (size_t i = 0; i < Scale / 100; i++) {
+		Sink += (size_t)BitmapFindBits(Bitmap, 1);
+		Sink += (size_t)BitmapFindBits(Bitmap, 8);
+		Sink += (size_t)BitmapFindBits(Bitmap, 64);
+		Operations += 3;
+	}
+	BitmapDestroy(Bitmap);
+	return Operations;
+}
+
+// A map the size of 4gb of pages that is full except for the last
+// megabyte, like the physical memory map of a loaded system
+size_t BenchBitmapFindBitsFull(size_t Scale)
+{
+	Bitmap_t *Bitmap = BitmapCreate(128 * 1024);
+	size_t Operations = 0;
+	BitmapSetBits(Bitmap, 0, (int)Bitmap->Capacity - 256);
+	for (size_t i = 0; i < Scale / 100; i++) {
+		Sink += (size_t)BitmapFindBits(Bitmap, 1);
+		Sink += (size_t)BitmapFindBits(Bitmap, 64);
+		Operations += 2;
+	}
+	BitmapDestroy(Bitmap);
+	return Operations;
+}
+
+// Allocates and frees random sizes while keeping a window of
+// allocations live, like the kernel heap does
+size_t BenchBlockBitmapChurn(size_t Scale)
+{
+	BlockBitmap_t *Blockmap = BlockBitmapCreate(0x100000, 0x10000000, 0x1000);
+	uintptr_t Live[256] = { 0 };
+	size_t Sizes[256] = { 0 };
+	for (size_t i = 0; i < Scale; i++) {
+		int Slot = (int)(Random() % 256);
+		if (Live[Slot] != 0) {
+			BlockBitmapFree(Blockmap, Live[Slot], Sizes[Slot]);
+		}
+		Sizes[Slot] = ((Random() % 16) + 1) * 0x1000;
+		Live[Slot] = BlockBitmapAllocate(Blockmap, Sizes[Slot]);
+	}
+	Sink += (size_t)Blockmap->BlocksAllocated;
+	BlockBitmapDestroy(Blockmap);
+	return Scale;
+}
+
+size_t BenchRingBuffer(size_t Scale)
+{
+	RingBuffer_t *RingBuffer = RingBufferCreate(0x1000);
+	uint8_t Buffer[64];
+	memset(Buffer, 0xAB, sizeof(Buffer));
+	for (size_t i = 0; i < Scale; i++) {
+		RingBufferWrite(RingBuffer, sizeof(Buffer), Buffer);
+		Sink += (size_t)RingBufferRead(RingBuffer, sizeof(Buffer), Buffer);
+	}
+	RingBufferDestroy(RingBuffer);
+	return Scale;
+}
+
+size_t BenchMStringCreate(size_t Scale)
+{
+	for (size_t i = 0; i < Scale; i++) {
+		MString_t *String = MStringCreate((void*)"/System/Themes/Default/Fonts/DejaVuSans.ttf", StrUTF8);
+		Sink += MStringSize(String);
+		MStringDestroy(String);
+	}
+	return Scale;
+}
+
+// Compares paths that share a long prefix, the common case
+// for the filesystem and service lookups
+size_t MStringCompareRun(size_t Scale, int IgnoreCase)
+{
+	MString_t *Strings[4];
+	Strings[0] = MStringCreate((void*)"rd:/System/Drivers/usb/ohci.dll", StrUTF8);
+	Strings[1] = MStringCreate((void*)"rd:/System/Drivers/USB/OHCI.dll", StrUTF8);
+	Strings[2] = MStringCreate((void*)"rd:/System/Drivers/usb/ehci.dll", StrUTF8);
+	Strings[3] = MStringCreate((void*)"rd:/System/Drivers/usb/ohci.dll.map", StrUTF8);
+	for (size_t i = 0; i < Scale; i++) {
+		Sink += (size_t)MStringCompare(Strings[0], Strings[i & 3], IgnoreCase);
+	}
+	for (int i = 0; i < 4; i++) {
+		MStringDestroy(Strings[i]);
+	}
+	return Scale;
+}
+
+size_t BenchMStringCompare(size_t Scale)
+{
+	return MStringCompareRun(Scale, 0);
+}
+
+size_t BenchMStringCompareIgnoreCase(size_t Scale)
+{
+	return MStringCompareRun(Scale, 1);
+}
+
+size_t BenchMStringHash(size_t Scale)
+{
+	MString_t *String = MStringCreate((void*)"rd:/System/Drivers/usb/ohci.dll", StrUTF8);
+	for (size_t i = 0; i < Scale; i++) {
+		Sink += MStringHash(String);
+	}
+	MStringDestroy(String);
+	return Scale;
+}
+
+// Allocates and releases random sizes while keeping a window of
+// allocations live, same pattern as the c-library heap
+size_t BenchBytePoolChurn(size_t Scale)
+{
+	size_t PoolSize = 16 * 1024 * 1024;
+	void *Memory = malloc(PoolSize);
+	void *Live[1024] = { 0 };
+	BytePool_t *Pool = NULL;
+
+	bpool(Memory, (ssize_t)PoolSize, &Pool);
+	for (size_t i = 0; i < Scale; i++) {
+		int Slot = (int)(Random() % 1024);
+		if (Live[Slot] != NULL) {
+			brel(Pool, Live[Slot]);
+		}
+		Live[Slot] = bget(Pool, (ssize_t)((Random() % 512) + 8));
+		Sink += (size_t)Live[Slot];
+	}
+	free(Memory);
+	free(Pool);
+	return Scale;
+}
+
+static Benchmark_t Benchmarks[] = {
+	{ "collection_append", BenchCollectionAppend },
+	{ "collection_insert", BenchCollectionInsert },
+	{ "collection_lookup", BenchCollectionLookup },
+	{ "collection_iterate", BenchCollectionIterate },
+	{ "collection_popfront", BenchCollectionPopFront },
+	{ "bitmap_findbits", BenchBitmapFindBits },
+	{ "bitmap_findbits_full", BenchBitmapFindBitsFull },
+	{ "blockbitmap_churn", BenchBlockBitmapChurn },
+	{ "ringbuffer_rw", BenchRingBuffer },
+	{ "mstring_create", BenchMStringCreate },
+	{ "mstring_compare", BenchMStringCompare },
+	{ "mstring_compare_nocase", BenchMStringCompareIgnoreCase },
+	{ "mstring_hash", BenchMStringHash },
+	{ "bytepool_churn", BenchBytePoolChurn },
+	{ NULL, NULL }
+};
+
+// Entry point, runs each benchmark once for warm-up and once measured
+int main(int argc, char **argv)
+{
+	const char *Filter = NULL;
+	size_t Scale = 100000;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			Scale = (size_t)strtoul(argv[++i], NULL, 0);
+		}
+		else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+			Filter = argv[++i];
+		}
+		else {
+			PrintUsage();
+			return -1;
+		}
+	}
+	if (Scale < 100) {
+		Scale = 100;
+	}
+
+	for (Benchmark_t *Bench = &Benchmarks[0]; Bench->Name != NULL; Bench++) {
+		size_t Operations;
+		double Start, Elapsed;
+		if (Filter != NULL && strncmp(Bench->Name, Filter, strlen(Filter))) {
+			continue;
+		}
+
+		Bench->Run(Scale / 10);
+		RandomState = 0x2545F491;
+		Start = GetTimestamp();
+		Operations = Bench->Run(Scale);
+		Elapsed = GetTimestamp() - Start;
+		printf("dsbench name=%s n=%zu ns_per_op=%.1f ops_per_sec=%.0f\n",
+			Bench->Name, Operations, Elapsed / (double)Operations,
+			((double)Operations * 1e9) / Elapsed);
+	}
+	return 0;
+}
@@ -0,0 +1,233 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS - Checksum Benchmark
+ * - Verifies each crc-32 and sha1 implementation the cpu supports against
+ *   the reference and prints one result line per implementation and size
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <crc32.h>
+#include <os/sha1.h>
+
+#define BUFFER_SIZE		(16 * 1024 * 1024)
+
+/* Benchmark
+ * Each benchmark runs the level on the given size the given number of
+ * times, the time is measured by the caller */
+typedef struct _Benchmark {
+	const char		*Name;
+	const char		*Levels[3];
+	OsStatus_t		(*Select)(int Level);
+	void			(*Run)(size_t Size, size_t Iterations);
+} Benchmark_t;
+
+/* Globals
+ * Results are accumulated into the sink so nothing is optimized away,
+ * the buffer is offset so the implementations see unaligned pointers */
+static volatile uint32_t Sink = 0;
+static uint8_t *Buffer;
+
+// Prints usage format of this program
+void PrintUsage(void)
+{
+	printf("Usage:\n"
+		"hashbench [-n bytes] [-b name]\n"
+		"  -n  Number of bytes processed per benchmark, default is 1GB\n"
+		"  -b  Only runs benchmarks whose name starts with the given name\n");
+}
+
+// Returns a monotonic timestamp in nanoseconds
+double GetTimestamp(void)
+{
+	struct timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return ((double)Time.tv_sec * 1e9) + (double)Time.tv_nsec;
+}
+
+// The byte-wise crc the ramdisk builder used to compute
+uint32_t Crc32Reference(const uint8_t *Data, size_t Length)
+{
+	uint32_t Crc = 0xFFFFFFFF;
+	for (size_t i = 0; i < Length; i++) {
+		Crc ^= (uint32_t)Data[i] << 24;
+		for (int j = 0; j < 8; j++) {
+			Crc = (Crc & 0x80000000) ? (Crc << 1) ^ POLYNOMIAL : (Crc << 1);
+		}
+	}
+	return ~Crc;
+}
+
+// Hashes the data in pieces of the given size
+void Sha1Pieces(const uint8_t *Data, size_t Length, size_t Piece, uint8_t Digest[SHA1_DIGEST_SIZE])
+{
+	Sha1Context_t Context;
+	Sha1Init(&Context, 1);
+	for (size_t i = 0; i < Length; i += Piece) {
+		Sha1Add(&Context, Data + i, (Length - i) < Piece ? (Length - i) : Piece);
+	}
+	Sha1Finalize(&Context, Digest);
+}
+
+// Verifies the crc level against the reference on sizes around the
+// block sizes of the implementations and on every alignment
+int VerifyCrc32(void)
+{
+	for (size_t Length = 0; Length < 1100; Length++) {
+		size_t Offset = Length % 16;
+		if (Crc32Generate(-1, Buffer + Offset, Length) != Crc32Reference(Buffer + Offset, Length)) {
+			printf("hashbench: crc32 mismatch at length %zu\n", Length);
+			return -1;
+		}
+	}
+	if (Crc32Generate(-1, (uint8_t*)"123456789", 9) != 0xFC891918) {
+		printf("hashbench: crc32 check value mismatch\n");
+		return -1;
+	}
+	return 0;
+}
+
+// Verifies the sha1 level against the known digests and against the
+// scalar transform with data added in uneven pieces
+int VerifySha1(int Level)
+{
+	static const uint8_t Abc[SHA1_DIGEST_SIZE] = {
+		0xA9, 0x99, 0x3E, 0x36, 0x47, 0x06, 0x81, 0x6A, 0xBA, 0x3E,
+		0x25, 0x71, 0x78, 0x50, 0xC2, 0x6C, 0x9C, 0xD0, 0xD8, 0x9D
+	};
+	static const uint8_t Long[SHA1_DIGEST_SIZE] = {
+		0x84, 0x98, 0x3E, 0x44, 0x1C, 0x3B, 0xD2, 0x6E, 0xBA, 0xAE,
+		0x4A, 0xA1, 0xF9, 0x51, 0x29, 0xE5, 0xE5, 0x46, 0x70, 0xF1
+	};
+	const char *LongText = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+	uint8_t Digest[SHA1_DIGEST_SIZE], Expected[SHA1_DIGEST_SIZE];
+
+	Sha1Pieces((const uint8_t*)"abc", 3, 64, Digest);
+	if (memcmp(Digest, Abc, SHA1_DIGEST_SIZE)) {
+		printf("hashbench: sha1 digest of abc mismatch\n");
+		return -1;
+	}
+	Sha1Pieces((const uint8_t*)LongText, strlen(LongText), 7, Digest);
+	if (memcmp(Digest, Long, SHA1_DIGEST_SIZE)) {
+		printf("hashbench: sha1 digest of two blocks mismatch\n");
+		return -1;
+	}
+
+	for (size_t Length = 0; Length < 1100; Length += 13) {
+		Sha1Select(SHA1_SCALAR);
+		Sha1Pieces(Buffer + 1, Length, 1100, Expected);
+		Sha1Select(Level);
+		Sha1Pieces(Buffer + 1, Length, 1 + Length % 200, Digest);
+		if (memcmp(Digest, Expected, SHA1_DIGEST_SIZE)) {
+			printf("hashbench: sha1 mismatch at length %zu\n", Length);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+void BenchCrc32(size_t Size, size_t Iterations)
+{
+	for (size_t i = 0; i < Iterations; i++) {
+		Sink += Crc32Generate(-1, Buffer + 1, Size);
+	}
+}
+
+void BenchSha1(size_t Size, size_t Iterations)
+{
+	uint8_t Digest[SHA1_DIGEST_SIZE];
+	for (size_t i = 0; i < Iterations; i++) {
+		Sha1Pieces(Buffer + 1, Size, Size, Digest);
+		Sink += Digest[0];
+	}
+}
+
+static Benchmark_t Benchmarks[] = {
+	{ "crc32", { "slice8", "pclmul", NULL }, Crc32Select, BenchCrc32 },
+	{ "sha1", { "scalar", "ssse3", "shani" }, Sha1Select, BenchSha1 },
+	{ NULL, { NULL }, NULL, NULL }
+};
+
+// Entry point, verifies and runs each benchmark for each level and size
+int main(int argc, char **argv)
+{
+	static const size_t Sizes[] = { 64, 1024, 16384, 262144, BUFFER_SIZE };
+	const char *Filter = NULL;
+	size_t Bytes = 1024 * 1024 * 1024;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			Bytes = (size_t)strtoul(argv[++i], NULL, 0);
+		}
+		else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+			Filter = argv[++i];
+		}
+		else {
+			PrintUsage();
+			return -1;
+		}
+	}
+
+	Buffer = (uint8_t*)malloc(BUFFER_SIZE + 64);
+	if (Buffer == NULL) {
+		printf("hashbench: out of memory\n");
+		return -1;
+	}
+	srand(1);
+	for (size_t i = 0; i < BUFFER_SIZE + 64; i++) {
+		Buffer[i] = (uint8_t)rand();
+	}
+	Crc32GenerateTable();
+
+	for (Benchmark_t *Bench = &Benchmarks[0]; Bench->Name != NULL; Bench++) {
+		if (Filter != NULL && strncmp(Bench->Name, Filter, strlen(Filter))) {
+			continue;
+		}
+		for (int Level = 0; Level < 3 && Bench->Levels[Level] != NULL; Level++) {
+			if (Bench->Select(Level) != OsSuccess) {
+				continue;
+			}
+			if ((Bench->Run == BenchCrc32 && VerifyCrc32())
+				|| (Bench->Run == BenchSha1 && VerifySha1(Level))) {
+				printf("hashbench: %s level=%s failed verification\n",
+					Bench->Name, Bench->Levels[Level]);
+				return -1;
+			}
+			for (size_t i = 0; i < sizeof(Sizes) / sizeof(Sizes[0]); i++) {
+				size_t Iterations = Bytes / Sizes[i];
+				double Start, Elapsed;
+				if (Iterations == 0) {
+					Iterations = 1;
+				}
+
+				Bench->Run(Sizes[i], Iterations / 10 + 1);
+				Start = GetTimestamp();
+				Bench->Run(Sizes[i], Iterations);
+				Elapsed = GetTimestamp() - Start;
+				printf("hashbench name=%s level=%s size=%zu ns_per_op=%.1f gb_per_sec=%.2f\n",
+					Bench->Name, Bench->Levels[Level], Sizes[i], Elapsed / (double)Iterations,
+					((double)Sizes[i] * (double)Iterations) / Elapsed);
+			}
+		}
+	}
+	return 0;
+}
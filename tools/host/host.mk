@@ -0,0 +1,16 @@
+# Definitions shared by the tools that compile os sources for the host
+# machine (benchmarks and fuzzers). The crtdefs.h in include/ replaces the
+# one in librt so the host c-library can be used together with the librt
+# headers. Use HOST_ARCH="-m32 -D_X86_32" to build for 32 bit.
+HOST_DIR := $(dir $(lastword $(MAKEFILE_LIST)))
+
+HOST_CC ?= clang
+HOST_CXX ?= clang++
+HOST_ARCH ?= -D_X86_64
+
+HOST_INCLUDES = -I$(HOST_DIR)include -idirafter $(HOST_DIR)../../librt/include
+HOST_CFLAGS = -O2 $(HOST_ARCH) $(HOST_INCLUDES)
+HOST_FUZZFLAGS = -g -O1 -fsanitize=fuzzer,address $(HOST_ARCH) $(HOST_INCLUDES)
+
+# Replaces the assembly parts of librt
+HOST_SOURCES = $(HOST_DIR)spinlock.c
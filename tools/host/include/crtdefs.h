@@ -0,0 +1,72 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS - Host C-Runtime Definitions
+ * - Replaces crtdefs.h when os sources are compiled for the host. Only the
+ *   export and annotation macros are defined, the types come from the host
+ *   c-library. Use with -Iinclude -idirafter ../../librt/include
+ */
+
+#ifndef _INC_CRTDEFS
+#define _INC_CRTDEFS
+
+#include <sys/types.h>
+#include <stddef.h>
+
+#define __CRT_INLINE	__inline
+#define _CRTIMP
+
+#ifndef __EXTERN
+#define __EXTERN		extern
+#endif
+#ifndef __CONST
+#define __CONST			const
+#endif
+
+#ifdef __cplusplus
+#define _CODE_BEGIN		extern "C" {
+#define _CODE_END		}
+#else
+#define _CODE_BEGIN
+#define _CODE_END
+#endif
+
+/* Everything is linked statically into the host program */
+#define SERVICEAPI		static __inline
+#define SERVICEABI
+#define KERNELAPI		__EXTERN
+#define KERNELABI
+#define MOSAPI			__EXTERN
+#define MOSABI
+
+#define PACKED_STRUCT(name, body) struct name body __attribute__((packed))
+#define PACKED_TYPESTRUCT(name, body) typedef struct _##name body name##_t __attribute__((packed))
+#define PACKED_ATYPESTRUCT(opts, name, body) typedef opts struct _##name body name##_t __attribute__((packed))
+
+#ifndef _CRT_UNUSED
+#define _CRT_UNUSED(x) (void)x
+#endif
+
+#define _Check_return_
+#define _In_
+#define _In_Opt_
+#define _Out_
+#define _Out_Opt_
+#define _InOut_
+
+#endif //!_INC_CRTDEFS
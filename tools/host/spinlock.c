@@ -0,0 +1,51 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS - Host Spinlock Implementation
+ * - Replaces arch/_spinlock.s when librt is compiled for the host
+ */
+
+/* Includes 
+ * - System */
+#include <os/spinlock.h>
+
+/* _spinlock_acquire
+ * Busy-waits for the lock, returns 1 when the lock is held */
+int _spinlock_acquire(Spinlock_t *Spinlock)
+{
+	while (__atomic_exchange_n(Spinlock, 1, __ATOMIC_ACQUIRE) != 0) {
+		while (__atomic_load_n(Spinlock, __ATOMIC_RELAXED) != 0) {
+			__builtin_ia32_pause();
+		}
+	}
+	return 1;
+}
+
+/* _spinlock_test
+ * Tries to take the lock once, returns 1 if the lock was taken */
+int _spinlock_test(Spinlock_t *Spinlock)
+{
+	return (__atomic_exchange_n(Spinlock, 1, __ATOMIC_ACQUIRE) == 0) ? 1 : 0;
+}
+
+/* _spinlock_release
+ * Releases the lock */
+void _spinlock_release(Spinlock_t *Spinlock)
+{
+	__atomic_store_n(Spinlock, 0, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,225 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS - Macia Interpreter Benchmark
+ * - Compiles Macia programs on the host and runs each of them repeatedly,
+ *   one result line is printed per program. Each program states its
+ *   expected result in its header as "Result: <value>", which is checked
+ *   against the first global after the first and the last run
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include "Lexer/Scanner.h"
+#include "Parser/Parser.h"
+#include "Generator/Generator.h"
+#include "Interpreter/Interpreter.h"
+
+#ifdef MACIA_THREADED_DISPATCH
+#define DISPATCH_NAME "threaded"
+#else
+#define DISPATCH_NAME "switch"
+#endif
+
+// Prints usage format of this program
+void PrintUsage(void)
+{
+	printf("Usage:\n"
+		"maciabench [-n runs] program.mc [program.mc ...]\n"
+		"  -n  Number of times each program is run, default is 100000\n"
+		"  The benchmark programs are in userspace/Applications/Macia/Examples/Benchmarks\n");
+}
+
+// Returns a monotonic timestamp in nanoseconds
+double GetTimestamp(void)
+{
+	struct timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return ((double)Time.tv_sec * 1e9) + (double)Time.tv_nsec;
+}
+
+// Reads the entire file into a new buffer
+char *ReadFile(const char *Path, size_t *Length)
+{
+	FILE *Source = fopen(Path, "rb");
+	char *Data = NULL;
+	if (Source == NULL) {
+		return NULL;
+	}
+
+	fseek(Source, 0, SEEK_END);
+	*Length = (size_t)ftell(Source);
+	fseek(Source, 0, SEEK_SET);
+	Data = (char*)malloc(*Length + 1);
+	if (Data != NULL && fread(Data, 1, *Length, Source) != *Length) {
+		free(Data);
+		Data = NULL;
+	}
+	fclose(Source);
+	return Data;
+}
+
+// Reads the expected result from the program header, which is
+// either an integer or a quoted string
+const char *GetExpected(const char *Data)
+{
+	const char *Expected = strstr(Data, "Result: ");
+	return (Expected != NULL) ? Expected + 8 : NULL;
+}
+
+// Compares the first global with the expected result
+int CheckResult(Interpreter *Vm, const char *Expected, const char *Path)
+{
+	const std::vector<Value_t> &Globals = Vm->GetGlobals();
+	const char *End;
+
+	if (Globals.empty()) {
+		printf("%s has no result global\n", Path);
+		return -1;
+	}
+	if (Expected[0] == '"') {
+		End = strchr(Expected + 1, '"');
+		if (End != NULL && Globals[0].Type == ValueString
+			&& strlen(Globals[0].String) == (size_t)(End - Expected - 1)
+			&& !strncmp(Globals[0].String, Expected + 1, End - Expected - 1)) {
+			return 0;
+		}
+	}
+	else if (Globals[0].Type == ValueInteger
+		&& Globals[0].Integer == (int)strtol(Expected, NULL, 0)) {
+		return 0;
+	}
+	printf("%s produced the wrong result, expected %.*s but got ", Path,
+		(int)strcspn(Expected, " \r\n*"), Expected);
+	if (Globals[0].Type == ValueInteger) {
+		printf("%i\n", Globals[0].Integer);
+	}
+	else if (Globals[0].Type == ValueString) {
+		printf("\"%s\"\n", Globals[0].String);
+	}
+	else {
+		printf("a value of type %i\n", (int)Globals[0].Type);
+	}
+	return -1;
+}
+
+// Compiles the program and runs it, the first run also
+// prepares the program and is not measured
+int RunProgram(const char *Path, size_t Runs)
+{
+	Scanner Scan;
+	Parser *Parse = NULL;
+	Generator *Gen = NULL;
+	Interpreter *Vm = NULL;
+	size_t Length = 0;
+	char *Data = ReadFile(Path, &Length);
+	const char *Expected = NULL;
+	int Result = -1;
+	double Start, Elapsed;
+	size_t Code = 0;
+
+	if (Data == NULL) {
+		printf("Failed to read %s\n", Path);
+		return -1;
+	}
+	Data[Length] = '\0';
+	Expected = GetExpected(Data);
+	if (Expected == NULL) {
+		printf("%s does not state its expected result\n", Path);
+		goto Cleanup;
+	}
+	if (Scan.Scan(Data, Length)) {
+		printf("Failed to scan %s\n", Path);
+		goto Cleanup;
+	}
+
+	Parse = new Parser(Scan.GetElements());
+	if (Parse->Parse()) {
+		printf("Failed to parse %s\n", Path);
+		goto Cleanup;
+	}
+
+	Gen = new Generator(Parse->GetProgram());
+	if (Gen->Generate()) {
+		printf("Failed to generate code for %s\n", Path);
+		goto Cleanup;
+	}
+	Code = Gen->GetCode().size() / sizeof(Instruction_t);
+
+	Vm = new Interpreter(Gen->GetPool());
+	if (Vm->Execute()) {
+		printf("Failed to execute %s\n", Path);
+		goto Cleanup;
+	}
+	if (CheckResult(Vm, Expected, Path)) {
+		goto Cleanup;
+	}
+
+	Start = GetTimestamp();
+	for (size_t i = 0; i < Runs; i++) {
+		if (Vm->Execute()) {
+			printf("Failed to execute %s\n", Path);
+			goto Cleanup;
+		}
+	}
+	Elapsed = GetTimestamp() - Start;
+	if (CheckResult(Vm, Expected, Path)) {
+		goto Cleanup;
+	}
+	printf("maciabench name=%s dispatch=%s instructions=%zu n=%zu ns_per_run=%.1f runs_per_sec=%.0f\n",
+		Path, DISPATCH_NAME, Code, Runs, Elapsed / (double)Runs, ((double)Runs * 1e9) / Elapsed);
+	Result = 0;
+
+Cleanup:
+	delete Vm;
+	delete Gen;
+	delete Parse;
+	free(Data);
+	return Result;
+}
+
+// Entry point, runs each program given
+int main(int argc, char **argv)
+{
+	size_t Runs = 100000;
+	int Programs = 0;
+	int Result = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			Runs = (size_t)strtoul(argv[++i], NULL, 0);
+		}
+		else if (argv[i][0] == '-') {
+			PrintUsage();
+			return -1;
+		}
+		else {
+			Result |= RunProgram(argv[i], Runs);
+			Programs++;
+		}
+	}
+
+	if (Programs == 0) {
+		PrintUsage();
+		return -1;
+	}
+	return Result;
+}
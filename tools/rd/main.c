@@ -11,8 +11,11 @@
 #include <dirent.h>
 #include <sys/stat.h>
 
+// The crc is shared with the kernel that verifies it
+#include <crc32.h>
+
+#undef PACKED_TYPESTRUCT
 #define PACKED_TYPESTRUCT(name, body) typedef struct __attribute__((packed)) _##name body name##_t
-#define POLYNOMIAL 0x04c11db7L      // Standard CRC-32 ppolynomial
 
 /* MCoreRamDiskHeader
  * The ramdisk header, this is present in the 
@@ -49,14 +52,47 @@ PACKED_TYPESTRUCT(MCoreRamDiskModuleHeader, {
     uint32_t    DeviceSubType;
 });
 
+/* MCoreRamDiskIndexHeader
+ * The data of the index entry, it's followed by the specific 
+ * (vendor/device) records and then the generic (class/subclass) records. */
+PACKED_TYPESTRUCT(MCoreRamDiskIndexHeader, {
+    uint32_t    SpecificCount;
+    uint32_t    GenericCount;
+});
+
+/* MCoreRamDiskIndexRecord
+ * Records are sorted by the key pair and then by entry, the entry
+ * is the position of the module in the entry table. */
+PACKED_TYPESTRUCT(MCoreRamDiskIndexRecord, {
+    uint32_t    Primary;
+    uint32_t    Secondary;
+    uint32_t    Entry;
+});
+
 // Statics
-uint32_t CrcTable[256] = { 0 };
 MCoreRamDiskHeader_t RdHeaderStatic = {
 	0x3144524D,
 	0x00000001,
 	0, 0
 };
 
+// Orders index records by key pair and then entry position
+static int CompareRecords(const void *a, const void *b)
+{
+	const MCoreRamDiskIndexRecord_t *ra = (const MCoreRamDiskIndexRecord_t*)a;
+	const MCoreRamDiskIndexRecord_t *rb = (const MCoreRamDiskIndexRecord_t*)b;
+	if (ra->Primary != rb->Primary) {
+		return ra->Primary < rb->Primary ? -1 : 1;
+	}
+	if (ra->Secondary != rb->Secondary) {
+		return ra->Secondary < rb->Secondary ? -1 : 1;
+	}
+	if (ra->Entry != rb->Entry) {
+		return ra->Entry < rb->Entry ? -1 : 1;
+	}
+	return 0;
+}
+
 // Prints usage format of this program
 static void ShowSyntax(void)
 {
@@ -64,51 +100,6 @@ static void ShowSyntax(void)
            "    Build    :  rd <arch> <output>\n\n");
 }
 
-/* Crc32GenerateTable
- * Generates a dynamic crc-32 table. */
-void
-Crc32GenerateTable(void)
-{
-    // Variables
-    register uint32_t CrcAccumulator;
-    register int i, j;
-
-    // Iterate and fill the table
-    for (i=0;  i < 256; i++) {
-        CrcAccumulator = ((uint32_t) i << 24);
-        for (j = 0;  j < 8;  j++) {
-            if (CrcAccumulator & 0x80000000L) {
-                CrcAccumulator = (CrcAccumulator << 1) ^ POLYNOMIAL;
-            }
-            else {
-                CrcAccumulator = (CrcAccumulator << 1);
-            }
-        }
-        CrcTable[i] = CrcAccumulator;
-    }
-}
-
-/* Crc32Generate
- * Generates an crc-32 checksum from the given accumulator and
- * the given data. */
-uint32_t
-Crc32Generate(
-    uint32_t CrcAccumulator, 
-    uint8_t *DataPointer, 
-    size_t DataSize)
-{
-    // Variables
-    register size_t i, j;
-
-    // Iterate each byte and accumulate crc
-    for (j = 0; j < DataSize; j++) {
-        i = ((int) (CrcAccumulator >> 24) ^ *DataPointer++) & 0xFF;
-        CrcAccumulator = (CrcAccumulator << 8) ^ CrcTable[i];
-    }
-    CrcAccumulator = ~CrcAccumulator;
-    return CrcAccumulator;
-}
-
 // Determines if a file has a corresponding driver descriptor
 static FILE *GetDriver(const char *path)
 {
@@ -230,6 +221,10 @@ int main(int argc, char *argv[])
 	long fdatapos = 0;
 	char **tokens;
 	int tokencount;
+	MCoreRamDiskIndexHeader_t indexheader = { 0 };
+	MCoreRamDiskIndexRecord_t *specific = NULL;
+	MCoreRamDiskIndexRecord_t *generic = NULL;
+	uint32_t entryindex = 0;
 
 	// Print header
 	printf("MollenOS Ramdisk Builder\n"
@@ -273,8 +268,11 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	// Rewind
+	// Rewind, the last entry is the index
 	rewinddir(dfd);
+	specific = (MCoreRamDiskIndexRecord_t*)calloc(RdHeaderStatic.FileCount + 1, sizeof(MCoreRamDiskIndexRecord_t));
+	generic = (MCoreRamDiskIndexRecord_t*)calloc(RdHeaderStatic.FileCount + 1, sizeof(MCoreRamDiskIndexRecord_t));
+	RdHeaderStatic.FileCount++;
 
     // Write header
     printf("Generating ramdisk header\n");
@@ -423,11 +421,45 @@ int main(int argc, char *argv[])
 			fflush(out);
 			free(dataptr);
 
+			// Add to the index, every entry is generic but only
+			// entries with a vendor are specific
+			if (vendorid != 0) {
+				specific[indexheader.SpecificCount].Primary = vendorid;
+				specific[indexheader.SpecificCount].Secondary = deviceid;
+				specific[indexheader.SpecificCount].Entry = entryindex;
+				indexheader.SpecificCount++;
+			}
+			generic[indexheader.GenericCount].Primary = dclass;
+			generic[indexheader.GenericCount].Secondary = dsubclass;
+			generic[indexheader.GenericCount].Entry = entryindex;
+			indexheader.GenericCount++;
+			entryindex++;
+
 			// Update data
 			fdatapos = ftell(out);
 		}
 	}
 
+	// Write the index entry and the sorted records
+	printf("Generating ramdisk index (%u specific, %u generic)\n",
+		indexheader.SpecificCount, indexheader.GenericCount);
+	qsort(specific, indexheader.SpecificCount, sizeof(MCoreRamDiskIndexRecord_t), CompareRecords);
+	qsort(generic, indexheader.GenericCount, sizeof(MCoreRamDiskIndexRecord_t), CompareRecords);
+	{
+		MCoreRamDiskEntry_t rdentry = { { 0 }, 0 };
+		memcpy(&rdentry.Name[0], "index", 5);
+		rdentry.Type = 0x8;
+		rdentry.DataHeaderOffset = fdatapos;
+		fseek(out, fentrypos, SEEK_SET);
+		fwrite(&rdentry, sizeof(MCoreRamDiskEntry_t), 1, out);
+		fseek(out, fdatapos, SEEK_SET);
+		fwrite(&indexheader, sizeof(MCoreRamDiskIndexHeader_t), 1, out);
+		fwrite(specific, sizeof(MCoreRamDiskIndexRecord_t), indexheader.SpecificCount, out);
+		fwrite(generic, sizeof(MCoreRamDiskIndexRecord_t), indexheader.GenericCount, out);
+	}
+	free(specific);
+	free(generic);
+
 	// Close directory
 	closedir(dfd);
 
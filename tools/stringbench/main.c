@@ -0,0 +1,196 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS - String Primitive Benchmark
+ * - Runs the memory and string primitives of each instruction set the
+ *   cpu supports and prints one result line per primitive and size
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <internal/_stringops.h>
+
+/* Benchmark
+ * Each benchmark runs the primitive on the given size the given
+ * number of times, the time is measured by the caller */
+typedef struct _Benchmark {
+	const char		*Name;
+	void			(*Run)(const StringOperations_t *Operations, size_t Size, size_t Iterations);
+} Benchmark_t;
+
+/* Globals
+ * Results are accumulated into the sink so nothing is optimized away,
+ * the buffers are offset so the primitives see unaligned pointers */
+static volatile size_t Sink = 0;
+static unsigned char *Source;
+static unsigned char *Destination;
+
+// Prints usage format of this program
+void PrintUsage(void)
+{
+	printf("Usage:\n"
+		"stringbench [-n bytes] [-b name]\n"
+		"  -n  Number of bytes processed per benchmark, default is 256MB\n"
+		"  -b  Only runs benchmarks whose name starts with the given name\n");
+}
+
+// Returns a monotonic timestamp in nanoseconds
+double GetTimestamp(void)
+{
+	struct timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return ((double)Time.tv_sec * 1e9) + (double)Time.tv_nsec;
+}
+
+void BenchMemcpy(const StringOperations_t *Operations, size_t Size, size_t Iterations)
+{
+	for (size_t i = 0; i < Iterations; i++) {
+		Sink += (size_t)Operations->Memcpy(Destination + 3, Source + 1, Size);
+	}
+}
+
+void BenchMemmove(const StringOperations_t *Operations, size_t Size, size_t Iterations)
+{
+	for (size_t i = 0; i < Iterations; i++) {
+		Sink += (size_t)Operations->Memmove(Source + 5, Source + 1, Size);
+	}
+}
+
+void BenchMemset(const StringOperations_t *Operations, size_t Size, size_t Iterations)
+{
+	for (size_t i = 0; i < Iterations; i++) {
+		Sink += (size_t)Operations->Memset(Destination + 3, (int)i, Size);
+	}
+}
+
+void BenchMemcmp(const StringOperations_t *Operations, size_t Size, size_t Iterations)
+{
+	memcpy_base(Destination + 3, Source + 1, Size);
+	for (size_t i = 0; i < Iterations; i++) {
+		Sink += (size_t)Operations->Memcmp(Destination + 3, Source + 1, Size);
+	}
+}
+
+void BenchMemchr(const StringOperations_t *Operations, size_t Size, size_t Iterations)
+{
+	memset_base(Source, 'a', Size + 1);
+	Source[Size] = 'b';
+	for (size_t i = 0; i < Iterations; i++) {
+		Sink += (size_t)Operations->Memchr(Source + 1, 'b', Size);
+	}
+}
+
+void BenchStrlen(const StringOperations_t *Operations, size_t Size, size_t Iterations)
+{
+	memset_base(Source, 'a', Size + 1);
+	Source[Size] = '\0';
+	for (size_t i = 0; i < Iterations; i++) {
+		Sink += Operations->Strlen((const char*)Source + 1);
+	}
+}
+
+void BenchStrchr(const StringOperations_t *Operations, size_t Size, size_t Iterations)
+{
+	memset_base(Source, 'a', Size + 1);
+	Source[Size] = '\0';
+	for (size_t i = 0; i < Iterations; i++) {
+		Sink += (size_t)Operations->Strchr((const char*)Source + 1, '/');
+	}
+}
+
+void BenchStrcmp(const StringOperations_t *Operations, size_t Size, size_t Iterations)
+{
+	memset_base(Source, 'a', Size + 1);
+	memset_base(Destination, 'a', Size + 3);
+	Source[Size] = '\0';
+	Destination[Size + 2] = '\0';
+	for (size_t i = 0; i < Iterations; i++) {
+		Sink += (size_t)Operations->Strcmp((const char*)Source + 1, (const char*)Destination + 3);
+	}
+}
+
+static Benchmark_t Benchmarks[] = {
+	{ "memcpy", BenchMemcpy },
+	{ "memmove", BenchMemmove },
+	{ "memset", BenchMemset },
+	{ "memcmp", BenchMemcmp },
+	{ "memchr", BenchMemchr },
+	{ "strlen", BenchStrlen },
+	{ "strchr", BenchStrchr },
+	{ "strcmp", BenchStrcmp },
+	{ NULL, NULL }
+};
+
+// Entry point, runs each benchmark for each level and size
+int main(int argc, char **argv)
+{
+	static const size_t Sizes[] = { 8, 32, 128, 1024, 16384, 262144 };
+	const char *Filter = NULL;
+	size_t Bytes = 256 * 1024 * 1024;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			Bytes = (size_t)strtoul(argv[++i], NULL, 0);
+		}
+		else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+			Filter = argv[++i];
+		}
+		else {
+			PrintUsage();
+			return -1;
+		}
+	}
+
+	Source = (unsigned char*)calloc(1, 262144 + 64);
+	Destination = (unsigned char*)calloc(1, 262144 + 64);
+	if (Source == NULL || Destination == NULL) {
+		printf("stringbench: out of memory\n");
+		return -1;
+	}
+
+	for (Benchmark_t *Bench = &Benchmarks[0]; Bench->Name != NULL; Bench++) {
+		if (Filter != NULL && strncmp(Bench->Name, Filter, strlen(Filter))) {
+			continue;
+		}
+		for (int Level = STRINGOPS_SCALAR; Level <= STRINGOPS_AVX2; Level++) {
+			const StringOperations_t *Operations = StringOperationsSelect(Level);
+			if (Operations == NULL) {
+				continue;
+			}
+			for (size_t i = 0; i < sizeof(Sizes) / sizeof(Sizes[0]); i++) {
+				size_t Iterations = Bytes / Sizes[i];
+				double Start, Elapsed;
+				if (Iterations == 0) {
+					Iterations = 1;
+				}
+
+				Bench->Run(Operations, Sizes[i], Iterations / 10 + 1);
+				Start = GetTimestamp();
+				Bench->Run(Operations, Sizes[i], Iterations);
+				Elapsed = GetTimestamp() - Start;
+				printf("stringbench name=%s level=%s size=%zu ns_per_op=%.1f gb_per_sec=%.2f\n",
+					Bench->Name, Operations->Name, Sizes[i], Elapsed / (double)Iterations,
+					((double)Sizes[i] * (double)Iterations) / Elapsed);
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,256 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS - String Primitive Test
+ * - Runs every primitive of each instruction set the cpu supports against
+ *   the scalar primitive across sizes and alignments. Strings are also
+ *   placed against an unmapped page to catch reads past the page
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <internal/_stringops.h>
+
+#define BUFFER_SIZE		(3 * 65536)
+#define GUARD_SIZE		64
+#define MAX_SMALL		300
+
+/* Globals
+ * Buffers for the results of the primitive being tested and the expected
+ * results from the scalar primitive */
+static unsigned char *Source;
+static unsigned char *Actual;
+static unsigned char *Expected;
+static unsigned int RandomState = 0x2545F491;
+static int Failures = 0;
+
+// Xorshift generator, the sequence is the same for every run
+unsigned int Random(void)
+{
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+	return RandomState;
+}
+
+// Reports a mismatch, only the first few are printed
+void Fail(const StringOperations_t *Operations, const char *Primitive, size_t Size, size_t Offset, size_t Offset2)
+{
+	if (Failures++ < 20) {
+		printf("stringtest FAIL level=%s primitive=%s size=%zu offset=%zu offset2=%zu\n",
+			Operations->Name, Primitive, Size, Offset, Offset2);
+	}
+}
+
+// Returns the sign of a comparison result
+int Sign(int Value)
+{
+	return (Value > 0) - (Value < 0);
+}
+
+// Sizes that are tested, all small sizes and a few around the vector
+// thresholds and loop boundaries of larger ones
+size_t GetSize(int Index)
+{
+	static const size_t Large[] = { 511, 512, 513, 1000, 4095, 4096, 4097, 65536 + 3 };
+	if (Index <= MAX_SMALL) {
+		return (size_t)Index;
+	}
+	Index -= MAX_SMALL + 1;
+	return (Index < (int)(sizeof(Large) / sizeof(Large[0]))) ? Large[Index] : (size_t)-1;
+}
+
+void FillRandom(unsigned char *Buffer, size_t Length)
+{
+	for (size_t i = 0; i < Length; i++) {
+		Buffer[i] = (unsigned char)Random();
+	}
+}
+
+void TestCopy(const StringOperations_t *Operations)
+{
+	size_t Size;
+	for (int i = 0; (Size = GetSize(i)) != (size_t)-1; i++) {
+		for (size_t SrcOffset = 0; SrcOffset < 64; SrcOffset += (Size > MAX_SMALL ? 13 : 1)) {
+			for (size_t DstOffset = 0; DstOffset < 64; DstOffset += (Size > MAX_SMALL ? 11 : 7)) {
+				FillRandom(Source, Size + 128);
+				memset(Actual, 0xA5, Size + 128 + GUARD_SIZE);
+				Operations->Memcpy(Actual + DstOffset, Source + SrcOffset, Size);
+				memset(Expected, 0xA5, Size + 128 + GUARD_SIZE);
+				memcpy_base(Expected + DstOffset, Source + SrcOffset, Size);
+				if (memcmp_base(Actual, Expected, Size + 128 + GUARD_SIZE)) {
+					Fail(Operations, "memcpy", Size, SrcOffset, DstOffset);
+				}
+			}
+		}
+	}
+}
+
+// Moves within one buffer, the distance covers overlaps in both
+// directions and no overlap at all
+void TestMove(const StringOperations_t *Operations)
+{
+	size_t Size;
+	for (int i = 0; (Size = GetSize(i)) != (size_t)-1; i++) {
+		for (long Distance = -140; Distance <= 140; Distance += (Size > MAX_SMALL ? 9 : 1)) {
+			size_t Base = 256 + (Random() & 31);
+			FillRandom(Expected, Size + 1024);
+			memcpy_base(Actual, Expected, Size + 1024);
+			Operations->Memmove(Actual + Base + Distance, Actual + Base, Size);
+			memmove_base(Expected + Base + Distance, Expected + Base, Size);
+			if (memcmp_base(Actual, Expected, Size + 1024)) {
+				Fail(Operations, "memmove", Size, Base, (size_t)Distance);
+			}
+		}
+	}
+}
+
+void TestSet(const StringOperations_t *Operations)
+{
+	size_t Size;
+	for (int i = 0; (Size = GetSize(i)) != (size_t)-1; i++) {
+		for (size_t Offset = 0; Offset < 64; Offset++) {
+			int Value = (int)Random();
+			memset_base(Actual, 0xA5, Size + 64 + GUARD_SIZE);
+			memset_base(Expected, 0xA5, Size + 64 + GUARD_SIZE);
+			Operations->Memset(Actual + Offset, Value, Size);
+			memset_base(Expected + Offset, Value, Size);
+			if (memcmp_base(Actual, Expected, Size + 64 + GUARD_SIZE)) {
+				Fail(Operations, "memset", Size, Offset, 0);
+			}
+		}
+	}
+}
+
+// Compares equal buffers with a single difference at a random
+// position, or none at all
+void TestCompare(const StringOperations_t *Operations)
+{
+	size_t Size;
+	for (int i = 0; (Size = GetSize(i)) != (size_t)-1; i++) {
+		for (size_t Offset = 0; Offset < 64; Offset += (Size > MAX_SMALL ? 5 : 1)) {
+			size_t Offset2 = Random() & 63;
+			FillRandom(Actual + Offset, Size);
+			memcpy_base(Expected + Offset2, Actual + Offset, Size);
+			if (Size != 0 && (Random() & 3)) {
+				Expected[Offset2 + (Random() % Size)] ^= (unsigned char)((Random() & 0xFF) | 1);
+			}
+			if (Operations->Memcmp(Actual + Offset, Expected + Offset2, Size)
+				!= memcmp_base(Actual + Offset, Expected + Offset2, Size)) {
+				Fail(Operations, "memcmp", Size, Offset, Offset2);
+			}
+		}
+	}
+}
+
+void TestFind(const StringOperations_t *Operations)
+{
+	size_t Size;
+	for (int i = 0; (Size = GetSize(i)) != (size_t)-1; i++) {
+		for (size_t Offset = 0; Offset < 64; Offset += (Size > MAX_SMALL ? 5 : 1)) {
+			unsigned char Needle = (unsigned char)Random();
+			for (size_t j = 0; j < Size + 64; j++) {
+				Actual[Offset + j] = (unsigned char)(Random() | 1);
+				if (Actual[Offset + j] == Needle) {
+					Actual[Offset + j] ^= 2;
+				}
+			}
+
+			// The needle is placed inside, just past the end, or not at all
+			if (Random() & 1) {
+				Actual[Offset + (Random() % (Size + 1))] = Needle;
+			}
+			if (Operations->Memchr(Actual + Offset, Needle, Size)
+				!= memchr_base(Actual + Offset, Needle, Size)) {
+				Fail(Operations, "memchr", Size, Offset, 0);
+			}
+		}
+	}
+}
+
+// Strings are placed so they end right before an unmapped page,
+// any read past the page faults
+void TestStrings(const StringOperations_t *Operations, unsigned char *PageEnd)
+{
+	for (size_t Length = 0; Length < 200; Length++) {
+		for (size_t Gap = 0; Gap < 40; Gap++) {
+			char *First = (char*)(PageEnd - Length - 1 - Gap);
+			char *Second = (char*)Actual + (Random() & 63);
+			for (size_t j = 0; j < Length; j++) {
+				First[j] = (char)((Random() % 255) + 1);
+			}
+			First[Length] = '\0';
+			memcpy_base(Second, First, Length + 1);
+			if (Length != 0 && (Random() & 1)) {
+				Second[Random() % Length] ^= (char)((Random() & 0x7F) | 1);
+			}
+
+			if (Operations->Strlen(First) != strlen_base(First)) {
+				Fail(Operations, "strlen", Length, Gap, 0);
+			}
+			if (Sign(Operations->Strcmp(First, Second)) != Sign(strcmp_base(First, Second))
+				|| Sign(Operations->Strcmp(Second, First)) != Sign(strcmp_base(Second, First))) {
+				Fail(Operations, "strcmp", Length, Gap, 0);
+			}
+			for (int k = 0; k < 4; k++) {
+				int Value = (k == 0) ? 0 : (k == 1 && Length) ? (unsigned char)First[Random() % Length] : (int)(Random() & 0xFF);
+				if (Operations->Strchr(First, Value) != strchr_base(First, Value)) {
+					Fail(Operations, "strchr", Length, Gap, (size_t)Value);
+				}
+			}
+		}
+	}
+}
+
+// Entry point, tests each level the cpu supports
+int main(void)
+{
+	long PageSize = sysconf(_SC_PAGESIZE);
+	unsigned char *Pages;
+
+	Source = (unsigned char*)malloc(BUFFER_SIZE);
+	Actual = (unsigned char*)malloc(BUFFER_SIZE);
+	Expected = (unsigned char*)malloc(BUFFER_SIZE);
+	Pages = (unsigned char*)mmap(NULL, (size_t)PageSize * 2, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (Source == NULL || Actual == NULL || Expected == NULL || Pages == MAP_FAILED
+		|| mprotect(Pages + PageSize, (size_t)PageSize, PROT_NONE)) {
+		printf("stringtest: out of memory\n");
+		return -1;
+	}
+
+	for (int Level = STRINGOPS_SSE2; Level <= STRINGOPS_AVX2; Level++) {
+		const StringOperations_t *Operations = StringOperationsSelect(Level);
+		if (Operations == NULL) {
+			printf("stringtest level=%d skipped, not supported by the cpu\n", Level);
+			continue;
+		}
+		TestCopy(Operations);
+		TestMove(Operations);
+		TestSet(Operations);
+		TestCompare(Operations);
+		TestFind(Operations);
+		TestStrings(Operations, Pages + PageSize);
+		printf("stringtest level=%s failures=%d\n", Operations->Name, Failures);
+	}
+	return Failures != 0;
+}
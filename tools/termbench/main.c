@@ -0,0 +1,225 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS - Terminal Benchmark
+ * - Runs the terminal cell grid on the host with a synthetic font
+ *   and prints one result line per benchmark
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "TerminalGrid.h"
+
+#define COLUMNS			80
+#define ROWS			25
+#define GLYPH_WIDTH		8
+#define GLYPH_HEIGHT	16
+#define BORDER			4
+
+/* Benchmark
+ * Each benchmark receives the scale and returns the number of lines
+ * it output, the time is measured by the caller */
+typedef struct _Benchmark {
+	const char		*Name;
+	size_t			(*Run)(size_t Scale);
+} Benchmark_t;
+
+/* Globals
+ * The terminal state shared by the benchmarks, the results are
+ * accumulated into the sink so nothing is optimized away */
+static SDL_TerminalGrid Grid;
+static SDL_TerminalAtlas Atlas;
+static SDL_TerminalTarget Target;
+static SDL_TerminalRGBA Foreground = { 0, 0, 0, 255 };
+static SDL_TerminalRGBA Background = { 0, 0, 0, 0 };
+static volatile size_t Sink = 0;
+static unsigned int RandomState = 0x2545F491;
+
+// Prints usage format of this program
+void PrintUsage(void)
+{
+	printf("Usage:\n"
+		"termbench [-n scale] [-b name]\n"
+		"  -n  Number of lines per benchmark, default is 100000\n"
+		"  -b  Only runs benchmarks whose name starts with the given name\n");
+}
+
+// Returns a monotonic timestamp in nanoseconds
+double GetTimestamp(void)
+{
+	struct timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return ((double)Time.tv_sec * 1e9) + (double)Time.tv_nsec;
+}
+
+// Xorshift generator, the sequence is the same for every run
+unsigned int Random(void)
+{
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+	return RandomState;
+}
+
+// Synthetic font, the coverage is a pattern derived from the character
+// with partial coverage on the edges like an anti-aliased glyph
+int Rasterize(void *Context, unsigned char c, int Style, uint8_t *Coverage, int w, int h)
+{
+	(void)Context;
+	for (int y = 0; y < h; y++) {
+		for (int x = 0; x < w; x++) {
+			unsigned int Bits = ((unsigned int)c * 2654435761u) >> ((x + y) & 15);
+			Coverage[y * w + x] = (Bits & 1) ? 255 : ((Bits & 2) ? 96 : 0);
+		}
+		if ((Style & SDL_TERMINAL_STYLE_UNDERLINE) && y == h - 2) {
+			memset(&Coverage[y * w], 255, (size_t)w);
+		}
+	}
+	return 0;
+}
+
+// Outputs one log line at the bottom row and scrolls, like
+// the terminal does for each newline
+void OutputLine(size_t Line)
+{
+	char Text[COLUMNS + 1];
+	int Length = snprintf(Text, sizeof(Text), 
+		"[%08zu] svc: request %u completed in %u us, status ok ", 
+		Line, Random() % 100000, Random() % 1000);
+	if (Length > COLUMNS) {
+		Length = COLUMNS;
+	}
+	for (int i = 0; i < Length; i++) {
+		SDL_TerminalGridPut(&Grid, i, ROWS - 1, (unsigned char)Text[i], 0, Foreground, Background);
+	}
+	SDL_TerminalGridScroll(&Grid, 1);
+}
+
+size_t BenchLogTail(size_t Scale)
+{
+	for (size_t i = 0; i < Scale; i++) {
+		OutputLine(i);
+		Sink += (size_t)SDL_TerminalGridFlush(&Grid, &Atlas, &Target);
+	}
+	return Scale;
+}
+
+// Flushes once per 16 lines, like a terminal that only
+// presents once per frame
+size_t BenchLogTailBatched(size_t Scale)
+{
+	for (size_t i = 0; i < Scale; i++) {
+		OutputLine(i);
+		if ((i & 15) == 15) {
+			Sink += (size_t)SDL_TerminalGridFlush(&Grid, &Atlas, &Target);
+		}
+	}
+	Sink += (size_t)SDL_TerminalGridFlush(&Grid, &Atlas, &Target);
+	return Scale;
+}
+
+// Redraws every cell for each line, the cost of a scroll that
+// redraws everything
+size_t BenchFullRedraw(size_t Scale)
+{
+	for (size_t i = 0; i < Scale; i++) {
+		OutputLine(i);
+		SDL_TerminalGridInvalidate(&Grid);
+		Sink += (size_t)SDL_TerminalGridFlush(&Grid, &Atlas, &Target);
+	}
+	return Scale;
+}
+
+static Benchmark_t Benchmarks[] = {
+	{ "log_tail", BenchLogTail },
+	{ "log_tail_batched", BenchLogTailBatched },
+	{ "full_redraw", BenchFullRedraw },
+	{ NULL, NULL }
+};
+
+// Entry point, runs each benchmark once for warm-up and once measured
+int main(int argc, char **argv)
+{
+	const char *Filter = NULL;
+	size_t Scale = 100000;
+	int Pitch = (COLUMNS * GLYPH_WIDTH + 2 * BORDER) * 4;
+	int Height = ROWS * GLYPH_HEIGHT + 2 * BORDER;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			Scale = (size_t)strtoul(argv[++i], NULL, 0);
+		}
+		else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+			Filter = argv[++i];
+		}
+		else {
+			PrintUsage();
+			return -1;
+		}
+	}
+	if (Scale < 100) {
+		Scale = 100;
+	}
+
+	// Same layout as the terminal surface, a border around the cells
+	// and the channels in RGBA order
+	memset(&Target, 0, sizeof(Target));
+	Target.pixels = (uint8_t*)calloc((size_t)Height, (size_t)Pitch);
+	Target.pitch = Pitch;
+	Target.x = BORDER;
+	Target.y = BORDER;
+	Target.rshift = 0;
+	Target.gshift = 8;
+	Target.bshift = 16;
+	Target.ashift = 24;
+	if (Target.pixels == NULL
+		|| SDL_TerminalAtlasCreate(&Atlas, GLYPH_WIDTH, GLYPH_HEIGHT, Rasterize, NULL)
+		|| SDL_TerminalGridCreate(&Grid, COLUMNS, ROWS)) {
+		printf("termbench: out of memory\n");
+		return -1;
+	}
+	Grid.background.r = 255;
+	Grid.background.g = 255;
+	Grid.background.b = 255;
+	Grid.background.a = 180;
+
+	for (Benchmark_t *Bench = &Benchmarks[0]; Bench->Name != NULL; Bench++) {
+		size_t Lines;
+		double Start, Elapsed;
+		if (Filter != NULL && strncmp(Bench->Name, Filter, strlen(Filter))) {
+			continue;
+		}
+
+		Bench->Run(Scale / 10);
+		RandomState = 0x2545F491;
+		Start = GetTimestamp();
+		Lines = Bench->Run(Scale);
+		Elapsed = GetTimestamp() - Start;
+		printf("termbench name=%s n=%zu ns_per_line=%.1f lines_per_sec=%.0f\n",
+			Bench->Name, Lines, Elapsed / (double)Lines,
+			((double)Lines * 1e9) / Elapsed);
+	}
+
+	SDL_TerminalGridDestroy(&Grid);
+	SDL_TerminalAtlasDestroy(&Atlas);
+	free(Target.pixels);
+	return 0;
+}
@@ -0,0 +1,171 @@
+/* MollenOS
+ *
+ * Copyright 2011 - 2017, Philip Meulengracht
+ *
+ * This program is free software : you can redistribute it and / or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation ? , either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ * MollenOS - Sapphire Compositor Benchmark
+ * - Runs the compositor headless with N overlapping windows and prints
+ *   one result line per scenario and kernel level
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "compositor.h"
+#include "backends/soft/softrenderer.h"
+
+/* Scenarios */
+#define SCENARIO_FULL       0
+#define SCENARIO_MOVE       1
+#define SCENARIO_COVERED    2
+
+static const char *ScenarioNames[] = { "full", "move", "covered" };
+
+// Prints usage format of this program
+void PrintUsage(void)
+{
+	printf("Usage:\n"
+		"wmbench [-w windows] [-f frames] [-s width height] [-a]\n"
+		"  -a  Makes every other window translucent\n");
+}
+
+// Returns a monotonic timestamp in seconds
+double GetTimestamp(void)
+{
+	struct timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return (double)Time.tv_sec + ((double)Time.tv_nsec / 1e9);
+}
+
+// Creates the windows, they cascade over the screen so each window
+// overlaps the ones below it
+CompositorLayer_t *CreateLayers(int Count, int Width, int Height, int Translucent)
+{
+	CompositorLayer_t *Layers = (CompositorLayer_t*)calloc(Count, sizeof(CompositorLayer_t));
+	for (int i = 0; i < Count; i++) {
+		CompositorLayer_t *Layer = &Layers[i];
+		Layer->Dimensions.w = Width / 2;
+		Layer->Dimensions.h = Height / 2;
+		Layer->Dimensions.x = (i * 37) % (Width - Layer->Dimensions.w);
+		Layer->Dimensions.y = (i * 23) % (Height - Layer->Dimensions.h);
+		Layer->Pitch = ((Layer->Dimensions.w * 4) + 63) & ~63;
+		Layer->Pixels = (uint32_t*)aligned_alloc(64, Layer->Pitch * Layer->Dimensions.h);
+		Layer->Flags = (Translucent && (i & 1)) ? 0 : LAYER_OPAQUE;
+		for (size_t p = 0; p < (Layer->Pitch / 4) * Layer->Dimensions.h; p++) {
+			Layer->Pixels[p] = (Layer->Flags & LAYER_OPAQUE) ? (0xFF000000 | (i * 0x10203)) : 0x80402010;
+		}
+	}
+	return Layers;
+}
+
+// Runs a single scenario and prints the result
+void RunScenario(int Scenario, int Level, int WindowCount, int Frames, 
+	int Width, int Height, int Translucent)
+{
+	Rect_t Screen = { 0, 0, Width, Height };
+	CSoftRenderer Renderer;
+	const PixelOperations_t *Operations = PixelOperationsSelect(Level);
+	if (Operations == NULL || !Renderer.Create(&Screen)) {
+		return;
+	}
+
+	CCompositor Compositor(&Renderer, &Screen);
+	CompositorLayer_t *Layers = CreateLayers(WindowCount, Width, Height, Translucent);
+	CompositorLayer_t **Order = (CompositorLayer_t**)malloc(WindowCount * sizeof(CompositorLayer_t*));
+	for (int i = 0; i < WindowCount; i++) {
+		Order[i] = &Layers[i];
+	}
+
+	// Warm up with a full frame so every buffer is faulted in
+	Compositor.Damage(NULL);
+	Compositor.Compose(Order, WindowCount);
+
+	size_t Pixels = 0;
+	int Culled = 0;
+	double Start = GetTimestamp();
+	for (int Frame = 0; Frame < Frames; Frame++) {
+		if (Scenario == SCENARIO_FULL) {
+			Compositor.Damage(NULL);
+		}
+		else if (Scenario == SCENARIO_MOVE) {
+			// Move the top window back and forth, both the old and
+			// the new position are damaged
+			CompositorLayer_t *Top = Order[WindowCount - 1];
+			Compositor.Damage(&Top->Dimensions);
+			Top->Dimensions.x = (Top->Dimensions.x + 8) % (Width - Top->Dimensions.w);
+			Compositor.Damage(&Top->Dimensions);
+		}
+		else {
+			// The bottom window updates an area that the top window covers
+			Rect_t Area = Order[WindowCount - 1]->Dimensions;
+			Area.w /= 2;
+			Area.h /= 2;
+			Compositor.Damage(&Area);
+		}
+		Compositor.Compose(Order, WindowCount);
+		Pixels += Compositor.GetPixelCount();
+		Culled += Compositor.GetCulledCount();
+	}
+	double Elapsed = GetTimestamp() - Start;
+
+	printf("wmbench scenario=%s kernels=%s windows=%i frames=%i fps=%.1f mpixels_per_sec=%.1f culled_per_frame=%.1f\n",
+		ScenarioNames[Scenario], Renderer.GetOperations()->Name, WindowCount, Frames, (double)Frames / Elapsed,
+		((double)Pixels / 1e6) / Elapsed, (double)Culled / Frames);
+
+	for (int i = 0; i < WindowCount; i++) {
+		free(Layers[i].Pixels);
+	}
+	free(Layers);
+	free(Order);
+}
+
+int main(int argc, char **argv)
+{
+	int WindowCount = 16, Frames = 200, Width = 1920, Height = 1080, Translucent = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-w") && (i + 1) < argc) {
+			WindowCount = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-f") && (i + 1) < argc) {
+			Frames = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-s") && (i + 2) < argc) {
+			Width = atoi(argv[++i]);
+			Height = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-a")) {
+			Translucent = 1;
+		}
+		else {
+			PrintUsage();
+			return -1;
+		}
+	}
+	if (WindowCount <= 0 || Frames <= 0 || Width < 64 || Height < 64) {
+		PrintUsage();
+		return -1;
+	}
+
+	for (int Scenario = SCENARIO_FULL; Scenario <= SCENARIO_COVERED; Scenario++) {
+		for (int Level = PIXELOPS_SCALAR; Level <= PIXELOPS_AVX2; Level++) {
+			RunScenario(Scenario, Level, WindowCount, Frames, Width, Height, Translucent);
+		}
+	}
+	return 0;
+}
@@ -23,6 +23,7 @@
 
 /* Includes */
 #include "Generator.h"
+#include <cstdio>
 
 /* Constructor 
  * Takes an AST for a program */
@@ -43,6 +44,7 @@ Generator::Generator(Statement *AST) {
 
 	/* Store */
 	m_pAST = AST;
+	m_iGlobalScopeId = -1;
 }
 
 /* Destructor 
@@ -61,12 +63,26 @@ Generator::~Generator() {
 	m_pAST = NULL;
 }
 
+/* Retrieves the scope that holds the initializers of
+ * global variables, it's created on first use */
+int Generator::GetGlobalScope() {
+
+	/* Create it? */
+	if (m_iGlobalScopeId == -1) {
+		m_iGlobalScopeId = m_pPool->CreateFunction("__maciaglobals", -1);
+	}
+
+	/* Done */
+	return m_iGlobalScopeId;
+}
+
 /* Generates the entry point for the program 
  * this includes instantiating a new object of 'Program' */
 void Generator::GenerateEntry() {
 
 	/* Variables */
 	int TemporaryRegister = -1;
+	int EntryRegister = -1;
 	int ObjectId = 0;
 	int ConstructorId = 0;
 	int MainId = 0;
@@ -90,29 +106,28 @@ void Generator::GenerateEntry() {
 
 	/* Define the needed variables */
 	VarId = m_pPool->DefineVariable("__entry", Id);
-
-	/* Allocate a register */
-	TemporaryRegister = AllocateRegister();
+	EntryRegister = GetLocalRegister(VarId, Id);
+
+	/* Initialize globals first, the temporary register
+	 * is never written so the invoke has no instance */
+	if (m_iGlobalScopeId != -1) {
+		TemporaryRegister = AllocateRegister();
+		m_pPool->AddInstruction(Id, MACIA_ABX(OpInvoke, TemporaryRegister, 
+			m_pPool->DefineConstant(ConstantCode, m_iGlobalScopeId)));
+		DeallocateRegister(TemporaryRegister);
+	}
 
 	/* Add code */
-	m_pPool->AddOpcode(Id, OpNew);
-	m_pPool->AddCode8(Id, TemporaryRegister);
-	m_pPool->AddCode32(Id, ObjectId);
-
-	m_pPool->AddOpcode(Id, OpStoreAR);
-	m_pPool->AddCode32(Id, VarId);
-	m_pPool->AddCode8(Id, TemporaryRegister);
-
-	m_pPool->AddOpcode(Id, OpInvoke);
-	m_pPool->AddCode8(Id, TemporaryRegister);
-	m_pPool->AddCode32(Id, ConstructorId);
+	m_pPool->AddInstruction(Id, MACIA_ABX(OpNew, EntryRegister,
+		m_pPool->DefineConstant(ConstantCode, ObjectId)));
 
-	m_pPool->AddOpcode(Id, OpInvoke);
-	m_pPool->AddCode8(Id, TemporaryRegister);
-	m_pPool->AddCode32(Id, MainId);
+	if (ConstructorId != -1) {
+		m_pPool->AddInstruction(Id, MACIA_ABX(OpInvoke, EntryRegister,
+			m_pPool->DefineConstant(ConstantCode, ConstructorId)));
+	}
 
-	/* Cleanup */
-	DeallocateRegister(TemporaryRegister);
+	m_pPool->AddInstruction(Id, MACIA_ABX(OpInvoke, EntryRegister,
+		m_pPool->DefineConstant(ConstantCode, MainId)));
 }
 
 /* Generate the bytecode from the AST,
@@ -163,23 +178,22 @@ int Generator::Generate() {
 			DataPtr++;
 		}
 
-		/* Function? */
-		if (Obj->GetType() == CTFunction) {
+		/* Function or object initializer? */
+		if (Obj->GetType() == CTFunction
+			|| Obj->GetType() == CTObject) {
 			
-			/* Write prologue */
-			m_lByteCode.push_back(OpLabel);
-			m_lByteCode.push_back(Itr->first & 0xFF);
-			m_lByteCode.push_back((Itr->first >> 8) & 0xFF);
-			m_lByteCode.push_back((Itr->first >> 16) & 0xFF);
-			m_lByteCode.push_back((Itr->first >> 24) & 0xFF);
-
-			/* Write code */
-			for (int i = 0; i < (int)Obj->GetCode().size(); i++) {
-				m_lByteCode.push_back(Obj->GetCode().at(i));
-			}
-
 			/* Write epilogue */
-			m_lByteCode.push_back(OpReturn);
+			Obj->AddCode(MACIA_ABC(OpReturn, 0, 0, 0));
+
+			/* Write prologue, then the code */
+			Instruction_t Label = MACIA_ABX(OpLabel, 0, Itr->first);
+			for (int i = -1; i < (int)Obj->GetCode().size(); i++) {
+				Instruction_t Instruction = (i == -1) ? Label : Obj->GetCode().at(i);
+				m_lByteCode.push_back(Instruction & 0xFF);
+				m_lByteCode.push_back((Instruction >> 8) & 0xFF);
+				m_lByteCode.push_back((Instruction >> 16) & 0xFF);
+				m_lByteCode.push_back((Instruction >> 24) & 0xFF);
+			}
 		}
 	}
 
@@ -257,6 +271,142 @@ void Generator::DeallocateRegister(int Register) {
 	m_sRegisters[Register] = 0;
 }
 
+/* Resolves an identifier to a variable id, the scope is searched
+ * first and then the scopes that owns it, ending at the globals */
+int Generator::LookupVariable(char *pIdentifier, int ScopeId) {
+
+	/* Walk the scopes outwards */
+	while (1) {
+		int Id = m_pPool->LookupSymbol(pIdentifier, ScopeId);
+		if (Id != -1 && m_pPool->GetObject(Id)->GetType() == CTVariable) {
+			return Id;
+		}
+
+		/* End of chain? */
+		if (ScopeId == -1) {
+			return -1;
+		}
+		ScopeId = m_pPool->GetObject(ScopeId)->GetScopeId();
+	}
+}
+
+/* Returns the register of the variable if it's
+ * a local of the given function scope, otherwise -1 */
+int Generator::GetLocalRegister(int VariableId, int ScopeId) {
+
+	/* Lookup objects */
+	CodeObject *Var = m_pPool->GetObject(VariableId);
+	CodeObject *Scope = m_pPool->GetObject(ScopeId);
+
+	/* Locals are only in functions */
+	if (Var == NULL || Scope == NULL
+		|| Var->GetScopeId() != ScopeId
+		|| Scope->GetType() != CTFunction) {
+		return -1;
+	}
+
+	/* They follow the temporaries */
+	return MACIA_REGISTER_COUNT + Var->GetOffset();
+}
+
+/* Generates code for loading the value of
+ * a variable into the given register */
+void Generator::EmitLoadVariable(int ScopeId, int Register, int VariableId) {
+
+	/* Variables */
+	CodeObject *Var = m_pPool->GetObject(VariableId);
+	int Local = GetLocalRegister(VariableId, ScopeId);
+
+	if (Local != -1) {
+		m_pPool->AddInstruction(ScopeId, MACIA_ABC(OpMove, Register, Local, 0));
+#ifdef DIAGNOSE
+		printf("move $%i, $%i\n", Register, Local);
+#endif
+	}
+	else if (Var->GetScopeId() == -1) {
+		m_pPool->AddInstruction(ScopeId, MACIA_ABX(OpLoadG, Register, Var->GetOffset()));
+#ifdef DIAGNOSE
+		printf("loadg $%i, !%i\n", Register, Var->GetOffset());
+#endif
+	}
+	else {
+		m_pPool->AddInstruction(ScopeId, MACIA_ABC(OpLoadF, Register, Var->GetOffset(), 0));
+#ifdef DIAGNOSE
+		printf("loadf $%i, @%i\n", Register, Var->GetOffset());
+#endif
+	}
+}
+
+/* Generates code for storing the given
+ * register into a variable */
+void Generator::EmitStoreVariable(int ScopeId, int VariableId, int Register) {
+
+	/* Variables */
+	CodeObject *Var = m_pPool->GetObject(VariableId);
+	int Local = GetLocalRegister(VariableId, ScopeId);
+
+	if (Local != -1) {
+		m_pPool->AddInstruction(ScopeId, MACIA_ABC(OpMove, Local, Register, 0));
+#ifdef DIAGNOSE
+		printf("move $%i, $%i\n", Local, Register);
+#endif
+	}
+	else if (Var->GetScopeId() == -1) {
+		m_pPool->AddInstruction(ScopeId, MACIA_ABX(OpStoreG, Register, Var->GetOffset()));
+#ifdef DIAGNOSE
+		printf("storeg $%i, !%i\n", Register, Var->GetOffset());
+#endif
+	}
+	else {
+		m_pPool->AddInstruction(ScopeId, MACIA_ABC(OpStoreF, Var->GetOffset(), Register, 0));
+#ifdef DIAGNOSE
+		printf("storef @%i, $%i\n", Var->GetOffset(), Register);
+#endif
+	}
+}
+
+/* Generates code for loading an integer, small values 
+ * are encoded in the instruction, the rest goes to the pool */
+void Generator::EmitLoadInteger(int ScopeId, int Register, int Value) {
+
+	if (Value >= MACIA_MIN_SBX && Value <= MACIA_MAX_SBX) {
+		m_pPool->AddInstruction(ScopeId, MACIA_ABX(OpLoadI, Register, Value));
+#ifdef DIAGNOSE
+		printf("loadi $%i, [%i]\n", Register, Value);
+#endif
+	}
+	else {
+		int Constant = m_pPool->DefineConstant(ConstantInteger, Value);
+		m_pPool->AddInstruction(ScopeId, MACIA_ABX(OpLoadK, Register, Constant));
+#ifdef DIAGNOSE
+		printf("loadk $%i, k%i ; %i\n", Register, Constant, Value);
+#endif
+	}
+}
+
+/* Selects the register a value for the active reference
+ * should be loaded into, locals are loaded in place */
+int Generator::BeginStore(GenState_t *State) {
+
+	/* Variables */
+	int Register = GetLocalRegister(State->ActiveReference, State->CodeScopeId);
+
+	/* Use a temporary otherwise */
+	if (Register == -1) {
+		Register = AllocateRegister();
+	}
+	return Register;
+}
+
+/* Stores the register from BeginStore in the active 
+ * reference, if it was a temporary */
+void Generator::EndStore(GenState_t *State, int Register) {
+	if (Register < MACIA_REGISTER_COUNT) {
+		EmitStoreVariable(State->CodeScopeId, State->ActiveReference, Register);
+		DeallocateRegister(Register);
+	}
+}
+
 /* The actual statement parser
  * This is the recursive function */
 int Generator::ParseStatement(Statement *pStmt, int ScopeId) {
@@ -368,8 +518,9 @@ int Generator::ParseStatement(Statement *pStmt, int ScopeId) {
 				return -1;
 			}
 
-			/* Setup the GenState */
-			State.CodeScopeId = ScopeId;
+			/* Setup the GenState, initializers of globals
+			 * are gathered in their own function */
+			State.CodeScopeId = (ScopeId == -1) ? GetGlobalScope() : ScopeId;
 			State.ActiveReference = Id;
 
 			/* Parse the expression */
@@ -386,7 +537,7 @@ int Generator::ParseStatement(Statement *pStmt, int ScopeId) {
 			Assignment *Ass = (Assignment*)pStmt;
 
 			/* Lookup the given symbol and get the id */
-			int Id = m_pPool->LookupSymbol(Ass->GetIdentifier(), ScopeId);
+			int Id = LookupVariable(Ass->GetIdentifier(), ScopeId);
 
 			/* Sanity 
 			 * We must find the id */
@@ -423,45 +574,58 @@ int Generator::ParseStatement(Statement *pStmt, int ScopeId) {
 	return 0;
 }
 
-/* Expression Parser */
+/* Expression Parser
+ * Stores the value of the expression in the active reference, 
+ * single values are loaded directly, operations are computed
+ * in a temporary so the reference can be used as an operand */
 int Generator::ParseExpressions(Expression *pExpr, GenState_t *State) {
 
-	/* Setup initial registers */
-	State->ActiveRegister = -1;
-	State->IntermediateRegister = -1;
-	State->GenerateCleanUp = 0;
+	/* Variables */
+	int Register = -1;
 
-	/* Now generate the code */
-	for (int i = 0; i < (int)OperatorGroupCount; i++) {
-		if (ParseExpression(pExpr, State, (OperatorGroup_t)i))
-			return -1;
+	/* Sanity */
+	if (pExpr == NULL) {
+		printf("Missing expression for bytecode generation...\n");
+		return -1;
 	}
 
-	/* Generate cleanup statement? */
-	if (State->GenerateCleanUp) {
-		m_pPool->AddOpcode(State->CodeScopeId, OpStoreAR);
-		m_pPool->AddCode32(State->CodeScopeId, State->ActiveReference);
-		m_pPool->AddCode8(State->CodeScopeId, State->ActiveRegister);
-
-#ifdef DIAGNOSE
-		printf("storear #%i, $%i\n", State->ActiveReference, State->ActiveRegister);
-#endif
+	/* Select the target register */
+	if (pExpr->GetType() == ExprBinary) {
+		Register = AllocateRegister();
+	}
+	else {
+		Register = BeginStore(State);
+	}
+	if (Register == -1) {
+		return -1;
+	}
 
-		/* Deallocate */
-		DeallocateRegister(State->ActiveRegister);
+	/* Now generate the code */
+	if (ParseExpression(pExpr, State, Register)) {
+		return -1;
 	}
 
+	/* Store the result */
+	if (pExpr->GetType() == ExprBinary) {
+		EmitStoreVariable(State->CodeScopeId, State->ActiveReference, Register);
+		DeallocateRegister(Register);
+	}
+	else {
+		EndStore(State, Register);
+	}
 	return 0;
 }
 
-/* This is a recursive expression parser 
- * used for turning AST expressions into bytecode */
-int Generator::ParseExpression(Expression *pExpr, GenState_t *State, OperatorGroup_t Group) {
+/* This is a recursive expression parser used for turning AST 
+ * expressions into bytecode, the value of the expression is
+ * computed into the given register. The left hand is computed
+ * in the register, and the right hand in a new temporary */
+int Generator::ParseExpression(Expression *pExpr, GenState_t *State, int Register) {
 
 	/* Sanity */
-	if (pExpr == NULL
-		|| pExpr->IsSolved()) {
-		return 0;
+	if (pExpr == NULL) {
+		printf("Missing expression for bytecode generation...\n");
+		return -1;
 	}
 
 	/* Determine what kind of expression .. */
@@ -474,50 +638,16 @@ int Generator::ParseExpression(Expression *pExpr, GenState_t *State, OperatorGro
 			Variable *Var = (Variable*)pExpr;
 
 			/* Lookup Id */
-			int Id = m_pPool->LookupSymbol(Var->GetIdentifier(), State->CodeScopeId);
+			int Id = LookupVariable(Var->GetIdentifier(), State->CodeScopeId);
 
-			/* Sanity, don't parse us 
-			 * unless we are asked for non operators */
-			if (Group != OpGroupSingles) {
-				return 0;
+			/* Sanity, it must exist */
+			if (Id == -1) {
+				printf("Unable to find variable with name %s...\n", Var->GetIdentifier());
+				return -1;
 			}
 
 			/* Generate some code */
-			if ((State->IntermediateRegister != -1
-				|| State->ActiveRegister != -1)) {
-
-				/* Select register */
-				int Register = State->IntermediateRegister;
-
-				/* Sanity */
-				if (Register == -1)
-					Register = State->ActiveRegister;
-
-				/* We are working in a temporary register
-				* use appropriate instructions */
-				m_pPool->AddOpcode(State->CodeScopeId, OpLoadRA);
-				m_pPool->AddCode8(State->CodeScopeId, Register);
-				m_pPool->AddCode32(State->CodeScopeId, Id);
-
-#ifdef DIAGNOSE
-				printf("loadra $%i, #%i\n", Register, Id);
-#endif
-			}
-			else {
-
-				/* We are working with a variable reference
-				* use appropriate instructions */
-				m_pPool->AddOpcode(State->CodeScopeId, OpLoadA);
-				m_pPool->AddCode32(State->CodeScopeId, State->ActiveReference);
-				m_pPool->AddCode32(State->CodeScopeId, Id);
-
-#ifdef DIAGNOSE
-				printf("loada #%i, #%i\n", State->ActiveReference, Id);
-#endif
-			}
-
-			/* Set us to solved */
-			pExpr->SetSolved();
+			EmitLoadVariable(State->CodeScopeId, Register, Id);
 
 		} break;
 
@@ -527,51 +657,17 @@ int Generator::ParseExpression(Expression *pExpr, GenState_t *State, OperatorGro
 			/* Cast to correct expression type */
 			StringValue *String = (StringValue*)pExpr;
 
-			/* Define it in our data-pool */
+			/* Define it in our data-pool, strings 
+			 * are loaded from the constant pool */
 			int Id = m_pPool->DefineString(String->GetValue());
-
-			/* Sanity, don't parse us 
-			 * unless we are asked for non operators */
-			if (Group != OpGroupSingles) {
-				return 0;
-			}
+			int Constant = m_pPool->DefineConstant(ConstantString, Id);
 
 			/* Generate some code */
-			if ((State->IntermediateRegister != -1
-				|| State->ActiveRegister != -1)) {
-
-				/* Select register */
-				int Register = State->IntermediateRegister;
-
-				/* Sanity */
-				if (Register == -1)
-					Register = State->ActiveRegister;
-
-				/* We are working in a temporary register
-				* use appropriate instructions */
-				m_pPool->AddOpcode(State->CodeScopeId, OpLoadRA);
-				m_pPool->AddCode8(State->CodeScopeId, Register);
-				m_pPool->AddCode32(State->CodeScopeId, Id);
+			m_pPool->AddInstruction(State->CodeScopeId, MACIA_ABX(OpLoadK, Register, Constant));
 
 #ifdef DIAGNOSE
-				printf("loadra $%i, #%i\n", Register, Id);
+			printf("loadk $%i, k%i ; \"%s\"\n", Register, Constant, String->GetValue());
 #endif
-			}
-			else {
-
-				/* We are working with a variable reference
-				* use appropriate instructions */
-				m_pPool->AddOpcode(State->CodeScopeId, OpLoadA);
-				m_pPool->AddCode32(State->CodeScopeId, State->ActiveReference);
-				m_pPool->AddCode32(State->CodeScopeId, Id);
-
-#ifdef DIAGNOSE
-				printf("loada #%i, #%i\n", State->ActiveReference, Id);
-#endif
-			}
-
-			/* Set us to solved */
-			pExpr->SetSolved();
 
 		} break;
 
@@ -581,48 +677,8 @@ int Generator::ParseExpression(Expression *pExpr, GenState_t *State, OperatorGro
 			/* Cast to correct expression type */
 			IntValue *Int = (IntValue*)pExpr;
 
-			/* Sanity, don't parse us 
-			 * unless we are asked for non operators */
-			if (Group != OpGroupSingles) {
-				return 0;
-			}
-
 			/* Generate some code */
-			if ((State->IntermediateRegister != -1
-				|| State->ActiveRegister != -1)) {
-
-				/* Select register */
-				int Register = State->IntermediateRegister;
-
-				/* Sanity */
-				if (Register == -1)
-					Register = State->ActiveRegister;
-
-				/* We are working in a temporary register
-				* use appropriate instructions */
-				m_pPool->AddOpcode(State->CodeScopeId, OpStoreRI);
-				m_pPool->AddCode8(State->CodeScopeId, Register);
-				m_pPool->AddCode32(State->CodeScopeId, Int->GetValue());
-
-#ifdef DIAGNOSE
-				printf("storeri $%i, [%i]\n", Register, Int->GetValue());
-#endif
-			}
-			else {
-
-				/* We are working with a variable reference
-				* use appropriate instructions */
-				m_pPool->AddOpcode(State->CodeScopeId, OpStoreI);
-				m_pPool->AddCode32(State->CodeScopeId, State->ActiveReference);
-				m_pPool->AddCode32(State->CodeScopeId, Int->GetValue());
-
-#ifdef DIAGNOSE
-				printf("storei #%i, [%i]\n", State->ActiveReference, Int->GetValue());
-#endif
-			}
-
-			/* Set us to solved */
-			pExpr->SetSolved();
+			EmitLoadInteger(State->CodeScopeId, Register, Int->GetValue());
 
 		} break;
 
@@ -631,199 +687,61 @@ int Generator::ParseExpression(Expression *pExpr, GenState_t *State, OperatorGro
 
 			/* Cast to correct expression type */
 			BinaryExpression *BinExpr = (BinaryExpression*)pExpr;
-
-			/* Are we in the correct group? */
-			if (Group == OpGroup3
-				&& (BinExpr->GetOperator() == ExprOperatorDivide
-				|| BinExpr->GetOperator() == ExprOperatorMultiply)) {
-				goto ParseUs;
-			}
-			else if (Group == OpGroup4
-				&& (BinExpr->GetOperator() == ExprOperatorAdd
-				|| BinExpr->GetOperator() == ExprOperatorSubtract)) {
-				goto ParseUs;
-			}
-			else {
-				return ParseExpression(BinExpr->GetExpression2(), State, Group);
+			Opcode_t Operation = OpNone;
+			int Intermediate = -1;
+
+			/* Select the operation */
+			switch (BinExpr->GetOperator()) {
+				case ExprOperatorAdd: Operation = OpAdd; break;
+				case ExprOperatorSubtract: Operation = OpSub; break;
+				case ExprOperatorMultiply: Operation = OpMul; break;
+				case ExprOperatorDivide: Operation = OpDiv; break;
+				default: {
+					printf("Unsupported operator for bytecode generation...\n");
+					return -1;
+				}
 			}
 
-		ParseUs:
-			/* Use previous state if there is any */
-			if (State->ActiveRegister == -1) {
-
-				/* Allocate a temporary register 
-				 * for calculations */
-				State->ActiveRegister = AllocateRegister();
-
-				/*************************************
-				 ***** LEFT - HAND - EVALUATION ******
-				 *************************************/
-
-				/* First of all, if our left hand is a binary expression
-				 * this means we should calculate our left hand tree before
-				 * proceeding. For that we need a new intermediate state */
-				if (BinExpr->GetExpression1()->GetType() == ExprBinary) {
-
-					/* Create a new intermediate state */
-					GenState_t TempEnvironment;
-
-					/* Instantiate it */
-					TempEnvironment.CodeScopeId = State->CodeScopeId;
-					TempEnvironment.IntermediateRegister = -1;
-					TempEnvironment.ActiveReference = -1;
-					TempEnvironment.ActiveRegister = -1;
-					TempEnvironment.GenerateCleanUp = 0;
-
-					/* Parse the left hand */
-					for (int i = 0; i < (int)OperatorGroupCount; i++) {
-						if (ParseExpression(BinExpr->GetExpression1(), &TempEnvironment, (OperatorGroup_t)i))
-							return -1;
-					}
-
-					/* Generate cleanup statement? */
-					if (TempEnvironment.GenerateCleanUp) {
-						m_pPool->AddOpcode(State->CodeScopeId, OpStore);
-						m_pPool->AddCode8(State->CodeScopeId, State->ActiveRegister);
-						m_pPool->AddCode8(State->CodeScopeId, TempEnvironment.ActiveRegister);
-
-#ifdef DIAGNOSE
-						printf("store #%i, $%i\n", State->ActiveRegister, TempEnvironment.ActiveRegister);
-#endif
-
-						/* Deallocate */
-						DeallocateRegister(TempEnvironment.ActiveRegister);
-					}
-
-					/* Mark expression as solved */
-					BinExpr->GetExpression1()->SetSolved();
-				}
-				else {
-					/* Simple stuff actually
-					 * this means we can directly load the left hand value in */
-					if (ParseExpression(BinExpr->GetExpression1(), State, OpGroupSingles)) {
-						return -1;
-					}
-				}
+			/*************************************
+			 ***** LEFT - HAND - EVALUATION ******
+			 *************************************/
 
-				/* Remember to cleanup */
-				State->GenerateCleanUp = 1;
+			/* A missing left hand is a negation */
+			if (BinExpr->GetExpression1() == NULL) {
+				EmitLoadInteger(State->CodeScopeId, Register, 0);
+			}
+			else if (ParseExpression(BinExpr->GetExpression1(), State, Register)) {
+				return -1;
 			}
-
-			/* Allocate an intermediate register */
-			State->IntermediateRegister = AllocateRegister();
 
 			/*************************************
 			 ***** RIGHT - HAND - EVALUATION *****
 			 *************************************/
 
-			/* First of all, if right hand is a binary expression
-			 * we have two cases that can happen, however if it is not
-			 * a binary expression, we have reached end of expression list
-			 * and such it's pretty easy to handle */
-			if (BinExpr->GetExpression2()->GetType() == ExprBinary) {
-				
-				/* For convienance, we need a handle to lower expression
-				 * Cast to correct expression type */
-				BinaryExpression *LowerBinExpr = (BinaryExpression*)BinExpr->GetExpression2();
-
-				/* Now we have two possible cases, either the left hand of
-				 * this expression is actually ALSO a binary expression,
-				 * in which case we actually need to parse it */
-				if (LowerBinExpr->GetExpression1()->GetType() == ExprBinary) {
-					
-					/* Create a temporary environment */
-					GenState_t TempEnvironment;
-
-					/* Deallocate the intermediate register */
-					DeallocateRegister(State->IntermediateRegister);
-
-					/* Instantiate it */
-					TempEnvironment.CodeScopeId = State->CodeScopeId;
-					TempEnvironment.IntermediateRegister = -1;
-					TempEnvironment.ActiveReference = -1;
-					TempEnvironment.ActiveRegister = -1;
-					TempEnvironment.GenerateCleanUp = 0;
-
-					/* Parse the left hand */
-					for (int i = 0; i < (int)OperatorGroupCount; i++) {
-						if (ParseExpression(LowerBinExpr->GetExpression1(), &TempEnvironment, (OperatorGroup_t)i))
-							return -1;
-					}
-
-					/* Update the new intermediate */
-					State->IntermediateRegister = TempEnvironment.ActiveRegister;
-
-					/* Mark expression as solved, skip it forever */
-					LowerBinExpr->GetExpression1()->SetSolved();
-				}
-				else {
-					/* Or, it's simply a single expression in which case it's pretty easy */
-					if (ParseExpression(LowerBinExpr->GetExpression1(), State, OpGroupSingles)) {
-						return -1;
-					}
-				}
+			/* Allocate an intermediate register */
+			Intermediate = AllocateRegister();
+			if (Intermediate == -1) {
+				return -1;
 			}
-			else {
-				/* Ok, end of chain, load second into intermediate 
-				 * generate the last statements */
-				if (ParseExpression(BinExpr->GetExpression2(), State, OpGroupSingles)) {
-					return -1;
-				}
+			if (ParseExpression(BinExpr->GetExpression2(), State, Intermediate)) {
+				return -1;
 			}
 
 			/*************************************
 			 ****** OPERATOR CODE APPENDUM *******
 			 *************************************/
 
-			/* Generate code for both active 
-			 * intermediate code */
-			if (BinExpr->GetOperator() == ExprOperatorAdd) {
-				m_pPool->AddOpcode(State->CodeScopeId, OpAdd);
-				m_pPool->AddCode8(State->CodeScopeId, State->ActiveRegister);
-				m_pPool->AddCode8(State->CodeScopeId, State->IntermediateRegister);
-
-#ifdef DIAGNOSE
-				printf("add $%i, $%i\n", State->ActiveRegister, State->IntermediateRegister);
-#endif
-			}
-			else if (BinExpr->GetOperator() == ExprOperatorSubtract) {
-				m_pPool->AddOpcode(State->CodeScopeId, OpSub);
-				m_pPool->AddCode8(State->CodeScopeId, State->ActiveRegister);
-				m_pPool->AddCode8(State->CodeScopeId, State->IntermediateRegister);
-
-#ifdef DIAGNOSE
-				printf("sub $%i, $%i\n", State->ActiveRegister, State->IntermediateRegister);
-#endif
-			}
-			else if (BinExpr->GetOperator() == ExprOperatorMultiply) {
-				m_pPool->AddOpcode(State->CodeScopeId, OpMul);
-				m_pPool->AddCode8(State->CodeScopeId, State->ActiveRegister);
-				m_pPool->AddCode8(State->CodeScopeId, State->IntermediateRegister);
-
-#ifdef DIAGNOSE
-				printf("mul $%i, $%i\n", State->ActiveRegister, State->IntermediateRegister);
-#endif
-			}
-			else if (BinExpr->GetOperator() == ExprOperatorDivide) {
-				m_pPool->AddOpcode(State->CodeScopeId, OpDiv);
-				m_pPool->AddCode8(State->CodeScopeId, State->ActiveRegister);
-				m_pPool->AddCode8(State->CodeScopeId, State->IntermediateRegister);
+			m_pPool->AddInstruction(State->CodeScopeId, 
+				MACIA_ABC(Operation, Register, Register, Intermediate));
 
 #ifdef DIAGNOSE
-				printf("div $%i, $%i\n", State->ActiveRegister, State->IntermediateRegister);
+			printf("%s $%i, $%i, $%i\n", (Operation == OpAdd) ? "add" : 
+				(Operation == OpSub) ? "sub" : (Operation == OpMul) ? "mul" : "div",
+				Register, Register, Intermediate);
 #endif
-			}
 
 			/* Free the intermediate */
-			DeallocateRegister(State->IntermediateRegister);
-			State->IntermediateRegister = -1;
-
-			/* Recursive down */
-			if (BinExpr->GetExpression2()->GetType() == ExprBinary) {
-				if (ParseExpression(BinExpr->GetExpression2(), State, Group)) {
-					return -1;
-				}
-			}
+			DeallocateRegister(Intermediate);
 
 		} break;
 
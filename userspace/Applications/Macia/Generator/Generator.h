@@ -26,8 +26,9 @@
 #include <cstring>
 #include <cstdlib>
 
-#define MACIA_REGISTER_COUNT	4
+#ifndef MACIA_NO_DIAGNOSE
 #define DIAGNOSE
+#endif
 #define VERSION "0.0.1-dev"
 #define AUTHOR	"Philip Meulengracht"
 
@@ -45,47 +46,12 @@ typedef struct {
 	 * the code too */
 	int CodeScopeId;
 
-	/* This contains things 
-	 * as active register */
-	int ActiveRegister;
-	int IntermediateRegister;
+	/* The variable the expression
+	 * is stored in */
 	int ActiveReference;
 
-	/* If we need cleanup for this
-	 * environment state */
-	int GenerateCleanUp;
-
 } GenState_t;
 
-/* Expression precedence groups */
-typedef enum {
-
-	/* Group 1:
-	 * ++ (suffix), -- (suffix), func(),
-	 * arr[], '.' obj access */
-	OpGroup1,
-
-	/* Group 2:
-	 * ++ (prefix), -- (prefix),
-	 * + (unary), - (unary) */
-	OpGroup2,
-
-	/* Group 3:
-	 * '*, '/', '%' */
-	OpGroup3,
-
-	/* Group 4:
-	 * + (add), - (sub) */
-	OpGroup4,
-
-	/* Singles */
-	OpGroupSingles,
-
-	/* Used for iteration */
-	OperatorGroupCount
-
-} OperatorGroup_t;
-
 /* The generation-class
  * Converts AST into IL Bytecode */
 class Generator
@@ -112,10 +78,22 @@ private:
 	/* Private - Functions */
 	int ParseStatement(Statement *pStmt, int ScopeId);
 	int ParseExpressions(Expression *pExpr, GenState_t *State);
-	int ParseExpression(Expression *pExpr, GenState_t *State, OperatorGroup_t Group);
+	int ParseExpression(Expression *pExpr, GenState_t *State, int Register);
 	int AllocateRegister();
 	void DeallocateRegister(int Register);
 
+	/* Variable access, locals live in the registers
+	 * that follow the temporaries, members and globals
+	 * are accessed with the field and global opcodes */
+	int LookupVariable(char *pIdentifier, int ScopeId);
+	int GetLocalRegister(int VariableId, int ScopeId);
+	void EmitLoadVariable(int ScopeId, int Register, int VariableId);
+	void EmitStoreVariable(int ScopeId, int VariableId, int Register);
+	void EmitLoadInteger(int ScopeId, int Register, int Value);
+	int BeginStore(GenState_t *State);
+	void EndStore(GenState_t *State, int Register);
+
+	int GetGlobalScope();
 	void GenerateEntry();
 
 	/* Private - Data */
@@ -124,4 +102,5 @@ private:
 	std::map<int, int> m_sRegisters;
 	Statement *m_pAST;
 	DataPool *m_pPool;
+	int m_iGlobalScopeId;
 };
\ No newline at end of file
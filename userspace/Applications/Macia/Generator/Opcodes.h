@@ -20,6 +20,37 @@
 */
 #pragma once
 
+/* The instruction format
+ * Every instruction is a single 32 bit word, the opcode is kept
+ * in the low byte followed by the register operands A, B and C.
+ * Instructions that take a constant or an immediate use the upper
+ * 16 bits as one operand Bx instead of B and C */
+typedef unsigned int Instruction_t;
+
+#define MACIA_OPCODE(i)			((Opcode_t)((i) & 0xFF))
+#define MACIA_A(i)				(((i) >> 8) & 0xFF)
+#define MACIA_B(i)				(((i) >> 16) & 0xFF)
+#define MACIA_C(i)				(((i) >> 24) & 0xFF)
+#define MACIA_BX(i)				(((i) >> 16) & 0xFFFF)
+#define MACIA_SBX(i)			((int)(short)(((i) >> 16) & 0xFFFF))
+
+#define MACIA_ABC(Op, A, B, C)	((Instruction_t)(Op) | (((Instruction_t)(A) & 0xFF) << 8) \
+	| (((Instruction_t)(B) & 0xFF) << 16) | (((Instruction_t)(C) & 0xFF) << 24))
+#define MACIA_ABX(Op, A, Bx)	((Instruction_t)(Op) | (((Instruction_t)(A) & 0xFF) << 8) \
+	| (((Instruction_t)(Bx) & 0xFFFF) << 16))
+
+/* Registers below this are temporaries for
+ * expressions, locals of a function follow them */
+#define MACIA_REGISTER_COUNT	4
+
+#define MACIA_MAX_BX			0xFFFF
+#define MACIA_MIN_SBX			-32768
+#define MACIA_MAX_SBX			32767
+
+/* Operand legend
+ * $ is a register in the frame, k is an index into the 
+ * constant pool, @ is a field of the current object and 
+ * ! is a global slot */
 typedef enum {
 
 	/* Unknown 
@@ -27,32 +58,28 @@ typedef enum {
 	OpNone			= 0x00,
 
 	/* Special Functions */
-	OpLabel,					//(5) label #id
-	OpNew,						//(5) new $, #id
-	OpInvoke,					//(5) invoke #id
-	OpReturn,					//(1) return
+	OpLabel,					// label #id (object files only)
+	OpNew,						// new $a, k
+	OpInvoke,					// invoke $a, k
+	OpReturn,					// return
 
-	/* Store Opcodes */
-	OpStore,					//(3) store $, $
-	OpStoreAR,					//(6) storear #id, $
-	OpStoreI,					//(9) storei #id, [val]
-	OpStoreRI,					//(5) storeir $, [val]
+	/* Load & Store Opcodes */
+	OpMove,						// move $a, $b
+	OpLoadI,					// loadi $a, [sbx]
+	OpLoadK,					// loadk $a, k
+	OpLoadF,					// loadf $a, @b
+	OpStoreF,					// storef @a, $b
+	OpLoadG,					// loadg $a, !bx
+	OpStoreG,					// storeg $a, !bx
 
-	/* Load Opcodes */
-	OpLoadA,					//(9) load #target_id, #source_id
-	OpLoadRA,					//(5) load $, #source_id
+	/* Arithmetics */
+	OpAdd,						// add $a, $b, $c
+	OpSub,						// sub $a, $b, $c
+	OpMul,						// mul $a, $b, $c
+	OpDiv,						// div $a, $b, $c
+	OpRem,						// rem $a, $b, $c
 
+	/* Used for iteration */
+	OpCount
 
-	/* Arithmetics */
-	OpAdd,						//(3) add $, $
-	OpAddRA,					//(6) addra #id, $
-	OpDiv,						//(3) div $, $
-	OpDivRA,					//(6) divra #id, $
-	OpSub,						//(3) sub $, $
-	OpSubRA,					//(6) subra #id, $
-	OpRem,						//(3) rem $
-	OpRemRA,					//(6) remra $
-	OpMul,						//(3) mul $, $
-	OpMulRA						//(6) mulra #id, $
-
-} Opcode_t;
\ No newline at end of file
+} Opcode_t;
@@ -23,26 +23,185 @@
 
 /* Includes */
 #include "Interpreter.h"
+#include <cstdio>
 
 /* Constructor 
  * Save the data given for execution 
  * and setup vm */
 Interpreter::Interpreter(DataPool *pPool) {
 	m_pPool = pPool;
+	m_iPrepared = 0;
+	m_pEntry = NULL;
+
+	/* Allocate the machine */
+	m_pFrames = (MachineFrame_t*)malloc(sizeof(MachineFrame_t) * MACIA_FRAME_COUNT);
+	m_pArena = (Value_t*)malloc(sizeof(Value_t) * MACIA_ARENA_SIZE);
 }
 
 /* Destructor 
  * Cleanup Vm */
 Interpreter::~Interpreter() {
 
+	/* Cleanup the prepared program */
+	for (std::map<int, MachineFunction_t*>::iterator Itr = m_sFunctions.begin();
+		Itr != m_sFunctions.end(); ++Itr) {
+		delete Itr->second;
+	}
+	m_sFunctions.clear();
+
+	/* Cleanup the machine */
+	free(m_pFrames);
+	free(m_pArena);
 }
 
-/* The execution, it returns 
- * when code runs out */
-int Interpreter::Execute() {
+/* Retrieves the machine function for the given 
+ * code object, it's created on first lookup */
+MachineFunction_t *Interpreter::GetFunction(int Id) {
+
+	/* Variables */
+	std::map<int, MachineFunction_t*>::iterator Itr = m_sFunctions.find(Id);
+	MachineFunction_t *Function = NULL;
+	CodeObject *Obj = NULL;
+
+	/* Already prepared? */
+	if (Itr != m_sFunctions.end()) {
+		return Itr->second;
+	}
+
+	/* Only functions and objects have code */
+	Obj = m_pPool->GetObject(Id);
+	if (Obj == NULL || (Obj->GetType() != CTFunction
+		&& Obj->GetType() != CTObject)) {
+		return NULL;
+	}
+
+	/* Create it, objects are their own owner as their
+	 * code is the initializer of the fields */
+	Function = new MachineFunction_t;
+	Function->Source = Obj;
+	Function->Owner = NULL;
+	Function->Code = Obj->GetCode().empty() ? NULL : &Obj->GetCode()[0];
+	Function->Length = Obj->GetCode().size();
+	Function->RegisterCount = MACIA_REGISTER_COUNT;
+	Function->FieldCount = 0;
+
+	if (Obj->GetType() == CTObject) {
+		Function->Owner = Obj;
+	}
+	else {
+		Function->Owner = m_pPool->GetObject(Obj->GetScopeId());
+		if (Function->Owner != NULL && Function->Owner->GetType() != CTObject) {
+			Function->Owner = NULL;
+		}
+		Function->RegisterCount += Obj->GetVariableCount();
+	}
+
+	if (Function->Owner != NULL) {
+		Function->FieldCount = Function->Owner->GetVariableCount();
+	}
+
+	/* Store */
+	m_sFunctions[Id] = Function;
+	return Function;
+}
+
+/* Verifies all operands of the function so the 
+ * execution loop does not have to check them */
+int Interpreter::Verify(MachineFunction_t *Function) {
+
+	/* Variables */
+	unsigned Registers = (unsigned)Function->RegisterCount;
+	unsigned Fields = (unsigned)Function->FieldCount;
+	unsigned Globals = (unsigned)m_lGlobals.size();
+	unsigned Constants = (unsigned)m_lConstants.size();
+
+	/* Operands are 8 bits */
+	if (Registers > 256) {
+		printf("Too many variables in %s\n", Function->Source->GetPath());
+		return -1;
+	}
+
+	/* Code must end by returning */
+	if (Function->Length == 0
+		|| MACIA_OPCODE(Function->Code[Function->Length - 1]) != OpReturn) {
+		printf("Missing return in %s\n", Function->Source->GetPath());
+		return -1;
+	}
+
+	/* Check each instruction */
+	for (size_t i = 0; i < Function->Length; i++) {
+		Instruction_t Instruction = Function->Code[i];
+		unsigned A = MACIA_A(Instruction);
+		unsigned B = MACIA_B(Instruction);
+		unsigned C = MACIA_C(Instruction);
+		unsigned Bx = MACIA_BX(Instruction);
+		int Valid = 0;
+
+		switch (MACIA_OPCODE(Instruction)) {
+			case OpNone:
+			case OpReturn: {
+				Valid = 1;
+			} break;
+
+			case OpNew:
+			case OpInvoke: {
+				Valid = A < Registers && Bx < Constants
+					&& m_lCallables[Bx] != NULL
+					&& (m_lCallables[Bx]->Source->GetType() == CTObject) 
+						== (MACIA_OPCODE(Instruction) == OpNew);
+			} break;
+
+			case OpMove: {
+				Valid = A < Registers && B < Registers;
+			} break;
+			case OpLoadI: {
+				Valid = A < Registers;
+			} break;
+			case OpLoadK: {
+				Valid = A < Registers && Bx < Constants
+					&& m_lConstants[Bx].Type != ValueNull;
+			} break;
+			case OpLoadF: {
+				Valid = A < Registers && B < Fields;
+			} break;
+			case OpStoreF: {
+				Valid = A < Fields && B < Registers;
+			} break;
+			case OpLoadG:
+			case OpStoreG: {
+				Valid = A < Registers && Bx < Globals;
+			} break;
+
+			case OpAdd:
+			case OpSub:
+			case OpMul:
+			case OpDiv:
+			case OpRem: {
+				Valid = A < Registers && B < Registers && C < Registers;
+			} break;
+
+			default:
+				break;
+		}
 
-	/* Lookup main method */
-	ObjectInstance *Instance = NULL;
+		/* Bail on the first invalid one */
+		if (!Valid) {
+			printf("Invalid instruction 0x%08x at %u in %s\n", 
+				Instruction, (unsigned)i, Function->Source->GetPath());
+			return -1;
+		}
+	}
+
+	/* Done! */
+	return 0;
+}
+
+/* Prepares the program in the data pool for execution, the constant 
+ * pool is resolved and the code of all functions is verified */
+int Interpreter::Prepare() {
+
+	/* Variables */
+	std::vector<Constant_t> &Constants = m_pPool->GetConstants();
 	CodeObject *EntryObj = m_pPool->LookupObject("__maciaentry");
 
 	/* Sanity -> We need entry */
@@ -54,64 +213,319 @@ int Interpreter::Execute() {
 		return -1;
 	}
 
-	/* Allocate variables and objects */
-	//Instance = new ObjectInstance(m_pPool->CalculateObjectSize(0), NULL);
+	/* Create all functions */
+	for (std::map<int, CodeObject*>::iterator Itr = m_pPool->GetTable().begin();
+		Itr != m_pPool->GetTable().end(); ++Itr) {
+		MachineFunction_t *Function = GetFunction(Itr->first);
+		if (Itr->second == EntryObj) {
+			m_pEntry = Function;
+		}
+	}
+
+	/* Resolve the constant pool */
+	for (size_t i = 0; i < Constants.size(); i++) {
+		MachineFunction_t *Callable = NULL;
+		Value_t Value;
+
+		memset(&Value, 0, sizeof(Value_t));
+		if (Constants[i].Type == ConstantInteger) {
+			Value.Type = ValueInteger;
+			Value.Integer = Constants[i].Value;
+		}
+		else if (Constants[i].Type == ConstantString) {
+			Value.Type = ValueString;
+			Value.String = m_pPool->GetString(Constants[i].Value);
+			if (Value.String == NULL) {
+				printf("Invalid string in constant pool\n");
+				return -1;
+			}
+		}
+		else {
+			Callable = GetFunction(Constants[i].Value);
+			if (Callable == NULL) {
+				printf("Invalid code reference in constant pool\n");
+				return -1;
+			}
+		}
+
+		m_lConstants.push_back(Value);
+		m_lCallables.push_back(Callable);
+	}
+
+	/* Allocate globals */
+	m_lGlobals.resize(m_pPool->GetGlobalCount());
+
+	/* Verify code */
+	for (std::map<int, MachineFunction_t*>::iterator Itr = m_sFunctions.begin();
+		Itr != m_sFunctions.end(); ++Itr) {
+		if (Verify(Itr->second)) {
+			return -1;
+		}
+	}
+
+	/* Done! */
+	m_iPrepared = 1;
+	return 0;
+}
+
+/* Creates a new instance of the given object, the 
+ * instance lives until the program finishes */
+ObjectInstance *Interpreter::CreateInstance(MachineFunction_t *Type) {
+
+	/* Allocate room for at-least one field */
+	size_t Fields = (Type->FieldCount == 0) ? 1 : (size_t)Type->FieldCount;
+	ObjectInstance *Instance = new ObjectInstance(Fields * sizeof(Value_t), Type->Source);
+
+	/* Track it */
+	m_lInstances.push_back(Instance);
+	return Instance;
+}
+
+/* The execution, it returns 
+ * when code runs out */
+int Interpreter::Execute() {
+
+	/* Variables */
+	int Result = 0;
+
+	/* Prepare the program on first run */
+	if (!m_iPrepared && Prepare()) {
+		return -1;
+	}
+
+	/* Reset globals */
+	if (!m_lGlobals.empty()) {
+		memset(&m_lGlobals[0], 0, m_lGlobals.size() * sizeof(Value_t));
+	}
 
 	/* Execute code */
-	return ExecuteCode(Instance, EntryObj->GetCode());
+	Result = ExecuteCode(m_pEntry);
+
+	/* Cleanup instances */
+	for (size_t i = 0; i < m_lInstances.size(); i++) {
+		delete m_lInstances[i];
+	}
+	m_lInstances.clear();
+	return Result;
 }
 
-/* Executes the given code 
- * this function may be called recursive */
-int Interpreter::ExecuteCode(ObjectInstance *Instance, std::vector<unsigned char> &Code) {
-	
-	/* Iterator */
-	size_t Iterator = 0;
+/* Dispatch macros
+ * With threaded dispatch every handler jumps directly to the 
+ * next one, otherwise all handlers return to the switch */
+#ifdef MACIA_THREADED_DISPATCH
+#define VM_CASE(Op)		Label##Op
+#define VM_NEXT()		Instruction = *Pc++; goto *DispatchTable[MACIA_OPCODE(Instruction)]
+#else
+#define VM_CASE(Op)		case Op
+#define VM_NEXT()		goto Dispatch
+#endif
 
-	while (Iterator < Code.size()) {
+/* Arithmetic operands must both be integers, the operations are 
+ * done unsigned so overflows wrap instead of being undefined */
+#define VM_ARITHMETIC(Operation) { \
+	Value_t *Left = &Registers[MACIA_B(Instruction)]; \
+	Value_t *Right = &Registers[MACIA_C(Instruction)]; \
+	if (Left->Type != ValueInteger || Right->Type != ValueInteger) { \
+		goto TypeError; \
+	} \
+	Registers[MACIA_A(Instruction)].Integer = (int)(Operation); \
+	Registers[MACIA_A(Instruction)].Type = ValueInteger; \
+}
 
-		/* Get opcode */
-		Opcode_t Opcode = (Opcode_t)Code[Iterator];
+/* Executes the given function and everything it invokes, all
+ * state is kept in locals so the compiler can keep it in registers */
+int Interpreter::ExecuteCode(MachineFunction_t *Function) {
 
-		/* Increament */
-		Iterator++;
+	/* Machine state */
+	MachineFrame_t *Frame = &m_pFrames[0];
+	MachineFrame_t *FrameLimit = &m_pFrames[MACIA_FRAME_COUNT - 1];
+	Value_t *ArenaLimit = m_pArena + MACIA_ARENA_SIZE;
+	Value_t *Constants = m_lConstants.empty() ? NULL : &m_lConstants[0];
+	MachineFunction_t **Callables = m_lCallables.empty() ? NULL : &m_lCallables[0];
+	Value_t *Globals = m_lGlobals.empty() ? NULL : &m_lGlobals[0];
+	Value_t *Registers = m_pArena;
+	Value_t *Fields = NULL;
+	ObjectInstance *Self = NULL;
+	MachineFunction_t *Callee = NULL;
+	const Instruction_t *Pc = Function->Code;
+	Instruction_t Instruction;
+	int Result = 0;
 
-		/* Handle opcode */
-		switch (Opcode) {
+#ifdef MACIA_THREADED_DISPATCH
+	/* Must be kept in the same order as Opcode_t */
+	static const void *DispatchTable[OpCount] = {
+		&&LabelOpNone, &&InvalidOpcode, &&LabelOpNew, &&LabelOpInvoke, &&LabelOpReturn,
+		&&LabelOpMove, &&LabelOpLoadI, &&LabelOpLoadK, &&LabelOpLoadF, &&LabelOpStoreF,
+		&&LabelOpLoadG, &&LabelOpStoreG, 
+		&&LabelOpAdd, &&LabelOpSub, &&LabelOpMul, &&LabelOpDiv, &&LabelOpRem
+	};
+#endif
 
-			/* Specials */
-			case OpLabel:
-			case OpNew:
-			case OpInvoke:
-			case OpReturn: {
+	/* Setup the first frame */
+	if (Function->RegisterCount > MACIA_ARENA_SIZE) {
+		goto StackOverflow;
+	}
+	memset(Registers, 0, Function->RegisterCount * sizeof(Value_t));
+	Frame->Function = Function;
+	Frame->Registers = Registers;
+	Frame->ReturnPc = NULL;
+	Frame->Self = NULL;
 
-			} break;
+#ifdef MACIA_THREADED_DISPATCH
+	VM_NEXT();
+#else
+Dispatch:
+	Instruction = *Pc++;
+	switch (MACIA_OPCODE(Instruction)) {
+#endif
 
-			/* Store Opcodes */
-			case OpStore:
-			case OpStoreAR:
-			case OpStoreRI:
-			case OpStoreI: {
+	VM_CASE(OpNone): {
+	} VM_NEXT();
 
-			} break;
+	/* Specials */
+	VM_CASE(OpNew): {
+		Callee = Callables[MACIA_BX(Instruction)];
+		Self = CreateInstance(Callee);
+		Registers[MACIA_A(Instruction)].Type = ValueObject;
+		Registers[MACIA_A(Instruction)].Object = Self;
+	} goto Invoke;
 
-			/* Load Opcodes */
-			case OpLoadA:
-			case OpLoadRA: {
+	VM_CASE(OpInvoke): {
+		Callee = Callables[MACIA_BX(Instruction)];
+		Self = (Registers[MACIA_A(Instruction)].Type == ValueObject) 
+			? Registers[MACIA_A(Instruction)].Object : NULL;
+		if (Callee->Owner != NULL
+			&& (Self == NULL || Self->GetType() != Callee->Owner)) {
+			goto InvalidInstance;
+		}
+	} goto Invoke;
 
-			} break;
+	VM_CASE(OpReturn): {
+		if (Frame == &m_pFrames[0]) {
+			goto Exit;
+		}
+		Frame--;
+		Registers = Frame->Registers;
+		Self = Frame->Self;
+		Fields = (Self != NULL) ? (Value_t*)Self->GetBase() : NULL;
+		Pc = Frame->ReturnPc;
+	} VM_NEXT();
 
-			/* Error on stupid opcodes */
-			default: {
-				/* Error Message */
-				printf("Unhandled opcode 0x%x\n", Opcode);
+	/* Load & Store Opcodes */
+	VM_CASE(OpMove): {
+		Registers[MACIA_A(Instruction)] = Registers[MACIA_B(Instruction)];
+	} VM_NEXT();
 
-				/* Bail */
-				return -1;
-			}
+	VM_CASE(OpLoadI): {
+		Registers[MACIA_A(Instruction)].Type = ValueInteger;
+		Registers[MACIA_A(Instruction)].Integer = MACIA_SBX(Instruction);
+	} VM_NEXT();
+
+	VM_CASE(OpLoadK): {
+		Registers[MACIA_A(Instruction)] = Constants[MACIA_BX(Instruction)];
+	} VM_NEXT();
+
+	VM_CASE(OpLoadF): {
+		Registers[MACIA_A(Instruction)] = Fields[MACIA_B(Instruction)];
+	} VM_NEXT();
+
+	VM_CASE(OpStoreF): {
+		Fields[MACIA_A(Instruction)] = Registers[MACIA_B(Instruction)];
+	} VM_NEXT();
+
+	VM_CASE(OpLoadG): {
+		Registers[MACIA_A(Instruction)] = Globals[MACIA_BX(Instruction)];
+	} VM_NEXT();
+
+	VM_CASE(OpStoreG): {
+		Globals[MACIA_BX(Instruction)] = Registers[MACIA_A(Instruction)];
+	} VM_NEXT();
+
+	/* Arithmetics */
+	VM_CASE(OpAdd): VM_ARITHMETIC((unsigned)Left->Integer + (unsigned)Right->Integer) VM_NEXT();
+	VM_CASE(OpSub): VM_ARITHMETIC((unsigned)Left->Integer - (unsigned)Right->Integer) VM_NEXT();
+	VM_CASE(OpMul): VM_ARITHMETIC((unsigned)Left->Integer * (unsigned)Right->Integer) VM_NEXT();
+
+	/* The divisor is only inspected once both operands are known to be
+	 * integers, INT_MIN / -1 is done as a negation so it wraps */
+	VM_CASE(OpDiv): {
+		if (Registers[MACIA_B(Instruction)].Type != ValueInteger
+			|| Registers[MACIA_C(Instruction)].Type != ValueInteger) {
+			goto TypeError;
 		}
+		if (Registers[MACIA_C(Instruction)].Integer == 0) {
+			goto DivideByZero;
+		}
+		if (Registers[MACIA_C(Instruction)].Integer == -1) {
+			VM_ARITHMETIC(0u - (unsigned)Left->Integer);
+		}
+		else {
+			VM_ARITHMETIC(Left->Integer / Right->Integer);
+		}
+	} VM_NEXT();
+
+	VM_CASE(OpRem): {
+		if (Registers[MACIA_B(Instruction)].Type != ValueInteger
+			|| Registers[MACIA_C(Instruction)].Type != ValueInteger) {
+			goto TypeError;
+		}
+		if (Registers[MACIA_C(Instruction)].Integer == 0) {
+			goto DivideByZero;
+		}
+		if (Registers[MACIA_C(Instruction)].Integer == -1) {
+			VM_ARITHMETIC(0);
+		}
+		else {
+			VM_ARITHMETIC(Left->Integer % Right->Integer);
+		}
+	} VM_NEXT();
+
+#ifndef MACIA_THREADED_DISPATCH
+	default:
+		goto InvalidOpcode;
+	}
+#endif
+
+	/* Invocation, the callee and instance has been
+	 * selected, push a new frame and a register window */
+Invoke:
+	if (Frame == FrameLimit
+		|| Registers + Frame->Function->RegisterCount + Callee->RegisterCount > ArenaLimit) {
+		goto StackOverflow;
 	}
+	Frame->ReturnPc = Pc;
+	Registers += Frame->Function->RegisterCount;
+	Frame++;
+	memset(Registers, 0, Callee->RegisterCount * sizeof(Value_t));
+	Frame->Function = Callee;
+	Frame->Registers = Registers;
+	Frame->Self = Self;
+	Fields = (Self != NULL) ? (Value_t*)Self->GetBase() : NULL;
+	Pc = Callee->Code;
+	VM_NEXT();
+
+	/* Runtime errors */
+InvalidOpcode:
+	printf("Unhandled opcode 0x%x", MACIA_OPCODE(Instruction));
+	goto Error;
+InvalidInstance:
+	printf("Invalid instance for %s", Callee->Source->GetPath());
+	goto Error;
+TypeError:
+	printf("Invalid operand types for arithmetic");
+	goto Error;
+DivideByZero:
+	printf("Division by zero");
+	goto Error;
+StackOverflow:
+	printf("Stack overflow");
+	goto Error;
 
+Error:
+	printf(" in %s\n", Frame->Function->Source->GetPath());
+	Result = -1;
+
+Exit:
 	/* Done! */
-	return 0;
-}
\ No newline at end of file
+	return Result;
+}
@@ -26,6 +26,7 @@
 #include <cstring>
 #include <cstdlib>
 #include <vector>
+#include <map>
 
 /* System Includes */
 #include "MachineState.h"
@@ -38,7 +39,7 @@ class ObjectInstance
 {
 public:
 	ObjectInstance(size_t Size, CodeObject *Type) {
-		m_pBase = malloc(Size);
+		m_pBase = calloc(1, Size);
 		m_pType = Type;
 		m_iSize = Size;
 	}
@@ -59,6 +60,12 @@ private:
 	void *m_pBase;
 };
 
+/* Select the dispatch method, computed goto is 
+ * used when the compiler supports it */
+#if defined(__GNUC__) && !defined(MACIA_SWITCH_DISPATCH)
+#define MACIA_THREADED_DISPATCH
+#endif
+
 /* The interpreter class 
  * this contains all functionality needed
  * for executing Macia bytecode */
@@ -69,13 +76,35 @@ public:
 	~Interpreter();
 
 	/* Run the interpreter
-	 * this returns when the code is at end */
+	 * this returns when the code is at end, the
+	 * program can be run any number of times */
 	int Execute();
 
+	/* Gets
+	 * The globals keep the values the last run left in them */
+	const std::vector<Value_t> &GetGlobals() { return m_lGlobals; }
+
 private:
 	/* Private - Functions */
-	int ExecuteCode(ObjectInstance *Instance, std::vector<unsigned char> &Code);
+	int Prepare();
+	int Verify(MachineFunction_t *Function);
+	MachineFunction_t *GetFunction(int Id);
+	ObjectInstance *CreateInstance(MachineFunction_t *Type);
+	int ExecuteCode(MachineFunction_t *Function);
 
 	/* Private - Data */
 	DataPool *m_pPool;
-};
\ No newline at end of file
+	int m_iPrepared;
+
+	/* Private - Program */
+	std::map<int, MachineFunction_t*> m_sFunctions;
+	std::vector<Value_t> m_lConstants;
+	std::vector<MachineFunction_t*> m_lCallables;
+	std::vector<Value_t> m_lGlobals;
+	std::vector<ObjectInstance*> m_lInstances;
+	MachineFunction_t *m_pEntry;
+
+	/* Private - Machine */
+	MachineFrame_t *m_pFrames;
+	Value_t *m_pArena;
+};
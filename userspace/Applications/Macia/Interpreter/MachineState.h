@@ -0,0 +1,83 @@
+/* The Macia Language (MACIA)
+*
+* Copyright 2016, Philip Meulengracht
+*
+* This program is free software : you can redistribute it and / or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation ? , either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* Macia - Virtual Machine State
+* - Describes the values, functions and frames the
+* - virtual machine operates on
+*/
+#pragma once
+
+/* Includes */
+#include <cstddef>
+
+/* System Includes */
+#include "../Generator/Opcodes.h"
+
+/* Machine limits
+ * The register windows of all active frames are carved out
+ * of one arena, both the arena and the frame stack are allocated
+ * once per interpreter */
+#define MACIA_ARENA_SIZE		(64 * 1024)
+#define MACIA_FRAME_COUNT		256
+
+/* Forward declarations */
+class ObjectInstance;
+class CodeObject;
+
+/* The value type
+ * Registers, fields and globals all hold values, a
+ * cleared value is null */
+typedef enum {
+	ValueNull = 0,
+	ValueInteger,
+	ValueString,
+	ValueObject
+} ValueType_t;
+
+/* The value
+ * Strings point into the data pool and are never owned */
+typedef struct _Value {
+	ValueType_t Type;
+	union {
+		int Integer;
+		const char *String;
+		ObjectInstance *Object;
+	};
+} Value_t;
+
+/* The machine function
+ * This is a prepared and verified code object, object
+ * initializers are functions that run on the new instance */
+typedef struct _MachineFunction {
+	CodeObject *Source;
+	CodeObject *Owner;
+	const Instruction_t *Code;
+	size_t Length;
+	int RegisterCount;
+	int FieldCount;
+} MachineFunction_t;
+
+/* The machine frame
+ * One for each active invocation, the registers point
+ * into the arena */
+typedef struct _MachineFrame {
+	MachineFunction_t *Function;
+	const Instruction_t *ReturnPc;
+	Value_t *Registers;
+	ObjectInstance *Self;
+} MachineFrame_t;
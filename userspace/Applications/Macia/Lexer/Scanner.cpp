@@ -332,5 +332,7 @@ void Scanner::CreateElement(ElementType_t Type, char *Data, int Line, long Chara
 	m_lElements.push_back(elem);
 
 	/* Diagnose */
+#ifndef MACIA_NO_DIAGNOSE
 	printf("Found Element %s\n", elem->GetName());
+#endif
 }
@@ -20,7 +20,9 @@
  */
 
 /* Includes */
+#ifdef _MSC_VER
 #include <tchar.h>
+#endif
 #include <cstdio>
 #include <cstdlib>
 
@@ -30,7 +32,11 @@
 #include "Generator/Generator.h"
 #include "Interpreter/Interpreter.h"
 
+#ifdef _MSC_VER
 int _tmain(int argc, _TCHAR* argv[])
+#else
+int main(int argc, char* argv[])
+#endif
 {
 	/* Variables we will need
 	 * for build */
@@ -40,6 +46,7 @@ int _tmain(int argc, _TCHAR* argv[])
 	Parser *parser = NULL;
 	char *fileData = NULL;
 	FILE *source = NULL;
+	const char *path = "test.mc";
 	size_t size = 0;
 	size_t bread = 0;
 
@@ -49,12 +56,20 @@ int _tmain(int argc, _TCHAR* argv[])
 	printf(" - Author: %s\n\n", AUTHOR);
 #endif
 
+	/* The source file can be given on hosts 
+	 * with a narrow argv */
+#ifndef _MSC_VER
+	if (argc > 1) {
+		path = argv[1];
+	}
+#endif
+
 	/* Step 1. Read file */
-	source = fopen("test.mc", "r+b");
+	source = fopen(path, "r+b");
 
 	/* Sanity */
 	if (source == NULL) {
-		printf("Failed to open %s\n", "test.mc");
+		printf("Failed to open %s\n", path);
 		return -1;
 	}
 
@@ -158,7 +173,9 @@ Cleanup:
 		fclose(source);
 	}
 
+#ifdef _MSC_VER
 	for (;;);
+#endif
 
 	return 0;
 }
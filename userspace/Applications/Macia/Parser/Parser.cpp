@@ -323,127 +323,151 @@ int Parser::ParseModifiers(int Index, int *Modifiers)
 	return Consumed;
 }
 
-/* Parse an AST expression from the given index 
+/* Parse a single operand of an expression, that is a literal, a variable,
+ * a negated operand or a sub-expression in parenthesis.
  * returns how many elements were consumed in the process */
-int Parser::ParseExpression(int Index, Expression **Parent)
+int Parser::ParseOperand(int Index, Expression **Parent)
 {
 	/* Keep track of elements consumed */
 	Expression *Expr = NULL;
 	int Consumed = 0;
-	int ModIndex = Index;
 
-	/* Iterate untill end of expression */
-	while (m_lElements[ModIndex]->GetType() != OperatorSemiColon
-		&& m_lElements[ModIndex]->GetType() != RightParenthesis) {
+	/* Now, let's check... */
+	if (m_lElements[Index]->GetType() == LeftParenthesis) {
 
-		/* Used elements */
-		int Used = 0;
+		/* Consume the left paranthesis */
+		Consumed++;
 
-		/* Now, let's check... */
-		if (m_lElements[ModIndex]->GetType() == LeftParenthesis) {
+		/* Parse sub-expression in expression */
+		Consumed += ParseExpression(Index + 1, &Expr);
 
-			/* Consume the left paranthesis */
-			Used++;
+		/* Skip the right parenthesis */
+		Consumed++;
+	}
+	else if (m_lElements[Index]->GetType() == StringLiteral) {
 
-			/* Parse sub-expression in expression */
-			Used += ParseExpression(ModIndex + 1, &Expr);
+		/* Create a new string value object */
+		Expr = new StringValue(m_lElements[Index]->GetData());
+		Consumed++;
+	}
+	else if (m_lElements[Index]->GetType() == DigitLiteral) {
 
-			/* Skip the right parenthesis */
-			Used++;
-		}
-		else if (m_lElements[ModIndex]->GetType() == StringLiteral) {
+		/* Create a new digit value object */
+		Expr = new IntValue(m_lElements[Index]->GetData());
+		Consumed++;
+	}
+	else if (m_lElements[Index]->GetType() == Identifier
+		&& m_lElements[Index + 1]->GetType() == LeftParenthesis) {
+		/* Function calls in expressions 
+		 * not really supported atm */
+		printf("Functions calls in expressions are currently unsupported, line %u\n",
+			m_lElements[Index]->GetLineNumber());
+		Consumed++;
+	}
+	else if (m_lElements[Index]->GetType() == Identifier) {
 
-			/* Create a new string value object */
-			StringValue *StrVal = new StringValue(m_lElements[ModIndex]->GetData());
+		/* Create a new variable value object */
+		Expr = new Variable(m_lElements[Index]->GetData());
+		Consumed++;
+	}
+	else if (m_lElements[Index]->GetType() == OperatorSubtract) {
 
-			/* Save it */
-			Expr = StrVal;
-			Used++;
-		}
-		else if (m_lElements[ModIndex]->GetType() == DigitLiteral) {
+		/* Negation has no left hand, it's subtracted from zero */
+		BinaryExpression *Binary = new BinaryExpression(ExprOperatorSubtract);
+		Expression *Expr2 = NULL;
 
-			/* Create a new digit value object */
-			IntValue *IntVal = new IntValue(m_lElements[ModIndex]->GetData());
+		Consumed++;
+		Consumed += ParseOperand(Index + 1, &Expr2);
+		Binary->SetExpression2(Expr2);
+		Expr = Binary;
+	}
+	else {
+		/* ERROR - ERRROR - ABBOOOOORT */
+		printf("Expected an operand but found element of type %s, line %u\n",
+			m_lElements[Index]->GetName(), m_lElements[Index]->GetLineNumber());
 
-			/* Save it */
-			Expr = IntVal;
-			Used++;
-		}
-		else if (m_lElements[ModIndex]->GetType() == Identifier
-			&& m_lElements[ModIndex + 1]->GetType() == LeftParenthesis) {
-			/* Function calls in expressions 
-			 * not really supported atm */
-			printf("Functions calls in expressions are currently unsupported, line %u\n",
-				m_lElements[ModIndex]->GetLineNumber());
+		/* Never consume the end of the expression */
+		if (m_lElements[Index]->GetType() != OperatorSemiColon
+			&& m_lElements[Index]->GetType() != RightParenthesis) {
+			Consumed++;
 		}
-		else if (m_lElements[ModIndex]->GetType() == Identifier) {
+	}
 
-			/* Create a new variable value object */
-			Variable *Var = new Variable(m_lElements[ModIndex]->GetData());
-			
-			/* Save it */
-			Expr = Var;
-			Used++;
-		}
-		/* Now we check for operators!! 
-		 * operators are allowed, we just need to be careful */
-		else if (m_lElements[ModIndex]->GetType() == OperatorAdd
-			|| m_lElements[ModIndex]->GetType() == OperatorSubtract
-			|| m_lElements[ModIndex]->GetType() == OperatorDivide
-			|| m_lElements[ModIndex]->GetType() == OperatorMultiply) {
-
-			/* Do the sanity check, no + operators to start with */
-			if (Expr == NULL
-				&& m_lElements[ModIndex]->GetType() != OperatorSubtract) {
-				printf("Expression cannot be started with element of type %s, line %u\n",
-					m_lElements[ModIndex]->GetName(), m_lElements[ModIndex]->GetLineNumber());
-			}
+	/* Update parent */
+	*Parent = Expr;
+	return Consumed;
+}
 
-			/* Determine correct expr-operator */
-			ExpressionBinaryOperator_t ExprOperator;
-			BinaryExpression *Binary = NULL;
-			Expression *Expr2 = NULL;
+/* Parse a chain of multiplications and divisions, the chain
+ * is built left-associative, a * b / c is (a * b) / c.
+ * returns how many elements were consumed in the process */
+int Parser::ParseTerm(int Index, Expression **Parent)
+{
+	/* Keep track of elements consumed */
+	Expression *Expr = NULL;
+	int Consumed = ParseOperand(Index, &Expr);
 
-			/* Switch.. */
-			if (m_lElements[ModIndex]->GetType() == OperatorAdd)
-				ExprOperator = ExprOperatorAdd;
-			else if (m_lElements[ModIndex]->GetType() == OperatorSubtract)
-				ExprOperator = ExprOperatorSubtract;
-			else if (m_lElements[ModIndex]->GetType() == OperatorDivide)
-				ExprOperator = ExprOperatorDivide;
-			else if (m_lElements[ModIndex]->GetType() == OperatorMultiply)
-				ExprOperator = ExprOperatorMultiply;
+	/* Iterate the operators of this precedence */
+	while (m_lElements[Index + Consumed]->GetType() == OperatorMultiply
+		|| m_lElements[Index + Consumed]->GetType() == OperatorDivide) {
 
-			/* Ok, create a new expression */
-			Binary = new BinaryExpression(ExprOperator);
+		/* Create a new expression, the existing one is the left hand */
+		BinaryExpression *Binary = new BinaryExpression(
+			(m_lElements[Index + Consumed]->GetType() == OperatorMultiply) 
+			? ExprOperatorMultiply : ExprOperatorDivide);
+		Expression *Expr2 = NULL;
 
-			/* Take the already existing expression, set it as left hand */
-			Binary->SetExpression1(Expr);
+		/* Skip the operator and parse the right hand */
+		Consumed++;
+		Consumed += ParseOperand(Index + Consumed, &Expr2);
 
-			/* Skip this element */
-			Used++;
+		/* Update */
+		Binary->SetExpression1(Expr);
+		Binary->SetExpression2(Expr2);
+		Expr = Binary;
+	}
 
-			/* Parse the next expression */
-			Used += ParseExpression(ModIndex + 1, &Expr2);
+	/* Update parent */
+	*Parent = Expr;
+	return Consumed;
+}
 
-			/* Set second expression */
-			Binary->SetExpression2(Expr2);
+/* Parse an AST expression from the given index, additions and 
+ * subtractions bind weaker than the terms, and are left-associative.
+ * returns how many elements were consumed in the process */
+int Parser::ParseExpression(int Index, Expression **Parent)
+{
+	/* Keep track of elements consumed */
+	Expression *Expr = NULL;
+	int Consumed = ParseTerm(Index, &Expr);
 
-			/* Update */
-			Expr = Binary;
-		}
-		else {
-			/* ERROR - ERRROR - ABBOOOOORT */
-			printf("Element of type %s in expressions are currently unsupported, line %u\n",
-				m_lElements[ModIndex]->GetName(), m_lElements[ModIndex]->GetLineNumber());
+	/* Iterate the operators of this precedence */
+	while (m_lElements[Index + Consumed]->GetType() == OperatorAdd
+		|| m_lElements[Index + Consumed]->GetType() == OperatorSubtract) {
 
-			/* Skip */
-			Used++;
-		}
+		/* Create a new expression, the existing one is the left hand */
+		BinaryExpression *Binary = new BinaryExpression(
+			(m_lElements[Index + Consumed]->GetType() == OperatorAdd) 
+			? ExprOperatorAdd : ExprOperatorSubtract);
+		Expression *Expr2 = NULL;
 
-		/* Consumeeee */
-		Consumed += Used;
-		ModIndex += Used;
+		/* Skip the operator and parse the right hand */
+		Consumed++;
+		Consumed += ParseTerm(Index + Consumed, &Expr2);
+
+		/* Update */
+		Binary->SetExpression1(Expr);
+		Binary->SetExpression2(Expr2);
+		Expr = Binary;
+	}
+
+	/* Skip anything up to the end of the expression */
+	while (m_lElements[Index + Consumed]->GetType() != OperatorSemiColon
+		&& m_lElements[Index + Consumed]->GetType() != RightParenthesis) {
+		printf("Element of type %s in expressions are currently unsupported, line %u\n",
+			m_lElements[Index + Consumed]->GetName(), 
+			m_lElements[Index + Consumed]->GetLineNumber());
+		Consumed++;
 	}
 
 	/* Update parent */
@@ -46,6 +46,8 @@ public:
 
 private:
 	/* Private - Functions */
+	int ParseOperand(int Index, Expression **Parent);
+	int ParseTerm(int Index, Expression **Parent);
 	int ParseExpression(int Index, Expression **Parent);
 	int ParseStatement(int Index, Statement **Parent);
 	int ParseModifiers(int Index, int *Modifiers);
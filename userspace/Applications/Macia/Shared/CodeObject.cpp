@@ -26,12 +26,12 @@
 
 /* Constructor 
  * Initialize and setup vars */
-CodeObject::CodeObject(CodeType_t pType, char *pIdentifier,
+CodeObject::CodeObject(CodeType_t pType, const char *pIdentifier,
 	char *pPath, int pScopeId) {
 
 	/* Store */
 	m_eType = pType;
-	m_pIdentifier = strdup(pIdentifier);
+	m_pIdentifier = (pIdentifier != NULL) ? strdup(pIdentifier) : NULL;
 	m_pPath = pPath;
 	m_iScopeId = pScopeId;
 
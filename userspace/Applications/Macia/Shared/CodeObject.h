@@ -27,6 +27,9 @@
 #include <cstdlib>
 #include <vector>
 
+/* System Includes */
+#include "../Generator/Opcodes.h"
+
 /* The code type
  * Identifies the type of the code object */
 typedef enum {
@@ -44,7 +47,7 @@ typedef enum {
 class CodeObject
 {
 public:
-	CodeObject(CodeType_t pType, char *pIdentifier,
+	CodeObject(CodeType_t pType, const char *pIdentifier,
 		char *pPath, int pScopeId);
 	~CodeObject();
 
@@ -56,19 +59,20 @@ public:
 	void SetOffset(int Offset) { m_iOffset = Offset; }
 
 	/* Add Code */
-	void AddCode(unsigned char Opcode) { m_lByteCode.push_back(Opcode); }
+	void AddCode(Instruction_t Instruction) { m_lByteCode.push_back(Instruction); }
 
 	/* Gets */
-	std::vector<unsigned char> &GetCode() { return m_lByteCode; }
+	std::vector<Instruction_t> &GetCode() { return m_lByteCode; }
 	CodeType_t GetType() { return m_eType; }
 	char *GetPath() { return m_pPath; }
 	char *GetIdentifier() { return m_pIdentifier; }
 	int GetScopeId() { return m_iScopeId; }
 	int GetOffset() { return m_iOffset; }
+	int GetVariableCount() { return m_iVariablesDefined; }
 
 private:
 	/* Private - ByteCode */
-	std::vector<unsigned char> m_lByteCode;
+	std::vector<Instruction_t> m_lByteCode;
 
 	/* Private - Data */
 	CodeType_t m_eType;
@@ -23,16 +23,19 @@
 
 /* Includes */
 #include "DataPool.h"
+#include <cstdio>
 
 /* Constructor 
  * Initialize the data pool etc */
 DataPool::DataPool() {
 
 	/* Initialize */
+	m_iGlobalsDefined = 0;
 	m_iIdGen = 0;
 
 	/* Clear out to be sure */
 	m_sTable.clear();
+	m_lConstants.clear();
 }
 
 /* Destructor 
@@ -42,7 +45,7 @@ DataPool::~DataPool() {
 }
 
 /* Checks for dublicates path */
-int DataPool::CheckDublicate(char *pIdentifier, char *pPath) {
+int DataPool::CheckDublicate(const char *pIdentifier, const char *pPath) {
 	
 	/* Iterate our code objects */
 	for (std::map<int, CodeObject*>::iterator Itr = m_sTable.begin();
@@ -68,7 +71,7 @@ int DataPool::CheckDublicate(char *pIdentifier, char *pPath) {
 
 /* Calculates and creates a path for the given
  * identifier, so it lets us easily check for dubs */
-char *DataPool::CreatePath(int ScopeId, char *Identifier) {
+char *DataPool::CreatePath(int ScopeId, const char *Identifier) {
 
 	/* Static storage */
 	char Buffer[256];
@@ -130,7 +133,7 @@ int DataPool::CreateObject(char *pIdentifier) {
 
 /* Create a new function for the given scope
  * and return the id for the current scope */
-int DataPool::CreateFunction(char *pIdentifier, int ScopeId) {
+int DataPool::CreateFunction(const char *pIdentifier, int ScopeId) {
 
 	/* Variables */
 	CodeObject *OwnerObj = NULL;
@@ -195,9 +198,12 @@ int DataPool::DefineVariable(char *pIdentifier, int ScopeId) {
 	dObj = new CodeObject(CTVariable, pIdentifier, Path, ScopeId);
 
 	/* Allocate us in the owner of this variable
-	 * we must know where to be put */
+	 * we must know where to be put, variables without
+	 * an owner are given a global slot */
 	if (OwnerObj != NULL)
 		dObj->SetOffset(OwnerObj->AllocateVariableOffset());
+	else
+		dObj->SetOffset(m_iGlobalsDefined++);
 
 	/* Insert */
 	m_sTable[Id] = dObj;
@@ -219,7 +225,7 @@ int DataPool::DefineString(char *pString) {
 	memset(&Buffer[0], 0, sizeof(Buffer));
 
 	/* Format the string */
-	sprintf(&Buffer[0], "StringPool.%s", pString);
+	sprintf(&Buffer[0], DATAPOOL_STRING_PREFIX "%s", pString);
 
 	/* Check dublicates */
 	for (std::map<int, CodeObject*>::iterator Itr = m_sTable.begin();
@@ -251,7 +257,7 @@ int DataPool::DefineString(char *pString) {
 
 /* Retrieve a variable Id from the given 
  * scope and identifier */
-int DataPool::LookupSymbol(char *pIdentifier, int ScopeId) {
+int DataPool::LookupSymbol(const char *pIdentifier, int ScopeId) {
 
 	/* Iterate our code objects */
 	for (std::map<int, CodeObject*>::iterator Itr = m_sTable.begin();
@@ -297,142 +303,80 @@ CodeObject *DataPool::LookupObject(char *pPath) {
 	return NULL;
 }
 
-/* Appends bytecode to a code-object
+/* Appends an instruction to a code-object
  * this redirects the bytecode to the id given */
-int DataPool::AddOpcode(int ScopeId, Opcode_t Opcode) {
-
-	/* Iterate our code objects */
-	for (std::map<int, CodeObject*>::iterator Itr = m_sTable.begin();
-		Itr != m_sTable.end(); ++Itr)
-	{
-		/* Get dataobject */
-		CodeObject *Obj = Itr->second;
-
-		/* Compare path */
-		if (Itr->first == ScopeId) {
+int DataPool::AddInstruction(int ScopeId, Instruction_t Instruction) {
 
-			/* Yay! Found! Add code */
-			Obj->AddCode(Opcode & 0xFF);
+	/* Lookup the code object */
+	CodeObject *Obj = GetObject(ScopeId);
 
-			/* Done! */
-			return 0;
-		}
+	/* Err - Not found - Bail */
+	if (Obj == NULL) {
+		return -1;
 	}
 
-	/* Err - Not found - Bail */
-	return -1;
+	/* Yay! Found! Add code */
+	Obj->AddCode(Instruction);
+	return 0;
 }
 
-/* Appends bytecode to a code-object
- * this redirects the bytecode to the id given */
-int DataPool::AddCode8(int ScopeId, char Value) {
-
-	/* Iterate our code objects */
-	for (std::map<int, CodeObject*>::iterator Itr = m_sTable.begin();
-		Itr != m_sTable.end(); ++Itr)
-	{
-		/* Get dataobject */
-		CodeObject *Obj = Itr->second;
-
-		/* Compare path */
-		if (Itr->first == ScopeId) {
+/* Creates a new entry in the constant pool, or returns
+ * the index of an identical entry that already exists */
+int DataPool::DefineConstant(ConstantType_t Type, int Value) {
 
-			/* Yay! Found! Add code */
-			Obj->AddCode(Value);
+	/* Variables */
+	Constant_t Constant;
 
-			/* Done! */
-			return 0;
+	/* Check dublicates */
+	for (size_t i = 0; i < m_lConstants.size(); i++) {
+		if (m_lConstants[i].Type == Type
+			&& m_lConstants[i].Value == Value) {
+			return (int)i;
 		}
 	}
 
-	/* Err - Not found - Bail */
-	return -1;
-}
-
-/* Appends bytecode to a code-object
- * this redirects the bytecode to the id given */
-int DataPool::AddCode16(int ScopeId, short Value) {
-
-	/* Iterate our code objects */
-	for (std::map<int, CodeObject*>::iterator Itr = m_sTable.begin();
-		Itr != m_sTable.end(); ++Itr)
-	{
-		/* Get dataobject */
-		CodeObject *Obj = Itr->second;
-
-		/* Compare path */
-		if (Itr->first == ScopeId) {
-
-			/* Yay! Found! Add code */
-			Obj->AddCode(Value & 0xFF);
-			Obj->AddCode((Value >> 8) & 0xFF);
-
-			/* Done! */
-			return 0;
-		}
+	/* The index must fit in the Bx operand */
+	if (m_lConstants.size() > MACIA_MAX_BX) {
+		printf("Too many constants in program\n");
+		return -1;
 	}
 
-	/* Err - Not found - Bail */
-	return -1;
-}
+	/* Append it */
+	Constant.Type = Type;
+	Constant.Value = Value;
+	m_lConstants.push_back(Constant);
 
-/* Appends bytecode to a code-object
- * this redirects the bytecode to the id given */
-int DataPool::AddCode32(int ScopeId, int Value) {
-	
-	/* Iterate our code objects */
-	for (std::map<int, CodeObject*>::iterator Itr = m_sTable.begin();
-		Itr != m_sTable.end(); ++Itr)
-	{
-		/* Get dataobject */
-		CodeObject *Obj = Itr->second;
+	/* Done! */
+	return (int)m_lConstants.size() - 1;
+}
 
-		/* Compare path */
-		if (Itr->first == ScopeId) {
+/* Retrieves the code object with the given id */
+CodeObject *DataPool::GetObject(int Id) {
 
-			/* Yay! Found! Add code */
-			Obj->AddCode(Value & 0xFF);
-			Obj->AddCode((Value >> 8) & 0xFF);
-			Obj->AddCode((Value >> 16) & 0xFF);
-			Obj->AddCode((Value >> 24) & 0xFF);
+	/* Lookup */
+	std::map<int, CodeObject*>::iterator Itr = m_sTable.find(Id);
 
-			/* Done! */
-			return 0;
-		}
+	/* Sanity */
+	if (Itr == m_sTable.end()) {
+		return NULL;
 	}
 
-	/* Err - Not found - Bail */
-	return -1;
+	/* Done! */
+	return Itr->second;
 }
 
-/* Appends bytecode to a code-object
- * this redirects the bytecode to the id given */
-int DataPool::AddCode64(int ScopeId, long long Value) {
+/* Retrieves the text of a string defined 
+ * with DefineString */
+const char *DataPool::GetString(int Id) {
 
-	/* Iterate our code objects */
-	for (std::map<int, CodeObject*>::iterator Itr = m_sTable.begin();
-		Itr != m_sTable.end(); ++Itr)
-	{
-		/* Get dataobject */
-		CodeObject *Obj = Itr->second;
+	/* Lookup */
+	CodeObject *Obj = GetObject(Id);
 
-		/* Compare path */
-		if (Itr->first == ScopeId) {
-
-			/* Yay! Found! Add code */
-			Obj->AddCode(Value & 0xFF);
-			Obj->AddCode((Value >> 8) & 0xFF);
-			Obj->AddCode((Value >> 16) & 0xFF);
-			Obj->AddCode((Value >> 24) & 0xFF);
-			Obj->AddCode((Value >> 32) & 0xFF);
-			Obj->AddCode((Value >> 40) & 0xFF);
-			Obj->AddCode((Value >> 48) & 0xFF);
-
-			/* Done! */
-			return 0;
-		}
+	/* Sanity */
+	if (Obj == NULL || Obj->GetType() != CTString) {
+		return NULL;
 	}
 
-	/* Err - Not found - Bail */
-	return -1;
-}
\ No newline at end of file
+	/* Skip the pool prefix */
+	return Obj->GetPath() + strlen(DATAPOOL_STRING_PREFIX);
+}
@@ -26,12 +26,32 @@
 #include <cstring>
 #include <cstdlib>
 #include <map>
+#include <vector>
 
 /* System Includes */
 #include "../Generator/Opcodes.h"
 #include "../Parser/Parser.h"
 #include "CodeObject.h"
 
+/* The prefix used for paths in the string pool */
+#define DATAPOOL_STRING_PREFIX	"StringPool."
+
+/* The constant type
+ * Integers are stored by value, strings and code 
+ * are stored as the id of their code object */
+typedef enum {
+	ConstantInteger,
+	ConstantString,
+	ConstantCode
+} ConstantType_t;
+
+/* The constant pool entry 
+ * Instructions refer to these by their index */
+typedef struct {
+	ConstantType_t Type;
+	int Value;
+} Constant_t;
+
 /* The data pool 
  * Contains all the static data for a program */
 class DataPool
@@ -46,7 +66,7 @@ public:
 
 	/* Create a new function for the given scope 
 	 * and return the id for the current scope */
-	int CreateFunction(char *pIdentifier, int ScopeId);
+	int CreateFunction(const char *pIdentifier, int ScopeId);
 
 	/* Create a new variable for the given scope
 	 * and return the id of the variable */
@@ -58,7 +78,7 @@ public:
 
 	/* Retrieve a code object Id from the given 
 	 * identifier and scope */
-	int LookupSymbol(char *pIdentifier, int ScopeId);
+	int LookupSymbol(const char *pIdentifier, int ScopeId);
 
 	/* Retrieves a code object from the given 
 	 * identifier path */
@@ -68,23 +88,34 @@ public:
 	 * an object, returned as bytes */
 	int CalculateObjectSize(int ObjectId);
 
-	/* Appends bytecode to a code-object 
+	/* Appends an instruction to a code-object
 	 * this redirects the bytecode to the id given */
-	int AddOpcode(int ScopeId, Opcode_t Opcode);
-	int AddCode8(int ScopeId, char Value);
-	int AddCode16(int ScopeId, short Value);
-	int AddCode32(int ScopeId, int Value);
-	int AddCode64(int ScopeId, long long Value);
+	int AddInstruction(int ScopeId, Instruction_t Instruction);
+
+	/* Creates a new entry in the constant pool, or returns
+	 * the index of an identical entry that already exists */
+	int DefineConstant(ConstantType_t Type, int Value);
+
+	/* Retrieves the code object with the given id */
+	CodeObject *GetObject(int Id);
+
+	/* Retrieves the text of a string defined 
+	 * with DefineString */
+	const char *GetString(int Id);
 
 	/* Gets */
 	std::map<int, CodeObject*> &GetTable() { return m_sTable; }
+	std::vector<Constant_t> &GetConstants() { return m_lConstants; }
+	int GetGlobalCount() { return m_iGlobalsDefined; }
 
 private:
 	/* Private - Functions */
-	int CheckDublicate(char *pIdentifier, char *pPath);
-	char *CreatePath(int ScopeId, char *Identifier);
+	int CheckDublicate(const char *pIdentifier, const char *pPath);
+	char *CreatePath(int ScopeId, const char *Identifier);
 
 	/* Private - Data */
 	std::map<int, CodeObject*> m_sTable;
+	std::vector<Constant_t> m_lConstants;
+	int m_iGlobalsDefined;
 	int m_iIdGen;
 };
\ No newline at end of file
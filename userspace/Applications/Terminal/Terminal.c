@@ -105,6 +105,11 @@ SDL_Terminal *SDL_CreateTerminal(SDL_Window *window)
     terminal->font_size = 0;
     terminal->glyph_size.w = 0;
     terminal->glyph_size.h = 0;
+
+    /* Cell grid and glyphs, created with the surface and the font */
+    memset (&terminal->grid, 0, sizeof(SDL_TerminalGrid));
+    memset (&terminal->atlas, 0, sizeof(SDL_TerminalAtlas));
+    terminal->style = 0;
     
     /* Defaults color settings */
     SDL_TerminalSetColor (terminal, 255,255,255,180);
@@ -207,6 +212,8 @@ SDL_DestroyTerminal (SDL_Terminal *terminal)
         TTF_CloseFont (terminal->font);
     if (terminal->surface)
         SDL_FreeSurface (terminal->surface);
+    SDL_TerminalGridDestroy (&terminal->grid);
+    SDL_TerminalAtlasDestroy (&terminal->atlas);
 
 #ifdef HAVE_OPENGL
     if (terminal->texture)
@@ -425,6 +432,7 @@ int
 SDL_TerminalBlit (SDL_Terminal *terminal)
 {
     SDL_TerminalRenderCursor (terminal);
+    SDL_TerminalFlush (terminal);
 
 	SDL_Surface *wSurface = SDL_GetWindowSurface(terminal->window);
 	if (wSurface == 0)
@@ -527,6 +535,9 @@ SDL_TerminalClear (SDL_Terminal *terminal)
     }
 #endif
 
+    /* The surface is blank now, so are the cells */
+    SDL_TerminalGridReset (&terminal->grid);
+
     /* Reset current edited line settings */
     terminal->cpos.x = 0;
     terminal->cpos.y = 0;
@@ -635,6 +646,13 @@ SDL_TerminalSetSize (SDL_Terminal *terminal, int column, int row)
         return -1;
     }
 	SDL_SetSurfaceBlendMode(terminal->surface, SDL_BLENDMODE_NONE);
+
+    SDL_TerminalGridDestroy (&terminal->grid);
+    if (SDL_TerminalGridCreate (&terminal->grid, terminal->size.column, terminal->size.row) != 0) {
+		SDL_SetError("SDL Error <out of memory>: %i", SDL_ENOMEM);
+        terminal->status = 0;
+        return -1;
+    }
     SDL_TerminalRefresh (terminal);
     return 0;
 }
@@ -654,6 +672,10 @@ SDL_TerminalSetColor (SDL_Terminal *terminal, int red, int green, int blue, int
     terminal->color.g = green;
     terminal->color.b = blue;
     terminal->color.a = alpha;
+    terminal->grid.background.r = red;
+    terminal->grid.background.g = green;
+    terminal->grid.background.b = blue;
+    terminal->grid.background.a = alpha;
     return 0;
 }
 
@@ -681,7 +703,7 @@ SDL_TerminalSetBorderSize (SDL_Terminal *terminal, int size)
 int
 SDL_TerminalReset (SDL_Terminal *terminal)
 {
-    TTF_SetFontStyle (terminal->font, TTF_STYLE_NORMAL);
+    terminal->style = 0;
     SDL_TerminalSetForeground (terminal,
                                terminal->default_fg_color.r,
                                terminal->default_fg_color.g,
@@ -698,42 +720,42 @@ SDL_TerminalReset (SDL_Terminal *terminal)
 int
 SDL_TerminalEnableBold (SDL_Terminal *terminal)
 {
-    TTF_SetFontStyle (terminal->font, TTF_GetFontStyle (terminal->font) | TTF_STYLE_BOLD);
+    terminal->style |= SDL_TERMINAL_STYLE_BOLD;
     return 0;
 }
 
 int
 SDL_TerminalDisableBold (SDL_Terminal *terminal)
 { 
-    TTF_SetFontStyle (terminal->font, TTF_GetFontStyle (terminal->font) & ~TTF_STYLE_BOLD);
+    terminal->style &= ~SDL_TERMINAL_STYLE_BOLD;
     return 0;
 }
 
 int
 SDL_TerminalEnableUnderline (SDL_Terminal *terminal)
 {
-    TTF_SetFontStyle (terminal->font, TTF_GetFontStyle (terminal->font) | TTF_STYLE_UNDERLINE);
+    terminal->style |= SDL_TERMINAL_STYLE_UNDERLINE;
     return 0;
 }
 
 int
 SDL_TerminalDisableUnderline (SDL_Terminal *terminal)
 {
-    TTF_SetFontStyle (terminal->font, TTF_GetFontStyle (terminal->font) & ~TTF_STYLE_UNDERLINE);
+    terminal->style &= ~SDL_TERMINAL_STYLE_UNDERLINE;
     return 0;
 }
 
 int
 SDL_TerminalEnableItalic (SDL_Terminal *terminal)
 {
-    TTF_SetFontStyle (terminal->font, TTF_GetFontStyle (terminal->font) | TTF_STYLE_ITALIC);
+    terminal->style |= SDL_TERMINAL_STYLE_ITALIC;
     return 0;
 }
 
 int
 SDL_TerminalDisableItalic (SDL_Terminal *terminal)
 {
-    TTF_SetFontStyle (terminal->font, TTF_GetFontStyle (terminal->font) & ~TTF_STYLE_ITALIC);
+    terminal->style &= ~SDL_TERMINAL_STYLE_ITALIC;
     return 0;
 }
 
@@ -820,26 +842,26 @@ SDL_TerminalSetFont (SDL_Terminal *terminal, char *filename, int size)
         return -1;
     }
 
-    int font_style = -1;
-    if (terminal->font) {
-        font_style = TTF_GetFontStyle(terminal->font);
+    if (terminal->font)
         TTF_CloseFont (terminal->font);
-    }
     terminal->font = font;
 
     if ((terminal->font_filename) && (terminal->font_filename != filename))
         free (terminal->font_filename);
     terminal->font_filename = strdup (filename);
     terminal->font_size = size;
-    if (font_style != -1)
-        TTF_SetFontStyle (terminal->font, font_style);
-    else
-        TTF_SetFontStyle (terminal->font, TTF_STYLE_NORMAL);
 
     /* Get glyph size */
     terminal->glyph_size.h = TTF_FontHeight (terminal->font);    
     TTF_GlyphMetrics(terminal->font, (Uint16)('A'), 0, 0, 0, 0, &terminal->glyph_size.w);
 
+    /* Glyphs of the old font are of no use */
+    SDL_TerminalAtlasDestroy (&terminal->atlas);
+    if (SDL_TerminalAtlasCreate (&terminal->atlas, terminal->glyph_size.w, terminal->glyph_size.h,
+                                 SDL_TerminalRasterizeGlyph, terminal) != 0) {
+		SDL_SetError("SDL Error <out of memory>: %i", SDL_ENOMEM);
+        return -1;
+    }
 
     /* Resize terminal according to new font size */
     SDL_TerminalSetSize (terminal, terminal->size.row, terminal->size.column);
@@ -1070,10 +1092,7 @@ SDL_TerminalAddChar (SDL_Terminal *terminal, char c)
     
     int i;
     for (i=0; i<dx; i++) {
-        SDL_TerminalRenderChar (terminal, 
-                                terminal->br_size+terminal->cpos.x * terminal->glyph_size.w,
-                                terminal->br_size+terminal->cpos.y * terminal->glyph_size.h,
-                                cc);
+        SDL_TerminalPutChar (terminal, terminal->cpos.x, terminal->cpos.y, cc);
         terminal->cpos.x++;
         if (terminal->cpos.x >= terminal->size.column) {
             terminal->cpos.x -= terminal->size.column;
@@ -1325,26 +1344,7 @@ SDL_TerminalGetNumberOfLine (SDL_Terminal *terminal, char *text)
  */
 int SDL_TerminalClearFrom (SDL_Terminal *terminal, int column, int row)
 {
-    Uint32 color = SDL_MapRGBA (terminal->surface->format, terminal->color.r, terminal->color.g, terminal->color.b, terminal->color.a);
-	//SDL_SetSurfaceAlphaMod(terminal->surface, 0);
-
-    if ((column <= (terminal->size.column-1)) && (row <= (terminal->size.row-1))) {
-        SDL_Rect dst = {terminal->br_size + column*terminal->glyph_size.w,
-                        terminal->br_size + row*terminal->glyph_size.h,
-                        (terminal->size.column-column)*terminal->glyph_size.w,
-                        (terminal->size.row-row)*terminal->glyph_size.h};
-        SDL_FillRect (terminal->surface, &dst, color);
-        SDL_TerminalUpdateGLTexture (terminal, &dst);
-    }
-    if (row < (terminal->size.row-1)) {
-        SDL_Rect dst = {terminal->br_size,
-                        terminal->br_size + (row+1) * terminal->glyph_size.h,
-                        terminal->size.column       * terminal->glyph_size.w,
-                        (terminal->size.row-row-1) * terminal->glyph_size.h};
-        SDL_FillRect (terminal->surface, &dst, color);
-        SDL_TerminalUpdateGLTexture (terminal, &dst);
-    }
-
+    SDL_TerminalGridClearFrom (&terminal->grid, column, row);
     return 1;
 }
 
@@ -1357,18 +1357,9 @@ SDL_TerminalScroll (SDL_Terminal *terminal, int n)
     if (n >= terminal->size.row)
         n = terminal->size.row;
 
-    if (n < terminal->size.row) {
-        SDL_Rect src_rect = {terminal->br_size, terminal->br_size+n*terminal->glyph_size.h,
-                             terminal->surface->w-2*terminal->br_size, terminal->surface->h - 2*terminal->br_size - n*terminal->glyph_size.h};
-
-        SDL_Rect dst_rect = {terminal->br_size, terminal->br_size,
-                             terminal->surface->w-2*terminal->br_size, terminal->surface->h - 2*terminal->br_size - n*terminal->glyph_size.h};
-		//SDL_SetSurfaceAlphaMod(terminal->surface, 0);
-        SDL_BlitSurface (terminal->surface, &src_rect, terminal->surface, &dst_rect);
-        SDL_TerminalUpdateGLTexture (terminal, &dst_rect);
-    }
-    SDL_TerminalClearFrom (terminal, 0, terminal->size.row-n);
-
+    /* Only the ring of rows moves here, the pixels are moved
+     * with a single copy when the terminal is flushed */
+    SDL_TerminalGridScroll (&terminal->grid, n);
     return n;
 }
 
@@ -1389,10 +1380,7 @@ SDL_TerminalEraseCursor (SDL_Terminal *terminal)
     }
 
 	/* 'Render' the cursor */
-    return SDL_TerminalRenderChar (terminal,
-                                   terminal->br_size + terminal->cpos.x * terminal->glyph_size.w,
-                                   terminal->br_size + terminal->cpos.y * terminal->glyph_size.h,
-                                   c);
+    return SDL_TerminalPutChar (terminal, terminal->cpos.x, terminal->cpos.y, c);
 }
 
 
@@ -1420,10 +1408,7 @@ SDL_TerminalRenderCursor (SDL_Terminal *terminal)
     }
 
 	/* Render the character */
-    r = SDL_TerminalRenderChar (terminal,
-                                    terminal->br_size + terminal->cpos.x * terminal->glyph_size.w,
-                                    terminal->br_size + terminal->cpos.y * terminal->glyph_size.h,
-                                    c);
+    r = SDL_TerminalPutChar (terminal, terminal->cpos.x, terminal->cpos.y, c);
 
 	/* Restore colors */
     terminal->fg_color = fg;
@@ -1434,80 +1419,99 @@ SDL_TerminalRenderCursor (SDL_Terminal *terminal)
 }
 
 /*
- * Render character 'c' onto terminal surface at given position.
+ * Put character 'c' into the cell at given position with the current
+ * colors and style, it's rendered when the terminal is flushed.
  */
 int
-SDL_TerminalRenderChar (SDL_Terminal *terminal, int x, int y, char c)
+SDL_TerminalPutChar (SDL_Terminal *terminal, int column, int row, char c)
 {
-	/* Temporary buffer */
-	SDL_Surface *TextSurface = 0;
-    char cBuffer[] = " ";
+    SDL_TerminalRGBA fg = {terminal->fg_color.r, terminal->fg_color.g,
+                           terminal->fg_color.b, terminal->fg_color.a};
+    SDL_TerminalRGBA bg = {terminal->bg_color.r, terminal->bg_color.g,
+                           terminal->bg_color.b, terminal->bg_color.a};
 
-	/* Set buffer */
-	cBuffer[0] = c;
+    SDL_TerminalGridPut (&terminal->grid, column, row, (unsigned char)c,
+                         terminal->style, fg, bg);
+    return 0;
+}
 
-	/* If we have transparency shade the character */
-    if (terminal->bg_color.a)
-		TextSurface = TTF_RenderText_Shaded(terminal->font,
-							cBuffer, terminal->fg_color, terminal->bg_color);
-    else
-		TextSurface = TTF_RenderText_Blended(terminal->font, cBuffer, terminal->fg_color);
+/*
+ * Render the cells that changed since last flush onto the terminal surface.
+ *
+ * @return	The number of rendered cells, or -1 if there is nothing to render to
+ */
+int
+SDL_TerminalFlush (SDL_Terminal *terminal)
+{
+    SDL_TerminalTarget target;
+    int n;
 
-	/* Sanity */
-	if (TextSurface == 0) {
-		SDL_SetError("SDL Error <out of memory>: %i", SDL_ENOMEM);
+    if ((!terminal->surface) || (!terminal->grid.cells) || (!terminal->atlas.coverage))
         return -1;
-    }
 
-	/* Erase any character at that position 
-	 * in case we are overwriting */
-    SDL_TerminalEraseChar (terminal, x, y);
-
-	/* Blit the surface */
-    SDL_Rect src = {0, 0, terminal->glyph_size.w, terminal->glyph_size.h};
-    SDL_Rect dst = {x, y, terminal->glyph_size.w, terminal->glyph_size.h};
-	SDL_BlitSurface(TextSurface, &src, terminal->surface, &dst);
-
-    /* Make character opaque when it is rendered on a transparent background */
-	if (TextSurface->format->BytesPerPixel == 4) {
-        int i,j;
-        for (i=0; i<terminal->glyph_size.w; i++) {
-            for (j=0; j<terminal->glyph_size.h; j++) {
-				Uint8 *s = (Uint8 *)((Uint8*)terminal->surface->pixels + (x + i) * 4 + (y + j)*terminal->surface->pitch);
-				Uint8 *t = (Uint8 *)((Uint8*)TextSurface->pixels + i * 4 + j*TextSurface->pitch);
-                if (*(t+3) > *(s+3))
-                    *(s+3) = *(t+3);
-            }
-        }
-    }
-    
-	/* Free the temporary text surface */
-	SDL_FreeSurface(TextSurface);
+    if (SDL_MUSTLOCK (terminal->surface))
+        SDL_LockSurface (terminal->surface);
+
+    target.pixels = (uint8_t *) terminal->surface->pixels;
+    target.pitch = terminal->surface->pitch;
+    target.x = terminal->br_size;
+    target.y = terminal->br_size;
+    target.rshift = terminal->surface->format->Rshift;
+    target.gshift = terminal->surface->format->Gshift;
+    target.bshift = terminal->surface->format->Bshift;
+    target.ashift = terminal->surface->format->Ashift;
+    n = SDL_TerminalGridFlush (&terminal->grid, &terminal->atlas, &target);
+
+    if (SDL_MUSTLOCK (terminal->surface))
+        SDL_UnlockSurface (terminal->surface);
 
 	/* If using opengl update texture */
-    return SDL_TerminalUpdateGLTexture (terminal, &dst);
+    if (n > 0)
+        SDL_TerminalUpdateGLTexture (terminal, NULL);
+    return n;
 }
 
-/* 
- * Erase one character from terminal surface at given position.
+/*
+ * Rasterize a glyph of the terminal font for the glyph atlas, the
+ * coverage is the alpha of the glyph rendered with the given style.
  */
 int
-SDL_TerminalEraseChar (SDL_Terminal *terminal, int x, int y)
+SDL_TerminalRasterizeGlyph (void *context, unsigned char c, int style,
+                            uint8_t *coverage, int w, int h)
 {
-	/* Get the background color in RGBA format */
-    Uint32 color = SDL_MapRGBA (terminal->surface->format, 
-		terminal->color.r, terminal->color.g, terminal->color.b, terminal->color.a);
+    SDL_Terminal *terminal = (SDL_Terminal *) context;
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface *TextSurface = 0;
+    char cBuffer[] = " ";
+    int i, j;
 
-	/* Set the alpha to be used for blit operations */
-	//SDL_SetSurfaceAlphaMod(terminal->surface, 0);
+    /* Control characters have no glyph */
+    if ((c < 32) || (c == 127) || (!terminal->font))
+        return -1;
+    cBuffer[0] = (char)c;
 
-	/* Blit background color on top of the character
-	 * essentially errasing it */
-    SDL_Rect dst = {x, y, terminal->glyph_size.w, terminal->glyph_size.h};
-    SDL_FillRect (terminal->surface, &dst, color);
+    /* The style bits are the same as the TTF_STYLE bits */
+    TTF_SetFontStyle (terminal->font, style);
+    TextSurface = TTF_RenderText_Blended (terminal->font, cBuffer, white);
+    if (TextSurface == 0)
+        return -1;
 
-	/* If using opengl update texture */
-    return SDL_TerminalUpdateGLTexture (terminal, &dst);
+    if (SDL_MUSTLOCK (TextSurface))
+        SDL_LockSurface (TextSurface);
+    for (j=0; j<h; j++) {
+        for (i=0; i<w; i++) {
+            Uint32 pixel = 0;
+            if ((i < TextSurface->w) && (j < TextSurface->h))
+                pixel = *(Uint32 *)((Uint8 *)TextSurface->pixels + j*TextSurface->pitch + i*4);
+            coverage[j*w + i] = (uint8_t)((pixel & TextSurface->format->Amask) >> TextSurface->format->Ashift);
+        }
+    }
+    if (SDL_MUSTLOCK (TextSurface))
+        SDL_UnlockSurface (TextSurface);
+
+    /* Free the temporary text surface */
+    SDL_FreeSurface(TextSurface);
+    return 0;
 }
 
 
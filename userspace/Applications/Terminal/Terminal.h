@@ -18,6 +18,7 @@
 
 #include <SDL.h>
 #include <SDL_ttf.h>
+#include "TerminalGrid.h"
 
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 #define		SDL_TERMINAL_MASK			0xFF000000, 0x00FF0000, 0x0000FF00, 0x000000FF
@@ -84,6 +85,9 @@ typedef struct SDL_Terminal {
     int				buffer_size;			/* Text buffer size */
 
     SDL_Surface *	surface;				/* Terminal surface */
+    SDL_TerminalGrid grid;					/* Cell content of the surface */
+    SDL_TerminalAtlas atlas;				/* Glyphs of the current font */
+    int				style;					/* Current text style */
     unsigned int	texture;				/* Terminal surface GL texture */
     Vec2i			texture_size;			/* Terminal surface GL texture size */
     SDL_EventFilter event_filter;			/* Event filter */
@@ -104,6 +108,7 @@ void SDL_DestroyTerminal (SDL_Terminal *terminal);
 
 int SDL_TerminalBlit (SDL_Terminal *terminal);
 int SDL_TerminalRefresh (SDL_Terminal *terminal);
+int SDL_TerminalFlush (SDL_Terminal *terminal);
 
 int SDL_TerminalClear (SDL_Terminal *terminal);
 int SDL_TerminalPrint (SDL_Terminal *terminal, char *text, ...);
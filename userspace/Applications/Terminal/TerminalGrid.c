@@ -0,0 +1,311 @@
+/* MollenOS
+*
+* Copyright 2011 - 2017, Philip Meulengracht
+*
+* This program is free software : you can redistribute it and / or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation ? , either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* MollenOS Terminal - Cell Grid
+* - Implementation of the cell grid and the glyph atlas
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "TerminalGrid.h"
+
+/*
+ * The cell used for cleared areas
+ */
+static const SDL_TerminalCell SDL_TerminalBlankCell = { ' ', 0, 0, 0, {0,0,0,0}, {0,0,0,0} };
+
+
+/*
+ * Create a glyph atlas for glyphs of the given size, the rasterizer
+ * is invoked the first time a glyph/style is used
+ *
+ * @return	If the creation is successful, it returns 0, otherwise it returns -1
+ */
+int
+SDL_TerminalAtlasCreate (SDL_TerminalAtlas *atlas, int glyph_w, int glyph_h,
+                         SDL_TerminalRasterizer rasterize, void *context)
+{
+    if ((glyph_w <= 0) || (glyph_h <= 0))
+        return -1;
+
+    memset (atlas, 0, sizeof(SDL_TerminalAtlas));
+    atlas->coverage = (uint8_t *) calloc (SDL_TERMINAL_STYLE_COUNT * 256, (size_t)glyph_w * glyph_h);
+    if (atlas->coverage == NULL)
+        return -1;
+
+    atlas->glyph_w = glyph_w;
+    atlas->glyph_h = glyph_h;
+    atlas->rasterize = rasterize;
+    atlas->context = context;
+    return 0;
+}
+
+/*
+ * Destroy a glyph atlas and free the allocated memory
+ */
+void
+SDL_TerminalAtlasDestroy (SDL_TerminalAtlas *atlas)
+{
+    if (atlas->coverage)
+        free (atlas->coverage);
+    memset (atlas, 0, sizeof(SDL_TerminalAtlas));
+}
+
+/*
+ * Get the coverage of a glyph, glyphs that fail to
+ * rasterize are left empty
+ */
+const uint8_t *
+SDL_TerminalAtlasGlyph (SDL_TerminalAtlas *atlas, unsigned char c, int style)
+{
+    size_t size = (size_t)atlas->glyph_w * atlas->glyph_h;
+    uint8_t *glyph;
+
+    style &= (SDL_TERMINAL_STYLE_COUNT - 1);
+    glyph = atlas->coverage + (((size_t)style * 256) + c) * size;
+    if (!atlas->present[style][c]) {
+        if ((atlas->rasterize == NULL)
+            || (atlas->rasterize (atlas->context, c, style, glyph, atlas->glyph_w, atlas->glyph_h) != 0))
+            memset (glyph, 0, size);
+        atlas->present[style][c] = 1;
+    }
+    return glyph;
+}
+
+
+/*
+ * Create a grid of blank cells
+ *
+ * @return	If the creation is successful, it returns 0, otherwise it returns -1
+ */
+int
+SDL_TerminalGridCreate (SDL_TerminalGrid *grid, int columns, int rows)
+{
+    if ((columns <= 0) || (rows <= 0))
+        return -1;
+
+    grid->columns = columns;
+    grid->rows = rows;
+    grid->cells = (SDL_TerminalCell *) malloc ((size_t)columns * rows * sizeof(SDL_TerminalCell));
+    grid->row_dirty = (unsigned char *) malloc ((size_t)rows);
+    if ((grid->cells == NULL) || (grid->row_dirty == NULL)) {
+        SDL_TerminalGridDestroy (grid);
+        return -1;
+    }
+
+    SDL_TerminalGridReset (grid);
+    return 0;
+}
+
+/*
+ * Destroy a grid and free the allocated memory
+ */
+void
+SDL_TerminalGridDestroy (SDL_TerminalGrid *grid)
+{
+    if (grid->cells)
+        free (grid->cells);
+    if (grid->row_dirty)
+        free (grid->row_dirty);
+    grid->cells = 0;
+    grid->row_dirty = 0;
+    grid->columns = 0;
+    grid->rows = 0;
+}
+
+/*
+ * Blank all cells, the cells are left clean as the
+ * caller has cleared the pixels as well
+ */
+void
+SDL_TerminalGridReset (SDL_TerminalGrid *grid)
+{
+    int i;
+    for (i=0; i<grid->columns*grid->rows; i++)
+        grid->cells[i] = SDL_TerminalBlankCell;
+    memset (grid->row_dirty, 0, (size_t)grid->rows);
+    grid->top = 0;
+    grid->scrolled = 0;
+}
+
+/*
+ * Mark all cells dirty, used when the pixels or the font changed
+ */
+void
+SDL_TerminalGridInvalidate (SDL_TerminalGrid *grid)
+{
+    int i;
+    for (i=0; i<grid->columns*grid->rows; i++)
+        grid->cells[i].dirty = 1;
+    memset (grid->row_dirty, 1, (size_t)grid->rows);
+    grid->scrolled = 0;
+}
+
+/*
+ * Set the content of a cell, it's only marked dirty
+ * if anything changed
+ */
+void
+SDL_TerminalGridPut (SDL_TerminalGrid *grid, int column, int row, unsigned char c,
+                     int style, SDL_TerminalRGBA fg, SDL_TerminalRGBA bg)
+{
+    if ((column < 0) || (row < 0) || (column >= grid->columns) || (row >= grid->rows))
+        return;
+
+    int ring = (grid->top + row) % grid->rows;
+    SDL_TerminalCell *cell = &grid->cells[ring * grid->columns + column];
+    if ((cell->c == c) && (cell->style == (unsigned char)style)
+        && (memcmp (&cell->fg, &fg, sizeof(SDL_TerminalRGBA)) == 0)
+        && (memcmp (&cell->bg, &bg, sizeof(SDL_TerminalRGBA)) == 0))
+        return;
+
+    cell->c = c;
+    cell->style = (unsigned char)style;
+    cell->fg = fg;
+    cell->bg = bg;
+    cell->dirty = 1;
+    grid->row_dirty[ring] = 1;
+}
+
+/*
+ * Blank the grid from given cell position to the end
+ */
+void
+SDL_TerminalGridClearFrom (SDL_TerminalGrid *grid, int column, int row)
+{
+    const SDL_TerminalCell *blank = &SDL_TerminalBlankCell;
+    int i, j;
+
+    for (j=(row < 0 ? 0 : row); j<grid->rows; j++) {
+        for (i=(j == row ? column : 0); i<grid->columns; i++)
+            SDL_TerminalGridPut (grid, i, j, blank->c, blank->style, blank->fg, blank->bg);
+    }
+}
+
+/*
+ * Scroll the grid up by n rows. The rows that appear at the bottom
+ * are always dirty as their pixels are stale after the move
+ */
+void
+SDL_TerminalGridScroll (SDL_TerminalGrid *grid, int n)
+{
+    int i, j;
+
+    if (n <= 0)
+        return;
+    if (n > grid->rows)
+        n = grid->rows;
+
+    grid->top = (grid->top + n) % grid->rows;
+    for (j=grid->rows-n; j<grid->rows; j++) {
+        int ring = (grid->top + j) % grid->rows;
+        SDL_TerminalCell *cell = &grid->cells[ring * grid->columns];
+        for (i=0; i<grid->columns; i++) {
+            cell[i] = SDL_TerminalBlankCell;
+            cell[i].dirty = 1;
+        }
+        grid->row_dirty[ring] = 1;
+    }
+
+    grid->scrolled += n;
+    if (grid->scrolled > grid->rows)
+        grid->scrolled = grid->rows;
+}
+
+/*
+ * PRIVATE
+ * Render one cell, the glyph coverage blends the foreground
+ * over the cell background
+ */
+static void
+SDL_TerminalGridDrawCell (SDL_TerminalGrid *grid, SDL_TerminalAtlas *atlas,
+                          SDL_TerminalTarget *target, SDL_TerminalCell *cell, int x, int y)
+{
+    const uint8_t *coverage = SDL_TerminalAtlasGlyph (atlas, cell->c, cell->style);
+    SDL_TerminalRGBA base = cell->bg.a ? cell->bg : grid->background;
+    SDL_TerminalRGBA fg = cell->fg;
+    uint32_t base_pixel = ((uint32_t)base.r << target->rshift) | ((uint32_t)base.g << target->gshift)
+                        | ((uint32_t)base.b << target->bshift) | ((uint32_t)base.a << target->ashift);
+    uint32_t fg_pixel = ((uint32_t)fg.r << target->rshift) | ((uint32_t)fg.g << target->gshift)
+                      | ((uint32_t)fg.b << target->bshift) | ((uint32_t)255 << target->ashift);
+    int i, j;
+
+    for (j=0; j<atlas->glyph_h; j++) {
+        uint32_t *pixel = (uint32_t *)(target->pixels + (y + j) * target->pitch) + x;
+        for (i=0; i<atlas->glyph_w; i++, coverage++) {
+            unsigned k = (fg.a == 255) ? *coverage : ((unsigned)*coverage * fg.a) / 255;
+            if (k == 0)
+                pixel[i] = base_pixel;
+            else if (k == 255)
+                pixel[i] = fg_pixel;
+            else {
+                uint32_t r = base.r + (((int)fg.r - (int)base.r) * (int)k) / 255;
+                uint32_t g = base.g + (((int)fg.g - (int)base.g) * (int)k) / 255;
+                uint32_t b = base.b + (((int)fg.b - (int)base.b) * (int)k) / 255;
+                uint32_t a = (k > base.a) ? k : base.a;
+                pixel[i] = (r << target->rshift) | (g << target->gshift)
+                         | (b << target->bshift) | (a << target->ashift);
+            }
+        }
+    }
+}
+
+/*
+ * Bring the pixels up to date with the grid. Pending scrolling is
+ * applied with one move of the cell rows, after that only dirty cells
+ * are rendered
+ *
+ * @return	The number of cells that were rendered
+ */
+int
+SDL_TerminalGridFlush (SDL_TerminalGrid *grid, SDL_TerminalAtlas *atlas,
+                       SDL_TerminalTarget *target)
+{
+    size_t row_bytes = (size_t)atlas->glyph_h * target->pitch;
+    int rendered = 0;
+    int i, j;
+
+    if (grid->scrolled > 0) {
+        if (grid->scrolled < grid->rows) {
+            uint8_t *first = target->pixels + (size_t)target->y * target->pitch;
+            memmove (first, first + grid->scrolled * row_bytes, (grid->rows - grid->scrolled) * row_bytes);
+            grid->scrolled = 0;
+        }
+        else
+            SDL_TerminalGridInvalidate (grid);
+    }
+
+    for (j=0; j<grid->rows; j++) {
+        int ring = (grid->top + j) % grid->rows;
+        SDL_TerminalCell *cell = &grid->cells[ring * grid->columns];
+        if (!grid->row_dirty[ring])
+            continue;
+
+        for (i=0; i<grid->columns; i++) {
+            if (!cell[i].dirty)
+                continue;
+            SDL_TerminalGridDrawCell (grid, atlas, target, &cell[i],
+                                      target->x + i * atlas->glyph_w,
+                                      target->y + j * atlas->glyph_h);
+            cell[i].dirty = 0;
+            rendered++;
+        }
+        grid->row_dirty[ring] = 0;
+    }
+    return rendered;
+}
@@ -0,0 +1,133 @@
+/* MollenOS
+*
+* Copyright 2011 - 2017, Philip Meulengracht
+*
+* This program is free software : you can redistribute it and / or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation ? , either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.If not, see <http://www.gnu.org/licenses/>.
+*
+*
+* MollenOS Terminal - Cell Grid
+* - The terminal content is kept as a grid of cells, only cells that
+*   changed are rendered and glyphs are rasterized once into an atlas.
+*   Nothing in here depends on SDL so it can be benchmarked headless
+*/
+
+#ifndef _TERMINAL_GRID_H_
+#define _TERMINAL_GRID_H_
+
+#include <stdint.h>
+
+/* The style bits of a cell, they have the same
+ * values as the TTF_STYLE_ bits */
+#define SDL_TERMINAL_STYLE_BOLD         0x01
+#define SDL_TERMINAL_STYLE_ITALIC       0x02
+#define SDL_TERMINAL_STYLE_UNDERLINE    0x04
+#define SDL_TERMINAL_STYLE_COUNT        8
+
+/*
+ * Color of a cell, same layout as SDL_Color
+ */
+typedef struct SDL_TerminalRGBA {
+    uint8_t r, g, b, a;
+} SDL_TerminalRGBA;
+
+/*
+ * A single character cell, a background with zero
+ * alpha shows the terminal background
+ */
+typedef struct SDL_TerminalCell {
+    unsigned char       c;
+    unsigned char       style;
+    unsigned char       dirty;
+    unsigned char       reserved;
+    SDL_TerminalRGBA    fg;
+    SDL_TerminalRGBA    bg;
+} SDL_TerminalCell;
+
+/*
+ * Rasterizes a glyph into a w*h coverage mask, returns 0 on success
+ */
+typedef int (*SDL_TerminalRasterizer) (void *context, unsigned char c, int style,
+                                       uint8_t *coverage, int w, int h);
+
+/*
+ * Glyph atlas, holds the coverage of every glyph/style that has been
+ * used with the font. Glyphs are rasterized the first time they are used
+ */
+typedef struct SDL_TerminalAtlas {
+    int                     glyph_w;
+    int                     glyph_h;
+    uint8_t *               coverage;
+    uint8_t                 present[SDL_TERMINAL_STYLE_COUNT][256];
+    SDL_TerminalRasterizer  rasterize;
+    void *                  context;
+} SDL_TerminalAtlas;
+
+/*
+ * The cell grid, rows are kept in a ring so scrolling only moves the
+ * index of the top row. Scrolling is applied to the pixels with a single
+ * move when the grid is flushed
+ */
+typedef struct SDL_TerminalGrid {
+    int                 columns;
+    int                 rows;
+    int                 top;                /* Ring index of the first visible row */
+    int                 scrolled;           /* Rows scrolled since last flush */
+    SDL_TerminalCell *  cells;              /* Ring of rows */
+    unsigned char *     row_dirty;          /* Dirty flag per ring row */
+    SDL_TerminalRGBA    background;         /* Shown by cells without background */
+} SDL_TerminalGrid;
+
+/*
+ * The pixels the grid is flushed into, 32 bit pixels where the
+ * channels are at the given shifts. x and y is the pixel position
+ * of the top-left cell
+ */
+typedef struct SDL_TerminalTarget {
+    uint8_t *           pixels;
+    int                 pitch;
+    int                 x;
+    int                 y;
+    int                 rshift, gshift, bshift, ashift;
+} SDL_TerminalTarget;
+
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+int SDL_TerminalAtlasCreate (SDL_TerminalAtlas *atlas, int glyph_w, int glyph_h,
+                             SDL_TerminalRasterizer rasterize, void *context);
+void SDL_TerminalAtlasDestroy (SDL_TerminalAtlas *atlas);
+const uint8_t *SDL_TerminalAtlasGlyph (SDL_TerminalAtlas *atlas, unsigned char c, int style);
+
+int SDL_TerminalGridCreate (SDL_TerminalGrid *grid, int columns, int rows);
+void SDL_TerminalGridDestroy (SDL_TerminalGrid *grid);
+void SDL_TerminalGridReset (SDL_TerminalGrid *grid);
+void SDL_TerminalGridInvalidate (SDL_TerminalGrid *grid);
+void SDL_TerminalGridPut (SDL_TerminalGrid *grid, int column, int row, unsigned char c,
+                          int style, SDL_TerminalRGBA fg, SDL_TerminalRGBA bg);
+void SDL_TerminalGridClearFrom (SDL_TerminalGrid *grid, int column, int row);
+void SDL_TerminalGridScroll (SDL_TerminalGrid *grid, int n);
+int SDL_TerminalGridFlush (SDL_TerminalGrid *grid, SDL_TerminalAtlas *atlas,
+                           SDL_TerminalTarget *target);
+
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
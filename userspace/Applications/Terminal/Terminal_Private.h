@@ -45,8 +45,9 @@ int SDL_TerminalGetNumberOfLine (SDL_Terminal *terminal, char *text);
 
 int SDL_TerminalEraseCursor (SDL_Terminal *terminal);
 int SDL_TerminalRenderCursor (SDL_Terminal *terminal);
-int SDL_TerminalRenderChar (SDL_Terminal *terminal, int x, int y, char c);
-int SDL_TerminalEraseChar  (SDL_Terminal *terminal, int x, int y);
+int SDL_TerminalPutChar (SDL_Terminal *terminal, int column, int row, char c);
+int SDL_TerminalRasterizeGlyph (void *context, unsigned char c, int style,
+                                uint8_t *coverage, int w, int h);
 int SDL_TerminalUpdateGLTexture (SDL_Terminal *terminal, SDL_Rect *src_rect);
 
 
@@ -32,6 +32,14 @@
  * Fixed constants for calculating the SHA1 */
 #define SHA1_DIGEST_SIZE 20
 
+/* SHA1 Transform Levels
+ * The transform is selected by cpuid, the levels
+ * can be forced by Sha1Select for benchmarking. The
+ * ssse3 level is never selected by default */
+#define SHA1_SCALAR			0
+#define SHA1_SSSE3			1
+#define SHA1_SHANI			2
+
 /* The SHA1 Context
  * Structure describing the needed
  * variables for calculating the SHA1 */
@@ -46,10 +54,9 @@ typedef struct {
 _CODE_BEGIN
 
 /* Sha1Init
- * Initializes a new SHA1 context 
- * using either an internal buffer for 
- * hashing by setting handsoff to 1, otherwise
- * it will destroy the given data buffers */
+ * Initializes a new SHA1 context, the given data
+ * buffers are never modified so handsoff is only
+ * kept for compatibility */
 MOSAPI 
 OsStatus_t
 Sha1Init(
@@ -84,6 +91,14 @@ Sha1DigestToHex(
 	_In_ uint8_t Digest[SHA1_DIGEST_SIZE], 
 	_Out_ char *Output);
 
+/* Sha1Select
+ * Overrides the transform with the given level, used for benchmarking.
+ * Returns OsError if the cpu does not support the level. */
+MOSAPI 
+OsStatus_t
+Sha1Select(
+	_In_ int Level);
+
 _CODE_END
 
 #endif //!_SHA1_INTERFACE_H_